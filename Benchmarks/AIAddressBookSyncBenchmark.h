@@ -0,0 +1,65 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+
+@class AIBenchmarkAccount;
+
+//Report keys
+#define KEY_AB_SYNC_REPORT_CARDS			@"Cards"
+#define KEY_AB_SYNC_REPORT_BUDDIES			@"Buddies"
+#define KEY_AB_SYNC_REPORT_MODIFIED			@"Modified"
+#define KEY_AB_SYNC_REPORT_CONTACTS_FOUND	@"Contacts Found"
+#define KEY_AB_SYNC_REPORT_CARDS_READ		@"Cards Read"
+#define KEY_AB_SYNC_REPORT_MISMATCHES		@"Mismatches"
+#define KEY_AB_SYNC_REPORT_OPERATIONS		@"Operations"
+
+/*!
+ * @class AIAddressBookSyncBenchmark
+ * @brief Indexes a generated folder of vCards with AIContactSourceSync, from scratch and then from its saved state
+ *
+ * cardCount vCards are written to a temporary folder, the first buddyCount of them naming one of as many buddies who
+ * sign on to the benchmark account. The folder is synchronized cold, as every launch used to read the whole address
+ * book; again with nothing changed; and again after a hundredth of the cards are modified. Each buddy is then looked
+ * up in the index the way the address book controller looks up contacts, and the contacts named by the modified cards
+ * are found. How many cards each synchronization read is reported, and any card read that shouldn't have been, or
+ * lookup that found the wrong card, is a mismatch.
+ *
+ * Run with -AIAddressBookSyncBenchmark YES. Settings:
+ *	-AIAddressBookSyncBenchmarkCards <n>	vCards to write and index (10000)
+ *	-AIAddressBookSyncBenchmarkBuddies <n>	Buddies to look up in the index (5000)
+ *	-AIContactListBenchmarkSeed <n>			Seed for the random choices (1)
+ */
+@interface AIAddressBookSyncBenchmark : NSObject <AIBenchmark> {
+	AIBenchmarkAccount	*account;
+
+	NSUInteger			cardCount;
+	NSUInteger			buddyCount;
+	uint32_t			seed;
+
+	NSMutableArray		*mismatches;
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount;
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger cardCount;
+@property (readwrite, nonatomic) NSUInteger buddyCount;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
@@ -0,0 +1,335 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIAddressBookSyncBenchmark.h"
+#import "AIBenchmarkAccount.h"
+#import <Adium/AIContactControllerProtocol.h>
+#import <Adium/AIListContact.h>
+#import <AIUtilities/AIContactCard.h>
+#import <AIUtilities/AIContactSourceSync.h>
+#import <AIUtilities/AIVCardDirectoryContactSource.h>
+#import <mach/mach_time.h>
+
+//Settings
+#define KEY_AB_SYNC_BENCHMARK_CARDS			@"AIAddressBookSyncBenchmarkCards"
+#define KEY_AB_SYNC_BENCHMARK_BUDDIES		@"AIAddressBookSyncBenchmarkBuddies"
+
+#define BENCHMARK_GROUP					@"Address Book Sync Benchmark"
+//One card in so many is modified before the last synchronization
+#define MODIFIED_INTERVAL				100
+//One card in so many also has a Google Talk address, so it names more than one buddy
+#define GTALK_INTERVAL					10
+//Cards are written and buddies looked up in batches, each in its own autorelease pool
+#define BATCH_SIZE						1000
+//How many mismatches are described in the report
+#define MAX_REPORTED_MISMATCHES			20
+
+/*!
+ * @brief The same generator as AIContactListTrace's, so a seed gives the same run everywhere
+ */
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+static void addCost(NSMutableDictionary *costs, NSString *costName, NSUInteger count, uint64_t machTime)
+{
+	[costs setObject:[NSDictionary dictionaryWithObjectsAndKeys:
+					  [NSNumber numberWithUnsignedInteger:count], @"Count",
+					  [NSNumber numberWithDouble:secondsFromMachTime(machTime)], @"Seconds",
+					  nil]
+			  forKey:costName];
+}
+
+static NSString *cardUniqueID(NSUInteger i)
+{
+	return [NSString stringWithFormat:@"card%06lu", (unsigned long)i];
+}
+
+static NSString *buddyUID(NSUInteger i)
+{
+	return [NSString stringWithFormat:@"syncbuddy%lu", (unsigned long)i];
+}
+
+@interface AIAddressBookSyncBenchmark ()
+- (void)writeCard:(NSUInteger)i toSource:(AIVCardDirectoryContactSource *)source modified:(BOOL)modified date:(NSDate *)date state:(uint32_t *)state;
+- (AIContactSourceSync *)synchronizeSource:(AIVCardDirectoryContactSource *)source
+								 statePath:(NSString *)statePath
+								  costName:(NSString *)costName
+									 costs:(NSMutableDictionary *)costs
+							  expectedRead:(NSUInteger)expectedRead
+						   changedUniqueIDs:(NSSet **)outChangedUniqueIDs;
+@end
+
+@implementation AIAddressBookSyncBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:10000], KEY_AB_SYNC_BENCHMARK_CARDS,
+			[NSNumber numberWithUnsignedInteger:5000], KEY_AB_SYNC_BENCHMARK_BUDDIES,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AIAddressBookSyncBenchmark *benchmark = [[[self alloc] initWithAccount:[AIBenchmarkAccount addTemporaryAccountWithUID:BENCHMARK_ACCOUNT_UID]] autorelease];
+
+	benchmark.cardCount = [defaults integerForKey:KEY_AB_SYNC_BENCHMARK_CARDS];
+	benchmark.buddyCount = [defaults integerForKey:KEY_AB_SYNC_BENCHMARK_BUDDIES];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (void)deleteAccounts
+{
+	[account deleteTemporaryAccount];
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount
+{
+	if ((self = [super init])) {
+		account = [inAccount retain];
+		cardCount = 10000;
+		buddyCount = 5000;
+		seed = 1;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[account release];
+	[mismatches release];
+
+	[super dealloc];
+}
+
+@synthesize cardCount, buddyCount, seed;
+
+- (NSDictionary *)run
+{
+	NSMutableDictionary				*costs = [NSMutableDictionary dictionary];
+	NSMutableDictionary				*cardsRead = [NSMutableDictionary dictionary];
+	NSString						*directoryPath = [NSTemporaryDirectory() stringByAppendingPathComponent:
+													  [NSString stringWithFormat:@"AIAddressBookSyncBenchmark-%@",
+													   [[NSProcessInfo processInfo] globallyUniqueString]]];
+	NSString						*cardsPath = [directoryPath stringByAppendingPathComponent:@"Cards"];
+	NSString						*statePath = [directoryPath stringByAppendingPathComponent:@"AddressBookSync.plist"];
+	AIVCardDirectoryContactSource	*source = [[[AIVCardDirectoryContactSource alloc] initWithDirectoryPath:cardsPath] autorelease];
+	NSDate							*anHourAgo = [NSDate dateWithTimeIntervalSinceNow:-3600];
+	NSMutableIndexSet				*modifiedCards = [NSMutableIndexSet indexSet];
+	AIContactSourceSync				*sync;
+	NSSet							*changedUniqueIDs = nil;
+	NSUInteger						i, batch, found = 0;
+	uint64_t						start;
+	uint32_t						state = seed;
+
+	[mismatches release]; mismatches = [[NSMutableArray alloc] init];
+
+	[[NSFileManager defaultManager] createDirectoryAtPath:cardsPath withIntermediateDirectories:YES attributes:nil error:NULL];
+
+	//The corpus predates the first synchronization
+	start = mach_absolute_time();
+	for (batch = 0; batch < cardCount; batch += BATCH_SIZE) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+		for (i = batch; i < MIN(batch + BATCH_SIZE, cardCount); i++) {
+			[self writeCard:i toSource:source modified:NO date:anHourAgo state:&state];
+		}
+
+		[pool release];
+	}
+	addCost(costs, @"Writing vCards", cardCount, mach_absolute_time() - start);
+
+	//Every card is read the first time
+	sync = [self synchronizeSource:source statePath:statePath costName:@"Cold sync" costs:costs
+					  expectedRead:cardCount changedUniqueIDs:NULL];
+	[cardsRead setObject:[NSNumber numberWithUnsignedInteger:sync.cardsRead] forKey:@"Cold sync"];
+
+	//None the second
+	sync = [self synchronizeSource:source statePath:statePath costName:@"Warm sync, nothing changed" costs:costs
+					  expectedRead:0 changedUniqueIDs:NULL];
+	[cardsRead setObject:[NSNumber numberWithUnsignedInteger:sync.cardsRead] forKey:@"Warm sync, nothing changed"];
+
+	//Only the modified ones the third
+	while (modifiedCards.count < cardCount / MODIFIED_INTERVAL) {
+		[modifiedCards addIndex:nextRandom(&state) % cardCount];
+	}
+	for (i = modifiedCards.firstIndex; i != NSNotFound; i = [modifiedCards indexGreaterThanIndex:i]) {
+		[self writeCard:i toSource:source modified:YES date:[NSDate date] state:&state];
+	}
+	sync = [self synchronizeSource:source statePath:statePath costName:@"Warm sync, 1% modified" costs:costs
+					  expectedRead:modifiedCards.count changedUniqueIDs:&changedUniqueIDs];
+	[cardsRead setObject:[NSNumber numberWithUnsignedInteger:sync.cardsRead] forKey:@"Warm sync, 1% modified"];
+
+	if (changedUniqueIDs.count != modifiedCards.count) {
+		[mismatches addObject:[NSString stringWithFormat:@"%lu cards changed, but %lu were modified",
+							   (unsigned long)changedUniqueIDs.count, (unsigned long)modifiedCards.count]];
+	}
+
+	//Look up each buddy as -[AIAddressBookController _searchForUID:serviceID:] does
+	[account connect];
+	for (i = 0; i < buddyCount; i++) {
+		[account signOnContactWithUID:buddyUID(i) group:BENCHMARK_GROUP away:NO statusMessage:nil];
+	}
+	[account endSignOnDelay];
+
+	uint64_t lookupTime = 0;
+	for (batch = 0; batch < buddyCount; batch += BATCH_SIZE) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+		for (i = batch; i < MIN(batch + BATCH_SIZE, buddyCount); i++) {
+			AIListContact	*contact = [account contactWithUID:buddyUID(i)];
+
+			start = mach_absolute_time();
+			NSString		*uniqueID = [sync cardUniqueIDForUID:contact.UID indexServiceID:@"AIM"];
+			lookupTime += mach_absolute_time() - start;
+
+			if (![uniqueID isEqualToString:cardUniqueID(i)]) {
+				[mismatches addObject:[NSString stringWithFormat:@"%@ was found on %@ rather than %@", contact.UID, uniqueID, cardUniqueID(i)]];
+			}
+		}
+
+		[pool release];
+	}
+	addCost(costs, @"Looking up buddies' cards", buddyCount, lookupTime);
+
+	//Find who the modified cards name, as -[AIAddressBookController addressBookChanged:] does
+	start = mach_absolute_time();
+	for (NSString *uniqueID in changedUniqueIDs) {
+		for (AIContactCardMatch *match in [sync matchesForCardWithUniqueID:uniqueID]) {
+			found += [adium.contactController allContactsWithService:account.service UID:match.UID].count;
+		}
+	}
+	addCost(costs, @"Finding contacts of modified cards", changedUniqueIDs.count, mach_absolute_time() - start);
+
+	for (i = 0; i < buddyCount; i++) {
+		[account signOffContactWithUID:buddyUID(i)];
+	}
+	[[NSFileManager defaultManager] removeItemAtPath:directoryPath error:NULL];
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:cardCount], KEY_AB_SYNC_REPORT_CARDS,
+			[NSNumber numberWithUnsignedInteger:buddyCount], KEY_AB_SYNC_REPORT_BUDDIES,
+			[NSNumber numberWithUnsignedInteger:modifiedCards.count], KEY_AB_SYNC_REPORT_MODIFIED,
+			[NSNumber numberWithUnsignedInteger:found], KEY_AB_SYNC_REPORT_CONTACTS_FOUND,
+			cardsRead, KEY_AB_SYNC_REPORT_CARDS_READ,
+			mismatches, KEY_AB_SYNC_REPORT_MISMATCHES,
+			costs, KEY_AB_SYNC_REPORT_OPERATIONS,
+			nil];
+}
+
+/*!
+ * @brief Write one card of the corpus
+ *
+ * Cards below buddyCount name their buddy as an AIM name, with spaces and capitals as people type them. A modified
+ * card names the same buddy but has a new email address.
+ */
+- (void)writeCard:(NSUInteger)i toSource:(AIVCardDirectoryContactSource *)source modified:(BOOL)modified date:(NSDate *)date state:(uint32_t *)state
+{
+	NSMutableString	*vCard = [NSMutableString stringWithString:@"BEGIN:VCARD\r\nVERSION:3.0\r\n"];
+	NSString		*path = [source pathForCardWithUniqueID:cardUniqueID(i)];
+
+	[vCard appendFormat:@"N:Last%lu;First%lu;;;\r\nFN:First%lu Last%lu\r\n",
+	 (unsigned long)i, (unsigned long)nextRandom(state) % 1000, (unsigned long)i, (unsigned long)i];
+	[vCard appendFormat:@"EMAIL;TYPE=INTERNET:person%lu@%@example.com\r\n", (unsigned long)i, (modified ? @"new." : @"")];
+	if (i % GTALK_INTERVAL == 0) [vCard appendFormat:@"EMAIL;TYPE=INTERNET:person%lu@gmail.com\r\n", (unsigned long)i];
+	if (i < buddyCount) [vCard appendFormat:@"X-AIM;TYPE=HOME:Sync Buddy%lu\r\n", (unsigned long)i];
+	[vCard appendString:@"END:VCARD\r\n"];
+
+	[vCard writeToFile:path atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+	[[NSFileManager defaultManager] setAttributes:[NSDictionary dictionaryWithObject:date forKey:NSFileModificationDate]
+									 ofItemAtPath:path
+											error:NULL];
+}
+
+/*!
+ * @brief Synchronize a new AIContactSourceSync with the folder, as on launch, and check how many cards it read
+ */
+- (AIContactSourceSync *)synchronizeSource:(AIVCardDirectoryContactSource *)source
+								 statePath:(NSString *)statePath
+								  costName:(NSString *)costName
+									 costs:(NSMutableDictionary *)costs
+							  expectedRead:(NSUInteger)expectedRead
+						   changedUniqueIDs:(NSSet **)outChangedUniqueIDs
+{
+	AIContactSourceSync	*sync = [[[AIContactSourceSync alloc] initWithContactSource:source statePath:statePath] autorelease];
+	NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+	uint64_t			start = mach_absolute_time();
+	NSSet				*changedUniqueIDs = [[sync synchronize] retain];
+
+	addCost(costs, costName, cardCount, mach_absolute_time() - start);
+	[pool release];
+
+	if (sync.cardsRead != expectedRead) {
+		[mismatches addObject:[NSString stringWithFormat:@"%@ read %lu cards rather than %lu",
+							   costName, (unsigned long)sync.cardsRead, (unsigned long)expectedRead]];
+	}
+
+	if (outChangedUniqueIDs) *outChangedUniqueIDs = changedUniqueIDs;
+	[changedUniqueIDs autorelease];
+
+	return sync;
+}
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSDictionary	*costs = [report objectForKey:KEY_AB_SYNC_REPORT_OPERATIONS];
+	NSDictionary	*cardsRead = [report objectForKey:KEY_AB_SYNC_REPORT_CARDS_READ];
+	NSArray			*reportMismatches = [report objectForKey:KEY_AB_SYNC_REPORT_MISMATCHES];
+
+	[description appendFormat:@"Cards: %@, buddies: %@, modified: %@ (naming %@ contacts)\n",
+	 [report objectForKey:KEY_AB_SYNC_REPORT_CARDS], [report objectForKey:KEY_AB_SYNC_REPORT_BUDDIES],
+	 [report objectForKey:KEY_AB_SYNC_REPORT_MODIFIED], [report objectForKey:KEY_AB_SYNC_REPORT_CONTACTS_FOUND]];
+	for (NSString *name in [[cardsRead allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		[description appendFormat:@"  %@: read %@ cards\n", name, [cardsRead objectForKey:name]];
+	}
+	[description appendFormat:@"Mismatches: %lu\n", (unsigned long)reportMismatches.count];
+
+	for (NSUInteger i = 0; i < reportMismatches.count && i < MAX_REPORTED_MISMATCHES; i++) {
+		[description appendFormat:@"  %@\n", [reportMismatches objectAtIndex:i]];
+	}
+
+	[description appendString:@"\n"];
+	for (NSString *name in [[costs allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		NSDictionary	*cost = [costs objectForKey:name];
+		NSUInteger		count = [[cost objectForKey:@"Count"] unsignedIntegerValue];
+		double			seconds = [[cost objectForKey:@"Seconds"] doubleValue];
+
+		[description appendFormat:@"  %-50s %8lu  %9.3f s  %10.3f us each\n",
+		 [name UTF8String], (unsigned long)count, seconds, (count ? seconds * USEC_PER_SEC / count : 0.0)];
+	}
+
+	return description;
+}
+
+@end
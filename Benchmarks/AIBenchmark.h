@@ -0,0 +1,67 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+//Settings shared by the trace replay and the benchmarks
+#define KEY_BENCHMARK_REPORT			@"AIContactListBenchmarkReport"
+#define KEY_BENCHMARK_SEED				@"AIContactListBenchmarkSeed"
+#define KEY_BENCHMARK_CONTACTS			@"AIContactListBenchmarkContacts"
+#define KEY_BENCHMARK_GROUPS			@"AIContactListBenchmarkGroups"
+
+//UIDs of the temporary accounts benchmarks add
+#define BENCHMARK_ACCOUNT_UID			@"benchmark"
+#define BENCHMARK_OTHER_ACCOUNT_UID		@"benchmark2"
+
+/*!
+ * @protocol AIBenchmark
+ * @brief A benchmark which AIContactListBenchmarkPlugin can run instead of replaying a trace
+ *
+ * A benchmark is switched on by setting the default named after its class to YES, and reads its other settings from
+ * defaults, which its class documents. Benchmarks are listed in AIContactListBenchmarkPlugin.m.
+ */
+@protocol AIBenchmark <NSObject>
+
+/*!
+ * @brief The settings the benchmark reads, with their values when they are not set
+ */
++ (NSDictionary *)defaultSettings;
+
+/*!
+ * @brief A benchmark configured from defaults
+ *
+ * Any accounts the benchmark needs are added before this returns; they are deleted by -deleteAccounts.
+ */
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults;
+
+/*!
+ * @brief Run the benchmark
+ *
+ * @result A property list report, for -descriptionOfReport: and for comparing runs
+ */
+- (NSDictionary *)run;
+
+/*!
+ * @brief A human readable description of a report returned by -run
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@optional
+
+/*!
+ * @brief Delete the accounts added by +benchmarkWithDefaults:, once the report has been written
+ */
+- (void)deleteAccounts;
+
+@end
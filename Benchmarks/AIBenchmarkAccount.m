@@ -0,0 +1,194 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmarkAccount.h"
+#import <Adium/AIAccountControllerProtocol.h>
+#import <Adium/AIContactControllerProtocol.h>
+#import <Adium/AIContactObserverManager.h>
+#import <Adium/AIContentControllerProtocol.h>
+#import <Adium/AIChatControllerProtocol.h>
+#import <Adium/AIContentMessage.h>
+#import <Adium/AIListContact.h>
+
+@implementation AIBenchmarkAccount
+
+/*!
+ * @brief Add a benchmark account which isn't saved with the user's accounts
+ */
++ (AIBenchmarkAccount *)addTemporaryAccountWithUID:(NSString *)UID
+{
+	AIService			*service = [adium.accountController serviceWithUniqueID:@"benchmark"];
+	AIBenchmarkAccount	*account = (AIBenchmarkAccount *)[adium.accountController createAccountWithService:service
+																									UID:UID];
+	[account setIsTemporary:YES];
+	[adium.accountController addAccount:account];
+
+	return account;
+}
+
+/*!
+ * @brief Delete an account added by +addTemporaryAccountWithUID:
+ */
+- (void)deleteTemporaryAccount
+{
+	[adium.accountController deleteAccount:self];
+}
+
+/*!
+ * @brief Connect
+ *
+ * There is nothing to connect to, so we are online at once. Like a real account signing on, contact list updates are
+ * held back until the initial flood of contacts is in; unlike a real account, they are released by an explicit
+ * endSignOnDelay rather than by a period of inactivity, so a replay doesn't depend on how fast the machine is.
+ */
+- (void)connect
+{
+	[super connect];
+
+	[self didConnect];
+	[self setLastDisconnectionError:nil];
+
+	if (!delayingNotifications) {
+		[[AIContactObserverManager sharedManager] delayListObjectNotifications];
+		delayingNotifications = YES;
+	}
+}
+
+- (void)disconnect
+{
+	[super disconnect];
+
+	[self endSignOnDelay];
+	[self didDisconnect];
+}
+
+/*!
+ * @brief Release the contact list updates held back since connecting
+ */
+- (void)endSignOnDelay
+{
+	if (delayingNotifications) {
+		delayingNotifications = NO;
+		[[AIContactObserverManager sharedManager] endListObjectNotificationsDelaysImmediately];
+	}
+}
+
+- (void)removeContacts:(NSArray *)objects fromGroups:(NSArray *)groups
+{
+
+}
+
+#pragma mark Chats
+
+/*!
+ * @brief Chats need nothing set up or torn down on our side
+ */
+- (BOOL)openChat:(AIChat *)chat
+{
+	return YES;
+}
+
+- (BOOL)closeChat:(AIChat *)chat
+{
+	return YES;
+}
+
+#pragma mark Contact events
+
+- (void)signOnContactWithUID:(NSString *)inUID group:(NSString *)groupName away:(BOOL)away statusMessage:(NSString *)statusMessage
+{
+	AIListContact *listContact = [self contactWithUID:inUID];
+
+	if (groupName && ![listContact.remoteGroupNames containsObject:groupName]) {
+		[listContact addRemoteGroupName:groupName];
+	}
+
+	[listContact setOnline:YES notify:NotifyLater silently:delayingNotifications];
+	[listContact setStatusWithName:nil
+						statusType:(away ? AIAwayStatusType : AIAvailableStatusType)
+							notify:NotifyLater];
+	[listContact setStatusMessage:(statusMessage ? [[[NSAttributedString alloc] initWithString:statusMessage] autorelease] : nil)
+						   notify:NotifyLater];
+
+	[listContact notifyOfChangedPropertiesSilently:delayingNotifications];
+}
+
+- (void)signOffContactWithUID:(NSString *)inUID
+{
+	AIListContact *listContact = [adium.contactController existingContactWithService:service account:self UID:inUID];
+	if (!listContact) return;
+
+	[listContact setOnline:NO notify:NotifyLater silently:delayingNotifications];
+	[self removePropertyValuesFromContact:listContact silently:delayingNotifications];
+}
+
+- (void)setContactWithUID:(NSString *)inUID away:(BOOL)away statusMessage:(NSString *)statusMessage
+{
+	AIListContact *listContact = [self contactWithUID:inUID];
+
+	[listContact setStatusWithName:nil
+						statusType:(away ? AIAwayStatusType : AIAvailableStatusType)
+							notify:NotifyLater];
+	[listContact setStatusMessage:(statusMessage ? [[[NSAttributedString alloc] initWithString:statusMessage] autorelease] : nil)
+						   notify:NotifyLater];
+
+	[listContact notifyOfChangedPropertiesSilently:delayingNotifications];
+}
+
+- (void)setContactWithUID:(NSString *)inUID idleSinceDate:(NSDate *)idleSinceDate
+{
+	AIListContact *listContact = [self contactWithUID:inUID];
+
+	[listContact setIdle:(idleSinceDate != nil) sinceDate:idleSinceDate notify:NotifyLater];
+	[listContact notifyOfChangedPropertiesSilently:delayingNotifications];
+}
+
+- (void)setContactWithUID:(NSString *)inUID alias:(NSString *)alias
+{
+	[[self contactWithUID:inUID] setServersideAlias:alias silently:delayingNotifications];
+}
+
+/*!
+ * @brief A contact sent us a message
+ *
+ * @param deliver If YES, the message is received into a chat as usual, which opens a chat window. If NO, it only goes
+ *                through the incoming content filters.
+ */
+- (void)receiveMessage:(NSString *)message fromContactWithUID:(NSString *)inUID deliver:(BOOL)deliver
+{
+	AIListContact		*listContact = [self contactWithUID:inUID];
+	NSAttributedString	*attributedMessage = [[[NSAttributedString alloc] initWithString:message] autorelease];
+
+	if (deliver) {
+		AIChat *chat = [adium.chatController chatWithContact:listContact];
+		AIContentMessage *messageObject = [AIContentMessage messageInChat:chat
+															   withSource:listContact
+															  destination:self
+																	 date:nil
+																  message:attributedMessage
+																autoreply:NO];
+
+		[adium.contentController receiveContentObject:messageObject];
+
+	} else {
+		[adium.contentController filterAttributedString:attributedMessage
+										usingFilterType:AIFilterContent
+											  direction:AIFilterIncoming
+												context:listContact];
+	}
+}
+
+@end
@@ -0,0 +1,76 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmarkService.h"
+#import "AIBenchmarkAccount.h"
+#import <Adium/AIStatusControllerProtocol.h>
+
+@implementation AIBenchmarkService
+
+- (Class)accountClass{
+	return [AIBenchmarkAccount class];
+}
+
+//Service Description
+- (NSString *)serviceCodeUniqueID{
+	return @"benchmark";
+}
+- (NSString *)serviceID{
+	return @"Benchmark";
+}
+- (NSString *)serviceClass{
+	return @"Benchmark";
+}
+- (NSString *)shortDescription{
+	return @"Benchmark";
+}
+- (NSString *)longDescription{
+	return @"Contact List Benchmark";
+}
+- (NSCharacterSet *)allowedCharacters{
+	return [[NSCharacterSet illegalCharacterSet] invertedSet];
+}
+- (NSUInteger)allowedLength{
+	return 999;
+}
+- (BOOL)caseSensitive{
+	return YES;
+}
+- (AIServiceImportance)serviceImportance{
+	return AIServiceUnsupported;
+}
+- (BOOL)supportsProxySettings{
+	return NO;
+}
+- (BOOL)supportsPassword{
+	return NO;
+}
+- (BOOL)isHidden{
+	return YES;
+}
+- (void)registerStatuses{
+	[adium.statusController registerStatus:STATUS_NAME_AVAILABLE
+						   withDescription:[adium.statusController localizedDescriptionForCoreStatusName:STATUS_NAME_AVAILABLE]
+									ofType:AIAvailableStatusType
+								forService:self];
+	
+	[adium.statusController registerStatus:STATUS_NAME_AWAY
+						   withDescription:[adium.statusController localizedDescriptionForCoreStatusName:STATUS_NAME_AWAY]
+									ofType:AIAwayStatusType
+								forService:self];
+}
+
+@end
@@ -0,0 +1,69 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+
+//Report keys
+#define KEY_BONJOUR_REPORT_PEERS				@"Peers"
+#define KEY_BONJOUR_REPORT_ROUNDS				@"Rounds"
+#define KEY_BONJOUR_REPORT_ANNOUNCEMENTS		@"Announcements"
+#define KEY_BONJOUR_REPORT_RESOLVES				@"Resolve Results"
+#define KEY_BONJOUR_REPORT_PARSES				@"TXT Records Parsed"
+#define KEY_BONJOUR_REPORT_STATE_CHANGES		@"State Changes Reported"
+#define KEY_BONJOUR_REPORT_IMAGE_CHANGES		@"Picture Changes Reported"
+#define KEY_BONJOUR_REPORT_IMAGE_FETCHES		@"Pictures Fetched"
+#define KEY_BONJOUR_REPORT_LEGACY_IMAGE_FETCHES	@"Pictures Fetched Before"
+#define KEY_BONJOUR_REPORT_DISTINCT_IMAGES		@"Distinct Pictures"
+#define KEY_BONJOUR_REPORT_SECONDS				@"Seconds"
+#define KEY_BONJOUR_REPORT_MISMATCHES			@"Mismatches"
+
+/*!
+ * @class AIBonjourPresenceBenchmark
+ * @brief Runs libezv's contact manager against a simulated LAN of Bonjour peers whose status flaps
+ *
+ * peerCount peers publish _presence._tcp services on an AWEzvLoopbackNetwork; most have a picture, and some share one
+ * of a few stock pictures. Over roundCount rounds, peers flap to away and straight back, change their status or
+ * message, refresh an unchanged record, change their picture, and drop off the network and come back. At the end
+ * of each round the network catches up and the manager's pending state changes are flushed, as if its delay had
+ * passed.
+ *
+ * libezv used to parse every resolve result and report every one to the client with userChangedState:, and fetched
+ * the picture of every contact it saw come online; those counts are given for comparison: the first two are the
+ * resolve result count, and the last is worked out from the peers' script. At the end, every online peer's name,
+ * status, message and picture are checked against what the manager last told the client.
+ *
+ * Run with -AIBonjourPresenceBenchmark YES. Settings:
+ *	-AIBonjourPresenceBenchmarkPeers <n>	Loopback Bonjour peers (500)
+ *	-AIBonjourPresenceBenchmarkRounds <n>	Rounds of status changes (50)
+ *	-AIContactListBenchmarkSeed <n>			Seed for the random choices (1)
+ */
+@interface AIBonjourPresenceBenchmark : NSObject <AIBenchmark> {
+	NSUInteger			peerCount;
+	NSUInteger			roundCount;
+	uint32_t			seed;
+
+	NSMutableArray		*mismatches;
+}
+
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger peerCount;
+@property (readwrite, nonatomic) NSUInteger roundCount;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
@@ -0,0 +1,501 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBonjourPresenceBenchmark.h"
+#import "AWEzv.h"
+#import "AWEzvContact.h"
+#import "AWEzvContactManager.h"
+#import "AWEzvContactManagerRendezvous.h"
+#import "AWEzvRendezvousData.h"
+#import "AWEzvLoopbackBackend.h"
+#import <CommonCrypto/CommonDigest.h>
+#import <mach/mach_time.h>
+
+//Settings
+#define KEY_BONJOUR_BENCHMARK_PEERS			@"AIBonjourPresenceBenchmarkPeers"
+#define KEY_BONJOUR_BENCHMARK_ROUNDS		@"AIBonjourPresenceBenchmarkRounds"
+
+#define STOCK_PICTURE_COUNT				3
+#define MIN_PICTURE_LENGTH				2048
+#define MAX_PICTURE_LENGTH				8192
+#define PEER_PORT						@"5298"
+//How many mismatches are described in the report
+#define MAX_REPORTED_MISMATCHES			20
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+static NSData *randomPicture(uint32_t *random)
+{
+	NSUInteger		length = MIN_PICTURE_LENGTH + nextRandom(random) % (MAX_PICTURE_LENGTH - MIN_PICTURE_LENGTH);
+	NSMutableData	*picture = [NSMutableData dataWithLength:length];
+	unsigned char	*bytes = [picture mutableBytes];
+	NSUInteger		i;
+
+	for (i = 0; i < length; i++) bytes[i] = (unsigned char)nextRandom(random);
+
+	return picture;
+}
+
+static NSData *pictureHash(NSData *picture)
+{
+	unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+	CC_SHA1([picture bytes], (CC_LONG)[picture length], digest);
+
+	return [NSData dataWithBytes:digest length:CC_SHA1_DIGEST_LENGTH];
+}
+
+static NSString *stateDescription(NSString *name, AWEzvStatus status, NSString *message)
+{
+	return [NSString stringWithFormat:@"%@, status %d, message \"%@\"", name, status, (message ? message : @"")];
+}
+
+static AWEzvStatus statusForField(NSString *status)
+{
+	if ([status isEqualToString:@"dnd"]) return AWEzvAway;
+	if ([status isEqualToString:@"away"]) return AWEzvIdle;
+	return AWEzvOnline;
+}
+
+/*!
+ * @class AIBonjourPresenceBenchmarkClient
+ * @brief Stands in for AWBonjourAccount, remembering what it was last told about each contact
+ */
+@interface AIBonjourPresenceBenchmarkClient : NSObject <AWEzvClientProtocol> {
+	NSMutableDictionary	*reportedStates;
+	NSMutableDictionary	*reportedPictures;
+	NSMutableArray		*errors;
+	NSUInteger			stateChangeCount;
+	NSUInteger			imageChangeCount;
+}
+@property (readonly, nonatomic) NSDictionary *reportedStates;
+@property (readonly, nonatomic) NSDictionary *reportedPictures;
+@property (readonly, nonatomic) NSArray *errors;
+@property (readonly, nonatomic) NSUInteger stateChangeCount;
+@property (readonly, nonatomic) NSUInteger imageChangeCount;
+@end
+
+@implementation AIBonjourPresenceBenchmarkClient
+
+- (id)init
+{
+	if ((self = [super init])) {
+		reportedStates = [[NSMutableDictionary alloc] init];
+		reportedPictures = [[NSMutableDictionary alloc] init];
+		errors = [[NSMutableArray alloc] init];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[reportedStates release];
+	[reportedPictures release];
+	[errors release];
+
+	[super dealloc];
+}
+
+@synthesize reportedStates, reportedPictures, errors, stateChangeCount, imageChangeCount;
+
+- (void)reportLoggedIn {}
+- (void)reportLoggedOut {}
+
+- (void)userLoggedOut:(AWEzvContact *)contact
+{
+	[reportedStates removeObjectForKey:contact.uniqueID];
+	[reportedPictures removeObjectForKey:contact.uniqueID];
+}
+
+- (void)userChangedState:(AWEzvContact *)contact
+{
+	stateChangeCount++;
+	[reportedStates setObject:stateDescription(contact.name, contact.status, contact.statusMessage) forKey:contact.uniqueID];
+}
+
+- (void)userChangedImage:(AWEzvContact *)contact
+{
+	imageChangeCount++;
+	if (contact.contactImageData) {
+		[reportedPictures setObject:contact.contactImageData forKey:contact.uniqueID];
+	} else {
+		[reportedPictures removeObjectForKey:contact.uniqueID];
+	}
+}
+
+- (void)user:(AWEzvContact *)contact sentMessage:(NSString *)message withHtml:(NSString *)html {}
+- (void)user:(AWEzvContact *)contact typingNotification:(AWEzvTyping)typingStatus {}
+- (void)user:(AWEzvContact *)contact typeAhead:(NSString *)message withHtml:(NSString *)html {}
+- (void)updateProgressForFileTransfer:(EKEzvFileTransfer *)fileTransfer percent:(NSNumber *)percent bytesSent:(NSNumber *)bytesSent {}
+- (void)remoteCanceledFileTransfer:(EKEzvFileTransfer *)fileTransfer {}
+- (void)transferFailed:(EKEzvFileTransfer *)fileTransfer {}
+- (void)user:(AWEzvContact *)contact sentFile:(EKEzvFileTransfer *)fileTransfer {}
+- (void)remoteUserBeganDownload:(EKEzvOutgoingFileTransfer *)fileTransfer {}
+- (void)remoteUserFinishedDownload:(EKEzvOutgoingFileTransfer *)fileTransfer {}
+
+- (void)reportError:(NSString *)error ofLevel:(AWEzvErrorSeverity)severity
+{
+	[errors addObject:error];
+}
+
+- (void)reportError:(NSString *)error ofLevel:(AWEzvErrorSeverity)severity forUser:(NSString *)contact
+{
+	[errors addObject:[NSString stringWithFormat:@"%@: %@", contact, error]];
+}
+
+@end
+
+/*!
+ * @class AIBonjourPresenceBenchmarkPeer
+ * @brief Someone else on the LAN, publishing a _presence._tcp service as iChat or another Adium would
+ */
+@interface AIBonjourPresenceBenchmarkPeer : NSObject {
+	AWEzvLoopbackBackend	*backend;
+	NSString				*name;
+	NSString				*nickname;
+	NSString				*status;
+	NSString				*message;
+	NSData					*picture;
+	BOOL					online;
+}
+- (id)initWithIndex:(NSUInteger)index network:(AWEzvLoopbackNetwork *)network;
+- (void)join;
+- (void)leave;
+- (void)announce;
+- (void)setPicture:(NSData *)inPicture;
+@property (readonly, nonatomic) NSString *name;
+@property (readonly, nonatomic) NSString *nickname;
+@property (readwrite, copy, nonatomic) NSString *status;
+@property (readwrite, copy, nonatomic) NSString *message;
+@property (readonly, nonatomic) NSData *picture;
+@property (readonly, nonatomic) BOOL online;
+@end
+
+@implementation AIBonjourPresenceBenchmarkPeer
+
+- (id)initWithIndex:(NSUInteger)index network:(AWEzvLoopbackNetwork *)network
+{
+	if ((self = [super init])) {
+		backend = [[AWEzvLoopbackBackend alloc] initWithNetwork:network];
+		name = [[NSString alloc] initWithFormat:@"peer%lu@benchmark%lu", (unsigned long)index, (unsigned long)index];
+		nickname = [[NSString alloc] initWithFormat:@"Peer %lu", (unsigned long)index];
+		status = @"avail";
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[backend release];
+	[name release];
+	[nickname release];
+	[status release];
+	[message release];
+	[picture release];
+
+	[super dealloc];
+}
+
+@synthesize name, nickname, status, message, picture, online;
+
+- (NSData *)TXTRecord
+{
+	AWEzvRendezvousData *data = [[[AWEzvRendezvousData alloc] init] autorelease];
+
+	[data setField:@"1st" content:nickname];
+	[data setField:@"status" content:status];
+	[data setField:@"port.p2pj" content:PEER_PORT];
+	[data setField:@"txtvers" content:@"1"];
+	[data setField:@"version" content:@"1"];
+	if (message) [data setField:@"msg" content:message];
+	if (picture) [data setField:@"phsh" content:pictureHash(picture)];
+
+	return [data dataAsTXTRecordData];
+}
+
+- (void)join
+{
+	[backend registerInstanceName:name port:0 TXTRecord:[self TXTRecord]];
+	if (picture) [backend setImageRecord:picture];
+	online = YES;
+}
+
+- (void)leave
+{
+	[backend unregister];
+	online = NO;
+}
+
+- (void)announce
+{
+	[backend updateTXTRecord:[self TXTRecord]];
+}
+
+- (void)setPicture:(NSData *)inPicture
+{
+	if (picture != inPicture) {
+		[picture release];
+		picture = [inPicture retain];
+	}
+
+	if (online) [backend setImageRecord:picture];
+}
+
+@end
+
+#pragma mark -
+
+@implementation AIBonjourPresenceBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:500], KEY_BONJOUR_BENCHMARK_PEERS,
+			[NSNumber numberWithUnsignedInteger:50], KEY_BONJOUR_BENCHMARK_ROUNDS,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AIBonjourPresenceBenchmark *benchmark = [[[self alloc] init] autorelease];
+
+	benchmark.peerCount = [defaults integerForKey:KEY_BONJOUR_BENCHMARK_PEERS];
+	benchmark.roundCount = [defaults integerForKey:KEY_BONJOUR_BENCHMARK_ROUNDS];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (id)init
+{
+	if ((self = [super init])) {
+		peerCount = 500;
+		roundCount = 50;
+		seed = 1;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[mismatches release];
+
+	[super dealloc];
+}
+
+@synthesize peerCount, roundCount, seed;
+
+- (NSDictionary *)run
+{
+	NSMutableArray			*peers = [NSMutableArray arrayWithCapacity:peerCount];
+	NSMutableArray			*stockPictures = [NSMutableArray arrayWithCapacity:STOCK_PICTURE_COUNT];
+	NSMutableSet			*pictureHashes = [NSMutableSet set];
+	NSUInteger				i, round, announcementCount = 0, legacyImageFetchCount = 0, parseCount;
+	uint32_t				random = seed;
+	uint64_t				start, processingTime = 0;
+
+	[mismatches release]; mismatches = [[NSMutableArray alloc] init];
+
+	AWEzvLoopbackNetwork	*network = [[[AWEzvLoopbackNetwork alloc] init] autorelease];
+	network.deliversAutomatically = NO;
+
+	for (i = 0; i < STOCK_PICTURE_COUNT; i++) [stockPictures addObject:randomPicture(&random)];
+
+	//Seven in ten peers have a picture of their own, one in ten a stock picture, and the rest none
+	for (i = 0; i < peerCount; i++) {
+		AIBonjourPresenceBenchmarkPeer	*peer = [[[AIBonjourPresenceBenchmarkPeer alloc] initWithIndex:i network:network] autorelease];
+		uint32_t						kind = nextRandom(&random) % 10;
+
+		if (kind < 7) {
+			[peer setPicture:randomPicture(&random)];
+		} else if (kind < 8) {
+			[peer setPicture:[stockPictures objectAtIndex:nextRandom(&random) % STOCK_PICTURE_COUNT]];
+		}
+		if (peer.picture) {
+			[pictureHashes addObject:pictureHash(peer.picture)];
+			legacyImageFetchCount++;
+		}
+
+		[peer join];
+		announcementCount++;
+		[peers addObject:peer];
+	}
+
+	AIBonjourPresenceBenchmarkClient	*client = [[[AIBonjourPresenceBenchmarkClient alloc] init] autorelease];
+	AWEzv								*ezv = [[[AWEzv alloc] initWithClient:client] autorelease];
+	AWEzvLoopbackBackend				*backend = [[[AWEzvLoopbackBackend alloc] initWithNetwork:network] autorelease];
+	AWEzvContactManager					*manager = [[AWEzvContactManager alloc] initWithClient:ezv backend:backend];
+
+	[ezv setName:@"Benchmark"];
+	[ezv setStatus:AWEzvOnline withMessage:nil];
+
+	parseCount = [AWEzvRendezvousData TXTRecordParseCount];
+
+	start = mach_absolute_time();
+	[manager login];
+	[network deliverPendingResults];
+	[manager flushContactStateChanges];
+	processingTime += mach_absolute_time() - start;
+
+	for (round = 0; round < roundCount; round++) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+		for (AIBonjourPresenceBenchmarkPeer *peer in peers) {
+			uint32_t action = nextRandom(&random) % 100;
+
+			if (!peer.online) {
+				//Back after a moment
+				if (action < 30) {
+					[peer join];
+					announcementCount++;
+					if (peer.picture) legacyImageFetchCount++;
+				}
+
+			} else if (action < 15) {
+				//Away and straight back
+				NSString *status = [[peer.status retain] autorelease];
+				peer.status = @"away";
+				[peer announce];
+				peer.status = status;
+				[peer announce];
+				announcementCount += 2;
+
+			} else if (action < 20) {
+				peer.status = ([peer.status isEqualToString:@"dnd"] ? @"avail" : @"dnd");
+				[peer announce];
+				announcementCount++;
+
+			} else if (action < 22) {
+				peer.message = (peer.message ? nil : [NSString stringWithFormat:@"Round %lu", (unsigned long)round]);
+				[peer announce];
+				announcementCount++;
+
+			} else if (action < 24) {
+				//The record is refreshed without changing
+				[peer announce];
+				announcementCount++;
+
+			} else if (action < 25) {
+				[peer setPicture:randomPicture(&random)];
+				[pictureHashes addObject:pictureHash(peer.picture)];
+				[peer announce];
+				announcementCount++;
+				legacyImageFetchCount++;
+
+			} else if (action < 29) {
+				[peer leave];
+			}
+		}
+
+		start = mach_absolute_time();
+		[network deliverPendingResults];
+		[manager flushContactStateChanges];
+		processingTime += mach_absolute_time() - start;
+
+		[pool release];
+	}
+
+	parseCount = [AWEzvRendezvousData TXTRecordParseCount] - parseCount;
+
+	//Check that the client was left with everyone's latest state and picture
+	for (AIBonjourPresenceBenchmarkPeer *peer in peers) {
+		NSString	*reportedState = [client.reportedStates objectForKey:peer.name];
+		NSData		*reportedPicture = [client.reportedPictures objectForKey:peer.name];
+
+		if (!peer.online) {
+			if (reportedState || [manager contactForIdentifier:peer.name]) {
+				[mismatches addObject:[NSString stringWithFormat:@"%@ is offline, but is still listed as %@", peer.name, reportedState]];
+			}
+			continue;
+		}
+
+		NSString *expectedState = stateDescription(peer.nickname, statusForField(peer.status), peer.message);
+		if (![reportedState isEqualToString:expectedState]) {
+			[mismatches addObject:[NSString stringWithFormat:@"%@ was reported as %@, expected %@", peer.name, reportedState, expectedState]];
+		}
+		if (reportedPicture != peer.picture && ![reportedPicture isEqualToData:peer.picture]) {
+			[mismatches addObject:[NSString stringWithFormat:@"%@ was shown with a picture of %lu bytes, expected %lu", peer.name,
+								   (unsigned long)reportedPicture.length, (unsigned long)peer.picture.length]];
+		}
+	}
+
+	for (NSString *error in client.errors) {
+		[mismatches addObject:[NSString stringWithFormat:@"Error reported: %@", error]];
+	}
+
+	[manager logout];
+	[manager release];
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:peerCount], KEY_BONJOUR_REPORT_PEERS,
+			[NSNumber numberWithUnsignedInteger:roundCount], KEY_BONJOUR_REPORT_ROUNDS,
+			[NSNumber numberWithUnsignedInteger:announcementCount], KEY_BONJOUR_REPORT_ANNOUNCEMENTS,
+			[NSNumber numberWithUnsignedInteger:network.resolveResultCount], KEY_BONJOUR_REPORT_RESOLVES,
+			[NSNumber numberWithUnsignedInteger:parseCount], KEY_BONJOUR_REPORT_PARSES,
+			[NSNumber numberWithUnsignedInteger:client.stateChangeCount], KEY_BONJOUR_REPORT_STATE_CHANGES,
+			[NSNumber numberWithUnsignedInteger:client.imageChangeCount], KEY_BONJOUR_REPORT_IMAGE_CHANGES,
+			[NSNumber numberWithUnsignedInteger:network.imageResultCount], KEY_BONJOUR_REPORT_IMAGE_FETCHES,
+			[NSNumber numberWithUnsignedInteger:legacyImageFetchCount], KEY_BONJOUR_REPORT_LEGACY_IMAGE_FETCHES,
+			[NSNumber numberWithUnsignedInteger:pictureHashes.count], KEY_BONJOUR_REPORT_DISTINCT_IMAGES,
+			[NSNumber numberWithDouble:secondsFromMachTime(processingTime)], KEY_BONJOUR_REPORT_SECONDS,
+			mismatches, KEY_BONJOUR_REPORT_MISMATCHES,
+			nil];
+}
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSArray			*reportMismatches = [report objectForKey:KEY_BONJOUR_REPORT_MISMATCHES];
+	NSNumber		*resolveCount = [report objectForKey:KEY_BONJOUR_REPORT_RESOLVES];
+
+	[description appendFormat:@"Peers: %@, rounds: %@, announcements: %@, resolve results: %@\n",
+	 [report objectForKey:KEY_BONJOUR_REPORT_PEERS], [report objectForKey:KEY_BONJOUR_REPORT_ROUNDS],
+	 [report objectForKey:KEY_BONJOUR_REPORT_ANNOUNCEMENTS], resolveCount];
+	[description appendFormat:@"TXT records parsed: %@ (previously %@)\n",
+	 [report objectForKey:KEY_BONJOUR_REPORT_PARSES], resolveCount];
+	[description appendFormat:@"State changes reported: %@ (previously %@)\n",
+	 [report objectForKey:KEY_BONJOUR_REPORT_STATE_CHANGES], resolveCount];
+	[description appendFormat:@"Pictures fetched: %@ (previously %@) of %@ distinct; picture changes reported: %@\n",
+	 [report objectForKey:KEY_BONJOUR_REPORT_IMAGE_FETCHES], [report objectForKey:KEY_BONJOUR_REPORT_LEGACY_IMAGE_FETCHES],
+	 [report objectForKey:KEY_BONJOUR_REPORT_DISTINCT_IMAGES], [report objectForKey:KEY_BONJOUR_REPORT_IMAGE_CHANGES]];
+	[description appendFormat:@"Time in libezv: %.3f s\n", [[report objectForKey:KEY_BONJOUR_REPORT_SECONDS] doubleValue]];
+	[description appendFormat:@"Mismatches: %lu\n", (unsigned long)reportMismatches.count];
+
+	for (NSUInteger i = 0; i < reportMismatches.count && i < MAX_REPORTED_MISMATCHES; i++) {
+		[description appendFormat:@"  %@\n", [reportMismatches objectAtIndex:i]];
+	}
+
+	return description;
+}
+
+@end
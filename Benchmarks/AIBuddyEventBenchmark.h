@@ -0,0 +1,99 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+#import <Adium/AIContactObserverManager.h>
+
+@class AIBenchmarkAccount;
+struct AIStubBuddy;
+
+//Report keys
+#define KEY_BUDDY_EVENT_REPORT_BUDDIES			@"Buddies"
+#define KEY_BUDDY_EVENT_REPORT_ROUNDS			@"Rounds"
+#define KEY_BUDDY_EVENT_REPORT_SIGNALS			@"Signals"
+#define KEY_BUDDY_EVENT_REPORT_TURNS			@"Turns"
+#define KEY_BUDDY_EVENT_REPORT_MISMATCHES		@"Mismatches"
+#define KEY_BUDDY_EVENT_REPORT_PASSES			@"Passes"
+
+//Keys of each pass in KEY_BUDDY_EVENT_REPORT_PASSES
+#define KEY_BUDDY_EVENT_PASS_NAME				@"Name"
+#define KEY_BUDDY_EVENT_PASS_NOTIFICATIONS		@"Property Notifications"
+#define KEY_BUDDY_EVENT_PASS_LOOKUPS			@"Contact Lookups"
+#define KEY_BUDDY_EVENT_PASS_POOLS				@"Autorelease Pools"
+#define KEY_BUDDY_EVENT_PASS_OBJECTS			@"Objects Created"
+#define KEY_BUDDY_EVENT_PASS_ICON_COPIES		@"Icon Copies"
+#define KEY_BUDDY_EVENT_PASS_SECONDS			@"Seconds"
+
+/*!
+ * @class AIBuddyEventBenchmark
+ * @brief Replays a recorded sequence of libpurple buddy signals and counts what applying them to contacts costs
+ *
+ * The buddies are stand-ins for PurpleBuddy: a state for each, which the recording sets before each signal the way
+ * libpurple updates a presence before emitting its signal. The recording is a signon storm of buddyCount buddies,
+ * roundCount rounds of one event per buddy (away and back, message changes, idling, new icons, some preceded by an
+ * empty icon, reconnects and signoffs), then a signoff storm, in turns of up to a socket read's worth of signals.
+ *
+ * It is replayed twice, onto two sets of contacts on the account. The first pass does what adiumPurpleSignals did:
+ * each signal looks up its contact in its own autorelease pool and applies and notifies its one change, and a signon
+ * or signoff also runs the status, idle and login time updates. The second notes each signal in an AIChangeCoalescer
+ * and flushes it at the end of every turn, applying each buddy's changes from its state with one notification.
+ *
+ * Property notifications are those observed for each set of contacts; contact lookups, pools, objects created and
+ * icon copies are counted as the adapter makes them. After both passes every contact is checked against its
+ * counterpart, and the online ones against their buddy's state.
+ *
+ * Run with -AIBuddyEventBenchmark YES. Settings:
+ *	-AIBuddyEventBenchmarkBuddies <n>	Buddies to replay signals for (500)
+ *	-AIBuddyEventBenchmarkRounds <n>	Rounds of signals (20)
+ *	-AIContactListBenchmarkSeed <n>		Seed for the random choices (1)
+ */
+@interface AIBuddyEventBenchmark : NSObject <AIBenchmark, AIListObjectObserver> {
+	AIBenchmarkAccount	*account;
+
+	NSUInteger			buddyCount;
+	NSUInteger			roundCount;
+	uint32_t			seed;
+
+	NSMutableData		*recording;
+	NSUInteger			turnCount;
+	struct AIStubBuddy	*buddies;
+	NSArray				*stockIcons;
+
+	NSArray				*perEventContacts;
+	NSArray				*coalescedContacts;
+	NSSet				*observedContacts;
+	AIListContact		*contactBeingUpdated;
+
+	NSUInteger			notificationCount;
+	NSUInteger			lookupCount;
+	NSUInteger			poolCount;
+	NSUInteger			objectCount;
+	NSUInteger			iconCopyCount;
+
+	NSMutableArray		*mismatches;
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount;
+
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger buddyCount;
+@property (readwrite, nonatomic) NSUInteger roundCount;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
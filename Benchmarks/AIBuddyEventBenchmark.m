@@ -0,0 +1,737 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBuddyEventBenchmark.h"
+#import "AIBenchmarkAccount.h"
+#import <Adium/AIListContact.h>
+#import <Adium/AIUserIcons.h>
+#import <AIUtilities/AIChangeCoalescer.h>
+#import <mach/mach_time.h>
+
+//Settings
+#define KEY_BUDDY_EVENT_BENCHMARK_BUDDIES	@"AIBuddyEventBenchmarkBuddies"
+#define KEY_BUDDY_EVENT_BENCHMARK_ROUNDS	@"AIBuddyEventBenchmarkRounds"
+
+#define STOCK_ICON_COUNT				6
+#define STOCK_ICON_SIZE					32
+//The most signals libpurple emits for one socket read
+#define MAX_SIGNALS_PER_TURN			40
+#define START_TIME						1300000000
+//How many mismatches are described in the report
+#define MAX_REPORTED_MISMATCHES			20
+
+typedef enum {
+	AIBuddySignalStatusChanged = 0,
+	AIBuddySignalIdleChanged,
+	AIBuddySignalSignedOn,
+	AIBuddySignalSignedOff,
+	AIBuddySignalGotLoginTime,
+	AIBuddySignalIconChanged,
+	AIBuddySignalEndOfTurn
+} AIBuddySignal;
+
+//What the coalesced pass notes for each signal, as adiumPurpleSignals does
+enum {
+	AIBuddySignedOnOrOff		= 1 << 0,
+	AIBuddyStatusChanged		= 1 << 1,
+	AIBuddyIdleChanged			= 1 << 2,
+	AIBuddySignonTimeChanged	= 1 << 3,
+	AIBuddyIconChanged			= 1 << 4
+};
+
+/*!
+ * @brief A PurpleBuddy's presence, as far as the signals go
+ */
+struct AIStubBuddy {
+	BOOL		online;
+	BOOL		away;
+	BOOL		mobile;
+	NSUInteger	message;	//0 for none
+	time_t		idleSince;	//0 when not idle
+	time_t		loginTime;
+	NSUInteger	icon;		//0 for none, otherwise 1 + an index into stockIcons
+};
+typedef struct AIStubBuddy AIStubBuddy;
+
+typedef struct {
+	NSUInteger		buddy;
+	AIBuddySignal	signal;
+	AIStubBuddy		state;	//The buddy's state when the signal is emitted
+} AIRecordedSignal;
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+static NSData *stockIconData(NSUInteger idx)
+{
+	NSImage *image = [[[NSImage alloc] initWithSize:NSMakeSize(STOCK_ICON_SIZE, STOCK_ICON_SIZE)] autorelease];
+
+	[image lockFocus];
+	[[NSColor colorWithCalibratedHue:(CGFloat)idx / STOCK_ICON_COUNT saturation:0.8f brightness:0.9f alpha:1.0f] set];
+	NSRectFill(NSMakeRect(0, 0, STOCK_ICON_SIZE, STOCK_ICON_SIZE));
+	[image unlockFocus];
+
+	return [image TIFFRepresentation];
+}
+
+static NSString *messageString(NSUInteger message)
+{
+	return (message ? [NSString stringWithFormat:@"Status message %lu", (unsigned long)message] : nil);
+}
+
+static BOOL objectsMatch(id a, id b)
+{
+	return (a == b || [a isEqual:b]);
+}
+
+@interface AIBuddyEventBenchmark ()
+- (void)record;
+- (void)recordSignal:(AIBuddySignal)signal forBuddy:(NSUInteger)idx state:(AIStubBuddy)state;
+- (void)recordEndOfTurn;
+- (AIListContact *)lookUpContactForBuddy:(NSUInteger)idx inContacts:(NSArray *)contacts;
+- (void)notifyOfChangedPropertiesOfContact:(AIListContact *)contact;
+- (void)applyOnline:(BOOL)online toContact:(AIListContact *)contact;
+- (void)applyStatusOfBuddy:(AIStubBuddy *)buddy toContact:(AIListContact *)contact;
+- (void)applyIdleOfBuddy:(AIStubBuddy *)buddy toContact:(AIListContact *)contact;
+- (void)applyLoginTimeOfBuddy:(AIStubBuddy *)buddy toContact:(AIListContact *)contact;
+- (void)applyIconOfBuddy:(AIStubBuddy *)buddy toContact:(AIListContact *)contact;
+- (void)perEventStatusChangedForBuddy:(NSUInteger)idx;
+- (void)perEventIdleChangedForBuddy:(NSUInteger)idx;
+- (void)perEvent:(AIBuddySignal)signal forBuddy:(NSUInteger)idx;
+- (void)applyChanges:(NSUInteger)changes toBuddy:(NSUInteger)idx;
+- (NSDictionary *)replayCoalescing:(BOOL)coalesce;
+- (void)checkContacts;
+@end
+
+@implementation AIBuddyEventBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:500], KEY_BUDDY_EVENT_BENCHMARK_BUDDIES,
+			[NSNumber numberWithUnsignedInteger:20], KEY_BUDDY_EVENT_BENCHMARK_ROUNDS,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AIBuddyEventBenchmark *benchmark = [[[self alloc] initWithAccount:[AIBenchmarkAccount addTemporaryAccountWithUID:BENCHMARK_ACCOUNT_UID]] autorelease];
+
+	benchmark.buddyCount = [defaults integerForKey:KEY_BUDDY_EVENT_BENCHMARK_BUDDIES];
+	benchmark.roundCount = [defaults integerForKey:KEY_BUDDY_EVENT_BENCHMARK_ROUNDS];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (void)deleteAccounts
+{
+	[account deleteTemporaryAccount];
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount
+{
+	if ((self = [super init])) {
+		account = [inAccount retain];
+		buddyCount = 500;
+		roundCount = 20;
+		seed = 1;
+		mismatches = [[NSMutableArray alloc] init];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[account release];
+	[recording release];
+	[stockIcons release];
+	[perEventContacts release];
+	[coalescedContacts release];
+	[observedContacts release];
+	[mismatches release];
+	free(buddies);
+
+	[super dealloc];
+}
+
+@synthesize buddyCount, roundCount, seed;
+
+#pragma mark Recording
+
+- (void)recordSignal:(AIBuddySignal)signal forBuddy:(NSUInteger)idx state:(AIStubBuddy)state
+{
+	AIRecordedSignal recorded = { idx, signal, state };
+
+	[recording appendBytes:&recorded length:sizeof(recorded)];
+}
+
+- (void)recordEndOfTurn
+{
+	AIRecordedSignal recorded;
+
+	memset(&recorded, 0, sizeof(recorded));
+	recorded.signal = AIBuddySignalEndOfTurn;
+	[recording appendBytes:&recorded length:sizeof(recorded)];
+	turnCount++;
+}
+
+/*!
+ * @brief Record the signon storm, the rounds of events and the signoff storm
+ *
+ * Signals are emitted in the order libpurple emits them: a buddy signing on changes status, signs on, goes idle if it
+ * is, gets its login time and then its icon.
+ */
+- (void)record
+{
+	AIStubBuddy		*states = calloc(buddyCount, sizeof(AIStubBuddy));
+	uint32_t		random = seed;
+	NSUInteger		message = 0, signalsInTurn = 0, turnLimit, idx, round, i;
+	time_t			now = START_TIME;
+
+	[recording release];
+	recording = [[NSMutableData alloc] init];
+	turnCount = 0;
+	turnLimit = 1 + nextRandom(&random) % MAX_SIGNALS_PER_TURN;
+
+#define RECORD(signal) do { \
+		[self recordSignal:(signal) forBuddy:idx state:*state]; \
+		if (++signalsInTurn >= turnLimit) { \
+			[self recordEndOfTurn]; \
+			signalsInTurn = 0; \
+			turnLimit = 1 + nextRandom(&random) % MAX_SIGNALS_PER_TURN; \
+		} \
+	} while (0)
+
+#define RECORD_NEW_ICON() do { \
+		/* An empty icon update often comes just before the new icon */ \
+		if (nextRandom(&random) % 3 == 0) { \
+			state->icon = 0; \
+			RECORD(AIBuddySignalIconChanged); \
+		} \
+		state->icon = 1 + nextRandom(&random) % STOCK_ICON_COUNT; \
+		RECORD(AIBuddySignalIconChanged); \
+	} while (0)
+
+#define RECORD_SIGNON() do { \
+		state->online = YES; \
+		state->away = (nextRandom(&random) % 5 == 0); \
+		state->mobile = (nextRandom(&random) % 10 == 0); \
+		state->message = (nextRandom(&random) % 2 ? ++message : 0); \
+		state->idleSince = (nextRandom(&random) % 7 == 0 ? now - (time_t)(nextRandom(&random) % 3600) : 0); \
+		state->loginTime = now - (time_t)(nextRandom(&random) % 600); \
+		RECORD(AIBuddySignalStatusChanged); \
+		RECORD(AIBuddySignalSignedOn); \
+		if (state->idleSince) RECORD(AIBuddySignalIdleChanged); \
+		RECORD(AIBuddySignalGotLoginTime); \
+		if (nextRandom(&random) % 10 < 7) RECORD_NEW_ICON(); \
+	} while (0)
+
+#define RECORD_SIGNOFF() do { \
+		state->online = NO; \
+		state->away = NO; \
+		state->mobile = NO; \
+		state->message = 0; \
+		RECORD(AIBuddySignalStatusChanged); \
+		RECORD(AIBuddySignalSignedOff); \
+	} while (0)
+
+	//Everyone signs on as we connect
+	for (idx = 0; idx < buddyCount; idx++) {
+		AIStubBuddy *state = &states[idx];
+		RECORD_SIGNON();
+	}
+
+	for (round = 0; round < roundCount; round++) {
+		for (i = 0; i < buddyCount; i++) {
+			AIStubBuddy	*state;
+			uint32_t	choice;
+
+			idx = nextRandom(&random) % buddyCount;
+			state = &states[idx];
+			choice = nextRandom(&random) % 100;
+			now += 1 + nextRandom(&random) % 5;
+
+			if (!state->online) {
+				RECORD_SIGNON();
+
+			} else if (choice < 30) {
+				//Away, with a message; the status is often sent twice over
+				state->away = YES;
+				state->message = ++message;
+				RECORD(AIBuddySignalStatusChanged);
+				if (nextRandom(&random) % 3 == 0) RECORD(AIBuddySignalStatusChanged);
+
+			} else if (choice < 45) {
+				state->away = NO;
+				state->message = (nextRandom(&random) % 2 ? ++message : 0);
+				RECORD(AIBuddySignalStatusChanged);
+
+			} else if (choice < 60) {
+				state->idleSince = (state->idleSince ? 0 : now - (time_t)(nextRandom(&random) % 600));
+				RECORD(AIBuddySignalIdleChanged);
+
+			} else if (choice < 70) {
+				RECORD_NEW_ICON();
+
+			} else if (choice < 80) {
+				state->mobile = !state->mobile;
+				RECORD(AIBuddySignalStatusChanged);
+
+			} else if (choice < 90) {
+				//Dropped and straight back
+				RECORD_SIGNOFF();
+				RECORD_SIGNON();
+
+			} else {
+				RECORD_SIGNOFF();
+			}
+		}
+	}
+
+	//Everyone signs off as we disconnect
+	for (idx = 0; idx < buddyCount; idx++) {
+		AIStubBuddy *state = &states[idx];
+		if (state->online) RECORD_SIGNOFF();
+	}
+
+	if (signalsInTurn) [self recordEndOfTurn];
+
+#undef RECORD_SIGNOFF
+#undef RECORD_SIGNON
+#undef RECORD_NEW_ICON
+#undef RECORD
+
+	free(states);
+}
+
+#pragma mark Applying changes
+
+/*!
+ * @brief contactLookupFromBuddy()
+ */
+- (AIListContact *)lookUpContactForBuddy:(NSUInteger)idx inContacts:(NSArray *)contacts
+{
+	lookupCount++;
+
+	return [contacts objectAtIndex:idx];
+}
+
+/* These make the same changes as CBPurpleAccount's update methods, counting the objects they create. */
+
+- (void)notifyOfChangedPropertiesOfContact:(AIListContact *)contact
+{
+	if (contact != contactBeingUpdated)
+		[contact notifyOfChangedPropertiesSilently:NO];
+}
+
+- (void)applyOnline:(BOOL)online toContact:(AIListContact *)contact
+{
+	[contact setOnline:online notify:NotifyLater silently:NO];
+
+	[self notifyOfChangedPropertiesOfContact:contact];
+}
+
+- (void)applyStatusOfBuddy:(AIStubBuddy *)buddy toContact:(AIListContact *)contact
+{
+	NSString	*message = messageString(buddy->message);
+
+	//The status type number and the decoded message
+	objectCount += (message ? 2 : 1);
+
+	[contact setStatusWithName:nil
+					statusType:(buddy->away ? AIAwayStatusType : AIAvailableStatusType)
+						notify:NotifyLater];
+	[contact setStatusMessage:(message ? [[[NSAttributedString alloc] initWithString:message] autorelease] : nil)
+					   notify:NotifyLater];
+	[contact setIsMobile:buddy->mobile notify:NotifyLater];
+
+	[self notifyOfChangedPropertiesOfContact:contact];
+}
+
+- (void)applyIdleOfBuddy:(AIStubBuddy *)buddy toContact:(AIListContact *)contact
+{
+	if (buddy->idleSince) {
+		objectCount++;
+		[contact setIdle:YES sinceDate:[NSDate dateWithTimeIntervalSince1970:buddy->idleSince] notify:NotifyLater];
+	} else {
+		[contact setIdle:NO sinceDate:nil notify:NotifyLater];
+	}
+
+	[self notifyOfChangedPropertiesOfContact:contact];
+}
+
+- (void)applyLoginTimeOfBuddy:(AIStubBuddy *)buddy toContact:(AIListContact *)contact
+{
+	if (buddy->loginTime) objectCount++;
+	[contact setSignonDate:(buddy->loginTime ? [NSDate dateWithTimeIntervalSince1970:buddy->loginTime] : nil)
+					notify:NotifyLater];
+
+	[self notifyOfChangedPropertiesOfContact:contact];
+}
+
+/*!
+ * @brief Copy the buddy's icon and set it
+ *
+ * An empty icon is left alone: the account clears the icon after a delay, which the icon that follows cancels.
+ */
+- (void)applyIconOfBuddy:(AIStubBuddy *)buddy toContact:(AIListContact *)contact
+{
+	if (!buddy->icon) return;
+
+	NSData *stockIcon = [stockIcons objectAtIndex:buddy->icon - 1];
+
+	iconCopyCount++;
+	objectCount++;
+	[contact setServersideIconData:[NSData dataWithBytes:[stockIcon bytes] length:[stockIcon length]]
+							notify:NotifyLater];
+
+	[self notifyOfChangedPropertiesOfContact:contact];
+}
+
+#pragma mark Per event
+
+/* What adiumPurpleSignals used to do for each signal */
+
+- (void)perEventStatusChangedForBuddy:(NSUInteger)idx
+{
+	NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+	AIListContact		*contact = [self lookUpContactForBuddy:idx inContacts:perEventContacts];
+
+	poolCount++;
+	[self applyStatusOfBuddy:&buddies[idx] toContact:contact];
+
+	[pool release];
+}
+
+- (void)perEventIdleChangedForBuddy:(NSUInteger)idx
+{
+	NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+	AIListContact		*contact = [self lookUpContactForBuddy:idx inContacts:perEventContacts];
+
+	poolCount++;
+	[self applyIdleOfBuddy:&buddies[idx] toContact:contact];
+
+	[pool release];
+}
+
+- (void)perEvent:(AIBuddySignal)signal forBuddy:(NSUInteger)idx
+{
+	NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+	AIListContact		*contact = [self lookUpContactForBuddy:idx inContacts:perEventContacts];
+	AIStubBuddy			*buddy = &buddies[idx];
+
+	poolCount++;
+
+	switch (signal) {
+		case AIBuddySignalSignedOn:
+			[self applyOnline:YES toContact:contact];
+			break;
+		case AIBuddySignalSignedOff:
+			[self applyOnline:NO toContact:contact];
+			break;
+		case AIBuddySignalGotLoginTime:
+			[self applyLoginTimeOfBuddy:buddy toContact:contact];
+			break;
+		case AIBuddySignalIconChanged:
+			[self applyIconOfBuddy:buddy toContact:contact];
+			break;
+		default:
+			break;
+	}
+
+	if (signal == AIBuddySignalSignedOn || signal == AIBuddySignalSignedOff) {
+		[self perEventStatusChangedForBuddy:idx];
+
+		if (signal == AIBuddySignalSignedOn) {
+			[self perEventIdleChangedForBuddy:idx];
+			[self perEvent:AIBuddySignalGotLoginTime forBuddy:idx];
+		}
+	}
+
+	[pool release];
+}
+
+#pragma mark Coalesced
+
+/*!
+ * @brief apply_buddy_changes()
+ */
+- (void)applyChanges:(NSUInteger)changes toBuddy:(NSUInteger)idx
+{
+	NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+	AIListContact		*contact = [self lookUpContactForBuddy:idx inContacts:coalescedContacts];
+	AIStubBuddy			*buddy = &buddies[idx];
+
+	poolCount++;
+
+	if (changes & AIBuddySignedOnOrOff) {
+		changes |= AIBuddyStatusChanged;
+		if (buddy->online) changes |= (AIBuddyIdleChanged | AIBuddySignonTimeChanged);
+	}
+
+	contactBeingUpdated = contact;
+
+	if (changes & AIBuddySignedOnOrOff) [self applyOnline:buddy->online toContact:contact];
+	if (changes & AIBuddyStatusChanged) [self applyStatusOfBuddy:buddy toContact:contact];
+	if (changes & AIBuddyIdleChanged) [self applyIdleOfBuddy:buddy toContact:contact];
+	if (changes & AIBuddySignonTimeChanged) [self applyLoginTimeOfBuddy:buddy toContact:contact];
+	if (changes & AIBuddyIconChanged) [self applyIconOfBuddy:buddy toContact:contact];
+
+	contactBeingUpdated = nil;
+	[contact notifyOfChangedPropertiesSilently:NO];
+
+	[pool release];
+}
+
+#pragma mark Replaying
+
+- (NSSet *)updateListObject:(AIListObject *)inObject keys:(NSSet *)inModifiedKeys silent:(BOOL)silent
+{
+	if (inModifiedKeys && [observedContacts containsObject:inObject]) notificationCount++;
+
+	return nil;
+}
+
+/*!
+ * @brief Replay the recording onto one set of contacts and report its costs
+ */
+- (NSDictionary *)replayCoalescing:(BOOL)coalesce
+{
+	const AIRecordedSignal	*signals = [recording bytes];
+	NSUInteger				signalCount = [recording length] / sizeof(AIRecordedSignal), i;
+	AIChangeCoalescer		*coalescer = nil;
+	uint64_t				start;
+
+	memset(buddies, 0, buddyCount * sizeof(AIStubBuddy));
+
+	[observedContacts release];
+	observedContacts = [[NSSet alloc] initWithArray:(coalesce ? coalescedContacts : perEventContacts)];
+
+	if (coalesce) {
+		coalescer = [[AIChangeCoalescer alloc] initWithHandler:^(void *key, NSUInteger changes) {
+			[self applyChanges:changes toBuddy:(AIStubBuddy *)key - buddies];
+		}];
+		coalescer.schedulesFlushes = NO;
+	}
+
+	notificationCount = 0;
+	lookupCount = 0;
+	poolCount = 0;
+	objectCount = 0;
+	iconCopyCount = 0;
+
+	start = mach_absolute_time();
+
+	for (i = 0; i < signalCount; i++) {
+		const AIRecordedSignal *recorded = &signals[i];
+
+		if (recorded->signal == AIBuddySignalEndOfTurn) {
+			//The end of a run loop turn
+			[coalescer flush];
+			continue;
+		}
+
+		buddies[recorded->buddy] = recorded->state;
+
+		if (coalesce) {
+			NSUInteger changes = 0;
+
+			switch (recorded->signal) {
+				case AIBuddySignalSignedOn:
+				case AIBuddySignalSignedOff:
+					changes = AIBuddySignedOnOrOff;
+					break;
+				case AIBuddySignalStatusChanged:
+					changes = AIBuddyStatusChanged;
+					break;
+				case AIBuddySignalIdleChanged:
+					changes = AIBuddyIdleChanged;
+					break;
+				case AIBuddySignalGotLoginTime:
+					changes = AIBuddySignonTimeChanged;
+					break;
+				case AIBuddySignalIconChanged:
+					changes = AIBuddyIconChanged;
+					break;
+				default:
+					break;
+			}
+
+			[coalescer addChanges:changes forKey:&buddies[recorded->buddy]];
+
+		} else if (recorded->signal == AIBuddySignalStatusChanged) {
+			[self perEventStatusChangedForBuddy:recorded->buddy];
+		} else if (recorded->signal == AIBuddySignalIdleChanged) {
+			[self perEventIdleChangedForBuddy:recorded->buddy];
+		} else {
+			[self perEvent:recorded->signal forBuddy:recorded->buddy];
+		}
+	}
+
+	[coalescer flush];
+	[coalescer release];
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			(coalesce ? @"Coalesced" : @"Per event"), KEY_BUDDY_EVENT_PASS_NAME,
+			[NSNumber numberWithUnsignedInteger:notificationCount], KEY_BUDDY_EVENT_PASS_NOTIFICATIONS,
+			[NSNumber numberWithUnsignedInteger:lookupCount], KEY_BUDDY_EVENT_PASS_LOOKUPS,
+			[NSNumber numberWithUnsignedInteger:poolCount], KEY_BUDDY_EVENT_PASS_POOLS,
+			[NSNumber numberWithUnsignedInteger:objectCount], KEY_BUDDY_EVENT_PASS_OBJECTS,
+			[NSNumber numberWithUnsignedInteger:iconCopyCount], KEY_BUDDY_EVENT_PASS_ICON_COPIES,
+			[NSNumber numberWithDouble:secondsFromMachTime(mach_absolute_time() - start)], KEY_BUDDY_EVENT_PASS_SECONDS,
+			nil];
+}
+
+#pragma mark Checks
+
+/*!
+ * @brief Check each contact against its counterpart from the other pass, and the online ones against their buddy
+ *
+ * The buddies are as the coalesced pass left them, which is the end of the recording.
+ */
+- (void)checkContacts
+{
+	for (NSUInteger idx = 0; idx < buddyCount; idx++) {
+		AIListContact	*perEvent = [perEventContacts objectAtIndex:idx];
+		AIListContact	*coalesced = [coalescedContacts objectAtIndex:idx];
+		AIStubBuddy		*buddy = &buddies[idx];
+
+		if (perEvent.online != coalesced.online ||
+			perEvent.statusType != coalesced.statusType ||
+			perEvent.isMobile != coalesced.isMobile ||
+			!objectsMatch(perEvent.statusMessageString, coalesced.statusMessageString) ||
+			!objectsMatch([perEvent valueForProperty:@"idleSince"], [coalesced valueForProperty:@"idleSince"]) ||
+			!objectsMatch(perEvent.signonDate, coalesced.signonDate) ||
+			!objectsMatch([AIUserIcons serversideUserIconDataForObject:perEvent],
+						  [AIUserIcons serversideUserIconDataForObject:coalesced])) {
+			[mismatches addObject:[NSString stringWithFormat:@"Buddy %lu: the passes left its contact differently",
+								   (unsigned long)idx]];
+		}
+
+		if (!buddy->online) continue;
+
+		NSDate *idleSince = (buddy->idleSince ? [NSDate dateWithTimeIntervalSince1970:buddy->idleSince] : nil);
+		NSDate *signonDate = (buddy->loginTime ? [NSDate dateWithTimeIntervalSince1970:buddy->loginTime] : nil);
+
+		if (!coalesced.online ||
+			coalesced.statusType != (buddy->away ? AIAwayStatusType : AIAvailableStatusType) ||
+			coalesced.isMobile != buddy->mobile ||
+			!objectsMatch(coalesced.statusMessageString, messageString(buddy->message)) ||
+			!objectsMatch([coalesced valueForProperty:@"idleSince"], idleSince) ||
+			!objectsMatch(coalesced.signonDate, signonDate) ||
+			(buddy->icon && ![[AIUserIcons serversideUserIconDataForObject:coalesced] isEqualToData:[stockIcons objectAtIndex:buddy->icon - 1]])) {
+			[mismatches addObject:[NSString stringWithFormat:@"Buddy %lu: its contact doesn't match its presence",
+								   (unsigned long)idx]];
+		}
+	}
+}
+
+#pragma mark Running
+
+- (NSDictionary *)run
+{
+	NSMutableArray	*perEvent = [NSMutableArray array], *coalesced = [NSMutableArray array], *icons = [NSMutableArray array];
+	NSMutableArray	*passes = [NSMutableArray array];
+	NSUInteger		idx;
+
+	[mismatches removeAllObjects];
+
+	for (idx = 0; idx < STOCK_ICON_COUNT; idx++) {
+		[icons addObject:stockIconData(idx)];
+	}
+	[stockIcons release];
+	stockIcons = [icons copy];
+
+	free(buddies);
+	buddies = calloc(buddyCount, sizeof(AIStubBuddy));
+
+	[self record];
+
+	[account connect];
+	for (idx = 0; idx < buddyCount; idx++) {
+		[perEvent addObject:[account contactWithUID:[NSString stringWithFormat:@"perevent%lu", (unsigned long)idx]]];
+		[coalesced addObject:[account contactWithUID:[NSString stringWithFormat:@"coalesced%lu", (unsigned long)idx]]];
+	}
+	[account endSignOnDelay];
+
+	[perEventContacts release];
+	perEventContacts = [perEvent copy];
+	[coalescedContacts release];
+	coalescedContacts = [coalesced copy];
+
+	[[AIContactObserverManager sharedManager] registerListObjectObserver:self];
+
+	[passes addObject:[self replayCoalescing:NO]];
+	[passes addObject:[self replayCoalescing:YES]];
+
+	[[AIContactObserverManager sharedManager] unregisterListObjectObserver:self];
+
+	[self checkContacts];
+
+	[account disconnect];
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:buddyCount], KEY_BUDDY_EVENT_REPORT_BUDDIES,
+			[NSNumber numberWithUnsignedInteger:roundCount], KEY_BUDDY_EVENT_REPORT_ROUNDS,
+			[NSNumber numberWithUnsignedInteger:[recording length] / sizeof(AIRecordedSignal) - turnCount], KEY_BUDDY_EVENT_REPORT_SIGNALS,
+			[NSNumber numberWithUnsignedInteger:turnCount], KEY_BUDDY_EVENT_REPORT_TURNS,
+			passes, KEY_BUDDY_EVENT_REPORT_PASSES,
+			[[mismatches copy] autorelease], KEY_BUDDY_EVENT_REPORT_MISMATCHES,
+			nil];
+}
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSArray			*reportMismatches = [report objectForKey:KEY_BUDDY_EVENT_REPORT_MISMATCHES];
+
+	[description appendFormat:@"Buddies: %@, rounds: %@, signals: %@ in %@ run loop turns\n",
+	 [report objectForKey:KEY_BUDDY_EVENT_REPORT_BUDDIES], [report objectForKey:KEY_BUDDY_EVENT_REPORT_ROUNDS],
+	 [report objectForKey:KEY_BUDDY_EVENT_REPORT_SIGNALS], [report objectForKey:KEY_BUDDY_EVENT_REPORT_TURNS]];
+
+	for (NSDictionary *pass in [report objectForKey:KEY_BUDDY_EVENT_REPORT_PASSES]) {
+		[description appendFormat:@"%@: %@ property notifications, %@ contact lookups, %@ autorelease pools, "
+		 @"%@ objects created (%@ icon copies), %.3f s\n",
+		 [pass objectForKey:KEY_BUDDY_EVENT_PASS_NAME],
+		 [pass objectForKey:KEY_BUDDY_EVENT_PASS_NOTIFICATIONS], [pass objectForKey:KEY_BUDDY_EVENT_PASS_LOOKUPS],
+		 [pass objectForKey:KEY_BUDDY_EVENT_PASS_POOLS], [pass objectForKey:KEY_BUDDY_EVENT_PASS_OBJECTS],
+		 [pass objectForKey:KEY_BUDDY_EVENT_PASS_ICON_COPIES],
+		 [[pass objectForKey:KEY_BUDDY_EVENT_PASS_SECONDS] doubleValue]];
+	}
+
+	[description appendFormat:@"Mismatches: %lu\n", (unsigned long)reportMismatches.count];
+
+	for (NSUInteger i = 0; i < reportMismatches.count && i < MAX_REPORTED_MISMATCHES; i++) {
+		[description appendFormat:@"  %@\n", [reportMismatches objectAtIndex:i]];
+	}
+
+	return description;
+}
+
+@end
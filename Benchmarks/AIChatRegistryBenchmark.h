@@ -0,0 +1,66 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+
+@class AIBenchmarkAccount;
+
+//Report keys
+#define KEY_CHAT_REPORT_GROUP_CHATS			@"Group Chats"
+#define KEY_CHAT_REPORT_PARTICIPANTS		@"Participants Per Chat"
+#define KEY_CHAT_REPORT_ONE_TO_ONE_CHATS	@"One-to-one Chats"
+#define KEY_CHAT_REPORT_OPEN_TIME			@"Open Time"
+#define KEY_CHAT_REPORT_CHECKS				@"Checks"
+#define KEY_CHAT_REPORT_MISMATCHES			@"Mismatches"
+#define KEY_CHAT_REPORT_LOOKUPS				@"Lookups"
+
+/*!
+ * @class AIChatRegistryBenchmark
+ * @brief Opens synthetic chats through the chat controller and checks its chat registry against a linear scan
+ *
+ * Every lookup the registry answers is also made the old way, by scanning every open chat, and the results
+ * are compared and timed. The chats are closed again before -run returns.
+ *
+ * Run with -AIChatRegistryBenchmark YES. Settings:
+ *	-AIChatRegistryBenchmarkChats <n>			Group chats to open (100)
+ *	-AIChatRegistryBenchmarkParticipants <n>	Members of each group chat (5000)
+ *	-AIChatRegistryBenchmarkOneToOneChats <n>	One-to-one chats to open (200)
+ *	-AIContactListBenchmarkSeed <n>				Seed for the random choices (1)
+ */
+@interface AIChatRegistryBenchmark : NSObject <AIBenchmark> {
+	AIBenchmarkAccount	*account;
+
+	NSUInteger			groupChatCount;
+	NSUInteger			participantsPerChat;
+	NSUInteger			oneToOneChatCount;
+	uint32_t			seed;
+
+	NSMutableDictionary	*lookupCosts;
+	NSMutableArray		*mismatches;
+	NSUInteger			checkCount;
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount;
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger groupChatCount;
+@property (readwrite, nonatomic) NSUInteger participantsPerChat;
+@property (readwrite, nonatomic) NSUInteger oneToOneChatCount;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
@@ -0,0 +1,460 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIChatRegistryBenchmark.h"
+#import "AIBenchmarkAccount.h"
+#import "AIChatController.h"
+#import <Adium/AIChat.h>
+#import <Adium/AIContactControllerProtocol.h>
+#import <Adium/AIPreferenceControllerProtocol.h>
+#import <Adium/AIStatusControllerProtocol.h>
+#import <Adium/AIListContact.h>
+#import <Adium/AIMetaContact.h>
+#import <mach/mach_time.h>
+
+//Settings
+#define KEY_CHAT_BENCHMARK_CHATS			@"AIChatRegistryBenchmarkChats"
+#define KEY_CHAT_BENCHMARK_PARTICIPANTS		@"AIChatRegistryBenchmarkParticipants"
+#define KEY_CHAT_BENCHMARK_ONE_TO_ONE		@"AIChatRegistryBenchmarkOneToOneChats"
+
+//Every so many one-to-one contacts is put in a metacontact with a partner which has no chat of its own
+#define METACONTACT_INTERVAL			4
+//Every so many participants leaves its channel again after joining
+#define PARTICIPANT_CHURN_INTERVAL		50
+//How many channel participants are looked up; the linear lookups are too slow to try them all
+#define PARTICIPANT_LOOKUP_SAMPLE		200
+//How many times each unviewed count is asked for
+#define UNVIEWED_COUNT_ROUNDS			100
+//How many mismatches are described in the report
+#define MAX_REPORTED_MISMATCHES			20
+
+/*!
+ * @brief The lookups AIChatRegistry replaced, scanning every open chat
+ *
+ * Kept as the reference the registry is checked against.
+ */
+@interface AIChatController (AILinearChatLookups)
+- (AIChat *)linearExistingChatWithContact:(AIListContact *)inContact;
+- (NSSet *)linearAllChatsWithContact:(AIListContact *)inContact;
+- (NSSet *)linearAllGroupChatsContainingContact:(AIListContact *)inContact;
+- (BOOL)linearContactIsInGroupChat:(AIListContact *)listContact;
+- (NSUInteger)linearUnviewedContentCount;
+- (NSUInteger)linearUnviewedConversationCount;
+@end
+
+@interface AIChatRegistryBenchmark ()
+- (void)check:(NSString *)lookupName of:(id)subject indexed:(id (^)(void))indexedLookup linear:(id (^)(void))linearLookup;
+@end
+
+/*!
+ * @brief The same generator as AIContactListTrace's, so a seed gives the same chats everywhere
+ */
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+@implementation AIChatRegistryBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:100], KEY_CHAT_BENCHMARK_CHATS,
+			[NSNumber numberWithUnsignedInteger:5000], KEY_CHAT_BENCHMARK_PARTICIPANTS,
+			[NSNumber numberWithUnsignedInteger:200], KEY_CHAT_BENCHMARK_ONE_TO_ONE,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AIChatRegistryBenchmark *benchmark = [[[self alloc] initWithAccount:[AIBenchmarkAccount addTemporaryAccountWithUID:BENCHMARK_ACCOUNT_UID]] autorelease];
+
+	benchmark.groupChatCount = [defaults integerForKey:KEY_CHAT_BENCHMARK_CHATS];
+	benchmark.participantsPerChat = [defaults integerForKey:KEY_CHAT_BENCHMARK_PARTICIPANTS];
+	benchmark.oneToOneChatCount = [defaults integerForKey:KEY_CHAT_BENCHMARK_ONE_TO_ONE];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (void)deleteAccounts
+{
+	[account deleteTemporaryAccount];
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount
+{
+	if ((self = [super init])) {
+		account = [inAccount retain];
+		groupChatCount = 100;
+		participantsPerChat = 5000;
+		oneToOneChatCount = 200;
+		seed = 1;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[account release];
+	[lookupCosts release];
+	[mismatches release];
+
+	[super dealloc];
+}
+
+@synthesize groupChatCount, participantsPerChat, oneToOneChatCount, seed;
+
+/*!
+ * @brief Open the chats, check every lookup both ways, close the chats, and report
+ */
+- (NSDictionary *)run
+{
+	AIChatController	*chatController = (AIChatController *)adium.chatController;
+	NSMutableArray		*chats = [NSMutableArray array];
+	NSMutableArray		*lookupContacts = [NSMutableArray array];
+	NSMutableArray		*partners = [NSMutableArray array];
+	uint32_t			state = seed;
+	NSUInteger			i, j;
+
+	[lookupCosts release]; lookupCosts = [[NSMutableDictionary alloc] init];
+	[mismatches release]; mismatches = [[NSMutableArray alloc] init];
+	checkCount = 0;
+
+	uint64_t openStart = mach_absolute_time();
+
+	//Channels draw their members from a pool twice their size, so any two channels share about half their members
+	NSUInteger		poolSize = participantsPerChat * 2;
+	NSMutableArray	*pool = [NSMutableArray arrayWithCapacity:poolSize];
+	for (i = 0; i < poolSize; i++) {
+		[pool addObject:[account contactWithUID:[NSString stringWithFormat:@"participant%lu", (unsigned long)i]]];
+	}
+
+	for (i = 0; i < groupChatCount; i++) {
+		AIChat *chat = [chatController chatWithName:[NSString stringWithFormat:@"#channel%lu", (unsigned long)i]
+										 identifier:nil
+										  onAccount:account
+								   chatCreationInfo:nil];
+		if (!chat) continue;
+		chat.isOpen = YES;
+
+		NSUInteger		offset = (poolSize ? nextRandom(&state) % poolSize : 0);
+		NSMutableArray	*participants = [NSMutableArray arrayWithCapacity:participantsPerChat];
+		for (j = 0; j < participantsPerChat; j++) {
+			[participants addObject:[pool objectAtIndex:(offset + j) % poolSize]];
+		}
+
+		[chat addParticipatingListObjects:participants notify:NO];
+		[chats addObject:chat];
+	}
+
+	for (i = 0; i < oneToOneChatCount; i++) {
+		AIListContact	*listContact = [account contactWithUID:[NSString stringWithFormat:@"buddy%lu", (unsigned long)i]];
+		AIChat			*chat = [chatController chatWithContact:listContact];
+		if (!chat) continue;
+		chat.isOpen = YES;
+
+		[chats addObject:chat];
+		[lookupContacts addObject:listContact];
+
+		if (i % METACONTACT_INTERVAL == 0) {
+			AIListContact	*partner = [account contactWithUID:[NSString stringWithFormat:@"partner%lu", (unsigned long)i]];
+			AIMetaContact	*metaContact = [adium.contactController groupContacts:[NSArray arrayWithObjects:listContact, partner, nil]];
+
+			[partners addObject:partner];
+			[lookupContacts addObject:partner];
+			if (metaContact) [lookupContacts addObject:metaContact];
+		}
+	}
+
+	double openTime = secondsFromMachTime(mach_absolute_time() - openStart);
+
+	//Some members leave their channels again
+	for (AIChat *chat in chats) {
+		if (!chat.isGroupChat) continue;
+
+		for (j = 0; j < chat.countOfContainedObjects; j += PARTICIPANT_CHURN_INTERVAL) {
+			[chat removeObject:[chat.containedObjects objectAtIndex:j]];
+		}
+	}
+
+	//Every other partner takes over the chat with its metacontact, which reindexes the chat under the partner
+	for (i = 0; i < partners.count; i += 2) {
+		[chatController chatWithContact:[partners objectAtIndex:i]];
+	}
+
+	//A third of the chats get unviewed content, and some group chats mentions as well; then a few are viewed
+	for (AIChat *chat in chats) {
+		if (nextRandom(&state) % 3) continue;
+
+		NSUInteger messages = 1 + nextRandom(&state) % 5;
+		for (j = 0; j < messages; j++) {
+			[chat incrementUnviewedContentCount];
+			if (chat.isGroupChat && nextRandom(&state) % 2) [chat incrementUnviewedMentionCount];
+		}
+	}
+	for (AIChat *chat in chats) {
+		if (nextRandom(&state) % 5 == 0) [chat clearUnviewedContentCount];
+	}
+
+	//Look up a sample of channel members, plus everyone with a one-to-one chat
+	for (i = 0; i < PARTICIPANT_LOOKUP_SAMPLE && poolSize; i++) {
+		[lookupContacts addObject:[pool objectAtIndex:nextRandom(&state) % poolSize]];
+	}
+
+	for (AIListContact *listContact in lookupContacts) {
+		[self check:@"existingChatWithContact:" of:listContact
+			indexed:^{ return (id)[chatController existingChatWithContact:listContact]; }
+			 linear:^{ return (id)[chatController linearExistingChatWithContact:listContact]; }];
+		[self check:@"allChatsWithContact:" of:listContact
+			indexed:^{ return (id)[chatController allChatsWithContact:listContact]; }
+			 linear:^{ return (id)[chatController linearAllChatsWithContact:listContact]; }];
+		[self check:@"allGroupChatsContainingContact:" of:listContact
+			indexed:^{ return (id)[chatController allGroupChatsContainingContact:listContact]; }
+			 linear:^{ return (id)[chatController linearAllGroupChatsContainingContact:listContact]; }];
+		[self check:@"contactIsInGroupChat:" of:listContact
+			indexed:^{ return (id)[NSNumber numberWithBool:[chatController contactIsInGroupChat:listContact]]; }
+			 linear:^{ return (id)[NSNumber numberWithBool:[chatController linearContactIsInGroupChat:listContact]]; }];
+	}
+
+	//Unviewed counts, both with and without counting only mentions in group chats
+	id mentionCountPreference = [[adium.preferenceController preferenceForKey:KEY_STATUS_MENTION_COUNT
+																		group:PREF_GROUP_STATUS_PREFERENCES] retain];
+	for (NSNumber *onlyMentions in [NSArray arrayWithObjects:[NSNumber numberWithBool:NO], [NSNumber numberWithBool:YES], nil]) {
+		[adium.preferenceController setPreference:onlyMentions forKey:KEY_STATUS_MENTION_COUNT group:PREF_GROUP_STATUS_PREFERENCES];
+
+		for (i = 0; i < UNVIEWED_COUNT_ROUNDS; i++) {
+			[self check:@"unviewedContentCount" of:onlyMentions
+				indexed:^{ return (id)[NSNumber numberWithUnsignedInteger:chatController.unviewedContentCount]; }
+				 linear:^{ return (id)[NSNumber numberWithUnsignedInteger:[chatController linearUnviewedContentCount]]; }];
+			[self check:@"unviewedConversationCount" of:onlyMentions
+				indexed:^{ return (id)[NSNumber numberWithUnsignedInteger:chatController.unviewedConversationCount]; }
+				 linear:^{ return (id)[NSNumber numberWithUnsignedInteger:[chatController linearUnviewedConversationCount]]; }];
+		}
+	}
+	[adium.preferenceController setPreference:mentionCountPreference forKey:KEY_STATUS_MENTION_COUNT group:PREF_GROUP_STATUS_PREFERENCES];
+	[mentionCountPreference release];
+
+	for (AIChat *chat in chats) {
+		[chatController closeChat:chat];
+	}
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:groupChatCount], KEY_CHAT_REPORT_GROUP_CHATS,
+			[NSNumber numberWithUnsignedInteger:participantsPerChat], KEY_CHAT_REPORT_PARTICIPANTS,
+			[NSNumber numberWithUnsignedInteger:oneToOneChatCount], KEY_CHAT_REPORT_ONE_TO_ONE_CHATS,
+			[NSNumber numberWithDouble:openTime], KEY_CHAT_REPORT_OPEN_TIME,
+			[NSNumber numberWithUnsignedInteger:checkCount], KEY_CHAT_REPORT_CHECKS,
+			[[mismatches copy] autorelease], KEY_CHAT_REPORT_MISMATCHES,
+			[[lookupCosts copy] autorelease], KEY_CHAT_REPORT_LOOKUPS,
+			nil];
+}
+
+/*!
+ * @brief Make a lookup with the registry and by scanning, time both, and note it if they disagree
+ */
+- (void)check:(NSString *)lookupName of:(id)subject indexed:(id (^)(void))indexedLookup linear:(id (^)(void))linearLookup
+{
+	NSArray	*variants = [NSArray arrayWithObjects:@"indexed", @"linear", nil];
+	id		results[2];
+
+	for (NSUInteger variant = 0; variant < 2; variant++) {
+		NSString			*costName = [NSString stringWithFormat:@"%@ (%@)", lookupName, [variants objectAtIndex:variant]];
+		uint64_t			start = mach_absolute_time();
+
+		results[variant] = (variant ? linearLookup() : indexedLookup());
+
+		uint64_t			elapsed = mach_absolute_time() - start;
+		NSMutableDictionary	*cost = [lookupCosts objectForKey:costName];
+		if (!cost) {
+			cost = [NSMutableDictionary dictionary];
+			[lookupCosts setObject:cost forKey:costName];
+		}
+
+		[cost setObject:[NSNumber numberWithUnsignedInteger:[[cost objectForKey:@"Count"] unsignedIntegerValue] + 1] forKey:@"Count"];
+		[cost setObject:[NSNumber numberWithDouble:[[cost objectForKey:@"Seconds"] doubleValue] + secondsFromMachTime(elapsed)] forKey:@"Seconds"];
+	}
+
+	checkCount++;
+	if (results[0] != results[1] && ![results[0] isEqual:results[1]]) {
+		[mismatches addObject:[NSString stringWithFormat:@"%@ %@: indexed %@, linear %@", lookupName, subject, results[0], results[1]]];
+	}
+}
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSArray			*reportMismatches = [report objectForKey:KEY_CHAT_REPORT_MISMATCHES];
+	NSDictionary	*costs = [report objectForKey:KEY_CHAT_REPORT_LOOKUPS];
+
+	[description appendFormat:@"Chats: %@ channels of %@ participants, %@ one-to-one\n",
+	 [report objectForKey:KEY_CHAT_REPORT_GROUP_CHATS], [report objectForKey:KEY_CHAT_REPORT_PARTICIPANTS],
+	 [report objectForKey:KEY_CHAT_REPORT_ONE_TO_ONE_CHATS]];
+	[description appendFormat:@"Open time: %.3f s\n", [[report objectForKey:KEY_CHAT_REPORT_OPEN_TIME] doubleValue]];
+	[description appendFormat:@"Checks: %@, mismatches: %lu\n", [report objectForKey:KEY_CHAT_REPORT_CHECKS],
+	 (unsigned long)reportMismatches.count];
+
+	for (NSUInteger i = 0; i < reportMismatches.count && i < MAX_REPORTED_MISMATCHES; i++) {
+		[description appendFormat:@"  %@\n", [reportMismatches objectAtIndex:i]];
+	}
+
+	[description appendString:@"\nLookups:\n"];
+	for (NSString *name in [[costs allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		NSDictionary	*cost = [costs objectForKey:name];
+		NSUInteger		count = [[cost objectForKey:@"Count"] unsignedIntegerValue];
+		double			seconds = [[cost objectForKey:@"Seconds"] doubleValue];
+
+		[description appendFormat:@"  %-50s %8lu  %9.3f s  %10.2f us each\n",
+		 [name UTF8String], (unsigned long)count, seconds, (count ? seconds * USEC_PER_SEC / count : 0.0)];
+	}
+
+	return description;
+}
+
+@end
+
+@implementation AIChatController (AILinearChatLookups)
+
+- (AIChat *)linearExistingChatWithContact:(AIListContact *)inContact
+{
+	AIChat			*chat = nil;
+
+	if ([inContact isKindOfClass:[AIMetaContact class]]) {
+		for (chat in self.openChats) {
+			if (!chat.isGroupChat &&
+				[[(AIMetaContact *)inContact containedObjects] containsObjectIdenticalTo:chat.listObject]) break;
+		}
+
+	} else {
+		for (chat in self.openChats) {
+			if (!chat.isGroupChat &&
+				chat.listObject == inContact) break;
+		}
+	}
+	
+	return chat;
+}
+
+- (NSSet *)linearAllChatsWithContact:(AIListContact *)inContact
+{
+    NSMutableSet	*foundChats = [NSMutableSet set];
+	
+	if ([inContact isKindOfClass:[AIMetaContact class]]) {
+		for (AIListContact *listContact in ((AIMetaContact *)inContact).uniqueContainedObjects) {
+			[foundChats unionSet:[self linearAllChatsWithContact:listContact]];
+		}
+		
+	} else {
+		for (AIChat *chat in self.openChats) {
+			if (!chat.isGroupChat &&
+				[chat.listObject.internalObjectID isEqualToString:inContact.internalObjectID] &&
+				chat.isOpen) {
+				[foundChats addObject:chat];
+			}
+		}
+	}
+
+    return foundChats;
+}
+
+- (NSSet *)linearAllGroupChatsContainingContact:(AIListContact *)inContact
+{
+	NSMutableSet *groupChats = [NSMutableSet set];
+	
+	if ([inContact isKindOfClass:[AIMetaContact class]]) {
+		for (AIChat *chat in self.openChats) {
+			if (!chat.isGroupChat)
+				continue;
+			
+			for (AIListContact *contact in (AIMetaContact *)inContact) {
+				if([chat containsObject:contact]) {
+					[groupChats addObject:chat];
+					break;
+				}
+			}
+		}
+		
+	} else {
+		for (AIChat *chat in self.openChats) {
+			if (chat.isGroupChat && [chat containsObject:inContact] && chat.account.shouldBeOnline) {
+				[groupChats addObject:chat];
+			}
+		}
+	}
+	
+	return groupChats;
+}
+
+- (BOOL)linearContactIsInGroupChat:(AIListContact *)listContact
+{
+	for (AIChat *chat in self.openChats) {
+		if (chat.isGroupChat &&
+			[chat containsObject:listContact]) {
+			return YES;
+		}
+	}
+	
+	return NO;
+}
+
+- (NSUInteger)linearUnviewedContentCount
+{
+	NSUInteger	count = 0;
+
+	for (AIChat *chat in self.openChats) {
+		if (chat.isGroupChat &&
+			[[adium.preferenceController preferenceForKey:KEY_STATUS_MENTION_COUNT
+													group:PREF_GROUP_STATUS_PREFERENCES] boolValue]) {
+			count += [chat unviewedMentionCount];
+		} else {
+			count += [chat unviewedContentCount];
+		}
+	}
+	return count;
+}
+
+- (NSUInteger)linearUnviewedConversationCount
+{
+	NSUInteger count = 0;
+
+	for (AIChat *chat in self.openChats) {
+		if (chat.isGroupChat &&
+			[[adium.preferenceController preferenceForKey:KEY_STATUS_MENTION_COUNT
+													group:PREF_GROUP_STATUS_PREFERENCES] boolValue]) {
+			if (chat.unviewedMentionCount) {
+				count++;
+			}
+		} else if (chat.unviewedContentCount) {
+			count++;
+		}
+	}
+	return count;
+}
+
+@end
@@ -0,0 +1,74 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+
+@class AIBenchmarkAccount;
+
+//Report keys
+#define KEY_ALERTS_REPORT_CONTACTS			@"Contacts"
+#define KEY_ALERTS_REPORT_GROUPS			@"Groups"
+#define KEY_ALERTS_REPORT_ROUNDS			@"Rounds"
+#define KEY_ALERTS_REPORT_EVENTS			@"Events"
+#define KEY_ALERTS_REPORT_ACTIONS_FIRED		@"Actions Fired"
+#define KEY_ALERTS_REPORT_DUPLICATES		@"Duplicate Actions Dropped"
+#define KEY_ALERTS_REPORT_MISMATCHES		@"Mismatches"
+#define KEY_ALERTS_REPORT_LOOKUPS			@"Lookups"
+
+/*!
+ * @class AIContactAlertsBenchmark
+ * @brief Replays status changes against contacts with contact alerts and checks the compiled alerts they fire
+ *
+ * Alerts which record when they are performed are set up globally, on groups and on contacts, with Do Nothing alerts
+ * and contacts in several groups and in metacontacts mixed in. Contacts then sign on and off and go away and come back
+ * for a number of rounds, with alerts and metacontacts changing between rounds. For every event, the alerts
+ * ESContactAlertsController compiled are compared with those resolved from preferences, both lookups are timed, and
+ * the actions which actually fired are compared with those the resolved alerts call for. The alerts and metacontacts
+ * are removed again before -run returns.
+ *
+ * Run with -AIContactAlertsBenchmark YES. Settings:
+ *	-AIContactListBenchmarkContacts <n>	Contacts recording alerts (2000)
+ *	-AIContactListBenchmarkGroups <n>	Groups they are in (25)
+ *	-AIContactAlertsBenchmarkRounds <n>	Rounds of status changes (20)
+ *	-AIContactListBenchmarkSeed <n>		Seed for the random choices (1)
+ */
+@interface AIContactAlertsBenchmark : NSObject <AIBenchmark> {
+	AIBenchmarkAccount	*account;
+
+	NSUInteger			contactCount;
+	NSUInteger			groupCount;
+	NSUInteger			rounds;
+	uint32_t			seed;
+
+	NSMutableArray		*firedActions;
+	NSMutableDictionary	*lookupCosts;
+	NSMutableArray		*mismatches;
+	NSUInteger			eventCount;
+	NSUInteger			actionCount;
+	NSUInteger			duplicateCount;
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount;
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger contactCount;
+@property (readwrite, nonatomic) NSUInteger groupCount;
+@property (readwrite, nonatomic) NSUInteger rounds;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
@@ -0,0 +1,529 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIContactAlertsBenchmark.h"
+#import "AIBenchmarkAccount.h"
+#import "ESContactAlertsController.h"
+#import "AIDoNothingContactAlertPlugin.h"
+#import <Adium/AIContactAlertsControllerProtocol.h>
+#import <Adium/AIContactControllerProtocol.h>
+#import <Adium/AIListContact.h>
+#import <Adium/AIListGroup.h>
+#import <Adium/AIMetaContact.h>
+#import <mach/mach_time.h>
+
+//Settings
+#define KEY_ALERTS_BENCHMARK_ROUNDS			@"AIContactAlertsBenchmarkRounds"
+
+#define BENCHMARK_ACTION_ONCE			@"AIContactAlertsBenchmarkOnce"
+#define BENCHMARK_ACTION_REPEAT			@"AIContactAlertsBenchmarkRepeat"
+//Every alert we add has this key in its details, saying where it was set
+#define KEY_BENCHMARK_LEVEL				@"AIContactAlertsBenchmarkLevel"
+
+//Every so many groups has alerts of its own, and every so many of those a Do Nothing alert as well
+#define GROUP_ALERT_INTERVAL			3
+#define GROUP_DO_NOTHING_INTERVAL		5
+//Every so many contacts has alerts of its own, a Do Nothing alert, a second group, or a metacontact with the next one
+#define CONTACT_ALERT_INTERVAL			7
+#define CONTACT_DO_NOTHING_INTERVAL		11
+#define SECOND_GROUP_INTERVAL			13
+#define METACONTACT_INTERVAL			17
+//How many mismatches are described in the report
+#define MAX_REPORTED_MISMATCHES			20
+
+/*!
+ * @brief Append the alerts for an event on a list object and everything it inherits from, resolved from preferences
+ *
+ * This is how the contact alerts controller resolved alerts before it compiled them, kept to check
+ * -[ESContactAlertsController resolvedAlertsForEventID:listObject:] against: the object's own alerts, then those of
+ * each of its containing objects in turn, or the global alerts if it has none, stopping at a Do Nothing alert. An
+ * alert inherited more than once is listed each time.
+ *
+ * @param listObject The object, or nil for global alerts only
+ * @param alerts The alerts so far; created if nil
+ */
+static NSMutableArray *appendLinearAlerts(AIListObject *listObject, NSString *eventID, NSMutableArray *alerts)
+{
+	NSArray *ownAlerts = [[adium.preferenceController preferenceForKey:KEY_CONTACT_ALERTS
+																 group:PREF_GROUP_CONTACT_ALERTS
+											 objectIgnoringInheritance:listObject] objectForKey:eventID];
+
+	if ([ownAlerts count]) {
+		if (!alerts) alerts = [NSMutableArray array];
+		[alerts addObjectsFromArray:ownAlerts];
+
+		for (NSDictionary *alert in ownAlerts) {
+			if ([[alert objectForKey:KEY_ACTION_ID] isEqualToString:DO_NOTHING_ALERT_IDENTIFIER])
+				return alerts;
+		}
+	}
+
+	if (listObject) {
+		if (listObject.containingObjects.count > 0) {
+			for (AIListObject<AIContainingObject> *container in listObject.containingObjects) {
+				alerts = appendLinearAlerts(container, eventID, alerts);
+			}
+		} else {
+			alerts = appendLinearAlerts(nil, eventID, alerts);
+		}
+	}
+
+	return alerts;
+}
+
+/*!
+ * @class AIBenchmarkAlertAction
+ * @brief An action which does nothing but note that it was performed
+ */
+@interface AIBenchmarkAlertAction : NSObject <AIActionHandler> {
+	NSMutableArray	*performedActions;
+}
+@property (readwrite, retain, nonatomic) NSMutableArray *performedActions;
+@end
+
+@implementation AIBenchmarkAlertAction
+
+@synthesize performedActions;
+
+- (void)dealloc
+{
+	[performedActions release];
+
+	[super dealloc];
+}
+
+- (NSString *)shortDescriptionForActionID:(NSString *)actionID
+{
+	return actionID;
+}
+
+- (NSString *)longDescriptionForActionID:(NSString *)actionID withDetails:(NSDictionary *)details
+{
+	return [NSString stringWithFormat:@"%@ (%@)", actionID, [details objectForKey:KEY_BENCHMARK_LEVEL]];
+}
+
+- (NSImage *)imageForActionID:(NSString *)actionID
+{
+	return nil;
+}
+
+- (AIActionDetailsPane *)detailsPaneForActionID:(NSString *)actionID
+{
+	return nil;
+}
+
+- (BOOL)performActionID:(NSString *)actionID forListObject:(AIListObject *)listObject withDetails:(NSDictionary *)details triggeringEventID:(NSString *)eventID userInfo:(id)userInfo
+{
+	[performedActions addObject:[NSString stringWithFormat:@"%@ (%@)", actionID, [details objectForKey:KEY_BENCHMARK_LEVEL]]];
+
+	return YES;
+}
+
+- (BOOL)allowMultipleActionsWithID:(NSString *)actionID
+{
+	return [actionID isEqualToString:BENCHMARK_ACTION_REPEAT];
+}
+
+@end
+
+#pragma mark -
+
+@interface AIContactAlertsBenchmark ()
+- (NSArray *)eventIDs;
+- (NSDictionary *)alertForEventID:(NSString *)eventID actionID:(NSString *)actionID level:(NSString *)level;
+- (void)addAlertsForLevel:(NSString *)level toListObject:(AIListObject *)listObject doNothing:(BOOL)doNothing;
+- (void)removeBenchmarkAlertsFromListObject:(AIListObject *)listObject;
+- (NSArray *)actionsPerformedForAlerts:(NSArray *)alerts;
+- (void)addCost:(NSString *)costName seconds:(double)seconds;
+- (void)eventOccurred:(NSNotification *)notification;
+@end
+
+/*!
+ * @brief The same generator as AIContactListTrace's, so a seed gives the same replay everywhere
+ */
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+@implementation AIContactAlertsBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:20], KEY_ALERTS_BENCHMARK_ROUNDS,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AIContactAlertsBenchmark *benchmark = [[[self alloc] initWithAccount:[AIBenchmarkAccount addTemporaryAccountWithUID:BENCHMARK_ACCOUNT_UID]] autorelease];
+
+	benchmark.contactCount = [defaults integerForKey:KEY_BENCHMARK_CONTACTS];
+	benchmark.groupCount = [defaults integerForKey:KEY_BENCHMARK_GROUPS];
+	benchmark.rounds = [defaults integerForKey:KEY_ALERTS_BENCHMARK_ROUNDS];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (void)deleteAccounts
+{
+	[account deleteTemporaryAccount];
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount
+{
+	if ((self = [super init])) {
+		account = [inAccount retain];
+		contactCount = 2000;
+		groupCount = 25;
+		rounds = 20;
+		seed = 1;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[account release];
+	[firedActions release];
+	[lookupCosts release];
+	[mismatches release];
+
+	[super dealloc];
+}
+
+@synthesize contactCount, groupCount, rounds, seed;
+
+- (NSArray *)eventIDs
+{
+	return [NSArray arrayWithObjects:CONTACT_STATUS_ONLINE_YES, CONTACT_STATUS_ONLINE_NO,
+			CONTACT_STATUS_AWAY_YES, CONTACT_STATUS_AWAY_NO, nil];
+}
+
+/*!
+ * @brief Set up the alerts, replay the status changes, check every event, clean up, and report
+ */
+- (NSDictionary *)run
+{
+	static AIBenchmarkAlertAction	*actionHandler = nil;
+	NSMutableArray					*contacts = [NSMutableArray array];
+	NSMutableArray					*groups = [NSMutableArray array];
+	NSMutableArray					*metaContacts = [NSMutableArray array];
+	NSMutableSet					*online = [NSMutableSet set];
+	NSMutableSet					*away = [NSMutableSet set];
+	uint32_t						state = seed;
+	NSUInteger						i, round;
+
+	[firedActions release]; firedActions = [[NSMutableArray alloc] init];
+	[lookupCosts release]; lookupCosts = [[NSMutableDictionary alloc] init];
+	[mismatches release]; mismatches = [[NSMutableArray alloc] init];
+	eventCount = actionCount = duplicateCount = 0;
+
+	//Action handlers can't be unregistered, so there is only ever one
+	if (!actionHandler) {
+		actionHandler = [[AIBenchmarkAlertAction alloc] init];
+		[adium.contactAlertsController registerActionID:BENCHMARK_ACTION_ONCE withHandler:actionHandler];
+		[adium.contactAlertsController registerActionID:BENCHMARK_ACTION_REPEAT withHandler:actionHandler];
+	}
+	actionHandler.performedActions = firedActions;
+
+	for (NSString *eventID in self.eventIDs) {
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(eventOccurred:)
+													 name:eventID
+												   object:nil];
+	}
+
+	[self addAlertsForLevel:@"Global" toListObject:nil doNothing:NO];
+
+	for (i = 0; i < groupCount; i++) {
+		AIListGroup *group = [adium.contactController groupWithUID:[NSString stringWithFormat:@"Alert Group %lu", (unsigned long)i]];
+		[groups addObject:group];
+
+		if (i % GROUP_ALERT_INTERVAL == 0) {
+			[self addAlertsForLevel:group.UID toListObject:group doNothing:(i % GROUP_DO_NOTHING_INTERVAL == 0)];
+		}
+	}
+
+	//Everyone signs on silently, as they would when we connect
+	[account connect];
+	for (i = 0; i < contactCount; i++) {
+		NSString	*UID = [NSString stringWithFormat:@"alertcontact%lu", (unsigned long)i];
+		AIListGroup	*group = [groups objectAtIndex:i % groupCount];
+
+		[account signOnContactWithUID:UID group:group.UID away:NO statusMessage:nil];
+		if (i % SECOND_GROUP_INTERVAL == 0) {
+			[account signOnContactWithUID:UID group:[[groups objectAtIndex:(i + 1) % groupCount] UID] away:NO statusMessage:nil];
+		}
+
+		[contacts addObject:[account contactWithUID:UID]];
+		[online addObject:UID];
+	}
+	[account endSignOnDelay];
+
+	for (i = 0; i < contactCount; i++) {
+		AIListContact *listContact = [contacts objectAtIndex:i];
+
+		if (i % CONTACT_ALERT_INTERVAL == 0 || i % CONTACT_DO_NOTHING_INTERVAL == 0) {
+			[self addAlertsForLevel:listContact.UID toListObject:listContact doNothing:(i % CONTACT_DO_NOTHING_INTERVAL == 0)];
+		}
+	}
+
+	for (i = 0; i + 1 < contactCount; i += METACONTACT_INTERVAL) {
+		AIMetaContact *metaContact = [adium.contactController groupContacts:[NSArray arrayWithObjects:
+																			  [contacts objectAtIndex:i],
+																			  [contacts objectAtIndex:i + 1], nil]];
+		if (metaContact) [metaContacts addObject:metaContact];
+	}
+
+	for (round = 0; round < rounds; round++) {
+		for (i = 0; i < contactCount; i++) {
+			NSString	*UID = [[contacts objectAtIndex:i] UID];
+			uint32_t	change = nextRandom(&state) % 4;
+
+			if (![online containsObject:UID]) {
+				if (change == 0) {
+					[account signOnContactWithUID:UID group:[[groups objectAtIndex:i % groupCount] UID] away:NO statusMessage:nil];
+					[online addObject:UID];
+					[away removeObject:UID];
+				}
+
+			} else if (change == 0) {
+				[account signOffContactWithUID:UID];
+				[online removeObject:UID];
+
+			} else if (change == 1) {
+				BOOL nowAway = ![away containsObject:UID];
+
+				[account setContactWithUID:UID away:nowAway statusMessage:nil];
+				if (nowAway) [away addObject:UID]; else [away removeObject:UID];
+			}
+		}
+
+		//Let anything the contact list put off run before the next round
+		[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate date]];
+
+		//Between rounds a group gets a new alert, which must reach its contacts, and a metacontact comes apart or back together
+		AIListGroup *group = [groups objectAtIndex:round % groupCount];
+		[adium.contactAlertsController addAlert:[self alertForEventID:CONTACT_STATUS_ONLINE_YES
+															 actionID:BENCHMARK_ACTION_ONCE
+																level:[NSString stringWithFormat:@"Round %lu", (unsigned long)round]]
+								   toListObject:group
+							   setAsNewDefaults:NO];
+
+		if (metaContacts.count) {
+			NSUInteger		pair = round % metaContacts.count;
+			AIMetaContact	*metaContact = [metaContacts objectAtIndex:pair];
+
+			if (metaContact.countOfContainedObjects) {
+				[adium.contactController explodeMetaContact:metaContact];
+			} else {
+				metaContact = [adium.contactController groupContacts:[NSArray arrayWithObjects:
+																	  [contacts objectAtIndex:pair * METACONTACT_INTERVAL],
+																	  [contacts objectAtIndex:pair * METACONTACT_INTERVAL + 1], nil]];
+				if (metaContact) [metaContacts replaceObjectAtIndex:pair withObject:metaContact];
+			}
+		}
+	}
+
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+	actionHandler.performedActions = nil;
+
+	[self removeBenchmarkAlertsFromListObject:nil];
+	for (AIListObject *listObject in [[groups arrayByAddingObjectsFromArray:contacts] arrayByAddingObjectsFromArray:metaContacts]) {
+		[self removeBenchmarkAlertsFromListObject:listObject];
+	}
+	for (AIMetaContact *metaContact in metaContacts) {
+		if (metaContact.countOfContainedObjects) [adium.contactController explodeMetaContact:metaContact];
+	}
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:contactCount], KEY_ALERTS_REPORT_CONTACTS,
+			[NSNumber numberWithUnsignedInteger:groupCount], KEY_ALERTS_REPORT_GROUPS,
+			[NSNumber numberWithUnsignedInteger:rounds], KEY_ALERTS_REPORT_ROUNDS,
+			[NSNumber numberWithUnsignedInteger:eventCount], KEY_ALERTS_REPORT_EVENTS,
+			[NSNumber numberWithUnsignedInteger:actionCount], KEY_ALERTS_REPORT_ACTIONS_FIRED,
+			[NSNumber numberWithUnsignedInteger:duplicateCount], KEY_ALERTS_REPORT_DUPLICATES,
+			[[mismatches copy] autorelease], KEY_ALERTS_REPORT_MISMATCHES,
+			[[lookupCosts copy] autorelease], KEY_ALERTS_REPORT_LOOKUPS,
+			nil];
+}
+
+- (NSDictionary *)alertForEventID:(NSString *)eventID actionID:(NSString *)actionID level:(NSString *)level
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			eventID, KEY_EVENT_ID,
+			actionID, KEY_ACTION_ID,
+			[NSDictionary dictionaryWithObject:level forKey:KEY_BENCHMARK_LEVEL], KEY_ACTION_DETAILS,
+			nil];
+}
+
+/*!
+ * @brief Give an object, or global if nil, both kinds of recording alert for every event
+ *
+ * The repeating action's alerts are the same at every level, so objects which inherit them more than once get
+ * duplicates, which the compiled alerts drop.
+ */
+- (void)addAlertsForLevel:(NSString *)level toListObject:(AIListObject *)listObject doNothing:(BOOL)doNothing
+{
+	for (NSString *eventID in self.eventIDs) {
+		[adium.contactAlertsController addAlert:[self alertForEventID:eventID actionID:BENCHMARK_ACTION_ONCE level:level]
+								   toListObject:listObject
+							   setAsNewDefaults:NO];
+		[adium.contactAlertsController addAlert:[self alertForEventID:eventID actionID:BENCHMARK_ACTION_REPEAT level:@"Shared"]
+								   toListObject:listObject
+							   setAsNewDefaults:NO];
+		if (doNothing) {
+			[adium.contactAlertsController addAlert:[self alertForEventID:eventID actionID:DO_NOTHING_ALERT_IDENTIFIER level:level]
+									   toListObject:listObject
+								   setAsNewDefaults:NO];
+		}
+	}
+}
+
+- (void)removeBenchmarkAlertsFromListObject:(AIListObject *)listObject
+{
+	for (NSDictionary *alert in [adium.contactAlertsController alertsForListObject:listObject]) {
+		if ([[alert objectForKey:KEY_ACTION_DETAILS] objectForKey:KEY_BENCHMARK_LEVEL])
+			[adium.contactAlertsController removeAlert:alert fromListObject:listObject];
+	}
+}
+
+/*!
+ * @brief The recording actions which generating an event for these alerts should perform, in order
+ *
+ * This follows -[ESContactAlertsController generateEvent:forListObject:userInfo:previouslyPerformedActionIDs:].
+ */
+- (NSArray *)actionsPerformedForAlerts:(NSArray *)alerts
+{
+	NSMutableArray	*performed = [NSMutableArray array];
+	BOOL			performedOnce = NO;
+
+	for (NSDictionary *alert in alerts) {
+		NSString *actionID = [alert objectForKey:KEY_ACTION_ID];
+
+		if ([actionID isEqualToString:BENCHMARK_ACTION_REPEAT] ||
+			([actionID isEqualToString:BENCHMARK_ACTION_ONCE] && !performedOnce)) {
+			[performed addObject:[NSString stringWithFormat:@"%@ (%@)", actionID,
+								  [[alert objectForKey:KEY_ACTION_DETAILS] objectForKey:KEY_BENCHMARK_LEVEL]]];
+			if ([actionID isEqualToString:BENCHMARK_ACTION_ONCE]) performedOnce = YES;
+		}
+	}
+
+	return performed;
+}
+
+- (void)addCost:(NSString *)costName seconds:(double)seconds
+{
+	NSMutableDictionary	*cost = [lookupCosts objectForKey:costName];
+	if (!cost) {
+		cost = [NSMutableDictionary dictionary];
+		[lookupCosts setObject:cost forKey:costName];
+	}
+
+	[cost setObject:[NSNumber numberWithUnsignedInteger:[[cost objectForKey:@"Count"] unsignedIntegerValue] + 1] forKey:@"Count"];
+	[cost setObject:[NSNumber numberWithDouble:[[cost objectForKey:@"Seconds"] doubleValue] + seconds] forKey:@"Seconds"];
+}
+
+/*!
+ * @brief An event was generated: check the alerts for it both ways, and the actions it performed
+ *
+ * Posted by the contact alerts controller once the event's actions have been performed.
+ */
+- (void)eventOccurred:(NSNotification *)notification
+{
+	ESContactAlertsController	*alertsController = (ESContactAlertsController *)adium.contactAlertsController;
+	NSString					*eventID = [notification name];
+	AIListObject				*listObject = [notification object];
+	uint64_t					start;
+
+	start = mach_absolute_time();
+	NSArray *compiled = [alertsController resolvedAlertsForEventID:eventID listObject:listObject];
+	[self addCost:@"resolvedAlertsForEventID: (compiled)" seconds:secondsFromMachTime(mach_absolute_time() - start)];
+
+	start = mach_absolute_time();
+	NSArray *linear = appendLinearAlerts(listObject, eventID, nil);
+	[self addCost:@"resolvedAlertsForEventID: (linear)" seconds:secondsFromMachTime(mach_absolute_time() - start)];
+
+	NSMutableArray *unique = [NSMutableArray array];
+	for (NSDictionary *alert in linear) {
+		if (![unique containsObject:alert]) [unique addObject:alert];
+	}
+
+	eventCount++;
+	if (![compiled isEqualToArray:unique]) {
+		[mismatches addObject:[NSString stringWithFormat:@"%@ on %@: compiled %@, resolved %@",
+							   eventID, listObject.UID, compiled, unique]];
+	}
+
+	NSArray *expected = [self actionsPerformedForAlerts:unique];
+	if (![firedActions isEqualToArray:expected]) {
+		[mismatches addObject:[NSString stringWithFormat:@"%@ on %@: performed %@, expected %@",
+							   eventID, listObject.UID, firedActions, expected]];
+	}
+
+	actionCount += firedActions.count;
+	duplicateCount += [self actionsPerformedForAlerts:linear].count - expected.count;
+	[firedActions removeAllObjects];
+}
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSArray			*reportMismatches = [report objectForKey:KEY_ALERTS_REPORT_MISMATCHES];
+	NSDictionary	*costs = [report objectForKey:KEY_ALERTS_REPORT_LOOKUPS];
+
+	[description appendFormat:@"Contacts: %@ in %@ groups, %@ rounds\n",
+	 [report objectForKey:KEY_ALERTS_REPORT_CONTACTS], [report objectForKey:KEY_ALERTS_REPORT_GROUPS],
+	 [report objectForKey:KEY_ALERTS_REPORT_ROUNDS]];
+	[description appendFormat:@"Events: %@, actions performed: %@, duplicate actions dropped: %@\n",
+	 [report objectForKey:KEY_ALERTS_REPORT_EVENTS], [report objectForKey:KEY_ALERTS_REPORT_ACTIONS_FIRED],
+	 [report objectForKey:KEY_ALERTS_REPORT_DUPLICATES]];
+	[description appendFormat:@"Mismatches: %lu\n", (unsigned long)reportMismatches.count];
+
+	for (NSUInteger i = 0; i < reportMismatches.count && i < MAX_REPORTED_MISMATCHES; i++) {
+		[description appendFormat:@"  %@\n", [reportMismatches objectAtIndex:i]];
+	}
+
+	[description appendString:@"\nLookups:\n"];
+	for (NSString *name in [[costs allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		NSDictionary	*cost = [costs objectForKey:name];
+		NSUInteger		count = [[cost objectForKey:@"Count"] unsignedIntegerValue];
+		double			seconds = [[cost objectForKey:@"Seconds"] doubleValue];
+
+		[description appendFormat:@"  %-50s %8lu  %9.3f s  %10.2f us each\n",
+		 [name UTF8String], (unsigned long)count, seconds, (count ? seconds * USEC_PER_SEC / count : 0.0)];
+	}
+
+	return description;
+}
+
+@end
@@ -0,0 +1,44 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <Adium/AIPlugin.h>
+
+@class AIContactListTraceRecorder;
+
+/*!
+ * @class AIContactListBenchmarkPlugin
+ * @brief Replays contact list traces into a running Adium and reports what they cost
+ *
+ * Built by the "Contact list benchmark" target; `make benchmark` builds it and runs it against a scratch copy of
+ * Adium. Does nothing unless one of these defaults is set, usually on the command line:
+ *
+ *	-AIContactListBenchmarkTrace <path>		Replay the trace at path once Adium has finished launching, then quit.
+ *											"synthetic" generates a trace instead; see AIContactListBenchmarkContacts,
+ *											AIContactListBenchmarkGroups, AIContactListBenchmarkFlapRounds,
+ *											AIContactListBenchmarkMessages and AIContactListBenchmarkSeed.
+ *	-AIContactListBenchmarkReport <path>	Also write the report as a property list, for comparing runs.
+ *	-AIContactListBenchmarkSaveTrace <path>	Write out the trace that was replayed.
+ *	-AIContactListBenchmarkDeliverMessages YES	Receive Message events into chats rather than only filtering them.
+ *	-AIContactListBenchmarkRecord <path>	Record the real contact list until Adium quits.
+ *	-<Benchmark> YES						Instead of replaying a trace, run the benchmark class of that name, report,
+ *											then quit. The benchmarks are listed in AIContactListBenchmarkPlugin.m; see
+ *											AIBenchmark.h and each class for its settings.
+ */
+@interface AIContactListBenchmarkPlugin : AIPlugin {
+	AIContactListTraceRecorder	*recorder;
+}
+
+@end
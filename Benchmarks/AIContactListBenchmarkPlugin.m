@@ -0,0 +1,261 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIContactListBenchmarkPlugin.h"
+#import "AIBenchmark.h"
+#import "AIBenchmarkService.h"
+#import "AIBenchmarkAccount.h"
+#import "AIContactListTrace.h"
+#import "AIContactListTraceRecorder.h"
+#import "AIContactListReplayer.h"
+#import "AIChatRegistryBenchmark.h"
+#import "AIMessageTailCacheBenchmark.h"
+#import "AIContactAlertsBenchmark.h"
+#import "AIOwnerArrayBenchmark.h"
+#import "AIPropertyStoreBenchmark.h"
+#import "AIReconnectSchedulerBenchmark.h"
+#import "AITimestampCodecBenchmark.h"
+#import "AITimerWheelBenchmark.h"
+#import "AIMetaContactBenchmark.h"
+#import "AIAddressBookSyncBenchmark.h"
+#import "AIHostResolverBenchmark.h"
+#import "AIImageUploadBenchmark.h"
+#import "AIUserListDiffBenchmark.h"
+#import "AIBonjourPresenceBenchmark.h"
+#import "AISocketReadBenchmark.h"
+#import "AIStatusMenuBenchmark.h"
+#import "AIBuddyEventBenchmark.h"
+#import "AIIdleTimeBenchmark.h"
+
+#define KEY_BENCHMARK_TRACE				@"AIContactListBenchmarkTrace"
+#define KEY_BENCHMARK_SAVE_TRACE		@"AIContactListBenchmarkSaveTrace"
+#define KEY_BENCHMARK_DELIVER_MESSAGES	@"AIContactListBenchmarkDeliverMessages"
+#define KEY_BENCHMARK_RECORD			@"AIContactListBenchmarkRecord"
+#define KEY_BENCHMARK_FLAP_ROUNDS		@"AIContactListBenchmarkFlapRounds"
+#define KEY_BENCHMARK_MESSAGES			@"AIContactListBenchmarkMessages"
+
+#define SYNTHETIC_TRACE					@"synthetic"
+
+@interface AIContactListBenchmarkPlugin ()
++ (NSDictionary *)benchmarkClassesByName;
+- (void)adiumFinishedLaunching:(NSNotification *)notification;
+- (void)adiumWillTerminate:(NSNotification *)notification;
+- (AIContactListTrace *)traceFromDefaults;
+- (void)replayTrace;
+- (void)runBenchmark:(Class)benchmarkClass;
+- (void)reportResults:(NSDictionary *)report description:(NSString *)description;
+@end
+
+@implementation AIContactListBenchmarkPlugin
+
+/*!
+ * @brief Every benchmark the plugin can run, keyed by the default which switches it on
+ *
+ * Add new benchmarks here.
+ */
++ (NSDictionary *)benchmarkClassesByName
+{
+	static NSDictionary *benchmarkClassesByName = nil;
+
+	if (!benchmarkClassesByName) {
+		NSArray				*benchmarkClasses = [NSArray arrayWithObjects:
+												 [AIChatRegistryBenchmark class],
+												 [AIMessageTailCacheBenchmark class],
+												 [AIContactAlertsBenchmark class],
+												 [AIOwnerArrayBenchmark class],
+												 [AIPropertyStoreBenchmark class],
+												 [AIReconnectSchedulerBenchmark class],
+												 [AITimestampCodecBenchmark class],
+												 [AITimerWheelBenchmark class],
+												 [AIMetaContactBenchmark class],
+												 [AIAddressBookSyncBenchmark class],
+												 [AIHostResolverBenchmark class],
+												 [AIImageUploadBenchmark class],
+												 [AIUserListDiffBenchmark class],
+												 [AIBonjourPresenceBenchmark class],
+												 [AISocketReadBenchmark class],
+												 [AIStatusMenuBenchmark class],
+												 [AIBuddyEventBenchmark class],
+												 [AIIdleTimeBenchmark class],
+												 nil];
+		NSMutableDictionary	*classesByName = [NSMutableDictionary dictionaryWithCapacity:benchmarkClasses.count];
+
+		for (Class benchmarkClass in benchmarkClasses) {
+			[classesByName setObject:benchmarkClass forKey:NSStringFromClass(benchmarkClass)];
+		}
+
+		benchmarkClassesByName = [classesByName copy];
+	}
+
+	return benchmarkClassesByName;
+}
+
+- (void)installPlugin
+{
+	NSUserDefaults		*defaults = [NSUserDefaults standardUserDefaults];
+	NSDictionary		*benchmarkClassesByName = [[self class] benchmarkClassesByName];
+	NSMutableDictionary	*settings = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+									 [NSNumber numberWithUnsignedInteger:2000], KEY_BENCHMARK_CONTACTS,
+									 [NSNumber numberWithUnsignedInteger:25], KEY_BENCHMARK_GROUPS,
+									 [NSNumber numberWithUnsignedInteger:50], KEY_BENCHMARK_FLAP_ROUNDS,
+									 [NSNumber numberWithUnsignedInteger:200], KEY_BENCHMARK_MESSAGES,
+									 [NSNumber numberWithUnsignedInt:1], KEY_BENCHMARK_SEED,
+									 nil];
+	BOOL				runBenchmark = NO;
+
+	for (NSString *name in benchmarkClassesByName) {
+		[settings addEntriesFromDictionary:[[benchmarkClassesByName objectForKey:name] defaultSettings]];
+		if ([defaults boolForKey:name])
+			runBenchmark = YES;
+	}
+
+	[defaults registerDefaults:settings];
+
+	[AIBenchmarkService registerService];
+
+	if ([defaults stringForKey:KEY_BENCHMARK_RECORD]) {
+		recorder = [[AIContactListTraceRecorder alloc] initWithPath:[[defaults stringForKey:KEY_BENCHMARK_RECORD] stringByExpandingTildeInPath]];
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(adiumWillTerminate:)
+													 name:AIAppWillTerminateNotification
+												   object:nil];
+	}
+
+	if ([defaults stringForKey:KEY_BENCHMARK_TRACE] || runBenchmark) {
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(adiumFinishedLaunching:)
+													 name:AIApplicationDidFinishLoadingNotification
+												   object:nil];
+	}
+}
+
+- (void)uninstallPlugin
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (void)dealloc
+{
+	[recorder release];
+
+	[super dealloc];
+}
+
+- (AIContactListTrace *)traceFromDefaults
+{
+	NSUserDefaults	*defaults = [NSUserDefaults standardUserDefaults];
+	NSString		*tracePath = [defaults stringForKey:KEY_BENCHMARK_TRACE];
+
+	if ([tracePath isEqualToString:SYNTHETIC_TRACE]) {
+		return [AIContactListTrace syntheticTraceWithContacts:[defaults integerForKey:KEY_BENCHMARK_CONTACTS]
+													   groups:[defaults integerForKey:KEY_BENCHMARK_GROUPS]
+												   flapRounds:[defaults integerForKey:KEY_BENCHMARK_FLAP_ROUNDS]
+													 messages:[defaults integerForKey:KEY_BENCHMARK_MESSAGES]
+														 seed:(uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED]];
+	}
+
+	return [AIContactListTrace traceWithContentsOfFile:[tracePath stringByExpandingTildeInPath]];
+}
+
+/*!
+ * @brief Adium finished launching: run the benchmark which is switched on or replay the trace, report, and quit
+ */
+- (void)adiumFinishedLaunching:(NSNotification *)notification
+{
+	NSUserDefaults	*defaults = [NSUserDefaults standardUserDefaults];
+	NSDictionary	*benchmarkClassesByName = [[self class] benchmarkClassesByName];
+	Class			benchmarkClass = Nil;
+
+	for (NSString *name in [[benchmarkClassesByName allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		if ([defaults boolForKey:name]) {
+			benchmarkClass = [benchmarkClassesByName objectForKey:name];
+			break;
+		}
+	}
+
+	if (benchmarkClass)
+		[self runBenchmark:benchmarkClass];
+	else
+		[self replayTrace];
+
+	[NSApp terminate:nil];
+}
+
+/*!
+ * @brief Replay the trace named by defaults into a temporary benchmark account, and report
+ */
+- (void)replayTrace
+{
+	NSUserDefaults		*defaults = [NSUserDefaults standardUserDefaults];
+	AIContactListTrace	*trace = [self traceFromDefaults];
+
+	if (!trace) {
+		fprintf(stderr, "Could not read contact list trace %s\n", [[defaults stringForKey:KEY_BENCHMARK_TRACE] UTF8String]);
+		return;
+	}
+
+	if ([defaults stringForKey:KEY_BENCHMARK_SAVE_TRACE])
+		[trace writeToFile:[[defaults stringForKey:KEY_BENCHMARK_SAVE_TRACE] stringByExpandingTildeInPath]];
+
+	AIBenchmarkAccount	*account = [AIBenchmarkAccount addTemporaryAccountWithUID:BENCHMARK_ACCOUNT_UID];
+
+	AIContactListReplayer *replayer = [[AIContactListReplayer alloc] initWithAccount:account];
+	replayer.deliverMessages = [defaults boolForKey:KEY_BENCHMARK_DELIVER_MESSAGES];
+
+	NSDictionary *report = [replayer replayTrace:trace];
+	[replayer release];
+
+	[self reportResults:report description:[AIContactListReplayer descriptionOfReport:report]];
+
+	[account deleteTemporaryAccount];
+}
+
+/*!
+ * @brief Run a benchmark configured from defaults, report, and delete any accounts it added
+ */
+- (void)runBenchmark:(Class)benchmarkClass
+{
+	id <AIBenchmark>	benchmark = [benchmarkClass benchmarkWithDefaults:[NSUserDefaults standardUserDefaults]];
+	NSDictionary		*report = [benchmark run];
+
+	[self reportResults:report description:[benchmarkClass descriptionOfReport:report]];
+
+	if ([benchmark respondsToSelector:@selector(deleteAccounts)])
+		[benchmark deleteAccounts];
+}
+
+/*!
+ * @brief Log and print a report, and write it out if AIContactListBenchmarkReport is set
+ */
+- (void)reportResults:(NSDictionary *)report description:(NSString *)description
+{
+	NSUserDefaults	*defaults = [NSUserDefaults standardUserDefaults];
+
+	AILogWithSignature(@"%@", description);
+	fputs([description UTF8String], stdout);
+	fflush(stdout);
+
+	if ([defaults stringForKey:KEY_BENCHMARK_REPORT])
+		[report writeToFile:[[defaults stringForKey:KEY_BENCHMARK_REPORT] stringByExpandingTildeInPath] atomically:YES];
+}
+
+- (void)adiumWillTerminate:(NSNotification *)notification
+{
+	[recorder stopRecording];
+	[recorder release]; recorder = nil;
+}
+
+@end
@@ -0,0 +1,57 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+@class AIBenchmarkAccount, AIContactListTrace;
+
+//Report keys
+#define KEY_REPORT_TRACE_NAME				@"Trace"
+#define KEY_REPORT_EVENT_COUNT				@"Events"
+#define KEY_REPORT_TICK_COUNT				@"Ticks"
+#define KEY_REPORT_WALL_TIME				@"Wall Time"
+#define KEY_REPORT_MAIN_THREAD_TIME			@"Main Thread CPU Time"
+#define KEY_REPORT_FINAL_SORT_TIME			@"Final Sort Time"
+#define KEY_REPORT_SORT_CONTROLLER			@"Sort Controller"
+#define KEY_REPORT_BYTES_IN_USE_DELTA		@"Bytes In Use Delta"
+#define KEY_REPORT_BLOCKS_IN_USE_DELTA		@"Blocks In Use Delta"
+#define KEY_REPORT_PEAK_BYTES_IN_USE_DELTA	@"Peak Bytes In Use Delta"
+#define KEY_REPORT_EVENT_TYPES				@"Event Types"
+#define KEY_REPORT_OBSERVERS				@"Observers"
+
+/*!
+ * @class AIContactListReplayer
+ * @brief Replays a contact list trace through a benchmark account and measures what it cost
+ *
+ * Replay runs on the main thread as fast as it can: all events on a tick are applied, then the run loop is given one
+ * pass so that anything the contact list scheduled (delayed sorts, redisplays) runs before the next tick.
+ */
+@interface AIContactListReplayer : NSObject {
+	AIBenchmarkAccount	*account;
+	BOOL				deliverMessages;
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount;
+- (NSDictionary *)replayTrace:(AIContactListTrace *)trace;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+/*!
+ * @brief Whether Message events are received into chats
+ *
+ * Defaults to NO, in which case messages only run through the content filters and no chat windows open.
+ */
+@property (readwrite, nonatomic) BOOL deliverMessages;
+
+@end
@@ -0,0 +1,263 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIContactListReplayer.h"
+#import "AIContactListTrace.h"
+#import "AIBenchmarkAccount.h"
+#import <Adium/AIContactControllerProtocol.h>
+#import <Adium/AIContactObserverManager.h>
+#import <Adium/AISortController.h>
+
+#import <malloc/malloc.h>
+#import <mach/mach.h>
+#import <mach/mach_time.h>
+
+@interface AIContactListReplayer ()
+- (void)applyEvent:(NSDictionary *)event;
+- (void)finishTickUpdatingPeakBytesInUse:(size_t *)peakBytesInUse;
+@end
+
+/*!
+ * @brief CPU time used by the calling thread so far, in seconds
+ */
+static NSTimeInterval currentThreadCPUTime(void)
+{
+	thread_basic_info_data_t	info;
+	mach_msg_type_number_t		count = THREAD_BASIC_INFO_COUNT;
+	mach_port_t					thread = mach_thread_self();
+	kern_return_t				result = thread_info(thread, THREAD_BASIC_INFO, (thread_info_t)&info, &count);
+
+	mach_port_deallocate(mach_task_self(), thread);
+	if (result != KERN_SUCCESS) return 0.0;
+
+	return (info.user_time.seconds + info.system_time.seconds +
+			(info.user_time.microseconds + info.system_time.microseconds) / (double)USEC_PER_SEC);
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+@implementation AIContactListReplayer
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount
+{
+	if ((self = [super init])) {
+		account = [inAccount retain];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[account release];
+
+	[super dealloc];
+}
+
+@synthesize deliverMessages;
+
+/*!
+ * @brief Replay a trace
+ *
+ * @result A report dictionary; see the KEY_REPORT_ keys. Times are in seconds. Observer and event type costs are
+ *         inclusive, so an observer which triggers further updates is charged for them too.
+ */
+- (NSDictionary *)replayTrace:(AIContactListTrace *)trace
+{
+	NSMutableDictionary		*eventTypeCosts = [NSMutableDictionary dictionary];
+	NSNumber				*currentTick = nil;
+	NSUInteger				tickCount = 0;
+	malloc_statistics_t		startStatistics, endStatistics;
+	size_t					peakBytesInUse;
+
+	AILogWithSignature(@"Replaying %@: %lu events", trace.name, (unsigned long)trace.events.count);
+
+	[[AIContactObserverManager sharedManager] beginProfilingObservers];
+
+	malloc_zone_statistics(NULL, &startStatistics);
+	peakBytesInUse = startStatistics.size_in_use;
+
+	NSTimeInterval	startCPUTime = currentThreadCPUTime();
+	CFAbsoluteTime	startTime = CFAbsoluteTimeGetCurrent();
+
+	for (NSDictionary *event in trace.events) {
+		NSNumber *tick = [event objectForKey:KEY_BENCHMARK_TICK];
+		if (currentTick && ![tick isEqualToNumber:currentTick]) {
+			[self finishTickUpdatingPeakBytesInUse:&peakBytesInUse];
+			tickCount++;
+		}
+		currentTick = tick;
+
+		NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+		NSString			*type = [event objectForKey:KEY_BENCHMARK_TYPE];
+		uint64_t			eventStart = mach_absolute_time();
+
+		[self applyEvent:event];
+
+		uint64_t			elapsed = mach_absolute_time() - eventStart;
+		NSMutableDictionary	*typeCost = [eventTypeCosts objectForKey:type];
+		if (!typeCost) {
+			typeCost = [NSMutableDictionary dictionary];
+			[eventTypeCosts setObject:typeCost forKey:type];
+		}
+		[typeCost setObject:[NSNumber numberWithUnsignedInteger:[[typeCost objectForKey:@"Count"] unsignedIntegerValue] + 1]
+					 forKey:@"Count"];
+		[typeCost setObject:[NSNumber numberWithDouble:[[typeCost objectForKey:@"Seconds"] doubleValue] + secondsFromMachTime(elapsed)]
+					 forKey:@"Seconds"];
+
+		[pool release];
+	}
+
+	if (currentTick) {
+		[self finishTickUpdatingPeakBytesInUse:&peakBytesInUse];
+		tickCount++;
+	}
+
+	//Whatever the trace did, leave nothing held back
+	[account endSignOnDelay];
+	[[AIContactObserverManager sharedManager] endListObjectNotificationsDelaysImmediately];
+
+	CFAbsoluteTime sortStartTime = CFAbsoluteTimeGetCurrent();
+	[adium.contactController sortContactList];
+	CFAbsoluteTime endTime = CFAbsoluteTimeGetCurrent();
+
+	NSTimeInterval endCPUTime = currentThreadCPUTime();
+	malloc_zone_statistics(NULL, &endStatistics);
+
+	NSDictionary *observerCosts = [[AIContactObserverManager sharedManager] endProfilingObservers];
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			trace.name, KEY_REPORT_TRACE_NAME,
+			[NSNumber numberWithUnsignedInteger:trace.events.count], KEY_REPORT_EVENT_COUNT,
+			[NSNumber numberWithUnsignedInteger:tickCount], KEY_REPORT_TICK_COUNT,
+			[NSNumber numberWithDouble:(endTime - startTime)], KEY_REPORT_WALL_TIME,
+			[NSNumber numberWithDouble:(endCPUTime - startCPUTime)], KEY_REPORT_MAIN_THREAD_TIME,
+			[NSNumber numberWithDouble:(endTime - sortStartTime)], KEY_REPORT_FINAL_SORT_TIME,
+			([[AISortController activeSortController] identifier] ?: @"None"), KEY_REPORT_SORT_CONTROLLER,
+			[NSNumber numberWithLongLong:((long long)endStatistics.size_in_use - (long long)startStatistics.size_in_use)], KEY_REPORT_BYTES_IN_USE_DELTA,
+			[NSNumber numberWithLongLong:((long long)endStatistics.blocks_in_use - (long long)startStatistics.blocks_in_use)], KEY_REPORT_BLOCKS_IN_USE_DELTA,
+			[NSNumber numberWithLongLong:((long long)peakBytesInUse - (long long)startStatistics.size_in_use)], KEY_REPORT_PEAK_BYTES_IN_USE_DELTA,
+			eventTypeCosts, KEY_REPORT_EVENT_TYPES,
+			observerCosts, KEY_REPORT_OBSERVERS,
+			nil];
+}
+
+/*!
+ * @brief Let the run loop process whatever the last tick scheduled, then sample memory use
+ */
+- (void)finishTickUpdatingPeakBytesInUse:(size_t *)peakBytesInUse
+{
+	malloc_statistics_t statistics;
+
+	[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate distantPast]];
+
+	malloc_zone_statistics(NULL, &statistics);
+	if (statistics.size_in_use > *peakBytesInUse) *peakBytesInUse = statistics.size_in_use;
+}
+
+- (void)applyEvent:(NSDictionary *)event
+{
+	NSString	*type = [event objectForKey:KEY_BENCHMARK_TYPE];
+	NSString	*UID = [event objectForKey:KEY_BENCHMARK_CONTACT];
+
+	if ([type isEqualToString:AIBenchmarkEventSignOn]) {
+		[account signOnContactWithUID:UID
+								group:[event objectForKey:KEY_BENCHMARK_GROUP]
+								 away:[[event objectForKey:KEY_BENCHMARK_AWAY] boolValue]
+						statusMessage:[event objectForKey:KEY_BENCHMARK_STATUS_MESSAGE]];
+
+	} else if ([type isEqualToString:AIBenchmarkEventSignOff]) {
+		[account signOffContactWithUID:UID];
+
+	} else if ([type isEqualToString:AIBenchmarkEventStatus]) {
+		[account setContactWithUID:UID
+							  away:[[event objectForKey:KEY_BENCHMARK_AWAY] boolValue]
+					 statusMessage:[event objectForKey:KEY_BENCHMARK_STATUS_MESSAGE]];
+
+	} else if ([type isEqualToString:AIBenchmarkEventIdle]) {
+		NSTimeInterval idleSeconds = [[event objectForKey:KEY_BENCHMARK_IDLE_SECONDS] doubleValue];
+		[account setContactWithUID:UID
+					 idleSinceDate:(idleSeconds > 0 ? [NSDate dateWithTimeIntervalSinceNow:-idleSeconds] : nil)];
+
+	} else if ([type isEqualToString:AIBenchmarkEventAlias]) {
+		[account setContactWithUID:UID alias:[event objectForKey:KEY_BENCHMARK_ALIAS]];
+
+	} else if ([type isEqualToString:AIBenchmarkEventMessage]) {
+		[account receiveMessage:([event objectForKey:KEY_BENCHMARK_MESSAGE] ?: @"")
+			 fromContactWithUID:UID
+						deliver:deliverMessages];
+
+	} else if ([type isEqualToString:AIBenchmarkEventConnect]) {
+		[account connect];
+
+	} else if ([type isEqualToString:AIBenchmarkEventEndSignOnDelay]) {
+		[account endSignOnDelay];
+
+	} else if ([type isEqualToString:AIBenchmarkEventDisconnect]) {
+		[account disconnect];
+
+	} else {
+		AILogWithSignature(@"Skipping unknown event type %@", type);
+	}
+}
+
+#pragma mark Report
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString *description = [NSMutableString string];
+
+	[description appendFormat:@"Trace: %@\n", [report objectForKey:KEY_REPORT_TRACE_NAME]];
+	[description appendFormat:@"Events: %@ over %@ ticks\n", [report objectForKey:KEY_REPORT_EVENT_COUNT], [report objectForKey:KEY_REPORT_TICK_COUNT]];
+	[description appendFormat:@"Wall time: %.3f s\n", [[report objectForKey:KEY_REPORT_WALL_TIME] doubleValue]];
+	[description appendFormat:@"Main thread CPU time: %.3f s\n", [[report objectForKey:KEY_REPORT_MAIN_THREAD_TIME] doubleValue]];
+	[description appendFormat:@"Final sort (%@): %.3f s\n", [report objectForKey:KEY_REPORT_SORT_CONTROLLER],
+	 [[report objectForKey:KEY_REPORT_FINAL_SORT_TIME] doubleValue]];
+	[description appendFormat:@"Memory in use: %+lld bytes in %+lld blocks (peak %+lld bytes)\n",
+	 [[report objectForKey:KEY_REPORT_BYTES_IN_USE_DELTA] longLongValue],
+	 [[report objectForKey:KEY_REPORT_BLOCKS_IN_USE_DELTA] longLongValue],
+	 [[report objectForKey:KEY_REPORT_PEAK_BYTES_IN_USE_DELTA] longLongValue]];
+
+	for (NSString *section in [NSArray arrayWithObjects:KEY_REPORT_EVENT_TYPES, KEY_REPORT_OBSERVERS, nil]) {
+		NSDictionary *costs = [report objectForKey:section];
+		NSArray *names = [costs keysSortedByValueUsingComparator:^(id costA, id costB) {
+			return [[costB objectForKey:@"Seconds"] compare:[costA objectForKey:@"Seconds"]];
+		}];
+
+		[description appendFormat:@"\n%@:\n", section];
+		for (NSString *name in names) {
+			NSDictionary	*cost = [costs objectForKey:name];
+			NSUInteger		count = [[cost objectForKey:@"Count"] unsignedIntegerValue];
+			double			seconds = [[cost objectForKey:@"Seconds"] doubleValue];
+
+			[description appendFormat:@"  %-40s %8lu  %9.3f s  %8.1f us each\n",
+			 [name UTF8String], (unsigned long)count, seconds, (count ? seconds * USEC_PER_SEC / count : 0.0)];
+		}
+	}
+
+	return description;
+}
+
+@end
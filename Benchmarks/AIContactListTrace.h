@@ -0,0 +1,66 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+//Event types
+#define AIBenchmarkEventConnect			@"Connect"
+#define AIBenchmarkEventEndSignOnDelay	@"EndSignOnDelay"
+#define AIBenchmarkEventDisconnect		@"Disconnect"
+#define AIBenchmarkEventSignOn			@"SignOn"
+#define AIBenchmarkEventSignOff			@"SignOff"
+#define AIBenchmarkEventStatus			@"Status"
+#define AIBenchmarkEventIdle			@"Idle"
+#define AIBenchmarkEventAlias			@"Alias"
+#define AIBenchmarkEventMessage			@"Message"
+
+//Event keys
+#define KEY_BENCHMARK_TICK				@"Tick"
+#define KEY_BENCHMARK_TYPE				@"Type"
+#define KEY_BENCHMARK_CONTACT			@"Contact"
+#define KEY_BENCHMARK_GROUP				@"Group"
+#define KEY_BENCHMARK_AWAY				@"Away"
+#define KEY_BENCHMARK_STATUS_MESSAGE	@"StatusMessage"
+#define KEY_BENCHMARK_IDLE_SECONDS		@"IdleSeconds"
+#define KEY_BENCHMARK_ALIAS				@"Alias"
+#define KEY_BENCHMARK_MESSAGE			@"Message"
+
+/*!
+ * @class AIContactListTrace
+ * @brief A sequence of presence and message events for one account
+ *
+ * A trace is stored as a property list: a dictionary with a Name and an array of Events. Each event is a dictionary
+ * with a Type, the Tick it happens on, and the keys that type needs. Events on the same tick are replayed together,
+ * between two passes of the run loop. Contacts are referred to by UID only, so traces can be recorded from a real
+ * contact list without identifying anyone.
+ */
+@interface AIContactListTrace : NSObject {
+	NSString		*name;
+	NSArray			*events;
+}
+
++ (AIContactListTrace *)traceWithContentsOfFile:(NSString *)path;
++ (AIContactListTrace *)syntheticTraceWithContacts:(NSUInteger)contactCount
+											groups:(NSUInteger)groupCount
+										flapRounds:(NSUInteger)flapRounds
+										  messages:(NSUInteger)messageCount
+											  seed:(uint32_t)seed;
+
+- (id)initWithName:(NSString *)inName events:(NSArray *)inEvents;
+- (BOOL)writeToFile:(NSString *)path;
+
+@property (readonly, nonatomic) NSString *name;
+@property (readonly, nonatomic) NSArray *events;
+
+@end
@@ -0,0 +1,219 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIContactListTrace.h"
+
+#define SIGN_ON_BATCH_SIZE		100
+#define FLAP_FRACTION			20		//One in this many contacts changes something each flap round
+
+static NSString *statusMessages[] = {
+	@"Out to lunch", @"In a meeting", @"Working from home", @"Busy, ping me later",
+	@"On the phone", @"Back in 5", @"Listening to music", @"http://adium.im"
+};
+#define STATUS_MESSAGE_COUNT (sizeof(statusMessages) / sizeof(statusMessages[0]))
+
+/*!
+ * @brief A small linear congruential generator, so a seed produces the same trace on every machine and OS release
+ */
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static NSMutableDictionary *eventDictionary(NSString *type, NSUInteger tick, NSString *contactUID)
+{
+	NSMutableDictionary *event = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+								  type, KEY_BENCHMARK_TYPE,
+								  [NSNumber numberWithUnsignedInteger:tick], KEY_BENCHMARK_TICK,
+								  nil];
+	if (contactUID) [event setObject:contactUID forKey:KEY_BENCHMARK_CONTACT];
+
+	return event;
+}
+
+@implementation AIContactListTrace
+
+/*!
+ * @brief Load a trace from a property list file
+ *
+ * @result The trace, or nil if the file couldn't be read or isn't a trace
+ */
++ (AIContactListTrace *)traceWithContentsOfFile:(NSString *)path
+{
+	NSDictionary	*plist = [NSDictionary dictionaryWithContentsOfFile:path];
+	NSArray			*events = [plist objectForKey:@"Events"];
+
+	if (![events isKindOfClass:[NSArray class]]) return nil;
+
+	return [[[self alloc] initWithName:([plist objectForKey:@"Name"] ?: [[path lastPathComponent] stringByDeletingPathExtension])
+								events:events] autorelease];
+}
+
+/*!
+ * @brief Generate a sign-on storm followed by status flapping and incoming messages
+ *
+ * The account connects, all contacts sign on in batches of SIGN_ON_BATCH_SIZE per tick, and then each flap round
+ * one contact in FLAP_FRACTION signs off or on, changes status, goes idle or comes back, or changes alias. Messages
+ * are spread evenly over the flap rounds. Finally the account disconnects.
+ */
++ (AIContactListTrace *)syntheticTraceWithContacts:(NSUInteger)contactCount
+											groups:(NSUInteger)groupCount
+										flapRounds:(NSUInteger)flapRounds
+										  messages:(NSUInteger)messageCount
+											  seed:(uint32_t)seed
+{
+	NSMutableArray	*events = [NSMutableArray array];
+	NSMutableData	*onlineData = [NSMutableData dataWithLength:contactCount * sizeof(BOOL)];
+	BOOL			*online = [onlineData mutableBytes];
+	uint32_t		state = seed;
+	NSUInteger		tick = 0, i;
+
+	if (groupCount == 0) groupCount = 1;
+
+	[events addObject:eventDictionary(AIBenchmarkEventConnect, tick++, nil)];
+
+	//Sign-on storm
+	for (i = 0; i < contactCount; i++) {
+		NSString			*UID = [NSString stringWithFormat:@"contact%lu", (unsigned long)i];
+		NSMutableDictionary	*signOn = eventDictionary(AIBenchmarkEventSignOn, tick + i / SIGN_ON_BATCH_SIZE, UID);
+
+		[signOn setObject:[NSString stringWithFormat:@"Group %lu", (unsigned long)(nextRandom(&state) % groupCount)]
+				   forKey:KEY_BENCHMARK_GROUP];
+		[signOn setObject:[NSNumber numberWithBool:(nextRandom(&state) % 5 == 0)] forKey:KEY_BENCHMARK_AWAY];
+		if (nextRandom(&state) % 3 == 0)
+			[signOn setObject:statusMessages[nextRandom(&state) % STATUS_MESSAGE_COUNT] forKey:KEY_BENCHMARK_STATUS_MESSAGE];
+		[events addObject:signOn];
+		online[i] = YES;
+
+		if (nextRandom(&state) % 10 == 0) {
+			NSMutableDictionary *alias = eventDictionary(AIBenchmarkEventAlias, tick + i / SIGN_ON_BATCH_SIZE, UID);
+			[alias setObject:[NSString stringWithFormat:@"Contact Number %lu", (unsigned long)i] forKey:KEY_BENCHMARK_ALIAS];
+			[events addObject:alias];
+		}
+
+		if (nextRandom(&state) % 7 == 0) {
+			NSMutableDictionary *idle = eventDictionary(AIBenchmarkEventIdle, tick + i / SIGN_ON_BATCH_SIZE, UID);
+			[idle setObject:[NSNumber numberWithUnsignedInt:60 * (1 + nextRandom(&state) % 120)] forKey:KEY_BENCHMARK_IDLE_SECONDS];
+			[events addObject:idle];
+		}
+	}
+	tick += (contactCount + SIGN_ON_BATCH_SIZE - 1) / SIGN_ON_BATCH_SIZE;
+
+	[events addObject:eventDictionary(AIBenchmarkEventEndSignOnDelay, tick++, nil)];
+
+	//Status flapping
+	NSUInteger	flapsPerRound = contactCount / FLAP_FRACTION;
+	NSUInteger	round;
+	for (round = 0; round < flapRounds; round++, tick++) {
+		NSUInteger flap;
+		for (flap = 0; flap < flapsPerRound; flap++) {
+			NSUInteger	index = nextRandom(&state) % contactCount;
+			NSString	*UID = [NSString stringWithFormat:@"contact%lu", (unsigned long)index];
+			NSMutableDictionary *event;
+
+			switch (nextRandom(&state) % 4) {
+				case 0:
+					if (online[index]) {
+						event = eventDictionary(AIBenchmarkEventSignOff, tick, UID);
+					} else {
+						event = eventDictionary(AIBenchmarkEventSignOn, tick, UID);
+						[event setObject:[NSNumber numberWithBool:NO] forKey:KEY_BENCHMARK_AWAY];
+					}
+					online[index] = !online[index];
+					break;
+				case 1:
+					event = eventDictionary(AIBenchmarkEventStatus, tick, UID);
+					[event setObject:[NSNumber numberWithBool:(nextRandom(&state) % 2 == 0)] forKey:KEY_BENCHMARK_AWAY];
+					[event setObject:statusMessages[nextRandom(&state) % STATUS_MESSAGE_COUNT] forKey:KEY_BENCHMARK_STATUS_MESSAGE];
+					break;
+				case 2:
+					event = eventDictionary(AIBenchmarkEventIdle, tick, UID);
+					[event setObject:[NSNumber numberWithUnsignedInt:((nextRandom(&state) % 2) ? 0 : 60 * (1 + nextRandom(&state) % 120))]
+							  forKey:KEY_BENCHMARK_IDLE_SECONDS];
+					break;
+				default:
+					event = eventDictionary(AIBenchmarkEventAlias, tick, UID);
+					[event setObject:[NSString stringWithFormat:@"Contact %lu (%u)", (unsigned long)index, nextRandom(&state) % 100]
+							  forKey:KEY_BENCHMARK_ALIAS];
+					break;
+			}
+
+			//Contacts who are offline only sign back on
+			if (!online[index] && ![[event objectForKey:KEY_BENCHMARK_TYPE] isEqualToString:AIBenchmarkEventSignOff]) continue;
+
+			[events addObject:event];
+		}
+	}
+
+	//Incoming messages, spread over the flap rounds
+	NSUInteger firstFlapTick = tick - flapRounds;
+	for (i = 0; i < messageCount; i++) {
+		NSUInteger			index = nextRandom(&state) % contactCount;
+		NSMutableDictionary	*message = eventDictionary(AIBenchmarkEventMessage,
+													   firstFlapTick + (flapRounds ? (i * flapRounds / messageCount) : 0),
+													   [NSString stringWithFormat:@"contact%lu", (unsigned long)index]);
+		[message setObject:[NSString stringWithFormat:@"Message %lu: have you seen http://adium.im/ yet? :)", (unsigned long)i]
+					forKey:KEY_BENCHMARK_MESSAGE];
+		[events addObject:message];
+	}
+
+	[events addObject:eventDictionary(AIBenchmarkEventDisconnect, tick, nil)];
+
+	NSString *traceName = [NSString stringWithFormat:@"Synthetic (%lu contacts, %lu groups, %lu flap rounds, %lu messages, seed %u)",
+						   (unsigned long)contactCount, (unsigned long)groupCount, (unsigned long)flapRounds,
+						   (unsigned long)messageCount, seed];
+
+	return [[[self alloc] initWithName:traceName events:events] autorelease];
+}
+
+/*!
+ * @brief Designated initializer
+ *
+ * @param inEvents Event dictionaries in any order; they are sorted by tick, keeping the order of events on the same tick
+ */
+- (id)initWithName:(NSString *)inName events:(NSArray *)inEvents
+{
+	if ((self = [super init])) {
+		name = [inName copy];
+		events = [[inEvents sortedArrayWithOptions:NSSortStable
+								   usingComparator:^(id eventA, id eventB) {
+									   return [[eventA objectForKey:KEY_BENCHMARK_TICK] compare:[eventB objectForKey:KEY_BENCHMARK_TICK]];
+								   }] retain];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[name release];
+	[events release];
+
+	[super dealloc];
+}
+
+@synthesize name, events;
+
+- (BOOL)writeToFile:(NSString *)path
+{
+	return [[NSDictionary dictionaryWithObjectsAndKeys:
+			 name, @"Name",
+			 events, @"Events",
+			 nil] writeToFile:path atomically:YES];
+}
+
+@end
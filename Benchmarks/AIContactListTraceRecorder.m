@@ -0,0 +1,217 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIContactListTraceRecorder.h"
+#import "AIContactListTrace.h"
+#import <Adium/AIContactControllerProtocol.h>
+#import <Adium/AIContentMessage.h>
+#import <Adium/AIListContact.h>
+#import <Adium/AIMetaContact.h>
+
+#define TICKS_PER_SECOND			10
+//Matches AIContactObserverManager's delay until inactivity: three quiet seconds end a sign-on
+#define SIGN_ON_QUIET_TICKS			(3 * TICKS_PER_SECOND)
+
+@interface AIContactListTraceRecorder ()
+- (NSMutableDictionary *)eventOfType:(NSString *)type forContact:(AIListContact *)listContact;
+- (void)listObjectStatusChanged:(NSNotification *)notification;
+- (void)messageReceived:(NSNotification *)notification;
+- (void)accountConnected:(NSNotification *)notification;
+- (NSArray *)eventsWithSignOnDelaysEnded;
+@end
+
+@implementation AIContactListTraceRecorder
+
+- (id)initWithPath:(NSString *)inPath
+{
+	if ((self = [super init])) {
+		path = [inPath copy];
+		events = [[NSMutableArray alloc] init];
+		anonymousUIDs = [[NSMutableDictionary alloc] init];
+		startTime = CFAbsoluteTimeGetCurrent();
+
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(listObjectStatusChanged:)
+													 name:ListObject_StatusChanged
+												   object:nil];
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(messageReceived:)
+													 name:CONTENT_MESSAGE_RECEIVED
+												   object:nil];
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(accountConnected:)
+													 name:ACCOUNT_CONNECTED
+												   object:nil];
+
+		AILogWithSignature(@"Recording contact list trace to %@", path);
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+
+	[path release];
+	[events release];
+	[anonymousUIDs release];
+
+	[super dealloc];
+}
+
+/*!
+ * @brief Stop recording and write the trace
+ *
+ * @result YES if the trace was written
+ */
+- (BOOL)stopRecording
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+
+	AIContactListTrace *trace = [[[AIContactListTrace alloc] initWithName:[NSString stringWithFormat:@"Recorded %@", [NSDate date]]
+																   events:[self eventsWithSignOnDelaysEnded]] autorelease];
+	BOOL success = [trace writeToFile:path];
+
+	AILogWithSignature(@"%@ %lu events to %@", (success ? @"Wrote" : @"Failed to write"), (unsigned long)trace.events.count, path);
+
+	return success;
+}
+
+- (NSMutableDictionary *)eventOfType:(NSString *)type forContact:(AIListContact *)listContact
+{
+	NSUInteger			tick = (NSUInteger)((CFAbsoluteTimeGetCurrent() - startTime) * TICKS_PER_SECOND);
+	NSMutableDictionary	*event = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+								  type, KEY_BENCHMARK_TYPE,
+								  [NSNumber numberWithUnsignedInteger:tick], KEY_BENCHMARK_TICK,
+								  nil];
+
+	if (listContact) {
+		NSString *anonymousUID = [anonymousUIDs objectForKey:listContact.internalObjectID];
+		if (!anonymousUID) {
+			anonymousUID = [NSString stringWithFormat:@"contact%lu", (unsigned long)anonymousUIDs.count];
+			[anonymousUIDs setObject:anonymousUID forKey:listContact.internalObjectID];
+		}
+
+		[event setObject:anonymousUID forKey:KEY_BENCHMARK_CONTACT];
+	}
+
+	[events addObject:event];
+
+	return event;
+}
+
+- (void)listObjectStatusChanged:(NSNotification *)notification
+{
+	AIListContact	*listContact = [notification object];
+	NSSet			*keys = [[notification userInfo] objectForKey:@"Keys"];
+
+	if (![listContact isKindOfClass:[AIListContact class]] || [listContact isKindOfClass:[AIMetaContact class]] || !listContact.account)
+		return;
+
+	if ([keys containsObject:@"isOnline"]) {
+		if (listContact.online) {
+			NSMutableDictionary *event = [self eventOfType:AIBenchmarkEventSignOn forContact:listContact];
+			NSString *groupName = [listContact.remoteGroupNames anyObject];
+			if (groupName) [event setObject:groupName forKey:KEY_BENCHMARK_GROUP];
+			[event setObject:[NSNumber numberWithBool:(listContact.statusType == AIAwayStatusType)] forKey:KEY_BENCHMARK_AWAY];
+			if (listContact.statusMessageString.length)
+				[event setObject:[@"" stringByPaddingToLength:listContact.statusMessageString.length withString:@"x" startingAtIndex:0]
+						  forKey:KEY_BENCHMARK_STATUS_MESSAGE];
+		} else {
+			[self eventOfType:AIBenchmarkEventSignOff forContact:listContact];
+		}
+
+		return;
+	}
+
+	if ([keys containsObject:@"listObjectStatusType"] || [keys containsObject:@"listObjectStatusMessage"]) {
+		NSMutableDictionary *event = [self eventOfType:AIBenchmarkEventStatus forContact:listContact];
+		[event setObject:[NSNumber numberWithBool:(listContact.statusType == AIAwayStatusType)] forKey:KEY_BENCHMARK_AWAY];
+		if (listContact.statusMessageString.length)
+			[event setObject:[@"" stringByPaddingToLength:listContact.statusMessageString.length withString:@"x" startingAtIndex:0]
+					  forKey:KEY_BENCHMARK_STATUS_MESSAGE];
+	}
+
+	if ([keys containsObject:@"isIdle"] || [keys containsObject:@"idleSince"]) {
+		NSMutableDictionary *event = [self eventOfType:AIBenchmarkEventIdle forContact:listContact];
+		NSDate *idleSince = [listContact valueForProperty:@"idleSince"];
+		NSTimeInterval idleSeconds = (idleSince ? -[idleSince timeIntervalSinceNow] : ([listContact boolValueForProperty:@"isIdle"] ? 60 : 0));
+		[event setObject:[NSNumber numberWithDouble:idleSeconds] forKey:KEY_BENCHMARK_IDLE_SECONDS];
+	}
+
+	if ([keys containsObject:@"serverDisplayName"]) {
+		NSString *alias = [listContact valueForProperty:@"serverDisplayName"];
+		NSMutableDictionary *event = [self eventOfType:AIBenchmarkEventAlias forContact:listContact];
+		if (alias.length)
+			[event setObject:[@"" stringByPaddingToLength:alias.length withString:@"x" startingAtIndex:0] forKey:KEY_BENCHMARK_ALIAS];
+	}
+}
+
+- (void)messageReceived:(NSNotification *)notification
+{
+	AIContentMessage	*message = [[notification userInfo] objectForKey:@"AIContentObject"];
+	AIListContact		*source = (AIListContact *)message.source;
+
+	if (![source isKindOfClass:[AIListContact class]]) return;
+
+	NSMutableDictionary *event = [self eventOfType:AIBenchmarkEventMessage forContact:source];
+	[event setObject:[@"" stringByPaddingToLength:message.message.length withString:@"x" startingAtIndex:0]
+			  forKey:KEY_BENCHMARK_MESSAGE];
+}
+
+- (void)accountConnected:(NSNotification *)notification
+{
+	[self eventOfType:AIBenchmarkEventConnect forContact:nil];
+}
+
+/*!
+ * @brief The recorded events, with an EndSignOnDelay after each connection's burst of sign-ons
+ *
+ * A burst ends at the last sign-on before a gap of SIGN_ON_QUIET_TICKS.
+ */
+- (NSArray *)eventsWithSignOnDelaysEnded
+{
+	NSMutableArray	*result = [NSMutableArray arrayWithCapacity:events.count];
+	BOOL			inSignOn = NO;
+	NSUInteger		lastSignOnTick = 0;
+
+	for (NSDictionary *event in events) {
+		NSString	*type = [event objectForKey:KEY_BENCHMARK_TYPE];
+		NSUInteger	tick = [[event objectForKey:KEY_BENCHMARK_TICK] unsignedIntegerValue];
+
+		if (inSignOn && tick > lastSignOnTick + SIGN_ON_QUIET_TICKS) {
+			[result addObject:[NSDictionary dictionaryWithObjectsAndKeys:
+							   AIBenchmarkEventEndSignOnDelay, KEY_BENCHMARK_TYPE,
+							   [NSNumber numberWithUnsignedInteger:lastSignOnTick + 1], KEY_BENCHMARK_TICK,
+							   nil]];
+			inSignOn = NO;
+		}
+
+		if ([type isEqualToString:AIBenchmarkEventConnect]) {
+			inSignOn = YES;
+			lastSignOnTick = tick;
+		} else if (inSignOn && [type isEqualToString:AIBenchmarkEventSignOn]) {
+			lastSignOnTick = tick;
+		}
+
+		[result addObject:event];
+	}
+
+	return result;
+}
+
+@end
@@ -0,0 +1,62 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+
+//Report keys
+#define KEY_DNS_REPORT_ACCOUNTS			@"Accounts"
+#define KEY_DNS_REPORT_STORMS			@"Storms"
+#define KEY_DNS_REPORT_HOSTS			@"Hosts"
+#define KEY_DNS_REPORT_LOOKUPS			@"Lookups"
+#define KEY_DNS_REPORT_QUERIES			@"Backend Queries"
+#define KEY_DNS_REPORT_DIRECT_QUERIES	@"Direct Backend Queries"
+#define KEY_DNS_REPORT_HIT_RATE			@"Hit Rate"
+#define KEY_DNS_REPORT_LATENCY			@"Average Backend Latency"
+#define KEY_DNS_REPORT_MISMATCHES		@"Mismatches"
+#define KEY_DNS_REPORT_OPERATIONS		@"Operations"
+
+/*!
+ * @class AIHostResolverBenchmark
+ * @brief Reconnects simulated accounts after network changes, resolving their servers through AIHostResolver and
+ * straight through the backend, as adiumPurpleDnsRequest used to
+ *
+ * accountCount accounts are spread over a handful of servers on a stub resolver which answers one query at a time
+ * after latency seconds. One account in ten has a server which doesn't exist, and retries it twice. The network
+ * changes stormCount times; after each change the resolver's cache is flushed and every account reconnects at once.
+ * The time until every account has its answer, and how many queries the stub answered, are reported for both, and
+ * every answer from the resolver is checked against the direct one.
+ *
+ * Run with -AIHostResolverBenchmark YES. Settings:
+ *	-AIHostResolverBenchmarkAccounts <n>	Simulated accounts (50)
+ *	-AIHostResolverBenchmarkStorms <n>		Times they all reconnect (20)
+ */
+@interface AIHostResolverBenchmark : NSObject <AIBenchmark> {
+	NSUInteger			accountCount;
+	NSUInteger			stormCount;
+	NSTimeInterval		latency;
+
+	NSMutableArray		*mismatches;
+}
+
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger accountCount;
+@property (readwrite, nonatomic) NSUInteger stormCount;
+@property (readwrite, nonatomic) NSTimeInterval latency;
+
+@end
@@ -0,0 +1,341 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIHostResolverBenchmark.h"
+#import <AIUtilities/AIHostResolver.h>
+#import <AIUtilities/AIHostsFileHostResolverBackend.h>
+#import <mach/mach_time.h>
+
+//Settings
+#define KEY_DNS_BENCHMARK_ACCOUNTS			@"AIHostResolverBenchmarkAccounts"
+#define KEY_DNS_BENCHMARK_STORMS			@"AIHostResolverBenchmarkStorms"
+
+#define SERVER_COUNT					5
+//One account in so many has a server which doesn't exist
+#define MISSING_SERVER_INTERVAL			10
+//How many times an account retries a failed lookup
+#define RETRIES							2
+//How long to wait for a storm to be answered before giving up
+#define STORM_TIMEOUT					60.0
+//How many mismatches are described in the report
+#define MAX_REPORTED_MISMATCHES			20
+
+typedef void (^AIHostResolverBenchmarkHandler)(NSArray *addresses, NSError *error);
+
+/*!
+ * @class AIHostResolverBenchmarkStub
+ * @brief A stub resolver which answers one query at a time, like a single upstream server under load
+ */
+@interface AIHostResolverBenchmarkStub : NSObject <AIHostResolverBackend> {
+	AIHostsFileHostResolverBackend	*hostsFile;
+	NSMutableArray					*queuedQueries;
+	BOOL							answering;
+	NSUInteger						queryCount;
+}
+- (id)initWithHostsFileContents:(NSString *)contents latency:(NSTimeInterval)latency;
+- (void)answerNextQuery;
+@property (readonly, nonatomic) NSUInteger queryCount;
+@end
+
+@implementation AIHostResolverBenchmarkStub
+
+- (id)initWithHostsFileContents:(NSString *)contents latency:(NSTimeInterval)latency
+{
+	if ((self = [super init])) {
+		hostsFile = [[AIHostsFileHostResolverBackend alloc] initWithHostsFileContents:contents];
+		hostsFile.latency = latency;
+		queuedQueries = [[NSMutableArray alloc] init];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[hostsFile release];
+	[queuedQueries release];
+
+	[super dealloc];
+}
+
+@synthesize queryCount;
+
+- (void)resolveHostName:(NSString *)hostName completion:(AIHostResolverBackendCompletion)completion
+{
+	queryCount++;
+	[queuedQueries addObject:[NSArray arrayWithObjects:hostName, [[completion copy] autorelease], nil]];
+	if (!answering) [self answerNextQuery];
+}
+
+- (void)answerNextQuery
+{
+	if (!queuedQueries.count) {
+		answering = NO;
+		return;
+	}
+
+	NSArray							*query = [[[queuedQueries objectAtIndex:0] retain] autorelease];
+	AIHostResolverBackendCompletion	completion = [query objectAtIndex:1];
+
+	[queuedQueries removeObjectAtIndex:0];
+	answering = YES;
+
+	[hostsFile resolveHostName:[query objectAtIndex:0] completion:^(NSArray *addresses, NSTimeInterval timeToLive, NSError *error) {
+		completion(addresses, timeToLive, error);
+		[self answerNextQuery];
+	}];
+}
+
+@end
+
+#pragma mark -
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+static void addCost(NSMutableDictionary *costs, NSString *costName, NSUInteger count, uint64_t machTime)
+{
+	[costs setObject:[NSDictionary dictionaryWithObjectsAndKeys:
+					  [NSNumber numberWithUnsignedInteger:count], @"Count",
+					  [NSNumber numberWithDouble:secondsFromMachTime(machTime)], @"Seconds",
+					  nil]
+			  forKey:costName];
+}
+
+static NSString *serverForAccount(NSUInteger i)
+{
+	if (i % MISSING_SERVER_INTERVAL == MISSING_SERVER_INTERVAL - 1)
+		return [NSString stringWithFormat:@"missing%lu.example.net", (unsigned long)(i / MISSING_SERVER_INTERVAL % SERVER_COUNT)];
+
+	return [NSString stringWithFormat:@"server%lu.example.net", (unsigned long)(i % SERVER_COUNT)];
+}
+
+/*!
+ * @brief A description of an answer which doesn't depend on the order of the addresses
+ */
+static NSString *answerDescription(NSArray *addresses, NSError *error)
+{
+	if (error) return [NSString stringWithFormat:@"error %ld", (long)[error code]];
+
+	NSMutableArray *descriptions = [NSMutableArray array];
+	for (NSData *address in addresses) [descriptions addObject:[address description]];
+
+	return [[descriptions sortedArrayUsingSelector:@selector(compare:)] componentsJoinedByString:@","];
+}
+
+@interface AIHostResolverBenchmark ()
+- (uint64_t)runStormWithLookup:(void (^)(NSString *hostName, AIHostResolverBenchmarkHandler handler))lookup
+					   answers:(NSMutableDictionary *)answers
+				   lookupCount:(NSUInteger *)lookupCount;
+@end
+
+@implementation AIHostResolverBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:50], KEY_DNS_BENCHMARK_ACCOUNTS,
+			[NSNumber numberWithUnsignedInteger:20], KEY_DNS_BENCHMARK_STORMS,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AIHostResolverBenchmark *benchmark = [[[self alloc] init] autorelease];
+
+	benchmark.accountCount = [defaults integerForKey:KEY_DNS_BENCHMARK_ACCOUNTS];
+	benchmark.stormCount = [defaults integerForKey:KEY_DNS_BENCHMARK_STORMS];
+
+	return benchmark;
+}
+
+- (id)init
+{
+	if ((self = [super init])) {
+		accountCount = 50;
+		stormCount = 20;
+		latency = 0.005;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[mismatches release];
+
+	[super dealloc];
+}
+
+@synthesize accountCount, stormCount, latency;
+
+- (NSDictionary *)run
+{
+	NSMutableDictionary		*costs = [NSMutableDictionary dictionary];
+	NSMutableString			*hostsFile = [NSMutableString string];
+	NSUInteger				i, storm, lookupCount = 0, directLookupCount = 0;
+	uint64_t				resolverTime = 0, directTime = 0;
+
+	NSMutableSet			*hostNames = [NSMutableSet set];
+
+	[mismatches release]; mismatches = [[NSMutableArray alloc] init];
+
+	for (i = 0; i < accountCount; i++) [hostNames addObject:serverForAccount(i)];
+
+	//Each server has an IPv6 and two IPv4 addresses
+	for (i = 0; i < SERVER_COUNT; i++) {
+		[hostsFile appendFormat:@"2001:db8::%lu server%lu.example.net\n", (unsigned long)(i + 1), (unsigned long)i];
+		[hostsFile appendFormat:@"192.0.2.%lu server%lu.example.net\n", (unsigned long)(i + 1), (unsigned long)i];
+		[hostsFile appendFormat:@"198.51.100.%lu server%lu.example.net\n", (unsigned long)(i + 1), (unsigned long)i];
+	}
+
+	AIHostResolverBenchmarkStub	*resolverStub = [[[AIHostResolverBenchmarkStub alloc] initWithHostsFileContents:hostsFile latency:latency] autorelease];
+	AIHostResolverBenchmarkStub	*directStub = [[[AIHostResolverBenchmarkStub alloc] initWithHostsFileContents:hostsFile latency:latency] autorelease];
+	AIHostResolver				*resolver = [[[AIHostResolver alloc] initWithBackend:resolverStub] autorelease];
+
+	for (storm = 0; storm < stormCount; storm++) {
+		NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+		NSMutableDictionary	*resolverAnswers = [NSMutableDictionary dictionary];
+		NSMutableDictionary	*directAnswers = [NSMutableDictionary dictionary];
+
+		//The network changed
+		[resolver flushCache];
+
+		resolverTime += [self runStormWithLookup:^(NSString *hostName, AIHostResolverBenchmarkHandler handler) {
+			[resolver resolveHostName:hostName handler:handler];
+		} answers:resolverAnswers lookupCount:&lookupCount];
+
+		directTime += [self runStormWithLookup:^(NSString *hostName, AIHostResolverBenchmarkHandler handler) {
+			[directStub resolveHostName:hostName completion:^(NSArray *addresses, NSTimeInterval timeToLive, NSError *error) {
+				handler(addresses, error);
+			}];
+		} answers:directAnswers lookupCount:&directLookupCount];
+
+		for (NSString *hostName in directAnswers) {
+			if (![[resolverAnswers objectForKey:hostName] isEqualToString:[directAnswers objectForKey:hostName]]) {
+				[mismatches addObject:[NSString stringWithFormat:@"Storm %lu, %@: %@, directly %@", (unsigned long)storm, hostName,
+									   [resolverAnswers objectForKey:hostName], [directAnswers objectForKey:hostName]]];
+			}
+		}
+
+		[pool release];
+	}
+
+	addCost(costs, @"Storms through AIHostResolver", stormCount, resolverTime);
+	addCost(costs, @"Storms straight to the backend", stormCount, directTime);
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:accountCount], KEY_DNS_REPORT_ACCOUNTS,
+			[NSNumber numberWithUnsignedInteger:stormCount], KEY_DNS_REPORT_STORMS,
+			[NSNumber numberWithUnsignedInteger:hostNames.count], KEY_DNS_REPORT_HOSTS,
+			[NSNumber numberWithUnsignedInteger:lookupCount], KEY_DNS_REPORT_LOOKUPS,
+			[NSNumber numberWithUnsignedInteger:resolverStub.queryCount], KEY_DNS_REPORT_QUERIES,
+			[NSNumber numberWithUnsignedInteger:directStub.queryCount], KEY_DNS_REPORT_DIRECT_QUERIES,
+			[NSNumber numberWithDouble:resolver.hitRate], KEY_DNS_REPORT_HIT_RATE,
+			[NSNumber numberWithDouble:resolver.averageBackendLatency], KEY_DNS_REPORT_LATENCY,
+			mismatches, KEY_DNS_REPORT_MISMATCHES,
+			costs, KEY_DNS_REPORT_OPERATIONS,
+			nil];
+}
+
+/*!
+ * @brief Have every account look up its server at once, retrying failures, and wait until all are answered
+ *
+ * @result How long it took
+ */
+- (uint64_t)runStormWithLookup:(void (^)(NSString *hostName, AIHostResolverBenchmarkHandler handler))lookup
+					   answers:(NSMutableDictionary *)answers
+				   lookupCount:(NSUInteger *)lookupCount
+{
+	__block NSUInteger	answeredCount = 0;
+	uint64_t			start = mach_absolute_time();
+	NSDate				*deadline = [NSDate dateWithTimeIntervalSinceNow:STORM_TIMEOUT];
+	NSUInteger			i;
+
+	for (i = 0; i < accountCount; i++) {
+		NSString				*hostName = serverForAccount(i);
+		__block NSUInteger		retriesLeft = RETRIES;
+		__block AIHostResolverBenchmarkHandler handler;
+
+		handler = [^(NSArray *addresses, NSError *error) {
+			[answers setObject:answerDescription(addresses, error) forKey:hostName];
+
+			if (error && retriesLeft) {
+				retriesLeft--;
+				(*lookupCount)++;
+				lookup(hostName, handler);
+			} else {
+				answeredCount++;
+				[handler autorelease];
+			}
+		} copy];
+
+		(*lookupCount)++;
+		lookup(hostName, handler);
+	}
+
+	while (answeredCount < accountCount && [deadline timeIntervalSinceNow] > 0) {
+		[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+	}
+
+	if (answeredCount < accountCount) {
+		[mismatches addObject:[NSString stringWithFormat:@"Only %lu of %lu accounts were answered",
+							   (unsigned long)answeredCount, (unsigned long)accountCount]];
+	}
+
+	return mach_absolute_time() - start;
+}
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSDictionary	*costs = [report objectForKey:KEY_DNS_REPORT_OPERATIONS];
+	NSArray			*reportMismatches = [report objectForKey:KEY_DNS_REPORT_MISMATCHES];
+
+	[description appendFormat:@"Accounts: %@, storms: %@, hosts: %@, lookups: %@\n",
+	 [report objectForKey:KEY_DNS_REPORT_ACCOUNTS], [report objectForKey:KEY_DNS_REPORT_STORMS],
+	 [report objectForKey:KEY_DNS_REPORT_HOSTS], [report objectForKey:KEY_DNS_REPORT_LOOKUPS]];
+	[description appendFormat:@"Backend queries: %@ through AIHostResolver (hit rate %.1f%%, average latency %.3f ms), %@ directly\n",
+	 [report objectForKey:KEY_DNS_REPORT_QUERIES], [[report objectForKey:KEY_DNS_REPORT_HIT_RATE] doubleValue] * 100.0,
+	 [[report objectForKey:KEY_DNS_REPORT_LATENCY] doubleValue] * 1000.0, [report objectForKey:KEY_DNS_REPORT_DIRECT_QUERIES]];
+	[description appendFormat:@"Mismatches: %lu\n", (unsigned long)reportMismatches.count];
+
+	for (NSUInteger i = 0; i < reportMismatches.count && i < MAX_REPORTED_MISMATCHES; i++) {
+		[description appendFormat:@"  %@\n", [reportMismatches objectAtIndex:i]];
+	}
+
+	[description appendString:@"\n"];
+	for (NSString *name in [[costs allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		NSDictionary	*cost = [costs objectForKey:name];
+		NSUInteger		count = [[cost objectForKey:@"Count"] unsignedIntegerValue];
+		double			seconds = [[cost objectForKey:@"Seconds"] doubleValue];
+
+		[description appendFormat:@"  %-50s %8lu  %9.3f s  %10.3f us each\n",
+		 [name UTF8String], (unsigned long)count, seconds, (count ? seconds * USEC_PER_SEC / count : 0.0)];
+	}
+
+	return description;
+}
+
+@end
@@ -0,0 +1,91 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+#import <Adium/AIContactObserverManager.h>
+
+@class AIBenchmarkAccount;
+
+//Report keys
+#define KEY_IDLE_TIME_REPORT_CONTACTS			@"Contacts"
+#define KEY_IDLE_TIME_REPORT_VISIBLE_ROWS		@"Visible Rows"
+#define KEY_IDLE_TIME_REPORT_MINUTES			@"Minutes"
+#define KEY_IDLE_TIME_REPORT_MISMATCHES			@"Mismatches"
+#define KEY_IDLE_TIME_REPORT_PASSES				@"Passes"
+
+//Keys of each pass in KEY_IDLE_TIME_REPORT_PASSES
+#define KEY_IDLE_TIME_PASS_NAME					@"Name"
+#define KEY_IDLE_TIME_PASS_NOTIFICATIONS		@"Observer Notifications"
+#define KEY_IDLE_TIME_PASS_LAYOUTS				@"Rows Laid Out"
+#define KEY_IDLE_TIME_PASS_REDRAWS				@"Rows Redrawn"
+#define KEY_IDLE_TIME_PASS_STRINGS				@"Idle Strings"
+#define KEY_IDLE_TIME_PASS_SECONDS				@"Seconds"
+
+/*!
+ * @class AIIdleTimeBenchmark
+ * @brief Counts what keeping idle times current costs as the minutes pass
+ *
+ * contactCount contacts sign on idle: most since a known date, some for an unknown time and a few for longer than idle
+ * times are shown. minuteCount minutes are then passed twice.
+ *
+ * The first pass does what AIContactIdlePlugin did each minute: set every idle contact's @"idle" to its minutes idle
+ * and notify, within one delay of list object notifications, with the extended status formatted again for each
+ * contact whose @"idle" changed, as AIExtendedStatusPlugin did. The second has AIElapsedTimeManager announce each
+ * minute, and redraws the rows which depend on the time among visibleRowCount rows at a random scroll position, as
+ * AIAbstractListController does, working out each of their idle times as it is drawn.
+ *
+ * Observer notifications are those received for the benchmark's contacts; rows laid out are contacts whose display
+ * version moved on, which discards their cached cell layout. Afterwards each contact's idle time and idle string are
+ * checked against what the first pass would have shown.
+ *
+ * Run with -AIIdleTimeBenchmark YES. Settings:
+ *	-AIIdleTimeBenchmarkContacts <n>	Idle contacts to sign on (3000)
+ *	-AIIdleTimeBenchmarkVisibleRows <n>	Rows the contact list shows (40)
+ *	-AIIdleTimeBenchmarkMinutes <n>		Minutes to pass (10)
+ *	-AIContactListBenchmarkSeed <n>		Seed for the random choices (1)
+ */
+@interface AIIdleTimeBenchmark : NSObject <AIBenchmark, AIListObjectObserver> {
+	AIBenchmarkAccount	*account;
+
+	NSUInteger			contactCount;
+	NSUInteger			visibleRowCount;
+	NSUInteger			minuteCount;
+	uint32_t			seed;
+	uint32_t			random;
+
+	NSArray				*contacts;
+	NSSet				*observedContacts;
+	BOOL				formatsOnIdleChanges;
+
+	NSUInteger			notificationCount;
+	NSUInteger			redrawCount;
+	NSUInteger			stringCount;
+
+	NSMutableArray		*mismatches;
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount;
+
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger contactCount;
+@property (readwrite, nonatomic) NSUInteger visibleRowCount;
+@property (readwrite, nonatomic) NSUInteger minuteCount;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
@@ -0,0 +1,436 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIIdleTimeBenchmark.h"
+#import "AIBenchmarkAccount.h"
+#import <Adium/AIListContact.h>
+#import <Adium/AIElapsedTimeManager.h>
+#import <AIUtilities/AIDateFormatterAdditions.h>
+#import <mach/mach_time.h>
+
+//Settings
+#define KEY_IDLE_TIME_BENCHMARK_CONTACTS	@"AIIdleTimeBenchmarkContacts"
+#define KEY_IDLE_TIME_BENCHMARK_ROWS		@"AIIdleTimeBenchmarkVisibleRows"
+#define KEY_IDLE_TIME_BENCHMARK_MINUTES		@"AIIdleTimeBenchmarkMinutes"
+
+//Idle times longer than 999 hours are shown simply as idle
+#define MAX_IDLE_MINUTES				599400
+//Idle dates fall this far into a minute, so checking them can't straddle a minute changing
+#define IDLE_SECONDS_INTO_MINUTE		30
+//How many mismatches are described in the report
+#define MAX_REPORTED_MISMATCHES			20
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+static BOOL objectsMatch(id a, id b)
+{
+	return (a == b || [a isEqual:b]);
+}
+
+/*!
+ * @brief Minutes idle since a date, as AIContactIdlePlugin worked them out
+ */
+static NSInteger minutesIdleSince(NSDate *idleSince)
+{
+	NSInteger idle = (CGFloat)(-[idleSince timeIntervalSinceNow]) / 60.0f;
+
+	return (idle == 0 ? -1 : idle);
+}
+
+/*!
+ * @brief The idle string for some minutes, as AIExtendedStatusPlugin formatted it
+ *
+ * "Idle" is looked up in the Adium framework, where AIElapsedTimeManager looks it up, rather than in our bundle.
+ */
+static NSString *idleStringForMinutes(NSInteger minutes)
+{
+	return ((minutes > MAX_IDLE_MINUTES) ?
+			AILocalizedStringFromTableInBundle(@"Idle", nil, [NSBundle bundleForClass:[AIElapsedTimeManager class]], nil) :
+			[NSDateFormatter stringForApproximateTimeInterval:(minutes * 60) abbreviated:YES]);
+}
+
+@interface AIIdleTimeBenchmark ()
+- (void)signOnContacts;
+- (void)noteDisplayVersions:(NSUInteger *)versions;
+- (NSUInteger)countLayoutsSinceDisplayVersions:(NSUInteger *)versions;
+- (NSDictionary *)passMinutesPerContact;
+- (NSDictionary *)passMinutesOnTheClock;
+- (void)minuteDidChange:(NSNotification *)notification;
+- (void)checkContacts;
+@end
+
+@implementation AIIdleTimeBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:3000], KEY_IDLE_TIME_BENCHMARK_CONTACTS,
+			[NSNumber numberWithUnsignedInteger:40], KEY_IDLE_TIME_BENCHMARK_ROWS,
+			[NSNumber numberWithUnsignedInteger:10], KEY_IDLE_TIME_BENCHMARK_MINUTES,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AIIdleTimeBenchmark *benchmark = [[[self alloc] initWithAccount:[AIBenchmarkAccount addTemporaryAccountWithUID:BENCHMARK_ACCOUNT_UID]] autorelease];
+
+	benchmark.contactCount = [defaults integerForKey:KEY_IDLE_TIME_BENCHMARK_CONTACTS];
+	benchmark.visibleRowCount = [defaults integerForKey:KEY_IDLE_TIME_BENCHMARK_ROWS];
+	benchmark.minuteCount = [defaults integerForKey:KEY_IDLE_TIME_BENCHMARK_MINUTES];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (void)deleteAccounts
+{
+	[account deleteTemporaryAccount];
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount
+{
+	if ((self = [super init])) {
+		account = [inAccount retain];
+		contactCount = 3000;
+		visibleRowCount = 40;
+		minuteCount = 10;
+		seed = 1;
+		mismatches = [[NSMutableArray alloc] init];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[account release];
+	[contacts release];
+	[observedContacts release];
+	[mismatches release];
+
+	[super dealloc];
+}
+
+@synthesize contactCount, visibleRowCount, minuteCount, seed;
+
+#pragma mark Contacts
+
+/*!
+ * @brief Sign on contactCount idle contacts
+ *
+ * One in twenty is idle for an unknown time and one in fifty for longer than idle times are shown; the rest went idle
+ * up to three days ago.
+ */
+- (void)signOnContacts
+{
+	NSMutableArray	*signedOn = [NSMutableArray arrayWithCapacity:contactCount];
+	NSDate			*now = [NSDate date];
+
+	[account connect];
+
+	for (NSUInteger idx = 0; idx < contactCount; idx++) {
+		NSString		*UID = [NSString stringWithFormat:@"idle%lu", (unsigned long)idx];
+		uint32_t		choice = nextRandom(&random) % 100;
+		NSTimeInterval	minutesIdle;
+
+		[account signOnContactWithUID:UID group:@"Idle" away:(nextRandom(&random) % 4 == 0) statusMessage:nil];
+
+		AIListContact	*contact = [account contactWithUID:UID];
+
+		if (choice < 5) {
+			[contact setIdle:YES sinceDate:nil notify:NotifyLater];
+			[contact notifyOfChangedPropertiesSilently:YES];
+
+		} else {
+			if (choice < 7) {
+				minutesIdle = MAX_IDLE_MINUTES + 1 + nextRandom(&random) % (60 * 24 * 30);
+			} else {
+				minutesIdle = nextRandom(&random) % (60 * 24 * 3);
+			}
+
+			[account setContactWithUID:UID
+						 idleSinceDate:[now dateByAddingTimeInterval:-(minutesIdle * 60 + IDLE_SECONDS_INTO_MINUTE)]];
+		}
+
+		[signedOn addObject:contact];
+	}
+
+	[account endSignOnDelay];
+
+	[contacts release];
+	contacts = [signedOn copy];
+	[observedContacts release];
+	observedContacts = [[NSSet alloc] initWithArray:contacts];
+}
+
+- (void)noteDisplayVersions:(NSUInteger *)versions
+{
+	for (NSUInteger idx = 0; idx < contactCount; idx++) {
+		versions[idx] = ((AIListContact *)[contacts objectAtIndex:idx]).displayVersion;
+	}
+}
+
+/*!
+ * @brief How many contacts' cached cell layouts have been discarded since their versions were noted
+ */
+- (NSUInteger)countLayoutsSinceDisplayVersions:(NSUInteger *)versions
+{
+	NSUInteger count = 0;
+
+	for (NSUInteger idx = 0; idx < contactCount; idx++) {
+		if (((AIListContact *)[contacts objectAtIndex:idx]).displayVersion != versions[idx]) count++;
+	}
+
+	return count;
+}
+
+#pragma mark Passes
+
+- (NSSet *)updateListObject:(AIListObject *)inObject keys:(NSSet *)inModifiedKeys silent:(BOOL)silent
+{
+	if (inModifiedKeys && [observedContacts containsObject:inObject]) {
+		notificationCount++;
+
+		//AIExtendedStatusPlugin formatted the idle time again whenever @"idle" changed
+		if (formatsOnIdleChanges && [inModifiedKeys containsObject:@"idle"]) {
+			NSInteger idle = [inObject integerValueForProperty:@"idle"];
+			if (idle > 0 && idleStringForMinutes(idle)) stringCount++;
+		}
+	}
+
+	return nil;
+}
+
+/*!
+ * @brief What AIContactIdlePlugin's timer did each minute
+ *
+ * Each minute's idle times are those the contacts would have then, so every one of them changes.
+ */
+- (NSDictionary *)passMinutesPerContact
+{
+	NSUInteger	*versions = malloc(contactCount * sizeof(NSUInteger));
+	NSUInteger	layoutCount = 0, minute;
+	uint64_t	start;
+
+	notificationCount = 0;
+	redrawCount = 0;
+	stringCount = 0;
+	formatsOnIdleChanges = YES;
+
+	start = mach_absolute_time();
+
+	for (minute = 1; minute <= minuteCount; minute++) {
+		[self noteDisplayVersions:versions];
+
+		[[AIContactObserverManager sharedManager] delayListObjectNotifications];
+
+		for (AIListContact *contact in contacts) {
+			NSDate *idleSince = [contact valueForProperty:@"idleSince"];
+
+			//Contacts idle for an unknown time weren't tracked
+			if (!idleSince) continue;
+
+			[contact setValue:[NSNumber numberWithInteger:minutesIdleSince(idleSince) + minute]
+				  forProperty:@"idle"
+					   notify:NotifyLater];
+			[contact notifyOfChangedPropertiesSilently:YES];
+		}
+
+		[[AIContactObserverManager sharedManager] endListObjectNotificationsDelay];
+
+		//Each of them was redrawn, as well as laid out again
+		NSUInteger laidOut = [self countLayoutsSinceDisplayVersions:versions];
+		layoutCount += laidOut;
+		redrawCount += laidOut;
+	}
+
+	double seconds = secondsFromMachTime(mach_absolute_time() - start);
+
+	formatsOnIdleChanges = NO;
+	free(versions);
+
+	//Leave @"idle" set only for the contacts idle for an unknown time, as it is now
+	for (AIListContact *contact in contacts) {
+		if ([contact valueForProperty:@"idleSince"])
+			[contact setValue:nil forProperty:@"idle" notify:NotifyNever];
+	}
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			@"Per contact", KEY_IDLE_TIME_PASS_NAME,
+			[NSNumber numberWithUnsignedInteger:notificationCount], KEY_IDLE_TIME_PASS_NOTIFICATIONS,
+			[NSNumber numberWithUnsignedInteger:layoutCount], KEY_IDLE_TIME_PASS_LAYOUTS,
+			[NSNumber numberWithUnsignedInteger:redrawCount], KEY_IDLE_TIME_PASS_REDRAWS,
+			[NSNumber numberWithUnsignedInteger:stringCount], KEY_IDLE_TIME_PASS_STRINGS,
+			[NSNumber numberWithDouble:seconds], KEY_IDLE_TIME_PASS_SECONDS,
+			nil];
+}
+
+/*!
+ * @brief Pass the minutes as AIElapsedTimeManager announces them
+ */
+- (NSDictionary *)passMinutesOnTheClock
+{
+	AIElapsedTimeManager	*elapsedTimeManager = [AIElapsedTimeManager sharedManager];
+	NSUInteger				*versions = malloc(contactCount * sizeof(NSUInteger));
+	NSUInteger				layoutCount = 0, minute;
+	uint64_t				start;
+
+	notificationCount = 0;
+	redrawCount = 0;
+	stringCount = 0;
+
+	[elapsedTimeManager addMinuteObserver:self selector:@selector(minuteDidChange:)];
+
+	start = mach_absolute_time();
+
+	for (minute = 1; minute <= minuteCount; minute++) {
+		[self noteDisplayVersions:versions];
+		[elapsedTimeManager minuteDidChange];
+		layoutCount += [self countLayoutsSinceDisplayVersions:versions];
+	}
+
+	double seconds = secondsFromMachTime(mach_absolute_time() - start);
+
+	[elapsedTimeManager removeMinuteObserver:self];
+	free(versions);
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			@"On the minute", KEY_IDLE_TIME_PASS_NAME,
+			[NSNumber numberWithUnsignedInteger:notificationCount], KEY_IDLE_TIME_PASS_NOTIFICATIONS,
+			[NSNumber numberWithUnsignedInteger:layoutCount], KEY_IDLE_TIME_PASS_LAYOUTS,
+			[NSNumber numberWithUnsignedInteger:redrawCount], KEY_IDLE_TIME_PASS_REDRAWS,
+			[NSNumber numberWithUnsignedInteger:stringCount], KEY_IDLE_TIME_PASS_STRINGS,
+			[NSNumber numberWithDouble:seconds], KEY_IDLE_TIME_PASS_SECONDS,
+			nil];
+}
+
+/*!
+ * @brief The minute changed; redraw the visible rows which depend on the time, as AIAbstractListController does
+ *
+ * The list is scrolled somewhere new each minute.
+ */
+- (void)minuteDidChange:(NSNotification *)notification
+{
+	AIElapsedTimeManager	*elapsedTimeManager = [AIElapsedTimeManager sharedManager];
+	NSUInteger				firstRow = 0, row;
+
+	if (contactCount > visibleRowCount)
+		firstRow = nextRandom(&random) % (contactCount - visibleRowCount + 1);
+
+	for (row = firstRow; row < firstRow + visibleRowCount && row < contactCount; row++) {
+		AIListContact *contact = [contacts objectAtIndex:row];
+
+		if ([elapsedTimeManager displayOfObjectDependsOnTime:contact]) {
+			redrawCount++;
+			if ([elapsedTimeManager idleStringForObject:contact]) stringCount++;
+		}
+	}
+}
+
+#pragma mark Checks
+
+/*!
+ * @brief Check each contact's idle time and idle string against what AIContactIdlePlugin and AIExtendedStatusPlugin showed
+ */
+- (void)checkContacts
+{
+	AIElapsedTimeManager	*elapsedTimeManager = [AIElapsedTimeManager sharedManager];
+
+	for (NSUInteger idx = 0; idx < contactCount; idx++) {
+		AIListContact	*contact = [contacts objectAtIndex:idx];
+		NSDate			*idleSince = [contact valueForProperty:@"idleSince"];
+		NSInteger		expected = (idleSince ? minutesIdleSince(idleSince) : -1);
+		NSString		*expectedString = (expected > 0 ? idleStringForMinutes(expected) : nil);
+		NSString		*idleString = [elapsedTimeManager idleStringForObject:contact];
+
+		if (contact.idleTime != expected || !objectsMatch(idleString, expectedString)) {
+			[mismatches addObject:[NSString stringWithFormat:@"Contact %lu: idle %ld (%@), expected %ld (%@)",
+								   (unsigned long)idx, (long)contact.idleTime, idleString, (long)expected, expectedString]];
+		}
+	}
+}
+
+#pragma mark Running
+
+- (NSDictionary *)run
+{
+	NSMutableArray	*passes = [NSMutableArray array];
+
+	[mismatches removeAllObjects];
+	random = seed;
+
+	[self signOnContacts];
+
+	[[AIContactObserverManager sharedManager] registerListObjectObserver:self];
+
+	[passes addObject:[self passMinutesPerContact]];
+	[passes addObject:[self passMinutesOnTheClock]];
+
+	[[AIContactObserverManager sharedManager] unregisterListObjectObserver:self];
+
+	[self checkContacts];
+
+	[account disconnect];
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:contactCount], KEY_IDLE_TIME_REPORT_CONTACTS,
+			[NSNumber numberWithUnsignedInteger:visibleRowCount], KEY_IDLE_TIME_REPORT_VISIBLE_ROWS,
+			[NSNumber numberWithUnsignedInteger:minuteCount], KEY_IDLE_TIME_REPORT_MINUTES,
+			passes, KEY_IDLE_TIME_REPORT_PASSES,
+			[[mismatches copy] autorelease], KEY_IDLE_TIME_REPORT_MISMATCHES,
+			nil];
+}
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSArray			*reportMismatches = [report objectForKey:KEY_IDLE_TIME_REPORT_MISMATCHES];
+
+	[description appendFormat:@"Idle contacts: %@, visible rows: %@, minutes: %@\n",
+	 [report objectForKey:KEY_IDLE_TIME_REPORT_CONTACTS], [report objectForKey:KEY_IDLE_TIME_REPORT_VISIBLE_ROWS],
+	 [report objectForKey:KEY_IDLE_TIME_REPORT_MINUTES]];
+
+	for (NSDictionary *pass in [report objectForKey:KEY_IDLE_TIME_REPORT_PASSES]) {
+		[description appendFormat:@"%@: %@ observer notifications, %@ rows laid out, %@ rows redrawn, "
+		 @"%@ idle strings, %.3f s\n",
+		 [pass objectForKey:KEY_IDLE_TIME_PASS_NAME],
+		 [pass objectForKey:KEY_IDLE_TIME_PASS_NOTIFICATIONS], [pass objectForKey:KEY_IDLE_TIME_PASS_LAYOUTS],
+		 [pass objectForKey:KEY_IDLE_TIME_PASS_REDRAWS], [pass objectForKey:KEY_IDLE_TIME_PASS_STRINGS],
+		 [[pass objectForKey:KEY_IDLE_TIME_PASS_SECONDS] doubleValue]];
+	}
+
+	[description appendFormat:@"Mismatches: %lu\n", (unsigned long)reportMismatches.count];
+
+	for (NSUInteger i = 0; i < reportMismatches.count && i < MAX_REPORTED_MISMATCHES; i++) {
+		[description appendFormat:@"  %@\n", [reportMismatches objectAtIndex:i]];
+	}
+
+	return description;
+}
+
+@end
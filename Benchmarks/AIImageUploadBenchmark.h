@@ -0,0 +1,73 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+#import <AIUtilities/AIProgressDataUploader.h>
+
+//Report keys
+#define KEY_UPLOAD_REPORT_IMAGES			@"Images"
+#define KEY_UPLOAD_REPORT_MAXIMUM_SIZE		@"Maximum Size"
+#define KEY_UPLOAD_REPORT_URL				@"URL"
+#define KEY_UPLOAD_REPORT_BYTES				@"Bytes"
+#define KEY_UPLOAD_REPORT_LEGACY_BYTES		@"Legacy Bytes"
+#define KEY_UPLOAD_REPORT_STALL				@"Longest Main Thread Stall"
+#define KEY_UPLOAD_REPORT_LEGACY_STALL		@"Longest Legacy Main Thread Stall"
+#define KEY_UPLOAD_REPORT_PEAK_RSS			@"Peak RSS Growth"
+#define KEY_UPLOAD_REPORT_LEGACY_PEAK_RSS	@"Legacy Peak RSS Growth"
+#define KEY_UPLOAD_REPORT_MISMATCHES		@"Mismatches"
+#define KEY_UPLOAD_REPORT_OPERATIONS		@"Operations"
+
+/*!
+ * @class AIImageUploadBenchmark
+ * @brief Prepares large screenshots for upload with AIImageTranscoder and AIMultipartFormBody, and the way
+ * AIGenericMultipartImageUploader used to, on the main thread
+ *
+ * imageCount Retina-sized synthetic screenshots are each encoded to fit maximumSize and turned into a multipart
+ * body, which is uploaded to uploadURL (e.g. Utilities/ImageUploadStubServer.py) if one is set, or read to its
+ * end otherwise. The longest the main thread went without getting back to its run loop is measured for both.
+ * The streamed pipeline runs first, so each peak RSS growth is over the peak of everything before it.
+ *
+ * While -AIImageUploadBenchmarkURL is set, images uploaded to chats are sent there too instead of to their service.
+ *
+ * Run with -AIImageUploadBenchmark YES. Settings:
+ *	-AIImageUploadBenchmarkImages <n>	Screenshots to prepare (3)
+ *	-AIImageUploadBenchmarkURL <URL>	Where to upload them, if set; see Utilities/ImageUploadStubServer.py
+ *	-AIContactListBenchmarkSeed <n>		Seed for the random choices (1)
+ */
+@interface AIImageUploadBenchmark : NSObject <AIBenchmark, AIProgressDataUploaderDelegate> {
+	NSUInteger			imageCount;
+	NSUInteger			maximumSize;
+	NSString			*uploadURL;
+	uint32_t			seed;
+
+	NSMutableArray		*mismatches;
+	NSData				*uploadResult;
+	BOOL				uploadFinished;
+	NSTimer				*tickTimer;
+	uint64_t			lastTick;
+	uint64_t			longestTickGap;
+}
+
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger imageCount;
+@property (readwrite, nonatomic) NSUInteger maximumSize;
+@property (readwrite, copy, nonatomic) NSString *uploadURL;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
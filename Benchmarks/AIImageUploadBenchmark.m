@@ -0,0 +1,552 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIImageUploadBenchmark.h"
+#import <AIUtilities/AIImageTranscoder.h>
+#import <AIUtilities/AIMultipartFormBody.h>
+#import <AIUtilities/AIImageAdditions.h>
+#import <mach/mach_time.h>
+#import <sys/resource.h>
+#import <objc/runtime.h>
+
+//Settings
+#define KEY_UPLOAD_BENCHMARK_IMAGES			@"AIImageUploadBenchmarkImages"
+#define KEY_UPLOAD_BENCHMARK_URL			@"AIImageUploadBenchmarkURL"
+
+//A Retina screenshot
+#define IMAGE_WIDTH					2880
+#define IMAGE_HEIGHT				1800
+
+#define MULTIPART_FORM_BOUNDARY		@"bf5faadd239c17e35f91e6dafe1d2f96"
+#define FIELD_NAME					@"image"
+#define KEY_FIELD_NAME				@"key"
+#define KEY_FIELD_VALUE				@"AIImageUploadBenchmark"
+
+//How often the main thread is expected back at its run loop while waiting
+#define TICK_INTERVAL				0.001
+//How long to wait for a transcoding or an upload
+#define TIMEOUT						120.0
+//How many mismatches are described in the report
+#define MAX_REPORTED_MISMATCHES		20
+
+//Where image uploads from chats are redirected, if anywhere
+static NSString *redirectedUploadURL = nil;
+
+/*!
+ * @brief Replaces -uploadURL in every image uploader once uploads are redirected
+ */
+static NSString *redirectedUploadURLMethod(id self, SEL _cmd)
+{
+	return redirectedUploadURL;
+}
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+static void addCost(NSMutableDictionary *costs, NSString *costName, NSUInteger count, uint64_t machTime)
+{
+	[costs setObject:[NSDictionary dictionaryWithObjectsAndKeys:
+					  [NSNumber numberWithUnsignedInteger:count], @"Count",
+					  [NSNumber numberWithDouble:secondsFromMachTime(machTime)], @"Seconds",
+					  nil]
+			  forKey:costName];
+}
+
+/*!
+ * @brief The process's peak resident set size so far, in bytes
+ */
+static unsigned long long peakResidentSize(void)
+{
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	return (unsigned long long)usage.ru_maxrss;
+}
+
+/*!
+ * @brief A synthetic screenshot: a flat window background, lines of "text", and a photo of noise a quarter of the screen
+ */
+static NSImage *newScreenshot(uint32_t *state)
+{
+	NSBitmapImageRep	*rep = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+																	 pixelsWide:IMAGE_WIDTH
+																	 pixelsHigh:IMAGE_HEIGHT
+																  bitsPerSample:8
+																samplesPerPixel:4
+																	   hasAlpha:YES
+																	   isPlanar:NO
+																 colorSpaceName:NSDeviceRGBColorSpace
+																	bytesPerRow:IMAGE_WIDTH * 4
+																   bitsPerPixel:32];
+	uint8_t				*pixels = [rep bitmapData];
+	NSUInteger			photoX = nextRandom(state) % (IMAGE_WIDTH / 2), photoY = nextRandom(state) % (IMAGE_HEIGHT / 2);
+	uint8_t				background = 0xE0 + nextRandom(state) % 0x20;
+	NSUInteger			x, y;
+
+	for (y = 0; y < IMAGE_HEIGHT; y++) {
+		BOOL textLine = (y % 24 >= 6 && y % 24 < 18);
+
+		for (x = 0; x < IMAGE_WIDTH; x++) {
+			uint8_t *pixel = pixels + (y * IMAGE_WIDTH + x) * 4;
+
+			if (x >= photoX && x < photoX + IMAGE_WIDTH / 2 && y >= photoY && y < photoY + IMAGE_HEIGHT / 2) {
+				uint32_t random = nextRandom(state);
+				pixel[0] = random; pixel[1] = random >> 8; pixel[2] = random >> 16;
+			} else if (textLine && nextRandom(state) % 3 == 0) {
+				pixel[0] = pixel[1] = pixel[2] = 0x20;
+			} else {
+				pixel[0] = pixel[1] = pixel[2] = background;
+			}
+			pixel[3] = 0xFF;
+		}
+	}
+
+	NSImage *image = [[NSImage alloc] initWithSize:NSMakeSize(IMAGE_WIDTH, IMAGE_HEIGHT)];
+	[image addRepresentation:rep];
+	[rep release];
+
+	return image;
+}
+
+@interface AIImageUploadBenchmark ()
+- (void)startTicking;
+- (uint64_t)stopTicking;
+- (void)tick:(NSTimer *)timer;
+- (BOOL)waitUntil:(BOOL (^)(void))condition;
+- (NSData *)legacyBodyForImage:(NSImage *)image;
+- (NSData *)upload:(AIProgressDataUploader *)dataUploader;
+- (unsigned long long)readStream:(NSInputStream *)stream;
+@end
+
+@implementation AIImageUploadBenchmark
+
+/*!
+ * @brief Send images uploaded to chats to the benchmark's upload URL too, if one is set
+ *
+ * This lets Utilities/ImageUploadStubServer.py stand in for the real services without the image uploaders knowing
+ * about it. Only builds with this plugin installed are affected.
+ */
++ (void)load
+{
+	NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+	Class				genericUploaderClass = NSClassFromString(@"AIGenericMultipartImageUploader");
+	NSString			*URL = [[NSUserDefaults standardUserDefaults] stringForKey:KEY_UPLOAD_BENCHMARK_URL];
+
+	if (URL && genericUploaderClass) {
+		int		classCount = objc_getClassList(NULL, 0);
+		Class	*classes = malloc(sizeof(Class) * classCount);
+		int		i;
+
+		redirectedUploadURL = [URL copy];
+
+		classCount = objc_getClassList(classes, classCount);
+		for (i = 0; i < classCount; i++) {
+			Class superclass = class_getSuperclass(classes[i]);
+
+			while (superclass && superclass != genericUploaderClass) superclass = class_getSuperclass(superclass);
+			if (!superclass) continue;
+
+			Method uploadURLMethod = class_getInstanceMethod(classes[i], @selector(uploadURL));
+			class_replaceMethod(classes[i], @selector(uploadURL), (IMP)redirectedUploadURLMethod, method_getTypeEncoding(uploadURLMethod));
+		}
+
+		free(classes);
+	}
+
+	[pool release];
+}
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:3], KEY_UPLOAD_BENCHMARK_IMAGES,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AIImageUploadBenchmark *benchmark = [[[self alloc] init] autorelease];
+
+	benchmark.imageCount = [defaults integerForKey:KEY_UPLOAD_BENCHMARK_IMAGES];
+	benchmark.uploadURL = [defaults stringForKey:KEY_UPLOAD_BENCHMARK_URL];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (id)init
+{
+	if ((self = [super init])) {
+		imageCount = 3;
+		maximumSize = 2500000;
+		seed = 1;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[uploadURL release];
+	[mismatches release];
+	[uploadResult release];
+
+	[super dealloc];
+}
+
+@synthesize imageCount, maximumSize, uploadURL, seed;
+
+- (NSDictionary *)run
+{
+	NSMutableDictionary		*costs = [NSMutableDictionary dictionary];
+	NSMutableArray			*images = [NSMutableArray array];
+	NSDictionary			*headers;
+	uint32_t				state = seed;
+	uint64_t				start, transcodeTime = 0, streamTime = 0, legacyTime = 0, legacyUploadTime = 0;
+	uint64_t				stall = 0, legacyStall = 0;
+	unsigned long long		bytes = 0, legacyBytes = 0, peakBefore, peakAfterStreamed;
+	NSUInteger				i;
+
+	[mismatches release]; mismatches = [[NSMutableArray alloc] init];
+
+	for (i = 0; i < imageCount; i++) {
+		NSImage *image = newScreenshot(&state);
+		[images addObject:image];
+		[image release];
+	}
+
+	peakBefore = peakResidentSize();
+
+	//The streamed pipeline, as AIGenericMultipartImageUploader uploads now
+	for (NSImage *image in images) {
+		NSAutoreleasePool			*pool = [[NSAutoreleasePool alloc] init];
+		AIImageTranscoder			*transcoder = [[[AIImageTranscoder alloc] init] autorelease];
+		__block NSString			*path = nil, *MIMEType = nil;
+		__block unsigned long long	length = 0;
+		__block BOOL				transcoded = NO;
+
+		[self startTicking];
+
+		start = mach_absolute_time();
+		transcoder.maximumFileSize = maximumSize;
+		[transcoder transcodeImage:[[image largestBitmapImageRep] CGImage]
+						completion:^(NSString *inPath, NSString *inMIMEType, unsigned long long inLength, NSError *error) {
+			path = [inPath retain];
+			MIMEType = [inMIMEType retain];
+			length = inLength;
+			transcoded = YES;
+		}];
+		if (![self waitUntil:^{ return transcoded; }]) [mismatches addObject:@"Transcoding timed out"];
+		transcodeTime += mach_absolute_time() - start;
+
+		if (!path) {
+			[mismatches addObject:@"An image could not be transcoded"];
+		} else {
+			AIMultipartFormBody *body = [[[AIMultipartFormBody alloc] initWithBoundary:MULTIPART_FORM_BOUNDARY] autorelease];
+
+			if (length > maximumSize) {
+				[mismatches addObject:[NSString stringWithFormat:@"A %@ of %llu bytes is over the maximum", MIMEType, length]];
+			}
+
+			[body addFieldWithName:KEY_FIELD_NAME value:KEY_FIELD_VALUE];
+			[body addFileAtPath:path name:FIELD_NAME fileName:@"image" contentType:MIMEType];
+			headers = [NSDictionary dictionaryWithObject:body.contentType forKey:@"Content-type"];
+
+			start = mach_absolute_time();
+			if (uploadURL) {
+				NSData *result = [self upload:[AIProgressDataUploader dataUploaderWithStream:[body inputStream]
+																					  length:body.contentLength
+																						 URL:[NSURL URLWithString:uploadURL]
+																					 headers:headers
+																					delegate:self
+																					 context:nil]];
+				NSString *response = (result ? [[[NSString alloc] initWithData:result encoding:NSUTF8StringEncoding] autorelease] : nil);
+
+				if ([response rangeOfString:@"stat=\"ok\""].location == NSNotFound) {
+					[mismatches addObject:[NSString stringWithFormat:@"The server did not accept a streamed body: %@", response]];
+				}
+			} else {
+				unsigned long long streamed = [self readStream:[body inputStream]];
+
+				if (streamed != body.contentLength) {
+					[mismatches addObject:[NSString stringWithFormat:@"Streamed %llu bytes of a %llu byte body", streamed, body.contentLength]];
+				}
+			}
+			streamTime += mach_absolute_time() - start;
+			bytes += body.contentLength;
+
+			[[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+		}
+
+		stall = MAX(stall, [self stopTicking]);
+
+		[path release];
+		[MIMEType release];
+		[pool release];
+	}
+
+	peakAfterStreamed = peakResidentSize();
+
+	//The old way: everything up to the upload itself on the main thread, the body built in memory
+	for (NSImage *image in images) {
+		NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+		uint64_t			elapsed;
+
+		start = mach_absolute_time();
+		NSData *body = [self legacyBodyForImage:image];
+		elapsed = mach_absolute_time() - start;
+		legacyTime += elapsed;
+		legacyStall = MAX(legacyStall, elapsed);
+
+		if (!body) {
+			[mismatches addObject:@"An image could not be encoded the old way"];
+		} else {
+			legacyBytes += body.length;
+
+			if (uploadURL) {
+				headers = [NSDictionary dictionaryWithObject:[NSString stringWithFormat:@"multipart/form-data; boundary=%@", MULTIPART_FORM_BOUNDARY]
+													  forKey:@"Content-type"];
+
+				[self startTicking];
+				start = mach_absolute_time();
+				[self upload:[AIProgressDataUploader dataUploaderWithData:body
+																	  URL:[NSURL URLWithString:uploadURL]
+																  headers:headers
+																 delegate:self
+																  context:nil]];
+				legacyUploadTime += mach_absolute_time() - start;
+				legacyStall = MAX(legacyStall, [self stopTicking]);
+			}
+		}
+
+		[pool release];
+	}
+
+	addCost(costs, @"Streamed: transcode in the background", imageCount, transcodeTime);
+	addCost(costs, (uploadURL ? @"Streamed: upload" : @"Streamed: read the body"), imageCount, streamTime);
+	addCost(costs, @"Legacy: encode and build the body on the main thread", imageCount, legacyTime);
+	if (uploadURL) addCost(costs, @"Legacy: upload", imageCount, legacyUploadTime);
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:imageCount], KEY_UPLOAD_REPORT_IMAGES,
+			[NSNumber numberWithUnsignedInteger:maximumSize], KEY_UPLOAD_REPORT_MAXIMUM_SIZE,
+			(uploadURL ? uploadURL : @""), KEY_UPLOAD_REPORT_URL,
+			[NSNumber numberWithUnsignedLongLong:bytes], KEY_UPLOAD_REPORT_BYTES,
+			[NSNumber numberWithUnsignedLongLong:legacyBytes], KEY_UPLOAD_REPORT_LEGACY_BYTES,
+			[NSNumber numberWithDouble:secondsFromMachTime(stall)], KEY_UPLOAD_REPORT_STALL,
+			[NSNumber numberWithDouble:secondsFromMachTime(legacyStall)], KEY_UPLOAD_REPORT_LEGACY_STALL,
+			[NSNumber numberWithUnsignedLongLong:peakAfterStreamed - peakBefore], KEY_UPLOAD_REPORT_PEAK_RSS,
+			[NSNumber numberWithUnsignedLongLong:peakResidentSize() - peakAfterStreamed], KEY_UPLOAD_REPORT_LEGACY_PEAK_RSS,
+			mismatches, KEY_UPLOAD_REPORT_MISMATCHES,
+			costs, KEY_UPLOAD_REPORT_OPERATIONS,
+			nil];
+}
+
+#pragma mark Main thread stalls
+
+/*!
+ * @brief Start noting how long the main thread goes between visits to its run loop
+ */
+- (void)startTicking
+{
+	NSTimer *timer = [NSTimer timerWithTimeInterval:TICK_INTERVAL target:self selector:@selector(tick:) userInfo:nil repeats:YES];
+
+	[[NSRunLoop currentRunLoop] addTimer:timer forMode:NSRunLoopCommonModes];
+	lastTick = mach_absolute_time();
+	longestTickGap = 0;
+	tickTimer = timer;
+}
+
+/*!
+ * @result The longest the main thread went without firing the timer
+ */
+- (uint64_t)stopTicking
+{
+	[self tick:nil];
+	[tickTimer invalidate]; tickTimer = nil;
+
+	return longestTickGap;
+}
+
+- (void)tick:(NSTimer *)timer
+{
+	uint64_t now = mach_absolute_time();
+
+	longestTickGap = MAX(longestTickGap, now - lastTick);
+	lastTick = now;
+}
+
+- (BOOL)waitUntil:(BOOL (^)(void))condition
+{
+	NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:TIMEOUT];
+
+	while (!condition() && [deadline timeIntervalSinceNow] > 0) {
+		[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:TICK_INTERVAL]];
+	}
+
+	return condition();
+}
+
+#pragma mark Bodies
+
+/*!
+ * @brief The body as AIGenericMultipartImageUploader used to build it
+ */
+- (NSData *)legacyBodyForImage:(NSImage *)image
+{
+	NSMutableData			*body = [NSMutableData data];
+	NSBitmapImageFileType	bestType;
+	NSData					*pngRepresentation = [[image largestBitmapImageRep] representationUsingType:NSPNGFileType properties:@{}];
+	NSData					*jpgRepresentation = [[image largestBitmapImageRep] representationUsingType:NSJPEGFileType properties:@{}];
+	NSData					*imageRepresentation;
+
+	if (pngRepresentation.length > jpgRepresentation.length) {
+		bestType = NSJPEGFileType;
+		imageRepresentation = jpgRepresentation;
+	} else {
+		bestType = NSPNGFileType;
+		imageRepresentation = pngRepresentation;
+	}
+
+	if (imageRepresentation.length > maximumSize) {
+		imageRepresentation = [image representationWithFileType:bestType maximumFileSize:maximumSize];
+	}
+
+	if (!imageRepresentation) return nil;
+
+	[body appendData:[[NSString stringWithFormat:@"--%@\r\n", MULTIPART_FORM_BOUNDARY] dataUsingEncoding:NSUTF8StringEncoding]];
+	[body appendData:[[NSString stringWithFormat:@"Content-Disposition: form-data; name=\"%@\"; filename=\"image\"\r\n", FIELD_NAME] dataUsingEncoding:NSUTF8StringEncoding]];
+	[body appendData:[[NSString stringWithFormat:@"Content-Type: %@\r\n\r\n", (bestType == NSJPEGFileType) ? @"image/jpeg" : @"image/png"] dataUsingEncoding:NSUTF8StringEncoding]];
+	[body appendData:imageRepresentation];
+	[body appendData:[[NSString stringWithFormat:@"\r\n--%@--\r\n", MULTIPART_FORM_BOUNDARY] dataUsingEncoding:NSUTF8StringEncoding]];
+	[body appendData:[[NSString stringWithFormat:@"--%@\r\n", MULTIPART_FORM_BOUNDARY] dataUsingEncoding:NSUTF8StringEncoding]];
+	[body appendData:[[NSString stringWithFormat:@"Content-Disposition: form-data; name= \"%@\"\r\n\r\n", KEY_FIELD_NAME] dataUsingEncoding:NSUTF8StringEncoding]];
+	[body appendData:[KEY_FIELD_VALUE dataUsingEncoding:NSUTF8StringEncoding]];
+
+	return body;
+}
+
+/*!
+ * @brief Read a stream to its end on the main thread, as CFNetwork would while sending it
+ */
+- (unsigned long long)readStream:(NSInputStream *)stream
+{
+	unsigned long long	length = 0;
+	uint8_t				buffer[65536];
+	NSDate				*deadline = [NSDate dateWithTimeIntervalSinceNow:TIMEOUT];
+
+	[stream open];
+	while ([stream streamStatus] != NSStreamStatusAtEnd && [stream streamStatus] != NSStreamStatusError &&
+		   [deadline timeIntervalSinceNow] > 0) {
+		if ([stream hasBytesAvailable]) {
+			NSInteger bytesRead = [stream read:buffer maxLength:sizeof(buffer)];
+			if (bytesRead > 0) length += bytesRead;
+		} else {
+			[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:TICK_INTERVAL]];
+		}
+	}
+	[stream close];
+
+	return length;
+}
+
+#pragma mark Uploading
+
+/*!
+ * @result What the server answered, or nil if the upload failed
+ */
+- (NSData *)upload:(AIProgressDataUploader *)dataUploader
+{
+	[uploadResult release]; uploadResult = nil;
+	uploadFinished = NO;
+
+	[dataUploader upload];
+	if (![self waitUntil:^{ return uploadFinished; }]) {
+		[dataUploader cancel];
+		[mismatches addObject:@"An upload timed out"];
+	}
+
+	return [[uploadResult retain] autorelease];
+}
+
+- (void)updateUploadProgress:(NSUInteger)uploaded total:(NSUInteger)total context:(id)context
+{
+}
+
+- (void)uploadCompleted:(id)context result:(NSData *)result
+{
+	uploadResult = [result copy];
+	uploadFinished = YES;
+}
+
+- (void)uploadFailed:(id)context
+{
+	uploadFinished = YES;
+}
+
+#pragma mark Report
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSDictionary	*costs = [report objectForKey:KEY_UPLOAD_REPORT_OPERATIONS];
+	NSArray			*reportMismatches = [report objectForKey:KEY_UPLOAD_REPORT_MISMATCHES];
+	NSString		*url = [report objectForKey:KEY_UPLOAD_REPORT_URL];
+
+	[description appendFormat:@"Images: %@ at %dx%d, maximum size: %@ bytes, %@\n",
+	 [report objectForKey:KEY_UPLOAD_REPORT_IMAGES], IMAGE_WIDTH, IMAGE_HEIGHT, [report objectForKey:KEY_UPLOAD_REPORT_MAXIMUM_SIZE],
+	 (url.length ? [NSString stringWithFormat:@"uploaded to %@", url] : @"bodies read locally")];
+	[description appendFormat:@"Body bytes: %@ streamed, %@ legacy\n",
+	 [report objectForKey:KEY_UPLOAD_REPORT_BYTES], [report objectForKey:KEY_UPLOAD_REPORT_LEGACY_BYTES]];
+	[description appendFormat:@"Longest main thread stall: %.1f ms streamed, %.1f ms legacy\n",
+	 [[report objectForKey:KEY_UPLOAD_REPORT_STALL] doubleValue] * 1000.0, [[report objectForKey:KEY_UPLOAD_REPORT_LEGACY_STALL] doubleValue] * 1000.0];
+	[description appendFormat:@"Peak RSS growth: %.1f MB streamed, then %.1f MB more legacy\n",
+	 [[report objectForKey:KEY_UPLOAD_REPORT_PEAK_RSS] doubleValue] / 1048576.0,
+	 [[report objectForKey:KEY_UPLOAD_REPORT_LEGACY_PEAK_RSS] doubleValue] / 1048576.0];
+	[description appendFormat:@"Mismatches: %lu\n", (unsigned long)reportMismatches.count];
+
+	for (NSUInteger i = 0; i < reportMismatches.count && i < MAX_REPORTED_MISMATCHES; i++) {
+		[description appendFormat:@"  %@\n", [reportMismatches objectAtIndex:i]];
+	}
+
+	[description appendString:@"\n"];
+	for (NSString *name in [[costs allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		NSDictionary	*cost = [costs objectForKey:name];
+		NSUInteger		count = [[cost objectForKey:@"Count"] unsignedIntegerValue];
+		double			seconds = [[cost objectForKey:@"Seconds"] doubleValue];
+
+		[description appendFormat:@"  %-50s %8lu  %9.3f s  %10.3f us each\n",
+		 [name UTF8String], (unsigned long)count, seconds, (count ? seconds * USEC_PER_SEC / count : 0.0)];
+	}
+
+	return description;
+}
+
+@end
@@ -0,0 +1,68 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+
+@class AIBenchmarkAccount;
+
+//Report keys
+#define KEY_TAIL_REPORT_CHATS				@"Chats"
+#define KEY_TAIL_REPORT_LOG_BYTES			@"Log Bytes Per Chat"
+#define KEY_TAIL_REPORT_LINES				@"Lines"
+#define KEY_TAIL_REPORT_TIMES				@"Times"
+#define KEY_TAIL_REPORT_CHECKS				@"Checks"
+#define KEY_TAIL_REPORT_MISMATCHES			@"Mismatches"
+#define KEY_TAIL_REPORT_HITS_AFTER_LOGGING	@"Cache Hits After Logging"
+
+/*!
+ * @class AIMessageTailCacheBenchmark
+ * @brief Times message history for chats with large logs, from the logs and from the message tail cache
+ *
+ * Each chat is given logs of about the configured size, written straight into the logs folder. Message history is
+ * then read for every chat by parsing the logs with LMX, as DCMessageContextDisplayPlugin used to on every chat
+ * open, and through the tail cache, both before and after its entries are filled. Every cached result is compared
+ * with the parsed one.
+ *
+ * Messages are then received in every chat, so the logger writes them and updates the cache, and the comparison
+ * is made again.
+ *
+ * Run with -AIMessageTailCacheBenchmark YES. Settings:
+ *	-AIMessageTailCacheBenchmarkChats <n>			Chats to write logs for (500)
+ *	-AIMessageTailCacheBenchmarkLogKilobytes <n>	Size of each chat's logs (2048)
+ *	-AIContactListBenchmarkSeed <n>					Seed for the random choices (1)
+ */
+@interface AIMessageTailCacheBenchmark : NSObject <AIBenchmark> {
+	AIBenchmarkAccount	*account;
+
+	NSUInteger			chatCount;
+	NSUInteger			logKilobytes;
+	uint32_t			seed;
+
+	NSMutableDictionary	*times;
+	NSMutableArray		*mismatches;
+	NSUInteger			checkCount;
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount;
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger chatCount;
+@property (readwrite, nonatomic) NSUInteger logKilobytes;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
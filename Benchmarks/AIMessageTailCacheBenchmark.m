@@ -0,0 +1,392 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIMessageTailCacheBenchmark.h"
+#import "AIBenchmarkAccount.h"
+#import "AILoggerPlugin.h"
+#import "AIMessageTailCache.h"
+#import "DCMessageContextDisplayPlugin.h"
+#import <Adium/AIAccount.h>
+#import <Adium/AIChat.h>
+#import <Adium/AIChatControllerProtocol.h>
+#import <Adium/AIContentObject.h>
+#import <Adium/AIListContact.h>
+#import <Adium/AIService.h>
+#import <Adium/AIXMLByteBuffer.h>
+#import <Adium/AIXMLElement.h>
+#import <AIUtilities/AISharedWriterQueue.h>
+#import <AIUtilities/AIStringAdditions.h>
+#import <AIUtilities/AITimestampCodec.h>
+#import <mach/mach_time.h>
+
+//Settings
+#define KEY_TAIL_BENCHMARK_CHATS			@"AIMessageTailCacheBenchmarkChats"
+#define KEY_TAIL_BENCHMARK_LOG_KILOBYTES	@"AIMessageTailCacheBenchmarkLogKilobytes"
+
+//Each chat's history is split over this many logs, so reading it has to go from one log to the next
+#define LOGS_PER_CHAT				2
+//Every so many elements logged is a status rather than a message
+#define STATUS_INTERVAL				7
+//How far apart the logged messages are, in seconds
+#define MESSAGE_SPACING				30.0
+//How many messages are received in each chat once the logs are cached
+#define RECEIVED_MESSAGES_PER_CHAT	3
+//How long to let received messages make their way through the content controller to the logger
+#define RECEIVE_SETTLE_TIME			2.0
+//Buffered log bytes are written out once there are this many
+#define LOG_WRITE_SIZE				(64 * 1024)
+//How many mismatches are described in the report
+#define MAX_REPORTED_MISMATCHES		20
+
+static const char *words[] = {
+	"adium", "chat", "release", "build", "beta", "status", "contact", "message", "window", "theme",
+	"xtras", "bonjour", "jabber", "otr", "log", "transcript", "icon", "dock", "growl", "sound"
+};
+
+@interface AIMessageTailCacheBenchmark ()
+- (void)writeLogsForChat:(AIChat *)chat state:(uint32_t *)state;
+- (NSArray *)time:(NSString *)name chats:(NSArray *)chats reading:(NSArray * (^)(AIChat *chat))readBlock;
+- (void)compare:(NSArray *)results with:(NSArray *)expectedResults chats:(NSArray *)chats named:(NSString *)name;
+@end
+
+/*!
+ * @brief The same generator as AIContactListTrace's, so a seed gives the same logs everywhere
+ */
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+/*!
+ * @brief A description of a content object detailed enough to tell two apart
+ */
+static NSString *describeContent(AIContentObject *content)
+{
+	return [NSString stringWithFormat:@"%@ %@ from %@: %@", NSStringFromClass([content class]), content.date,
+			content.source.UID, content.message];
+}
+
+@implementation AIMessageTailCacheBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:500], KEY_TAIL_BENCHMARK_CHATS,
+			[NSNumber numberWithUnsignedInteger:2048], KEY_TAIL_BENCHMARK_LOG_KILOBYTES,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AIMessageTailCacheBenchmark *benchmark = [[[self alloc] initWithAccount:[AIBenchmarkAccount addTemporaryAccountWithUID:BENCHMARK_ACCOUNT_UID]] autorelease];
+
+	benchmark.chatCount = [defaults integerForKey:KEY_TAIL_BENCHMARK_CHATS];
+	benchmark.logKilobytes = [defaults integerForKey:KEY_TAIL_BENCHMARK_LOG_KILOBYTES];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (void)deleteAccounts
+{
+	[account deleteTemporaryAccount];
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount
+{
+	if ((self = [super init])) {
+		account = [inAccount retain];
+		chatCount = 500;
+		logKilobytes = 2048;
+		seed = 1;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[account release];
+	[times release];
+	[mismatches release];
+
+	[super dealloc];
+}
+
+@synthesize chatCount, logKilobytes, seed;
+
+/*!
+ * @brief Write the logs, read every chat's history each way, log some more, compare again, and report
+ */
+- (NSDictionary *)run
+{
+	DCMessageContextDisplayPlugin	*contextPlugin = [DCMessageContextDisplayPlugin sharedInstance];
+	AIMessageTailCache				*tailCache = [AILoggerPlugin messageTailCache];
+	NSInteger						lines = tailCache.capacity;
+	NSMutableArray					*chats = [NSMutableArray arrayWithCapacity:chatCount];
+	uint32_t						state = seed;
+	NSUInteger						i;
+
+	[times release]; times = [[NSMutableDictionary alloc] init];
+	[mismatches release]; mismatches = [[NSMutableArray alloc] init];
+	checkCount = 0;
+
+	uint64_t writeStart = mach_absolute_time();
+	for (i = 0; i < chatCount; i++) {
+		NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+		AIListContact		*listContact = [account contactWithUID:[NSString stringWithFormat:@"tail%lu", (unsigned long)i]];
+		AIChat				*chat = [adium.chatController chatWithContact:listContact];
+
+		if (chat) {
+			[chats addObject:chat];
+			[tailCache removeRecordsForKey:[AILoggerPlugin relativePathForLogsLikeChat:chat]];
+			[self writeLogsForChat:chat state:&state];
+		}
+		[pool release];
+	}
+	[AISharedWriterQueue waitUntilAllOperationsAreFinished];
+	[times setObject:[NSNumber numberWithDouble:secondsFromMachTime(mach_absolute_time() - writeStart)] forKey:@"Writing logs"];
+
+	NSArray *parsed = [self time:@"Parsing logs" chats:chats reading:^(AIChat *chat) {
+		return [contextPlugin contextFromLogsForChat:chat lines:lines alsoStatus:NO];
+	}];
+	NSArray *filled = [self time:@"Filling the cache" chats:chats reading:^(AIChat *chat) {
+		return [contextPlugin contextForChat:chat lines:lines alsoStatus:NO];
+	}];
+	NSArray *cached = [self time:@"Reading the cache" chats:chats reading:^(AIChat *chat) {
+		return [contextPlugin contextForChat:chat lines:lines alsoStatus:NO];
+	}];
+	[self compare:filled with:parsed chats:chats named:@"filling"];
+	[self compare:cached with:parsed chats:chats named:@"cached"];
+
+	//The last activity in a chat, as the chat controller asks for it, statuses included
+	NSArray *parsedActivity = [self time:@"Parsing logs for last activity" chats:chats reading:^(AIChat *chat) {
+		return [contextPlugin contextFromLogsForChat:chat lines:1 alsoStatus:YES];
+	}];
+	NSArray *cachedActivity = [self time:@"Reading the cache for last activity" chats:chats reading:^(AIChat *chat) {
+		return [contextPlugin contextForChat:chat lines:1 alsoStatus:YES];
+	}];
+	[self compare:cachedActivity with:parsedActivity chats:chats named:@"last activity"];
+
+	//Log some more through the logger, which keeps the cache up to date as it goes
+	for (i = 0; i < RECEIVED_MESSAGES_PER_CHAT; i++) {
+		for (AIChat *chat in chats) {
+			[account receiveMessage:[NSString stringWithFormat:@"%s & %s %lu", words[nextRandom(&state) % 20], words[nextRandom(&state) % 20], (unsigned long)i]
+				 fromContactWithUID:chat.listObject.UID
+							deliver:YES];
+		}
+	}
+	[[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:RECEIVE_SETTLE_TIME]];
+	[AISharedWriterQueue waitUntilAllOperationsAreFinished];
+
+	NSUInteger hitsAfterLogging = 0;
+	for (AIChat *chat in chats) {
+		if ([tailCache recordsForKey:[AILoggerPlugin relativePathForLogsLikeChat:chat] lines:lines alsoStatus:NO])
+			hitsAfterLogging++;
+	}
+
+	NSArray *parsedAfterLogging = [self time:@"Parsing logs after logging" chats:chats reading:^(AIChat *chat) {
+		return [contextPlugin contextFromLogsForChat:chat lines:lines alsoStatus:NO];
+	}];
+	NSArray *cachedAfterLogging = [self time:@"Reading the cache after logging" chats:chats reading:^(AIChat *chat) {
+		return [contextPlugin contextForChat:chat lines:lines alsoStatus:NO];
+	}];
+	[self compare:cachedAfterLogging with:parsedAfterLogging chats:chats named:@"after logging"];
+
+	for (AIChat *chat in chats) {
+		[adium.chatController closeChat:chat];
+	}
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:chats.count], KEY_TAIL_REPORT_CHATS,
+			[NSNumber numberWithUnsignedInteger:logKilobytes * 1024], KEY_TAIL_REPORT_LOG_BYTES,
+			[NSNumber numberWithInteger:lines], KEY_TAIL_REPORT_LINES,
+			[[times copy] autorelease], KEY_TAIL_REPORT_TIMES,
+			[NSNumber numberWithUnsignedInteger:checkCount], KEY_TAIL_REPORT_CHECKS,
+			[[mismatches copy] autorelease], KEY_TAIL_REPORT_MISMATCHES,
+			[NSNumber numberWithUnsignedInteger:hitsAfterLogging], KEY_TAIL_REPORT_HITS_AFTER_LOGGING,
+			nil];
+}
+
+/*!
+ * @brief Write a chat's logs, as the logger would have, ending a day ago
+ */
+- (void)writeLogsForChat:(AIChat *)chat state:(uint32_t *)state
+{
+	AITimestampCodec		*formatter = [[[AITimestampCodec alloc] init] autorelease];
+	AIXMLByteBuffer			*buffer = [[[AIXMLByteBuffer alloc] initWithCapacity:LOG_WRITE_SIZE * 2] autorelease];
+	NSString				*folderPath = [[AILoggerPlugin logBasePath] stringByAppendingPathComponent:[AILoggerPlugin relativePathForLogsLikeChat:chat]];
+	NSString				*objectUID = [chat.listObject.UID safeFilenameString];
+	NSUInteger				bytesPerLog = logKilobytes * 1024 / LOGS_PER_CHAT;
+	NSUInteger				elementsPerLog = MAX(bytesPerLog / 160, 1U);
+	NSTimeInterval			firstMessage = -86400.0 - (LOGS_PER_CHAT * elementsPerLog * MESSAGE_SPACING);
+	NSUInteger				elementIndex = 0;
+
+	for (NSUInteger logIndex = 0; logIndex < LOGS_PER_CHAT; logIndex++) {
+		NSDate		*logDate = [NSDate dateWithTimeIntervalSinceNow:firstMessage + logIndex * elementsPerLog * MESSAGE_SPACING];
+		NSString	*name = [NSString stringWithFormat:@"%@ (%@)", objectUID,
+							 [logDate descriptionWithCalendarFormat:@"%Y-%m-%dT%H.%M.%S%z" timeZone:nil locale:nil]];
+		NSString	*bundlePath = [folderPath stringByAppendingPathComponent:[name stringByAppendingPathExtension:@"chatlog"]];
+		NSString	*xmlPath = [bundlePath stringByAppendingPathComponent:[name stringByAppendingPathExtension:@"xml"]];
+
+		[[NSFileManager defaultManager] createDirectoryAtPath:bundlePath withIntermediateDirectories:YES attributes:nil error:NULL];
+		FILE *file = fopen([xmlPath fileSystemRepresentation], "w");
+		if (!file) continue;
+
+		[buffer removeAllBytes];
+		[buffer appendCString:"<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n<chat xmlns=\""];
+		[buffer appendString:XML_LOGGING_NAMESPACE];
+		[buffer appendCString:"\" account=\""];
+		[buffer appendXMLEscapedString:account.UID];
+		[buffer appendCString:"\" service=\""];
+		[buffer appendXMLEscapedString:account.service.serviceID];
+		[buffer appendCString:"\">"];
+
+		while ((NSUInteger)ftello(file) + buffer.length < bytesPerLog) {
+			NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+			NSDate				*date = [NSDate dateWithTimeIntervalSinceNow:firstMessage + elementIndex * MESSAGE_SPACING];
+			NSString			*time = [formatter stringFromDate:date];
+			BOOL				 fromMe = (nextRandom(state) % 2 == 0);
+			NSString			*sender = (fromMe ? account.UID : chat.listObject.UID);
+
+			if (elementIndex % STATUS_INTERVAL == STATUS_INTERVAL - 1) {
+				[AIXMLElement appendUTF8XMLBytesForElementWithName:@"status"
+													attributeNames:[NSArray arrayWithObjects:@"type", @"sender", @"time", nil]
+															values:[NSArray arrayWithObjects:@"away", chat.listObject.UID, time, nil]
+												   escapedContents:nil
+														  toBuffer:buffer];
+			} else {
+				NSMutableString *text = [NSMutableString string];
+				NSUInteger		 wordCount = 6 + nextRandom(state) % 20;
+				for (NSUInteger w = 0; w < wordCount; w++) {
+					[text appendFormat:(w ? @" %s" : @"%s"), words[nextRandom(state) % 20]];
+				}
+				if (nextRandom(state) % 4 == 0) [text appendString:@" <&> \"more\""];
+
+				[AIXMLElement appendUTF8XMLBytesForElementWithName:@"message"
+													attributeNames:[NSArray arrayWithObjects:@"sender", @"time", nil]
+															values:[NSArray arrayWithObjects:sender, time, nil]
+												   escapedContents:[NSString stringWithFormat:
+																	@"<div><span style=\"font-family: Helvetica; font-size: 12pt;\">%@</span></div>",
+																	[text stringByEscapingForXMLWithEntities:nil]]
+														  toBuffer:buffer];
+			}
+			[buffer appendBytes:"\n" length:1];
+			elementIndex++;
+
+			if (buffer.length >= LOG_WRITE_SIZE) {
+				fwrite(buffer.bytes, 1, buffer.length, file);
+				[buffer removeAllBytes];
+			}
+			[pool release];
+		}
+
+		[buffer appendCString:"</chat>"];
+		fwrite(buffer.bytes, 1, buffer.length, file);
+		fclose(file);
+	}
+}
+
+/*!
+ * @brief Read every chat's history once, timing the whole pass
+ */
+- (NSArray *)time:(NSString *)name chats:(NSArray *)chats reading:(NSArray * (^)(AIChat *chat))readBlock
+{
+	NSMutableArray	*results = [NSMutableArray arrayWithCapacity:chats.count];
+	uint64_t		start = mach_absolute_time();
+
+	for (AIChat *chat in chats) {
+		NSArray *result = readBlock(chat);
+		[results addObject:(result ?: [NSArray array])];
+	}
+
+	[times setObject:[NSNumber numberWithDouble:secondsFromMachTime(mach_absolute_time() - start)] forKey:name];
+
+	return results;
+}
+
+/*!
+ * @brief Note every chat whose history read one way differs from the other
+ */
+- (void)compare:(NSArray *)results with:(NSArray *)expectedResults chats:(NSArray *)chats named:(NSString *)name
+{
+	for (NSUInteger i = 0; i < chats.count; i++) {
+		NSArray *result = [results objectAtIndex:i];
+		NSArray *expected = [expectedResults objectAtIndex:i];
+
+		checkCount++;
+
+		if (result.count != expected.count) {
+			[mismatches addObject:[NSString stringWithFormat:@"%@ %@: %lu lines, expected %lu", name, [chats objectAtIndex:i],
+								   (unsigned long)result.count, (unsigned long)expected.count]];
+			continue;
+		}
+
+		for (NSUInteger j = 0; j < result.count; j++) {
+			NSString *description = describeContent([result objectAtIndex:j]);
+			NSString *expectedDescription = describeContent([expected objectAtIndex:j]);
+
+			if (![description isEqualToString:expectedDescription]) {
+				[mismatches addObject:[NSString stringWithFormat:@"%@ %@ line %lu: %@, expected %@", name, [chats objectAtIndex:i],
+									   (unsigned long)j, description, expectedDescription]];
+				break;
+			}
+		}
+	}
+}
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSArray			*reportMismatches = [report objectForKey:KEY_TAIL_REPORT_MISMATCHES];
+	NSDictionary	*reportTimes = [report objectForKey:KEY_TAIL_REPORT_TIMES];
+	NSUInteger		chats = [[report objectForKey:KEY_TAIL_REPORT_CHATS] unsignedIntegerValue];
+
+	[description appendFormat:@"Chats: %lu with %.1f MB of logs each, %@ lines of history\n", (unsigned long)chats,
+	 [[report objectForKey:KEY_TAIL_REPORT_LOG_BYTES] doubleValue] / (1024 * 1024), [report objectForKey:KEY_TAIL_REPORT_LINES]];
+	[description appendFormat:@"Checks: %@, mismatches: %lu\n", [report objectForKey:KEY_TAIL_REPORT_CHECKS],
+	 (unsigned long)reportMismatches.count];
+	[description appendFormat:@"Cache hits after logging: %@ of %lu\n", [report objectForKey:KEY_TAIL_REPORT_HITS_AFTER_LOGGING],
+	 (unsigned long)chats];
+
+	for (NSUInteger i = 0; i < reportMismatches.count && i < MAX_REPORTED_MISMATCHES; i++) {
+		[description appendFormat:@"  %@\n", [reportMismatches objectAtIndex:i]];
+	}
+
+	[description appendString:@"\nTimes:\n"];
+	for (NSString *name in [[reportTimes allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		double seconds = [[reportTimes objectForKey:name] doubleValue];
+
+		[description appendFormat:@"  %-40s %9.3f s  %10.3f ms per chat\n",
+		 [name UTF8String], seconds, (chats ? seconds * 1000.0 / chats : 0.0)];
+	}
+
+	return description;
+}
+
+@end
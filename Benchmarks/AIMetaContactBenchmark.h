@@ -0,0 +1,69 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+
+@class AIBenchmarkAccount;
+
+//Report keys
+#define KEY_META_REPORT_METACONTACTS		@"Metacontacts"
+#define KEY_META_REPORT_CONTACTS			@"Contacts"
+#define KEY_META_REPORT_DUPLICATES			@"Duplicates"
+#define KEY_META_REPORT_FLAPS				@"Flaps"
+#define KEY_META_REPORT_CHECKS				@"Checks"
+#define KEY_META_REPORT_MISMATCHES			@"Mismatches"
+#define KEY_META_REPORT_OPERATIONS			@"Operations"
+
+/*!
+ * @class AIMetaContactBenchmark
+ * @brief Flaps the presence of contacts in metacontacts and checks each metacontact against a from-scratch rebuild
+ *
+ * metaContactCount metacontacts of 3 to 6 contacts are made on one account; a third of the contacts are also on a
+ * second account, so the metacontacts hold duplicates. Random contacts then sign on and off, go away, idle and mobile,
+ * and the metacontact's preferred destination is set to random contacts, flapCount times. After each change the
+ * metacontact's unique contacts, preferred contacts and preferred destination are compared with those worked out from
+ * its contained objects the way AIMetaContact used to, and both are timed. The metacontacts are taken apart again
+ * before -run returns.
+ *
+ * Run with -AIMetaContactBenchmark YES. Settings:
+ *	-AIMetaContactBenchmarkMetaContacts <n>	Metacontacts to build (2000)
+ *	-AIMetaContactBenchmarkFlaps <n>		Presence changes of their members (50000)
+ *	-AIContactListBenchmarkSeed <n>			Seed for the random choices (1)
+ */
+@interface AIMetaContactBenchmark : NSObject <AIBenchmark> {
+	AIBenchmarkAccount	*account;
+	AIBenchmarkAccount	*otherAccount;
+
+	NSUInteger			metaContactCount;
+	NSUInteger			flapCount;
+	uint32_t			seed;
+
+	NSMutableArray		*mismatches;
+	NSUInteger			checkCount;
+	uint64_t			incrementalTime;
+	uint64_t			rebuildTime;
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount otherAccount:(AIBenchmarkAccount *)inOtherAccount;
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger metaContactCount;
+@property (readwrite, nonatomic) NSUInteger flapCount;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
@@ -0,0 +1,442 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIMetaContactBenchmark.h"
+#import "AIBenchmarkAccount.h"
+#import <Adium/AIContactControllerProtocol.h>
+#import <Adium/AIContentMessage.h>
+#import <Adium/AIListContact.h>
+#import <Adium/AIMetaContact.h>
+#import <Adium/AIService.h>
+#import <mach/mach_time.h>
+
+//Settings
+#define KEY_META_BENCHMARK_METACONTACTS		@"AIMetaContactBenchmarkMetaContacts"
+#define KEY_META_BENCHMARK_FLAPS			@"AIMetaContactBenchmarkFlaps"
+
+#define BENCHMARK_GROUP					@"Metacontact Benchmark"
+#define MINIMUM_MEMBERS					3
+#define MAXIMUM_MEMBERS					6
+//One member in so many is also on the other account
+#define DUPLICATE_INTERVAL				3
+//Flaps are done in batches, each in its own autorelease pool
+#define BATCH_SIZE						1000
+//How many mismatches are described in the report
+#define MAX_REPORTED_MISMATCHES			20
+
+typedef enum {
+	AIMetaContactFlapOnline = 0,
+	AIMetaContactFlapAway,
+	AIMetaContactFlapIdle,
+	AIMetaContactFlapMobile,
+	AIMetaContactFlapPreferredDestination,
+	AIMetaContactFlapKindCount
+} AIMetaContactFlapKind;
+
+@interface AIMetaContactBenchmark ()
+- (void)checkMetaContact:(AIMetaContact *)metaContact service:(AIService *)service flap:(NSUInteger)flap;
+- (void)noteMismatch:(NSString *)what ofMetaContact:(AIMetaContact *)metaContact flap:(NSUInteger)flap value:(id)value rebuiltValue:(id)rebuiltValue;
+@end
+
+/*!
+ * @brief The same generator as AIContactListTrace's, so a seed gives the same replay everywhere
+ */
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+static void addCost(NSMutableDictionary *costs, NSString *costName, NSUInteger count, uint64_t machTime)
+{
+	[costs setObject:[NSDictionary dictionaryWithObjectsAndKeys:
+					  [NSNumber numberWithUnsignedInteger:count], @"Count",
+					  [NSNumber numberWithDouble:secondsFromMachTime(machTime)], @"Seconds",
+					  nil]
+			  forKey:costName];
+}
+
+#pragma mark Rebuilding from scratch
+
+/*!
+ * @brief A metacontact's unique contacts, worked out from its contained objects as AIMetaContact used to each time
+ */
+static NSArray *rebuiltUniqueContacts(AIMetaContact *metaContact, BOOL includeOfflineAccounts)
+{
+	NSMutableArray	*listContacts = [NSMutableArray array];
+
+	for (AIListContact *listContact in metaContact.containedObjects) {
+		AIListContact *previousContact = [listContacts lastObject];
+
+		if ([listContact.internalObjectID isEqualToString:previousContact.internalObjectID]) {
+			if (!previousContact.online && listContact.online)
+				[listContacts replaceObjectAtIndex:listContacts.count - 1 withObject:listContact];
+			continue;
+		}
+
+		if (listContact.countOfRemoteGroupNames > 0 || includeOfflineAccounts)
+			[listContacts addObject:listContact];
+	}
+
+	return listContacts;
+}
+
+/*!
+ * @brief The preferred contact, optionally on one service only, found with AIMetaContact's old three passes
+ */
+static AIListContact *rebuiltPreferredContact(AIMetaContact *metaContact, NSArray *uniqueContacts, NSString *serviceClass)
+{
+	for (AIListContact *listContact in uniqueContacts) {
+		if ((!serviceClass || [listContact.service.serviceClass isEqualToString:serviceClass]) &&
+			listContact.statusSummary == AIAvailableStatus && !listContact.isMobile)
+			return listContact;
+	}
+
+	for (AIListContact *listContact in uniqueContacts) {
+		if ((!serviceClass || [listContact.service.serviceClass isEqualToString:serviceClass]) && listContact.online)
+			return listContact;
+	}
+
+	for (AIListContact *listContact in uniqueContacts) {
+		if (!serviceClass || [listContact.service.serviceClass isEqualToString:serviceClass])
+			return listContact;
+	}
+
+	if (!serviceClass && metaContact.countOfContainedObjects)
+		return [metaContact.containedObjects objectAtIndex:0];
+
+	return nil;
+}
+
+/*!
+ * @brief The contact to message, found the old way: the saved contact is looked up in the whole contact list
+ *
+ * The lookup returns whichever contact with the saved ID it comes to first; since AIMetaContact now picks the one in
+ * its unique contacts, that one is compared against.
+ */
+static AIListContact *rebuiltPreferredDestination(AIMetaContact *metaContact, NSArray *allUniqueContacts, AIListContact *preferredContact)
+{
+	NSString		*objID = [metaContact preferenceForKey:KEY_PREFERRED_DESTINATION_CONTACT group:PREF_GROUP_OBJECT_STATUS_CACHE];
+	AIListContact	*destination = nil;
+
+	if (objID && [metaContact.containedObjects containsObject:[adium.contactController existingListObjectWithUniqueID:objID]]) {
+		for (AIListContact *listContact in allUniqueContacts) {
+			if ([listContact.internalObjectID isEqualToString:objID]) {
+				destination = listContact;
+				break;
+			}
+		}
+	}
+
+	if (!destination ||
+		destination.statusSummary != metaContact.statusSummary ||
+		(!metaContact.isMobile && destination.isMobile)) {
+		destination = preferredContact;
+	}
+
+	return destination;
+}
+
+#pragma mark -
+
+@implementation AIMetaContactBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:2000], KEY_META_BENCHMARK_METACONTACTS,
+			[NSNumber numberWithUnsignedInteger:50000], KEY_META_BENCHMARK_FLAPS,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AIMetaContactBenchmark *benchmark = [[[self alloc] initWithAccount:[AIBenchmarkAccount addTemporaryAccountWithUID:BENCHMARK_ACCOUNT_UID]
+												   otherAccount:[AIBenchmarkAccount addTemporaryAccountWithUID:BENCHMARK_OTHER_ACCOUNT_UID]] autorelease];
+
+	benchmark.metaContactCount = [defaults integerForKey:KEY_META_BENCHMARK_METACONTACTS];
+	benchmark.flapCount = [defaults integerForKey:KEY_META_BENCHMARK_FLAPS];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (void)deleteAccounts
+{
+	[account deleteTemporaryAccount];
+	[otherAccount deleteTemporaryAccount];
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount otherAccount:(AIBenchmarkAccount *)inOtherAccount
+{
+	if ((self = [super init])) {
+		account = [inAccount retain];
+		otherAccount = [inOtherAccount retain];
+		metaContactCount = 2000;
+		flapCount = 50000;
+		seed = 1;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[account release];
+	[otherAccount release];
+	[mismatches release];
+
+	[super dealloc];
+}
+
+@synthesize metaContactCount, flapCount, seed;
+
+- (NSDictionary *)run
+{
+	NSMutableDictionary	*costs = [NSMutableDictionary dictionary];
+	NSMutableArray		*metaContacts = [NSMutableArray array];
+	NSMutableArray		*memberUIDs = [NSMutableArray array];
+	NSMutableSet		*duplicatedUIDs = [NSMutableSet set];
+	NSMutableSet		*offline = [NSMutableSet set], *away = [NSMutableSet set];
+	NSMutableSet		*idle = [NSMutableSet set], *mobile = [NSMutableSet set];
+	NSUInteger			contactCount = 0, duplicateCount = 0;
+	NSUInteger			i, j, flap, batch;
+	uint64_t			start, flapTime = 0;
+	uint32_t			state = seed;
+
+	[mismatches release]; mismatches = [[NSMutableArray alloc] init];
+	checkCount = 0;
+	incrementalTime = rebuildTime = 0;
+
+	//Everyone signs on silently, as they would when we connect
+	[account connect];
+	[otherAccount connect];
+	for (i = 0; i < metaContactCount; i++) {
+		NSUInteger		memberCount = MINIMUM_MEMBERS + nextRandom(&state) % (MAXIMUM_MEMBERS - MINIMUM_MEMBERS + 1);
+		NSMutableArray	*UIDs = [NSMutableArray arrayWithCapacity:memberCount];
+
+		for (j = 0; j < memberCount; j++) {
+			NSString *UID = [NSString stringWithFormat:@"metamember%lu.%lu", (unsigned long)i, (unsigned long)j];
+
+			[account signOnContactWithUID:UID group:BENCHMARK_GROUP away:NO statusMessage:nil];
+			if (nextRandom(&state) % DUPLICATE_INTERVAL == 0) {
+				[otherAccount signOnContactWithUID:UID group:BENCHMARK_GROUP away:NO statusMessage:nil];
+				[duplicatedUIDs addObject:UID];
+			}
+
+			[UIDs addObject:UID];
+		}
+
+		[memberUIDs addObject:UIDs];
+	}
+	[account endSignOnDelay];
+	[otherAccount endSignOnDelay];
+
+	start = mach_absolute_time();
+	for (i = 0; i < memberUIDs.count; i++) {
+		NSMutableArray *contacts = [NSMutableArray array];
+
+		for (NSString *UID in [memberUIDs objectAtIndex:i]) {
+			[contacts addObject:[account contactWithUID:UID]];
+			if ([duplicatedUIDs containsObject:UID])
+				[contacts addObject:[otherAccount contactWithUID:UID]];
+		}
+
+		AIMetaContact *metaContact = [adium.contactController groupContacts:contacts];
+		[metaContacts addObject:(metaContact ?: (id)[NSNull null])];
+		if (metaContact) {
+			contactCount += metaContact.countOfContainedObjects;
+			duplicateCount += metaContact.countOfContainedObjects - metaContact.listContactsIncludingOfflineAccounts.count;
+		}
+	}
+	addCost(costs, @"Grouping", contactCount, mach_absolute_time() - start);
+
+	for (flap = 0; flap < flapCount; flap += BATCH_SIZE) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+		for (NSUInteger f = flap; f < MIN(flap + BATCH_SIZE, flapCount); f++) {
+			NSUInteger				idx = nextRandom(&state) % metaContacts.count;
+			AIMetaContact			*metaContact = [metaContacts objectAtIndex:idx];
+			NSArray					*UIDs = [memberUIDs objectAtIndex:idx];
+			NSString				*UID = [UIDs objectAtIndex:nextRandom(&state) % UIDs.count];
+			AIBenchmarkAccount		*flapAccount = (([duplicatedUIDs containsObject:UID] && nextRandom(&state) % 2) ? otherAccount : account);
+			NSString				*key = [NSString stringWithFormat:@"%@/%@", flapAccount.UID, UID];
+			AIMetaContactFlapKind	kind = nextRandom(&state) % AIMetaContactFlapKindCount;
+
+			if ((id)metaContact == [NSNull null]) continue;
+
+			start = mach_absolute_time();
+			if (kind == AIMetaContactFlapOnline || [offline containsObject:key]) {
+				if ([offline containsObject:key]) {
+					[flapAccount signOnContactWithUID:UID group:BENCHMARK_GROUP away:NO statusMessage:nil];
+					[offline removeObject:key];
+				} else {
+					[flapAccount signOffContactWithUID:UID];
+					[offline addObject:key];
+					[away removeObject:key];
+					[idle removeObject:key];
+				}
+
+			} else if (kind == AIMetaContactFlapAway) {
+				BOOL nowAway = ![away containsObject:key];
+
+				[flapAccount setContactWithUID:UID away:nowAway statusMessage:(nowAway ? @"Away" : nil)];
+				if (nowAway) [away addObject:key]; else [away removeObject:key];
+
+			} else if (kind == AIMetaContactFlapIdle) {
+				BOOL nowIdle = ![idle containsObject:key];
+
+				[flapAccount setContactWithUID:UID idleSinceDate:(nowIdle ? [NSDate date] : nil)];
+				if (nowIdle) [idle addObject:key]; else [idle removeObject:key];
+
+			} else if (kind == AIMetaContactFlapMobile) {
+				BOOL nowMobile = ![mobile containsObject:key];
+
+				[[flapAccount contactWithUID:UID] setIsMobile:nowMobile notify:NotifyNow];
+				if (nowMobile) [mobile addObject:key]; else [mobile removeObject:key];
+
+			} else {
+				//Someone we contain, someone we don't, or no one
+				NSString	*destinationUID = nil;
+				uint32_t	choice = nextRandom(&state) % 4;
+
+				if (choice < 2)
+					destinationUID = UID;
+				else if (choice == 2)
+					destinationUID = [[memberUIDs objectAtIndex:(idx + 1) % memberUIDs.count] objectAtIndex:0];
+
+				[metaContact setPreference:(destinationUID ? [account contactWithUID:destinationUID].internalObjectID : nil)
+									forKey:KEY_PREFERRED_DESTINATION_CONTACT
+									 group:PREF_GROUP_OBJECT_STATUS_CACHE];
+			}
+			flapTime += mach_absolute_time() - start;
+
+			[self checkMetaContact:metaContact service:account.service flap:f];
+
+			//Only our own contacts are contained
+			AIListContact *stranger = [account contactWithUID:[[memberUIDs objectAtIndex:(idx + 1) % memberUIDs.count] objectAtIndex:0]];
+			if (![metaContact containsObject:[flapAccount contactWithUID:UID]] || [metaContact containsObject:stranger]) {
+				[self noteMismatch:@"containsObject:" ofMetaContact:metaContact flap:f value:UID rebuiltValue:stranger.UID];
+			}
+		}
+
+		[pool release];
+	}
+	addCost(costs, @"Presence and preference changes", flapCount, flapTime);
+	addCost(costs, @"Incremental unique and preferred contacts", checkCount, incrementalTime);
+	addCost(costs, @"Rebuilt unique and preferred contacts", checkCount, rebuildTime);
+
+	for (AIMetaContact *metaContact in metaContacts) {
+		if ((id)metaContact == [NSNull null]) continue;
+
+		[metaContact setPreference:nil forKey:KEY_PREFERRED_DESTINATION_CONTACT group:PREF_GROUP_OBJECT_STATUS_CACHE];
+		if (metaContact.countOfContainedObjects) [adium.contactController explodeMetaContact:metaContact];
+	}
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:metaContactCount], KEY_META_REPORT_METACONTACTS,
+			[NSNumber numberWithUnsignedInteger:contactCount], KEY_META_REPORT_CONTACTS,
+			[NSNumber numberWithUnsignedInteger:duplicateCount], KEY_META_REPORT_DUPLICATES,
+			[NSNumber numberWithUnsignedInteger:flapCount], KEY_META_REPORT_FLAPS,
+			[NSNumber numberWithUnsignedInteger:checkCount], KEY_META_REPORT_CHECKS,
+			mismatches, KEY_META_REPORT_MISMATCHES,
+			costs, KEY_META_REPORT_OPERATIONS,
+			nil];
+}
+
+/*!
+ * @brief Compare what a metacontact keeps up to date with what rebuilding it from scratch gives
+ */
+- (void)checkMetaContact:(AIMetaContact *)metaContact service:(AIService *)service flap:(NSUInteger)flap
+{
+	uint64_t		start = mach_absolute_time();
+	NSArray			*uniqueContacts = metaContact.uniqueContainedObjects;
+	NSArray			*allUniqueContacts = metaContact.listContactsIncludingOfflineAccounts;
+	AIListContact	*preferredContact = metaContact.preferredContact;
+	AIListContact	*serviceContact = [metaContact preferredContactWithCompatibleService:service];
+	AIListContact	*destination = [metaContact preferredContactForContentType:CONTENT_MESSAGE_TYPE];
+	incrementalTime += mach_absolute_time() - start;
+
+	start = mach_absolute_time();
+	NSArray			*rebuiltUnique = rebuiltUniqueContacts(metaContact, NO);
+	NSArray			*rebuiltAllUnique = rebuiltUniqueContacts(metaContact, YES);
+	AIListContact	*rebuiltPreferred = rebuiltPreferredContact(metaContact, rebuiltUnique, nil);
+	AIListContact	*rebuiltService = rebuiltPreferredContact(metaContact, rebuiltUnique, service.serviceClass);
+	AIListContact	*rebuiltDestination = rebuiltPreferredDestination(metaContact, rebuiltAllUnique, rebuiltPreferred);
+	rebuildTime += mach_absolute_time() - start;
+
+	checkCount++;
+
+	if (![uniqueContacts isEqualToArray:rebuiltUnique])
+		[self noteMismatch:@"uniqueContainedObjects" ofMetaContact:metaContact flap:flap value:uniqueContacts rebuiltValue:rebuiltUnique];
+	if (![allUniqueContacts isEqualToArray:rebuiltAllUnique])
+		[self noteMismatch:@"listContactsIncludingOfflineAccounts" ofMetaContact:metaContact flap:flap value:allUniqueContacts rebuiltValue:rebuiltAllUnique];
+	if (preferredContact != rebuiltPreferred)
+		[self noteMismatch:@"preferredContact" ofMetaContact:metaContact flap:flap value:preferredContact rebuiltValue:rebuiltPreferred];
+	if (serviceContact != rebuiltService)
+		[self noteMismatch:@"preferredContactWithCompatibleService:" ofMetaContact:metaContact flap:flap value:serviceContact rebuiltValue:rebuiltService];
+	if (destination != rebuiltDestination)
+		[self noteMismatch:@"preferredContactForContentType:" ofMetaContact:metaContact flap:flap value:destination rebuiltValue:rebuiltDestination];
+}
+
+- (void)noteMismatch:(NSString *)what ofMetaContact:(AIMetaContact *)metaContact flap:(NSUInteger)flap value:(id)value rebuiltValue:(id)rebuiltValue
+{
+	[mismatches addObject:[NSString stringWithFormat:@"Flap %lu, %@ of %@: %@, rebuilt %@",
+						   (unsigned long)flap, what, metaContact.UID, value, rebuiltValue]];
+}
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSDictionary	*costs = [report objectForKey:KEY_META_REPORT_OPERATIONS];
+	NSArray			*reportMismatches = [report objectForKey:KEY_META_REPORT_MISMATCHES];
+
+	[description appendFormat:@"Metacontacts: %@, contacts: %@ (%@ duplicates)\n",
+	 [report objectForKey:KEY_META_REPORT_METACONTACTS], [report objectForKey:KEY_META_REPORT_CONTACTS],
+	 [report objectForKey:KEY_META_REPORT_DUPLICATES]];
+	[description appendFormat:@"Flaps: %@, checks: %@\n",
+	 [report objectForKey:KEY_META_REPORT_FLAPS], [report objectForKey:KEY_META_REPORT_CHECKS]];
+	[description appendFormat:@"Mismatches: %lu\n", (unsigned long)reportMismatches.count];
+
+	for (NSUInteger i = 0; i < reportMismatches.count && i < MAX_REPORTED_MISMATCHES; i++) {
+		[description appendFormat:@"  %@\n", [reportMismatches objectAtIndex:i]];
+	}
+
+	[description appendString:@"\n"];
+	for (NSString *name in [[costs allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		NSDictionary	*cost = [costs objectForKey:name];
+		NSUInteger		count = [[cost objectForKey:@"Count"] unsignedIntegerValue];
+		double			seconds = [[cost objectForKey:@"Seconds"] doubleValue];
+
+		[description appendFormat:@"  %-50s %8lu  %9.3f s  %10.3f us each\n",
+		 [name UTF8String], (unsigned long)count, seconds, (count ? seconds * USEC_PER_SEC / count : 0.0)];
+	}
+
+	return description;
+}
+
+@end
@@ -0,0 +1,57 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+
+//Report keys
+#define KEY_OWNER_REPORT_CONTACTS			@"Contacts"
+#define KEY_OWNER_REPORT_KEYS				@"Display Keys"
+#define KEY_OWNER_REPORT_ARRAYS				@"Owner Arrays"
+#define KEY_OWNER_REPORT_ENTRIES			@"Entries"
+#define KEY_OWNER_REPORT_STORAGE			@"Storage"
+#define KEY_OWNER_REPORT_BYTES				@"Bytes In Use Delta"
+#define KEY_OWNER_REPORT_BLOCKS				@"Blocks In Use Delta"
+#define KEY_OWNER_REPORT_OPERATIONS			@"Operations"
+#define KEY_OWNER_REPORT_MISMATCHES			@"Mismatches"
+
+/*!
+ * @class AIOwnerArrayBenchmark
+ * @brief Fills the display arrays of a synthetic contact list and measures what they cost
+ *
+ * Every contact gets an owner array for each of the usual display keys, most with one owner and some with two or
+ * three, the way a real contact list's are. The same work is done with AIMutableOwnerArray and with a copy of the
+ * parallel NSMutableArray storage it used to have, and the memory each holds and the time each operation takes are
+ * reported side by side. Every answer AIMutableOwnerArray gives is also checked against the parallel arrays'.
+ *
+ * Run with -AIOwnerArrayBenchmark YES. Settings:
+ *	-AIOwnerArrayBenchmarkContacts <n>	Contacts to fill display owner arrays for (20000)
+ *	-AIContactListBenchmarkSeed <n>		Seed for the random choices (1)
+ */
+@interface AIOwnerArrayBenchmark : NSObject <AIBenchmark> {
+	NSUInteger			contactCount;
+	uint32_t			seed;
+
+	NSMutableArray		*mismatches;
+}
+
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger contactCount;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
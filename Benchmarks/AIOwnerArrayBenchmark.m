@@ -0,0 +1,409 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIOwnerArrayBenchmark.h"
+#import <AIUtilities/AIMutableOwnerArray.h>
+#import <malloc/malloc.h>
+#import <mach/mach_time.h>
+
+//Settings
+#define KEY_OWNER_BENCHMARK_CONTACTS		@"AIOwnerArrayBenchmarkContacts"
+
+//How many owner arrays each contact has, as for Display Name, Long Display Name, Phonetic Name, colors and icons
+#define DISPLAY_KEYS_PER_CONTACT		7
+//How many times every array's object value is asked for
+#define OBJECT_VALUE_ROUNDS				4
+//How many distinct objects are stored, so the objects themselves don't count towards memory use
+#define OBJECT_POOL_SIZE				64
+//How many mismatches are described in the report
+#define MAX_REPORTED_MISMATCHES			20
+
+/*!
+ * @class AIParallelOwnerArray
+ * @brief The storage AIMutableOwnerArray used to have: three parallel arrays, with boxed priorities
+ *
+ * Only what the benchmark uses is here, done the same way it was.
+ */
+@interface AIParallelOwnerArray : NSObject {
+	NSMutableArray	*contentArray;
+	NSMutableArray	*ownerArray;
+	NSMutableArray	*priorityArray;
+	BOOL			valueIsSortedToFront;
+}
+- (void)setObject:(id)anObject withOwner:(id)inOwner priorityLevel:(float)priority;
+- (id)objectValue;
+- (id)objectWithOwner:(id)inOwner;
+@end
+
+@implementation AIParallelOwnerArray
+
+- (void)dealloc
+{
+	[contentArray release];
+	[ownerArray release];
+	[priorityArray release];
+
+	[super dealloc];
+}
+
+- (void)setObject:(id)anObject withOwner:(id)inOwner priorityLevel:(float)priority
+{
+	NSUInteger ownerIndex = [ownerArray indexOfObject:inOwner];
+	if (ownerArray && (ownerIndex != NSNotFound)) {
+		[ownerArray removeObjectAtIndex:ownerIndex];
+		[contentArray removeObjectAtIndex:ownerIndex];
+		[priorityArray removeObjectAtIndex:ownerIndex];
+	}
+
+	if (anObject) {
+		if (!ownerArray) {
+			contentArray = [[NSMutableArray alloc] init];
+			priorityArray = [[NSMutableArray alloc] init];
+			ownerArray = [[NSMutableArray alloc] init];
+		}
+
+		[ownerArray addObject:inOwner];
+		[contentArray addObject:anObject];
+		[priorityArray addObject:[NSNumber numberWithFloat:priority]];
+	}
+
+	valueIsSortedToFront = NO;
+}
+
+- (id)objectValue
+{
+	if (![ownerArray count]) return nil;
+
+	if ([priorityArray count] != 1 && !valueIsSortedToFront) {
+		float		currentMax = Lowest_Priority;
+		NSUInteger	indexOfMax = 0, idx = 0;
+
+		for (NSNumber *priority in priorityArray) {
+			if ([priority floatValue] < currentMax) {
+				currentMax = [priority floatValue];
+				indexOfMax = idx;
+			}
+			idx++;
+		}
+
+		if (indexOfMax != 0) {
+			[contentArray exchangeObjectAtIndex:indexOfMax withObjectAtIndex:0];
+			[ownerArray exchangeObjectAtIndex:indexOfMax withObjectAtIndex:0];
+			[priorityArray exchangeObjectAtIndex:indexOfMax withObjectAtIndex:0];
+		}
+		valueIsSortedToFront = YES;
+	}
+
+	return [contentArray objectAtIndex:0];
+}
+
+- (id)objectWithOwner:(id)inOwner
+{
+	NSUInteger idx = [ownerArray indexOfObject:inOwner];
+
+	return (ownerArray && idx != NSNotFound ? [contentArray objectAtIndex:idx] : nil);
+}
+
+@end
+
+#pragma mark -
+
+@interface AIOwnerArrayBenchmark ()
+- (NSDictionary *)runStorage:(Class)storageClass
+				  ownerCounts:(const uint8_t *)ownerCounts
+				   arrayCount:(NSUInteger)arrayCount
+					   owners:(NSArray *)owners
+					  objects:(NSArray *)objects
+				 objectValues:(id *)objectValues;
+@end
+
+/*!
+ * @brief The same generator as AIContactListTrace's, so a seed gives the same contact list everywhere
+ */
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+/*!
+ * @brief The priority an owner sets its object at; fixed per owner and pass, as it is for the plugins which set them
+ */
+static float priorityForOwner(NSUInteger ownerIndex, NSUInteger pass)
+{
+	static const float priorities[] = { Medium_Priority, High_Priority, Low_Priority, Highest_Priority, Lowest_Priority };
+
+	return priorities[(ownerIndex + pass) % (sizeof(priorities) / sizeof(priorities[0]))];
+}
+
+static void addCost(NSMutableDictionary *costs, NSString *costName, NSUInteger count, uint64_t machTime)
+{
+	[costs setObject:[NSDictionary dictionaryWithObjectsAndKeys:
+					  [NSNumber numberWithUnsignedInteger:count], @"Count",
+					  [NSNumber numberWithDouble:secondsFromMachTime(machTime)], @"Seconds",
+					  nil]
+			  forKey:costName];
+}
+
+@implementation AIOwnerArrayBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:20000], KEY_OWNER_BENCHMARK_CONTACTS,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AIOwnerArrayBenchmark *benchmark = [[[self alloc] init] autorelease];
+
+	benchmark.contactCount = [defaults integerForKey:KEY_OWNER_BENCHMARK_CONTACTS];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (id)init
+{
+	if ((self = [super init])) {
+		contactCount = 20000;
+		seed = 1;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[mismatches release];
+
+	[super dealloc];
+}
+
+@synthesize contactCount, seed;
+
+/*!
+ * @brief Do the same work with both kinds of storage, check they agree, and report
+ */
+- (NSDictionary *)run
+{
+	NSUInteger		arrayCount = contactCount * DISPLAY_KEYS_PER_CONTACT;
+	NSUInteger		entryCount = 0;
+	uint8_t			*ownerCounts = malloc(arrayCount);
+	id				*objectValues = calloc(arrayCount * 2, sizeof(id));
+	id				*parallelObjectValues = calloc(arrayCount * 2, sizeof(id));
+	NSMutableArray	*owners = [NSMutableArray array];
+	NSMutableArray	*objects = [NSMutableArray array];
+	uint32_t		state = seed;
+	NSUInteger		i;
+
+	[mismatches release]; mismatches = [[NSMutableArray alloc] init];
+
+	for (i = 0; i < 3; i++) {
+		[owners addObject:[NSString stringWithFormat:@"Owner %lu", (unsigned long)i]];
+	}
+	for (i = 0; i < OBJECT_POOL_SIZE; i++) {
+		[objects addObject:[NSString stringWithFormat:@"Value %lu", (unsigned long)i]];
+	}
+
+	//Most arrays have a single owner; one in four has two, and one in sixteen three
+	for (i = 0; i < arrayCount; i++) {
+		uint32_t roll = nextRandom(&state) % 16;
+
+		ownerCounts[i] = (roll == 0 ? 3 : (roll < 4 ? 2 : 1));
+		entryCount += ownerCounts[i];
+	}
+
+	NSDictionary *ownerArrayReport = [self runStorage:[AIMutableOwnerArray class]
+										  ownerCounts:ownerCounts
+										   arrayCount:arrayCount
+											   owners:owners
+											  objects:objects
+										 objectValues:objectValues];
+	NSDictionary *parallelReport = [self runStorage:[AIParallelOwnerArray class]
+										ownerCounts:ownerCounts
+										 arrayCount:arrayCount
+											 owners:owners
+											objects:objects
+									   objectValues:parallelObjectValues];
+
+	for (i = 0; i < arrayCount * 2; i++) {
+		if (objectValues[i] != parallelObjectValues[i]) {
+			[mismatches addObject:[NSString stringWithFormat:@"array %lu %@: owner array %@, parallel arrays %@",
+								   (unsigned long)(i % arrayCount), (i < arrayCount ? @"after filling" : @"after replacing"),
+								   objectValues[i], parallelObjectValues[i]]];
+		}
+	}
+
+	free(ownerCounts);
+	free(objectValues);
+	free(parallelObjectValues);
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:contactCount], KEY_OWNER_REPORT_CONTACTS,
+			[NSNumber numberWithUnsignedInteger:DISPLAY_KEYS_PER_CONTACT], KEY_OWNER_REPORT_KEYS,
+			[NSNumber numberWithUnsignedInteger:arrayCount], KEY_OWNER_REPORT_ARRAYS,
+			[NSNumber numberWithUnsignedInteger:entryCount], KEY_OWNER_REPORT_ENTRIES,
+			[NSDictionary dictionaryWithObjectsAndKeys:
+			 ownerArrayReport, @"AIMutableOwnerArray",
+			 parallelReport, @"Parallel arrays",
+			 nil], KEY_OWNER_REPORT_STORAGE,
+			[[mismatches copy] autorelease], KEY_OWNER_REPORT_MISMATCHES,
+			nil];
+}
+
+/*!
+ * @brief Fill, query, update and empty one owner array per entry of ownerCounts, timing each step
+ *
+ * The object value of every array after filling and after replacing is written to objectValues, which must have
+ * room for twice arrayCount objects.
+ */
+- (NSDictionary *)runStorage:(Class)storageClass
+				  ownerCounts:(const uint8_t *)ownerCounts
+				   arrayCount:(NSUInteger)arrayCount
+					   owners:(NSArray *)owners
+					  objects:(NSArray *)objects
+				 objectValues:(id *)objectValues
+{
+	NSMutableDictionary	*costs = [NSMutableDictionary dictionary];
+	id					*arrays = calloc(arrayCount, sizeof(id));
+	NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+	malloc_statistics_t	startStatistics, endStatistics;
+	NSUInteger			i, round, owner, operations;
+	uint64_t			start;
+
+	malloc_zone_statistics(NULL, &startStatistics);
+
+	start = mach_absolute_time();
+	operations = 0;
+	for (i = 0; i < arrayCount; i++) {
+		arrays[i] = [[storageClass alloc] init];
+		for (owner = 0; owner < ownerCounts[i]; owner++) {
+			[arrays[i] setObject:[objects objectAtIndex:(i + owner) % OBJECT_POOL_SIZE]
+					   withOwner:[owners objectAtIndex:owner]
+				   priorityLevel:priorityForOwner(owner, 0)];
+			operations++;
+		}
+	}
+	addCost(costs, @"fill", operations, mach_absolute_time() - start);
+
+	malloc_zone_statistics(NULL, &endStatistics);
+
+	start = mach_absolute_time();
+	for (round = 0; round < OBJECT_VALUE_ROUNDS; round++) {
+		for (i = 0; i < arrayCount; i++) {
+			objectValues[i] = [arrays[i] objectValue];
+		}
+	}
+	addCost(costs, @"objectValue", arrayCount * OBJECT_VALUE_ROUNDS, mach_absolute_time() - start);
+
+	start = mach_absolute_time();
+	for (i = 0; i < arrayCount; i++) {
+		[arrays[i] objectWithOwner:[owners objectAtIndex:ownerCounts[i] - 1]];
+	}
+	addCost(costs, @"objectWithOwner:", arrayCount, mach_absolute_time() - start);
+
+	//Every owner sets a new object at a new priority, as when a contact's status changes
+	start = mach_absolute_time();
+	operations = 0;
+	for (i = 0; i < arrayCount; i++) {
+		for (owner = 0; owner < ownerCounts[i]; owner++) {
+			[arrays[i] setObject:[objects objectAtIndex:(i + owner + 1) % OBJECT_POOL_SIZE]
+					   withOwner:[owners objectAtIndex:owner]
+				   priorityLevel:priorityForOwner(owner, 1)];
+			operations++;
+		}
+		objectValues[arrayCount + i] = [arrays[i] objectValue];
+	}
+	addCost(costs, @"replace and objectValue", operations, mach_absolute_time() - start);
+
+	start = mach_absolute_time();
+	operations = 0;
+	for (i = 0; i < arrayCount; i++) {
+		for (owner = 0; owner < ownerCounts[i]; owner++) {
+			[arrays[i] setObject:nil withOwner:[owners objectAtIndex:owner] priorityLevel:Medium_Priority];
+			operations++;
+		}
+	}
+	addCost(costs, @"remove", operations, mach_absolute_time() - start);
+
+	start = mach_absolute_time();
+	for (i = 0; i < arrayCount; i++) {
+		[arrays[i] release];
+	}
+	addCost(costs, @"release", arrayCount, mach_absolute_time() - start);
+
+	[pool release];
+	free(arrays);
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithLongLong:((long long)endStatistics.size_in_use - (long long)startStatistics.size_in_use)], KEY_OWNER_REPORT_BYTES,
+			[NSNumber numberWithLongLong:((long long)endStatistics.blocks_in_use - (long long)startStatistics.blocks_in_use)], KEY_OWNER_REPORT_BLOCKS,
+			costs, KEY_OWNER_REPORT_OPERATIONS,
+			nil];
+}
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSArray			*reportMismatches = [report objectForKey:KEY_OWNER_REPORT_MISMATCHES];
+	NSDictionary	*storage = [report objectForKey:KEY_OWNER_REPORT_STORAGE];
+	NSUInteger		arrayCount = [[report objectForKey:KEY_OWNER_REPORT_ARRAYS] unsignedIntegerValue];
+
+	[description appendFormat:@"Contacts: %@, %@ owner arrays holding %@ entries\n",
+	 [report objectForKey:KEY_OWNER_REPORT_CONTACTS], [report objectForKey:KEY_OWNER_REPORT_ARRAYS],
+	 [report objectForKey:KEY_OWNER_REPORT_ENTRIES]];
+	[description appendFormat:@"Mismatches: %lu\n", (unsigned long)reportMismatches.count];
+
+	for (NSUInteger i = 0; i < reportMismatches.count && i < MAX_REPORTED_MISMATCHES; i++) {
+		[description appendFormat:@"  %@\n", [reportMismatches objectAtIndex:i]];
+	}
+
+	for (NSString *storageName in [[storage allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		NSDictionary	*storageReport = [storage objectForKey:storageName];
+		NSDictionary	*costs = [storageReport objectForKey:KEY_OWNER_REPORT_OPERATIONS];
+		long long		bytes = [[storageReport objectForKey:KEY_OWNER_REPORT_BYTES] longLongValue];
+
+		[description appendFormat:@"\n%@: %lld bytes in %lld blocks once filled (%.1f bytes per array)\n",
+		 storageName, bytes, [[storageReport objectForKey:KEY_OWNER_REPORT_BLOCKS] longLongValue],
+		 (arrayCount ? (double)bytes / arrayCount : 0.0)];
+
+		for (NSString *name in [[costs allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+			NSDictionary	*cost = [costs objectForKey:name];
+			NSUInteger		count = [[cost objectForKey:@"Count"] unsignedIntegerValue];
+			double			seconds = [[cost objectForKey:@"Seconds"] doubleValue];
+
+			[description appendFormat:@"  %-50s %8lu  %9.3f s  %10.3f us each\n",
+			 [name UTF8String], (unsigned long)count, seconds, (count ? seconds * USEC_PER_SEC / count : 0.0)];
+		}
+	}
+
+	return description;
+}
+
+@end
@@ -0,0 +1,60 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+
+//Report keys
+#define KEY_PROPERTY_REPORT_CONTACTS		@"Contacts"
+#define KEY_PROPERTY_REPORT_SETS			@"Property Sets"
+#define KEY_PROPERTY_REPORT_NOTIFICATIONS	@"Notifications"
+#define KEY_PROPERTY_REPORT_STORAGE			@"Storage"
+#define KEY_PROPERTY_REPORT_BYTES			@"Bytes In Use Delta"
+#define KEY_PROPERTY_REPORT_BLOCKS			@"Blocks In Use Delta"
+#define KEY_PROPERTY_REPORT_OPERATIONS		@"Operations"
+#define KEY_PROPERTY_REPORT_MISMATCHES		@"Mismatches"
+
+/*!
+ * @class AIPropertyStoreBenchmark
+ * @brief Replays presence-style property sets over a synthetic contact list and measures what storing them costs
+ *
+ * A trace of setCount property sets is generated over contactCount objects: bursts of NotifyLater sets of the keys a
+ * presence update touches, each followed by -notifyOfChangedPropertiesSilently:, with some keys outside the key
+ * registry mixed in. The trace is replayed into ESObjectWithProperties and into a copy of the dictionary storage it
+ * used to have, and the memory each holds and the time each step takes are reported side by side. The values and
+ * the changed keys each reports are checked against each other.
+ *
+ * Run with -AIPropertyStoreBenchmark YES. Settings:
+ *	-AIPropertyStoreBenchmarkContacts <n>	Objects to set properties on (20000)
+ *	-AIPropertyStoreBenchmarkSets <n>		Property sets to replay (1000000)
+ *	-AIContactListBenchmarkSeed <n>			Seed for the random choices (1)
+ */
+@interface AIPropertyStoreBenchmark : NSObject <AIBenchmark> {
+	NSUInteger			contactCount;
+	NSUInteger			setCount;
+	uint32_t			seed;
+
+	NSMutableArray		*mismatches;
+}
+
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger contactCount;
+@property (readwrite, nonatomic) NSUInteger setCount;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
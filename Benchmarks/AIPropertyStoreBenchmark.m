@@ -0,0 +1,509 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIPropertyStoreBenchmark.h"
+#import <Adium/ESObjectWithProperties.h>
+#import <malloc/malloc.h>
+#import <mach/mach_time.h>
+#import <objc/runtime.h>
+
+//Settings
+#define KEY_PROPERTY_BENCHMARK_CONTACTS		@"AIPropertyStoreBenchmarkContacts"
+#define KEY_PROPERTY_BENCHMARK_SETS			@"AIPropertyStoreBenchmarkSets"
+
+//The longest burst of sets before the changes are notified, as when a contact signs on
+#define MAX_SETS_PER_UPDATE				8
+//One set in this many is of a key outside the key registry
+#define UNREGISTERED_KEY_FREQUENCY		5
+//One set in this many clears the property
+#define NIL_VALUE_FREQUENCY				5
+//How many distinct values are stored, so the values themselves don't count towards memory use
+#define VALUE_POOL_SIZE					32
+#define NIL_VALUE						UINT8_MAX
+//How many mismatches are described in the report
+#define MAX_REPORTED_MISMATCHES			20
+
+/*!
+ * @brief The keys a presence update sets: registered ones first, then some which aren't
+ *
+ * idleSince and idle are backed by ivars of the benchmark objects, as they are in AIListContact.
+ */
+static NSString *const benchmarkKeys[] = {
+	@"isOnline", @"idleSince", @"idle", @"isIdle", @"isMobile", @"notAStranger", @"signedOn", @"signedOff",
+	@"Signon Date", @"listObjectStatusMessage", @"Warning",
+	@"ProfileArray", @"Client", @"Capabilities", @"StatusIconName"
+};
+#define BENCHMARK_KEY_COUNT				(sizeof(benchmarkKeys) / sizeof(benchmarkKeys[0]))
+#define REGISTERED_BENCHMARK_KEY_COUNT	11
+
+/*!
+ * @class AIBenchmarkPropertyObject
+ * @brief An ESObjectWithProperties with a couple of ivar-backed properties, counting the changed keys it is told of
+ */
+@interface AIBenchmarkPropertyObject : ESObjectWithProperties {
+	NSDate		*idleSince;
+	NSInteger	idle;
+	NSUInteger	notifiedKeyCount;
+}
+@property (readonly, nonatomic) NSUInteger notifiedKeyCount;
+@end
+
+@implementation AIBenchmarkPropertyObject
+
+@synthesize notifiedKeyCount;
+
+- (void)dealloc
+{
+	[idleSince release];
+
+	[super dealloc];
+}
+
+- (void)didModifyProperties:(NSSet *)keys silent:(BOOL)silent
+{
+	notifiedKeyCount += keys.count;
+}
+
+@end
+
+/*!
+ * @class AIDictionaryPropertyObject
+ * @brief The storage ESObjectWithProperties used to have: a dictionary of properties and a set of changed keys
+ *
+ * Only what the benchmark uses is here, done the same way it was, with the same ivars as AIBenchmarkPropertyObject.
+ */
+@interface AIDictionaryPropertyObject : NSObject {
+	NSMutableDictionary		*propertiesDictionary;
+	NSMutableSet			*changedProperties;
+	NSMutableDictionary		*displayDictionary;
+	NSMutableSet			*proxyObjects;
+
+	NSDate		*idleSince;
+	NSInteger	idle;
+	NSUInteger	notifiedKeyCount;
+}
+- (void)setValue:(id)value forProperty:(NSString *)key notify:(NotifyTiming)notify;
+- (id)valueForProperty:(NSString *)key;
+- (void)notifyOfChangedPropertiesSilently:(BOOL)silent;
+@property (readonly, nonatomic) NSUInteger notifiedKeyCount;
+@end
+
+@implementation AIDictionaryPropertyObject
+
+@synthesize notifiedKeyCount;
+
+- (void)dealloc
+{
+	[propertiesDictionary release];
+	[changedProperties release];
+	[idleSince release];
+
+	[super dealloc];
+}
+
+- (void)setValue:(id)value forProperty:(NSString *)key notify:(NotifyTiming)notify
+{
+	id oldValue = [self valueForProperty:key];
+	if (value == oldValue) return;
+
+	[self willChangeValueForKey:key];
+
+	Ivar ivar = class_getInstanceVariable([self class], [key UTF8String]);
+
+	if (ivar == NULL) {
+		if (!propertiesDictionary && value) propertiesDictionary = [[NSMutableDictionary alloc] init];
+
+		if (value) {
+			[propertiesDictionary setObject:value forKey:key];
+		} else {
+			[propertiesDictionary removeObjectForKey:key];
+		}
+
+	} else {
+		const char *ivarType = ivar_getTypeEncoding(ivar);
+
+		if (ivarType[0] == _C_ID) {
+			[oldValue release];
+			object_setIvar(self, ivar, [value retain]);
+		} else if (strcmp(ivarType, @encode(NSInteger)) == 0) {
+			object_setIvar(self, ivar, (void *)(value ? [value integerValue] : 0));
+		}
+	}
+
+	if (notify == NotifyNow) {
+		notifiedKeyCount++;
+	} else if (notify == NotifyLater) {
+		if (!changedProperties) changedProperties = [[NSMutableSet alloc] init];
+		[changedProperties addObject:key];
+	}
+
+	[self didChangeValueForKey:key];
+}
+
+- (id)valueForProperty:(NSString *)key
+{
+	id value = nil;
+	Ivar ivar = object_getInstanceVariable(self, [key UTF8String], (void **)&value);
+
+	if (ivar == NULL) return [propertiesDictionary objectForKey:key];
+
+	if (strcmp(ivar_getTypeEncoding(ivar), @encode(NSInteger)) == 0)
+		return [[[NSNumber alloc] initWithInteger:(NSInteger)value] autorelease];
+
+	return [[value retain] autorelease];
+}
+
+- (void)notifyOfChangedPropertiesSilently:(BOOL)silent
+{
+	if (changedProperties && [changedProperties count]) {
+		NSSet *keys = changedProperties;
+		changedProperties = nil;
+
+		notifiedKeyCount += keys.count;
+
+		[keys release];
+	}
+}
+
+@end
+
+#pragma mark -
+
+/*!
+ * @brief A generated sequence of property sets
+ */
+typedef struct {
+	NSUInteger	count;
+	uint32_t	*contacts;		//Which object each set is on
+	uint8_t		*keys;			//Index into benchmarkKeys
+	uint8_t		*values;		//Index into the value pool, or NIL_VALUE
+	BOOL		*notifyAfter;	//Whether -notifyOfChangedPropertiesSilently: follows the set
+} AIPropertySetTrace;
+
+@interface AIPropertyStoreBenchmark ()
+- (NSDictionary *)runStorage:(Class)storageClass
+					   trace:(const AIPropertySetTrace *)trace
+					  values:(NSArray *)valuePool
+				 finalValues:(id *)finalValues
+			  notifiedCounts:(NSUInteger *)notifiedCounts;
+@end
+
+/*!
+ * @brief The same generator as AIContactListTrace's, so a seed gives the same contact list everywhere
+ */
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+static void addCost(NSMutableDictionary *costs, NSString *costName, NSUInteger count, uint64_t machTime)
+{
+	[costs setObject:[NSDictionary dictionaryWithObjectsAndKeys:
+					  [NSNumber numberWithUnsignedInteger:count], @"Count",
+					  [NSNumber numberWithDouble:secondsFromMachTime(machTime)], @"Seconds",
+					  nil]
+			  forKey:costName];
+}
+
+/*!
+ * @brief A value of the right type for a key: numbers for idle, dates for idleSince, anything for the rest
+ */
+static uint8_t valueForKey(NSUInteger keyIndex, uint32_t *state)
+{
+	if (nextRandom(state) % NIL_VALUE_FREQUENCY == 0) return NIL_VALUE;
+
+	if ([benchmarkKeys[keyIndex] isEqualToString:@"idle"]) return nextRandom(state) % 8;
+	if ([benchmarkKeys[keyIndex] isEqualToString:@"idleSince"]) return 8 + nextRandom(state) % 8;
+
+	return nextRandom(state) % VALUE_POOL_SIZE;
+}
+
+@implementation AIPropertyStoreBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:20000], KEY_PROPERTY_BENCHMARK_CONTACTS,
+			[NSNumber numberWithUnsignedInteger:1000000], KEY_PROPERTY_BENCHMARK_SETS,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AIPropertyStoreBenchmark *benchmark = [[[self alloc] init] autorelease];
+
+	benchmark.contactCount = [defaults integerForKey:KEY_PROPERTY_BENCHMARK_CONTACTS];
+	benchmark.setCount = [defaults integerForKey:KEY_PROPERTY_BENCHMARK_SETS];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (id)init
+{
+	if ((self = [super init])) {
+		contactCount = 20000;
+		setCount = 1000000;
+		seed = 1;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[mismatches release];
+
+	[super dealloc];
+}
+
+@synthesize contactCount, setCount, seed;
+
+/*!
+ * @brief Replay the same trace into both kinds of storage, check they agree, and report
+ */
+- (NSDictionary *)run
+{
+	AIPropertySetTrace	trace;
+	NSMutableArray		*valuePool = [NSMutableArray array];
+	NSUInteger			valueCount = contactCount * BENCHMARK_KEY_COUNT;
+	id					*finalValues = calloc(valueCount, sizeof(id));
+	id					*dictionaryFinalValues = calloc(valueCount, sizeof(id));
+	NSUInteger			*notifiedCounts = calloc(contactCount, sizeof(NSUInteger));
+	NSUInteger			*dictionaryNotifiedCounts = calloc(contactCount, sizeof(NSUInteger));
+	NSUInteger			notifications = 0;
+	uint32_t			state = seed;
+	NSUInteger			i;
+
+	[mismatches release]; mismatches = [[NSMutableArray alloc] init];
+
+	//Numbers, dates and strings, as presence updates store
+	for (i = 0; i < VALUE_POOL_SIZE; i++) {
+		if (i < 8) {
+			[valuePool addObject:[NSNumber numberWithUnsignedInteger:i]];
+		} else if (i < 16) {
+			[valuePool addObject:[NSDate dateWithTimeIntervalSinceReferenceDate:(NSTimeInterval)i * 3600]];
+		} else {
+			[valuePool addObject:[NSString stringWithFormat:@"Value %lu", (unsigned long)i]];
+		}
+	}
+
+	trace.count = setCount;
+	trace.contacts = malloc(setCount * sizeof(uint32_t));
+	trace.keys = malloc(setCount);
+	trace.values = malloc(setCount);
+	trace.notifyAfter = calloc(setCount, sizeof(BOOL));
+
+	for (i = 0; i < setCount && contactCount; ) {
+		uint32_t	contact = nextRandom(&state) % contactCount;
+		NSUInteger	burst = 1 + nextRandom(&state) % MAX_SETS_PER_UPDATE;
+
+		for (; burst > 0 && i < setCount; burst--, i++) {
+			NSUInteger keyIndex;
+			if (nextRandom(&state) % UNREGISTERED_KEY_FREQUENCY == 0) {
+				keyIndex = REGISTERED_BENCHMARK_KEY_COUNT + nextRandom(&state) % (BENCHMARK_KEY_COUNT - REGISTERED_BENCHMARK_KEY_COUNT);
+			} else {
+				keyIndex = nextRandom(&state) % REGISTERED_BENCHMARK_KEY_COUNT;
+			}
+
+			trace.contacts[i] = contact;
+			trace.keys[i] = (uint8_t)keyIndex;
+			trace.values[i] = valueForKey(keyIndex, &state);
+		}
+
+		trace.notifyAfter[i - 1] = YES;
+		notifications++;
+	}
+	trace.count = i;
+
+	NSDictionary *slotReport = [self runStorage:[AIBenchmarkPropertyObject class]
+										  trace:&trace
+										 values:valuePool
+									finalValues:finalValues
+								 notifiedCounts:notifiedCounts];
+	NSDictionary *dictionaryReport = [self runStorage:[AIDictionaryPropertyObject class]
+												trace:&trace
+											   values:valuePool
+										  finalValues:dictionaryFinalValues
+									   notifiedCounts:dictionaryNotifiedCounts];
+
+	for (i = 0; i < valueCount; i++) {
+		if (finalValues[i] != dictionaryFinalValues[i] && ![finalValues[i] isEqual:dictionaryFinalValues[i]]) {
+			[mismatches addObject:[NSString stringWithFormat:@"contact %lu %@: ESObjectWithProperties %@, dictionary %@",
+								   (unsigned long)(i / BENCHMARK_KEY_COUNT), benchmarkKeys[i % BENCHMARK_KEY_COUNT],
+								   finalValues[i], dictionaryFinalValues[i]]];
+		}
+	}
+	for (i = 0; i < contactCount; i++) {
+		if (notifiedCounts[i] != dictionaryNotifiedCounts[i]) {
+			[mismatches addObject:[NSString stringWithFormat:@"contact %lu: ESObjectWithProperties notified of %lu changed keys, dictionary %lu",
+								   (unsigned long)i, (unsigned long)notifiedCounts[i], (unsigned long)dictionaryNotifiedCounts[i]]];
+		}
+	}
+
+	for (i = 0; i < valueCount; i++) {
+		[finalValues[i] release];
+		[dictionaryFinalValues[i] release];
+	}
+	free(finalValues);
+	free(dictionaryFinalValues);
+	free(notifiedCounts);
+	free(dictionaryNotifiedCounts);
+	free(trace.contacts);
+	free(trace.keys);
+	free(trace.values);
+	free(trace.notifyAfter);
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:contactCount], KEY_PROPERTY_REPORT_CONTACTS,
+			[NSNumber numberWithUnsignedInteger:trace.count], KEY_PROPERTY_REPORT_SETS,
+			[NSNumber numberWithUnsignedInteger:notifications], KEY_PROPERTY_REPORT_NOTIFICATIONS,
+			[NSDictionary dictionaryWithObjectsAndKeys:
+			 slotReport, @"ESObjectWithProperties",
+			 dictionaryReport, @"Dictionary and set",
+			 nil], KEY_PROPERTY_REPORT_STORAGE,
+			[[mismatches copy] autorelease], KEY_PROPERTY_REPORT_MISMATCHES,
+			nil];
+}
+
+/*!
+ * @brief Create the objects, replay the trace into them, read every property back and release them, timing each step
+ *
+ * Every object's final value for each of benchmarkKeys is retained into finalValues, which must have room for
+ * contactCount * BENCHMARK_KEY_COUNT objects; the number of changed keys each object was notified of goes in
+ * notifiedCounts.
+ */
+- (NSDictionary *)runStorage:(Class)storageClass
+					   trace:(const AIPropertySetTrace *)trace
+					  values:(NSArray *)valuePool
+				 finalValues:(id *)finalValues
+			  notifiedCounts:(NSUInteger *)notifiedCounts
+{
+	NSMutableDictionary	*costs = [NSMutableDictionary dictionary];
+	id					*objects = calloc(contactCount, sizeof(id));
+	NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+	malloc_statistics_t	startStatistics, endStatistics;
+	NSUInteger			i, key;
+	uint64_t			start;
+
+	malloc_zone_statistics(NULL, &startStatistics);
+
+	start = mach_absolute_time();
+	for (i = 0; i < contactCount; i++) {
+		objects[i] = [[storageClass alloc] init];
+	}
+	addCost(costs, @"create", contactCount, mach_absolute_time() - start);
+
+	start = mach_absolute_time();
+	for (i = 0; i < trace->count; i++) {
+		id object = objects[trace->contacts[i]];
+
+		[object setValue:(trace->values[i] == NIL_VALUE ? nil : [valuePool objectAtIndex:trace->values[i]])
+			 forProperty:benchmarkKeys[trace->keys[i]]
+				  notify:NotifyLater];
+
+		if (trace->notifyAfter[i]) {
+			[object notifyOfChangedPropertiesSilently:YES];
+		}
+
+		//Don't let the boxed NSIntegers pile up
+		if (i % 10000 == 0) {
+			[pool release];
+			pool = [[NSAutoreleasePool alloc] init];
+		}
+	}
+	addCost(costs, @"setValue:forProperty:notify: and notify", trace->count, mach_absolute_time() - start);
+
+	[pool release];
+	pool = [[NSAutoreleasePool alloc] init];
+	malloc_zone_statistics(NULL, &endStatistics);
+
+	start = mach_absolute_time();
+	for (i = 0; i < contactCount; i++) {
+		for (key = 0; key < BENCHMARK_KEY_COUNT; key++) {
+			finalValues[i * BENCHMARK_KEY_COUNT + key] = [[objects[i] valueForProperty:benchmarkKeys[key]] retain];
+		}
+		notifiedCounts[i] = [objects[i] notifiedKeyCount];
+	}
+	addCost(costs, @"valueForProperty:", contactCount * BENCHMARK_KEY_COUNT, mach_absolute_time() - start);
+
+	start = mach_absolute_time();
+	for (i = 0; i < contactCount; i++) {
+		[objects[i] release];
+	}
+	addCost(costs, @"release", contactCount, mach_absolute_time() - start);
+
+	[pool release];
+	free(objects);
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithLongLong:((long long)endStatistics.size_in_use - (long long)startStatistics.size_in_use)], KEY_PROPERTY_REPORT_BYTES,
+			[NSNumber numberWithLongLong:((long long)endStatistics.blocks_in_use - (long long)startStatistics.blocks_in_use)], KEY_PROPERTY_REPORT_BLOCKS,
+			costs, KEY_PROPERTY_REPORT_OPERATIONS,
+			nil];
+}
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSArray			*reportMismatches = [report objectForKey:KEY_PROPERTY_REPORT_MISMATCHES];
+	NSDictionary	*storage = [report objectForKey:KEY_PROPERTY_REPORT_STORAGE];
+	NSUInteger		reportContacts = [[report objectForKey:KEY_PROPERTY_REPORT_CONTACTS] unsignedIntegerValue];
+
+	[description appendFormat:@"Contacts: %@, %@ property sets in %@ notifications\n",
+	 [report objectForKey:KEY_PROPERTY_REPORT_CONTACTS], [report objectForKey:KEY_PROPERTY_REPORT_SETS],
+	 [report objectForKey:KEY_PROPERTY_REPORT_NOTIFICATIONS]];
+	[description appendFormat:@"Mismatches: %lu\n", (unsigned long)reportMismatches.count];
+
+	for (NSUInteger i = 0; i < reportMismatches.count && i < MAX_REPORTED_MISMATCHES; i++) {
+		[description appendFormat:@"  %@\n", [reportMismatches objectAtIndex:i]];
+	}
+
+	for (NSString *storageName in [[storage allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		NSDictionary	*storageReport = [storage objectForKey:storageName];
+		NSDictionary	*costs = [storageReport objectForKey:KEY_PROPERTY_REPORT_OPERATIONS];
+		long long		bytes = [[storageReport objectForKey:KEY_PROPERTY_REPORT_BYTES] longLongValue];
+
+		[description appendFormat:@"\n%@: %lld bytes in %lld blocks after the replay (%.1f bytes per contact)\n",
+		 storageName, bytes, [[storageReport objectForKey:KEY_PROPERTY_REPORT_BLOCKS] longLongValue],
+		 (reportContacts ? (double)bytes / reportContacts : 0.0)];
+
+		for (NSString *name in [[costs allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+			NSDictionary	*cost = [costs objectForKey:name];
+			NSUInteger		count = [[cost objectForKey:@"Count"] unsignedIntegerValue];
+			double			seconds = [[cost objectForKey:@"Seconds"] doubleValue];
+
+			[description appendFormat:@"  %-50s %8lu  %9.3f s  %10.3f us each\n",
+			 [name UTF8String], (unsigned long)count, seconds, (count ? seconds * USEC_PER_SEC / count : 0.0)];
+		}
+	}
+
+	return description;
+}
+
+@end
@@ -0,0 +1,91 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+
+@class AIReconnectScheduler, AIReconnectBenchmarkClock;
+
+//Report keys
+#define KEY_RECONNECT_REPORT_ACCOUNTS			@"Accounts"
+#define KEY_RECONNECT_REPORT_SERVICES			@"Services"
+#define KEY_RECONNECT_REPORT_POLICIES			@"Policies"
+#define KEY_RECONNECT_REPORT_ALL_ONLINE			@"Seconds Until All Online"
+#define KEY_RECONNECT_REPORT_HANDSHAKES			@"Handshakes"
+#define KEY_RECONNECT_REPORT_REJECTED			@"Rejected Handshakes"
+#define KEY_RECONNECT_REPORT_FAILED				@"Failed Handshakes"
+#define KEY_RECONNECT_REPORT_PEAK_CONCURRENT	@"Peak Concurrent Handshakes"
+#define KEY_RECONNECT_REPORT_PEAK_PER_SECOND	@"Peak Handshakes Per Second"
+#define KEY_RECONNECT_REPORT_PER_SECOND			@"Handshakes Started Each Second"
+#define KEY_RECONNECT_REPORT_DATE_CHANGES		@"Reconnect Date Changes"
+#define KEY_RECONNECT_REPORT_NOTIFICATIONS		@"Reconnect Date Notifications"
+
+/*!
+ * @class AIReconnectSchedulerBenchmark
+ * @brief Simulates accounts coming back online together, with AIReconnectScheduler and with per-account backoff
+ *
+ * accountCount fake accounts spread over serviceCount services are offline, waiting for the network, which returns at
+ * time 0. flapAfter seconds later it drops again for flapSeconds, dropping any handshakes in progress. Time is
+ * simulated, so a run takes no longer than the work it does.
+ *
+ * A handshake takes a second or two, longer the more handshakes are in progress. Each fails with failurePercent
+ * chance, and a service rejects handshakes beyond SERVER_BURST_LIMIT started within a second, as servers which rate
+ * limit logins do. Failed accounts retry, either through AIReconnectScheduler or with the fixed exponential backoff
+ * AIAbstractAccount used before it, connecting at once when the network returns.
+ *
+ * The time until every account is online, the burst of handshakes started, and the waitingToReconnect updates the
+ * accounts' observers would be told of are reported for each.
+ *
+ * Run with -AIReconnectSchedulerBenchmark YES. Settings:
+ *	-AIReconnectSchedulerBenchmarkAccounts <n>	Simulated accounts (50)
+ *	-AIReconnectSchedulerBenchmarkServices <n>	Services they are spread over (5)
+ *	-AIContactListBenchmarkSeed <n>				Seed for the random choices (1)
+ */
+@interface AIReconnectSchedulerBenchmark : NSObject <AIBenchmark> {
+	NSUInteger					accountCount;
+	NSUInteger					serviceCount;
+	NSUInteger					failurePercent;
+	NSTimeInterval				flapAfter;
+	NSTimeInterval				flapSeconds;
+	uint32_t					seed;
+
+	//The simulation in progress
+	BOOL						useScheduler;
+	uint32_t					randomState;
+	NSTimeInterval				now;
+	BOOL						networkIsUp;
+	NSMutableArray				*accounts;
+	AIReconnectBenchmarkClock	*clock;
+	AIReconnectScheduler		*scheduler;
+	NSMutableArray				*startTimes;
+	NSMutableArray				*serviceStartTimes;
+	NSUInteger					connectingCount;
+	NSUInteger					peakConnectingCount;
+	NSUInteger					rejectedCount;
+	NSUInteger					failedCount;
+}
+
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger accountCount;
+@property (readwrite, nonatomic) NSUInteger serviceCount;
+@property (readwrite, nonatomic) NSUInteger failurePercent;
+@property (readwrite, nonatomic) NSTimeInterval flapAfter;
+@property (readwrite, nonatomic) NSTimeInterval flapSeconds;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
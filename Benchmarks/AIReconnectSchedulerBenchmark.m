@@ -0,0 +1,482 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIReconnectSchedulerBenchmark.h"
+#import <Adium/AIReconnectScheduler.h>
+#import <mach/mach_time.h>
+
+//Settings
+#define KEY_RECONNECT_BENCHMARK_ACCOUNTS	@"AIReconnectSchedulerBenchmarkAccounts"
+#define KEY_RECONNECT_BENCHMARK_SERVICES	@"AIReconnectSchedulerBenchmarkServices"
+
+//A handshake takes HANDSHAKE_SECONDS plus up to as much again, plus CONTENTION_SECONDS for each one already going
+#define HANDSHAKE_SECONDS			1.0
+#define CONTENTION_SECONDS			0.25
+//A service rejects handshakes beyond this many started within a second, after REJECTION_SECONDS
+#define SERVER_BURST_LIMIT			3
+#define REJECTION_SECONDS			0.5
+//The accounts' minimum reconnect delay, as AIAbstractAccount's RECONNECT_MIN_TIME
+#define MINIMUM_DELAY				5.0
+//The old per-account backoff: BACKOFF_BASE^attempts, clamped to MINIMUM_DELAY and BACKOFF_MAXIMUM
+#define BACKOFF_BASE				1.75
+#define BACKOFF_MAXIMUM				600.0
+//Give up on a policy which hasn't got everyone online after this long
+#define SIMULATION_LIMIT			(24 * 3600.0)
+//How many seconds of handshake starts are reported one by one
+#define REPORTED_SECONDS			30
+
+/*!
+ * @class AIReconnectBenchmarkClock
+ * @brief Simulated time for the scheduler; the benchmark advances it and wakes the scheduler
+ */
+@interface AIReconnectBenchmarkClock : NSObject <AIReconnectSchedulerClock> {
+@public
+	NSTimeInterval	time;
+	NSTimeInterval	wakeTime;
+}
+@end
+
+@implementation AIReconnectBenchmarkClock
+
+- (NSTimeInterval)currentTime
+{
+	return time;
+}
+
+- (void)wakeScheduler:(AIReconnectScheduler *)scheduler atTime:(NSTimeInterval)inTime
+{
+	wakeTime = inTime;
+}
+
+@end
+
+/*!
+ * @class AIReconnectBenchmarkAccount
+ * @brief A fake account: only what connecting takes
+ */
+@interface AIReconnectBenchmarkAccount : NSObject <AIReconnectSchedulerClient> {
+@public
+	AIReconnectSchedulerBenchmark	*benchmark;
+	NSUInteger						 serviceIndex;
+	NSString						*service;
+	NSString						*host;
+
+	BOOL							 online;
+	BOOL							 connecting;
+	BOOL							 willBeRejected;
+	NSTimeInterval					 handshakeEndTime;
+	NSTimeInterval					 nextAttemptTime;	//For the per-account backoff; 0 if not waiting
+	NSUInteger						 attempts;
+
+	NSUInteger						 dateChanges;
+	NSUInteger						 notifications;
+	BOOL							 dateChanged;
+}
+@end
+
+@interface AIReconnectSchedulerBenchmark ()
+- (NSDictionary *)runUsingScheduler:(BOOL)inUseScheduler;
+- (void)startHandshakeForAccount:(AIReconnectBenchmarkAccount *)account;
+- (void)finishHandshakeForAccount:(AIReconnectBenchmarkAccount *)account;
+- (void)retryAccount:(AIReconnectBenchmarkAccount *)account;
+- (void)setNetworkIsUp:(BOOL)up;
+@end
+
+@implementation AIReconnectBenchmarkAccount
+
+- (void)dealloc
+{
+	[service release];
+	[host release];
+
+	[super dealloc];
+}
+
+- (NSString *)reconnectServiceIdentifier
+{
+	return service;
+}
+
+- (NSString *)reconnectHost
+{
+	return host;
+}
+
+- (void)performScheduledReconnect
+{
+	[benchmark startHandshakeForAccount:self];
+}
+
+- (void)setScheduledReconnectDate:(NSDate *)date
+{
+	dateChanges++;
+	dateChanged = YES;
+}
+
+- (void)notifyOfScheduledReconnectDate
+{
+	if (dateChanged) notifications++;
+	dateChanged = NO;
+}
+
+@end
+
+#pragma mark -
+
+/*!
+ * @brief The same generator as AIContactListTrace's
+ */
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double nextRandomFraction(uint32_t *state)
+{
+	return (double)nextRandom(state) / (1 << 24);
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+@implementation AIReconnectSchedulerBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:50], KEY_RECONNECT_BENCHMARK_ACCOUNTS,
+			[NSNumber numberWithUnsignedInteger:5], KEY_RECONNECT_BENCHMARK_SERVICES,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AIReconnectSchedulerBenchmark *benchmark = [[[self alloc] init] autorelease];
+
+	benchmark.accountCount = [defaults integerForKey:KEY_RECONNECT_BENCHMARK_ACCOUNTS];
+	benchmark.serviceCount = [defaults integerForKey:KEY_RECONNECT_BENCHMARK_SERVICES];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (id)init
+{
+	if ((self = [super init])) {
+		accountCount = 50;
+		serviceCount = 5;
+		failurePercent = 10;
+		flapAfter = 3.0;
+		flapSeconds = 5.0;
+		seed = 1;
+	}
+
+	return self;
+}
+
+@synthesize accountCount, serviceCount, failurePercent, flapAfter, flapSeconds, seed;
+
+/*!
+ * @brief Simulate the same network with each policy and report
+ */
+- (NSDictionary *)run
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:accountCount], KEY_RECONNECT_REPORT_ACCOUNTS,
+			[NSNumber numberWithUnsignedInteger:serviceCount], KEY_RECONNECT_REPORT_SERVICES,
+			[NSDictionary dictionaryWithObjectsAndKeys:
+			 [self runUsingScheduler:YES], @"AIReconnectScheduler",
+			 [self runUsingScheduler:NO], @"Per-account backoff",
+			 nil], KEY_RECONNECT_REPORT_POLICIES,
+			nil];
+}
+
+- (NSDictionary *)runUsingScheduler:(BOOL)inUseScheduler
+{
+	NSTimeInterval	lastOnlineTime = 0;
+	NSTimeInterval	networkEvents[] = { 0, flapAfter, flapAfter + flapSeconds };
+	NSUInteger		networkEventCount = (flapSeconds > 0 ? 3 : 1);
+	NSUInteger		networkEventIndex = 0;
+	NSUInteger		onlineCount = 0;
+	NSUInteger		i;
+	uint64_t		start = mach_absolute_time();
+
+	useScheduler = inUseScheduler;
+	randomState = seed;
+	now = -1;
+	networkIsUp = NO;
+	connectingCount = peakConnectingCount = rejectedCount = failedCount = 0;
+	startTimes = [[NSMutableArray alloc] init];
+	serviceStartTimes = [[NSMutableArray alloc] init];
+	accounts = [[NSMutableArray alloc] init];
+
+	if (useScheduler) {
+		clock = [[AIReconnectBenchmarkClock alloc] init];
+		if (clock) clock->time = now;
+		scheduler = [[AIReconnectScheduler alloc] initWithClock:clock];
+		[scheduler setRandomSeed:seed];
+	}
+
+	for (i = 0; i < serviceCount; i++) {
+		[serviceStartTimes addObject:[NSMutableArray array]];
+	}
+
+	for (i = 0; i < accountCount; i++) {
+		AIReconnectBenchmarkAccount *account = [[AIReconnectBenchmarkAccount alloc] init];
+
+		account->benchmark = self;
+		account->serviceIndex = (serviceCount ? i % serviceCount : 0);
+		account->service = [[NSString alloc] initWithFormat:@"service%lu", (unsigned long)account->serviceIndex];
+		account->host = [[NSString alloc] initWithFormat:@"%@.example.com", account->service];
+		[accounts addObject:account];
+		[account release];
+
+		[scheduler setHost:account->host reachable:NO];
+	}
+
+	while (onlineCount < accountCount && now < SIMULATION_LIMIT) {
+		NSTimeInterval next = SIMULATION_LIMIT;
+
+		//Find the next thing to happen
+		if (networkEventIndex < networkEventCount) next = MIN(next, networkEvents[networkEventIndex]);
+		for (AIReconnectBenchmarkAccount *account in accounts) {
+			if (account->connecting) next = MIN(next, account->handshakeEndTime);
+			if (account->nextAttemptTime) next = MIN(next, account->nextAttemptTime);
+		}
+		if (clock && clock->wakeTime) next = MIN(next, clock->wakeTime);
+
+		now = MAX(now, next);
+		if (clock) clock->time = now;
+
+		//Then make it happen
+		if (networkEventIndex < networkEventCount && networkEvents[networkEventIndex] <= now) {
+			[self setNetworkIsUp:!networkIsUp];
+			networkEventIndex++;
+		}
+
+		for (AIReconnectBenchmarkAccount *account in accounts) {
+			if (account->connecting && account->handshakeEndTime <= now) {
+				[self finishHandshakeForAccount:account];
+				if (account->online) {
+					onlineCount++;
+					lastOnlineTime = now;
+				}
+			}
+		}
+
+		for (AIReconnectBenchmarkAccount *account in accounts) {
+			if (account->nextAttemptTime && account->nextAttemptTime <= now) {
+				account->nextAttemptTime = 0;
+				if (networkIsUp) {
+					[self startHandshakeForAccount:account];
+				} else {
+					[self retryAccount:account];
+				}
+			}
+		}
+
+		if (clock && clock->wakeTime && clock->wakeTime <= now) {
+			clock->wakeTime = 0;
+			[scheduler clockDidReachWakeTime];
+		}
+		[scheduler flushClientNotifications];
+	}
+
+	//Tally the bursts
+	NSUInteger	perSecond[REPORTED_SECONDS] = { 0 };
+	NSUInteger	peakPerSecond = 0, windowStart = 0;
+	NSUInteger	dateChanges = 0, notifications = 0;
+
+	for (i = 0; i < startTimes.count; i++) {
+		NSTimeInterval startTime = [[startTimes objectAtIndex:i] doubleValue];
+
+		if (startTime >= 0 && startTime < REPORTED_SECONDS) perSecond[(NSUInteger)startTime]++;
+
+		while ([[startTimes objectAtIndex:windowStart] doubleValue] <= startTime - 1.0) windowStart++;
+		peakPerSecond = MAX(peakPerSecond, i + 1 - windowStart);
+	}
+
+	NSMutableArray *perSecondReport = [NSMutableArray array];
+	for (i = 0; i < REPORTED_SECONDS; i++) {
+		[perSecondReport addObject:[NSNumber numberWithUnsignedInteger:perSecond[i]]];
+	}
+
+	for (AIReconnectBenchmarkAccount *account in accounts) {
+		dateChanges += account->dateChanges;
+		notifications += account->notifications;
+	}
+
+	NSDictionary *report = [NSDictionary dictionaryWithObjectsAndKeys:
+							[NSNumber numberWithDouble:(onlineCount == accountCount ? lastOnlineTime : -1)], KEY_RECONNECT_REPORT_ALL_ONLINE,
+							[NSNumber numberWithUnsignedInteger:startTimes.count], KEY_RECONNECT_REPORT_HANDSHAKES,
+							[NSNumber numberWithUnsignedInteger:rejectedCount], KEY_RECONNECT_REPORT_REJECTED,
+							[NSNumber numberWithUnsignedInteger:failedCount], KEY_RECONNECT_REPORT_FAILED,
+							[NSNumber numberWithUnsignedInteger:peakConnectingCount], KEY_RECONNECT_REPORT_PEAK_CONCURRENT,
+							[NSNumber numberWithUnsignedInteger:peakPerSecond], KEY_RECONNECT_REPORT_PEAK_PER_SECOND,
+							perSecondReport, KEY_RECONNECT_REPORT_PER_SECOND,
+							[NSNumber numberWithUnsignedInteger:dateChanges], KEY_RECONNECT_REPORT_DATE_CHANGES,
+							[NSNumber numberWithUnsignedInteger:notifications], KEY_RECONNECT_REPORT_NOTIFICATIONS,
+							[NSNumber numberWithDouble:secondsFromMachTime(mach_absolute_time() - start)], @"Simulation Seconds",
+							nil];
+
+	[scheduler release]; scheduler = nil;
+	[clock release]; clock = nil;
+	[accounts release]; accounts = nil;
+	[startTimes release]; startTimes = nil;
+	[serviceStartTimes release]; serviceStartTimes = nil;
+
+	return report;
+}
+
+#pragma mark The network
+
+/*!
+ * @brief The network went down or came back, as ESAccountNetworkConnectivityPlugin would hear of it
+ */
+- (void)setNetworkIsUp:(BOOL)up
+{
+	networkIsUp = up;
+
+	if (!up) {
+		//Handshakes in progress are dropped, and the accounts wait for the network
+		for (AIReconnectBenchmarkAccount *account in accounts) {
+			if (account->connecting) {
+				account->connecting = NO;
+				connectingCount--;
+				[scheduler cancelReconnectForClient:account];
+			}
+		}
+	}
+
+	for (NSUInteger i = 0; i < serviceCount; i++) {
+		[scheduler setHost:[NSString stringWithFormat:@"service%lu.example.com", (unsigned long)i] reachable:up];
+	}
+
+	if (up) {
+		for (AIReconnectBenchmarkAccount *account in accounts) {
+			if (account->online || account->connecting) continue;
+
+			if (useScheduler) {
+				[scheduler scheduleConnectForClient:account];
+			} else {
+				//setShouldBeOnline:YES, at once
+				account->nextAttemptTime = 0;
+				[self startHandshakeForAccount:account];
+			}
+		}
+	}
+}
+
+- (void)startHandshakeForAccount:(AIReconnectBenchmarkAccount *)account
+{
+	NSMutableArray	*recentStarts = (serviceCount ? [serviceStartTimes objectAtIndex:account->serviceIndex] : nil);
+	NSTimeInterval	duration = HANDSHAKE_SECONDS * (1.0 + nextRandomFraction(&randomState)) + CONTENTION_SECONDS * connectingCount;
+
+	while (recentStarts.count && [[recentStarts objectAtIndex:0] doubleValue] <= now - 1.0) {
+		[recentStarts removeObjectAtIndex:0];
+	}
+	[recentStarts addObject:[NSNumber numberWithDouble:now]];
+
+	account->willBeRejected = (recentStarts.count > SERVER_BURST_LIMIT);
+	account->connecting = YES;
+	account->handshakeEndTime = now + (account->willBeRejected ? REJECTION_SECONDS : duration);
+
+	[startTimes addObject:[NSNumber numberWithDouble:now]];
+	connectingCount++;
+	peakConnectingCount = MAX(peakConnectingCount, connectingCount);
+}
+
+- (void)finishHandshakeForAccount:(AIReconnectBenchmarkAccount *)account
+{
+	account->connecting = NO;
+	connectingCount--;
+
+	if (account->willBeRejected) {
+		rejectedCount++;
+		[self retryAccount:account];
+
+	} else if (nextRandom(&randomState) % 100 < failurePercent) {
+		failedCount++;
+		[self retryAccount:account];
+
+	} else {
+		account->online = YES;
+		account->attempts = 0;
+		[scheduler clientDidConnect:account];
+	}
+}
+
+/*!
+ * @brief A connection attempt failed; try again later, as AIAbstractAccount's didDisconnect would
+ */
+- (void)retryAccount:(AIReconnectBenchmarkAccount *)account
+{
+	if (useScheduler) {
+		[scheduler scheduleReconnectForClient:account minimumDelay:MINIMUM_DELAY];
+
+	} else {
+		NSTimeInterval delay = pow(BACKOFF_BASE, (double)account->attempts);
+
+		if (delay < MINIMUM_DELAY) delay = MINIMUM_DELAY;
+		else if (delay > BACKOFF_MAXIMUM) delay = BACKOFF_MAXIMUM;
+
+		account->nextAttemptTime = now + delay;
+		account->attempts++;
+
+		//waitingToReconnect was set with NotifyNow
+		account->dateChanges++;
+		account->notifications++;
+	}
+}
+
+#pragma mark Report
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSDictionary	*policies = [report objectForKey:KEY_RECONNECT_REPORT_POLICIES];
+	NSArray			*keys = [NSArray arrayWithObjects:KEY_RECONNECT_REPORT_ALL_ONLINE, KEY_RECONNECT_REPORT_HANDSHAKES,
+							 KEY_RECONNECT_REPORT_REJECTED, KEY_RECONNECT_REPORT_FAILED, KEY_RECONNECT_REPORT_PEAK_CONCURRENT,
+							 KEY_RECONNECT_REPORT_PEAK_PER_SECOND, KEY_RECONNECT_REPORT_DATE_CHANGES,
+							 KEY_RECONNECT_REPORT_NOTIFICATIONS, @"Simulation Seconds", nil];
+
+	[description appendFormat:@"Accounts: %@ on %@ services\n",
+	 [report objectForKey:KEY_RECONNECT_REPORT_ACCOUNTS], [report objectForKey:KEY_RECONNECT_REPORT_SERVICES]];
+
+	for (NSString *policyName in [[policies allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		NSDictionary *policy = [policies objectForKey:policyName];
+
+		[description appendFormat:@"\n%@:\n", policyName];
+		for (NSString *key in keys) {
+			[description appendFormat:@"  %-32s %10.3f\n", [key UTF8String], [[policy objectForKey:key] doubleValue]];
+		}
+		[description appendFormat:@"  %-32s %@\n", [KEY_RECONNECT_REPORT_PER_SECOND UTF8String],
+		 [[policy objectForKey:KEY_RECONNECT_REPORT_PER_SECOND] componentsJoinedByString:@" "]];
+	}
+
+	return description;
+}
+
+@end
@@ -0,0 +1,71 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+
+//Report keys
+#define KEY_SOCKET_REPORT_STANZAS			@"Stanzas"
+#define KEY_SOCKET_REPORT_TRANSFERS			@"Transfers"
+#define KEY_SOCKET_REPORT_TRANSFER_LENGTH	@"Transfer Length"
+#define KEY_SOCKET_REPORT_RUNS				@"Runs"
+#define KEY_SOCKET_REPORT_MISMATCHES		@"Mismatches"
+
+//Keys of each run
+#define KEY_SOCKET_RUN_READ_CALLS			@"Read Calls"
+#define KEY_SOCKET_RUN_BYTES				@"Bytes"
+#define KEY_SOCKET_RUN_ALLOCATIONS			@"Allocations"
+#define KEY_SOCKET_RUN_SECONDS				@"Seconds"
+
+/*!
+ * @class AISocketReadBenchmark
+ * @brief Reads Bonjour chat and file transfer traffic from a socket pair the old way and through AWEzvReadBuffer
+ *
+ * A writer thread sends stanzaCount small message stanzas inside a stream:stream element, one write() each, as a
+ * chatty peer would. They are read into expat as AWEzvXMLStream used to, with one NSData per read from
+ * NSFileHandle, and as it does now, with readv() into AWEzvReadBuffer and each slice handed to expat in place.
+ *
+ * Then transferCount responses of transferLength bytes, each behind HTTP headers, are read as AsyncSocket used to,
+ * a byte per read until each CRLF and then the body, and as it does now, with the headers found in AWEzvReadBuffer
+ * and the body read straight into its buffer once nothing is left buffered.
+ *
+ * Read calls, bytes and allocations (NSData objects and buffer segments) are reported for each run, and what each
+ * run read is checked against what was sent.
+ *
+ * Run with -AISocketReadBenchmark YES. Settings:
+ *	-AISocketReadBenchmarkStanzas <n>		Chat stanzas to read (20000)
+ *	-AISocketReadBenchmarkTransfers <n>		File transfers to read (20)
+ *	-AISocketReadBenchmarkTransferSize <n>	Bytes in each transfer (1048576)
+ *	-AIContactListBenchmarkSeed <n>			Seed for the random choices (1)
+ */
+@interface AISocketReadBenchmark : NSObject <AIBenchmark> {
+	NSUInteger			stanzaCount;
+	NSUInteger			transferCount;
+	NSUInteger			transferLength;
+	uint32_t			seed;
+
+	NSMutableArray		*mismatches;
+}
+
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger stanzaCount;
+@property (readwrite, nonatomic) NSUInteger transferCount;
+@property (readwrite, nonatomic) NSUInteger transferLength;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
@@ -0,0 +1,549 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AISocketReadBenchmark.h"
+#import "AWEzvReadBuffer.h"
+#import <mach/mach_time.h>
+#import <sys/socket.h>
+
+#define XMLCALL
+#import <expat.h>
+
+//Settings
+#define KEY_SOCKET_BENCHMARK_STANZAS		@"AISocketReadBenchmarkStanzas"
+#define KEY_SOCKET_BENCHMARK_TRANSFERS		@"AISocketReadBenchmarkTransfers"
+#define KEY_SOCKET_BENCHMARK_TRANSFER_SIZE	@"AISocketReadBenchmarkTransferSize"
+
+#define STANZA_RUN_BEFORE			@"Stanzas: an NSData per read"
+#define STANZA_RUN_AFTER			@"Stanzas: AWEzvReadBuffer slices"
+#define TRANSFER_RUN_BEFORE			@"Transfers: headers a byte at a time"
+#define TRANSFER_RUN_AFTER			@"Transfers: AWEzvReadBuffer"
+
+#define MIN_STANZA_TEXT_LENGTH		8
+#define MAX_STANZA_TEXT_LENGTH		160
+//How many mismatches are described in the report
+#define MAX_REPORTED_MISMATCHES		20
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+typedef struct {
+	NSUInteger	readCalls;
+	NSUInteger	bytes;
+	NSUInteger	allocations;
+	uint64_t	machTime;
+} AISocketReadCost;
+
+static NSDictionary *dictionaryFromCost(AISocketReadCost cost)
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:cost.readCalls], KEY_SOCKET_RUN_READ_CALLS,
+			[NSNumber numberWithUnsignedInteger:cost.bytes], KEY_SOCKET_RUN_BYTES,
+			[NSNumber numberWithUnsignedInteger:cost.allocations], KEY_SOCKET_RUN_ALLOCATIONS,
+			[NSNumber numberWithDouble:secondsFromMachTime(cost.machTime)], KEY_SOCKET_RUN_SECONDS,
+			nil];
+}
+
+#pragma mark Stanza counting
+
+typedef struct {
+	NSUInteger	depth;
+	NSUInteger	stanzas;
+	NSUInteger	textLength;
+} AIStanzaCounter;
+
+static void XMLCALL counterStartElement(void *userData, const XML_Char *name, const XML_Char **attributes)
+{
+	((AIStanzaCounter *)userData)->depth++;
+}
+
+static void XMLCALL counterEndElement(void *userData, const XML_Char *name)
+{
+	AIStanzaCounter *counter = userData;
+
+	//Stanzas are the children of stream:stream
+	if (--counter->depth == 1) counter->stanzas++;
+}
+
+static void XMLCALL counterCharacterData(void *userData, const XML_Char *s, int len)
+{
+	((AIStanzaCounter *)userData)->textLength += len;
+}
+
+static XML_Parser createCountingParser(AIStanzaCounter *counter)
+{
+	XML_Parser parser = XML_ParserCreate(NULL);
+
+	XML_SetUserData(parser, counter);
+	XML_SetElementHandler(parser, &counterStartElement, &counterEndElement);
+	XML_SetCharacterDataHandler(parser, &counterCharacterData);
+	XML_SetParamEntityParsing(parser, XML_PARAM_ENTITY_PARSING_NEVER);
+
+	return parser;
+}
+
+#pragma mark Socket pair
+
+static void writeChunks(int fd, NSArray *chunks)
+{
+	for (NSData *chunk in chunks) {
+		const unsigned char	*bytes = [chunk bytes];
+		size_t				remaining = [chunk length];
+
+		while (remaining > 0) {
+			ssize_t written = write(fd, bytes, remaining);
+
+			if (written < 0) {
+				if (errno == EINTR) continue;
+				return;
+			}
+			bytes += written;
+			remaining -= written;
+		}
+	}
+}
+
+/*!
+ * @brief Send chunks down a new socket pair from another thread, one write() each
+ *
+ * @result The reading end, or -1; the writer closes its end when it's done
+ */
+static int startWriter(NSArray *chunks, dispatch_group_t group)
+{
+	int fds[2], on = 1;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) return -1;
+
+	//The reader may give up early
+	setsockopt(fds[1], SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+
+	int writeFD = fds[1];
+	dispatch_group_async(group, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		writeChunks(writeFD, chunks);
+		close(writeFD);
+	});
+
+	return fds[0];
+}
+
+static uint32_t checksumOfBytes(const unsigned char *bytes, NSUInteger length)
+{
+	uint32_t	checksum = 0;
+	NSUInteger	i;
+
+	for (i = 0; i < length; i++) checksum = checksum * 31 + bytes[i];
+
+	return checksum;
+}
+
+/*!
+ * @brief The Content-Length of a header line, or NSNotFound if it's another header
+ */
+static NSUInteger contentLengthFromHeaderLine(NSData *line)
+{
+	NSString *header = [[[NSString alloc] initWithData:line encoding:NSASCIIStringEncoding] autorelease];
+
+	if (![header hasPrefix:@"Content-Length:"]) return NSNotFound;
+
+	return (NSUInteger)[[header substringFromIndex:[@"Content-Length:" length]] integerValue];
+}
+
+static BOOL isBlankLine(NSData *line)
+{
+	return ([line length] == 2 && memcmp([line bytes], "\r\n", 2) == 0);
+}
+
+#pragma mark -
+
+@interface AISocketReadBenchmark ()
+- (NSArray *)stanzaChunksWithTextLength:(NSUInteger *)outTextLength random:(uint32_t *)random;
+- (NSArray *)transferChunksWithChecksums:(NSMutableArray *)checksums random:(uint32_t *)random;
+- (AISocketReadCost)readStanzas:(NSArray *)chunks withBuffer:(BOOL)useBuffer counter:(AIStanzaCounter *)counter;
+- (AISocketReadCost)readTransfers:(NSArray *)chunks withBuffer:(BOOL)useBuffer checksums:(NSMutableArray *)checksums;
+- (void)checkStanzaCounter:(AIStanzaCounter)counter textLength:(NSUInteger)textLength run:(NSString *)run;
+@end
+
+@implementation AISocketReadBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:20000], KEY_SOCKET_BENCHMARK_STANZAS,
+			[NSNumber numberWithUnsignedInteger:20], KEY_SOCKET_BENCHMARK_TRANSFERS,
+			[NSNumber numberWithUnsignedInteger:1024 * 1024], KEY_SOCKET_BENCHMARK_TRANSFER_SIZE,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AISocketReadBenchmark *benchmark = [[[self alloc] init] autorelease];
+
+	benchmark.stanzaCount = [defaults integerForKey:KEY_SOCKET_BENCHMARK_STANZAS];
+	benchmark.transferCount = [defaults integerForKey:KEY_SOCKET_BENCHMARK_TRANSFERS];
+	benchmark.transferLength = [defaults integerForKey:KEY_SOCKET_BENCHMARK_TRANSFER_SIZE];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (id)init
+{
+	if ((self = [super init])) {
+		stanzaCount = 20000;
+		transferCount = 20;
+		transferLength = 1024 * 1024;
+		seed = 1;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[mismatches release];
+
+	[super dealloc];
+}
+
+@synthesize stanzaCount, transferCount, transferLength, seed;
+
+- (NSDictionary *)run
+{
+	NSMutableDictionary	*runs = [NSMutableDictionary dictionary];
+	NSMutableArray		*expectedChecksums = [NSMutableArray array];
+	NSMutableArray		*checksums;
+	NSArray				*chunks;
+	NSUInteger			textLength;
+	AIStanzaCounter		counter;
+	uint32_t			random = seed;
+
+	[mismatches release]; mismatches = [[NSMutableArray alloc] init];
+
+	chunks = [self stanzaChunksWithTextLength:&textLength random:&random];
+
+	memset(&counter, 0, sizeof(counter));
+	[runs setObject:dictionaryFromCost([self readStanzas:chunks withBuffer:NO counter:&counter]) forKey:STANZA_RUN_BEFORE];
+	[self checkStanzaCounter:counter textLength:textLength run:STANZA_RUN_BEFORE];
+
+	memset(&counter, 0, sizeof(counter));
+	[runs setObject:dictionaryFromCost([self readStanzas:chunks withBuffer:YES counter:&counter]) forKey:STANZA_RUN_AFTER];
+	[self checkStanzaCounter:counter textLength:textLength run:STANZA_RUN_AFTER];
+
+	chunks = [self transferChunksWithChecksums:expectedChecksums random:&random];
+
+	checksums = [NSMutableArray array];
+	[runs setObject:dictionaryFromCost([self readTransfers:chunks withBuffer:NO checksums:checksums]) forKey:TRANSFER_RUN_BEFORE];
+	if (![checksums isEqualToArray:expectedChecksums]) {
+		[mismatches addObject:[NSString stringWithFormat:@"%@: read %@, expected %@", TRANSFER_RUN_BEFORE, checksums, expectedChecksums]];
+	}
+
+	checksums = [NSMutableArray array];
+	[runs setObject:dictionaryFromCost([self readTransfers:chunks withBuffer:YES checksums:checksums]) forKey:TRANSFER_RUN_AFTER];
+	if (![checksums isEqualToArray:expectedChecksums]) {
+		[mismatches addObject:[NSString stringWithFormat:@"%@: read %@, expected %@", TRANSFER_RUN_AFTER, checksums, expectedChecksums]];
+	}
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:stanzaCount], KEY_SOCKET_REPORT_STANZAS,
+			[NSNumber numberWithUnsignedInteger:transferCount], KEY_SOCKET_REPORT_TRANSFERS,
+			[NSNumber numberWithUnsignedInteger:transferLength], KEY_SOCKET_REPORT_TRANSFER_LENGTH,
+			runs, KEY_SOCKET_REPORT_RUNS,
+			mismatches, KEY_SOCKET_REPORT_MISMATCHES,
+			nil];
+}
+
+/*!
+ * @brief A stream:stream element holding stanzaCount chat messages, one chunk per stanza
+ *
+ * Each message carries its text twice, as a plain body and as XHTML.
+ */
+- (NSArray *)stanzaChunksWithTextLength:(NSUInteger *)outTextLength random:(uint32_t *)random
+{
+	NSMutableArray	*chunks = [NSMutableArray arrayWithCapacity:stanzaCount + 2];
+	char			text[MAX_STANZA_TEXT_LENGTH + 1];
+	NSUInteger		i, j;
+
+	*outTextLength = 0;
+
+	[chunks addObject:[@"<?xml version=\"1.0\" encoding=\"UTF-8\" ?><stream:stream to=\"peer@benchmark\" from=\"me@benchmark\" "
+					   @"xmlns=\"jabber:client\" xmlns:stream=\"http://etherx.jabber.org/streams\">" dataUsingEncoding:NSUTF8StringEncoding]];
+
+	for (i = 0; i < stanzaCount; i++) {
+		NSUInteger textLength = MIN_STANZA_TEXT_LENGTH + nextRandom(random) % (MAX_STANZA_TEXT_LENGTH - MIN_STANZA_TEXT_LENGTH);
+
+		for (j = 0; j < textLength; j++) {
+			uint32_t letter = nextRandom(random) % 27;
+			text[j] = (letter == 26 ? ' ' : 'a' + letter);
+		}
+		text[textLength] = '\0';
+
+		NSString *stanza = [NSString stringWithFormat:@"<message to=\"peer@benchmark\" from=\"me@benchmark\" type=\"chat\">"
+							@"<body>%s</body><html xmlns=\"http://www.w3.org/1999/xhtml\"><body><font face=\"Helvetica\">%s</font></body></html>"
+							@"<x xmlns=\"jabber:x:event\"><composing/></x></message>", text, text];
+		[chunks addObject:[stanza dataUsingEncoding:NSUTF8StringEncoding]];
+		*outTextLength += textLength * 2;
+	}
+
+	[chunks addObject:[@"</stream:stream>" dataUsingEncoding:NSUTF8StringEncoding]];
+
+	return chunks;
+}
+
+/*!
+ * @brief transferCount HTTP responses, the headers and the body of each in a chunk of their own
+ */
+- (NSArray *)transferChunksWithChecksums:(NSMutableArray *)checksums random:(uint32_t *)random
+{
+	NSMutableArray	*chunks = [NSMutableArray arrayWithCapacity:transferCount * 2];
+	NSUInteger		i, j;
+
+	for (i = 0; i < transferCount; i++) {
+		NSMutableData	*body = [NSMutableData dataWithLength:transferLength];
+		unsigned char	*bytes = [body mutableBytes];
+
+		for (j = 0; j < transferLength; j++) bytes[j] = (unsigned char)nextRandom(random);
+
+		NSString *headers = [NSString stringWithFormat:@"HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\n"
+							 @"Content-Length: %lu\r\nServer: AISocketReadBenchmark\r\n\r\n", (unsigned long)transferLength];
+		[chunks addObject:[headers dataUsingEncoding:NSASCIIStringEncoding]];
+		[chunks addObject:body];
+		[checksums addObject:[NSNumber numberWithUnsignedInt:checksumOfBytes(bytes, transferLength)]];
+	}
+
+	return chunks;
+}
+
+/*!
+ * @brief Parse the stanzas as they arrive, as AWEzvXMLStream did (useBuffer NO) or does (useBuffer YES)
+ */
+- (AISocketReadCost)readStanzas:(NSArray *)chunks withBuffer:(BOOL)useBuffer counter:(AIStanzaCounter *)counter
+{
+	AISocketReadCost	cost;
+	dispatch_group_t	group = dispatch_group_create();
+	XML_Parser			parser = createCountingParser(counter);
+	int					fd = startWriter(chunks, group);
+	uint64_t			start = mach_absolute_time();
+
+	memset(&cost, 0, sizeof(cost));
+
+	if (fd < 0) {
+		[mismatches addObject:[NSString stringWithFormat:@"Could not create a socket pair: %s", strerror(errno)]];
+
+	} else if (useBuffer) {
+		AWEzvReadBuffer *buffer = [[AWEzvReadBuffer alloc] init];
+		NSInteger		bytesRead;
+		BOOL			interrupted;
+
+		do {
+			bytesRead = [buffer readFromFileDescriptor:fd];
+			interrupted = (bytesRead < 0 && errno == EINTR);
+
+			[buffer consumeSlicesUsingBlock:^(const unsigned char *bytes, NSUInteger sliceLength) {
+				XML_Parse(parser, (const char *)bytes, (int)sliceLength, 0);
+			}];
+		} while (bytesRead > 0 || interrupted);
+		XML_Parse(parser, NULL, 0, 1);
+
+		cost.readCalls = buffer.readCallCount;
+		cost.bytes = buffer.byteCount;
+		cost.allocations = buffer.segmentAllocationCount;
+		[buffer release];
+		close(fd);
+
+	} else {
+		NSFileHandle	*fileHandle = [[NSFileHandle alloc] initWithFileDescriptor:fd closeOnDealloc:YES];
+		BOOL			finished = NO;
+
+		while (!finished) {
+			NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+			NSData				*data = [fileHandle availableData];
+
+			cost.readCalls++;
+			cost.allocations++;
+			cost.bytes += [data length];
+			finished = ([data length] == 0);
+			XML_Parse(parser, [data bytes], (int)[data length], finished);
+
+			[pool release];
+		}
+
+		[fileHandle release];
+	}
+
+	cost.machTime = mach_absolute_time() - start;
+
+	dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+	dispatch_release(group);
+	XML_ParserFree(parser);
+
+	return cost;
+}
+
+/*!
+ * @brief Read the responses, as AsyncSocket's readDataToData: and readDataToLength: did (useBuffer NO) or do (useBuffer YES)
+ *
+ * Each header line and each body is an NSData of its own, as the delegate is given.
+ */
+- (AISocketReadCost)readTransfers:(NSArray *)chunks withBuffer:(BOOL)useBuffer checksums:(NSMutableArray *)checksums
+{
+	AISocketReadCost	cost;
+	dispatch_group_t	group = dispatch_group_create();
+	int					fd = startWriter(chunks, group);
+	AWEzvReadBuffer		*buffer = (useBuffer ? [[AWEzvReadBuffer alloc] init] : nil);
+	NSData				*CRLF = [NSData dataWithBytes:"\r\n" length:2];
+	uint64_t			start = mach_absolute_time();
+	NSUInteger			i;
+	BOOL				failed = (fd < 0);
+
+	memset(&cost, 0, sizeof(cost));
+
+	for (i = 0; i < transferCount && !failed; i++) {
+		NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+		NSUInteger			contentLength = NSNotFound;
+		BOOL				headersDone = NO;
+
+		while (!headersDone && !failed) {
+			NSMutableData *line = [NSMutableData data];
+			cost.allocations++;
+
+			if (useBuffer) {
+				NSUInteger scanOffset = 0, offset;
+
+				while (!failed && (offset = [buffer offsetOfData:CRLF startingAt:scanOffset]) == NSNotFound) {
+					if ([buffer length] > 0) scanOffset = [buffer length] - 1;
+					failed = ([buffer readFromFileDescriptor:fd] <= 0);
+				}
+				if (!failed) [buffer appendBytesOfLength:offset + 2 toData:line];
+
+			} else {
+				//One byte per read, until the line ends with CRLF
+				while (!failed && !([line length] >= 2 && memcmp((const char *)[line bytes] + [line length] - 2, "\r\n", 2) == 0)) {
+					[line increaseLengthBy:1];
+					ssize_t bytesRead = read(fd, (unsigned char *)[line mutableBytes] + [line length] - 1, 1);
+					cost.readCalls++;
+					if (bytesRead == 1) {
+						cost.bytes++;
+					} else {
+						failed = YES;
+					}
+				}
+			}
+
+			if (isBlankLine(line)) {
+				headersDone = YES;
+			} else if (contentLengthFromHeaderLine(line) != NSNotFound) {
+				contentLength = contentLengthFromHeaderLine(line);
+			}
+		}
+
+		if (!failed && contentLength != NSNotFound) {
+			NSMutableData	*body = [NSMutableData dataWithLength:contentLength];
+			unsigned char	*bytes = [body mutableBytes];
+			NSUInteger		bytesDone = (useBuffer ? [buffer readBytes:bytes length:contentLength] : 0);
+
+			cost.allocations++;
+
+			//The rest goes straight into the body
+			while (!failed && bytesDone < contentLength) {
+				ssize_t bytesRead = read(fd, bytes + bytesDone, contentLength - bytesDone);
+				cost.readCalls++;
+				if (bytesRead > 0) {
+					bytesDone += bytesRead;
+					cost.bytes += bytesRead;
+				} else if (!(bytesRead < 0 && errno == EINTR)) {
+					failed = YES;
+				}
+			}
+
+			if (!failed) [checksums addObject:[NSNumber numberWithUnsignedInt:checksumOfBytes(bytes, contentLength)]];
+		}
+
+		[pool release];
+	}
+
+	cost.machTime = mach_absolute_time() - start;
+
+	if (buffer) {
+		cost.readCalls += buffer.readCallCount;
+		cost.bytes += buffer.byteCount;
+		cost.allocations += buffer.segmentAllocationCount;
+		[buffer release];
+	}
+
+	//Let the writer finish if we gave up early
+	if (fd >= 0) close(fd);
+	dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+	dispatch_release(group);
+
+	return cost;
+}
+
+- (void)checkStanzaCounter:(AIStanzaCounter)counter textLength:(NSUInteger)textLength run:(NSString *)run
+{
+	if (counter.stanzas != stanzaCount || counter.textLength != textLength) {
+		[mismatches addObject:[NSString stringWithFormat:@"%@: parsed %lu stanzas with %lu bytes of text, expected %lu with %lu", run,
+							   (unsigned long)counter.stanzas, (unsigned long)counter.textLength,
+							   (unsigned long)stanzaCount, (unsigned long)textLength]];
+	}
+}
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSDictionary	*runs = [report objectForKey:KEY_SOCKET_REPORT_RUNS];
+	NSArray			*reportMismatches = [report objectForKey:KEY_SOCKET_REPORT_MISMATCHES];
+
+	[description appendFormat:@"Stanzas: %@, transfers: %@ of %@ bytes\n",
+	 [report objectForKey:KEY_SOCKET_REPORT_STANZAS], [report objectForKey:KEY_SOCKET_REPORT_TRANSFERS],
+	 [report objectForKey:KEY_SOCKET_REPORT_TRANSFER_LENGTH]];
+	[description appendFormat:@"Mismatches: %lu\n", (unsigned long)reportMismatches.count];
+
+	for (NSUInteger i = 0; i < reportMismatches.count && i < MAX_REPORTED_MISMATCHES; i++) {
+		[description appendFormat:@"  %@\n", [reportMismatches objectAtIndex:i]];
+	}
+
+	[description appendFormat:@"\n  %-40s %10s %12s %8s %10s %9s\n", "", "reads", "bytes/read", "allocs", "allocs/MB", "seconds"];
+	for (NSString *name in [[runs allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		NSDictionary	*run = [runs objectForKey:name];
+		NSUInteger		readCalls = [[run objectForKey:KEY_SOCKET_RUN_READ_CALLS] unsignedIntegerValue];
+		NSUInteger		bytes = [[run objectForKey:KEY_SOCKET_RUN_BYTES] unsignedIntegerValue];
+		NSUInteger		allocations = [[run objectForKey:KEY_SOCKET_RUN_ALLOCATIONS] unsignedIntegerValue];
+		double			megabytes = bytes / (1024.0 * 1024.0);
+
+		[description appendFormat:@"  %-40s %10lu %12.1f %8lu %10.2f %9.3f\n",
+		 [name UTF8String], (unsigned long)readCalls, (readCalls ? (double)bytes / readCalls : 0.0),
+		 (unsigned long)allocations, (megabytes > 0 ? allocations / megabytes : 0.0),
+		 [[run objectForKey:KEY_SOCKET_RUN_SECONDS] doubleValue]];
+	}
+
+	return description;
+}
+
+@end
@@ -0,0 +1,78 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+#import <Adium/AIStatusMenu.h>
+#import <Adium/AIContactObserverManager.h>
+
+//Report keys
+#define KEY_STATUS_REPORT_ACCOUNTS						@"Accounts"
+#define KEY_STATUS_REPORT_ROUNDS						@"Rounds"
+#define KEY_STATUS_REPORT_EVENTS						@"Events"
+#define KEY_STATUS_REPORT_ARRAY_NOTIFICATIONS			@"State Array Notifications"
+#define KEY_STATUS_REPORT_MENU_REBUILDS					@"Menu Rebuilds"
+#define KEY_STATUS_REPORT_ACTIVE_NOTIFICATIONS			@"Active State Notifications"
+#define KEY_STATUS_REPORT_LEGACY_ACTIVE_NOTIFICATIONS	@"Active State Notifications Before"
+#define KEY_STATUS_REPORT_SECONDS						@"Seconds"
+#define KEY_STATUS_REPORT_MISMATCHES					@"Mismatches"
+
+/*!
+ * @class AIStatusMenuBenchmark
+ * @brief Drives benchmark accounts through a connect storm and status changes, counting status menu rebuilds
+ *
+ * The accounts are enabled and connected one after another. Then, over roundCount rounds of one event per account,
+ * random accounts are set to a built-in state, set to a new custom away state, re-set to the state they are in,
+ * dropped and reconnected, and now and then all of them are set to one state at once. Finally they all disconnect.
+ *
+ * An AIStatusMenu is kept for the whole run with this object as its delegate. It used to be rebuilt for each
+ * state array changed notification; that count is given along with the number of times it was actually rebuilt.
+ * The status controller used to post an active state changed notification for each update to an account's
+ * online, idle, status or enabled keys outside of a status change it made itself, and once for each such change.
+ *
+ * After every event the controller's active states are checked against a count of every account's state, and after
+ * every round the menu items are checked against sortedFullStateArray and the statuses found by unique status ID
+ * against flatStatusSet.
+ *
+ * Run with -AIStatusMenuBenchmark YES. Settings:
+ *	-AIStatusMenuBenchmarkAccounts <n>	Benchmark accounts to connect (50)
+ *	-AIStatusMenuBenchmarkRounds <n>	Rounds of status changes (20)
+ *	-AIContactListBenchmarkSeed <n>		Seed for the random choices (1)
+ */
+@interface AIStatusMenuBenchmark : NSObject <AIBenchmark, AIStatusMenuDelegate, AIListObjectObserver> {
+	NSArray				*accounts;
+	NSUInteger			roundCount;
+	uint32_t			seed;
+
+	NSArray				*menuItems;
+	NSUInteger			arrayNotificationCount;
+	NSUInteger			menuRebuildCount;
+	NSUInteger			activeNotificationCount;
+	NSUInteger			legacyActiveNotificationCount;
+	BOOL				applyingState;
+
+	NSMutableArray		*mismatches;
+}
+
+- (id)initWithAccounts:(NSArray *)inAccounts;
+
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger roundCount;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
@@ -0,0 +1,402 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIStatusMenuBenchmark.h"
+#import "AIBenchmarkAccount.h"
+#import <Adium/AIAccountControllerProtocol.h>
+#import <Adium/AIStatusControllerProtocol.h>
+#import <Adium/AIStatus.h>
+#import <Adium/AIStatusGroup.h>
+#import <mach/mach_time.h>
+
+//Settings
+#define KEY_STATUS_MENU_BENCHMARK_ACCOUNTS	@"AIStatusMenuBenchmarkAccounts"
+#define KEY_STATUS_MENU_BENCHMARK_ROUNDS	@"AIStatusMenuBenchmarkRounds"
+
+//How many mismatches are described in the report
+#define MAX_REPORTED_MISMATCHES			20
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+@interface AIStatusMenuBenchmark ()
+- (void)addMismatch:(NSString *)mismatch;
+- (void)applyState:(AIStatus *)statusState toAccount:(AIAccount *)account;
+- (void)applyStateToAllAccounts:(AIStatus *)statusState;
+- (void)checkActiveStatesAfter:(NSString *)event;
+- (void)checkMenuAndStatusIDsAfterRound:(NSUInteger)round;
+- (void)stateArrayChanged:(NSNotification *)notification;
+- (void)activeStateChanged:(NSNotification *)notification;
+@end
+
+@implementation AIStatusMenuBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:50], KEY_STATUS_MENU_BENCHMARK_ACCOUNTS,
+			[NSNumber numberWithUnsignedInteger:20], KEY_STATUS_MENU_BENCHMARK_ROUNDS,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	NSMutableArray	*benchmarkAccounts = [NSMutableArray array];
+	NSInteger		accountCount = [defaults integerForKey:KEY_STATUS_MENU_BENCHMARK_ACCOUNTS];
+
+	for (NSInteger i = 0; i < accountCount; i++) {
+		[benchmarkAccounts addObject:[AIBenchmarkAccount addTemporaryAccountWithUID:[NSString stringWithFormat:@"status%ld", (long)i]]];
+	}
+
+	AIStatusMenuBenchmark *benchmark = [[[self alloc] initWithAccounts:benchmarkAccounts] autorelease];
+
+	benchmark.roundCount = [defaults integerForKey:KEY_STATUS_MENU_BENCHMARK_ROUNDS];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (void)deleteAccounts
+{
+	for (AIBenchmarkAccount *account in accounts) {
+		[account deleteTemporaryAccount];
+	}
+}
+
+- (id)initWithAccounts:(NSArray *)inAccounts
+{
+	if ((self = [super init])) {
+		accounts = [inAccounts copy];
+		roundCount = 20;
+		seed = 1;
+		mismatches = [[NSMutableArray alloc] init];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[accounts release];
+	[menuItems release];
+	[mismatches release];
+
+	[super dealloc];
+}
+
+@synthesize roundCount, seed;
+
+#pragma mark Observing
+
+- (void)statusMenu:(AIStatusMenu *)statusMenu didRebuildStatusMenuItems:(NSArray *)inMenuItems
+{
+	menuRebuildCount++;
+
+	[menuItems release];
+	menuItems = [inMenuItems copy];
+}
+
+- (void)stateArrayChanged:(NSNotification *)notification
+{
+	arrayNotificationCount++;
+}
+
+- (void)activeStateChanged:(NSNotification *)notification
+{
+	activeNotificationCount++;
+}
+
+/*!
+ * @brief Count the account updates which each used to post an active state changed notification
+ */
+- (NSSet *)updateListObject:(AIListObject *)inObject keys:(NSSet *)inModifiedKeys silent:(BOOL)silent
+{
+	if (!applyingState && [accounts containsObject:inObject] &&
+		([inModifiedKeys containsObject:@"isOnline"] ||
+		 [inModifiedKeys containsObject:@"idleSince"] ||
+		 [inModifiedKeys containsObject:@"accountStatus"] ||
+		 [inModifiedKeys containsObject:KEY_ENABLED])) {
+		legacyActiveNotificationCount++;
+	}
+
+	return nil;
+}
+
+#pragma mark Events
+
+/*!
+ * @brief Set one account's state, as its status menu does
+ */
+- (void)applyState:(AIStatus *)statusState toAccount:(AIAccount *)account
+{
+	applyingState = YES;
+	[adium.statusController setActiveStatusState:statusState forAccount:account];
+	applyingState = NO;
+
+	//The status controller used to post once when it finished applying a state
+	legacyActiveNotificationCount++;
+}
+
+/*!
+ * @brief Set every account's state, as the global status menu does
+ *
+ * setActiveStatusState: waits for the next run loop; apply the state at once instead.
+ */
+- (void)applyStateToAllAccounts:(AIStatus *)statusState
+{
+	applyingState = YES;
+	[adium.statusController applyState:statusState toAccounts:adium.accountController.accounts];
+	applyingState = NO;
+
+	legacyActiveNotificationCount++;
+}
+
+#pragma mark Checks
+
+- (void)addMismatch:(NSString *)mismatch
+{
+	[mismatches addObject:mismatch];
+}
+
+/*!
+ * @brief Check the controller's active states against a count of every account's state, as it used to make
+ */
+- (void)checkActiveStatesAfter:(NSString *)event
+{
+	NSObject<AIStatusController>	*statusController = adium.statusController;
+	NSCountedSet	*onlineStatusCounts = [NSCountedSet set];
+	NSMutableSet	*enabledStatuses = [NSMutableSet set];
+	NSUInteger		highestCount = 0;
+
+	for (AIAccount *account in adium.accountController.accounts) {
+		AIStatus *statusState = account.statusState;
+
+		if (account.online) [onlineStatusCounts addObject:(statusState ? statusState : statusController.defaultInitialStatusState)];
+		if (account.enabled && statusState) [enabledStatuses addObject:statusState];
+	}
+
+	for (AIStatus *statusState in onlineStatusCounts) {
+		highestCount = MAX(highestCount, [onlineStatusCounts countForObject:statusState]);
+	}
+
+	AIStatus *activeStatusState = statusController.activeStatusState;
+	if (highestCount ?
+		([onlineStatusCounts countForObject:activeStatusState] != highestCount) :
+		(activeStatusState != statusController.offlineStatusState)) {
+		[self addMismatch:[NSString stringWithFormat:@"After %@: active state is %@, used by %lu online accounts rather than %lu",
+						   event, activeStatusState, (unsigned long)[onlineStatusCounts countForObject:activeStatusState],
+						   (unsigned long)highestCount]];
+	}
+
+	if (![[statusController allActiveStatusStates] isEqualToSet:enabledStatuses]) {
+		[self addMismatch:[NSString stringWithFormat:@"After %@: all active states are %@ rather than %@",
+						   event, [statusController allActiveStatusStates], enabledStatuses]];
+	}
+}
+
+/*!
+ * @brief Check that the status menu lists sortedFullStateArray, and that statuses are found by their unique IDs
+ */
+- (void)checkMenuAndStatusIDsAfterRound:(NSUInteger)round
+{
+	NSObject<AIStatusController>	*statusController = adium.statusController;
+	NSMutableArray	*menuStatuses = [NSMutableArray array];
+
+	for (NSMenuItem *menuItem in menuItems) {
+		AIStatusItem *statusItem = [[menuItem representedObject] objectForKey:@"AIStatus"];
+		if (!statusItem) continue;
+
+		[menuStatuses addObject:statusItem];
+		if (![[menuItem title] isEqualToString:[AIStatusMenu titleForMenuDisplayOfState:statusItem]]) {
+			[self addMismatch:[NSString stringWithFormat:@"Round %lu: menu item \"%@\" is for %@",
+							   (unsigned long)round, [menuItem title], statusItem]];
+		}
+	}
+
+	if (![menuStatuses isEqualToArray:statusController.sortedFullStateArray]) {
+		[self addMismatch:[NSString stringWithFormat:@"Round %lu: the menu lists %@ rather than %@",
+						   (unsigned long)round, menuStatuses, statusController.sortedFullStateArray]];
+	}
+
+	for (AIStatus *statusState in statusController.flatStatusSet) {
+		int uniqueStatusID = [statusState preexistingUniqueStatusID];
+		if (uniqueStatusID == -1) continue;
+
+		AIStatus *foundStatusState = [statusController statusStateWithUniqueStatusID:[NSNumber numberWithInt:uniqueStatusID]];
+		if ([foundStatusState preexistingUniqueStatusID] != uniqueStatusID) {
+			[self addMismatch:[NSString stringWithFormat:@"Round %lu: unique status ID %d found %@ rather than %@",
+							   (unsigned long)round, uniqueStatusID, foundStatusState, statusState]];
+		}
+	}
+}
+
+#pragma mark Running
+
+- (NSDictionary *)run
+{
+	NSObject<AIStatusController>	*statusController = adium.statusController;
+	NSArray			*builtInStates = [NSArray arrayWithObjects:statusController.availableStatus,
+									  statusController.awayStatus, statusController.invisibleStatus, nil];
+	uint32_t		random = seed;
+	NSUInteger		eventCount = 0, round, i;
+	uint64_t		machTime = 0, start;
+
+	[mismatches removeAllObjects];
+
+	for (AIBenchmarkAccount *account in accounts) {
+		[account setEnabled:YES];
+	}
+
+	AIStatusMenu *statusMenu = [[AIStatusMenu alloc] initWithDelegate:self];
+
+	[[NSNotificationCenter defaultCenter] addObserver:self
+											 selector:@selector(stateArrayChanged:)
+												 name:AIStatusStateArrayChangedNotification
+											   object:nil];
+	[[NSNotificationCenter defaultCenter] addObserver:self
+											 selector:@selector(activeStateChanged:)
+												 name:AIStatusActiveStateChangedNotification
+											   object:nil];
+	[[AIContactObserverManager sharedManager] registerListObjectObserver:self];
+
+	//Only count what the events cause
+	menuRebuildCount = 0;
+	arrayNotificationCount = 0;
+	activeNotificationCount = 0;
+	legacyActiveNotificationCount = 0;
+
+	//Connect storm
+	for (AIBenchmarkAccount *account in accounts) {
+		start = mach_absolute_time();
+		[account connect];
+		[account endSignOnDelay];
+		machTime += mach_absolute_time() - start;
+
+		eventCount++;
+		[self checkActiveStatesAfter:[NSString stringWithFormat:@"connecting %@", account.UID]];
+	}
+	[self checkMenuAndStatusIDsAfterRound:0];
+
+	for (round = 1; round <= roundCount; round++) {
+		for (i = 0; i < accounts.count; i++) {
+			NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+			AIBenchmarkAccount	*account = [accounts objectAtIndex:nextRandom(&random) % accounts.count];
+			uint32_t			choice = nextRandom(&random) % 100;
+			NSString			*event;
+
+			start = mach_absolute_time();
+
+			if (choice < 50) {
+				AIStatus *statusState = [builtInStates objectAtIndex:nextRandom(&random) % builtInStates.count];
+				[self applyState:statusState toAccount:account];
+				event = [NSString stringWithFormat:@"setting %@ to %@", account.UID, statusState];
+
+			} else if (choice < 70) {
+				AIStatus *statusState = [AIStatus statusOfType:AIAwayStatusType];
+				statusState.statusMessageString = [NSString stringWithFormat:@"Away %lu", (unsigned long)eventCount];
+				[self applyState:statusState toAccount:account];
+				event = [NSString stringWithFormat:@"setting %@ to a custom away", account.UID];
+
+			} else if (choice < 85) {
+				[account disconnect];
+				[account connect];
+				[account endSignOnDelay];
+				event = [NSString stringWithFormat:@"reconnecting %@", account.UID];
+
+			} else if (choice < 95) {
+				AIStatus *statusState = account.actualStatusState;
+				[self applyState:(statusState ? statusState : statusController.availableStatus) toAccount:account];
+				event = [NSString stringWithFormat:@"setting %@ to the state it's in", account.UID];
+
+			} else {
+				AIStatus *statusState = [builtInStates objectAtIndex:nextRandom(&random) % builtInStates.count];
+				[self applyStateToAllAccounts:statusState];
+				event = [NSString stringWithFormat:@"setting all accounts to %@", statusState];
+			}
+
+			machTime += mach_absolute_time() - start;
+			eventCount++;
+
+			[self checkActiveStatesAfter:event];
+			[pool release];
+		}
+
+		[self checkMenuAndStatusIDsAfterRound:round];
+	}
+
+	//Everyone signs off
+	for (AIBenchmarkAccount *account in accounts) {
+		start = mach_absolute_time();
+		[account disconnect];
+		machTime += mach_absolute_time() - start;
+
+		eventCount++;
+		[self checkActiveStatesAfter:[NSString stringWithFormat:@"disconnecting %@", account.UID]];
+	}
+	[self checkMenuAndStatusIDsAfterRound:roundCount + 1];
+
+	[[AIContactObserverManager sharedManager] unregisterListObjectObserver:self];
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+	[statusMenu release];
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:accounts.count], KEY_STATUS_REPORT_ACCOUNTS,
+			[NSNumber numberWithUnsignedInteger:roundCount], KEY_STATUS_REPORT_ROUNDS,
+			[NSNumber numberWithUnsignedInteger:eventCount], KEY_STATUS_REPORT_EVENTS,
+			[NSNumber numberWithUnsignedInteger:arrayNotificationCount], KEY_STATUS_REPORT_ARRAY_NOTIFICATIONS,
+			[NSNumber numberWithUnsignedInteger:menuRebuildCount], KEY_STATUS_REPORT_MENU_REBUILDS,
+			[NSNumber numberWithUnsignedInteger:activeNotificationCount], KEY_STATUS_REPORT_ACTIVE_NOTIFICATIONS,
+			[NSNumber numberWithUnsignedInteger:legacyActiveNotificationCount], KEY_STATUS_REPORT_LEGACY_ACTIVE_NOTIFICATIONS,
+			[NSNumber numberWithDouble:secondsFromMachTime(machTime)], KEY_STATUS_REPORT_SECONDS,
+			[[mismatches copy] autorelease], KEY_STATUS_REPORT_MISMATCHES,
+			nil];
+}
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSArray			*reportMismatches = [report objectForKey:KEY_STATUS_REPORT_MISMATCHES];
+
+	[description appendFormat:@"Accounts: %@, rounds: %@, events: %@\n",
+	 [report objectForKey:KEY_STATUS_REPORT_ACCOUNTS], [report objectForKey:KEY_STATUS_REPORT_ROUNDS],
+	 [report objectForKey:KEY_STATUS_REPORT_EVENTS]];
+	[description appendFormat:@"Status menu rebuilds: %@ (previously %@)\n",
+	 [report objectForKey:KEY_STATUS_REPORT_MENU_REBUILDS], [report objectForKey:KEY_STATUS_REPORT_ARRAY_NOTIFICATIONS]];
+	[description appendFormat:@"Active state notifications: %@ (previously %@)\n",
+	 [report objectForKey:KEY_STATUS_REPORT_ACTIVE_NOTIFICATIONS],
+	 [report objectForKey:KEY_STATUS_REPORT_LEGACY_ACTIVE_NOTIFICATIONS]];
+	[description appendFormat:@"Time handling events: %.3f s\n", [[report objectForKey:KEY_STATUS_REPORT_SECONDS] doubleValue]];
+	[description appendFormat:@"Mismatches: %lu\n", (unsigned long)reportMismatches.count];
+
+	for (NSUInteger i = 0; i < reportMismatches.count && i < MAX_REPORTED_MISMATCHES; i++) {
+		[description appendFormat:@"  %@\n", [reportMismatches objectAtIndex:i]];
+	}
+
+	return description;
+}
+
+@end
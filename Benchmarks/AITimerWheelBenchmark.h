@@ -0,0 +1,58 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+
+@class AITimerWheel;
+
+//Report keys
+#define KEY_TIMER_WHEEL_REPORT_TIMERS		@"Timers"
+#define KEY_TIMER_WHEEL_REPORT_RESCHEDULES	@"Reschedules"
+#define KEY_TIMER_WHEEL_REPORT_FIRED		@"Fired"
+#define KEY_TIMER_WHEEL_REPORT_WAKEUPS		@"Wakeups"
+#define KEY_TIMER_WHEEL_REPORT_OPERATIONS	@"Operations"
+
+/*!
+ * @class AITimerWheelBenchmark
+ * @brief Schedules, reschedules and fires many timers on an AITimerWheel, and does the same with NSTimers
+ *
+ * timerCount timers are scheduled 0 to 60 seconds out on a wheel with a virtual clock, then pushed back 3 seconds
+ * at a time, ten times as often as there are timers, the way typing timers are on every keystroke, while the clock
+ * moves 10ms per thousand keystrokes. The clock then runs until every timer has fired. The same schedule,
+ * reschedule and invalidate work is done with NSTimers on the current run loop; they are never fired.
+ *
+ * Run with -AITimerWheelBenchmark YES. Settings:
+ *	-AITimerWheelBenchmarkTimers <n>	Timers to schedule (100000)
+ *	-AIContactListBenchmarkSeed <n>		Seed for the random choices (1)
+ */
+@interface AITimerWheelBenchmark : NSObject <AIBenchmark> {
+	NSUInteger			timerCount;
+	uint32_t			seed;
+
+	NSUInteger			firedCount;
+	NSUInteger			wakeupCount;
+	NSTimeInterval		lastFireTime;
+	AITimerWheel		*wheel;
+}
+
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger timerCount;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
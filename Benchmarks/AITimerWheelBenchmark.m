@@ -0,0 +1,244 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AITimerWheelBenchmark.h"
+#import <AIUtilities/AITimerWheel.h>
+#import <mach/mach_time.h>
+
+//Settings
+#define KEY_TIMER_WHEEL_BENCHMARK_TIMERS	@"AITimerWheelBenchmarkTimers"
+
+#define TICK_INTERVAL				0.01
+#define MAXIMUM_DELAY_MS			60000
+#define TYPING_DELAY				3.0
+#define KEYSTROKES_PER_TIMER		10
+#define KEYSTROKES_PER_TICK			1000
+//Work is done in batches, each in its own autorelease pool
+#define BATCH_SIZE					10000
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+static void addCost(NSMutableDictionary *costs, NSString *costName, NSUInteger count, uint64_t machTime)
+{
+	[costs setObject:[NSDictionary dictionaryWithObjectsAndKeys:
+					  [NSNumber numberWithUnsignedInteger:count], @"Count",
+					  [NSNumber numberWithDouble:secondsFromMachTime(machTime)], @"Seconds",
+					  nil]
+			  forKey:costName];
+}
+
+@interface AITimerWheelBenchmark ()
+- (void)timerFired:(id)timer;
+@end
+
+@implementation AITimerWheelBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:100000], KEY_TIMER_WHEEL_BENCHMARK_TIMERS,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AITimerWheelBenchmark *benchmark = [[[self alloc] init] autorelease];
+
+	benchmark.timerCount = [defaults integerForKey:KEY_TIMER_WHEEL_BENCHMARK_TIMERS];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (id)init
+{
+	if ((self = [super init])) {
+		timerCount = 100000;
+		seed = 1;
+	}
+
+	return self;
+}
+
+@synthesize timerCount, seed;
+
+- (void)timerFired:(id)timer
+{
+	firedCount++;
+
+	//Timers due on the same tick share a wakeup
+	if (wheel.currentTime != lastFireTime) {
+		wakeupCount++;
+		lastFireTime = wheel.currentTime;
+	}
+}
+
+- (NSDictionary *)run
+{
+	NSMutableDictionary		*costs = [NSMutableDictionary dictionary];
+	NSUInteger				rescheduleCount = timerCount * KEYSTROKES_PER_TIMER;
+	AIWheelTimer			**wheelTimers = malloc(timerCount * sizeof(AIWheelTimer *));
+	NSTimer					**timers = malloc(timerCount * sizeof(NSTimer *));
+	NSRunLoop				*runLoop = [NSRunLoop currentRunLoop];
+	uint32_t				state;
+	uint64_t				start;
+	NSUInteger				i, batch;
+
+	wheel = [[AITimerWheel alloc] initWithVirtualClockAndTickInterval:TICK_INTERVAL];
+	firedCount = wakeupCount = 0;
+	lastFireTime = -1;
+
+	//Scheduling
+	state = seed;
+	start = mach_absolute_time();
+	for (batch = 0; batch < timerCount; batch += BATCH_SIZE) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		for (i = batch; i < MIN(batch + BATCH_SIZE, timerCount); i++) {
+			wheelTimers[i] = [[wheel scheduleTimerWithDelay:(nextRandom(&state) % MAXIMUM_DELAY_MS) * 0.001
+											 repeatInterval:0
+													 target:self
+												   selector:@selector(timerFired:)
+												   userInfo:nil] retain];
+		}
+		[pool release];
+	}
+	addCost(costs, @"AITimerWheel schedule", timerCount, mach_absolute_time() - start);
+
+	state = seed;
+	start = mach_absolute_time();
+	for (batch = 0; batch < timerCount; batch += BATCH_SIZE) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		for (i = batch; i < MIN(batch + BATCH_SIZE, timerCount); i++) {
+			timers[i] = [[NSTimer alloc] initWithFireDate:[NSDate dateWithTimeIntervalSinceNow:(nextRandom(&state) % MAXIMUM_DELAY_MS) * 0.001]
+												 interval:0
+												   target:self
+												 selector:@selector(timerFired:)
+												 userInfo:nil
+												  repeats:NO];
+			[runLoop addTimer:timers[i] forMode:NSDefaultRunLoopMode];
+		}
+		[pool release];
+	}
+	addCost(costs, @"NSTimer schedule", timerCount, mach_absolute_time() - start);
+
+	//Keystrokes, each pushing back one timer
+	state = seed;
+	start = mach_absolute_time();
+	for (batch = 0; batch < rescheduleCount; batch += KEYSTROKES_PER_TICK) {
+		for (i = batch; i < MIN(batch + KEYSTROKES_PER_TICK, rescheduleCount); i++) {
+			[wheelTimers[nextRandom(&state) % timerCount] rescheduleAfterDelay:TYPING_DELAY];
+		}
+		[wheel advanceTimeBy:TICK_INTERVAL];
+	}
+	addCost(costs, @"AIWheelTimer rescheduleAfterDelay: and firing", rescheduleCount, mach_absolute_time() - start);
+
+	state = seed;
+	start = mach_absolute_time();
+	for (batch = 0; batch < rescheduleCount; batch += BATCH_SIZE) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		for (i = batch; i < MIN(batch + BATCH_SIZE, rescheduleCount); i++) {
+			[timers[nextRandom(&state) % timerCount] setFireDate:[NSDate dateWithTimeIntervalSinceNow:TYPING_DELAY]];
+		}
+		[pool release];
+	}
+	addCost(costs, @"NSTimer setFireDate:", rescheduleCount, mach_absolute_time() - start);
+
+	//Let the rest come due
+	NSUInteger firedBefore = firedCount;
+	start = mach_absolute_time();
+	while (wheel.timerCount) {
+		[wheel advanceTimeBy:1.0];
+	}
+	addCost(costs, @"AITimerWheel advanceTimeBy: firing the rest", timerCount - firedBefore, mach_absolute_time() - start);
+
+	//Invalidating; the wheel's timers have all fired, so schedule them again first
+	for (i = 0; i < timerCount; i++) {
+		[wheelTimers[i] release];
+		wheelTimers[i] = [[wheel scheduleTimerWithDelay:(i % MAXIMUM_DELAY_MS) * 0.001
+										 repeatInterval:0
+												 target:self
+											   selector:@selector(timerFired:)
+											   userInfo:nil] retain];
+	}
+
+	start = mach_absolute_time();
+	for (i = 0; i < timerCount; i++) {
+		[wheelTimers[i] invalidate];
+	}
+	addCost(costs, @"AIWheelTimer invalidate", timerCount, mach_absolute_time() - start);
+
+	start = mach_absolute_time();
+	for (i = 0; i < timerCount; i++) {
+		[timers[i] invalidate];
+	}
+	addCost(costs, @"NSTimer invalidate", timerCount, mach_absolute_time() - start);
+
+	for (i = 0; i < timerCount; i++) {
+		[wheelTimers[i] release];
+		[timers[i] release];
+	}
+	free(wheelTimers);
+	free(timers);
+	[wheel release]; wheel = nil;
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:timerCount], KEY_TIMER_WHEEL_REPORT_TIMERS,
+			[NSNumber numberWithUnsignedInteger:rescheduleCount], KEY_TIMER_WHEEL_REPORT_RESCHEDULES,
+			[NSNumber numberWithUnsignedInteger:firedCount], KEY_TIMER_WHEEL_REPORT_FIRED,
+			[NSNumber numberWithUnsignedInteger:wakeupCount], KEY_TIMER_WHEEL_REPORT_WAKEUPS,
+			costs, KEY_TIMER_WHEEL_REPORT_OPERATIONS,
+			nil];
+}
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSDictionary	*costs = [report objectForKey:KEY_TIMER_WHEEL_REPORT_OPERATIONS];
+
+	[description appendFormat:@"Timers: %@, reschedules: %@\n",
+	 [report objectForKey:KEY_TIMER_WHEEL_REPORT_TIMERS], [report objectForKey:KEY_TIMER_WHEEL_REPORT_RESCHEDULES]];
+	[description appendFormat:@"Fired: %@ on %@ wakeups\n",
+	 [report objectForKey:KEY_TIMER_WHEEL_REPORT_FIRED], [report objectForKey:KEY_TIMER_WHEEL_REPORT_WAKEUPS]];
+
+	[description appendString:@"\n"];
+	for (NSString *name in [[costs allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		NSDictionary	*cost = [costs objectForKey:name];
+		NSUInteger		count = [[cost objectForKey:@"Count"] unsignedIntegerValue];
+		double			seconds = [[cost objectForKey:@"Seconds"] doubleValue];
+
+		[description appendFormat:@"  %-50s %8lu  %9.3f s  %10.3f us each\n",
+		 [name UTF8String], (unsigned long)count, seconds, (count ? seconds * USEC_PER_SEC / count : 0.0)];
+	}
+
+	return description;
+}
+
+@end
@@ -0,0 +1,53 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+
+//Report keys
+#define KEY_TIMESTAMP_REPORT_TIMESTAMPS		@"Timestamps"
+#define KEY_TIMESTAMP_REPORT_FILE_NAMES		@"File Names"
+#define KEY_TIMESTAMP_REPORT_OPERATIONS		@"Operations"
+#define KEY_TIMESTAMP_REPORT_MISMATCH_COUNT	@"Mismatch Count"
+#define KEY_TIMESTAMP_REPORT_MISMATCHES		@"Mismatches"
+
+/*!
+ * @class AITimestampCodecBenchmark
+ * @brief Reads and writes chat log timestamps with AITimestampCodec and with ISO8601DateFormatter
+ *
+ * timestampCount timestamps spread over twenty years and a handful of time zones are written and read back by each,
+ * as the logger, the transcript viewer and message history do, and a hundredth as many log file name dates are read
+ * the way dateFromFileName() used to, with a new formatter each time. Every result of the codec is checked against
+ * the formatter's.
+ *
+ * Run with -AITimestampCodecBenchmark YES. Settings:
+ *	-AITimestampCodecBenchmarkTimestamps <n>	Timestamps to write and read (1000000)
+ *	-AIContactListBenchmarkSeed <n>				Seed for the random choices (1)
+ */
+@interface AITimestampCodecBenchmark : NSObject <AIBenchmark> {
+	NSUInteger			timestampCount;
+	uint32_t			seed;
+
+	NSMutableArray		*mismatches;
+}
+
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger timestampCount;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
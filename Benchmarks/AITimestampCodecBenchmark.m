@@ -0,0 +1,284 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AITimestampCodecBenchmark.h"
+#import <AIUtilities/AITimestampCodec.h>
+#import <AIUtilities/ISO8601DateFormatter.h>
+#import <mach/mach_time.h>
+
+//Settings
+#define KEY_TIMESTAMP_BENCHMARK_TIMESTAMPS	@"AITimestampCodecBenchmarkTimestamps"
+
+//Timestamps are spread over twenty years from 2005
+#define FIRST_TIMESTAMP				126230400.0
+#define TIMESTAMP_SPAN				(20 * 365 * 86400U)
+//Work is done in batches, each in its own autorelease pool
+#define BATCH_SIZE					10000
+#define MAX_REPORTED_MISMATCHES		20
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+static void addCost(NSMutableDictionary *costs, NSString *costName, NSUInteger count, uint64_t machTime)
+{
+	[costs setObject:[NSDictionary dictionaryWithObjectsAndKeys:
+					  [NSNumber numberWithUnsignedInteger:count], @"Count",
+					  [NSNumber numberWithDouble:secondsFromMachTime(machTime)], @"Seconds",
+					  nil]
+			  forKey:costName];
+}
+
+@interface AITimestampCodecBenchmark ()
+- (void)noteMismatch:(NSString *)mismatch;
+@end
+
+@implementation AITimestampCodecBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:1000000], KEY_TIMESTAMP_BENCHMARK_TIMESTAMPS,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AITimestampCodecBenchmark *benchmark = [[[self alloc] init] autorelease];
+
+	benchmark.timestampCount = [defaults integerForKey:KEY_TIMESTAMP_BENCHMARK_TIMESTAMPS];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (id)init
+{
+	if ((self = [super init])) {
+		timestampCount = 1000000;
+		seed = 1;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[mismatches release];
+
+	[super dealloc];
+}
+
+@synthesize timestampCount, seed;
+
+- (void)noteMismatch:(NSString *)mismatch
+{
+	if (mismatches.count < MAX_REPORTED_MISMATCHES)
+		[mismatches addObject:mismatch];
+}
+
+- (NSDictionary *)run
+{
+	NSArray					*timeZoneNames = [NSArray arrayWithObjects:@"America/Los_Angeles", @"America/New_York", @"Europe/Berlin",
+											  @"Asia/Kolkata", @"Australia/Adelaide", @"UTC", nil];
+	NSMutableArray			*timeZones = [NSMutableArray array];
+	NSMutableDictionary		*costs = [NSMutableDictionary dictionary];
+	ISO8601DateFormatter	*formatter = [[[ISO8601DateFormatter alloc] init] autorelease];
+	AITimestampCodec		*codec = [[[AITimestampCodec alloc] init] autorelease];
+	NSUInteger				fileNameCount = MAX(timestampCount / 100, 1U);
+	NSDate					**dates = malloc(timestampCount * sizeof(NSDate *));
+	NSTimeZone				**dateTimeZones = malloc(timestampCount * sizeof(NSTimeZone *));
+	NSString				**strings = malloc(timestampCount * sizeof(NSString *));
+	NSString				**fileNameStrings = malloc(fileNameCount * sizeof(NSString *));
+	NSUInteger				mismatchCount = 0;
+	uint32_t				state = seed;
+	uint64_t				start;
+	NSUInteger				i, batch;
+
+	[mismatches release];
+	mismatches = [[NSMutableArray alloc] init];
+	formatter.includeTime = YES;
+
+	for (NSString *name in timeZoneNames) {
+		[timeZones addObject:[NSTimeZone timeZoneWithName:name]];
+	}
+
+	//Logs are written in order, a conversation at a time, so runs of timestamps share a time zone. Timestamps hold
+	//whole seconds, so they read back exactly.
+	NSTimeZone *timeZone = [timeZones objectAtIndex:0];
+	for (i = 0; i < timestampCount; i++) {
+		if (i % 200 == 0) timeZone = [timeZones objectAtIndex:nextRandom(&state) % timeZones.count];
+
+		dates[i] = [[NSDate alloc] initWithTimeIntervalSinceReferenceDate:FIRST_TIMESTAMP + floor((double)i * TIMESTAMP_SPAN / timestampCount)];
+		dateTimeZones[i] = timeZone;
+	}
+
+	//Writing
+	start = mach_absolute_time();
+	for (batch = 0; batch < timestampCount; batch += BATCH_SIZE) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		for (i = batch; i < MIN(batch + BATCH_SIZE, timestampCount); i++) {
+			[formatter stringFromDate:dates[i] timeZone:dateTimeZones[i]];
+		}
+		[pool release];
+	}
+	addCost(costs, @"ISO8601DateFormatter stringFromDate:", timestampCount, mach_absolute_time() - start);
+
+	start = mach_absolute_time();
+	for (batch = 0; batch < timestampCount; batch += BATCH_SIZE) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		for (i = batch; i < MIN(batch + BATCH_SIZE, timestampCount); i++) {
+			strings[i] = [[codec stringFromDate:dates[i] timeZone:dateTimeZones[i]] retain];
+		}
+		[pool release];
+	}
+	addCost(costs, @"AITimestampCodec stringFromDate:", timestampCount, mach_absolute_time() - start);
+
+	//Reading
+	start = mach_absolute_time();
+	for (batch = 0; batch < timestampCount; batch += BATCH_SIZE) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		for (i = batch; i < MIN(batch + BATCH_SIZE, timestampCount); i++) {
+			[formatter dateFromString:strings[i]];
+		}
+		[pool release];
+	}
+	addCost(costs, @"ISO8601DateFormatter dateFromString:", timestampCount, mach_absolute_time() - start);
+
+	start = mach_absolute_time();
+	for (batch = 0; batch < timestampCount; batch += BATCH_SIZE) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		for (i = batch; i < MIN(batch + BATCH_SIZE, timestampCount); i++) {
+			[codec dateFromString:strings[i]];
+		}
+		[pool release];
+	}
+	addCost(costs, @"AITimestampCodec dateFromString:", timestampCount, mach_absolute_time() - start);
+
+	//Log file names, each read with a formatter of its own as dateFromFileName() did
+	AITimestampCodec *fileNameCodec = [[[AITimestampCodec alloc] initWithTimeSeparator:'.'] autorelease];
+	for (i = 0; i < fileNameCount; i++) {
+		NSUInteger index = nextRandom(&state) % timestampCount;
+		fileNameStrings[i] = [[fileNameCodec stringFromDate:dates[index] timeZone:dateTimeZones[index]] retain];
+	}
+
+	start = mach_absolute_time();
+	for (batch = 0; batch < fileNameCount; batch += BATCH_SIZE) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		for (i = batch; i < MIN(batch + BATCH_SIZE, fileNameCount); i++) {
+			ISO8601DateFormatter *fileNameFormatter = [[ISO8601DateFormatter alloc] init];
+			fileNameFormatter.timeSeparator = '.';
+			[fileNameFormatter dateFromString:fileNameStrings[i]];
+			[fileNameFormatter release];
+		}
+		[pool release];
+	}
+	addCost(costs, @"new ISO8601DateFormatter per file name", fileNameCount, mach_absolute_time() - start);
+
+	start = mach_absolute_time();
+	for (batch = 0; batch < fileNameCount; batch += BATCH_SIZE) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		for (i = batch; i < MIN(batch + BATCH_SIZE, fileNameCount); i++) {
+			[AITimestampCodec dateFromString:fileNameStrings[i] timeSeparator:'.'];
+		}
+		[pool release];
+	}
+	addCost(costs, @"+[AITimestampCodec dateFromString:timeSeparator:]", fileNameCount, mach_absolute_time() - start);
+
+	//Check every answer against the formatter's, outside the timings
+	for (batch = 0; batch < timestampCount; batch += BATCH_SIZE) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		for (i = batch; i < MIN(batch + BATCH_SIZE, timestampCount); i++) {
+			NSString	*expectedString = [formatter stringFromDate:dates[i] timeZone:dateTimeZones[i]];
+			NSDate		*expectedDate = [formatter dateFromString:strings[i]];
+			NSDate		*date = [codec dateFromString:strings[i]];
+
+			if (![strings[i] isEqualToString:expectedString]) {
+				mismatchCount++;
+				[self noteMismatch:[NSString stringWithFormat:@"%@ in %@ was written as %@, not %@",
+									dates[i], [dateTimeZones[i] name], strings[i], expectedString]];
+			}
+			if (![date isEqualToDate:expectedDate] || ![date isEqualToDate:dates[i]]) {
+				mismatchCount++;
+				[self noteMismatch:[NSString stringWithFormat:@"%@ was read as %@, not %@ (written from %@)",
+									strings[i], date, expectedDate, dates[i]]];
+			}
+		}
+		[pool release];
+	}
+
+	for (i = 0; i < timestampCount; i++) {
+		[dates[i] release];
+		[strings[i] release];
+	}
+	for (i = 0; i < fileNameCount; i++) {
+		[fileNameStrings[i] release];
+	}
+	free(dates);
+	free(dateTimeZones);
+	free(strings);
+	free(fileNameStrings);
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:timestampCount], KEY_TIMESTAMP_REPORT_TIMESTAMPS,
+			[NSNumber numberWithUnsignedInteger:fileNameCount], KEY_TIMESTAMP_REPORT_FILE_NAMES,
+			[NSNumber numberWithUnsignedInteger:mismatchCount], KEY_TIMESTAMP_REPORT_MISMATCH_COUNT,
+			[[mismatches copy] autorelease], KEY_TIMESTAMP_REPORT_MISMATCHES,
+			costs, KEY_TIMESTAMP_REPORT_OPERATIONS,
+			nil];
+}
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSArray			*reportMismatches = [report objectForKey:KEY_TIMESTAMP_REPORT_MISMATCHES];
+	NSDictionary	*costs = [report objectForKey:KEY_TIMESTAMP_REPORT_OPERATIONS];
+
+	[description appendFormat:@"Timestamps: %@, log file names: %@\n",
+	 [report objectForKey:KEY_TIMESTAMP_REPORT_TIMESTAMPS], [report objectForKey:KEY_TIMESTAMP_REPORT_FILE_NAMES]];
+	[description appendFormat:@"Mismatches: %@\n", [report objectForKey:KEY_TIMESTAMP_REPORT_MISMATCH_COUNT]];
+
+	for (NSString *mismatch in reportMismatches) {
+		[description appendFormat:@"  %@\n", mismatch];
+	}
+
+	[description appendString:@"\n"];
+	for (NSString *name in [[costs allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		NSDictionary	*cost = [costs objectForKey:name];
+		NSUInteger		count = [[cost objectForKey:@"Count"] unsignedIntegerValue];
+		double			seconds = [[cost objectForKey:@"Seconds"] doubleValue];
+
+		[description appendFormat:@"  %-50s %8lu  %9.3f s  %10.3f us each\n",
+		 [name UTF8String], (unsigned long)count, seconds, (count ? seconds * USEC_PER_SEC / count : 0.0)];
+	}
+
+	return description;
+}
+
+@end
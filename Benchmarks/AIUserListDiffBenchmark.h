@@ -0,0 +1,92 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIBenchmark.h"
+
+@class AIBenchmarkAccount;
+
+//Report keys
+#define KEY_USERLIST_REPORT_PARTICIPANTS		@"Participants"
+#define KEY_USERLIST_REPORT_SPLIT				@"Split"
+#define KEY_USERLIST_REPORT_BURST				@"Burst Size"
+#define KEY_USERLIST_REPORT_EVENTS				@"Events"
+#define KEY_USERLIST_REPORT_TURNS				@"Turns"
+#define KEY_USERLIST_REPORT_CHECKS				@"Checks"
+#define KEY_USERLIST_REPORT_MISMATCHES			@"Mismatches"
+#define KEY_USERLIST_REPORT_PASSES				@"Passes"
+
+//Keys of each pass in KEY_USERLIST_REPORT_PASSES
+#define KEY_USERLIST_PASS_UPDATES				@"Updates"
+#define KEY_USERLIST_PASS_COMPARISONS			@"Comparisons"
+#define KEY_USERLIST_PASS_ROWS_RELOADED			@"Rows Reloaded"
+#define KEY_USERLIST_PASS_ROWS_INSERTED			@"Rows Inserted"
+#define KEY_USERLIST_PASS_ROWS_REMOVED			@"Rows Removed"
+#define KEY_USERLIST_PASS_ROWS_MOVED			@"Rows Moved"
+#define KEY_USERLIST_PASS_SECONDS				@"Seconds"
+
+/*!
+ * @class AIUserListDiffBenchmark
+ * @brief Replays a recorded netsplit into a group chat and counts the work of keeping its user list up to date
+ *
+ * A channel of participantCount users is joined, sees some ordinary joins, parts, nick and mode changes, then loses
+ * splitPercent of its users to a netsplit and gets them back, in bursts of burstSize events per run loop turn, as
+ * libpurple delivers them after a socket read. Ops get their modes back once they have rejoined.
+ *
+ * The replay is made twice, on two chats, without a window. The first pass does what the message view used to for
+ * every Chat_ParticipatingListObjectsChanged: sort all the participants and reload every row. The second applies
+ * the chat's journal once per turn and works out the rows to insert, remove, move and redraw with AIArrayEditScript,
+ * as ESChatUserListController does. Sort comparisons are counted with +[AIChat participantComparisonCount].
+ *
+ * After every turn of the second pass, its rows are checked against the chat's participants, which are checked to be
+ * in order. The chats are closed before -run returns.
+ *
+ * Run with -AIUserListDiffBenchmark YES. Settings:
+ *	-AIUserListDiffBenchmarkParticipants <n>	Members of the channel (2000)
+ *	-AIUserListDiffBenchmarkSplitPercent <n>	Percentage of them lost in the netsplit (40)
+ *	-AIUserListDiffBenchmarkBurstSize <n>		Members who rejoin in each burst (20)
+ *	-AIContactListBenchmarkSeed <n>				Seed for the random choices (1)
+ */
+@interface AIUserListDiffBenchmark : NSObject <AIBenchmark> {
+	AIBenchmarkAccount	*account;
+
+	NSUInteger			participantCount;
+	NSUInteger			splitPercent;
+	NSUInteger			burstSize;
+	NSUInteger			churnEventCount;
+	uint32_t			seed;
+
+	NSMutableData		*events;
+	NSMutableArray		*turnLengths;
+
+	NSMutableArray		*displayedParticipants;
+	NSMutableDictionary	*passCounts;
+	NSMutableArray		*mismatches;
+	NSUInteger			checkCount;
+	uint64_t			passTime;
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount;
+- (NSDictionary *)run;
+
++ (NSString *)descriptionOfReport:(NSDictionary *)report;
+
+@property (readwrite, nonatomic) NSUInteger participantCount;
+@property (readwrite, nonatomic) NSUInteger splitPercent;
+@property (readwrite, nonatomic) NSUInteger burstSize;
+@property (readwrite, nonatomic) NSUInteger churnEventCount;
+@property (readwrite, nonatomic) uint32_t seed;
+
+@end
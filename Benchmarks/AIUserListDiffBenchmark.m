@@ -0,0 +1,569 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIUserListDiffBenchmark.h"
+#import "AIBenchmarkAccount.h"
+#import <Adium/AIChat.h>
+#import <Adium/AIChatControllerProtocol.h>
+#import <Adium/AIListContact.h>
+#import <AIUtilities/AIArrayEditScript.h>
+#import <mach/mach_time.h>
+
+//Settings
+#define KEY_USERLIST_BENCHMARK_PARTICIPANTS	@"AIUserListDiffBenchmarkParticipants"
+#define KEY_USERLIST_BENCHMARK_SPLIT		@"AIUserListDiffBenchmarkSplitPercent"
+#define KEY_USERLIST_BENCHMARK_BURST		@"AIUserListDiffBenchmarkBurstSize"
+
+//How many mismatches are described in the report
+#define MAX_REPORTED_MISMATCHES			20
+
+#define PASS_RELOAD						@"Full resort and reload per change"
+#define PASS_DIFF						@"Journal and row diff per turn"
+
+typedef enum {
+	AIUserListEventNames = 0,	//One of the users listed on joining the channel
+	AIUserListEventJoin,
+	AIUserListEventPart,
+	AIUserListEventRename,
+	AIUserListEventMode
+} AIUserListEventType;
+
+typedef struct {
+	AIUserListEventType	type;
+	NSUInteger			user;
+	AIGroupChatFlags	flags;
+	uint32_t			nick;		//Seeds the user's nickname after the event
+} AIUserListEvent;
+
+@interface AIUserListDiffBenchmark ()
+- (void)recordNetsplit;
+- (void)replayIntoChatNamed:(NSString *)chatName diffing:(BOOL)diffing;
+- (void)applyTurn:(const AIUserListEvent *)turnEvents count:(NSUInteger)count toChat:(AIChat *)chat;
+- (void)checkChat:(AIChat *)chat afterTurn:(NSUInteger)turn;
+- (void)addCount:(NSUInteger)count forKey:(NSString *)key;
+@end
+
+/*!
+ * @brief The same generator as AIContactListTrace's, so a seed gives the same replay everywhere
+ */
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static double secondsFromMachTime(uint64_t machTime)
+{
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+static NSString *UIDForUser(NSUInteger user)
+{
+	return [NSString stringWithFormat:@"user%lu", (unsigned long)user];
+}
+
+/*!
+ * @brief A nickname of 3 to 10 letters, some capitalized, so the case insensitive part of the sort has work to do
+ */
+static NSString *nicknameForSeed(uint32_t nick)
+{
+	unichar		characters[10];
+	NSUInteger	length = 3 + nick % 8;
+
+	for (NSUInteger i = 0; i < length; i++) {
+		characters[i] = (unichar)('a' + nextRandom(&nick) % 26);
+		if (nextRandom(&nick) % 5 == 0) characters[i] -= ('a' - 'A');
+	}
+
+	return [NSString stringWithCharacters:characters length:length];
+}
+
+/*!
+ * @brief The rank AIChat sorts participants by, highest first, worked out independently
+ */
+static NSUInteger flagRank(AIGroupChatFlags flags)
+{
+	if (flags & AIGroupChatFounder) return 4;
+	if (flags & AIGroupChatOp) return 3;
+	if (flags & AIGroupChatHalfOp) return 2;
+	if (flags & AIGroupChatVoice) return 1;
+
+	return 0;
+}
+
+/*!
+ * @brief Flags to join with: a few ops and half-ops, more voiced users, and some of everyone away
+ */
+static AIGroupChatFlags randomFlags(uint32_t *state)
+{
+	AIGroupChatFlags	flags = AIGroupChatNone;
+	uint32_t			roll = nextRandom(state) % 100;
+
+	if (roll == 0)
+		flags = AIGroupChatFounder | AIGroupChatOp;
+	else if (roll < 5)
+		flags = AIGroupChatOp;
+	else if (roll < 7)
+		flags = AIGroupChatHalfOp;
+	else if (roll < 20)
+		flags = AIGroupChatVoice;
+
+	if (nextRandom(state) % 4 == 0) flags |= AIGroupChatAway;
+
+	return flags;
+}
+
+@implementation AIUserListDiffBenchmark
+
++ (NSDictionary *)defaultSettings
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:2000], KEY_USERLIST_BENCHMARK_PARTICIPANTS,
+			[NSNumber numberWithUnsignedInteger:40], KEY_USERLIST_BENCHMARK_SPLIT,
+			[NSNumber numberWithUnsignedInteger:20], KEY_USERLIST_BENCHMARK_BURST,
+			nil];
+}
+
++ (id <AIBenchmark>)benchmarkWithDefaults:(NSUserDefaults *)defaults
+{
+	AIUserListDiffBenchmark *benchmark = [[[self alloc] initWithAccount:[AIBenchmarkAccount addTemporaryAccountWithUID:BENCHMARK_ACCOUNT_UID]] autorelease];
+
+	benchmark.participantCount = [defaults integerForKey:KEY_USERLIST_BENCHMARK_PARTICIPANTS];
+	benchmark.splitPercent = [defaults integerForKey:KEY_USERLIST_BENCHMARK_SPLIT];
+	benchmark.burstSize = [defaults integerForKey:KEY_USERLIST_BENCHMARK_BURST];
+	benchmark.seed = (uint32_t)[defaults integerForKey:KEY_BENCHMARK_SEED];
+
+	return benchmark;
+}
+
+- (void)deleteAccounts
+{
+	[account deleteTemporaryAccount];
+}
+
+- (id)initWithAccount:(AIBenchmarkAccount *)inAccount
+{
+	if ((self = [super init])) {
+		account = [inAccount retain];
+		participantCount = 2000;
+		splitPercent = 40;
+		burstSize = 20;
+		churnEventCount = 200;
+		seed = 1;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+
+	[account release];
+	[events release];
+	[turnLengths release];
+	[displayedParticipants release];
+	[passCounts release];
+	[mismatches release];
+
+	[super dealloc];
+}
+
+@synthesize participantCount, splitPercent, burstSize, churnEventCount, seed;
+
+/*!
+ * @brief Record the netsplit, replay it both ways, and report
+ */
+- (NSDictionary *)run
+{
+	NSMutableDictionary	*passes = [NSMutableDictionary dictionary];
+
+	[mismatches release]; mismatches = [[NSMutableArray alloc] init];
+	checkCount = 0;
+
+	[self recordNetsplit];
+
+	for (NSString *passName in [NSArray arrayWithObjects:PASS_RELOAD, PASS_DIFF, nil]) {
+		BOOL diffing = [passName isEqualToString:PASS_DIFF];
+
+		[passCounts release]; passCounts = [[NSMutableDictionary alloc] init];
+		passTime = 0;
+
+		[self replayIntoChatNamed:(diffing ? @"#netsplit-diff" : @"#netsplit-reload") diffing:diffing];
+
+		[passCounts setObject:[NSNumber numberWithDouble:secondsFromMachTime(passTime)] forKey:KEY_USERLIST_PASS_SECONDS];
+		[passes setObject:[[passCounts copy] autorelease] forKey:passName];
+	}
+
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			[NSNumber numberWithUnsignedInteger:participantCount], KEY_USERLIST_REPORT_PARTICIPANTS,
+			[NSNumber numberWithUnsignedInteger:participantCount * splitPercent / 100], KEY_USERLIST_REPORT_SPLIT,
+			[NSNumber numberWithUnsignedInteger:burstSize], KEY_USERLIST_REPORT_BURST,
+			[NSNumber numberWithUnsignedInteger:events.length / sizeof(AIUserListEvent)], KEY_USERLIST_REPORT_EVENTS,
+			[NSNumber numberWithUnsignedInteger:turnLengths.count], KEY_USERLIST_REPORT_TURNS,
+			[NSNumber numberWithUnsignedInteger:checkCount], KEY_USERLIST_REPORT_CHECKS,
+			[[mismatches copy] autorelease], KEY_USERLIST_REPORT_MISMATCHES,
+			passes, KEY_USERLIST_REPORT_PASSES,
+			nil];
+}
+
+#pragma mark Recording
+
+/*!
+ * @brief Write down every event of the replay, and how many events each run loop turn delivers
+ */
+- (void)recordNetsplit
+{
+	NSUInteger			userCount = participantCount + churnEventCount;
+	AIGroupChatFlags	*flags = malloc(userCount * sizeof(AIGroupChatFlags));
+	uint32_t			*nicks = malloc(userCount * sizeof(uint32_t));
+	NSUInteger			*present = malloc(userCount * sizeof(NSUInteger));
+	NSUInteger			presentCount = 0, nextUser = 0, i;
+	uint32_t			state = seed;
+	__block NSUInteger	turnLength = 0;
+
+	[events release]; events = [[NSMutableData alloc] init];
+	[turnLengths release]; turnLengths = [[NSMutableArray alloc] init];
+
+	void (^record)(AIUserListEventType, NSUInteger) = ^(AIUserListEventType type, NSUInteger user) {
+		AIUserListEvent event = { type, user, flags[user], nicks[user] };
+		[events appendBytes:&event length:sizeof(event)];
+		turnLength++;
+	};
+	void (^endTurn)(void) = ^{
+		if (turnLength) [turnLengths addObject:[NSNumber numberWithUnsignedInteger:turnLength]];
+		turnLength = 0;
+	};
+
+	//The names list on joining arrives in one go
+	for (nextUser = 0; nextUser < participantCount; nextUser++) {
+		flags[nextUser] = randomFlags(&state);
+		nicks[nextUser] = nextRandom(&state);
+		present[presentCount++] = nextUser;
+		record(AIUserListEventNames, nextUser);
+	}
+	endTurn();
+
+	//Ordinary traffic, one event at a time
+	for (i = 0; i < churnEventCount; i++) {
+		uint32_t	roll = nextRandom(&state) % 4;
+		NSUInteger	slot = (presentCount ? nextRandom(&state) % presentCount : 0);
+
+		if (roll == 0 || !presentCount) {
+			flags[nextUser] = randomFlags(&state) & ~(AIGroupChatFounder | AIGroupChatOp | AIGroupChatHalfOp);
+			nicks[nextUser] = nextRandom(&state);
+			present[presentCount++] = nextUser;
+			record(AIUserListEventJoin, nextUser++);
+
+		} else if (roll == 1) {
+			record(AIUserListEventPart, present[slot]);
+			present[slot] = present[--presentCount];
+
+		} else if (roll == 2) {
+			nicks[present[slot]] = nextRandom(&state);
+			record(AIUserListEventRename, present[slot]);
+
+		} else {
+			flags[present[slot]] ^= ((nextRandom(&state) % 2) ? AIGroupChatVoice : AIGroupChatAway);
+			record(AIUserListEventMode, present[slot]);
+		}
+		endTurn();
+	}
+
+	//The split: a share of the channel quits, a burst at a time
+	NSUInteger	splitCount = MIN(participantCount * splitPercent / 100, presentCount);
+	NSUInteger	*split = malloc(MAX(splitCount, 1) * sizeof(NSUInteger));
+
+	for (i = 0; i < splitCount; i++) {
+		NSUInteger slot = nextRandom(&state) % presentCount;
+
+		split[i] = present[slot];
+		present[slot] = present[--presentCount];
+		record(AIUserListEventPart, split[i]);
+		if (turnLength == burstSize) endTurn();
+	}
+	endTurn();
+
+	//They come back without their modes...
+	for (i = 0; i < splitCount; i++) {
+		AIGroupChatFlags modes = flags[split[i]];
+
+		flags[split[i]] = modes & AIGroupChatAway;
+		record(AIUserListEventJoin, split[i]);
+		flags[split[i]] = modes;
+		if (turnLength == burstSize) endTurn();
+	}
+	endTurn();
+
+	//...which the server gives back once the split has healed
+	for (i = 0; i < splitCount; i++) {
+		if (!(flags[split[i]] & ~AIGroupChatAway)) continue;
+
+		record(AIUserListEventMode, split[i]);
+		if (turnLength == burstSize) endTurn();
+	}
+	endTurn();
+
+	free(split);
+	free(present);
+	free(nicks);
+	free(flags);
+}
+
+#pragma mark Replaying
+
+/*!
+ * @brief Replay the recording into a new chat, keeping a user list up to date one way or the other
+ */
+- (void)replayIntoChatNamed:(NSString *)chatName diffing:(BOOL)diffing
+{
+	AIChat	*chat = [adium.chatController chatWithName:chatName
+										   identifier:nil
+											onAccount:account
+									 chatCreationInfo:nil];
+	if (!chat) return;
+	chat.isOpen = YES;
+
+	[displayedParticipants release]; displayedParticipants = [[NSMutableArray alloc] init];
+
+	if (diffing) {
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(participantsDidChange:)
+													 name:Chat_ParticipantsDidChange
+												   object:chat];
+	} else {
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(participatingListObjectsChanged:)
+													 name:Chat_ParticipatingListObjectsChanged
+												   object:chat];
+	}
+
+	const AIUserListEvent	*event = events.bytes;
+	NSUInteger				turn = 0;
+
+	for (NSNumber *turnLength in turnLengths) {
+		NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+		NSUInteger			count = [turnLength unsignedIntegerValue];
+
+		[self applyTurn:event count:count toChat:chat];
+		event += count;
+
+		/* The end of the run loop turn. Without a diffing user list, the journal is still flushed to keep it short,
+		 * but nothing is listening and its cost isn't counted; the old code didn't have one.
+		 */
+		if (diffing) {
+			NSUInteger	comparisons = [AIChat participantComparisonCount];
+			uint64_t	start = mach_absolute_time();
+
+			[chat flushParticipantChanges];
+
+			passTime += mach_absolute_time() - start;
+			[self addCount:[AIChat participantComparisonCount] - comparisons forKey:KEY_USERLIST_PASS_COMPARISONS];
+
+			[self checkChat:chat afterTurn:turn];
+		} else {
+			[chat flushParticipantChanges];
+		}
+
+		turn++;
+		[pool release];
+	}
+
+	[[NSNotificationCenter defaultCenter] removeObserver:self name:nil object:chat];
+	[adium.chatController closeChat:chat];
+}
+
+/*!
+ * @brief Apply one turn's events the way CBPurpleAccount does, including its notifications
+ */
+- (void)applyTurn:(const AIUserListEvent *)turnEvents count:(NSUInteger)count toChat:(AIChat *)chat
+{
+	NSMutableArray	*namesList = [NSMutableArray array];
+	NSUInteger		i;
+
+	//The names list is added all at once, then given its flags and aliases, as -updateUserListForChat:users:newlyAdded: does
+	for (i = 0; i < count && turnEvents[i].type == AIUserListEventNames; i++) {
+		[namesList addObject:[account contactWithUID:UIDForUser(turnEvents[i].user)]];
+	}
+	if (namesList.count) {
+		[chat addParticipatingListObjects:namesList notify:NO];
+		for (i = 0; i < namesList.count; i++) {
+			[chat setFlags:turnEvents[i].flags forContact:[namesList objectAtIndex:i]];
+			[chat setAlias:nicknameForSeed(turnEvents[i].nick) forContact:[namesList objectAtIndex:i]];
+		}
+		[[NSNotificationCenter defaultCenter] postNotificationName:Chat_ParticipatingListObjectsChanged object:chat];
+	}
+
+	for (; i < count; i++) {
+		const AIUserListEvent	*event = &turnEvents[i];
+		AIListContact			*contact = [account contactWithUID:UIDForUser(event->user)];
+
+		switch (event->type) {
+			case AIUserListEventNames:
+			case AIUserListEventJoin:
+				[chat addParticipatingListObjects:[NSArray arrayWithObject:contact] notify:NO];
+				[chat setFlags:event->flags forContact:contact];
+				[chat setAlias:nicknameForSeed(event->nick) forContact:contact];
+				[[NSNotificationCenter defaultCenter] postNotificationName:Chat_ParticipatingListObjectsChanged object:chat];
+				break;
+
+			case AIUserListEventPart:
+				[chat removeObject:contact];
+				break;
+
+			case AIUserListEventRename:
+				[chat setAlias:nicknameForSeed(event->nick) forContact:contact];
+				[[NSNotificationCenter defaultCenter] postNotificationName:Chat_ParticipatingListObjectsChanged object:chat];
+				break;
+
+			case AIUserListEventMode:
+				[chat setFlags:event->flags forContact:contact];
+				[[NSNotificationCenter defaultCenter] postNotificationName:Chat_ParticipatingListObjectsChanged object:chat];
+				break;
+		}
+	}
+}
+
+/*!
+ * @brief What the message view used to do for every change: resort everyone and reload every row
+ */
+- (void)participatingListObjectsChanged:(NSNotification *)notification
+{
+	AIChat		*chat = [notification object];
+	NSUInteger	comparisons = [AIChat participantComparisonCount];
+	uint64_t	start = mach_absolute_time();
+
+	[chat resortParticipants];
+	[displayedParticipants setArray:chat.containedObjects];
+
+	passTime += mach_absolute_time() - start;
+	[self addCount:[AIChat participantComparisonCount] - comparisons forKey:KEY_USERLIST_PASS_COMPARISONS];
+	[self addCount:1 forKey:KEY_USERLIST_PASS_UPDATES];
+	[self addCount:chat.countOfContainedObjects forKey:KEY_USERLIST_PASS_ROWS_RELOADED];
+}
+
+/*!
+ * @brief What ESChatUserListController does once per turn: touch only the rows which changed
+ */
+- (void)participantsDidChange:(NSNotification *)notification
+{
+	AIChat				*chat = [notification object];
+	NSArray				*participants = chat.containedObjects;
+	uint64_t			start = mach_absolute_time();
+	AIArrayEditScript	*script = [AIArrayEditScript editScriptFromArray:displayedParticipants toArray:participants];
+
+	[script applyToArray:displayedParticipants withObjectsFromArray:participants];
+
+	NSSet			*insertedContacts = [NSSet setWithArray:[participants objectsAtIndexes:script.insertedIndexes]];
+	NSMutableSet	*redrawnContacts = [NSMutableSet set];
+	NSSet			*presentContacts = nil;
+
+	for (AIChatParticipantChange *change in [[notification userInfo] objectForKey:KEY_CHAT_PARTICIPANT_CHANGES]) {
+		if (change.type == AIChatParticipantLeft || [insertedContacts containsObject:change.contact]) continue;
+
+		if (!presentContacts) presentContacts = [NSSet setWithArray:participants];
+		if ([presentContacts containsObject:change.contact]) [redrawnContacts addObject:change.contact];
+	}
+
+	passTime += mach_absolute_time() - start;
+	[self addCount:1 forKey:KEY_USERLIST_PASS_UPDATES];
+	[self addCount:redrawnContacts.count forKey:KEY_USERLIST_PASS_ROWS_RELOADED];
+	[self addCount:script.insertedIndexes.count forKey:KEY_USERLIST_PASS_ROWS_INSERTED];
+	[self addCount:script.removedIndexes.count forKey:KEY_USERLIST_PASS_ROWS_REMOVED];
+	[self addCount:script.moveCount forKey:KEY_USERLIST_PASS_ROWS_MOVED];
+}
+
+/*!
+ * @brief Check the rows match the participants, and the participants are in order
+ */
+- (void)checkChat:(AIChat *)chat afterTurn:(NSUInteger)turn
+{
+	NSArray		*participants = chat.containedObjects;
+	NSUInteger	i;
+
+	checkCount++;
+
+	if (![displayedParticipants isEqualToArray:participants]) {
+		[mismatches addObject:[NSString stringWithFormat:@"Turn %lu: %lu rows for %lu participants, or in a different order",
+							   (unsigned long)turn, (unsigned long)displayedParticipants.count, (unsigned long)participants.count]];
+		[displayedParticipants setArray:participants];
+	}
+
+	for (i = 1; i < participants.count; i++) {
+		AIListContact	*previous = [participants objectAtIndex:i - 1], *contact = [participants objectAtIndex:i];
+		NSUInteger		previousRank = flagRank([chat flagsForContact:previous]), rank = flagRank([chat flagsForContact:contact]);
+
+		if (previousRank < rank ||
+			(previousRank == rank &&
+			 [[chat displayNameForContact:previous] caseInsensitiveCompare:[chat displayNameForContact:contact]] == NSOrderedDescending)) {
+			[mismatches addObject:[NSString stringWithFormat:@"Turn %lu: %@ is listed before %@",
+								   (unsigned long)turn, [chat displayNameForContact:previous], [chat displayNameForContact:contact]]];
+			break;
+		}
+	}
+}
+
+- (void)addCount:(NSUInteger)count forKey:(NSString *)key
+{
+	[passCounts setObject:[NSNumber numberWithUnsignedInteger:[[passCounts objectForKey:key] unsignedIntegerValue] + count]
+				   forKey:key];
+}
+
+#pragma mark Reporting
+
+/*!
+ * @brief A plain text rendering of a report, for the terminal
+ */
++ (NSString *)descriptionOfReport:(NSDictionary *)report
+{
+	NSMutableString	*description = [NSMutableString string];
+	NSArray			*reportMismatches = [report objectForKey:KEY_USERLIST_REPORT_MISMATCHES];
+	NSDictionary	*passes = [report objectForKey:KEY_USERLIST_REPORT_PASSES];
+	NSArray			*countKeys = [NSArray arrayWithObjects:KEY_USERLIST_PASS_UPDATES, KEY_USERLIST_PASS_COMPARISONS,
+								  KEY_USERLIST_PASS_ROWS_RELOADED, KEY_USERLIST_PASS_ROWS_INSERTED,
+								  KEY_USERLIST_PASS_ROWS_REMOVED, KEY_USERLIST_PASS_ROWS_MOVED, nil];
+
+	[description appendFormat:@"Channel: %@ participants, %@ lost to a netsplit and rejoined in bursts of %@\n",
+	 [report objectForKey:KEY_USERLIST_REPORT_PARTICIPANTS], [report objectForKey:KEY_USERLIST_REPORT_SPLIT],
+	 [report objectForKey:KEY_USERLIST_REPORT_BURST]];
+	[description appendFormat:@"Replay: %@ events in %@ run loop turns\n",
+	 [report objectForKey:KEY_USERLIST_REPORT_EVENTS], [report objectForKey:KEY_USERLIST_REPORT_TURNS]];
+	[description appendFormat:@"Checks: %@, mismatches: %lu\n", [report objectForKey:KEY_USERLIST_REPORT_CHECKS],
+	 (unsigned long)reportMismatches.count];
+
+	for (NSUInteger i = 0; i < reportMismatches.count && i < MAX_REPORTED_MISMATCHES; i++) {
+		[description appendFormat:@"  %@\n", [reportMismatches objectAtIndex:i]];
+	}
+
+	for (NSString *passName in [NSArray arrayWithObjects:PASS_RELOAD, PASS_DIFF, nil]) {
+		NSDictionary *pass = [passes objectForKey:passName];
+		if (!pass) continue;
+
+		[description appendFormat:@"\n%@:\n", passName];
+		for (NSString *key in countKeys) {
+			[description appendFormat:@"  %-50s %10lu\n", [key UTF8String], (unsigned long)[[pass objectForKey:key] unsignedIntegerValue]];
+		}
+		[description appendFormat:@"  %-50s %10.3f s\n", [KEY_USERLIST_PASS_SECONDS UTF8String],
+		 [[pass objectForKey:KEY_USERLIST_PASS_SECONDS] doubleValue]];
+	}
+
+	return description;
+}
+
+@end
@@ -15,7 +15,13 @@
  */
 
 
-@interface AdiumApplescriptRunner : NSObject {
+#import <AIUtilities/AIScriptExecutor.h>
+
+/*!
+ * @class AdiumApplescriptRunner
+ * @brief Runs AppleScripts in the AdiumApplescriptRunner helper, launching it as needed
+ */
+@interface AdiumApplescriptRunner : NSObject <AIScriptExecutor> {
 	NSMutableDictionary	*runningApplescriptsDict;
 	NSMutableArray		*pendingApplescriptsArray;
 	BOOL				applescriptRunnerIsReady;	
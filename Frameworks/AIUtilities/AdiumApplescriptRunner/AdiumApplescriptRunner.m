@@ -20,6 +20,7 @@
 - (void)applescriptRunnerIsReady:(NSNotification *)inNotification;
 - (void)applescriptRunnerDidQuit:(NSNotification *)inNotification;
 - (void)applescriptDidRun:(NSNotification *)inNotification;
+- (void)_failScriptsSentToHelper;
 @end
 
 @implementation AdiumApplescriptRunner
@@ -136,11 +137,50 @@
 	}
 }
 
+#pragma mark AIScriptExecutor
+
+- (void)runScriptAtPath:(NSString *)path function:(NSString *)function arguments:(NSArray *)arguments notifyingTarget:(id)target selector:(SEL)selector userInfo:(id)userInfo
+{
+	[self runApplescriptAtPath:path function:function arguments:arguments notifyingTarget:target selector:selector userInfo:userInfo];
+}
+
+/*!
+ * @brief Reset the helper's inactivity timer, if it is running
+ *
+ * The helper treats a readiness check as activity. If it isn't running, it is left to be launched when next needed.
+ */
+- (void)keepAlive
+{
+	if (applescriptRunnerIsReady) {
+		[[NSDistributedNotificationCenter defaultCenter] postNotificationName:@"AdiumApplescriptRunner_RespondIfReady"
+																	   object:nil
+																	 userInfo:nil
+														   deliverImmediately:NO];
+	}
+}
+
+/*!
+ * @brief Give up on a script. The helper still runs it, but its result is dropped.
+ */
+- (void)cancelScriptWithUserInfo:(id)userInfo
+{
+	for (NSString *uniqueID in [runningApplescriptsDict allKeys]) {
+		if ([[runningApplescriptsDict objectForKey:uniqueID] objectForKey:@"userInfo"] == userInfo)
+			[runningApplescriptsDict removeObjectForKey:uniqueID];
+	}
+}
+
+#pragma mark Helper notifications
+
 - (void)applescriptRunnerIsReady:(NSNotification *)inNotification
 {
 	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
 	NSDictionary	*executionDict;
 	
+	//A helper we didn't know was running has been launched; anything sent to one before it is lost
+	if (!applescriptRunnerIsReady)
+		[self _failScriptsSentToHelper];
+
 	applescriptRunnerIsReady = YES;
 	
 	for (executionDict in pendingApplescriptsArray) {
@@ -153,7 +193,39 @@
 
 - (void)applescriptRunnerDidQuit:(NSNotification *)inNotification
 {
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+	//Scripts started by the targets we notify now wait for the helper to be launched again
 	applescriptRunnerIsReady = NO;
+	[self _failScriptsSentToHelper];
+
+	[pool release];
+}
+
+/*!
+ * @brief Notify the targets of scripts sent to a helper which has gone away with a nil result
+ *
+ * Scripts still waiting for the helper to launch are left to be sent to it.
+ */
+- (void)_failScriptsSentToHelper
+{
+	NSMutableSet	*waitingIDs = [NSMutableSet set];
+	NSDictionary	*executionDict;
+
+	for (executionDict in pendingApplescriptsArray) {
+		[waitingIDs addObject:[executionDict objectForKey:@"uniqueID"]];
+	}
+
+	for (NSString *uniqueID in [runningApplescriptsDict allKeys]) {
+		if ([waitingIDs containsObject:uniqueID]) continue;
+
+		NSDictionary *targetDict = [[[runningApplescriptsDict objectForKey:uniqueID] retain] autorelease];
+		[runningApplescriptsDict removeObjectForKey:uniqueID];
+
+		[[targetDict objectForKey:@"target"] performSelector:NSSelectorFromString([targetDict objectForKey:@"selector"])
+												  withObject:[targetDict objectForKey:@"userInfo"]
+												  withObject:nil];
+	}
 }
 
 - (void)applescriptDidRun:(NSNotification *)inNotification
@@ -0,0 +1,78 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <AIUtilities/AIAddrInfoHostResolverBackend.h>
+
+#import <sys/socket.h>
+#import <netdb.h>
+
+#define DEFAULT_TIME_TO_LIVE	60.0
+
+@implementation AIAddrInfoHostResolverBackend
+
+- (id)init
+{
+	if ((self = [super init])) {
+		timeToLive = DEFAULT_TIME_TO_LIVE;
+	}
+
+	return self;
+}
+
+@synthesize timeToLive;
+
+- (void)resolveHostName:(NSString *)hostName completion:(AIHostResolverBackendCompletion)completion
+{
+	NSTimeInterval	answerTimeToLive = timeToLive;
+
+	hostName = [[hostName copy] autorelease];
+
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+		NSMutableArray		*addresses = [NSMutableArray array];
+		NSError				*error = nil;
+		struct addrinfo		hints, *result = NULL;
+		int					err;
+
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = PF_UNSPEC;
+		//One entry per address rather than one per socket type
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_flags = AI_ADDRCONFIG;
+
+		err = getaddrinfo([hostName UTF8String], NULL, &hints, &result);
+		if (err == 0) {
+			for (struct addrinfo *info = result; info; info = info->ai_next) {
+				[addresses addObject:[NSData dataWithBytes:info->ai_addr length:info->ai_addrlen]];
+			}
+			freeaddrinfo(result);
+
+		} else {
+			error = [NSError errorWithDomain:AIHostResolverErrorDomain
+										code:err
+									userInfo:[NSDictionary dictionaryWithObject:[NSString stringWithUTF8String:gai_strerror(err)]
+																		 forKey:NSLocalizedDescriptionKey]];
+		}
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			completion(addresses, answerTimeToLive, error);
+		});
+
+		[pool release];
+	});
+}
+
+@end
@@ -0,0 +1,75 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*!
+ * @class AIArrayEditScript
+ * @brief The removals, moves and insertions which turn one array into another
+ *
+ * Meant for bringing a table or outline view up to date with a changed list without reloading every row. Objects are
+ * matched by identity, not -isEqual:, and must appear at most once in each array.
+ *
+ * The script is applied in three steps: remove removedIndexes, which index the old array; perform the moves in
+ * order, each taking the object at one index and putting it back so it ends up at another; then insert
+ * insertedIndexes, which index the new array. This is the order NSTableView and NSOutlineView expect within
+ * -beginUpdates/-endUpdates.
+ *
+ * Objects which keep their relative order stay put; the longest such run is found, so the number of moves is the
+ * fewest possible.
+ */
+@interface AIArrayEditScript : NSObject {
+	NSIndexSet	*removedIndexes;
+	NSIndexSet	*insertedIndexes;
+
+	NSUInteger	*moves;
+	NSUInteger	 moveCount;
+}
+
++ (AIArrayEditScript *)editScriptFromArray:(NSArray *)oldArray toArray:(NSArray *)newArray;
+- (id)initFromArray:(NSArray *)oldArray toArray:(NSArray *)newArray;
+
+/*!
+ * @brief Indexes in the old array of objects which aren't in the new one
+ */
+@property (readonly, nonatomic) NSIndexSet *removedIndexes;
+
+/*!
+ * @brief Indexes in the new array of objects which weren't in the old one
+ */
+@property (readonly, nonatomic) NSIndexSet *insertedIndexes;
+
+@property (readonly, nonatomic) NSUInteger moveCount;
+
+/*!
+ * @brief Enumerate the moves, in the order they must be made
+ *
+ * fromIndex and toIndex are positions in the array as it stands after the removals and the moves before this one.
+ * toIndex is where the object ends up, as with -[NSTableView moveRowAtIndex:toIndex:].
+ */
+- (void)enumerateMovesUsingBlock:(void (^)(NSUInteger fromIndex, NSUInteger toIndex))block;
+
+/*!
+ * @brief YES if the arrays held the same objects in the same order
+ */
+@property (readonly, nonatomic) BOOL isEmpty;
+
+/*!
+ * @brief Apply the script to a copy of the old array
+ *
+ * @param newArray The array the script was made with, from which inserted objects are taken
+ */
+- (void)applyToArray:(NSMutableArray *)array withObjectsFromArray:(NSArray *)newArray;
+
+@end
@@ -0,0 +1,232 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIArrayEditScript.h"
+
+@interface AIArrayEditScript ()
+- (void)calculateMovesForSequence:(NSUInteger *)sequence count:(NSUInteger)count;
+@end
+
+static int compareIndexes(const void *a, const void *b)
+{
+	NSUInteger indexA = *(const NSUInteger *)a, indexB = *(const NSUInteger *)b;
+
+	return (indexA < indexB ? -1 : (indexA > indexB ? 1 : 0));
+}
+
+/*!
+ * @brief Mark the members of the longest increasing run in sequence, which need not be contiguous
+ *
+ * Patience sorting: tails[l] is the position of the smallest value which ends an increasing run of length l + 1.
+ */
+static void markLongestIncreasingRun(const NSUInteger *sequence, NSUInteger count, BOOL *inLongestRun)
+{
+	NSUInteger	*tails = malloc(count * sizeof(NSUInteger));
+	NSUInteger	*previous = malloc(count * sizeof(NSUInteger));
+	NSUInteger	length = 0;
+
+	for (NSUInteger i = 0; i < count; i++) {
+		NSUInteger low = 0, high = length;
+
+		while (low < high) {
+			NSUInteger mid = (low + high) / 2;
+
+			if (sequence[tails[mid]] < sequence[i])
+				low = mid + 1;
+			else
+				high = mid;
+		}
+
+		previous[i] = (low > 0 ? tails[low - 1] : NSNotFound);
+		tails[low] = i;
+		if (low == length) length++;
+	}
+
+	memset(inLongestRun, 0, count * sizeof(BOOL));
+	for (NSUInteger i = (length ? tails[length - 1] : NSNotFound); i != NSNotFound; i = previous[i]) {
+		inLongestRun[i] = YES;
+	}
+
+	free(tails);
+	free(previous);
+}
+
+static NSUInteger positionOfValue(const NSUInteger *sequence, NSUInteger count, NSUInteger value)
+{
+	for (NSUInteger i = 0; i < count; i++) {
+		if (sequence[i] == value) return i;
+	}
+
+	return NSNotFound;
+}
+
+@implementation AIArrayEditScript
+
++ (AIArrayEditScript *)editScriptFromArray:(NSArray *)oldArray toArray:(NSArray *)newArray
+{
+	return [[[self alloc] initFromArray:oldArray toArray:newArray] autorelease];
+}
+
+- (id)initFromArray:(NSArray *)oldArray toArray:(NSArray *)newArray
+{
+	if ((self = [super init])) {
+		NSUInteger				oldCount = oldArray.count, newCount = newArray.count;
+		NSMutableIndexSet		*removed = [NSMutableIndexSet indexSet];
+		NSMutableIndexSet		*inserted = [NSMutableIndexSet indexSet];
+		CFMutableDictionaryRef	newPositions = CFDictionaryCreateMutable(kCFAllocatorDefault, newCount, NULL, NULL);
+		CFMutableSetRef			oldObjects = CFSetCreateMutable(kCFAllocatorDefault, oldCount, NULL);
+		NSUInteger				*sequence = malloc(MAX(oldCount, 1) * sizeof(NSUInteger));
+		NSUInteger				kept = 0, i;
+
+		i = 0;
+		for (id object in newArray) {
+			CFDictionarySetValue(newPositions, object, (const void *)i++);
+		}
+
+		//The new positions of the objects in both arrays, in their old order
+		i = 0;
+		for (id object in oldArray) {
+			const void *position;
+
+			CFSetAddValue(oldObjects, object);
+			if (CFDictionaryGetValueIfPresent(newPositions, object, &position))
+				sequence[kept++] = (NSUInteger)position;
+			else
+				[removed addIndex:i];
+			i++;
+		}
+
+		i = 0;
+		for (id object in newArray) {
+			if (!CFSetContainsValue(oldObjects, object)) [inserted addIndex:i];
+			i++;
+		}
+
+		[self calculateMovesForSequence:sequence count:kept];
+
+		removedIndexes = [removed copy];
+		insertedIndexes = [inserted copy];
+
+		free(sequence);
+		CFRelease(newPositions);
+		CFRelease(oldObjects);
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[removedIndexes release];
+	[insertedIndexes release];
+	free(moves);
+
+	[super dealloc];
+}
+
+/*!
+ * @brief Work out the moves which sort sequence
+ *
+ * The longest increasing run stays where it is. Everything else is moved, smallest first, to just after the value
+ * which precedes it once sorted; that value is either in the run or has already been moved, so it is in place.
+ *
+ * @param sequence The new positions of the kept objects, in their order after the removals. Sorted in place.
+ */
+- (void)calculateMovesForSequence:(NSUInteger *)sequence count:(NSUInteger)count
+{
+	if (count < 2) return;
+
+	BOOL		*inLongestRun = malloc(count * sizeof(BOOL));
+	NSUInteger	*sorted = malloc(count * sizeof(NSUInteger));
+	NSUInteger	*toMove = malloc(count * sizeof(NSUInteger));
+	NSUInteger	toMoveCount = 0;
+
+	markLongestIncreasingRun(sequence, count, inLongestRun);
+	for (NSUInteger i = 0; i < count; i++) {
+		if (!inLongestRun[i]) toMove[toMoveCount++] = sequence[i];
+	}
+
+	memcpy(sorted, sequence, count * sizeof(NSUInteger));
+	qsort(sorted, count, sizeof(NSUInteger), compareIndexes);
+	qsort(toMove, toMoveCount, sizeof(NSUInteger), compareIndexes);
+
+	moves = malloc(MAX(toMoveCount, 1) * 2 * sizeof(NSUInteger));
+
+	for (NSUInteger m = 0; m < toMoveCount; m++) {
+		NSUInteger value = toMove[m];
+		NSUInteger fromIndex = positionOfValue(sequence, count, value);
+		NSUInteger toIndex = 0;
+		NSUInteger *rank = bsearch(&value, sorted, count, sizeof(NSUInteger), compareIndexes);
+
+		if (rank != sorted) {
+			NSUInteger predecessorIndex = positionOfValue(sequence, count, *(rank - 1));
+			toIndex = (fromIndex < predecessorIndex ? predecessorIndex : predecessorIndex + 1);
+		}
+
+		if (fromIndex == toIndex) continue;
+
+		if (fromIndex < toIndex)
+			memmove(&sequence[fromIndex], &sequence[fromIndex + 1], (toIndex - fromIndex) * sizeof(NSUInteger));
+		else
+			memmove(&sequence[toIndex + 1], &sequence[toIndex], (fromIndex - toIndex) * sizeof(NSUInteger));
+		sequence[toIndex] = value;
+
+		moves[moveCount * 2] = fromIndex;
+		moves[moveCount * 2 + 1] = toIndex;
+		moveCount++;
+	}
+
+	free(inLongestRun);
+	free(sorted);
+	free(toMove);
+}
+
+@synthesize removedIndexes, insertedIndexes, moveCount;
+
+- (void)enumerateMovesUsingBlock:(void (^)(NSUInteger fromIndex, NSUInteger toIndex))block
+{
+	for (NSUInteger m = 0; m < moveCount; m++) {
+		block(moves[m * 2], moves[m * 2 + 1]);
+	}
+}
+
+- (BOOL)isEmpty
+{
+	return (!removedIndexes.count && !insertedIndexes.count && !moveCount);
+}
+
+- (void)applyToArray:(NSMutableArray *)array withObjectsFromArray:(NSArray *)newArray
+{
+	[array removeObjectsAtIndexes:removedIndexes];
+
+	[self enumerateMovesUsingBlock:^(NSUInteger fromIndex, NSUInteger toIndex) {
+		id object = [[array objectAtIndex:fromIndex] retain];
+
+		[array removeObjectAtIndex:fromIndex];
+		[array insertObject:object atIndex:toIndex];
+		[object release];
+	}];
+
+	[array insertObjects:[newArray objectsAtIndexes:insertedIndexes] atIndexes:insertedIndexes];
+}
+
+- (NSString *)description
+{
+	return [NSString stringWithFormat:@"<%@: %p; %lu removed, %lu moved, %lu inserted>", NSStringFromClass([self class]), self,
+			(unsigned long)removedIndexes.count, (unsigned long)moveCount, (unsigned long)insertedIndexes.count];
+}
+
+@end
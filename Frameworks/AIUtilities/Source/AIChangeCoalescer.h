@@ -0,0 +1,83 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*!
+ * @class AIChangeCoalescer
+ * @brief Collects change flags per key and hands each key's changes over once per run loop turn
+ *
+ * Meant for callbacks which report one small change at a time, several of which describe the same object within one
+ * turn of the run loop. Each call to -addChanges:forKey: ORs flags into the key's pending changes; at the end of the
+ * turn the handler is called once for each key, in the order the keys first had changes added, with everything that
+ * was added for it.
+ *
+ * Keys are opaque pointers and are neither retained nor dereferenced. A key which is about to be freed must be passed
+ * to -removeKey:, which drops its pending changes. Main thread only.
+ */
+@interface AIChangeCoalescer : NSObject {
+	void				(^handler)(void *key, NSUInteger changes);
+
+	CFMutableDictionaryRef	changesByKey;
+	void				**pendingKeys;
+	NSUInteger			pendingCount;
+	NSUInteger			pendingCapacity;
+
+	BOOL				schedulesFlushes;
+	BOOL				flushScheduled;
+	NSUInteger			flushCount;
+}
+
+- (id)initWithHandler:(void (^)(void *key, NSUInteger changes))inHandler;
+
+/*!
+ * @brief Add changes to those pending for key
+ *
+ * The first changes added in a run loop turn schedule a flush at its end, unless schedulesFlushes is NO.
+ */
+- (void)addChanges:(NSUInteger)changes forKey:(void *)key;
+
+/*!
+ * @brief Drop the changes pending for key
+ */
+- (void)removeKey:(void *)key;
+
+/*!
+ * @brief Hand over every key's pending changes now
+ *
+ * Changes added by the handler are handed over before this returns.
+ */
+- (void)flush;
+
+/*!
+ * @brief The changes pending for key, or 0
+ */
+- (NSUInteger)changesForKey:(void *)key;
+
+/*!
+ * @brief The number of keys with changes pending
+ */
+@property (readonly, nonatomic) NSUInteger pendingKeyCount;
+
+/*!
+ * @brief The number of flushes which handed over at least one key
+ */
+@property (readonly, nonatomic) NSUInteger flushCount;
+
+/*!
+ * @brief If NO, changes wait for an explicit -flush. Defaults to YES.
+ */
+@property (readwrite, nonatomic) BOOL schedulesFlushes;
+
+@end
@@ -0,0 +1,116 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIChangeCoalescer.h"
+
+@implementation AIChangeCoalescer
+
+- (id)initWithHandler:(void (^)(void *key, NSUInteger changes))inHandler
+{
+	if ((self = [super init])) {
+		handler = [inHandler copy];
+		//Pointer keys and integer values, neither retained
+		changesByKey = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+		schedulesFlushes = YES;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(flush) object:nil];
+
+	CFRelease(changesByKey);
+	free(pendingKeys);
+	[handler release];
+
+	[super dealloc];
+}
+
+@synthesize flushCount, schedulesFlushes;
+
+- (void)addChanges:(NSUInteger)changes forKey:(void *)key
+{
+	const void *existingChanges;
+
+	if (CFDictionaryGetValueIfPresent(changesByKey, key, &existingChanges)) {
+		CFDictionarySetValue(changesByKey, key, (const void *)((NSUInteger)existingChanges | changes));
+		return;
+	}
+
+	CFDictionarySetValue(changesByKey, key, (const void *)changes);
+
+	if (pendingCount == pendingCapacity) {
+		pendingCapacity = (pendingCapacity ? pendingCapacity * 2 : 16);
+		pendingKeys = reallocf(pendingKeys, pendingCapacity * sizeof(void *));
+	}
+	pendingKeys[pendingCount++] = key;
+
+	if (schedulesFlushes && !flushScheduled) {
+		flushScheduled = YES;
+		[self performSelector:@selector(flush)
+				   withObject:nil
+				   afterDelay:0];
+	}
+}
+
+- (void)removeKey:(void *)key
+{
+	//Its slot in pendingKeys is skipped when the flush finds no changes for it
+	CFDictionaryRemoveValue(changesByKey, key);
+}
+
+- (NSUInteger)changesForKey:(void *)key
+{
+	return (NSUInteger)CFDictionaryGetValue(changesByKey, key);
+}
+
+- (NSUInteger)pendingKeyCount
+{
+	return (NSUInteger)CFDictionaryGetCount(changesByKey);
+}
+
+- (void)flush
+{
+	NSUInteger i;
+
+	if (flushScheduled) {
+		[NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(flush) object:nil];
+		flushScheduled = NO;
+	}
+
+	if (!pendingCount) return;
+
+	[self retain];
+	flushCount++;
+
+	//The handler may add changes; those keys are appended, and so handed over in this same pass
+	for (i = 0; i < pendingCount; i++) {
+		void		*key = pendingKeys[i];
+		const void	*changes;
+
+		if (!CFDictionaryGetValueIfPresent(changesByKey, key, &changes)) continue;
+		CFDictionaryRemoveValue(changesByKey, key);
+
+		handler(key, (NSUInteger)changes);
+	}
+
+	pendingCount = 0;
+	[self release];
+}
+
+@end
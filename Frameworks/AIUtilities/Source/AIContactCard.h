@@ -0,0 +1,108 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+//Keys of -[AIContactCard nameComponents]
+#define AIContactCardFirstNameKey			@"First"
+#define AIContactCardLastNameKey			@"Last"
+#define AIContactCardMiddleNameKey			@"Middle"
+#define AIContactCardNicknameKey			@"Nickname"
+#define AIContactCardPhoneticFirstNameKey	@"PhoneticFirst"
+#define AIContactCardPhoneticMiddleNameKey	@"PhoneticMiddle"
+#define AIContactCardPhoneticLastNameKey	@"PhoneticLast"
+#define AIContactCardOrganizationKey		@"Organization"
+#define AIContactCardFlagsKey				@"Flags"
+
+/*!
+ * @class AIContactCardMatch
+ * @brief One screen name found on a contact card
+ *
+ * indexServiceID is the service whose lookup table the name belongs in, and serviceID the service of the contacts it
+ * names; they differ for names like .Mac addresses, which are kept with AIM names but are contacts on the Mac service.
+ */
+@interface AIContactCardMatch : NSObject {
+	NSString	*UID;
+	NSString	*compactedUID;
+	NSString	*indexServiceID;
+	NSString	*serviceID;
+}
+
+- (id)initWithUID:(NSString *)inUID indexServiceID:(NSString *)inIndexServiceID serviceID:(NSString *)inServiceID;
+
+/*!
+ * @brief A match from its -propertyListRepresentation
+ */
+- (id)initWithPropertyListRepresentation:(NSArray *)propertyList;
+- (NSArray *)propertyListRepresentation;
+
+@property (readonly, nonatomic) NSString *UID;
+@property (readonly, nonatomic) NSString *compactedUID;
+@property (readonly, nonatomic) NSString *indexServiceID;
+@property (readonly, nonatomic) NSString *serviceID;
+
+@end
+
+/*!
+ * @class AIContactCard
+ * @brief What Adium uses of one card in a contact source, such as the Address Book or a folder of vCards
+ *
+ * Instant messaging names are keyed by the service ID of their field: AIM, ICQ, Jabber, MSN or Yahoo!.
+ */
+@interface AIContactCard : NSObject {
+	NSString		*uniqueID;
+	NSDictionary	*nameComponents;
+	NSArray			*emails;
+	NSArray			*homepages;
+	NSDictionary	*instantMessageNames;
+}
+
+- (id)initWithUniqueID:(NSString *)inUniqueID
+		nameComponents:(NSDictionary *)inNameComponents
+				emails:(NSArray *)inEmails
+			 homepages:(NSArray *)inHomepages
+   instantMessageNames:(NSDictionary *)inInstantMessageNames;
+
+@property (readonly, nonatomic) NSString *uniqueID;
+@property (readonly, nonatomic) NSDictionary *nameComponents;
+@property (readonly, nonatomic) NSArray *emails;
+@property (readonly, nonatomic) NSArray *homepages;
+@property (readonly, nonatomic) NSDictionary *instantMessageNames;
+
+/*!
+ * @brief The screen names on the card, as AIContactCardMatch objects
+ *
+ * Email addresses at .Mac, MobileMe, Google and Hotmail, fb:// homepages and every instant messaging name count. OSCAR
+ * names are told apart into AIM, ICQ, .Mac and MobileMe, and Jabber names into Google Talk, LiveJournal and Jabber.
+ */
+- (NSArray *)matches;
+
+/*!
+ * @brief A digest of everything on the card Adium uses
+ *
+ * Two cards with the same digest name the same people the same way.
+ */
+- (NSString *)contentHash;
+
+@end
+
+/*!
+ * @brief The service of an OSCAR screen name: Mac, MobileMe, ICQ or AIM
+ */
+NSString *AIServiceIDForOscarUID(NSString *UID);
+
+/*!
+ * @brief The service of a Jabber ID: GTalk, LiveJournal or Jabber
+ */
+NSString *AIServiceIDForJabberUID(NSString *UID);
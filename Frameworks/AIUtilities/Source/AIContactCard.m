@@ -0,0 +1,261 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <AIUtilities/AIContactCard.h>
+#import <AIUtilities/AIStringAdditions.h>
+#import <CommonCrypto/CommonDigest.h>
+
+#define FACEBOOK_SCHEME		@"fb"
+
+@implementation AIContactCardMatch
+
+- (id)initWithUID:(NSString *)inUID indexServiceID:(NSString *)inIndexServiceID serviceID:(NSString *)inServiceID
+{
+	if ((self = [super init])) {
+		UID = [inUID copy];
+		compactedUID = [[inUID compactedString] retain];
+		indexServiceID = [inIndexServiceID copy];
+		serviceID = [inServiceID copy];
+	}
+
+	return self;
+}
+
+- (id)initWithPropertyListRepresentation:(NSArray *)propertyList
+{
+	if (![propertyList isKindOfClass:[NSArray class]] || propertyList.count != 3) {
+		[self release];
+		return nil;
+	}
+
+	return [self initWithUID:[propertyList objectAtIndex:0]
+			  indexServiceID:[propertyList objectAtIndex:1]
+				   serviceID:[propertyList objectAtIndex:2]];
+}
+
+- (void)dealloc
+{
+	[UID release];
+	[compactedUID release];
+	[indexServiceID release];
+	[serviceID release];
+
+	[super dealloc];
+}
+
+@synthesize UID, compactedUID, indexServiceID, serviceID;
+
+- (NSArray *)propertyListRepresentation
+{
+	return [NSArray arrayWithObjects:UID, indexServiceID, serviceID, nil];
+}
+
+- (BOOL)isEqual:(id)object
+{
+	if (![object isKindOfClass:[AIContactCardMatch class]]) return NO;
+
+	AIContactCardMatch *match = (AIContactCardMatch *)object;
+	return ([UID isEqualToString:match.UID] &&
+			[indexServiceID isEqualToString:match.indexServiceID] &&
+			[serviceID isEqualToString:match.serviceID]);
+}
+
+- (NSUInteger)hash
+{
+	return [UID hash] ^ [serviceID hash];
+}
+
+- (NSString *)description
+{
+	return [NSString stringWithFormat:@"<%@: %@ (%@ in %@)>", NSStringFromClass([self class]), UID, serviceID, indexServiceID];
+}
+
+@end
+
+@implementation AIContactCard
+
+- (id)initWithUniqueID:(NSString *)inUniqueID
+		nameComponents:(NSDictionary *)inNameComponents
+				emails:(NSArray *)inEmails
+			 homepages:(NSArray *)inHomepages
+   instantMessageNames:(NSDictionary *)inInstantMessageNames
+{
+	if ((self = [super init])) {
+		uniqueID = [inUniqueID copy];
+		nameComponents = [(inNameComponents ?: [NSDictionary dictionary]) copy];
+		emails = [(inEmails ?: [NSArray array]) copy];
+		homepages = [(inHomepages ?: [NSArray array]) copy];
+		instantMessageNames = [(inInstantMessageNames ?: [NSDictionary dictionary]) copy];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[uniqueID release];
+	[nameComponents release];
+	[emails release];
+	[homepages release];
+	[instantMessageNames release];
+
+	[super dealloc];
+}
+
+@synthesize uniqueID, nameComponents, emails, homepages, instantMessageNames;
+
+static void addMatch(NSMutableArray *matches, NSString *UID, NSString *indexServiceID, NSString *serviceID)
+{
+	AIContactCardMatch *match = [[AIContactCardMatch alloc] initWithUID:UID indexServiceID:indexServiceID serviceID:serviceID];
+	[matches addObject:match];
+	[match release];
+}
+
+- (NSArray *)matches
+{
+	NSMutableArray *matches = [NSMutableArray array];
+
+	//Email addresses which are also screen names
+	for (NSString *email in emails) {
+		if ([email hasSuffix:@"@mac.com"]) {
+			//.Mac and MobileMe names are looked up with AIM names
+			addMatch(matches, email, @"AIM", @"Mac");
+		} else if ([email hasSuffix:@"me.com"]) {
+			addMatch(matches, email, @"AIM", @"MobileMe");
+		} else if ([email hasSuffix:@"gmail.com"] || [email hasSuffix:@"googlemail.com"]) {
+			//Google Talk names are looked up with Jabber names
+			addMatch(matches, email, @"Jabber", @"GTalk");
+		} else if ([email hasSuffix:@"hotmail.com"]) {
+			addMatch(matches, email, @"MSN", @"MSN");
+		}
+	}
+
+	//fb://profile/XXX homepages, where XXX is the Facebook UID
+	for (NSString *homepage in homepages) {
+		NSURL *URL = [NSURL URLWithString:homepage];
+
+		if ([[URL scheme] isEqualToString:FACEBOOK_SCHEME]) {
+			addMatch(matches, [NSString stringWithFormat:@"-%@@chat.facebook.com", [homepage lastPathComponent]], @"Facebook", @"Facebook");
+		}
+	}
+
+	//Instant messaging names, in a fixed order so the matches are the same every time
+	for (NSString *fieldServiceID in [[instantMessageNames allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		BOOL	isOSCAR = ([fieldServiceID isEqualToString:@"AIM"] || [fieldServiceID isEqualToString:@"ICQ"]);
+		BOOL	isJabber = ([fieldServiceID isEqualToString:@"Jabber"] || [fieldServiceID isEqualToString:@"XMPP"]);
+
+		for (NSString *name in [instantMessageNames objectForKey:fieldServiceID]) {
+			NSString *UID = [name compactedString];
+			if (!UID.length) continue;
+
+			addMatch(matches, UID, fieldServiceID,
+					 (isOSCAR ? AIServiceIDForOscarUID(UID) : (isJabber ? AIServiceIDForJabberUID(UID) : fieldServiceID)));
+		}
+	}
+
+	return matches;
+}
+
+static void appendField(NSMutableData *data, NSString *string)
+{
+	const char *UTF8String = [string UTF8String];
+
+	//Including the terminating NUL keeps "ab","c" apart from "a","bc"
+	if (UTF8String) [data appendBytes:UTF8String length:strlen(UTF8String) + 1];
+}
+
+- (NSString *)contentHash
+{
+	NSMutableData	*data = [NSMutableData data];
+	unsigned char	digest[CC_SHA1_DIGEST_LENGTH];
+
+	for (NSString *key in [[nameComponents allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		appendField(data, key);
+		appendField(data, [[nameComponents objectForKey:key] description]);
+	}
+
+	appendField(data, @"Emails");
+	for (NSString *email in emails) appendField(data, email);
+
+	appendField(data, @"Homepages");
+	for (NSString *homepage in homepages) appendField(data, homepage);
+
+	for (NSString *fieldServiceID in [[instantMessageNames allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+		appendField(data, fieldServiceID);
+		for (NSString *name in [instantMessageNames objectForKey:fieldServiceID]) appendField(data, name);
+	}
+
+	CC_SHA1([data bytes], (CC_LONG)[data length], digest);
+
+	NSMutableString *hash = [NSMutableString stringWithCapacity:CC_SHA1_DIGEST_LENGTH * 2];
+	for (NSUInteger i = 0; i < CC_SHA1_DIGEST_LENGTH; i++) {
+		[hash appendFormat:@"%02x", digest[i]];
+	}
+
+	return hash;
+}
+
+- (NSString *)description
+{
+	return [NSString stringWithFormat:@"<%@: %@ %@>", NSStringFromClass([self class]), uniqueID, nameComponents];
+}
+
+@end
+
+/*!
+ * @brief Service ID for an OSCAR UID
+ *
+ * An AIM field may hold a .Mac, a MobileMe, an ICQ or an AIM name.
+ */
+NSString *AIServiceIDForOscarUID(NSString *UID)
+{
+	NSString	*serviceID;
+	unichar		firstCharacter = (UID.length ? [UID characterAtIndex:0] : 0);
+
+	if ([UID hasSuffix:@"@mac.com"]) {
+		serviceID = @"Mac";
+	} else if ([UID hasSuffix:@"@me.com"]) {
+		serviceID = @"MobileMe";
+	} else if (firstCharacter >= '0' && firstCharacter <= '9') {
+		serviceID = @"ICQ";
+	} else {
+		serviceID = @"AIM";
+	}
+
+	return serviceID;
+}
+
+/*!
+ * @brief Service ID for a Jabber UID
+ *
+ * Google Talk and LiveJournal are told apart from the rest of the Jabber world by their domains.
+ */
+NSString *AIServiceIDForJabberUID(NSString *UID)
+{
+	NSString	*serviceID;
+
+	if ([UID hasSuffix:@"@gmail.com"] ||
+		[UID hasSuffix:@"@googlemail.com"] ||
+		[UID hasSuffix:@"@public.talk.google.com"]) {
+		serviceID = @"GTalk";
+	} else if ([UID hasSuffix:@"@livejournal.com"]) {
+		serviceID = @"LiveJournal";
+	} else {
+		serviceID = @"Jabber";
+	}
+
+	return serviceID;
+}
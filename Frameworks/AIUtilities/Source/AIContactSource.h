@@ -0,0 +1,45 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+@class AIContactCard;
+
+/*!
+ * @protocol AIContactSource
+ * @brief A collection of contact cards which AIContactSourceSync can keep an index of
+ *
+ * Cards are identified by unique IDs which stay the same as a card is edited. A source need not be thread safe; it is
+ * only used on the thread its AIContactSourceSync is.
+ */
+@protocol AIContactSource <NSObject>
+
+/*!
+ * @brief The unique IDs of every card, without reading the cards themselves if possible
+ */
+- (NSSet *)allCardUniqueIDs;
+
+/*!
+ * @brief The unique IDs of the cards modified at or after a date
+ *
+ * Cards which weren't modified may be included; cards which were must be.
+ */
+- (NSSet *)cardUniqueIDsModifiedSinceDate:(NSDate *)date;
+
+/*!
+ * @brief Read a card, or nil if there is no longer one with that unique ID
+ */
+- (AIContactCard *)cardWithUniqueID:(NSString *)uniqueID;
+
+@end
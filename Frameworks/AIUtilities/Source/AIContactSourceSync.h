@@ -0,0 +1,106 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <AIUtilities/AIContactSource.h>
+
+/*!
+ * @class AIContactSourceSync
+ * @brief Keeps an index of the screen names on the cards of a contact source, reading only cards which changed
+ *
+ * For every card, the digest of its contents and the screen names found on it are stored in a file, along with when
+ * the source was last synchronized. On the next launch, only cards the source reports as modified since then, and
+ * cards we have no record of, are read; a card whose digest is unchanged is left alone. Removed cards are noticed by
+ * their unique IDs alone.
+ *
+ * From the stored screen names, a reverse index from compacted UID to card is kept for each service, and the screen
+ * names a card had are still known after it is modified or removed, so the contacts it used to name can be updated.
+ *
+ * Not thread safe.
+ */
+@interface AIContactSourceSync : NSObject {
+	id <AIContactSource>	contactSource;
+	NSString				*statePath;
+
+	NSDate					*lastSyncDate;
+	NSMutableDictionary		*contentHashes;		//Unique ID -> digest of the card's contents
+	NSMutableDictionary		*cardMatches;		//Unique ID -> NSArray of AIContactCardMatch
+	NSMutableDictionary		*indexes;			//Index service ID -> (compacted UID -> unique ID)
+
+	BOOL					loadedState;
+	BOOL					stateChanged;
+	NSUInteger				cardsRead;
+}
+
+/*!
+ * @brief Index a contact source
+ *
+ * @param inStatePath Where what we know of the cards is kept between launches, or nil to start from scratch each time
+ */
+- (id)initWithContactSource:(id <AIContactSource>)inContactSource statePath:(NSString *)inStatePath;
+
+/*!
+ * @brief Bring the index up to date with the source and save it
+ *
+ * @result The unique IDs of the cards added, changed or removed since the last synchronization
+ */
+- (NSSet *)synchronize;
+
+/*!
+ * @brief Read the given cards again, as when the source says they were added or modified
+ *
+ * Cards which no longer exist are removed.
+ *
+ * @result The unique IDs of those cards whose contents actually changed
+ */
+- (NSSet *)updateCardsWithUniqueIDs:(id <NSFastEnumeration>)uniqueIDs;
+
+/*!
+ * @brief Forget the given cards, as when the source says they were deleted
+ */
+- (void)removeCardsWithUniqueIDs:(id <NSFastEnumeration>)uniqueIDs;
+
+/*!
+ * @brief Write what we know of the cards to the state path, if it changed
+ */
+- (BOOL)save;
+
+/*!
+ * @brief The card naming a UID, which is compacted first
+ *
+ * @param indexServiceID The service of the field the name is in: AIM for .Mac and MobileMe names, Jabber for Google
+ * Talk and LiveJournal names
+ */
+- (NSString *)cardUniqueIDForUID:(NSString *)UID indexServiceID:(NSString *)indexServiceID;
+
+/*!
+ * @brief The screen names on a card, as AIContactCardMatch objects, or nil if we have no record of the card
+ */
+- (NSArray *)matchesForCardWithUniqueID:(NSString *)uniqueID;
+
+/*!
+ * @brief The unique IDs of every card with more than one screen name
+ */
+- (NSArray *)uniqueIDsOfCardsWithMultipleMatches;
+
+@property (readonly, nonatomic) NSSet *allCardUniqueIDs;
+@property (readonly, nonatomic) NSDate *lastSyncDate;
+
+/*!
+ * @brief How many cards have been read from the source
+ */
+@property (readonly, nonatomic) NSUInteger cardsRead;
+
+@end
@@ -0,0 +1,299 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <AIUtilities/AIContactSourceSync.h>
+#import <AIUtilities/AIContactCard.h>
+#import <AIUtilities/AIStringAdditions.h>
+
+#define STATE_VERSION			1
+#define KEY_STATE_VERSION		@"Version"
+#define KEY_STATE_LAST_SYNC		@"LastSync"
+#define KEY_STATE_CARDS			@"Cards"
+#define KEY_CARD_HASH			@"Hash"
+#define KEY_CARD_MATCHES		@"Matches"
+
+/* Modification dates may only be kept to the second, so a card modified just after we asked for the modified cards
+ * could otherwise carry a date before the one we remember. Cards modified this long before a synchronization are
+ * read again the next time; their digests say they are unchanged.
+ */
+#define SYNC_DATE_ALLOWANCE		2.0
+
+@interface AIContactSourceSync ()
+- (void)loadState;
+- (void)setMatches:(NSArray *)matches contentHash:(NSString *)contentHash forCardWithUniqueID:(NSString *)uniqueID;
+- (void)indexMatches:(NSArray *)matches ofCardWithUniqueID:(NSString *)uniqueID;
+- (void)unindexCardWithUniqueID:(NSString *)uniqueID;
+@end
+
+@implementation AIContactSourceSync
+
+- (id)initWithContactSource:(id <AIContactSource>)inContactSource statePath:(NSString *)inStatePath
+{
+	if ((self = [super init])) {
+		contactSource = [inContactSource retain];
+		statePath = [inStatePath copy];
+
+		contentHashes = [[NSMutableDictionary alloc] init];
+		cardMatches = [[NSMutableDictionary alloc] init];
+		indexes = [[NSMutableDictionary alloc] init];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[contactSource release];
+	[statePath release];
+	[lastSyncDate release];
+	[contentHashes release];
+	[cardMatches release];
+	[indexes release];
+
+	[super dealloc];
+}
+
+@synthesize lastSyncDate, cardsRead;
+
+#pragma mark Synchronizing
+
+- (NSSet *)synchronize
+{
+	NSDate			*syncDate = [NSDate date];
+	NSMutableSet	*changedUniqueIDs = [NSMutableSet set];
+
+	if (!loadedState) [self loadState];
+
+	NSSet			*allUniqueIDs = [contactSource allCardUniqueIDs];
+	NSMutableSet	*uniqueIDsToRead;
+
+	if (lastSyncDate) {
+		uniqueIDsToRead = [[[contactSource cardUniqueIDsModifiedSinceDate:lastSyncDate] mutableCopy] autorelease];
+
+		//Cards we have no record of, whatever their dates
+		for (NSString *uniqueID in allUniqueIDs) {
+			if (![contentHashes objectForKey:uniqueID]) [uniqueIDsToRead addObject:uniqueID];
+		}
+	} else {
+		uniqueIDsToRead = [[allUniqueIDs mutableCopy] autorelease];
+	}
+
+	[changedUniqueIDs unionSet:[self updateCardsWithUniqueIDs:uniqueIDsToRead]];
+
+	//Cards which are gone
+	NSMutableArray *removedUniqueIDs = [NSMutableArray array];
+	for (NSString *uniqueID in contentHashes) {
+		if (![allUniqueIDs containsObject:uniqueID]) [removedUniqueIDs addObject:uniqueID];
+	}
+	[self removeCardsWithUniqueIDs:removedUniqueIDs];
+	[changedUniqueIDs addObjectsFromArray:removedUniqueIDs];
+
+	[lastSyncDate release]; lastSyncDate = [[syncDate dateByAddingTimeInterval:-SYNC_DATE_ALLOWANCE] retain];
+	stateChanged = YES;
+	[self save];
+
+	return changedUniqueIDs;
+}
+
+- (NSSet *)updateCardsWithUniqueIDs:(id <NSFastEnumeration>)uniqueIDs
+{
+	NSMutableSet	*changedUniqueIDs = [NSMutableSet set];
+	NSMutableArray	*removedUniqueIDs = [NSMutableArray array];
+
+	if (!loadedState) [self loadState];
+
+	for (NSString *uniqueID in uniqueIDs) {
+		NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+		AIContactCard		*card = [contactSource cardWithUniqueID:uniqueID];
+
+		cardsRead++;
+
+		if (!card) {
+			if ([contentHashes objectForKey:uniqueID]) [removedUniqueIDs addObject:uniqueID];
+
+		} else {
+			NSString *contentHash = [card contentHash];
+
+			if (![contentHash isEqualToString:[contentHashes objectForKey:uniqueID]]) {
+				[self setMatches:[card matches] contentHash:contentHash forCardWithUniqueID:uniqueID];
+				[changedUniqueIDs addObject:uniqueID];
+			}
+		}
+
+		[pool release];
+	}
+
+	[self removeCardsWithUniqueIDs:removedUniqueIDs];
+	[changedUniqueIDs addObjectsFromArray:removedUniqueIDs];
+
+	return changedUniqueIDs;
+}
+
+- (void)removeCardsWithUniqueIDs:(id <NSFastEnumeration>)uniqueIDs
+{
+	for (NSString *uniqueID in uniqueIDs) {
+		if (![contentHashes objectForKey:uniqueID]) continue;
+
+		[self unindexCardWithUniqueID:uniqueID];
+		[contentHashes removeObjectForKey:uniqueID];
+		[cardMatches removeObjectForKey:uniqueID];
+		stateChanged = YES;
+	}
+}
+
+- (void)setMatches:(NSArray *)matches contentHash:(NSString *)contentHash forCardWithUniqueID:(NSString *)uniqueID
+{
+	[self unindexCardWithUniqueID:uniqueID];
+
+	[contentHashes setObject:contentHash forKey:uniqueID];
+	[cardMatches setObject:matches forKey:uniqueID];
+	[self indexMatches:matches ofCardWithUniqueID:uniqueID];
+
+	stateChanged = YES;
+}
+
+#pragma mark Index
+
+- (void)indexMatches:(NSArray *)matches ofCardWithUniqueID:(NSString *)uniqueID
+{
+	for (AIContactCardMatch *match in matches) {
+		NSMutableDictionary *index = [indexes objectForKey:match.indexServiceID];
+
+		if (!index) {
+			index = [[NSMutableDictionary alloc] init];
+			[indexes setObject:index forKey:match.indexServiceID];
+			[index release];
+		}
+
+		//If several cards have the same name, the last one read has it
+		[index setObject:uniqueID forKey:match.compactedUID];
+	}
+}
+
+- (void)unindexCardWithUniqueID:(NSString *)uniqueID
+{
+	for (AIContactCardMatch *match in [cardMatches objectForKey:uniqueID]) {
+		NSMutableDictionary *index = [indexes objectForKey:match.indexServiceID];
+
+		//Leave the name to another card which has it
+		if ([[index objectForKey:match.compactedUID] isEqualToString:uniqueID])
+			[index removeObjectForKey:match.compactedUID];
+	}
+}
+
+- (NSString *)cardUniqueIDForUID:(NSString *)UID indexServiceID:(NSString *)indexServiceID
+{
+	return [[indexes objectForKey:indexServiceID] objectForKey:[UID compactedString]];
+}
+
+- (NSArray *)matchesForCardWithUniqueID:(NSString *)uniqueID
+{
+	return [cardMatches objectForKey:uniqueID];
+}
+
+- (NSArray *)uniqueIDsOfCardsWithMultipleMatches
+{
+	NSMutableArray *uniqueIDs = [NSMutableArray array];
+
+	for (NSString *uniqueID in cardMatches) {
+		if ([[cardMatches objectForKey:uniqueID] count] > 1) [uniqueIDs addObject:uniqueID];
+	}
+
+	return uniqueIDs;
+}
+
+- (NSSet *)allCardUniqueIDs
+{
+	return [NSSet setWithArray:[contentHashes allKeys]];
+}
+
+#pragma mark State
+
+- (void)loadState
+{
+	NSData			*data = (statePath ? [NSData dataWithContentsOfFile:statePath] : nil);
+	NSDictionary	*state = (data ?
+							  [NSPropertyListSerialization propertyListFromData:data
+															   mutabilityOption:NSPropertyListImmutable
+																		 format:NULL
+															   errorDescription:NULL] :
+							  nil);
+
+	loadedState = YES;
+
+	if (![state isKindOfClass:[NSDictionary class]] ||
+		[[state objectForKey:KEY_STATE_VERSION] integerValue] != STATE_VERSION)
+		return;
+
+	NSDictionary *cards = [state objectForKey:KEY_STATE_CARDS];
+	for (NSString *uniqueID in cards) {
+		NSDictionary	*card = [cards objectForKey:uniqueID];
+		NSMutableArray	*matches = [NSMutableArray array];
+
+		for (NSArray *propertyList in [card objectForKey:KEY_CARD_MATCHES]) {
+			AIContactCardMatch *match = [[AIContactCardMatch alloc] initWithPropertyListRepresentation:propertyList];
+			if (match) [matches addObject:match];
+			[match release];
+		}
+
+		[contentHashes setObject:[card objectForKey:KEY_CARD_HASH] forKey:uniqueID];
+		[cardMatches setObject:matches forKey:uniqueID];
+		[self indexMatches:matches ofCardWithUniqueID:uniqueID];
+	}
+
+	[lastSyncDate release]; lastSyncDate = [[state objectForKey:KEY_STATE_LAST_SYNC] retain];
+}
+
+- (BOOL)save
+{
+	if (!statePath || !stateChanged) return YES;
+
+	NSMutableDictionary *cards = [NSMutableDictionary dictionaryWithCapacity:contentHashes.count];
+	for (NSString *uniqueID in contentHashes) {
+		NSArray			*matches = [cardMatches objectForKey:uniqueID];
+		NSMutableArray	*matchPropertyLists = [NSMutableArray arrayWithCapacity:matches.count];
+
+		for (AIContactCardMatch *match in matches) {
+			[matchPropertyLists addObject:[match propertyListRepresentation]];
+		}
+
+		[cards setObject:[NSDictionary dictionaryWithObjectsAndKeys:
+						  [contentHashes objectForKey:uniqueID], KEY_CARD_HASH,
+						  matchPropertyLists, KEY_CARD_MATCHES,
+						  nil]
+				  forKey:uniqueID];
+	}
+
+	NSMutableDictionary *state = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+								  [NSNumber numberWithInteger:STATE_VERSION], KEY_STATE_VERSION,
+								  cards, KEY_STATE_CARDS,
+								  nil];
+	if (lastSyncDate) [state setObject:lastSyncDate forKey:KEY_STATE_LAST_SYNC];
+
+	NSData *data = [NSPropertyListSerialization dataFromPropertyList:state
+															  format:NSPropertyListBinaryFormat_v1_0
+													errorDescription:NULL];
+
+	[[NSFileManager defaultManager] createDirectoryAtPath:[statePath stringByDeletingLastPathComponent]
+							  withIntermediateDirectories:YES
+											   attributes:nil
+													error:NULL];
+	stateChanged = ![data writeToFile:statePath atomically:YES];
+
+	return !stateChanged;
+}
+
+@end
@@ -0,0 +1,140 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <AIUtilities/AIHostResolverBackend.h>
+
+@class AIHostResolver;
+
+/*!
+ * @brief Called with a host's addresses, in the order to try them, or with an error in AIHostResolverErrorDomain
+ */
+typedef void (^AIHostResolverHandler)(NSArray *addresses, NSError *error);
+
+/*!
+ * @class AIHostResolution
+ * @brief One request to resolve a host name, which may be cancelled before it is answered
+ */
+@interface AIHostResolution : NSObject {
+	NSString				*hostName;
+	AIHostResolverHandler	handler;
+}
+
+/*!
+ * @brief Don't call the handler. The lookup itself carries on if others are waiting for it, and is cached either way.
+ */
+- (void)cancel;
+
+@property (readonly, nonatomic) NSString *hostName;
+@property (readonly, nonatomic) BOOL isCancelled;
+
+@end
+
+/*!
+ * @class AIHostResolver
+ * @brief Resolves host names through a backend, caching the answers and sharing lookups in progress
+ *
+ * Addresses are kept for the time to live the backend gives, within minimumTimeToLive and maximumTimeToLive;
+ * failures are kept for negativeTimeToLive, so a host which doesn't exist isn't asked about again by every account
+ * reconnecting to it. A request for a host already being looked up waits for that lookup rather than starting another.
+ *
+ * Addresses are given with the address families alternating, starting with the family the backend listed first, so
+ * a client trying them in order reaches an IPv4 address quickly when IPv6 is broken, as Happy Eyeballs (RFC 8305)
+ * orders them.
+ *
+ * Main thread only. Handlers are always called asynchronously, even for cached answers.
+ */
+@interface AIHostResolver : NSObject {
+	id <AIHostResolverBackend>	backend;
+
+	NSMutableDictionary			*cache;
+	NSMutableDictionary			*pendingResolutions;
+	NSUInteger					generation;
+
+	NSUInteger					maximumCachedHosts;
+	NSTimeInterval				minimumTimeToLive;
+	NSTimeInterval				maximumTimeToLive;
+	NSTimeInterval				negativeTimeToLive;
+
+	NSUInteger					lookupCount;
+	NSUInteger					cacheHitCount;
+	NSUInteger					negativeCacheHitCount;
+	NSUInteger					coalescedLookupCount;
+	NSUInteger					backendQueryCount;
+	NSUInteger					backendFailureCount;
+	NSUInteger					backendAnswerCount;
+	NSTimeInterval				totalBackendLatency;
+	NSTimeInterval				maximumBackendLatency;
+}
+
+/*!
+ * @brief The resolver for the application, which asks getaddrinfo()
+ */
++ (AIHostResolver *)sharedResolver;
+
+- (id)initWithBackend:(id <AIHostResolverBackend>)inBackend;
+
+/*!
+ * @brief Resolve a host name
+ *
+ * @result The request, which may be cancelled until the handler is called
+ */
+- (AIHostResolution *)resolveHostName:(NSString *)hostName handler:(AIHostResolverHandler)handler;
+
+/*!
+ * @brief Forget every cached answer, such as when the network changes
+ *
+ * Lookups in progress are still answered, but not cached, and later requests for their hosts start new lookups.
+ */
+- (void)flushCache;
+
+/*!
+ * @brief Reset the counters
+ */
+- (void)resetStatistics;
+
+@property (readonly, nonatomic) id <AIHostResolverBackend> backend;
+@property (readwrite, nonatomic) NSUInteger maximumCachedHosts;
+@property (readwrite, nonatomic) NSTimeInterval minimumTimeToLive;
+@property (readwrite, nonatomic) NSTimeInterval maximumTimeToLive;
+@property (readwrite, nonatomic) NSTimeInterval negativeTimeToLive;
+
+@property (readonly, nonatomic) NSUInteger lookupCount;
+@property (readonly, nonatomic) NSUInteger cacheHitCount;
+@property (readonly, nonatomic) NSUInteger negativeCacheHitCount;
+@property (readonly, nonatomic) NSUInteger coalescedLookupCount;
+@property (readonly, nonatomic) NSUInteger backendQueryCount;
+@property (readonly, nonatomic) NSUInteger backendFailureCount;
+
+/*!
+ * @brief The fraction of lookups answered without asking the backend
+ */
+@property (readonly, nonatomic) double hitRate;
+
+/*!
+ * @brief Seconds the backend took to answer, in total, on average and at most
+ */
+@property (readonly, nonatomic) NSTimeInterval totalBackendLatency;
+@property (readonly, nonatomic) NSTimeInterval averageBackendLatency;
+@property (readonly, nonatomic) NSTimeInterval maximumBackendLatency;
+
+@end
+
+/*!
+ * @brief Socket addresses reordered so that address families alternate, starting with the family of the first
+ *
+ * Within each family the order is kept.
+ */
+NSArray *AIHostResolverInterleavedAddresses(NSArray *addresses);
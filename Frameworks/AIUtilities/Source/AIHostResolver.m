@@ -0,0 +1,334 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <AIUtilities/AIHostResolver.h>
+#import <AIUtilities/AIAddrInfoHostResolverBackend.h>
+
+#import <sys/socket.h>
+#import <netdb.h>
+
+#define DEFAULT_MAXIMUM_CACHED_HOSTS	256
+#define DEFAULT_MINIMUM_TIME_TO_LIVE	5.0
+#define DEFAULT_MAXIMUM_TIME_TO_LIVE	300.0
+#define DEFAULT_NEGATIVE_TIME_TO_LIVE	5.0
+
+/*!
+ * @class AIHostResolverCacheEntry
+ * @brief The answer for one host name, until it expires
+ */
+@interface AIHostResolverCacheEntry : NSObject {
+@public
+	NSArray			*addresses;
+	NSError			*error;
+	NSTimeInterval	expiry;
+}
+@end
+
+@implementation AIHostResolverCacheEntry
+
+- (void)dealloc
+{
+	[addresses release];
+	[error release];
+
+	[super dealloc];
+}
+
+@end
+
+@interface AIHostResolution ()
+- (id)initWithHostName:(NSString *)inHostName handler:(AIHostResolverHandler)inHandler;
+- (void)deliverAddresses:(NSArray *)addresses error:(NSError *)error;
+@end
+
+@implementation AIHostResolution
+
+- (id)initWithHostName:(NSString *)inHostName handler:(AIHostResolverHandler)inHandler
+{
+	if ((self = [super init])) {
+		hostName = [inHostName copy];
+		handler = [inHandler copy];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[hostName release];
+	[handler release];
+
+	[super dealloc];
+}
+
+@synthesize hostName;
+
+- (BOOL)isCancelled
+{
+	return (handler == nil);
+}
+
+- (void)cancel
+{
+	[handler release]; handler = nil;
+}
+
+- (void)deliverAddresses:(NSArray *)addresses error:(NSError *)error
+{
+	AIHostResolverHandler deliveredHandler = handler;
+
+	if (!deliveredHandler) return;
+
+	//Only once
+	handler = nil;
+	deliveredHandler(addresses, error);
+	[deliveredHandler release];
+}
+
+@end
+
+#pragma mark -
+
+@interface AIHostResolver ()
+- (void)backendDidResolveHostKey:(NSString *)key
+					   addresses:(NSArray *)addresses
+					  timeToLive:(NSTimeInterval)timeToLive
+						   error:(NSError *)error
+					   startTime:(NSTimeInterval)startTime
+						 waiting:(NSMutableArray *)waiting
+					  generation:(NSUInteger)queryGeneration;
+- (void)cacheEntry:(AIHostResolverCacheEntry *)entry forKey:(NSString *)key now:(NSTimeInterval)now;
+@end
+
+@implementation AIHostResolver
+
++ (AIHostResolver *)sharedResolver
+{
+	static AIHostResolver *sharedResolver = nil;
+
+	if (!sharedResolver) {
+		AIAddrInfoHostResolverBackend *addrInfoBackend = [[AIAddrInfoHostResolverBackend alloc] init];
+		sharedResolver = [[AIHostResolver alloc] initWithBackend:addrInfoBackend];
+		[addrInfoBackend release];
+	}
+
+	return sharedResolver;
+}
+
+- (id)initWithBackend:(id <AIHostResolverBackend>)inBackend
+{
+	if ((self = [super init])) {
+		backend = [inBackend retain];
+		cache = [[NSMutableDictionary alloc] init];
+		pendingResolutions = [[NSMutableDictionary alloc] init];
+
+		maximumCachedHosts = DEFAULT_MAXIMUM_CACHED_HOSTS;
+		minimumTimeToLive = DEFAULT_MINIMUM_TIME_TO_LIVE;
+		maximumTimeToLive = DEFAULT_MAXIMUM_TIME_TO_LIVE;
+		negativeTimeToLive = DEFAULT_NEGATIVE_TIME_TO_LIVE;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[backend release];
+	[cache release];
+	[pendingResolutions release];
+
+	[super dealloc];
+}
+
+@synthesize backend, maximumCachedHosts, minimumTimeToLive, maximumTimeToLive, negativeTimeToLive;
+@synthesize lookupCount, cacheHitCount, negativeCacheHitCount, coalescedLookupCount, backendQueryCount, backendFailureCount;
+@synthesize totalBackendLatency, maximumBackendLatency;
+
+- (AIHostResolution *)resolveHostName:(NSString *)hostName handler:(AIHostResolverHandler)handler
+{
+	AIHostResolution			*resolution = [[[AIHostResolution alloc] initWithHostName:hostName handler:handler] autorelease];
+	NSString					*key = [hostName lowercaseString];
+	NSTimeInterval				now = [NSDate timeIntervalSinceReferenceDate];
+	AIHostResolverCacheEntry	*entry = [cache objectForKey:key];
+	NSMutableArray				*waiting;
+
+	lookupCount++;
+
+	if (entry && entry->expiry > now) {
+		NSArray *addresses = [[entry->addresses retain] autorelease];
+		NSError *error = [[entry->error retain] autorelease];
+
+		if (error) negativeCacheHitCount++; else cacheHitCount++;
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[resolution deliverAddresses:addresses error:error];
+		});
+
+		return resolution;
+	}
+	if (entry) [cache removeObjectForKey:key];
+
+	if ((waiting = [pendingResolutions objectForKey:key])) {
+		coalescedLookupCount++;
+		[waiting addObject:resolution];
+		return resolution;
+	}
+
+	waiting = [NSMutableArray arrayWithObject:resolution];
+	[pendingResolutions setObject:waiting forKey:key];
+	backendQueryCount++;
+
+	NSUInteger queryGeneration = generation;
+	[backend resolveHostName:hostName completion:^(NSArray *addresses, NSTimeInterval timeToLive, NSError *error) {
+		[self backendDidResolveHostKey:key
+							 addresses:addresses
+							timeToLive:timeToLive
+								 error:error
+							 startTime:now
+							   waiting:waiting
+							generation:queryGeneration];
+	}];
+
+	return resolution;
+}
+
+- (void)backendDidResolveHostKey:(NSString *)key
+					   addresses:(NSArray *)addresses
+					  timeToLive:(NSTimeInterval)timeToLive
+						   error:(NSError *)error
+					   startTime:(NSTimeInterval)startTime
+						 waiting:(NSMutableArray *)waiting
+					  generation:(NSUInteger)queryGeneration
+{
+	NSTimeInterval	now = [NSDate timeIntervalSinceReferenceDate];
+	NSTimeInterval	latency = now - startTime;
+
+	backendAnswerCount++;
+	totalBackendLatency += latency;
+	if (latency > maximumBackendLatency) maximumBackendLatency = latency;
+
+	if (!error && !addresses.count) {
+		error = [NSError errorWithDomain:AIHostResolverErrorDomain
+									code:EAI_NONAME
+								userInfo:[NSDictionary dictionaryWithObject:[NSString stringWithUTF8String:gai_strerror(EAI_NONAME)]
+																	 forKey:NSLocalizedDescriptionKey]];
+	}
+
+	if (error) {
+		backendFailureCount++;
+		addresses = [NSArray array];
+		timeToLive = negativeTimeToLive;
+	} else {
+		addresses = AIHostResolverInterleavedAddresses(addresses);
+		timeToLive = MIN(MAX(timeToLive, minimumTimeToLive), maximumTimeToLive);
+	}
+
+	//An answer from before the cache was flushed may be out of date
+	if (queryGeneration == generation && timeToLive > 0) {
+		AIHostResolverCacheEntry *entry = [[AIHostResolverCacheEntry alloc] init];
+		entry->addresses = [addresses retain];
+		entry->error = [error retain];
+		entry->expiry = now + timeToLive;
+		[self cacheEntry:entry forKey:key now:now];
+		[entry release];
+	}
+
+	//Unless the cache was flushed and another lookup started since
+	if ([pendingResolutions objectForKey:key] == waiting) [pendingResolutions removeObjectForKey:key];
+
+	for (AIHostResolution *resolution in waiting) {
+		[resolution deliverAddresses:addresses error:error];
+	}
+}
+
+/*!
+ * @brief Cache an answer, making room if need be: expired answers go first, then those closest to expiring
+ */
+- (void)cacheEntry:(AIHostResolverCacheEntry *)entry forKey:(NSString *)key now:(NSTimeInterval)now
+{
+	if (cache.count >= maximumCachedHosts && ![cache objectForKey:key]) {
+		NSMutableArray	*expiredKeys = [NSMutableArray array];
+		NSString		*soonestKey = nil;
+		NSTimeInterval	soonestExpiry = 0;
+
+		for (NSString *cachedKey in cache) {
+			AIHostResolverCacheEntry *cachedEntry = [cache objectForKey:cachedKey];
+
+			if (cachedEntry->expiry <= now) {
+				[expiredKeys addObject:cachedKey];
+			} else if (!soonestKey || cachedEntry->expiry < soonestExpiry) {
+				soonestKey = cachedKey;
+				soonestExpiry = cachedEntry->expiry;
+			}
+		}
+
+		[cache removeObjectsForKeys:expiredKeys];
+		if (cache.count >= maximumCachedHosts && soonestKey) [cache removeObjectForKey:soonestKey];
+	}
+
+	if (maximumCachedHosts) [cache setObject:entry forKey:key];
+}
+
+- (void)flushCache
+{
+	[cache removeAllObjects];
+	[pendingResolutions removeAllObjects];
+	generation++;
+}
+
+- (void)resetStatistics
+{
+	lookupCount = cacheHitCount = negativeCacheHitCount = coalescedLookupCount = 0;
+	backendQueryCount = backendFailureCount = backendAnswerCount = 0;
+	totalBackendLatency = maximumBackendLatency = 0;
+}
+
+- (double)hitRate
+{
+	return (lookupCount ? (double)(lookupCount - backendQueryCount) / lookupCount : 0.0);
+}
+
+- (NSTimeInterval)averageBackendLatency
+{
+	return (backendAnswerCount ? totalBackendLatency / backendAnswerCount : 0.0);
+}
+
+@end
+
+NSArray *AIHostResolverInterleavedAddresses(NSArray *addresses)
+{
+	NSMutableArray	*firstFamily = [NSMutableArray array];
+	NSMutableArray	*otherFamilies = [NSMutableArray array];
+	NSMutableArray	*interleaved;
+	sa_family_t		family = 0;
+
+	if (addresses.count < 2) return addresses;
+
+	for (NSData *address in addresses) {
+		const struct sockaddr *addr = [address bytes];
+
+		if (!family) family = addr->sa_family;
+		[(addr->sa_family == family ? firstFamily : otherFamilies) addObject:address];
+	}
+
+	interleaved = [NSMutableArray arrayWithCapacity:addresses.count];
+	for (NSUInteger i = 0; i < MAX(firstFamily.count, otherFamilies.count); i++) {
+		if (i < firstFamily.count) [interleaved addObject:[firstFamily objectAtIndex:i]];
+		if (i < otherFamilies.count) [interleaved addObject:[otherFamilies objectAtIndex:i]];
+	}
+
+	return interleaved;
+}
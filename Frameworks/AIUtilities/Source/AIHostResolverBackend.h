@@ -0,0 +1,41 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#define AIHostResolverErrorDomain	@"AIHostResolverErrorDomain"
+
+/*!
+ * @brief Called with a host's addresses, each an NSData wrapping a struct sockaddr with no port, and how many seconds
+ * they may be reused; or with an error in AIHostResolverErrorDomain whose code is a getaddrinfo() EAI_ error
+ */
+typedef void (^AIHostResolverBackendCompletion)(NSArray *addresses, NSTimeInterval timeToLive, NSError *error);
+
+/*!
+ * @protocol AIHostResolverBackend
+ * @brief Something which can look up the addresses of a host name
+ *
+ * AIAddrInfoHostResolverBackend asks the system with getaddrinfo(); AIHostsFileHostResolverBackend answers from a
+ * hosts file, which is useful for tests and benchmarks.
+ */
+@protocol AIHostResolverBackend <NSObject>
+
+/*!
+ * @brief Look up a host name
+ *
+ * @param completion Always called once, on the main thread, and never before this method returns
+ */
+- (void)resolveHostName:(NSString *)hostName completion:(AIHostResolverBackendCompletion)completion;
+
+@end
@@ -0,0 +1,52 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <AIUtilities/AIHostResolverBackend.h>
+
+/*!
+ * @class AIHostsFileHostResolverBackend
+ * @brief Answers host name lookups from the contents of a hosts file, as /etc/hosts is written
+ *
+ * Each line is an IPv4 or IPv6 address followed by the names it belongs to; a name on several lines has all of their
+ * addresses, in order. Names are matched without regard to case. Unknown names fail with EAI_NONAME.
+ *
+ * Answers are given after latency seconds, like a stub resolver in front of a slow server, so lookups can be
+ * counted and timed without any network.
+ */
+@interface AIHostsFileHostResolverBackend : NSObject <AIHostResolverBackend> {
+	NSMutableDictionary	*addressesByName;
+	NSTimeInterval		latency;
+	NSTimeInterval		timeToLive;
+	NSUInteger			queryCount;
+}
+
+- (id)initWithHostsFileContents:(NSString *)contents;
+- (id)initWithHostsFileAtPath:(NSString *)path;
+
+/*!
+ * @brief The socket address for an IPv4 or IPv6 address string, as an NSData wrapping a struct sockaddr, or nil
+ */
++ (NSData *)socketAddressWithString:(NSString *)addressString;
+
+@property (readwrite, nonatomic) NSTimeInterval latency;
+@property (readwrite, nonatomic) NSTimeInterval timeToLive;
+
+/*!
+ * @brief How many lookups have been asked of us
+ */
+@property (readonly, nonatomic) NSUInteger queryCount;
+
+@end
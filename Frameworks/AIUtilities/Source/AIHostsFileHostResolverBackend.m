@@ -0,0 +1,121 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <AIUtilities/AIHostsFileHostResolverBackend.h>
+
+#import <sys/socket.h>
+#import <netinet/in.h>
+#import <arpa/inet.h>
+#import <netdb.h>
+
+#define DEFAULT_TIME_TO_LIVE	60.0
+
+@implementation AIHostsFileHostResolverBackend
+
+- (id)initWithHostsFileContents:(NSString *)contents
+{
+	if ((self = [super init])) {
+		NSCharacterSet *whitespace = [NSCharacterSet whitespaceCharacterSet];
+
+		addressesByName = [[NSMutableDictionary alloc] init];
+		timeToLive = DEFAULT_TIME_TO_LIVE;
+
+		for (NSString *line in [contents componentsSeparatedByCharactersInSet:[NSCharacterSet newlineCharacterSet]]) {
+			NSRange		comment = [line rangeOfString:@"#"];
+			NSMutableArray	*fields = [NSMutableArray array];
+
+			if (comment.location != NSNotFound) line = [line substringToIndex:comment.location];
+
+			for (NSString *field in [line componentsSeparatedByCharactersInSet:whitespace]) {
+				if (field.length) [fields addObject:field];
+			}
+			if (fields.count < 2) continue;
+
+			NSData *address = [[self class] socketAddressWithString:[fields objectAtIndex:0]];
+			if (!address) continue;
+
+			for (NSString *name in [fields subarrayWithRange:NSMakeRange(1, fields.count - 1)]) {
+				NSMutableArray *addresses = [addressesByName objectForKey:[name lowercaseString]];
+				if (!addresses) {
+					addresses = [NSMutableArray array];
+					[addressesByName setObject:addresses forKey:[name lowercaseString]];
+				}
+				[addresses addObject:address];
+			}
+		}
+	}
+
+	return self;
+}
+
+- (id)initWithHostsFileAtPath:(NSString *)path
+{
+	return [self initWithHostsFileContents:[NSString stringWithContentsOfFile:path encoding:NSUTF8StringEncoding error:NULL]];
+}
+
+- (void)dealloc
+{
+	[addressesByName release];
+
+	[super dealloc];
+}
+
+@synthesize latency, timeToLive, queryCount;
+
++ (NSData *)socketAddressWithString:(NSString *)addressString
+{
+	struct sockaddr_in	addr4;
+	struct sockaddr_in6	addr6;
+
+	memset(&addr4, 0, sizeof(addr4));
+	if (inet_pton(AF_INET, [addressString UTF8String], &addr4.sin_addr) == 1) {
+		addr4.sin_len = sizeof(addr4);
+		addr4.sin_family = AF_INET;
+		return [NSData dataWithBytes:&addr4 length:sizeof(addr4)];
+	}
+
+	memset(&addr6, 0, sizeof(addr6));
+	if (inet_pton(AF_INET6, [addressString UTF8String], &addr6.sin6_addr) == 1) {
+		addr6.sin6_len = sizeof(addr6);
+		addr6.sin6_family = AF_INET6;
+		return [NSData dataWithBytes:&addr6 length:sizeof(addr6)];
+	}
+
+	return nil;
+}
+
+- (void)resolveHostName:(NSString *)hostName completion:(AIHostResolverBackendCompletion)completion
+{
+	NSArray			*addresses = [[[addressesByName objectForKey:[hostName lowercaseString]] copy] autorelease];
+	NSTimeInterval	answerTimeToLive = timeToLive;
+	NSError			*error = nil;
+
+	queryCount++;
+
+	if (!addresses) {
+		addresses = [NSArray array];
+		error = [NSError errorWithDomain:AIHostResolverErrorDomain
+									code:EAI_NONAME
+								userInfo:[NSDictionary dictionaryWithObject:[NSString stringWithUTF8String:gai_strerror(EAI_NONAME)]
+																	 forKey:NSLocalizedDescriptionKey]];
+	}
+
+	dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(latency * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+		completion(addresses, answerTimeToLive, error);
+	});
+}
+
+@end
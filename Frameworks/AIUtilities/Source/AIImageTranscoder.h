@@ -0,0 +1,48 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+typedef void (^AIImageTranscoderCompletion)(NSString *path, NSString *MIMEType, unsigned long long length, NSError *error);
+
+/*!
+ * @class AIImageTranscoder
+ * @brief Encodes an image to a temporary file no larger than a maximum size, on a background queue
+ *
+ * The image is encoded as PNG and as JPEG and the smaller is kept, as the image uploaders always have. Every
+ * encoding is written straight to disk through ImageIO and abandoned as soon as it passes the size it has to
+ * beat, so a screenshot whose PNG is too large is never encoded in full more than once. If neither fits, JPEG
+ * qualities are tried from highest to lowest, then the image is scaled down; the first that fits is used.
+ *
+ * CGImages are safe to use from any thread; NSImages are not, so the caller picks the representation to encode
+ * on the main thread, e.g. with -[NSImage largestBitmapImageRep].
+ */
+@interface AIImageTranscoder : NSObject {
+	NSUInteger			maximumFileSize;
+	NSUInteger			encodingCount;
+}
+
+- (void)transcodeImage:(CGImageRef)image completion:(AIImageTranscoderCompletion)completion;
+
+/*!
+ * @brief The largest file to produce, in bytes, or 0 for no limit. Defaults to 0.
+ */
+@property (readwrite, nonatomic) NSUInteger maximumFileSize;
+
+/*!
+ * @brief How many encodings were started for the last image transcoded, including abandoned ones
+ */
+@property (readonly, nonatomic) NSUInteger encodingCount;
+
+@end
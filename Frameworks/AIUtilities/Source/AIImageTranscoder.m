@@ -0,0 +1,194 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIImageTranscoder.h"
+#import <ApplicationServices/ApplicationServices.h>
+
+//JPEG qualities to try, best first, when neither the PNG nor the default JPEG fits
+static const CGFloat jpegQualities[] = { 0.8f, 0.6f, 0.4f };
+#define JPEG_QUALITY_COUNT		(sizeof(jpegQualities) / sizeof(jpegQualities[0]))
+
+//How much smaller each scaled attempt is than the last, and the smallest width or height to try
+#define SCALE_STEP				0.75
+#define MINIMUM_DIMENSION		64
+
+/*!
+ * @brief Where an encoding is written; refuses bytes past limit so ImageIO gives up early
+ */
+typedef struct {
+	FILE				*file;
+	unsigned long long	 written;
+	unsigned long long	 limit;
+	BOOL				 exceeded;
+} AIImageTranscoderSink;
+
+static size_t sinkPutBytes(void *info, const void *buffer, size_t count)
+{
+	AIImageTranscoderSink *sink = info;
+
+	if (sink->limit && sink->written + count > sink->limit) {
+		sink->exceeded = YES;
+		return 0;
+	}
+
+	size_t written = fwrite(buffer, 1, count, sink->file);
+	sink->written += written;
+
+	return written;
+}
+
+/*!
+ * @brief Encode an image to a file, giving up as soon as it is larger than limit bytes
+ *
+ * @param quality The lossy compression quality, or 0 for the encoder's default
+ * @param limit The largest acceptable file, or 0 for no limit
+ * @result The length of the file, or 0 if it was too large or couldn't be written
+ */
+static unsigned long long encodeImage(CGImageRef image, CFStringRef type, CGFloat quality, NSString *path, unsigned long long limit)
+{
+	AIImageTranscoderSink	sink = { fopen([path fileSystemRepresentation], "wb"), 0, limit, NO };
+	BOOL					success = NO;
+
+	if (!sink.file) return 0;
+
+	CGDataConsumerCallbacks	callbacks = { sinkPutBytes, NULL };
+	CGDataConsumerRef		consumer = CGDataConsumerCreate(&sink, &callbacks);
+	CGImageDestinationRef	destination = CGImageDestinationCreateWithDataConsumer(consumer, type, 1, NULL);
+
+	if (destination) {
+		NSDictionary *properties = nil;
+		if (quality > 0) {
+			properties = [NSDictionary dictionaryWithObject:[NSNumber numberWithDouble:quality]
+													 forKey:(NSString *)kCGImageDestinationLossyCompressionQuality];
+		}
+
+		CGImageDestinationAddImage(destination, image, (CFDictionaryRef)properties);
+		success = CGImageDestinationFinalize(destination);
+		CFRelease(destination);
+	}
+
+	CGDataConsumerRelease(consumer);
+	if (fclose(sink.file) != 0) success = NO;
+
+	return ((success && !sink.exceeded) ? sink.written : 0);
+}
+
+/*!
+ * @brief A copy of an image scaled by a factor; the caller releases it
+ */
+static CGImageRef copyScaledImage(CGImageRef image, CGFloat scale)
+{
+	size_t				width = MAX((size_t)(CGImageGetWidth(image) * scale), (size_t)1);
+	size_t				height = MAX((size_t)(CGImageGetHeight(image) * scale), (size_t)1);
+	CGColorSpaceRef		colorSpace = CGColorSpaceCreateDeviceRGB();
+	CGContextRef		context = CGBitmapContextCreate(NULL, width, height, 8, 0, colorSpace, kCGImageAlphaPremultipliedLast);
+	CGImageRef			scaledImage = NULL;
+
+	CGColorSpaceRelease(colorSpace);
+	if (!context) return NULL;
+
+	CGContextSetInterpolationQuality(context, kCGInterpolationHigh);
+	CGContextDrawImage(context, CGRectMake(0, 0, width, height), image);
+	scaledImage = CGBitmapContextCreateImage(context);
+	CGContextRelease(context);
+
+	return scaledImage;
+}
+
+static NSString *temporaryPath(NSString *extension)
+{
+	return [NSTemporaryDirectory() stringByAppendingPathComponent:
+			[NSString stringWithFormat:@"AIImageTranscoder-%@.%@", [[NSProcessInfo processInfo] globallyUniqueString], extension]];
+}
+
+@implementation AIImageTranscoder
+
+@synthesize maximumFileSize, encodingCount;
+
+/*!
+ * @brief Encode an image on a background queue
+ *
+ * The completion is called on the main thread with the path of a temporary file, which the caller should remove
+ * when done with it, or with an error if the image couldn't be made to fit.
+ */
+- (void)transcodeImage:(CGImageRef)image completion:(AIImageTranscoderCompletion)completion
+{
+	unsigned long long	limit = maximumFileSize;
+
+	completion = [[completion copy] autorelease];
+	CGImageRetain(image);
+
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+		NSFileManager		*fileManager = [[[NSFileManager alloc] init] autorelease];
+		NSString			*pngPath = temporaryPath(@"png"), *jpegPath = temporaryPath(@"jpg");
+		NSString			*path = nil, *MIMEType = nil;
+		unsigned long long	pngLength, jpegLength, length = 0;
+		NSUInteger			count = 2;
+
+		//The JPEG only has to be encoded as far as the PNG's length to know the PNG is smaller
+		pngLength = encodeImage(image, CFSTR("public.png"), 0, pngPath, limit);
+		jpegLength = encodeImage(image, CFSTR("public.jpeg"), 0, jpegPath, (pngLength ? pngLength - 1 : limit));
+
+		if (jpegLength) {
+			path = jpegPath; MIMEType = @"image/jpeg"; length = jpegLength;
+			[fileManager removeItemAtPath:pngPath error:NULL];
+
+		} else if (pngLength) {
+			path = pngPath; MIMEType = @"image/png"; length = pngLength;
+			[fileManager removeItemAtPath:jpegPath error:NULL];
+
+		} else {
+			NSUInteger	i;
+			CGFloat		scale;
+
+			[fileManager removeItemAtPath:pngPath error:NULL];
+
+			for (i = 0; i < JPEG_QUALITY_COUNT && !length; i++, count++) {
+				length = encodeImage(image, CFSTR("public.jpeg"), jpegQualities[i], jpegPath, limit);
+			}
+
+			for (scale = SCALE_STEP;
+				 !length && MIN(CGImageGetWidth(image), CGImageGetHeight(image)) * scale >= MINIMUM_DIMENSION;
+				 scale *= SCALE_STEP, count++) {
+				CGImageRef scaledImage = copyScaledImage(image, scale);
+				if (!scaledImage) break;
+
+				length = encodeImage(scaledImage, CFSTR("public.jpeg"), jpegQualities[0], jpegPath, limit);
+				CGImageRelease(scaledImage);
+			}
+
+			if (length) {
+				path = jpegPath; MIMEType = @"image/jpeg";
+			} else {
+				[fileManager removeItemAtPath:jpegPath error:NULL];
+			}
+		}
+
+		CGImageRelease(image);
+
+		NSError *error = (path ? nil : [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileWriteUnknownError userInfo:nil]);
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			encodingCount = count;
+			completion(path, MIMEType, length, error);
+		});
+
+		[pool release];
+	});
+}
+
+@end
@@ -0,0 +1,70 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*!
+ * @class AIKeywordMatcher
+ * @brief Finds any of a fixed set of keywords in a string, ignoring case, in a single pass
+ *
+ * The keywords are compiled into an Aho-Corasick automaton when the matcher is created, so the cost of a search
+ * depends on the length of the string rather than on the number of keywords. Case is folded one UTF-16 unit at a
+ * time, which covers everything but the few characters whose lowercase form is longer than they are.
+ *
+ * Matchers are immutable once created and may be searched from any thread.
+ */
+@interface AIKeywordMatcher : NSObject {
+	NSArray		*keywords;
+	NSUInteger	*keywordLengths;
+	NSUInteger	longestKeywordLength;
+
+	NSUInteger	stateCount;
+	NSUInteger	*failureStates;		//Longest proper suffix of each state which is also a state
+	NSUInteger	*outputStates;		//Nearest state along the failure chain which ends a keyword, or NSNotFound
+	NSUInteger	*firstKeywords;		//First keyword ending at each state, or NSNotFound
+	NSUInteger	*nextKeywords;		//Next keyword ending at the same state as each keyword, or NSNotFound
+
+	NSUInteger	*firstEdges;		//Each state's edges are edgeCharacters/edgeTargets[firstEdges[s]..firstEdges[s+1]]
+	unichar		*edgeCharacters;	//Sorted within each state
+	NSUInteger	*edgeTargets;
+}
+
+/*!
+ * @brief Create a matcher for keywords
+ *
+ * @param inKeywords NSStrings to look for. Empty keywords never match; a keyword may appear more than once.
+ */
+- (id)initWithKeywords:(NSArray *)inKeywords;
+
+@property (readonly, nonatomic) NSArray *keywords;
+
+/*!
+ * @brief Find the first occurrence of every keyword in a string
+ *
+ * @param outRanges Room for one range per keyword, in the order of the keywords array. A keyword which does not occur
+ *                  gets a location of NSNotFound.
+ */
+- (void)getFirstRanges:(NSRange *)outRanges inString:(NSString *)string;
+
+/*!
+ * @brief Find the first occurrence of every keyword which doesn't overlap text with a given attribute
+ *
+ * The attribute's runs are looked up as the string is scanned, so excluding them costs no extra pass.
+ * For example, passing NSLinkAttributeName finds keywords which are not part of a link.
+ *
+ * @param outRanges Room for one range per keyword, as for <tt>getFirstRanges:inString:</tt>
+ */
+- (void)getFirstRanges:(NSRange *)outRanges inAttributedString:(NSAttributedString *)attributedString excludingAttribute:(NSString *)attributeName;
+
+@end
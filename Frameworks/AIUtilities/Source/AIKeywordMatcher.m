@@ -0,0 +1,323 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIKeywordMatcher.h"
+#import <pthread.h>
+
+#pragma mark Case folding
+
+static unichar			*foldPages[256];
+static pthread_mutex_t	foldLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*!
+ * @brief Build the lowercase mapping for 256 characters, keeping only those which lowercase to a single character
+ */
+static unichar *AIBuildFoldPage(NSUInteger pageIndex)
+{
+	pthread_mutex_lock(&foldLock);
+
+	unichar *page = foldPages[pageIndex];
+	if (!page) {
+		CFMutableStringRef	scratch = CFStringCreateMutable(kCFAllocatorDefault, 0);
+
+		page = malloc(256 * sizeof(unichar));
+		for (NSUInteger i = 0; i < 256; i++) {
+			unichar	character = (unichar)((pageIndex << 8) | i);
+
+			CFStringDelete(scratch, CFRangeMake(0, CFStringGetLength(scratch)));
+			CFStringAppendCharacters(scratch, &character, 1);
+			CFStringLowercase(scratch, NULL);
+
+			page[i] = (CFStringGetLength(scratch) == 1 ? CFStringGetCharacterAtIndex(scratch, 0) : character);
+		}
+		CFRelease(scratch);
+
+		//Readers look at foldPages without the lock; the page must be complete before they can see it
+		__sync_synchronize();
+		foldPages[pageIndex] = page;
+	}
+
+	pthread_mutex_unlock(&foldLock);
+
+	return page;
+}
+
+static inline unichar AIFoldedCharacter(unichar character)
+{
+	if (character < 0x80) return ((character >= 'A' && character <= 'Z') ? (unichar)(character + ('a' - 'A')) : character);
+
+	unichar *page = foldPages[character >> 8];
+	if (!page) page = AIBuildFoldPage(character >> 8);
+
+	return page[character & 0xFF];
+}
+
+#pragma mark -
+
+/*!
+ * @brief The state reached from state on a (folded) character, or NSNotFound if there is no such edge
+ */
+static inline NSUInteger AITargetOfState(const NSUInteger *firstEdges, const unichar *edgeCharacters, const NSUInteger *edgeTargets,
+										 NSUInteger state, unichar character)
+{
+	NSUInteger low = firstEdges[state], high = firstEdges[state + 1];
+
+	while (low < high) {
+		NSUInteger middle = (low + high) / 2;
+
+		if (edgeCharacters[middle] < character) {
+			low = middle + 1;
+		} else if (edgeCharacters[middle] > character) {
+			high = middle;
+		} else {
+			return edgeTargets[middle];
+		}
+	}
+
+	return NSNotFound;
+}
+
+@interface AIKeywordMatcher ()
+- (void)_getFirstRanges:(NSRange *)outRanges
+			   inString:(NSString *)string
+	 attributedString:(NSAttributedString *)attributedString
+	 excludingAttribute:(NSString *)attributeName;
+@end
+
+@implementation AIKeywordMatcher
+
+- (id)initWithKeywords:(NSArray *)inKeywords
+{
+	if ((self = [super init])) {
+		NSUInteger	keywordCount = inKeywords.count;
+		NSUInteger	totalLength = 0, k, i;
+
+		keywords = [inKeywords copy];
+		keywordLengths = malloc(MAX(keywordCount, 1) * sizeof(NSUInteger));
+		nextKeywords = malloc(MAX(keywordCount, 1) * sizeof(NSUInteger));
+
+		for (k = 0; k < keywordCount; k++) {
+			keywordLengths[k] = [[keywords objectAtIndex:k] length];
+			totalLength += keywordLengths[k];
+			longestKeywordLength = MAX(longestKeywordLength, keywordLengths[k]);
+		}
+
+		//Build the trie. States are numbered in order of creation, with the root as 0; while building, each state's
+		//children are a linked list.
+		NSUInteger	maxStates = totalLength + 1;
+		NSUInteger	*firstChild = malloc(maxStates * sizeof(NSUInteger));
+		NSUInteger	*nextSibling = malloc(maxStates * sizeof(NSUInteger));
+		unichar		*incomingCharacter = malloc(maxStates * sizeof(unichar));
+		unichar		*folded = malloc(MAX(longestKeywordLength, 1) * sizeof(unichar));
+
+		firstKeywords = malloc(maxStates * sizeof(NSUInteger));
+
+		firstChild[0] = NSNotFound;
+		firstKeywords[0] = NSNotFound;
+		stateCount = 1;
+
+		for (k = 0; k < keywordCount; k++) {
+			NSUInteger state = 0;
+
+			nextKeywords[k] = NSNotFound;
+			if (!keywordLengths[k]) continue;
+
+			[[keywords objectAtIndex:k] getCharacters:folded range:NSMakeRange(0, keywordLengths[k])];
+
+			for (i = 0; i < keywordLengths[k]; i++) {
+				unichar		character = AIFoldedCharacter(folded[i]);
+				NSUInteger	child;
+
+				for (child = firstChild[state]; child != NSNotFound; child = nextSibling[child]) {
+					if (incomingCharacter[child] == character) break;
+				}
+
+				if (child == NSNotFound) {
+					child = stateCount++;
+					incomingCharacter[child] = character;
+					firstChild[child] = NSNotFound;
+					firstKeywords[child] = NSNotFound;
+					nextSibling[child] = firstChild[state];
+					firstChild[state] = child;
+				}
+
+				state = child;
+			}
+
+			//Keep keywords which end at the same state in their original order
+			NSUInteger *link = &firstKeywords[state];
+			while (*link != NSNotFound) link = &nextKeywords[*link];
+			*link = k;
+		}
+
+		//Lay the edges out contiguously, sorted by character within each state, for binary search
+		firstEdges = malloc((stateCount + 1) * sizeof(NSUInteger));
+		edgeCharacters = malloc(MAX(stateCount - 1, 1) * sizeof(unichar));
+		edgeTargets = malloc(MAX(stateCount - 1, 1) * sizeof(NSUInteger));
+
+		NSUInteger edgeCount = 0;
+		for (NSUInteger state = 0; state < stateCount; state++) {
+			firstEdges[state] = edgeCount;
+
+			for (NSUInteger child = firstChild[state]; child != NSNotFound; child = nextSibling[child]) {
+				//Insertion sort; states rarely have more than a handful of children
+				NSUInteger j = edgeCount++;
+				while (j > firstEdges[state] && edgeCharacters[j - 1] > incomingCharacter[child]) {
+					edgeCharacters[j] = edgeCharacters[j - 1];
+					edgeTargets[j] = edgeTargets[j - 1];
+					j--;
+				}
+				edgeCharacters[j] = incomingCharacter[child];
+				edgeTargets[j] = child;
+			}
+		}
+		firstEdges[stateCount] = edgeCount;
+
+		//Failure and output links, breadth first so a state's failure state is always done before it is
+		NSUInteger	*queue = malloc(stateCount * sizeof(NSUInteger));
+		NSUInteger	head = 0, tail = 0;
+
+		failureStates = malloc(stateCount * sizeof(NSUInteger));
+		outputStates = malloc(stateCount * sizeof(NSUInteger));
+		failureStates[0] = 0;
+		outputStates[0] = NSNotFound;
+		queue[tail++] = 0;
+
+		while (head < tail) {
+			NSUInteger state = queue[head++];
+
+			for (NSUInteger edge = firstEdges[state]; edge < firstEdges[state + 1]; edge++) {
+				NSUInteger	child = edgeTargets[edge];
+				NSUInteger	failure = NSNotFound;
+
+				if (state != 0) {
+					NSUInteger fallback = failureStates[state];
+					while ((failure = AITargetOfState(firstEdges, edgeCharacters, edgeTargets, fallback, edgeCharacters[edge])) == NSNotFound && fallback != 0) {
+						fallback = failureStates[fallback];
+					}
+				}
+
+				failureStates[child] = (failure == NSNotFound ? 0 : failure);
+				outputStates[child] = (firstKeywords[failureStates[child]] != NSNotFound ?
+									   failureStates[child] :
+									   outputStates[failureStates[child]]);
+				queue[tail++] = child;
+			}
+		}
+
+		free(queue);
+		free(folded);
+		free(incomingCharacter);
+		free(nextSibling);
+		free(firstChild);
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[keywords release];
+	free(keywordLengths);
+	free(nextKeywords);
+	free(firstKeywords);
+	free(failureStates);
+	free(outputStates);
+	free(firstEdges);
+	free(edgeCharacters);
+	free(edgeTargets);
+
+	[super dealloc];
+}
+
+@synthesize keywords;
+
+- (void)getFirstRanges:(NSRange *)outRanges inString:(NSString *)string
+{
+	[self _getFirstRanges:outRanges inString:string attributedString:nil excludingAttribute:nil];
+}
+
+- (void)getFirstRanges:(NSRange *)outRanges inAttributedString:(NSAttributedString *)attributedString excludingAttribute:(NSString *)attributeName
+{
+	[self _getFirstRanges:outRanges inString:[attributedString string] attributedString:attributedString excludingAttribute:attributeName];
+}
+
+/*!
+ * @brief Scan string once, recording the first acceptable match of each keyword
+ *
+ * Matches are found in order of where they end, so the first one found for a keyword is also the one which starts
+ * first. When excluding an attribute, only the latest run with the attribute that starts at or before the current
+ * character needs checking: a match overlapping an earlier run would also contain the start of the latest one.
+ */
+- (void)_getFirstRanges:(NSRange *)outRanges
+			   inString:(NSString *)string
+	 attributedString:(NSAttributedString *)attributedString
+	 excludingAttribute:(NSString *)attributeName
+{
+	NSUInteger				keywordCount = keywords.count;
+	NSUInteger				remaining = 0;
+	NSUInteger				k;
+
+	for (k = 0; k < keywordCount; k++) {
+		outRanges[k] = NSMakeRange(NSNotFound, 0);
+		if (keywordLengths[k]) remaining++;
+	}
+
+	if (!remaining || !string) return;
+
+	CFStringInlineBuffer	buffer;
+	CFIndex					length = CFStringGetLength((CFStringRef)string);
+	NSUInteger				state = 0;
+	NSRange					excludedRange = NSMakeRange(NSNotFound, 0);
+	NSUInteger				attributeRunEnd = 0;
+
+	CFStringInitInlineBuffer((CFStringRef)string, &buffer, CFRangeMake(0, length));
+
+	for (NSUInteger i = 0; i < (NSUInteger)length; i++) {
+		if (attributeName && i >= attributeRunEnd) {
+			NSRange attributeRun;
+
+			if ([attributedString attribute:attributeName atIndex:i effectiveRange:&attributeRun]) {
+				excludedRange = attributeRun;
+			}
+			attributeRunEnd = NSMaxRange(attributeRun);
+		}
+
+		unichar		character = AIFoldedCharacter(CFStringGetCharacterFromInlineBuffer(&buffer, i));
+		NSUInteger	next;
+
+		while ((next = AITargetOfState(firstEdges, edgeCharacters, edgeTargets, state, character)) == NSNotFound && state != 0) {
+			state = failureStates[state];
+		}
+		state = (next == NSNotFound ? 0 : next);
+
+		for (NSUInteger matchState = (firstKeywords[state] != NSNotFound ? state : outputStates[state]);
+			 matchState != NSNotFound;
+			 matchState = outputStates[matchState]) {
+			for (k = firstKeywords[matchState]; k != NSNotFound; k = nextKeywords[k]) {
+				NSUInteger start = i + 1 - keywordLengths[k];
+
+				if (outRanges[k].location != NSNotFound) continue;
+				if (excludedRange.location != NSNotFound && start < NSMaxRange(excludedRange)) continue;
+
+				outRanges[k] = NSMakeRange(start, keywordLengths[k]);
+				if (--remaining == 0) return;
+			}
+		}
+	}
+}
+
+@end
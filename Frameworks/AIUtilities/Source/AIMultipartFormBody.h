@@ -0,0 +1,52 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*!
+ * @class AIMultipartFormBody
+ * @brief A multipart/form-data request body which is streamed rather than built in memory
+ *
+ * Fields and files are sent in the order they were added, each part closed by a CRLF, followed by the closing
+ * boundary. Files are read a buffer at a time as the stream is consumed, so an upload never holds more than
+ * one buffer of them in memory.
+ */
+@interface AIMultipartFormBody : NSObject {
+	NSString			*boundary;
+	NSMutableArray		*parts;
+}
+
+- (id)initWithBoundary:(NSString *)inBoundary;
+
+- (void)addFieldWithName:(NSString *)name value:(NSString *)value;
+- (void)addFileAtPath:(NSString *)path name:(NSString *)name fileName:(NSString *)fileName contentType:(NSString *)contentType;
+
+- (NSInputStream *)inputStream;
+
+/*!
+ * @brief The boundary between parts. Defaults to a random one.
+ */
+@property (readonly, nonatomic) NSString *boundary;
+
+/*!
+ * @brief The value for the request's Content-Type header
+ */
+@property (readonly, nonatomic) NSString *contentType;
+
+/*!
+ * @brief The length of the body in bytes, for the request's Content-Length header
+ */
+@property (readonly, nonatomic) unsigned long long contentLength;
+
+@end
@@ -0,0 +1,272 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIMultipartFormBody.h"
+
+#define BUFFER_SIZE		65536
+
+/*!
+ * @class AIMultipartFormBodyProducer
+ * @brief Writes the parts of a body into the write end of a bound stream pair as it has space
+ *
+ * Keeps itself alive until everything is written or the read end is closed.
+ */
+@interface AIMultipartFormBodyProducer : NSObject <NSStreamDelegate> {
+	NSArray				*segments;
+	NSUInteger			segmentIndex;
+	NSUInteger			segmentOffset;
+	NSInputStream		*fileStream;
+
+	NSOutputStream		*outputStream;
+	uint8_t				buffer[BUFFER_SIZE];
+	NSUInteger			bufferOffset;
+	NSUInteger			bufferLength;
+	BOOL				finished;
+}
+- (id)initWithSegments:(NSArray *)inSegments outputStream:(NSOutputStream *)inOutputStream;
+- (void)start;
+- (BOOL)fillBuffer;
+- (void)finish;
+@end
+
+@implementation AIMultipartFormBodyProducer
+
+- (id)initWithSegments:(NSArray *)inSegments outputStream:(NSOutputStream *)inOutputStream
+{
+	if ((self = [super init])) {
+		segments = [inSegments copy];
+		outputStream = [inOutputStream retain];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[segments release];
+	[fileStream release];
+	[outputStream release];
+
+	[super dealloc];
+}
+
+- (void)start
+{
+	[self retain];
+
+	[outputStream setDelegate:self];
+	[outputStream scheduleInRunLoop:[NSRunLoop currentRunLoop] forMode:NSRunLoopCommonModes];
+	[outputStream open];
+}
+
+/*!
+ * @brief Refill the buffer from the next segments
+ *
+ * @result NO if a file couldn't be read. The buffer is left empty once every segment has been written.
+ */
+- (BOOL)fillBuffer
+{
+	bufferOffset = bufferLength = 0;
+
+	while (!bufferLength && segmentIndex < segments.count) {
+		id segment = [segments objectAtIndex:segmentIndex];
+
+		if ([segment isKindOfClass:[NSData class]]) {
+			bufferLength = MIN([(NSData *)segment length] - segmentOffset, (NSUInteger)BUFFER_SIZE);
+			[(NSData *)segment getBytes:buffer range:NSMakeRange(segmentOffset, bufferLength)];
+			segmentOffset += bufferLength;
+
+			if (segmentOffset == [(NSData *)segment length]) {
+				segmentIndex++;
+				segmentOffset = 0;
+			}
+
+		} else {
+			if (!fileStream) {
+				fileStream = [[NSInputStream alloc] initWithFileAtPath:segment];
+				[fileStream open];
+			}
+
+			NSInteger bytesRead = [fileStream read:buffer maxLength:BUFFER_SIZE];
+			if (bytesRead < 0) return NO;
+
+			if (bytesRead) {
+				bufferLength = bytesRead;
+			} else {
+				[fileStream close];
+				[fileStream release]; fileStream = nil;
+				segmentIndex++;
+			}
+		}
+	}
+
+	return YES;
+}
+
+- (void)stream:(NSStream *)stream handleEvent:(NSStreamEvent)eventCode
+{
+	switch (eventCode) {
+		case NSStreamEventHasSpaceAvailable:
+		{
+			if (bufferOffset == bufferLength && (![self fillBuffer] || !bufferLength)) {
+				//Done, or a file went missing; either way the read end sees the end of the body
+				[self finish];
+				return;
+			}
+
+			NSInteger written = [outputStream write:(buffer + bufferOffset) maxLength:(bufferLength - bufferOffset)];
+			if (written <= 0) {
+				[self finish];
+			} else {
+				bufferOffset += written;
+			}
+			break;
+		}
+
+		case NSStreamEventErrorOccurred:
+		case NSStreamEventEndEncountered:
+			[self finish];
+			break;
+
+		default:
+			break;
+	}
+}
+
+- (void)finish
+{
+	if (finished) return;
+	finished = YES;
+
+	[outputStream setDelegate:nil];
+	[outputStream removeFromRunLoop:[NSRunLoop currentRunLoop] forMode:NSRunLoopCommonModes];
+	[outputStream close];
+
+	[fileStream close];
+	[fileStream release]; fileStream = nil;
+
+	[self autorelease];
+}
+
+@end
+
+#pragma mark -
+
+@interface AIMultipartFormBody ()
+- (NSData *)closingBoundary;
+@end
+
+@implementation AIMultipartFormBody
+
+- (id)init
+{
+	return [self initWithBoundary:[[[NSProcessInfo processInfo] globallyUniqueString] stringByReplacingOccurrencesOfString:@"-" withString:@""]];
+}
+
+- (id)initWithBoundary:(NSString *)inBoundary
+{
+	if ((self = [super init])) {
+		boundary = [inBoundary copy];
+		parts = [[NSMutableArray alloc] init];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[boundary release];
+	[parts release];
+
+	[super dealloc];
+}
+
+@synthesize boundary;
+
+- (NSString *)contentType
+{
+	return [NSString stringWithFormat:@"multipart/form-data; boundary=%@", boundary];
+}
+
+- (void)addFieldWithName:(NSString *)name value:(NSString *)value
+{
+	NSString *part = [NSString stringWithFormat:@"--%@\r\nContent-Disposition: form-data; name=\"%@\"\r\n\r\n%@\r\n", boundary, name, value];
+
+	[parts addObject:[part dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+/*!
+ * @brief Add a file, which is read when the body is streamed
+ */
+- (void)addFileAtPath:(NSString *)path name:(NSString *)name fileName:(NSString *)fileName contentType:(NSString *)contentType
+{
+	NSString *header = [NSString stringWithFormat:@"--%@\r\nContent-Disposition: form-data; name=\"%@\"; filename=\"%@\"\r\nContent-Type: %@\r\n\r\n",
+						boundary, name, fileName, contentType];
+
+	[parts addObject:[header dataUsingEncoding:NSUTF8StringEncoding]];
+	[parts addObject:[[path copy] autorelease]];
+	[parts addObject:[@"\r\n" dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (NSData *)closingBoundary
+{
+	return [[NSString stringWithFormat:@"--%@--\r\n", boundary] dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+- (unsigned long long)contentLength
+{
+	NSFileManager		*fileManager = [NSFileManager defaultManager];
+	unsigned long long	length = [[self closingBoundary] length];
+
+	for (id part in parts) {
+		if ([part isKindOfClass:[NSData class]]) {
+			length += [(NSData *)part length];
+		} else {
+			length += [[fileManager attributesOfItemAtPath:part error:NULL] fileSize];
+		}
+	}
+
+	return length;
+}
+
+/*!
+ * @brief A new stream of the whole body
+ *
+ * The body is produced on the current run loop as the stream is read, so this must be called on a thread whose
+ * run loop keeps running, normally the main thread.
+ */
+- (NSInputStream *)inputStream
+{
+	CFReadStreamRef		readStream = NULL;
+	CFWriteStreamRef	writeStream = NULL;
+
+	CFStreamCreateBoundPair(kCFAllocatorDefault, &readStream, &writeStream, BUFFER_SIZE);
+	if (!readStream || !writeStream) {
+		if (readStream) CFRelease(readStream);
+		if (writeStream) CFRelease(writeStream);
+		return nil;
+	}
+
+	AIMultipartFormBodyProducer *producer = [[AIMultipartFormBodyProducer alloc] initWithSegments:[parts arrayByAddingObject:[self closingBoundary]]
+																				   outputStream:(NSOutputStream *)writeStream];
+	[producer start];
+	[producer release];
+	CFRelease(writeStream);
+
+	return [NSMakeCollectable(readStream) autorelease];
+}
+
+@end
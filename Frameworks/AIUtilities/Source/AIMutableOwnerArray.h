@@ -20,8 +20,20 @@
 #define Low_Priority  		0.75f
 #define Lowest_Priority  	1.0f
 
+//Most owner arrays never hold more than this many objects; up to this many are stored without a separate allocation
+#define OWNER_ARRAY_INLINE_CAPACITY	2
+
 @class AIMutableOwnerArray;
 
+/*!
+ * @brief One object in an AIMutableOwnerArray, with its owner and priority. The owner and object are retained.
+ */
+typedef struct {
+	id		owner;
+	id		object;
+	float	priority;
+} AIMutableOwnerArrayEntry;
+
 //Delegate protocol for documentation purposes; it is not necessary to declare conformance to this protocol.
 @protocol AIMutableOwnerArrayDelegate
 - (void)mutableOwnerArray:(AIMutableOwnerArray *)inArray didSetObject:(id)anObject withOwner:(id)inOwner priorityLevel:(float)priority;
@@ -41,11 +53,16 @@
  *
  * Floating point priority levels can be used to dictate the ordering of objects in the array.
  * Lower numbers have higher priority.
+ *
+ * Every list object keeps several of these, so they are kept small: entries live in a plain C array, inside the
+ * owner array itself while there are no more than \c OWNER_ARRAY_INLINE_CAPACITY of them.
  */
 @interface AIMutableOwnerArray : NSObject <NSFastEnumeration> {
-	NSMutableArray	*contentArray;
-	NSMutableArray	*ownerArray;
-	NSMutableArray	*priorityArray;
+	AIMutableOwnerArrayEntry	inlineEntries[OWNER_ARRAY_INLINE_CAPACITY];
+	AIMutableOwnerArrayEntry	*entries;
+	NSUInteger					entryCount;
+	NSUInteger					entryCapacity;
+	unsigned long				mutations;
 	
 	BOOL			valueIsSortedToFront;
 	
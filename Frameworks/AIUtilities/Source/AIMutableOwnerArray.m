@@ -14,18 +14,15 @@
  * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
-/*
-	Delegate method:
-		- (void)mutableOwnerArray:(AIMutableOwnerArray *)inArray didSetObject:(id)anObject withOwner:(id)inOwner priorityLevel:(float)priority
-*/
-
 #import "AIMutableOwnerArray.h"
 
 @interface AIMutableOwnerArray ()
 - (id)_objectWithHighestPriority;
-- (void)_moveObjectToFront:(int)objectIndex;
-- (void)_createArrays;
-- (void)_destroyArrays;
+- (void)_moveObjectToFront:(NSUInteger)objectIndex;
+- (NSUInteger)_indexOfOwner:(id)inOwner;
+- (NSUInteger)_indexOfObject:(id)inObject;
+- (void)_removeEntryAtIndex:(NSUInteger)idx;
+- (void)_addEntryWithOwner:(id)inOwner object:(id)anObject priority:(float)priority;
 - (void)mutableOwnerArray:(AIMutableOwnerArray *)mutableOwnerArray didSetObject:(id)anObject withOwner:(id)inOwner;
 @end
 
@@ -35,9 +32,9 @@
 - (id)init
 {
 	if ((self = [super init])) {
-		contentArray = nil;
-		ownerArray = nil;
-		priorityArray = nil;
+		entries = inlineEntries;
+		entryCount = 0;
+		entryCapacity = OWNER_ARRAY_INLINE_CAPACITY;
 		valueIsSortedToFront = NO;
 		delegate = nil;
 	}
@@ -50,7 +47,12 @@
 {
 	delegate = nil;
 	
-	[self _destroyArrays];
+	for (NSUInteger i = 0; i < entryCount; i++) {
+		[entries[i].owner release];
+		[entries[i].object release];
+	}
+	if (entries != inlineEntries) free(entries);
+
 	[super dealloc];
 }
 
@@ -58,11 +60,10 @@
 - (NSString *)description
 {
 	NSMutableString	*desc = [[NSMutableString alloc] initWithFormat:@"<%@: %p: ", NSStringFromClass([self class]), self];
-	NSUInteger	i = 0;
 	
-	for (id object in self) {
-		[desc appendFormat:@"(%@:%@:%@)%@", [ownerArray objectAtIndex:i], object, [priorityArray objectAtIndex:i], (object == [contentArray lastObject] ? @"" : @", ")];
-		i++;
+	for (NSUInteger i = 0; i < entryCount; i++) {
+		[desc appendFormat:@"(%@:%@:%@)%@", entries[i].owner, entries[i].object, [NSNumber numberWithFloat:entries[i].priority],
+		 (i + 1 == entryCount ? @"" : @", ")];
 	}
 	[desc appendString:@">"];
 	
@@ -84,24 +85,18 @@
 	//Keep priority in bounds
 	if ((priority < Highest_Priority) || (priority > Lowest_Priority)) priority = Medium_Priority;
 
+	//The new object may only be retained by the entry it replaces
+	[anObject retain];
+	[inOwner retain];
+	
 	//Remove any existing objects from this owner
-	ownerIndex = [ownerArray indexOfObject:inOwner];
-	if (ownerArray && (ownerIndex != NSNotFound)) {
-		[ownerArray removeObjectAtIndex:ownerIndex];
-		[contentArray removeObjectAtIndex:ownerIndex];
-		[priorityArray removeObjectAtIndex:ownerIndex];
-	}
+	ownerIndex = [self _indexOfOwner:inOwner];
+	if (ownerIndex != NSNotFound) [self _removeEntryAtIndex:ownerIndex];
 	
 	//Add the new object
-	if (anObject) {
-		//If we haven't created arrays yet, do so now
-		if (!ownerArray) [self _createArrays];
-		
-		//Add the object
-		[ownerArray addObject:inOwner];
-		[contentArray addObject:anObject];
-		[priorityArray addObject:[NSNumber numberWithFloat:priority]];
-	}
+	if (anObject) [self _addEntryWithOwner:inOwner object:anObject priority:priority];
+
+	mutations++;
 
 	//Our array may no longer have the return value sorted to the front, clear this flag so it can be sorted again
 	valueIsSortedToFront = NO;
@@ -109,6 +104,9 @@
 	if (delegate && delegateRespondsToDidSetObjectWithOwnerPriorityLevel) {
 		[delegate mutableOwnerArray:self didSetObject:anObject withOwner:inOwner priorityLevel:priority];
 	}	
+
+	[anObject release];
+	[inOwner release];
 }
 
 //The method the delegate would implement, here to make the compiler happy.
@@ -119,23 +117,21 @@
 
 - (id)objectValue
 {
-    return ((ownerArray && [ownerArray count]) ? [self _objectWithHighestPriority] : nil);
+    return (entryCount ? [self _objectWithHighestPriority] : nil);
 }
 
 - (NSNumber *)numberValue
 {
-	NSUInteger count;
-	if (ownerArray && (count = [ownerArray count])) {
+	if (entryCount) {
 		//If we have more than one object and the object we want is not already in the front of our arrays, 
 		//we need to find the object with largest int value and move it to the front
-		if (count != 1 && !valueIsSortedToFront) {
+		if (entryCount != 1 && !valueIsSortedToFront) {
 			NSNumber 	*currentMax = [NSNumber numberWithInt:0];
-			int			indexOfMax = 0;
-			int			idx = 0;
+			NSUInteger	indexOfMax = 0;
 			
 			//Find the object with the largest int value
-			for (idx = 0;idx < count;idx++) {
-				NSNumber	*value = [contentArray objectAtIndex:idx];
+			for (NSUInteger idx = 0; idx < entryCount; idx++) {
+				NSNumber	*value = entries[idx].object;
 
 				if ([value compare:currentMax] == NSOrderedDescending) {
 					currentMax = value;
@@ -148,7 +144,7 @@
 			
 			return currentMax;
 		} else {
-			return [contentArray objectAtIndex:0];
+			return entries[0].object;
 		}
 	}
 	return 0;
@@ -156,18 +152,16 @@
 
 - (NSInteger)intValue
 {
-	NSUInteger count;
-	if (ownerArray && (count = [ownerArray count])) {
+	if (entryCount) {
 		//If we have more than one object and the object we want is not already in the front of our arrays, 
 		//we need to find the object with largest int value and move it to the front
-		if (count != 1 && !valueIsSortedToFront) {
+		if (entryCount != 1 && !valueIsSortedToFront) {
 			NSInteger 	currentMax = 0;
-			int		indexOfMax = 0;
-			int		idx = 0;
+			NSUInteger	indexOfMax = 0;
 			
 			//Find the object with the largest int value
-			for (idx = 0;idx < count;idx++) {
-				NSInteger	value = [[contentArray objectAtIndex:idx] integerValue];
+			for (NSUInteger idx = 0; idx < entryCount; idx++) {
+				NSInteger	value = [entries[idx].object integerValue];
 				
 				if (value > currentMax) {
 					currentMax = value;
@@ -180,7 +174,7 @@
 			
 			return currentMax;
 		} else {
-			return [[contentArray objectAtIndex:0] integerValue];
+			return [entries[0].object integerValue];
 		}
 	}
 	return 0;
@@ -188,19 +182,17 @@
 
 - (double)doubleValue
 {
-	NSUInteger count;
-	if (ownerArray && (count = [ownerArray count])) {
+	if (entryCount) {
 		
 		//If we have more than one object and the object we want is not already in the front of our arrays, 
 		//we need to find the object with largest double value and move it to the front
-		if (count != 1 && !valueIsSortedToFront) {
-			double  currentMax = 0;
-			int		indexOfMax = 0;
-			int		idx = 0;
+		if (entryCount != 1 && !valueIsSortedToFront) {
+			double  	currentMax = 0;
+			NSUInteger	indexOfMax = 0;
 			
 			//Find the object with the largest double value
-			for (idx = 0;idx < count;idx++) {
-				double	value = [[contentArray objectAtIndex:idx] doubleValue];
+			for (NSUInteger idx = 0; idx < entryCount; idx++) {
+				double	value = [entries[idx].object doubleValue];
 				
 				if (value > currentMax) {
 					currentMax = value;
@@ -213,7 +205,7 @@
 			
 			return currentMax;
 		} else {
-			return [[contentArray objectAtIndex:0] doubleValue];
+			return [entries[0].object doubleValue];
 		}
 	}
 	
@@ -222,18 +214,16 @@
 
 - (NSDate *)date
 {
-	NSInteger count;
-	if (ownerArray && (count = [ownerArray count])) {
+	if (entryCount) {
 		//If we have more than one object and the object we want is not already in the front of our arrays, 
 		//we need to find the object with largest double value and move it to the front
-		if (count != 1 && !valueIsSortedToFront) {
-			NSDate  *currentMax = nil;
-			int		indexOfMax = 0;
-			int		idx = 0;
+		if (entryCount != 1 && !valueIsSortedToFront) {
+			NSDate  	*currentMax = nil;
+			NSUInteger	indexOfMax = 0;
 			
 			//Find the object with the earliest date
-			for (idx = 0;idx < count;idx++) {
-				NSDate	*value = [contentArray objectAtIndex:idx];
+			for (NSUInteger idx = 0; idx < entryCount; idx++) {
+				NSDate	*value = entries[idx].object;
 				
 				if (!currentMax || [currentMax timeIntervalSinceDate:value] > 0) {
 					currentMax = value;
@@ -246,7 +236,7 @@
 			
 			return currentMax;
 		} else {
-			return [contentArray objectAtIndex:0];
+			return entries[0].object;
 		}
 	}
 	return nil;
@@ -256,109 +246,157 @@
 {
 	//If we have more than one object and the object we want is not already in the front of our arrays, 
 	//we need to find the object with highest priority and move it to the front
-	if ([priorityArray count] != 1 && !valueIsSortedToFront) {
-		CGFloat			currentMax = Lowest_Priority;
-		int				indexOfMax = 0;
-		int				idx = 0;
+	if (entryCount != 1 && !valueIsSortedToFront) {
+		float			currentMax = Lowest_Priority;
+		NSUInteger		indexOfMax = 0;
 		
 		//Find the object with highest priority
-		for (NSNumber *priority in priorityArray) {
-			float	value = [priority floatValue];
-			if (value < currentMax) {
-				currentMax = value;
+		for (NSUInteger idx = 0; idx < entryCount; idx++) {
+			if (entries[idx].priority < currentMax) {
+				currentMax = entries[idx].priority;
 				indexOfMax = idx;
 			}
-			idx++;
 		}
 
 		//Move the object to the front, so we don't have to find it next time
 		[self _moveObjectToFront:indexOfMax];
 	}
 
-	return [contentArray objectAtIndex:0]; 
+	return entries[0].object; 
 }
 
-//Move an object to the front of our arrays
-- (void)_moveObjectToFront:(int)objectIndex
+//Move an object to the front of our entries. The winner of the last search stays at the front until something is set.
+- (void)_moveObjectToFront:(NSUInteger)objectIndex
 {
 	if (objectIndex != 0) {
-		[contentArray exchangeObjectAtIndex:objectIndex withObjectAtIndex:0];
-		[ownerArray exchangeObjectAtIndex:objectIndex withObjectAtIndex:0];
-		[priorityArray exchangeObjectAtIndex:objectIndex withObjectAtIndex:0];
+		AIMutableOwnerArrayEntry	front = entries[0];
+
+		entries[0] = entries[objectIndex];
+		entries[objectIndex] = front;
 	}
 	valueIsSortedToFront = YES;
 }
 
+/*!
+ * @brief Index of the entry for an owner, or NSNotFound
+ *
+ * Owners are compared with isEqual:, but nearly all are passed in as the same object each time, so that is tried first.
+ */
+- (NSUInteger)_indexOfOwner:(id)inOwner
+{
+	NSUInteger	idx;
+	
+	for (idx = 0; idx < entryCount; idx++) {
+		if (entries[idx].owner == inOwner) return idx;
+	}
+	for (idx = 0; idx < entryCount; idx++) {
+		if ([entries[idx].owner isEqual:inOwner]) return idx;
+	}
+	
+	return NSNotFound;
+}
+
+//Index of the first entry whose object isEqual: to inObject, or NSNotFound
+- (NSUInteger)_indexOfObject:(id)inObject
+{
+	for (NSUInteger idx = 0; idx < entryCount; idx++) {
+		if (entries[idx].object == inObject || [entries[idx].object isEqual:inObject]) return idx;
+	}
+	
+	return NSNotFound;
+}
 
 //Returns an object with the specified owner
 - (id)objectWithOwner:(id)inOwner
 {
-    if (ownerArray && contentArray) {
-        NSUInteger	idx = [ownerArray indexOfObject:inOwner];
-        if (idx != NSNotFound) return [contentArray objectAtIndex:idx];
-    }
-    
-    return nil;
+	NSUInteger	idx = [self _indexOfOwner:inOwner];
+	
+	return (idx != NSNotFound ? entries[idx].object : nil);
 }
 
 - (float)priorityOfObjectWithOwner:(id)inOwner
 {
-	if (ownerArray && priorityArray) {
-        NSUInteger	idx = [ownerArray indexOfObject:inOwner];
-		if (idx != NSNotFound) return [[priorityArray objectAtIndex:idx] floatValue];
-	}
-	return 0.0f;
+	NSUInteger	idx = [self _indexOfOwner:inOwner];
+	
+	return (idx != NSNotFound ? entries[idx].priority : 0.0f);
 }
 
 - (id)ownerWithObject:(id)inObject
 {
-    if (ownerArray && contentArray) {
-        NSUInteger	idx = [contentArray indexOfObject:inObject];
-        if (idx != NSNotFound) return [ownerArray objectAtIndex:idx];
-    }
-    
-    return nil;
+	NSUInteger	idx = [self _indexOfObject:inObject];
+	
+	return (idx != NSNotFound ? entries[idx].owner : nil);
 }
 
 - (float)priorityOfObject:(id)inObject
 {
-	if (contentArray && priorityArray) {
-        NSUInteger	idx = [contentArray indexOfObject:inObject];
-		if (idx != NSNotFound) return [[priorityArray objectAtIndex:idx] floatValue];
-	}
-	return 0.0f;
+	NSUInteger	idx = [self _indexOfObject:inObject];
+	
+	return (idx != NSNotFound ? entries[idx].priority : 0.0f);
 }
 
 - (NSEnumerator *)objectEnumerator
 {
-	return [contentArray objectEnumerator];
+	return [self.allValues objectEnumerator];
 }
 
-@synthesize allValues = contentArray;
+- (NSArray *)allValues
+{
+	NSMutableArray	*allValues = [NSMutableArray arrayWithCapacity:entryCount];
+	
+	for (NSUInteger i = 0; i < entryCount; i++) {
+		[allValues addObject:entries[i].object];
+	}
+	
+	return allValues;
+}
 
 - (NSUInteger)count
 {
-    return [contentArray count];
+    return entryCount;
 }
 
-//Array creation / Destruction -----------------------------------------------------------------------------------------
-#pragma mark Array creation / Destruction
-//We don't actually create our arrays until needed.  There are many places where a mutable owner array
-//is created and not actually used to store anything, so this saves us a bit of ram.
-//Create our storage arrays
-- (void)_createArrays
+//Entry storage --------------------------------------------------------------------------------------------------------
+#pragma mark Entry storage
+//Entries start out in inlineEntries, and move to the heap only when there are more than OWNER_ARRAY_INLINE_CAPACITY.
+//Order is kept as objects are removed, since the earliest of equally ranked objects is the one returned.
+
+- (void)_removeEntryAtIndex:(NSUInteger)idx
 {
-	contentArray = [[NSMutableArray alloc] init];
-	priorityArray = [[NSMutableArray alloc] init];
-	ownerArray = [[NSMutableArray alloc] init];
+	[entries[idx].owner release];
+	[entries[idx].object release];
+	
+	entryCount--;
+	if (idx < entryCount) memmove(&entries[idx], &entries[idx + 1], (entryCount - idx) * sizeof(AIMutableOwnerArrayEntry));
+	
+	//Back to inline storage once we fit again
+	if (entries != inlineEntries && entryCount <= OWNER_ARRAY_INLINE_CAPACITY) {
+		memcpy(inlineEntries, entries, entryCount * sizeof(AIMutableOwnerArrayEntry));
+		free(entries);
+		entries = inlineEntries;
+		entryCapacity = OWNER_ARRAY_INLINE_CAPACITY;
+	}
 }
 
-//Destroy our storage arrays
-- (void)_destroyArrays
+- (void)_addEntryWithOwner:(id)inOwner object:(id)anObject priority:(float)priority
 {
-	[contentArray release]; contentArray = nil;
-	[priorityArray release]; priorityArray = nil;
-	[ownerArray release]; ownerArray = nil;
+	if (entryCount == entryCapacity) {
+		NSUInteger	newCapacity = entryCapacity * 2;
+		
+		if (entries == inlineEntries) {
+			entries = malloc(newCapacity * sizeof(AIMutableOwnerArrayEntry));
+			memcpy(entries, inlineEntries, entryCount * sizeof(AIMutableOwnerArrayEntry));
+		} else {
+			entries = reallocf(entries, newCapacity * sizeof(AIMutableOwnerArrayEntry));
+		}
+		NSAssert(entries != NULL, @"Out of memory growing an owner array");
+		entryCapacity = newCapacity;
+	}
+	
+	entries[entryCount].owner = [inOwner retain];
+	entries[entryCount].object = [anObject retain];
+	entries[entryCount].priority = priority;
+	entryCount++;
 }
 
 //Delegation -----------------------------------------------------------------------------------------
@@ -377,7 +415,18 @@
 
 - (NSUInteger)countByEnumeratingWithState:(NSFastEnumerationState *)state objects:(id *)stackbuf count:(NSUInteger)len;
 {
-	return [contentArray countByEnumeratingWithState:state objects:stackbuf count:len];
+	NSUInteger	idx = state->state;
+	NSUInteger	returned = 0;
+	
+	state->itemsPtr = stackbuf;
+	state->mutationsPtr = &mutations;
+	
+	while (idx < entryCount && returned < len) {
+		stackbuf[returned++] = entries[idx++].object;
+	}
+	state->state = idx;
+	
+	return returned;
 }
 
 @end
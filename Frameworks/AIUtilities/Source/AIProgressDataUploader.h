@@ -39,6 +39,8 @@
 
 @interface AIProgressDataUploader : NSObject {
 	NSData									*uploadData;
+	NSInputStream							*uploadStream;
+	unsigned long long						uploadLength;
 	NSURL									*url;
 	NSDictionary							*headers;
 	id <AIProgressDataUploaderDelegate>		delegate;
@@ -60,6 +62,13 @@
 				  delegate:(id <AIProgressDataUploaderDelegate>)delegate
 				   context:(id)context;
 
++ (id)dataUploaderWithStream:(NSInputStream *)uploadStream
+					  length:(unsigned long long)length
+						 URL:(NSURL *)url
+					 headers:(NSDictionary *)headers
+					delegate:(id <AIProgressDataUploaderDelegate>)delegate
+					 context:(id)context;
+
 - (void)upload;
 - (void)cancel;
 
@@ -81,6 +81,29 @@ static void AIProgressDataUploaderCallback(CFReadStreamRef callbackStream,
 	return [[[self alloc] initWithData:uploadData URL:url headers:headers delegate:delegate context:context] autorelease];
 }
 
+/*!
+ * @brief Create a data uploader which sends the body from a stream
+ *
+ * @param uploadStream The body, which is read as it is sent, so it needn't be held in memory
+ * @param length The length of the body, sent as the Content-Length
+ *
+ * Uploading does not begin until -upload is called.
+ */
++ (id)dataUploaderWithStream:(NSInputStream *)uploadStream
+					  length:(unsigned long long)length
+						 URL:(NSURL *)url
+					 headers:(NSDictionary *)headers
+					delegate:(id <AIProgressDataUploaderDelegate>)delegate
+					 context:(id)context
+{
+	AIProgressDataUploader *dataUploader = [[[self alloc] initWithData:nil URL:url headers:headers delegate:delegate context:context] autorelease];
+
+	dataUploader->uploadStream = [uploadStream retain];
+	dataUploader->uploadLength = length;
+
+	return dataUploader;
+}
+
 - (id)initWithData:(NSData *)inUploadData
 			   URL:(NSURL *)inURL
 		   headers:(NSDictionary *)inHeaders
@@ -103,6 +126,7 @@ static void AIProgressDataUploaderCallback(CFReadStreamRef callbackStream,
 	[url release]; url = nil;
 	[headers release]; headers = nil;
 	[uploadData release]; uploadData = nil;
+	[uploadStream release]; uploadStream = nil;
 	[returnedData release]; returnedData = nil;
 	
 	[super dealloc];
@@ -126,9 +150,18 @@ static void AIProgressDataUploaderCallback(CFReadStreamRef callbackStream,
 										 (CFStringRef)[headers objectForKey:headerKey]);
 	}
 	
-	CFHTTPMessageSetBody(httpRequest, (CFDataRef)uploadData);
-	
-	stream = CFReadStreamCreateForHTTPRequest(kCFAllocatorDefault, httpRequest);
+	if (uploadStream) {
+		//Without a length the body would be sent chunked, which upload services don't all accept
+		CFHTTPMessageSetHeaderFieldValue(httpRequest,
+										 CFSTR("Content-Length"),
+										 (CFStringRef)[NSString stringWithFormat:@"%llu", uploadLength]);
+		
+		stream = CFReadStreamCreateForStreamedHTTPRequest(kCFAllocatorDefault, httpRequest, (CFReadStreamRef)uploadStream);
+	} else {
+		CFHTTPMessageSetBody(httpRequest, (CFDataRef)uploadData);
+		
+		stream = CFReadStreamCreateForHTTPRequest(kCFAllocatorDefault, httpRequest);
+	}
 	
 	CFStreamClientContext streamClientContext = {
 		0,
@@ -194,7 +227,7 @@ static void AIProgressDataUploaderCallback(CFReadStreamRef callbackStream,
  */
 - (void)streamDidOpen
 {
-	totalSize = [uploadData length];
+	totalSize = (uploadStream ? (NSInteger)uploadLength : (NSInteger)[uploadData length]);
 	
 	periodicTimer = [[NSTimer scheduledTimerWithTimeInterval:UPDATE_INTERVAL
 													  target:self
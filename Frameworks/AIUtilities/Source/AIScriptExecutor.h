@@ -0,0 +1,50 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*!
+ * @protocol AIScriptExecutor
+ * @brief Something which can run a script file, optionally calling a function in it with arguments
+ *
+ * AdiumApplescriptRunner runs AppleScripts this way; AIShellScriptExecutor runs shell scripts, which is useful where
+ * AppleScript isn't available, such as in tests.
+ */
+@protocol AIScriptExecutor <NSObject>
+
+/*!
+ * @brief Run a script and notify a target of its result
+ *
+ * @param selector A selector of the form scriptDidRun:resultString:, performed on target with userInfo and the
+ *                 script's result, or nil if it failed. It is always performed on the main thread.
+ */
+- (void)runScriptAtPath:(NSString *)path
+			   function:(NSString *)function
+			  arguments:(NSArray *)arguments
+		notifyingTarget:(id)target
+			   selector:(SEL)selector
+			   userInfo:(id)userInfo;
+
+@optional
+/*!
+ * @brief Give up on a script run with a given userInfo; its target need not be notified
+ */
+- (void)cancelScriptWithUserInfo:(id)userInfo;
+
+/*!
+ * @brief Keep any worker process running, as scripts are expected soon
+ */
+- (void)keepAlive;
+
+@end
@@ -0,0 +1,89 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <AIUtilities/AIScriptExecutor.h>
+
+/*!
+ * @class AIScriptExecutorPool
+ * @brief Queues script runs across a set of long-lived executors, with timeouts and cached results
+ *
+ * Each executor runs a fixed number of scripts at a time, one unless the pool was created with more; further
+ * requests wait in order for the next free executor. A request with a timeout notifies its target with a nil result
+ * if its script hasn't finished in time, whether it was still waiting or running, and a running script's executor is
+ * freed for the next request. Results of requests marked cacheable, for scripts which always give the same result for
+ * the same arguments, are remembered until -flushCachedResults.
+ *
+ * While requests are waiting or running, and for one keep-alive interval after the last of them, executors which
+ * support it are periodically asked to keep their workers running, so a script doesn't have to wait for one to launch
+ * again. Call -invalidate when done with the pool.
+ *
+ * Main thread only. Targets are always notified asynchronously, even for cached results.
+ */
+@interface AIScriptExecutorPool : NSObject {
+	NSArray				*executors;
+	NSMutableArray		*idleExecutors;
+	NSMutableArray		*pendingRequests;
+	NSMutableSet		*runningRequests;
+	NSMutableDictionary	*cachedResults;
+	NSUInteger			maximumCachedResults;
+
+	NSTimer				*keepAliveTimer;
+	NSTimeInterval		keepAliveInterval;
+	BOOL				usedSinceKeepAlive;
+}
+
+/*!
+ * @param inExecutors Objects conforming to AIScriptExecutor, each running one script at a time
+ */
+- (id)initWithExecutors:(NSArray *)inExecutors;
+
+/*!
+ * @param inExecutors Objects conforming to AIScriptExecutor
+ * @param requestsPerExecutor How many scripts each executor is given at once
+ */
+- (id)initWithExecutors:(NSArray *)inExecutors requestsPerExecutor:(NSUInteger)requestsPerExecutor;
+
+/*!
+ * @brief Run a script on the next free executor
+ *
+ * @param cacheable YES if the script gives the same result every time for the same function and arguments
+ * @param timeout Seconds to wait for the result from now, including any wait for a free executor, or 0 to wait indefinitely
+ * @param target Notified as for -[AIScriptExecutor runScriptAtPath:function:arguments:notifyingTarget:selector:userInfo:]; may be nil
+ */
+- (void)runScriptAtPath:(NSString *)path
+			   function:(NSString *)function
+			  arguments:(NSArray *)arguments
+			  cacheable:(BOOL)cacheable
+				timeout:(NSTimeInterval)timeout
+		notifyingTarget:(id)target
+			   selector:(SEL)selector
+			   userInfo:(id)userInfo;
+
+/*!
+ * @brief Forget all cached results, such as when the scripts may have changed
+ */
+- (void)flushCachedResults;
+
+/*!
+ * @brief Stop keeping executors alive. Pending and running requests still finish.
+ */
+- (void)invalidate;
+
+@property (readonly, nonatomic) NSArray *executors;
+@property (readwrite, nonatomic) NSUInteger maximumCachedResults;
+@property (readwrite, nonatomic) NSTimeInterval keepAliveInterval;
+
+@end
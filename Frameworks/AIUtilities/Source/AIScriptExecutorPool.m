@@ -0,0 +1,314 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIScriptExecutorPool.h"
+
+//Ask executors to keep their workers up this often; AdiumApplescriptRunner's quits after ten idle minutes
+#define DEFAULT_KEEP_ALIVE_INTERVAL		300
+#define DEFAULT_MAXIMUM_CACHED_RESULTS	64
+
+/*!
+ * @class AIScriptRequest
+ * @brief One script run, from being queued until its target is notified
+ */
+@interface AIScriptRequest : NSObject {
+@public
+	NSString				*path;
+	NSString				*function;
+	NSArray					*arguments;
+	BOOL					cacheable;
+
+	id						target;
+	SEL						selector;
+	id						userInfo;
+
+	id <AIScriptExecutor>	executor;
+	NSTimer					*timeoutTimer;
+	NSString				*result;
+}
+- (NSString *)cacheKey;
+@end
+
+@implementation AIScriptRequest
+
+- (void)dealloc
+{
+	[path release];
+	[function release];
+	[arguments release];
+	[target release];
+	[userInfo release];
+	[executor release];
+	[timeoutTimer release];
+	[result release];
+
+	[super dealloc];
+}
+
+/*!
+ * @brief A key for the cache which can't be the same for two different requests
+ */
+- (NSString *)cacheKey
+{
+	NSMutableString *key = [NSMutableString string];
+
+	[key appendFormat:@"%lu:%@%lu:%@", (unsigned long)path.length, path, (unsigned long)function.length, (function ? function : @"")];
+	for (NSString *argument in arguments) {
+		[key appendFormat:@"%lu:%@", (unsigned long)argument.length, argument];
+	}
+
+	return key;
+}
+
+@end
+
+#pragma mark -
+
+@interface AIScriptExecutorPool ()
+- (void)_startPendingRequests;
+- (void)_finishRequest:(AIScriptRequest *)request withResult:(NSString *)result;
+- (void)_notifyTargetOfRequest:(AIScriptRequest *)request;
+- (void)_deliverCachedResult:(AIScriptRequest *)request;
+- (void)_requestTimedOut:(NSTimer *)timer;
+- (void)requestDidRun:(AIScriptRequest *)request resultString:(NSString *)resultString;
+- (void)_keepExecutorsAlive:(NSTimer *)timer;
+@end
+
+@implementation AIScriptExecutorPool
+
+- (id)initWithExecutors:(NSArray *)inExecutors
+{
+	return [self initWithExecutors:inExecutors requestsPerExecutor:1];
+}
+
+- (id)initWithExecutors:(NSArray *)inExecutors requestsPerExecutor:(NSUInteger)requestsPerExecutor
+{
+	if ((self = [super init])) {
+		executors = [inExecutors copy];
+
+		//An executor is listed once for each request it can take
+		idleExecutors = [[NSMutableArray alloc] initWithCapacity:(inExecutors.count * requestsPerExecutor)];
+		for (NSUInteger i = 0; i < requestsPerExecutor; i++) {
+			[idleExecutors addObjectsFromArray:inExecutors];
+		}
+
+		pendingRequests = [[NSMutableArray alloc] init];
+		runningRequests = [[NSMutableSet alloc] init];
+		cachedResults = [[NSMutableDictionary alloc] init];
+		maximumCachedResults = DEFAULT_MAXIMUM_CACHED_RESULTS;
+		keepAliveInterval = DEFAULT_KEEP_ALIVE_INTERVAL;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[self invalidate];
+
+	[executors release];
+	[idleExecutors release];
+	[pendingRequests release];
+	[runningRequests release];
+	[cachedResults release];
+
+	[super dealloc];
+}
+
+@synthesize executors, maximumCachedResults, keepAliveInterval;
+
+- (void)runScriptAtPath:(NSString *)path
+			   function:(NSString *)function
+			  arguments:(NSArray *)arguments
+			  cacheable:(BOOL)cacheable
+				timeout:(NSTimeInterval)timeout
+		notifyingTarget:(id)target
+			   selector:(SEL)selector
+			   userInfo:(id)userInfo
+{
+	AIScriptRequest *request = [[AIScriptRequest alloc] init];
+
+	request->path = [path copy];
+	request->function = [function copy];
+	request->arguments = [arguments copy];
+	request->cacheable = cacheable;
+	request->target = [target retain];
+	request->selector = selector;
+	request->userInfo = [userInfo retain];
+
+	NSString *cachedResult = (cacheable ? [cachedResults objectForKey:[request cacheKey]] : nil);
+
+	if (cachedResult) {
+		request->result = [cachedResult retain];
+		[self performSelector:@selector(_deliverCachedResult:) withObject:request afterDelay:0];
+
+	} else {
+		//The timeout runs from now, so a request can't be held up indefinitely behind others without one
+		if (timeout > 0) {
+			request->timeoutTimer = [[NSTimer scheduledTimerWithTimeInterval:timeout
+																	  target:self
+																	selector:@selector(_requestTimedOut:)
+																	userInfo:request
+																	 repeats:NO] retain];
+		}
+
+		[pendingRequests addObject:request];
+		[self _startPendingRequests];
+
+		usedSinceKeepAlive = YES;
+		if (!keepAliveTimer && keepAliveInterval > 0) {
+			keepAliveTimer = [[NSTimer scheduledTimerWithTimeInterval:keepAliveInterval
+															   target:self
+															 selector:@selector(_keepExecutorsAlive:)
+															 userInfo:nil
+															  repeats:YES] retain];
+		}
+	}
+
+	[request release];
+}
+
+/*!
+ * @brief Hand waiting requests to free executors, oldest first
+ */
+- (void)_startPendingRequests
+{
+	while (idleExecutors.count && pendingRequests.count) {
+		AIScriptRequest *request = [[pendingRequests objectAtIndex:0] retain];
+		[pendingRequests removeObjectAtIndex:0];
+
+		request->executor = [[idleExecutors lastObject] retain];
+		[idleExecutors removeLastObject];
+		[runningRequests addObject:request];
+
+		[request->executor runScriptAtPath:request->path
+								  function:request->function
+								 arguments:request->arguments
+						   notifyingTarget:self
+								  selector:@selector(requestDidRun:resultString:)
+								  userInfo:request];
+		[request release];
+	}
+}
+
+/*!
+ * @brief An executor finished a script
+ */
+- (void)requestDidRun:(AIScriptRequest *)request resultString:(NSString *)resultString
+{
+	//Requests which timed out have already been answered
+	if (![runningRequests containsObject:request]) return;
+
+	[self _finishRequest:request withResult:resultString];
+}
+
+/*!
+ * @brief A request's timeout passed, either while it ran or while it was still waiting for an executor
+ */
+- (void)_requestTimedOut:(NSTimer *)timer
+{
+	AIScriptRequest *request = [[[timer userInfo] retain] autorelease];
+
+	if ([pendingRequests indexOfObjectIdenticalTo:request] != NSNotFound) {
+		[request->timeoutTimer release]; request->timeoutTimer = nil;
+		[pendingRequests removeObjectIdenticalTo:request];
+
+		[self _notifyTargetOfRequest:request];
+		return;
+	}
+
+	if (![runningRequests containsObject:request]) return;
+
+	if ([request->executor respondsToSelector:@selector(cancelScriptWithUserInfo:)])
+		[request->executor cancelScriptWithUserInfo:request];
+
+	[self _finishRequest:request withResult:nil];
+}
+
+/*!
+ * @brief Free the request's executor for the next request, then notify the request's target
+ */
+- (void)_finishRequest:(AIScriptRequest *)request withResult:(NSString *)result
+{
+	[request retain];
+
+	[request->timeoutTimer invalidate];
+	[request->timeoutTimer release]; request->timeoutTimer = nil;
+
+	[runningRequests removeObject:request];
+	[idleExecutors addObject:request->executor];
+	[request->executor release]; request->executor = nil;
+
+	if (request->cacheable && result) {
+		if (cachedResults.count >= maximumCachedResults) [cachedResults removeAllObjects];
+		[cachedResults setObject:result forKey:[request cacheKey]];
+	}
+
+	[request->result release]; request->result = [result retain];
+
+	[self _startPendingRequests];
+	[self _notifyTargetOfRequest:request];
+
+	[request release];
+}
+
+- (void)_deliverCachedResult:(AIScriptRequest *)request
+{
+	[self _notifyTargetOfRequest:request];
+}
+
+- (void)_notifyTargetOfRequest:(AIScriptRequest *)request
+{
+	if (request->target && request->selector) {
+		[request->target performSelector:request->selector
+							  withObject:request->userInfo
+							  withObject:request->result];
+	}
+}
+
+- (void)flushCachedResults
+{
+	[cachedResults removeAllObjects];
+}
+
+/*!
+ * @brief Keep executors' workers running while there is work, and for one interval after
+ *
+ * Once a whole interval passes with nothing waiting, running or requested, the timer stops, so that workers which
+ * quit when idle, such as AdiumApplescriptRunner, can do so. The next request starts it again.
+ */
+- (void)_keepExecutorsAlive:(NSTimer *)timer
+{
+	if (!usedSinceKeepAlive && !pendingRequests.count && !runningRequests.count) {
+		[self invalidate];
+		return;
+	}
+
+	usedSinceKeepAlive = NO;
+
+	for (id <AIScriptExecutor> executor in executors) {
+		if ([executor respondsToSelector:@selector(keepAlive)])
+			[executor keepAlive];
+	}
+}
+
+- (void)invalidate
+{
+	[keepAliveTimer invalidate];
+	[keepAliveTimer release]; keepAliveTimer = nil;
+}
+
+@end
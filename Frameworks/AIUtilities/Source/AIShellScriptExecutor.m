@@ -0,0 +1,113 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIShellScriptExecutor.h"
+
+#define KEY_TASK		@"Task"
+#define KEY_USER_INFO	@"UserInfo"
+
+@implementation AIShellScriptExecutor
+
+- (id)init
+{
+	if ((self = [super init])) {
+		runningTasks = [[NSMutableArray alloc] init];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	for (NSDictionary *taskDict in runningTasks) {
+		[[taskDict objectForKey:KEY_TASK] terminate];
+	}
+	[runningTasks release];
+
+	[super dealloc];
+}
+
+- (void)runScriptAtPath:(NSString *)path
+			   function:(NSString *)function
+			  arguments:(NSArray *)arguments
+		notifyingTarget:(id)target
+			   selector:(SEL)selector
+			   userInfo:(id)userInfo
+{
+	NSTask			*task = [[[NSTask alloc] init] autorelease];
+	NSPipe			*outputPipe = [NSPipe pipe];
+	NSMutableArray	*taskArguments = [NSMutableArray arrayWithObjects:path, (function ? function : @""), nil];
+	NSDictionary	*taskDict = [NSDictionary dictionaryWithObjectsAndKeys:task, KEY_TASK, userInfo, KEY_USER_INFO, nil];
+
+	if (arguments) [taskArguments addObjectsFromArray:arguments];
+
+	[task setLaunchPath:@"/bin/sh"];
+	[task setArguments:taskArguments];
+	[task setStandardOutput:outputPipe];
+	[task setStandardError:[NSFileHandle fileHandleWithNullDevice]];
+
+	@try {
+		[task launch];
+	} @catch (NSException *exception) {
+		NSLog(@"Could not run %@: %@", path, exception);
+		if (target && selector) {
+			dispatch_async(dispatch_get_main_queue(), ^{
+				[target performSelector:selector withObject:userInfo withObject:nil];
+			});
+		}
+		return;
+	}
+
+	[runningTasks addObject:taskDict];
+
+	//Read the output off the main thread; the task can't exit until its output has been read
+	[target retain];
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		NSData *output = [[outputPipe fileHandleForReading] readDataToEndOfFile];
+		[task waitUntilExit];
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			//A cancelled script's target is not notified
+			if ([runningTasks indexOfObjectIdenticalTo:taskDict] != NSNotFound) {
+				NSString *result = nil;
+
+				[runningTasks removeObjectIdenticalTo:taskDict];
+
+				if ([task terminationStatus] == 0) {
+					result = [[[NSString alloc] initWithData:output encoding:NSUTF8StringEncoding] autorelease];
+					if ([result hasSuffix:@"\n"]) result = [result substringToIndex:result.length - 1];
+				}
+
+				if (target && selector)
+					[target performSelector:selector withObject:userInfo withObject:result];
+			}
+
+			[target release];
+		});
+	});
+}
+
+- (void)cancelScriptWithUserInfo:(id)userInfo
+{
+	for (NSDictionary *taskDict in [[runningTasks copy] autorelease]) {
+		if ([taskDict objectForKey:KEY_USER_INFO] == userInfo) {
+			[[taskDict objectForKey:KEY_TASK] terminate];
+			[runningTasks removeObjectIdenticalTo:taskDict];
+		}
+	}
+}
+
+@end
@@ -0,0 +1,154 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+@class AITimerWheel, AIWheelTimer;
+
+//Slots per level and levels in the wheel; AI_TIMER_WHEEL_SLOTS^AI_TIMER_WHEEL_LEVELS ticks is the longest exact delay
+#define AI_TIMER_WHEEL_SLOT_BITS	6
+#define AI_TIMER_WHEEL_SLOTS		(1 << AI_TIMER_WHEEL_SLOT_BITS)
+#define AI_TIMER_WHEEL_LEVELS		4
+
+typedef struct {
+	AIWheelTimer	*head;
+	AIWheelTimer	*tail;
+} AITimerWheelSlot;
+
+/*!
+ * @class AIWheelTimer
+ * @brief A timer on an AITimerWheel, and the token for cancelling or moving it
+ *
+ * Like an NSTimer, a wheel timer retains its target and userInfo until it is invalidated, and a non-repeating timer
+ * invalidates itself after firing unless it was rescheduled while it fired.
+ */
+@interface AIWheelTimer : NSObject {
+@public
+	AITimerWheel		*wheel;			//Not retained; the wheel retains us while we are scheduled
+	AIWheelTimer		*previous;
+	AIWheelTimer		*next;
+	AITimerWheelSlot	*slot;			//The list we are in, or NULL
+
+	uint64_t			dueTick;
+	uint64_t			repeatTicks;	//0 if not repeating
+
+	id					target;
+	SEL					selector;
+	id					userInfo;
+	void				(^block)(AIWheelTimer *timer);
+	BOOL				valid;
+}
+
+/*!
+ * @brief Move the timer to fire delay seconds from now
+ *
+ * Cheaper than invalidating and creating a new timer; has no effect on an invalidated timer.
+ */
+- (void)rescheduleAfterDelay:(NSTimeInterval)delay;
+
+/*!
+ * @brief Stop the timer from ever firing again, and release its target and userInfo
+ */
+- (void)invalidate;
+
+@property (readonly, nonatomic) BOOL isValid;
+@property (readonly, nonatomic) id userInfo;
+@property (readonly, nonatomic) NSTimeInterval repeatInterval;
+
+@end
+
+/*!
+ * @class AITimerWheel
+ * @brief Many timers on one dispatch timer source
+ *
+ * Timers are kept in a hierarchical timing wheel: AI_TIMER_WHEEL_LEVELS levels of AI_TIMER_WHEEL_SLOTS slots, each
+ * level's slots AI_TIMER_WHEEL_SLOTS times as long as the level below's. Scheduling, rescheduling and invalidating a
+ * timer are O(1) list operations; timers move down a level at most AI_TIMER_WHEEL_LEVELS - 1 times before firing.
+ *
+ * Time is counted in ticks. A timer fires on the first tick at or after its fire time, along with every other timer
+ * due on that tick, so timers set close together share a wakeup. The dispatch source is only armed for the next tick
+ * which has work to do.
+ *
+ * A wheel, and its timers, must only be used on the wheel's queue; the shared wheel's is the main queue.
+ *
+ * A wheel created with a virtual clock never fires on its own. Its time only moves when -advanceTimeBy: is called,
+ * which makes tests and benchmarks deterministic.
+ */
+@interface AITimerWheel : NSObject {
+	NSTimeInterval		tickInterval;
+	uint64_t			currentTick;
+	AITimerWheelSlot	slots[AI_TIMER_WHEEL_LEVELS][AI_TIMER_WHEEL_SLOTS];
+	uint64_t			occupiedSlots[AI_TIMER_WHEEL_LEVELS];	//Bit n is set if slot n of the level has timers
+	NSUInteger			timerCount;
+	BOOL				firing;
+
+	//Real time
+	dispatch_queue_t	queue;
+	dispatch_source_t	source;
+	uint64_t			startMachTime;
+	uint64_t			armedTick;			//UINT64_MAX if the source isn't armed
+
+	//Virtual time
+	BOOL				usesVirtualClock;
+	NSTimeInterval		virtualTime;
+}
+
+/*!
+ * @brief The wheel for timers on the main thread, ticking every 10ms
+ */
++ (AITimerWheel *)sharedTimerWheel;
+
+/*!
+ * @brief A wheel firing its timers on queue, every tickInterval seconds at most
+ */
+- (id)initWithTickInterval:(NSTimeInterval)inTickInterval queue:(dispatch_queue_t)inQueue;
+
+/*!
+ * @brief A wheel whose time only moves when -advanceTimeBy: is called
+ */
+- (id)initWithVirtualClockAndTickInterval:(NSTimeInterval)inTickInterval;
+
+/*!
+ * @brief Move a virtual clock forward, firing every timer which comes due, in order
+ */
+- (void)advanceTimeBy:(NSTimeInterval)interval;
+
+/*!
+ * @brief Seconds since the wheel was created, on its own clock
+ *
+ * While a virtual clock fires timers, this is the time of the tick being fired.
+ */
+@property (readonly, nonatomic) NSTimeInterval currentTime;
+@property (readonly, nonatomic) NSTimeInterval tickInterval;
+@property (readonly, nonatomic) NSUInteger timerCount;
+
+/*!
+ * @brief Schedule a timer which sends selector to target, with the timer as the argument
+ *
+ * @param repeatInterval If more than 0, the timer fires again every repeatInterval seconds until invalidated
+ */
+- (AIWheelTimer *)scheduleTimerWithDelay:(NSTimeInterval)delay
+						  repeatInterval:(NSTimeInterval)repeatInterval
+								  target:(id)target
+								selector:(SEL)selector
+								userInfo:(id)userInfo;
+
+/*!
+ * @brief Schedule a timer which runs a block, with the timer as the argument
+ */
+- (AIWheelTimer *)scheduleTimerWithDelay:(NSTimeInterval)delay
+						  repeatInterval:(NSTimeInterval)repeatInterval
+								   block:(void (^)(AIWheelTimer *timer))block;
+
+@end
@@ -0,0 +1,431 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <AIUtilities/AITimerWheel.h>
+#import <mach/mach_time.h>
+
+#define SHARED_TICK_INTERVAL	0.01
+#define TICK_ROUNDING_ALLOWANCE	1e-6
+
+//Ticks covered by each level's slots, and by the whole wheel
+#define LEVEL_SPAN(level)		(1ULL << (AI_TIMER_WHEEL_SLOT_BITS * (level)))
+#define WHEEL_SPAN				LEVEL_SPAN(AI_TIMER_WHEEL_LEVELS)
+#define SLOT_MASK				(AI_TIMER_WHEEL_SLOTS - 1)
+
+static inline uint64_t rotateRight(uint64_t bits, unsigned count)
+{
+	count &= 63;
+	return (count ? ((bits >> count) | (bits << (64 - count))) : bits);
+}
+
+@interface AITimerWheel ()
+- (uint64_t)tickForDelay:(NSTimeInterval)delay;
+- (void)linkTimer:(AIWheelTimer *)timer;
+- (void)unlinkTimer:(AIWheelTimer *)timer;
+- (void)timerWasInvalidated:(AIWheelTimer *)timer;
+- (uint64_t)nextEventTick;
+- (void)fireTimer:(AIWheelTimer *)timer;
+- (void)runUntilTick:(uint64_t)targetTick;
+- (void)armSource;
+@end
+
+@implementation AIWheelTimer
+
+- (void)dealloc
+{
+	[target release];
+	[userInfo release];
+	[block release];
+
+	[super dealloc];
+}
+
+- (BOOL)isValid
+{
+	return valid;
+}
+
+- (id)userInfo
+{
+	return userInfo;
+}
+
+- (NSTimeInterval)repeatInterval
+{
+	return repeatTicks * wheel.tickInterval;
+}
+
+- (void)rescheduleAfterDelay:(NSTimeInterval)delay
+{
+	if (!valid) return;
+
+	[self retain];
+	[wheel unlinkTimer:self];
+	dueTick = [wheel tickForDelay:delay];
+	[wheel linkTimer:self];
+	[self release];
+}
+
+- (void)invalidate
+{
+	if (!valid) return;
+
+	//Our target may own us; stay alive until we're done
+	[self retain];
+	valid = NO;
+
+	[wheel unlinkTimer:self];
+	[wheel timerWasInvalidated:self];
+	wheel = nil;
+
+	[target release]; target = nil;
+	[userInfo release]; userInfo = nil;
+	[block release]; block = nil;
+	[self release];
+}
+
+- (NSString *)description
+{
+	return [NSString stringWithFormat:@"<%@:%p tick %llu%@>", NSStringFromClass([self class]), self, dueTick,
+			(valid ? @"" : @" invalid")];
+}
+
+@end
+
+@implementation AITimerWheel
+
++ (AITimerWheel *)sharedTimerWheel
+{
+	static AITimerWheel		*sharedTimerWheel = nil;
+	static dispatch_once_t	onceToken;
+
+	dispatch_once(&onceToken, ^{
+		sharedTimerWheel = [[AITimerWheel alloc] initWithTickInterval:SHARED_TICK_INTERVAL
+																queue:dispatch_get_main_queue()];
+	});
+
+	return sharedTimerWheel;
+}
+
+- (id)initWithTickInterval:(NSTimeInterval)inTickInterval queue:(dispatch_queue_t)inQueue
+{
+	if ((self = [super init])) {
+		tickInterval = inTickInterval;
+		armedTick = UINT64_MAX;
+		startMachTime = mach_absolute_time();
+
+		queue = inQueue;
+		dispatch_retain(queue);
+
+		//The source must not retain us, or we'd never be released
+		__block AITimerWheel *wheel = self;
+		source = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, queue);
+		dispatch_source_set_timer(source, DISPATCH_TIME_FOREVER, 0, 0);
+		dispatch_source_set_event_handler(source, ^{
+			wheel->armedTick = UINT64_MAX;
+			[wheel runUntilTick:(uint64_t)floor(wheel.currentTime / wheel->tickInterval)];
+			[wheel armSource];
+		});
+		dispatch_resume(source);
+	}
+
+	return self;
+}
+
+- (id)initWithVirtualClockAndTickInterval:(NSTimeInterval)inTickInterval
+{
+	if ((self = [super init])) {
+		tickInterval = inTickInterval;
+		armedTick = UINT64_MAX;
+		usesVirtualClock = YES;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	AIWheelTimer	*timer;
+	unsigned		level, index;
+
+	//Timers may outlive us; leave them invalid rather than pointing at freed memory
+	for (level = 0; level < AI_TIMER_WHEEL_LEVELS; level++) {
+		for (index = 0; index < AI_TIMER_WHEEL_SLOTS; index++) {
+			while ((timer = slots[level][index].head)) {
+				[timer invalidate];
+			}
+		}
+	}
+
+	if (source) {
+		dispatch_source_cancel(source);
+		dispatch_release(source);
+	}
+	if (queue) dispatch_release(queue);
+
+	[super dealloc];
+}
+
+@synthesize tickInterval, timerCount;
+
+- (NSTimeInterval)currentTime
+{
+	//A virtual clock reads as the tick being fired, so timers see the time they were due
+	if (usesVirtualClock) return (firing ? currentTick * tickInterval : virtualTime);
+
+	static mach_timebase_info_data_t timebase;
+	if (timebase.denom == 0) mach_timebase_info(&timebase);
+
+	return (double)(mach_absolute_time() - startMachTime) * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+#pragma mark Scheduling
+
+- (AIWheelTimer *)scheduleTimerWithDelay:(NSTimeInterval)delay
+						  repeatInterval:(NSTimeInterval)repeatInterval
+								  target:(id)target
+								selector:(SEL)selector
+								userInfo:(id)userInfo
+{
+	AIWheelTimer *timer = [[AIWheelTimer alloc] init];
+
+	timer->wheel = self;
+	timer->target = [target retain];
+	timer->selector = selector;
+	timer->userInfo = [userInfo retain];
+	timer->repeatTicks = (repeatInterval > 0 ? MAX((uint64_t)ceil(repeatInterval / tickInterval), 1) : 0);
+	timer->valid = YES;
+	timer->dueTick = [self tickForDelay:delay];
+
+	timerCount++;
+	[self linkTimer:timer];
+
+	return [timer autorelease];
+}
+
+- (AIWheelTimer *)scheduleTimerWithDelay:(NSTimeInterval)delay
+						  repeatInterval:(NSTimeInterval)repeatInterval
+								   block:(void (^)(AIWheelTimer *timer))block
+{
+	AIWheelTimer *timer = [self scheduleTimerWithDelay:delay repeatInterval:repeatInterval target:nil selector:NULL userInfo:nil];
+	timer->block = [block copy];
+
+	return timer;
+}
+
+/*!
+ * @brief The first tick at or after delay seconds from now, and always after the current tick
+ */
+- (uint64_t)tickForDelay:(NSTimeInterval)delay
+{
+	NSTimeInterval	now = self.currentTime;
+	uint64_t		nowTick = (uint64_t)floor(now / tickInterval + TICK_ROUNDING_ALLOWANCE);
+
+	/* An idle real-time wheel's current tick falls behind the clock. Until the next event it can safely be moved
+	 * forward, which keeps new timers on the lower levels.
+	 */
+	if (nowTick > currentTick && !firing && [self nextEventTick] > nowTick)
+		currentTick = nowTick;
+
+	//Allow for rounding error, so a delay of a whole number of ticks is exactly that many ticks
+	double		due = ceil((now + MAX(delay, 0)) / tickInterval - TICK_ROUNDING_ALLOWANCE);
+	uint64_t	dueTick = (due >= (double)UINT64_MAX ? UINT64_MAX : (uint64_t)due);
+
+	return MAX(dueTick, currentTick + 1);
+}
+
+#pragma mark Slots
+
+/*!
+ * @brief Put a timer in the slot where it belongs relative to the current tick
+ *
+ * A timer due on the current tick, which only happens while cascading, goes in the level 0 slot about to fire.
+ * Timers beyond the end of the wheel wait in the last slot it covers and are placed again when that slot cascades.
+ */
+- (void)linkTimer:(AIWheelTimer *)timer
+{
+	uint64_t	placement = MIN(timer->dueTick, currentTick + WHEEL_SPAN - 1);
+	uint64_t	delta = (placement > currentTick ? placement - currentTick : 0);
+	unsigned	level = 0;
+
+	while (delta >= LEVEL_SPAN(level + 1)) level++;
+
+	unsigned			index = (unsigned)(placement >> (AI_TIMER_WHEEL_SLOT_BITS * level)) & SLOT_MASK;
+	AITimerWheelSlot	*slot = &slots[level][index];
+
+	[timer retain];
+	timer->slot = slot;
+	timer->next = nil;
+	timer->previous = slot->tail;
+	if (slot->tail) {
+		slot->tail->next = timer;
+	} else {
+		slot->head = timer;
+		occupiedSlots[level] |= (1ULL << index);
+	}
+	slot->tail = timer;
+
+	if (!usesVirtualClock && !firing && placement < armedTick) [self armSource];
+}
+
+- (void)unlinkTimer:(AIWheelTimer *)timer
+{
+	AITimerWheelSlot *slot = timer->slot;
+	if (!slot) return;
+
+	if (timer->previous) timer->previous->next = timer->next;
+	else slot->head = timer->next;
+	if (timer->next) timer->next->previous = timer->previous;
+	else slot->tail = timer->previous;
+
+	if (!slot->head) {
+		ptrdiff_t position = slot - &slots[0][0];
+		occupiedSlots[position / AI_TIMER_WHEEL_SLOTS] &= ~(1ULL << (position % AI_TIMER_WHEEL_SLOTS));
+	}
+
+	timer->slot = NULL;
+	timer->previous = timer->next = nil;
+	[timer release];
+}
+
+- (void)timerWasInvalidated:(AIWheelTimer *)timer
+{
+	timerCount--;
+}
+
+#pragma mark Firing
+
+/*!
+ * @brief The next tick on which a slot fires or cascades, or UINT64_MAX if there are no timers
+ */
+- (uint64_t)nextEventTick
+{
+	uint64_t	next = UINT64_MAX;
+	unsigned	level;
+
+	for (level = 0; level < AI_TIMER_WHEEL_LEVELS; level++) {
+		if (!occupiedSlots[level]) continue;
+
+		//Slots are visited in order starting with the one after the current one
+		uint64_t	block = (currentTick >> (AI_TIMER_WHEEL_SLOT_BITS * level)) + 1;
+		uint64_t	bits = rotateRight(occupiedSlots[level], (unsigned)(block & SLOT_MASK));
+		uint64_t	tick = (block + __builtin_ctzll(bits)) << (AI_TIMER_WHEEL_SLOT_BITS * level);
+
+		if (tick < next) next = tick;
+	}
+
+	return next;
+}
+
+- (void)fireTimer:(AIWheelTimer *)timer
+{
+	[timer retain];
+	[self unlinkTimer:timer];
+
+	if (timer->block) {
+		timer->block(timer);
+	} else {
+		[timer->target performSelector:timer->selector withObject:timer];
+	}
+
+	//Unless the timer was invalidated or rescheduled while it fired
+	if (timer->valid && !timer->slot) {
+		if (timer->repeatTicks) {
+			timer->dueTick = MAX(timer->dueTick + timer->repeatTicks, currentTick + 1);
+			[self linkTimer:timer];
+		} else {
+			[timer invalidate];
+		}
+	}
+
+	[timer release];
+}
+
+/*!
+ * @brief Fire every timer due up to and including targetTick, in order
+ *
+ * Only the ticks which have work to do are visited. On each, higher level slots whose time has come are cascaded
+ * down first, so timers which land in the slot for this tick fire with it.
+ */
+- (void)runUntilTick:(uint64_t)targetTick
+{
+	if (firing) return;
+	firing = YES;
+
+	uint64_t	tick;
+	while ((tick = [self nextEventTick]) <= targetTick) {
+		unsigned	level;
+
+		currentTick = tick;
+
+		for (level = AI_TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+			if (tick & (LEVEL_SPAN(level) - 1)) continue;
+
+			AITimerWheelSlot	*slot = &slots[level][(tick >> (AI_TIMER_WHEEL_SLOT_BITS * level)) & SLOT_MASK];
+			AIWheelTimer		*timer;
+
+			while ((timer = slot->head)) {
+				[timer retain];
+				[self unlinkTimer:timer];
+				[self linkTimer:timer];
+				[timer release];
+			}
+		}
+
+		//Timers fired from this slot can't be scheduled back into it, since they must be due after this tick
+		AITimerWheelSlot	*slot = &slots[0][tick & SLOT_MASK];
+		AIWheelTimer		*timer;
+		while ((timer = slot->head)) {
+			[self fireTimer:timer];
+		}
+
+		//A virtual clock may have been advanced by a timer
+		if (usesVirtualClock) targetTick = MAX(targetTick, (uint64_t)floor(virtualTime / tickInterval + TICK_ROUNDING_ALLOWANCE));
+	}
+
+	if (targetTick > currentTick) currentTick = targetTick;
+	firing = NO;
+}
+
+- (void)advanceTimeBy:(NSTimeInterval)interval
+{
+	NSAssert(usesVirtualClock, @"Only a virtual clock can be advanced");
+
+	virtualTime += interval;
+	[self runUntilTick:(uint64_t)floor(virtualTime / tickInterval + TICK_ROUNDING_ALLOWANCE)];
+}
+
+/*!
+ * @brief Arm the dispatch source for the next tick with work to do
+ */
+- (void)armSource
+{
+	if (usesVirtualClock) return;
+
+	uint64_t next = [self nextEventTick];
+	if (next == armedTick) return;
+
+	armedTick = next;
+	if (next == UINT64_MAX) {
+		dispatch_source_set_timer(source, DISPATCH_TIME_FOREVER, 0, 0);
+	} else {
+		NSTimeInterval	wait = MAX(next * tickInterval - self.currentTime, 0);
+		dispatch_source_set_timer(source, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(wait * NSEC_PER_SEC)),
+								  DISPATCH_TIME_FOREVER, (uint64_t)(tickInterval * NSEC_PER_SEC));
+	}
+}
+
+@end
@@ -0,0 +1,98 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+@class ISO8601DateFormatter;
+
+//Long enough for any timestamp AITimestampCodec writes: YYYY-MM-DDTHH:MM:SS±HHMM
+#define AI_TIMESTAMP_MAX_LENGTH		24
+
+/*!
+ * @brief Parse a timestamp of exactly the form YYYY-MM-DDTHH:MM:SS±HHMM or YYYY-MM-DDTHH:MM:SSZ
+ *
+ * Pure arithmetic on the characters; no calendar or time zone is consulted. Safe to call from any thread.
+ *
+ * @param timeSeparator The character between hours, minutes and seconds; ':' in logs, '.' in log file names
+ * @param outTimeInterval Set to the time since the reference date
+ * @param outSecondsFromGMT If not NULL, set to the offset the timestamp was written in
+ * @result YES if the characters were of that form and in range; NO if a general ISO 8601 parser is needed
+ */
+BOOL AIParseTimestamp(const unichar *characters, NSUInteger length, unichar timeSeparator,
+					  NSTimeInterval *outTimeInterval, NSInteger *outSecondsFromGMT);
+
+/*!
+ * @brief Write a timestamp of the form AIParseTimestamp reads
+ *
+ * Fractions of a second are dropped, as ISO8601DateFormatter drops them. An offset of zero is written as Z.
+ *
+ * @param outCharacters Room for AI_TIMESTAMP_MAX_LENGTH characters
+ * @result The number of characters written, or 0 for years before 1583 or after 9999
+ */
+NSUInteger AIFormatTimestamp(NSTimeInterval timeInterval, NSInteger secondsFromGMT, unichar timeSeparator,
+							 unichar *outCharacters);
+
+/*!
+ * @class AITimestampCodec
+ * @brief Reads and writes the timestamps Adium puts in chat logs and log file names
+ *
+ * Adium only ever writes one ISO 8601 form, so that form is handled directly, without the NSCalendar work
+ * ISO8601DateFormatter does for every string. Anything else, such as logs written by very old versions or by other
+ * clients, is handed to an ISO8601DateFormatter, so the results are the same as before.
+ *
+ * When writing, the offset of the time zone is cached until its next daylight saving transition.
+ *
+ * A codec is not thread safe; the class methods are.
+ */
+@interface AITimestampCodec : NSObject {
+	unichar					timeSeparator;
+	ISO8601DateFormatter	*fallbackFormatter;
+
+	NSTimeZone				*offsetTimeZone;
+	NSTimeInterval			offsetValidFrom;
+	NSTimeInterval			offsetValidUntil;
+	NSInteger				cachedSecondsFromGMT;
+}
+
+/*!
+ * @brief A codec for the timestamps in chat logs, separating the parts of the time with ':'
+ */
+- (id)init;
+
+/*!
+ * @brief A codec separating the parts of the time with timeSeparator; log file names use '.'
+ */
+- (id)initWithTimeSeparator:(unichar)inTimeSeparator;
+
+@property (readonly, nonatomic) unichar timeSeparator;
+
+/*!
+ * @brief Parse a timestamp, falling back to ISO8601DateFormatter if it isn't in Adium's own form
+ */
+- (NSDate *)dateFromString:(NSString *)string;
+
+/*!
+ * @brief A timestamp for a date in the default time zone
+ */
+- (NSString *)stringFromDate:(NSDate *)date;
+- (NSString *)stringFromDate:(NSDate *)date timeZone:(NSTimeZone *)timeZone;
+
+/*!
+ * @brief Parse a timestamp without keeping a codec around
+ *
+ * A fallback formatter is created only if the string needs one.
+ */
++ (NSDate *)dateFromString:(NSString *)string timeSeparator:(unichar)timeSeparator;
+
+@end
@@ -0,0 +1,293 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <AIUtilities/AITimestampCodec.h>
+#import <AIUtilities/ISO8601DateFormatter.h>
+
+//Days from 1970-01-01 to 2001-01-01, NSDate's reference date
+#define REFERENCE_DATE_DAYS		11323
+#define SECONDS_PER_DAY			86400
+//NSCalendar's Gregorian calendar is Julian before this; NSTimeZone refuses offsets beyond MAXIMUM_OFFSET
+#define FIRST_GREGORIAN_YEAR	1583
+#define MAXIMUM_OFFSET			(18 * 3600)
+
+/*!
+ * @brief Days since 1970-01-01 of a date in the proleptic Gregorian calendar
+ *
+ * Howard Hinnant's days_from_civil; counting years from March puts the leap day at the end.
+ */
+static inline int64_t daysFromCivil(int64_t year, unsigned month, unsigned day)
+{
+	year -= (month <= 2);
+
+	int64_t		era = (year >= 0 ? year : year - 399) / 400;
+	unsigned	yearOfEra = (unsigned)(year - era * 400);
+	unsigned	dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	unsigned	dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+	return era * 146097 + (int64_t)dayOfEra - 719468;
+}
+
+/*!
+ * @brief The inverse of daysFromCivil
+ */
+static inline void civilFromDays(int64_t days, int64_t *outYear, unsigned *outMonth, unsigned *outDay)
+{
+	days += 719468;
+
+	int64_t		era = (days >= 0 ? days : days - 146096) / 146097;
+	unsigned	dayOfEra = (unsigned)(days - era * 146097);
+	unsigned	yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+	unsigned	dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	unsigned	monthFromMarch = (5 * dayOfYear + 2) / 153;
+
+	*outDay = dayOfYear - (153 * monthFromMarch + 2) / 5 + 1;
+	*outMonth = (monthFromMarch < 10 ? monthFromMarch + 3 : monthFromMarch - 9);
+	*outYear = (int64_t)yearOfEra + era * 400 + (*outMonth <= 2);
+}
+
+static inline BOOL isLeapYear(int64_t year)
+{
+	return (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0));
+}
+
+/*!
+ * @brief Read count decimal digits, or return -1 if any of them isn't one
+ */
+static inline int readDigits(const unichar *characters, NSUInteger count)
+{
+	int value = 0;
+
+	for (NSUInteger i = 0; i < count; i++) {
+		unichar ch = characters[i];
+		if (ch < '0' || ch > '9') return -1;
+		value = value * 10 + (ch - '0');
+	}
+
+	return value;
+}
+
+static inline void writeDigits(unichar *outCharacters, unsigned value, NSUInteger count)
+{
+	while (count--) {
+		outCharacters[count] = (unichar)('0' + value % 10);
+		value /= 10;
+	}
+}
+
+BOOL AIParseTimestamp(const unichar *characters, NSUInteger length, unichar timeSeparator,
+					  NSTimeInterval *outTimeInterval, NSInteger *outSecondsFromGMT)
+{
+	static const unsigned	daysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	NSInteger				secondsFromGMT = 0;
+
+	if (length != 20 && length != 24) return NO;
+
+	if (characters[4] != '-' || characters[7] != '-' || characters[10] != 'T' ||
+		characters[13] != timeSeparator || characters[16] != timeSeparator) return NO;
+
+	int	year = readDigits(characters, 4);
+	int	month = readDigits(characters + 5, 2);
+	int	day = readDigits(characters + 8, 2);
+	int	hour = readDigits(characters + 11, 2);
+	int	minute = readDigits(characters + 14, 2);
+	int	second = readDigits(characters + 17, 2);
+
+	//ISO8601DateFormatter is lenient about out of range values; let it decide what they mean
+	if (year < FIRST_GREGORIAN_YEAR || month < 1 || month > 12 || day < 1 || hour < 0 || hour > 23 ||
+		minute < 0 || minute > 59 || second < 0 || second > 59) return NO;
+	if (day > (int)daysInMonth[month - 1] + (month == 2 && isLeapYear(year))) return NO;
+
+	if (length == 20) {
+		if (characters[19] != 'Z') return NO;
+
+	} else {
+		unichar	sign = characters[19];
+		int		offsetHours = readDigits(characters + 20, 2);
+		int		offsetMinutes = readDigits(characters + 22, 2);
+
+		if ((sign != '+' && sign != '-') || offsetHours < 0 || offsetMinutes < 0 || offsetMinutes > 59) return NO;
+
+		secondsFromGMT = (offsetHours * 60 + offsetMinutes) * 60;
+		if (secondsFromGMT > MAXIMUM_OFFSET) return NO;
+		if (sign == '-') secondsFromGMT = -secondsFromGMT;
+	}
+
+	int64_t days = daysFromCivil(year, (unsigned)month, (unsigned)day) - REFERENCE_DATE_DAYS;
+
+	*outTimeInterval = (NSTimeInterval)(days * SECONDS_PER_DAY + hour * 3600 + minute * 60 + second - secondsFromGMT);
+	if (outSecondsFromGMT) *outSecondsFromGMT = secondsFromGMT;
+
+	return YES;
+}
+
+NSUInteger AIFormatTimestamp(NSTimeInterval timeInterval, NSInteger secondsFromGMT, unichar timeSeparator,
+							 unichar *outCharacters)
+{
+	//Whole minutes only, as ISO8601DateFormatter writes them
+	NSInteger	offsetMinutes = secondsFromGMT / 60;
+	int64_t		localSeconds = (int64_t)floor(timeInterval) + offsetMinutes * 60;
+	int64_t		days = localSeconds / SECONDS_PER_DAY;
+	int64_t		secondOfDay = localSeconds % SECONDS_PER_DAY;
+	int64_t		year;
+	unsigned	month, day;
+
+	if (secondOfDay < 0) {
+		secondOfDay += SECONDS_PER_DAY;
+		days--;
+	}
+
+	civilFromDays(days + REFERENCE_DATE_DAYS, &year, &month, &day);
+	if (year < FIRST_GREGORIAN_YEAR || year > 9999) return 0;
+
+	writeDigits(outCharacters, (unsigned)year, 4);
+	outCharacters[4] = '-';
+	writeDigits(outCharacters + 5, month, 2);
+	outCharacters[7] = '-';
+	writeDigits(outCharacters + 8, day, 2);
+	outCharacters[10] = 'T';
+	writeDigits(outCharacters + 11, (unsigned)(secondOfDay / 3600), 2);
+	outCharacters[13] = timeSeparator;
+	writeDigits(outCharacters + 14, (unsigned)(secondOfDay / 60 % 60), 2);
+	outCharacters[16] = timeSeparator;
+	writeDigits(outCharacters + 17, (unsigned)(secondOfDay % 60), 2);
+
+	if (offsetMinutes == 0) {
+		outCharacters[19] = 'Z';
+		return 20;
+	}
+
+	outCharacters[19] = (offsetMinutes < 0 ? '-' : '+');
+	if (offsetMinutes < 0) offsetMinutes = -offsetMinutes;
+	writeDigits(outCharacters + 20, (unsigned)(offsetMinutes / 60), 2);
+	writeDigits(outCharacters + 22, (unsigned)(offsetMinutes % 60), 2);
+
+	return 24;
+}
+
+/*!
+ * @brief Parse a string's characters with AIParseTimestamp
+ */
+static BOOL parseTimestampString(NSString *string, unichar timeSeparator, NSTimeInterval *outTimeInterval)
+{
+	unichar		characters[AI_TIMESTAMP_MAX_LENGTH];
+	NSUInteger	length = [string length];
+
+	if (length > AI_TIMESTAMP_MAX_LENGTH) return NO;
+	[string getCharacters:characters range:NSMakeRange(0, length)];
+
+	return AIParseTimestamp(characters, length, timeSeparator, outTimeInterval, NULL);
+}
+
+static ISO8601DateFormatter *newFallbackFormatter(unichar timeSeparator)
+{
+	ISO8601DateFormatter *formatter = [[ISO8601DateFormatter alloc] init];
+
+	formatter.timeSeparator = timeSeparator;
+	formatter.includeTime = YES;
+
+	return formatter;
+}
+
+@implementation AITimestampCodec
+
+- (id)init
+{
+	return [self initWithTimeSeparator:ISO8601DefaultTimeSeparatorCharacter];
+}
+
+- (id)initWithTimeSeparator:(unichar)inTimeSeparator
+{
+	if ((self = [super init])) {
+		timeSeparator = inTimeSeparator;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[fallbackFormatter release];
+	[offsetTimeZone release];
+
+	[super dealloc];
+}
+
+@synthesize timeSeparator;
+
+- (NSDate *)dateFromString:(NSString *)string
+{
+	NSTimeInterval timeInterval;
+
+	if (!string) return nil;
+
+	if (parseTimestampString(string, timeSeparator, &timeInterval))
+		return [NSDate dateWithTimeIntervalSinceReferenceDate:timeInterval];
+
+	if (!fallbackFormatter) fallbackFormatter = newFallbackFormatter(timeSeparator);
+	return [fallbackFormatter dateFromString:string];
+}
+
+- (NSString *)stringFromDate:(NSDate *)date
+{
+	return [self stringFromDate:date timeZone:[NSTimeZone defaultTimeZone]];
+}
+
+- (NSString *)stringFromDate:(NSDate *)date timeZone:(NSTimeZone *)timeZone
+{
+	NSTimeInterval	timeInterval = [date timeIntervalSinceReferenceDate];
+	unichar			characters[AI_TIMESTAMP_MAX_LENGTH];
+	NSUInteger		length;
+
+	if (!date) return nil;
+
+	//The offset only changes at daylight saving transitions, and logs are written in order
+	if (timeZone != offsetTimeZone || timeInterval < offsetValidFrom || timeInterval >= offsetValidUntil) {
+		NSDate *transition = [timeZone nextDaylightSavingTimeTransitionAfterDate:date];
+
+		[offsetTimeZone release];
+		offsetTimeZone = [timeZone retain];
+		cachedSecondsFromGMT = [timeZone secondsFromGMTForDate:date];
+		offsetValidFrom = timeInterval;
+		offsetValidUntil = (transition ? [transition timeIntervalSinceReferenceDate] : INFINITY);
+	}
+
+	length = AIFormatTimestamp(timeInterval, cachedSecondsFromGMT, timeSeparator, characters);
+	if (!length) {
+		if (!fallbackFormatter) fallbackFormatter = newFallbackFormatter(timeSeparator);
+		return [fallbackFormatter stringFromDate:date timeZone:timeZone];
+	}
+
+	return [NSString stringWithCharacters:characters length:length];
+}
+
++ (NSDate *)dateFromString:(NSString *)string timeSeparator:(unichar)timeSeparator
+{
+	NSTimeInterval timeInterval;
+
+	if (!string) return nil;
+
+	if (parseTimestampString(string, timeSeparator, &timeInterval))
+		return [NSDate dateWithTimeIntervalSinceReferenceDate:timeInterval];
+
+	ISO8601DateFormatter	*formatter = newFallbackFormatter(timeSeparator);
+	NSDate					*date = [formatter dateFromString:string];
+	[formatter release];
+
+	return date;
+}
+
+@end
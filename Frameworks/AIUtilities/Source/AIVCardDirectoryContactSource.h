@@ -0,0 +1,44 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <AIUtilities/AIContactSource.h>
+
+/*!
+ * @class AIVCardDirectoryContactSource
+ * @brief A folder of .vcf files, one card each, as a contact source
+ *
+ * A card's unique ID is its file name without the extension, and its modification date the file's. The name, nickname,
+ * organization, phonetic names, emails, URLs and instant messaging fields, both the X-AIM style and IMPP, are read.
+ */
+@interface AIVCardDirectoryContactSource : NSObject <AIContactSource> {
+	NSString	*directoryPath;
+}
+
+- (id)initWithDirectoryPath:(NSString *)inDirectoryPath;
+
+/*!
+ * @brief Read the first card in a vCard file's contents
+ */
++ (AIContactCard *)cardWithUniqueID:(NSString *)uniqueID vCardString:(NSString *)vCard;
+
+/*!
+ * @brief The path of the file for a card
+ */
+- (NSString *)pathForCardWithUniqueID:(NSString *)uniqueID;
+
+@property (readonly, nonatomic) NSString *directoryPath;
+
+@end
@@ -0,0 +1,219 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <AIUtilities/AIVCardDirectoryContactSource.h>
+#import <AIUtilities/AIContactCard.h>
+
+#define VCARD_EXTENSION		@"vcf"
+
+/*!
+ * @brief Split a vCard value at unescaped separators, unescaping each part
+ */
+static NSArray *vCardValueComponents(NSString *value, unichar separator)
+{
+	NSMutableArray	*components = [NSMutableArray array];
+	NSMutableString	*component = [NSMutableString string];
+	NSUInteger		length = value.length;
+
+	for (NSUInteger i = 0; i < length; i++) {
+		unichar character = [value characterAtIndex:i];
+
+		if (character == '\\' && i + 1 < length) {
+			unichar escaped = [value characterAtIndex:++i];
+			if (escaped == 'n' || escaped == 'N') escaped = '\n';
+			[component appendFormat:@"%C", escaped];
+
+		} else if (character == separator) {
+			[components addObject:[[component copy] autorelease]];
+			[component setString:@""];
+
+		} else {
+			[component appendFormat:@"%C", character];
+		}
+	}
+	[components addObject:component];
+
+	return components;
+}
+
+static NSString *vCardText(NSString *value)
+{
+	return [vCardValueComponents(value, 0) objectAtIndex:0];
+}
+
+@implementation AIVCardDirectoryContactSource
+
+- (id)initWithDirectoryPath:(NSString *)inDirectoryPath
+{
+	if ((self = [super init])) {
+		directoryPath = [inDirectoryPath copy];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[directoryPath release];
+
+	[super dealloc];
+}
+
+@synthesize directoryPath;
+
+- (NSString *)pathForCardWithUniqueID:(NSString *)uniqueID
+{
+	return [[directoryPath stringByAppendingPathComponent:uniqueID] stringByAppendingPathExtension:VCARD_EXTENSION];
+}
+
+- (NSSet *)allCardUniqueIDs
+{
+	NSMutableSet *uniqueIDs = [NSMutableSet set];
+
+	for (NSString *fileName in [[NSFileManager defaultManager] contentsOfDirectoryAtPath:directoryPath error:NULL]) {
+		if ([[fileName pathExtension] caseInsensitiveCompare:VCARD_EXTENSION] == NSOrderedSame)
+			[uniqueIDs addObject:[fileName stringByDeletingPathExtension]];
+	}
+
+	return uniqueIDs;
+}
+
+- (NSSet *)cardUniqueIDsModifiedSinceDate:(NSDate *)date
+{
+	NSMutableSet	*uniqueIDs = [NSMutableSet set];
+	NSArray			*URLs = [[NSFileManager defaultManager] contentsOfDirectoryAtURL:[NSURL fileURLWithPath:directoryPath]
+												  includingPropertiesForKeys:[NSArray arrayWithObject:NSURLContentModificationDateKey]
+																	 options:NSDirectoryEnumerationSkipsHiddenFiles
+																	   error:NULL];
+
+	for (NSURL *URL in URLs) {
+		NSDate *modificationDate = nil;
+
+		if ([[[URL path] pathExtension] caseInsensitiveCompare:VCARD_EXTENSION] != NSOrderedSame) continue;
+
+		[URL getResourceValue:&modificationDate forKey:NSURLContentModificationDateKey error:NULL];
+		if (!modificationDate || [modificationDate compare:date] != NSOrderedAscending)
+			[uniqueIDs addObject:[[[URL path] lastPathComponent] stringByDeletingPathExtension]];
+	}
+
+	return uniqueIDs;
+}
+
+- (AIContactCard *)cardWithUniqueID:(NSString *)uniqueID
+{
+	NSString *vCard = [NSString stringWithContentsOfFile:[self pathForCardWithUniqueID:uniqueID]
+												encoding:NSUTF8StringEncoding
+												   error:NULL];
+
+	return (vCard ? [[self class] cardWithUniqueID:uniqueID vCardString:vCard] : nil);
+}
+
++ (AIContactCard *)cardWithUniqueID:(NSString *)uniqueID vCardString:(NSString *)vCard
+{
+	static NSDictionary	*instantMessageFields = nil;
+	static NSDictionary	*IMPPSchemes = nil;
+
+	if (!instantMessageFields) {
+		instantMessageFields = [[NSDictionary alloc] initWithObjectsAndKeys:
+								@"AIM", @"X-AIM", @"ICQ", @"X-ICQ", @"Jabber", @"X-JABBER",
+								@"MSN", @"X-MSN", @"Yahoo!", @"X-YAHOO", nil];
+		IMPPSchemes = [[NSDictionary alloc] initWithObjectsAndKeys:
+					   @"AIM", @"aim", @"ICQ", @"icq", @"Jabber", @"xmpp",
+					   @"MSN", @"msnim", @"Yahoo!", @"ymsgr", nil];
+	}
+
+	NSMutableDictionary	*nameComponents = [NSMutableDictionary dictionary];
+	NSMutableArray		*emails = [NSMutableArray array];
+	NSMutableArray		*homepages = [NSMutableArray array];
+	NSMutableDictionary	*instantMessageNames = [NSMutableDictionary dictionary];
+	BOOL				inCard = NO;
+
+	//Unfold continuation lines
+	NSString *unfolded = [[vCard stringByReplacingOccurrencesOfString:@"\r\n" withString:@"\n"]
+						  stringByReplacingOccurrencesOfString:@"\r" withString:@"\n"];
+	unfolded = [[unfolded stringByReplacingOccurrencesOfString:@"\n " withString:@""]
+				stringByReplacingOccurrencesOfString:@"\n\t" withString:@""];
+
+	for (NSString *line in [unfolded componentsSeparatedByString:@"\n"]) {
+		NSRange	colon = [line rangeOfString:@":"];
+		if (colon.location == NSNotFound) continue;
+
+		NSString	*name = [[[line substringToIndex:colon.location] componentsSeparatedByString:@";"] objectAtIndex:0];
+		NSString	*value = [line substringFromIndex:NSMaxRange(colon)];
+		NSRange		dot = [name rangeOfString:@"."];
+
+		//Drop any group, as in item1.EMAIL
+		if (dot.location != NSNotFound) name = [name substringFromIndex:NSMaxRange(dot)];
+		name = [name uppercaseString];
+
+		if ([name isEqualToString:@"BEGIN"]) {
+			inCard = YES;
+			continue;
+		}
+		if (!inCard) continue;
+		if ([name isEqualToString:@"END"]) break;
+
+		if ([name isEqualToString:@"N"]) {
+			NSArray		*parts = vCardValueComponents(value, ';');
+			NSString	*keys[] = { AIContactCardLastNameKey, AIContactCardFirstNameKey, AIContactCardMiddleNameKey };
+
+			for (NSUInteger i = 0; i < 3 && i < parts.count; i++) {
+				if ([[parts objectAtIndex:i] length]) [nameComponents setObject:[parts objectAtIndex:i] forKey:keys[i]];
+			}
+
+		} else if ([name isEqualToString:@"NICKNAME"]) {
+			[nameComponents setObject:vCardText(value) forKey:AIContactCardNicknameKey];
+		} else if ([name isEqualToString:@"ORG"]) {
+			[nameComponents setObject:[vCardValueComponents(value, ';') objectAtIndex:0] forKey:AIContactCardOrganizationKey];
+		} else if ([name isEqualToString:@"X-PHONETIC-FIRST-NAME"]) {
+			[nameComponents setObject:vCardText(value) forKey:AIContactCardPhoneticFirstNameKey];
+		} else if ([name isEqualToString:@"X-PHONETIC-LAST-NAME"]) {
+			[nameComponents setObject:vCardText(value) forKey:AIContactCardPhoneticLastNameKey];
+		} else if ([name isEqualToString:@"EMAIL"]) {
+			[emails addObject:vCardText(value)];
+		} else if ([name isEqualToString:@"URL"]) {
+			[homepages addObject:vCardText(value)];
+
+		} else {
+			NSString *fieldServiceID = [instantMessageFields objectForKey:name];
+
+			if (!fieldServiceID && [name isEqualToString:@"IMPP"]) {
+				NSRange schemeColon = [value rangeOfString:@":"];
+				if (schemeColon.location != NSNotFound) {
+					fieldServiceID = [IMPPSchemes objectForKey:[[value substringToIndex:schemeColon.location] lowercaseString]];
+					value = [value substringFromIndex:NSMaxRange(schemeColon)];
+				}
+			}
+
+			if (fieldServiceID) {
+				NSMutableArray *names = [instantMessageNames objectForKey:fieldServiceID];
+				if (!names) {
+					names = [NSMutableArray array];
+					[instantMessageNames setObject:names forKey:fieldServiceID];
+				}
+				[names addObject:vCardText(value)];
+			}
+		}
+	}
+
+	return [[[AIContactCard alloc] initWithUniqueID:uniqueID
+									 nameComponents:nameComponents
+											 emails:emails
+										  homepages:homepages
+								instantMessageNames:instantMessageNames] autorelease];
+}
+
+@end
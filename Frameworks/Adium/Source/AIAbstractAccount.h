@@ -16,6 +16,7 @@
 
 #import <Adium/AIAccount.h>
 #import <Adium/AIPasswordPromptController.h>
+#import <Adium/AIReconnectScheduler.h>
 
 typedef enum {
 	AIReconnectNever = 0,
@@ -24,7 +25,7 @@ typedef enum {
 	AIReconnectNormally
 } AIReconnectDelayType;
 
-@interface AIAccount (Abstract)
+@interface AIAccount (Abstract) <AIReconnectSchedulerClient>
 
 - (id)initWithUID:(NSString *)inUID internalObjectID:(NSString *)inInternalObjectID service:(AIService *)inService;
 @property (readwrite, retain, nonatomic) NSData *userIconData;
@@ -100,6 +101,7 @@ typedef enum {
 
 //FUS Disconnecting
 - (void)autoReconnectAfterDelay:(NSTimeInterval)delay;
+- (void)scheduleConnect;
 - (double)minimumReconnectTime;
 - (void)cancelAutoReconnect;
 - (void)initFUSDisconnecting;
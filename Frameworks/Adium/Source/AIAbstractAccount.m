@@ -38,9 +38,7 @@
 
 #define FILTERED_STRING_REFRESH    30.0    //delay in seconds between refresh of our attributed string statuses when needed
 
-#define RECONNECT_BASE_TIME				1.75	//Reconnect wait time is base^(try) in seconds
 #define RECONNECT_MIN_TIME				5.0		//Minimum time in seconds to wait between reconnect attempts
-#define RECONNECT_MAX_TIME				600.0	//Maximum time in seconds to wait between reconnect attempts
 
 #define	ACCOUNT_DEFAULTS			@"AccountDefaults"
 
@@ -1213,13 +1211,14 @@
 	[self setValue:nil forProperty:@"connectionProgressString" notify:NotifyLater];
 	[self setValue:nil forProperty:@"connectionProgressPercent" notify:NotifyLater];	
     [self setValue:nil forProperty:@"waitingToReconnect" notify:NotifyLater];
-	AILogWithSignature(@"*** status dictionary is now %@", propertiesDictionary);
+	AILogWithSignature(@"*** status dictionary is now %@", self.properties);
 	
 	//Apply any changes
 	[self notifyOfChangedPropertiesSilently:NO];
 	
-    //Reset reconnection attempts
+    //Reset reconnection attempts, and let the next account connect
     reconnectAttemptsPerformed = 0;
+	[[AIReconnectScheduler sharedScheduler] clientDidConnect:self];
 	
 	//Update our status and idle status to ensure our newly connected account is in the states we want it to be
 	if (self.statusState.statusType == AIOfflineStatusType) {
@@ -1244,27 +1243,78 @@
 
 - (void)cancelAutoReconnect
 {
+	[[AIReconnectScheduler sharedScheduler] cancelReconnectForClient:self];
+
     [self setValue:nil forProperty:@"waitingToReconnect" notify:NotifyNow];
 
 	reconnectAttemptsPerformed = 0;
-
-	[NSObject cancelPreviousPerformRequestsWithTarget:self
-											 selector:@selector(performAutoreconnect)
-											   object:nil];
 }
 
 /*!
  * @brief Autoreconnect after a specified delay
  *
+ * The reconnect still waits its turn with the reconnect scheduler once the delay has passed.
+ *
  * @param delay Delay in seconds
  */
 - (void)autoReconnectAfterDelay:(NSTimeInterval)delay
 {
-    [self setValue:[NSDate dateWithTimeIntervalSinceNow:delay] forProperty:@"waitingToReconnect" notify:NotifyNow];
-	[self performSelector:@selector(performAutoreconnect)
-			   withObject:nil
-			   afterDelay:delay];
+	[[AIReconnectScheduler sharedScheduler] scheduleReconnectForClient:self afterDelay:delay];
+}
+
+/*!
+ * @brief Connect once the reconnect scheduler allows
+ *
+ * Used rather than setShouldBeOnline:YES when many accounts may be coming online together, such as when the network
+ * returns, so that they are spread out and only a few connect at once.
+ */
+- (void)scheduleConnect
+{
+	[[AIReconnectScheduler sharedScheduler] scheduleConnectForClient:self];
+}
+
+#pragma mark AIReconnectSchedulerClient
+
+- (NSString *)reconnectServiceIdentifier
+{
+	return self.service.serviceID;
+}
+
+- (NSString *)reconnectHost
+{
+	return (self.connectivityBasedOnNetworkReachability ? self.host : nil);
+}
+
+/*!
+ * @brief Our turn to connect came up
+ *
+ * If we don't start connecting, give up our turn so another account can have it.
+ */
+- (void)performScheduledReconnect
+{
+	if (!self.online && ![self boolValueForProperty:@"isConnecting"]) {
+		if (self.shouldBeOnline) {
+			[self updateStatusForKey:@"isOnline"];
+		} else {
+			[self setShouldBeOnline:YES];
+		}
+	}
+
+	if (!self.online && ![self boolValueForProperty:@"isConnecting"]) {
+		[[AIReconnectScheduler sharedScheduler] cancelReconnectForClient:self];
+	}
 }
+
+- (void)setScheduledReconnectDate:(NSDate *)date
+{
+	[self setValue:date forProperty:@"waitingToReconnect" notify:NotifyLater];
+}
+
+- (void)notifyOfScheduledReconnectDate
+{
+	[self notifyOfChangedPropertiesSilently:NO];
+}
+
 - (void)performAutoreconnect
 {
 	//If we still want to be online, and we're not yet online, continue with the reconnect
@@ -1389,20 +1439,13 @@
 	} else if ([self shouldBeOnline] && lastDisconnectionError) {
 		AIReconnectDelayType shouldReconnect = [self shouldAttemptReconnectAfterDisconnectionError:&lastDisconnectionError];
 		if (shouldReconnect == AIReconnectNormally) {
-			// Set our retry time to RECONNECT_BASE_TIME^reconnectAttemptsPerformed
-			double reconnectDelay = pow(RECONNECT_BASE_TIME, (double)reconnectAttemptsPerformed);
-			
-			// Make sure we're not going too fast
-			if (reconnectDelay < [self minimumReconnectTime])
-				reconnectDelay = [self minimumReconnectTime];
-			// Or too slow
-			else if (reconnectDelay > RECONNECT_MAX_TIME)
-				reconnectDelay = RECONNECT_MAX_TIME;
+			// The scheduler backs off from our minimum delay, with jitter so that accounts don't retry in lockstep
+			NSTimeInterval reconnectDelay = [[AIReconnectScheduler sharedScheduler] scheduleReconnectForClient:self
+																								  minimumDelay:[self minimumReconnectTime]];
 			
 			AILog(@"%@: Disconnected (\"%@\"): Automatically reconnecting in %0f seconds (%i attempts performed)",
 				  self, lastDisconnectionError, reconnectDelay, reconnectAttemptsPerformed);
 			
-			[self autoReconnectAfterDelay:reconnectDelay];
 			reconnectAttemptsPerformed++;
 		} else if (shouldReconnect == AIReconnectImmediately) {
 			AILog(@"%@: Disconnected (\"%@\"): Automatically reconnecting immediately", self, lastDisconnectionError);
@@ -1417,10 +1460,12 @@
 			
 			//Reset reconnection attempts
 			reconnectAttemptsPerformed = 0;
+			[[AIReconnectScheduler sharedScheduler] cancelReconnectForClient:self];
 		}
 	} else {
 		AILog(@"%@: Disconnected; should be online? %@; lastDisconnectionError %@",
 			  self, ([self shouldBeOnline] ? @"Yes" : @"No"), lastDisconnectionError);
+		[[AIReconnectScheduler sharedScheduler] cancelReconnectForClient:self];
 	}
 }
 
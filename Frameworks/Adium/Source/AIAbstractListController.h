@@ -220,6 +220,7 @@ typedef enum {
 - (void)updateCellRelatedThemePreferencesFromDict:(NSDictionary *)prefDict;
 
 - (void)listObjectAttributeChangesComplete:(NSNotification *)notification;
+- (void)elapsedTimeMinuteDidChange:(NSNotification *)notification;
 - (void)contactListDesiredSizeChanged;
 - (void)updateTransparency;
 - (BOOL)useAliasesInContactListAsRequested;
@@ -36,6 +36,7 @@
 #import <Adium/AIMenuControllerProtocol.h>
 #import <Adium/AIUserIcons.h>
 #import <Adium/AIService.h>
+#import <Adium/AIElapsedTimeManager.h>
 #import <AIUtilities/AIAutoScrollView.h>
 #import <AIUtilities/AIColorAdditions.h>
 #import <AIUtilities/AIFontAdditions.h>
@@ -122,6 +123,9 @@ static NSString *AIWebURLsWithTitlesPboardType = @"WebURLsWithTitlesPboardType";
 										   name:AIDisplayableContainedObjectsDidChange
 										 object:nil];
 		
+		//Idle times are drawn from the time, so redraw them as it changes
+		[[AIElapsedTimeManager sharedManager] addMinuteObserver:self
+													   selector:@selector(elapsedTimeMinuteDidChange:)];
 	}
 
 	return self;
@@ -155,6 +159,7 @@ static NSString *AIWebURLsWithTitlesPboardType = @"WebURLsWithTitlesPboardType";
 	[groupCell release];
 	[contentCell release];
 	
+	[[AIElapsedTimeManager sharedManager] removeMinuteObserver:self];
 	[[NSNotificationCenter defaultCenter] removeObserver:self]; 
 
     [super dealloc];
@@ -599,6 +604,25 @@ static NSString *AIWebURLsWithTitlesPboardType = @"WebURLsWithTitlesPboardType";
 	}
 }
 
+/*!
+ * @brief The minute changed
+ *
+ * Redraw the visible rows whose idle times may now read differently. Rows scrolled out of view are drawn with the
+ * current time when they come back, and nothing about the objects themselves changed, so nothing else is updated.
+ */
+- (void)elapsedTimeMinuteDidChange:(NSNotification *)notification
+{
+	AIElapsedTimeManager	*elapsedTimeManager = [AIElapsedTimeManager sharedManager];
+	NSRange					visibleRows = [contactListView rowsInRect:[contactListView visibleRect]];
+
+	for (NSUInteger row = visibleRows.location; row < NSMaxRange(visibleRows); row++) {
+		AIListObject *listObject = ((AIProxyListObject *)[contactListView itemAtRow:row]).listObject;
+
+		if ([elapsedTimeManager displayOfObjectDependsOnTime:listObject])
+			[contactListView setNeedsDisplayInRect:[contactListView rectOfRow:row]];
+	}
+}
+
 
 //Outline View data source ---------------------------------------------------------------------------------------------
 #pragma mark Outline View data source
@@ -0,0 +1,39 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <AddressBook/AddressBook.h>
+#import <AIUtilities/AIContactSource.h>
+
+/*!
+ * @class AIAddressBookContactSource
+ * @brief The Address Book's people as a contact source
+ *
+ * Modified people are found with a search on their modification dates, which the Address Book keeps indexed, so
+ * nobody else's record needs to be read.
+ */
+@interface AIAddressBookContactSource : NSObject <AIContactSource> {
+	ABAddressBook	*addressBook;
+	NSDictionary	*instantMessageProperties;
+}
+
+/*!
+ * @brief A source for an address book
+ *
+ * @param inInstantMessageProperties Address Book instant messaging properties keyed by the service ID of their names
+ */
+- (id)initWithAddressBook:(ABAddressBook *)inAddressBook instantMessageProperties:(NSDictionary *)inInstantMessageProperties;
+
+@end
@@ -0,0 +1,111 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIAddressBookContactSource.h"
+#import <AIUtilities/AIContactCard.h>
+
+@implementation AIAddressBookContactSource
+
+- (id)initWithAddressBook:(ABAddressBook *)inAddressBook instantMessageProperties:(NSDictionary *)inInstantMessageProperties
+{
+	if ((self = [super init])) {
+		addressBook = [inAddressBook retain];
+		instantMessageProperties = [inInstantMessageProperties copy];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[addressBook release];
+	[instantMessageProperties release];
+
+	[super dealloc];
+}
+
+- (NSSet *)allCardUniqueIDs
+{
+	return [NSSet setWithArray:[[addressBook people] valueForKey:@"uniqueId"]];
+}
+
+- (NSSet *)cardUniqueIDsModifiedSinceDate:(NSDate *)date
+{
+	ABSearchElement	*modifiedSince = [ABPerson searchElementForProperty:kABModificationDateProperty
+																 label:nil
+																   key:nil
+																 value:date
+															comparison:kABGreaterThanOrEqual];
+
+	return [NSSet setWithArray:[[addressBook recordsMatchingSearchElement:modifiedSince] valueForKey:@"uniqueId"]];
+}
+
+static NSArray *valuesOfMultiValue(ABMultiValue *multiValue)
+{
+	NSUInteger		count = [multiValue count];
+	NSMutableArray	*values = [NSMutableArray arrayWithCapacity:count];
+
+	for (NSUInteger i = 0; i < count; i++) {
+		id value = [multiValue valueAtIndex:i];
+		if ([value isKindOfClass:[NSString class]]) [values addObject:value];
+	}
+
+	return values;
+}
+
+- (AIContactCard *)cardWithUniqueID:(NSString *)uniqueID
+{
+	ABRecord	*record = [addressBook recordForUniqueId:uniqueID];
+
+	if (![record isKindOfClass:[ABPerson class]]) return nil;
+
+	NSMutableDictionary	*nameComponents = [NSMutableDictionary dictionary];
+	NSMutableDictionary	*instantMessageNames = [NSMutableDictionary dictionary];
+	NSDictionary		*nameProperties = [NSDictionary dictionaryWithObjectsAndKeys:
+										   AIContactCardFirstNameKey, kABFirstNameProperty,
+										   AIContactCardLastNameKey, kABLastNameProperty,
+										   AIContactCardMiddleNameKey, kABMiddleNameProperty,
+										   AIContactCardNicknameKey, kABNicknameProperty,
+										   AIContactCardPhoneticFirstNameKey, kABFirstNamePhoneticProperty,
+										   AIContactCardPhoneticMiddleNameKey, kABMiddleNamePhoneticProperty,
+										   AIContactCardPhoneticLastNameKey, kABLastNamePhoneticProperty,
+										   AIContactCardOrganizationKey, kABOrganizationProperty,
+										   AIContactCardFlagsKey, kABPersonFlags,
+										   nil];
+
+	for (NSString *property in nameProperties) {
+		id value = [record valueForProperty:property];
+		if (value) [nameComponents setObject:value forKey:[nameProperties objectForKey:property]];
+	}
+
+	for (NSString *serviceID in instantMessageProperties) {
+		NSString *property = [instantMessageProperties objectForKey:serviceID];
+
+		//Homepages are read as homepages, not names
+		if ([property isEqualToString:kABURLsProperty]) continue;
+
+		NSArray *names = valuesOfMultiValue([record valueForProperty:property]);
+		if (names.count) [instantMessageNames setObject:names forKey:serviceID];
+	}
+
+	return [[[AIContactCard alloc] initWithUniqueID:uniqueID
+									 nameComponents:nameComponents
+											 emails:valuesOfMultiValue([record valueForProperty:kABEmailProperty])
+										  homepages:valuesOfMultiValue([record valueForProperty:kABURLsProperty])
+								instantMessageNames:instantMessageNames] autorelease];
+}
+
+@end
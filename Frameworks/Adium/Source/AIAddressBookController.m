@@ -30,8 +30,11 @@
 #import <AIUtilities/OWAddressBookAdditions.h>
 #import <AIUtilities/AIFileManagerAdditions.h>
 #import <AIUtilities/AIImageAdditions.h>
+#import <AIUtilities/AIContactCard.h>
+#import <AIUtilities/AIContactSourceSync.h>
 
 #import "AIAddressBookUserIconSource.h"
+#import "AIAddressBookContactSource.h"
 
 #define IMAGE_LOOKUP_INTERVAL   0.01
 #define SHOW_IN_AB_CONTEXTUAL_MENU_TITLE AILocalizedString(@"Show In Address Book", "Show In Address Book Contextual Menu")
@@ -52,11 +55,11 @@
 - (void)updateAllContacts;
 - (void)updateSelfIncludingIcon:(BOOL)includeIcon;
 - (NSString *)nameForPerson:(ABPerson *)person phonetic:(NSString **)phonetic;
-- (void)rebuildAddressBookDict;
+- (void)synchronizeAddressBook;
 - (void)showInAddressBook;
 - (void)editInAddressBook;
-- (void)addToAddressBookDict:(NSArray *)people;
-- (void)removeFromAddressBookDict:(NSArray *)UIDs;
+- (void)groupCardsWithUniqueIDs:(id <NSFastEnumeration>)uniqueIDs;
+- (NSSet *)contactsForMatches:(NSArray *)matches;
 - (void)installAddressBookActions;
 
 - (void)adiumFinishedLaunching:(NSNotification *)notification;
@@ -77,12 +80,9 @@
 
 static AIAddressBookController	*addressBookController = nil;
 static ABAddressBook			*sharedAddressBook;
-static NSMutableDictionary		*addressBookDict;
+static AIContactSourceSync		*addressBookSync;
 static NSDictionary				*serviceDict;
 
-NSString* serviceIDForOscarUID(NSString *UID);
-NSString* serviceIDForJabberUID(NSString *UID);
-
 + (void) startAddressBookIntegration
 {
 	if(!addressBookController)
@@ -94,7 +94,7 @@ NSString* serviceIDForJabberUID(NSString *UID);
 	if ((self = [super init]))
 	{
 		meTag = -1;
-		addressBookDict = nil;
+		addressBookSync = nil;
 		createMetaContacts = NO;
 		
 		personUniqueIdToMetaContactDict = [[NSMutableDictionary alloc] init];
@@ -234,6 +234,7 @@ NSString* serviceIDForJabberUID(NSString *UID);
 {
 	[serviceDict release]; serviceDict = nil;
 
+	[addressBookSync release]; addressBookSync = nil;
 	[sharedAddressBook release]; sharedAddressBook = nil;
 	[personUniqueIdToMetaContactDict release]; personUniqueIdToMetaContactDict = nil;
 
@@ -312,8 +313,8 @@ NSString* serviceIDForJabberUID(NSString *UID);
 	AIListContact	*listContact;
 	NSSet			*modifiedAttributes = nil;
 
-	//Just stop here if we don't have an address book dict to work with
-	if (!addressBookDict) return nil;
+	//Just stop here if we haven't indexed the address book yet
+	if (!addressBookSync) return nil;
 	
 	//We handle accounts separately; doing updates here causes chaos in addition to being inefficient.
 	if ([inObject isKindOfClass:[AIAccount class]]) return nil;
@@ -530,8 +531,8 @@ NSString* serviceIDForJabberUID(NSString *UID);
 /*!
  * @brief Observe preference changes
  *
- * On first call, this method builds the addressBookDict. Subsequently, it rebuilds the dict only if the "create metaContacts"
- * option is toggled, as metaContacts are created while building the dict.
+ * On first call, this method synchronizes our address book index. Subsequently, it synchronizes again only if the "create
+ * metaContacts" option is toggled, as metaContacts are created while synchronizing.
  *
  * If the user set a new image as a preference for an object, write it out to the contact's AB card if desired.
  */
@@ -559,8 +560,8 @@ NSString* serviceIDForJabberUID(NSString *UID);
 	createMetaContacts = [[prefDict objectForKey:KEY_AB_CREATE_METACONTACTS] boolValue];
 	
 	if (firstTime) {
-		//Build the address book dictionary, which will also trigger metacontact grouping as appropriate
-		[self rebuildAddressBookDict];
+		//Synchronize the address book index, which will also trigger metacontact grouping as appropriate
+		[self synchronizeAddressBook];
 		
 		//Register ourself as a listObject observer, which will update all objects
 		[[AIContactObserverManager sharedManager] registerListObjectObserver:self];
@@ -572,10 +573,10 @@ NSString* serviceIDForJabberUID(NSString *UID);
 		//If we weren't creating meta contacts before but we are now
 		if (!oldCreateMetaContacts && createMetaContacts) {
 			/*
-			 Build the address book dictionary, which will also trigger metacontact grouping as appropriate
+			 Synchronize the address book index, which will also trigger metacontact grouping as appropriate
 			 Delay to the next run loop to give better UI responsiveness
 			 */
-			[self performSelector:@selector(rebuildAddressBookDict)
+			[self performSelector:@selector(synchronizeAddressBook)
 					   withObject:nil
 					   afterDelay:0];
 		}
@@ -718,7 +719,7 @@ NSString* serviceIDForJabberUID(NSString *UID);
 /*!
  * @brief Find an ABPerson for a given UID and serviceID combination
  * 
- * Uses our addressBookDict cache created in rebuildAddressBook.
+ * Uses the index kept by addressBookSync.
  *
  * @param UID The UID for the contact
  * @param serviceID The serviceID for the contact
@@ -728,30 +729,28 @@ NSString* serviceIDForJabberUID(NSString *UID);
 + (ABPerson *)_searchForUID:(NSString *)UID serviceID:(NSString *)serviceID
 {
 	ABPerson		*person = nil;
-	NSDictionary	*dict;
+	NSString		*indexServiceID;
 	
 	if ([serviceID isEqualToString:@"Mac"] ||
 		[serviceID isEqualToString:@"MobileMe"]) {
-		dict = [addressBookDict objectForKey:@"AIM"];
+		indexServiceID = @"AIM";
 
 	} else if ([serviceID isEqualToString:@"GTalk"]) {
-		dict = [addressBookDict objectForKey:@"Jabber"];
+		indexServiceID = @"Jabber";
 
 	} else if ([serviceID isEqualToString:@"LiveJournal"]) {
-		dict = [addressBookDict objectForKey:@"Jabber"];
+		indexServiceID = @"Jabber";
 		
 	} else if ([serviceID isEqualToString:@"Yahoo! Japan"]) {
-		dict = [addressBookDict objectForKey:@"Yahoo!"];
+		indexServiceID = @"Yahoo!";
 		
 	} else {
-		dict = [addressBookDict objectForKey:serviceID];
+		indexServiceID = serviceID;
 	} 
 	
-	if (dict) {
-		NSString *uniqueID = [dict objectForKey:[UID compactedString]];
-		if (uniqueID) {
-			person = (ABPerson *)[sharedAddressBook recordForUniqueId:uniqueID];
-		}
+	NSString *uniqueID = [addressBookSync cardUniqueIDForUID:UID indexServiceID:indexServiceID];
+	if (uniqueID) {
+		person = (ABPerson *)[sharedAddressBook recordForUniqueId:uniqueID];
 	}
 	
 	return person;
@@ -759,115 +758,18 @@ NSString* serviceIDForJabberUID(NSString *UID);
 
 #pragma mark -
 
-- (NSSet *)contactsForPerson:(ABPerson *)person
+/*!
+ * @brief The contacts named by the screen names found on a card
+ */
+- (NSSet *)contactsForMatches:(NSArray *)matches
 {
-	NSArray			*allServiceKeys = [serviceDict allKeys];
-	NSString		*serviceID;
 	NSMutableSet	*contactSet = [NSMutableSet set];
-	ABMultiValue	*emails;
-	ABMultiValue	*homepages;
-	NSInteger				i, emailsCount, homepagesCount;
 
-	//An ABPerson may have multiple emails; iterate through them looking for @mac.com addresses
-	{
-		emails = [person valueForProperty:kABEmailProperty];
-		emailsCount = [emails count];
-		
-		for (i = 0; i < emailsCount ; i++) {
-			NSString	*email;
-			
-			email = [emails valueAtIndex:i];
-			if ([email hasSuffix:@"@mac.com"]) {
-				//Retrieve all appropriate contacts
-				NSSet	*contacts = [adium.contactController allContactsWithService:[adium.accountController firstServiceWithServiceID:@"Mac"]
-																				  UID:email];
-
-				//Add them to our set
-				[contactSet unionSet:contacts];
-
-			} else if ([email hasSuffix:@"me.com"]) {
-					//Retrieve all appropriate contacts
-					NSSet	*contacts = [adium.contactController allContactsWithService:[adium.accountController firstServiceWithServiceID:@"MobileMe"]
-																					UID:email];
-					
-					//Add them to our set
-					[contactSet unionSet:contacts];
+	for (AIContactCardMatch *match in matches) {
+		AIService *service = [adium.accountController firstServiceWithServiceID:match.serviceID];
+		if (!service) continue;
 
-			} else if ([email hasSuffix:@"gmail.com"] || [email hasSuffix:@"googlemail.com"]) {
-				//Retrieve all appropriate contacts
-				NSSet	*contacts = [adium.contactController allContactsWithService:[adium.accountController firstServiceWithServiceID:@"GTalk"]
-																				UID:email];
-				
-				//Add them to our set
-				[contactSet unionSet:contacts];
-			} else if ([email hasSuffix:@"hotmail.com"]) {
-				//Retrieve all appropriate contacts
-				NSSet	*contacts = [adium.contactController allContactsWithService:[adium.accountController firstServiceWithServiceID:@"MSN"]
-																				UID:email];
-				
-				//Add them to our set
-				[contactSet unionSet:contacts];
-			}
-		}
-	}
-	
-	//An ABPerson may have multiple hompages; iterate through them looking for fb:// addresses
-	{
-		homepages = [person valueForProperty:kABURLsProperty];
-		homepagesCount = [homepages count];
-		
-		for (i = 0; i < homepagesCount ; i++) {
-			NSURL	*homepage = [NSURL URLWithString:(NSString*)[homepages valueAtIndex:i]];
-			if ([[homepage scheme] isEqualToString:@"fb"]) {
-				//Retrieve all appropriate contacts
-				//This will be fb://profile/XXX where XXX is the UID
-				NSString	*facebookNumber = (NSString*)[(NSString*)homepage lastPathComponent];
-				NSString	*facebookUID = [NSString stringWithFormat:@"-%@@chat.facebook.com", facebookNumber];
-
-				NSSet		*contacts = [adium.contactController allContactsWithService:[adium.accountController firstServiceWithServiceID:@"Facebook"]
-																					UID:facebookUID];
-				
-				//Add them to our set
-				[contactSet unionSet:contacts];
-			}
-		}
-	}
-	
-	//Now go through the instant messaging keys
-	for (serviceID in allServiceKeys) {
-		NSString		*addressBookKey = [serviceDict objectForKey:serviceID];
-		ABMultiValue	*names;
-		NSInteger				nameCount;
-
-		//An ABPerson may have multiple names; iterate through them
-		names = [person valueForProperty:addressBookKey];
-		nameCount = [names count];
-		
-		//Continue to the next serviceID immediately if no names are found
-		if (nameCount == 0) continue;
-		
-		BOOL					isOSCAR = ([serviceID isEqualToString:@"AIM"] || 
-										   [serviceID isEqualToString:@"ICQ"]);
-		BOOL					isJabber = [serviceID isEqualToString:@"Jabber"] ||
-                                           [serviceID isEqualToString:@"XMPP"];
-		
-		for (i = 0 ; i < nameCount ; i++) {
-			NSString	*UID = [[names valueAtIndex:i] compactedString];
-			if ([UID length]) {
-				if (isOSCAR) {
-					serviceID = serviceIDForOscarUID(UID);
-					
-				} else if (isJabber) {
-					serviceID = serviceIDForJabberUID(UID);
-				}
-				
-				NSSet	*contacts = [adium.contactController allContactsWithService:[adium.accountController firstServiceWithServiceID:serviceID]
-																				  UID:UID];
-				
-				//Add them to our set
-				[contactSet unionSet:contacts];
-			}
-		}
+		[contactSet unionSet:[adium.contactController allContactsWithService:service UID:match.UID]];
 	}
 
 	return contactSet;
@@ -877,7 +779,8 @@ NSString* serviceIDForJabberUID(NSString *UID);
 /*!
  * @brief Address book changed externally
  *
- * As a result we add/remove people to/from our address book dictionary cache and update all contacts based on it
+ * As a result we reread the added and modified people into our address book index and update the contacts they named,
+ * both before and after the change
  */
 - (void)addressBookChanged:(NSNotification *)notification
 {
@@ -885,82 +788,85 @@ NSString* serviceIDForJabberUID(NSString *UID);
 	 * In case of more then one, they are will be NSArrays containing NSStrings.
 	 */	
 	id				addedPeopleUniqueIDs, modifiedPeopleUniqueIDs, deletedPeopleUniqueIDs;
-	NSMutableSet	*allModifiedPeople = [[NSMutableSet alloc] init];
-	ABPerson		*me = [sharedAddressBook me];
-	BOOL			modifiedMe = NO;;
+	NSMutableSet	*changedUniqueIDs = [NSMutableSet set];
+	NSMutableSet	*deletedUniqueIDs = [NSMutableSet set];
+	NSMutableArray	*affectedMatches = [NSMutableArray array];
+	NSString		*meUniqueID = [[sharedAddressBook me] uniqueId];
+
+	if (!addressBookSync) return;
 
 	//Delay listObjectNotifications to speed up metaContact creation
 	[[AIContactObserverManager sharedManager] delayListObjectNotifications];
 
 	//Addition of new records
 	if ((addedPeopleUniqueIDs = [[notification userInfo] objectForKey:kABInsertedRecords])) {
-		NSArray	*peopleToAdd;
-
 		if ([addedPeopleUniqueIDs isKindOfClass:[NSArray class]]) {
 			//We are dealing with multiple records
-			peopleToAdd = [sharedAddressBook peopleFromUniqueIDs:(NSArray *)addedPeopleUniqueIDs];
+			[changedUniqueIDs addObjectsFromArray:addedPeopleUniqueIDs];
 		} else {
 			//We have only one record
-			peopleToAdd = [NSArray arrayWithObject:(ABPerson *)[sharedAddressBook recordForUniqueId:addedPeopleUniqueIDs]];
+			[changedUniqueIDs addObject:addedPeopleUniqueIDs];
 		}
-		AILogWithSignature(@"Adding %@ to address book", peopleToAdd);
-		[allModifiedPeople addObjectsFromArray:peopleToAdd];
-		[self addToAddressBookDict:peopleToAdd];
+		AILogWithSignature(@"Added %@ to address book", addedPeopleUniqueIDs);
 	}
 	
 	//Modification of existing records
 	if ((modifiedPeopleUniqueIDs = [[notification userInfo] objectForKey:kABUpdatedRecords])) {
-		NSArray	*peopleToAdd;
-
 		if ([modifiedPeopleUniqueIDs isKindOfClass:[NSArray class]]) {
 			//We are dealing with multiple records
-			[self removeFromAddressBookDict:modifiedPeopleUniqueIDs];
-			peopleToAdd = [sharedAddressBook peopleFromUniqueIDs:modifiedPeopleUniqueIDs];
+			[changedUniqueIDs addObjectsFromArray:modifiedPeopleUniqueIDs];
 		} else {
 			//We have only one record
-			[self removeFromAddressBookDict:[NSArray arrayWithObject:modifiedPeopleUniqueIDs]];
-			peopleToAdd = [NSArray arrayWithObject:(ABPerson *)[sharedAddressBook recordForUniqueId:modifiedPeopleUniqueIDs]];
+			[changedUniqueIDs addObject:modifiedPeopleUniqueIDs];
 		}
-		AILogWithSignature(@"Modified unique IDs %@, which correspond to people %@", modifiedPeopleUniqueIDs, peopleToAdd);
-		[allModifiedPeople addObjectsFromArray:peopleToAdd];
-		[self addToAddressBookDict:peopleToAdd];
+		AILogWithSignature(@"Modified %@", modifiedPeopleUniqueIDs);
 	}
 	
 	//Deletion of existing records
 	if ((deletedPeopleUniqueIDs = [[notification userInfo] objectForKey:kABDeletedRecords])) {
 		if ([deletedPeopleUniqueIDs isKindOfClass:[NSArray class]]) {
 			//We are dealing with multiple records
-			[self removeFromAddressBookDict:deletedPeopleUniqueIDs];
+			[deletedUniqueIDs addObjectsFromArray:deletedPeopleUniqueIDs];
 		} else {
 			//We have only one record
-			[self removeFromAddressBookDict:[NSArray arrayWithObject:deletedPeopleUniqueIDs]];
+			[deletedUniqueIDs addObject:deletedPeopleUniqueIDs];
 		}
-		
-		//Note: We have no way of retrieving the records of people who were removed, so we really can't do much here.
 		AILogWithSignature(@"Removed %@", deletedPeopleUniqueIDs);
 	}
-	
-	ABPerson		*person;
-	
-	//Do appropriate updates for each updated ABPerson
-	for (person in allModifiedPeople) {
-		if (person == me) {
-			modifiedMe = YES;
-		}
 
-		//It's tempting to not do this if (person == me), but the 'me' contact may also be in the contact list
-		[[AIContactObserverManager sharedManager] updateContacts:[self contactsForPerson:person]
-									  forObserver:self];
+	//The screen names these people had, so contacts they no longer name are updated, too
+	for (NSString *uniqueID in changedUniqueIDs) {
+		NSArray *matches = [addressBookSync matchesForCardWithUniqueID:uniqueID];
+		if (matches) [affectedMatches addObjectsFromArray:matches];
+	}
+	for (NSString *uniqueID in deletedUniqueIDs) {
+		NSArray *matches = [addressBookSync matchesForCardWithUniqueID:uniqueID];
+		if (matches) [affectedMatches addObjectsFromArray:matches];
+	}
+
+	[addressBookSync removeCardsWithUniqueIDs:deletedUniqueIDs];
+	[addressBookSync updateCardsWithUniqueIDs:changedUniqueIDs];
+	[addressBookSync save];
+
+	if (createMetaContacts) [self groupCardsWithUniqueIDs:changedUniqueIDs];
+
+	//...and the screen names they have now
+	for (NSString *uniqueID in changedUniqueIDs) {
+		NSArray *matches = [addressBookSync matchesForCardWithUniqueID:uniqueID];
+		if (matches) [affectedMatches addObjectsFromArray:matches];
 	}
 
+	//It's tempting to skip the 'me' card here, but the 'me' contact may also be in the contact list
+	[[AIContactObserverManager sharedManager] updateContacts:[self contactsForMatches:affectedMatches]
+												 forObserver:self];
+
 	//Update us if appropriate
-	if (modifiedMe) {
+	if (meUniqueID && [changedUniqueIDs containsObject:meUniqueID]) {
 		[self updateSelfIncludingIcon:YES];
 	}
 	
 	//Stop delaying list object notifications since we are done
 	[[AIContactObserverManager sharedManager] endListObjectNotificationsDelay];
-	[allModifiedPeople release];
 }
 
 /*!
@@ -1032,299 +938,92 @@ NSString* serviceIDForJabberUID(NSString *UID);
 
 #pragma mark Address book caching
 /*!
- * @brief rebuild our address book lookup dictionary
+ * @brief Bring our address book index up to date
+ *
+ * Only people modified since the last launch are read; the rest of the index is loaded from our caches. Metacontacts
+ * made from cards aren't saved, so every card with more than one screen name is grouped again, from the stored names.
  */
-- (void)rebuildAddressBookDict
+- (void)synchronizeAddressBook
 {
 	//Delay listObjectNotifications to speed up metaContact creation
 	[[AIContactObserverManager sharedManager] delayListObjectNotifications];
 	
-	[addressBookDict release]; addressBookDict = [[NSMutableDictionary alloc] init];
-	
-	[self addToAddressBookDict:[sharedAddressBook people]];
-
-	//Stop delaying list object notifications since we are done
-	[[AIContactObserverManager sharedManager] endListObjectNotificationsDelay];
-}
-
+	if (!addressBookSync) {
+		AIAddressBookContactSource *contactSource = [[AIAddressBookContactSource alloc] initWithAddressBook:sharedAddressBook
+																				   instantMessageProperties:serviceDict];
+		addressBookSync = [[AIContactSourceSync alloc] initWithContactSource:contactSource
+																   statePath:[adium.cachesPath stringByAppendingPathComponent:@"AddressBookSync.plist"]];
+		[contactSource release];
+	}
 
-/*!
- * @brief Service ID for an OSCAR UID
- *
- * If we are on an OSCAR service we need to resolve our serviceID into the appropriate string
- * because we may have a .Mac, an ICQ, or an AIM name in the field
- */
-NSString* serviceIDForOscarUID(NSString *UID)
-{
-	NSString	*serviceID;
+	NSSet *changedUniqueIDs = [addressBookSync synchronize];
+	AILogWithSignature(@"%lu people changed since %@; read %lu",
+					   (unsigned long)changedUniqueIDs.count, addressBookSync.lastSyncDate, (unsigned long)addressBookSync.cardsRead);
 
-	const char	firstCharacter = [UID characterAtIndex:0];
-	
-	//Determine service based on UID
-	if ([UID hasSuffix:@"@mac.com"]) {
-		serviceID = @"Mac";
-	} else if ([UID hasSuffix:@"@me.com"]) {
-		serviceID = @"MobileMe";
-	} else if (firstCharacter >= '0' && firstCharacter <= '9') {
-		serviceID = @"ICQ";
-	} else {
-		serviceID = @"AIM";
-	}
-	
-	return serviceID;
-}
+	if (createMetaContacts) [self groupCardsWithUniqueIDs:[addressBookSync uniqueIDsOfCardsWithMultipleMatches]];
 
-/*!
- * @brief Service ID for a Jabber UID
- *
- * If we are on the Jabber server, we need to distinguish between Google Talk (GTalk), LiveJournal, and the rest of the
- * Jabber world. serviceID is already Jabber, so we only need to change if we have a special UID.
- */
-NSString* serviceIDForJabberUID(NSString *UID)
-{
-	NSString	*serviceID;
-
-	if ([UID hasSuffix:@"@gmail.com"] ||
-		[UID hasSuffix:@"@googlemail.com"] ||
-        [UID hasSuffix:@"@public.talk.google.com"]) {
-		serviceID = @"GTalk";
-	} else if ([UID hasSuffix:@"@livejournal.com"]) {
-		serviceID = @"LiveJournal";
-	} else {
-		serviceID = @"Jabber";
-	}
-	
-	return serviceID;
+	//Stop delaying list object notifications since we are done
+	[[AIContactObserverManager sharedManager] endListObjectNotificationsDelay];
 }
 
 /*!
- * @brief add people to our address book lookup dictionary
+ * @brief Group the screen names on each card into a metaContact
  *
- * Rather than continually searching the address book, a lookup dictionary addressBookDict provides an quick and easy
- * way to look up a unique record ID for an ABPerson based on the service and UID of a contact. addressBookDict contains
- * NSDictionary objects keyed by service ID. Each of these NSDictionary objects contains unique record IDs keyed by compacted
- * (that is, no spaces and no all lowercase) UID. This means we can search while ignoring spaces, which normal AB searching
- * does not allow.
- *
- * In the process of building we look for cards which have multiple screen names listed and, if desired, automatically
- * create metaContacts baesd on this information.
+ * Cards with fewer than two screen names are skipped.
  */
-- (void)addToAddressBookDict:(NSArray *)people
+- (void)groupCardsWithUniqueIDs:(id <NSFastEnumeration>)uniqueIDs
 {
-	NSArray				*allServiceKeys = [serviceDict allKeys];
-	ABPerson			*person;
-	
-	for (person in people) {
-		NSString			*serviceID;
-		
-		NSMutableArray		*UIDsArray = [NSMutableArray array];
-		NSMutableArray		*servicesArray = [NSMutableArray array];
-		
-		NSMutableDictionary	*dict;
-		ABMultiValue		*emails;
-		ABMultiValue		*homepages;
-		NSInteger					i, emailsCount, homepagesCount;
-		
-		//An ABPerson may have multiple emails; iterate through them looking for @mac.com addresses
-		{
-			emails = [person valueForProperty:kABEmailProperty];
-			emailsCount = [emails count];
-			
-			for (i = 0; i < emailsCount ; i++) {
-				NSString	*email;
-				
-				email = [emails valueAtIndex:i];
-				if ([email hasSuffix:@"@mac.com"]) {
-					//@mac.com UIDs go into the AIM dictionary
-					if (!(dict = [addressBookDict objectForKey:@"AIM"])) {
-						dict = [[[NSMutableDictionary alloc] init] autorelease];
-						[addressBookDict setObject:dict forKey:@"AIM"];
-					}
-					
-					[dict setObject:[person uniqueId] forKey:email];
-					
-					//Internally we distinguish them as .Mac addresses (for metaContact purposes below)
-					[UIDsArray addObject:email];
-					[servicesArray addObject:@"Mac"];
-
-				} else if ([email hasSuffix:@"me.com"]) {
-					//@me.com UIDs go into the AIM dictionary
-					if (!(dict = [addressBookDict objectForKey:@"AIM"])) {
-						dict = [[[NSMutableDictionary alloc] init] autorelease];
-						[addressBookDict setObject:dict forKey:@"AIM"];
-					}
-					
-					[dict setObject:[person uniqueId] forKey:email];
-					
-					//Internally we distinguish them as .Mac addresses (for metaContact purposes below)
-					[UIDsArray addObject:email];
-					[servicesArray addObject:@"MobileMe"];
-					
-				} else if ([email hasSuffix:@"gmail.com"] || [email hasSuffix:@"googlemail.com"]) {
-					//GTalk UIDs go into the Jabber dictionary
-					if (!(dict = [addressBookDict objectForKey:@"Jabber"])) {
-						dict = [[[NSMutableDictionary alloc] init] autorelease];
-						[addressBookDict setObject:dict forKey:@"Jabber"];
-					}
-					
-					[dict setObject:[person uniqueId] forKey:email];
-					
-					//Internally we distinguish them as Google Talk addresses (for metaContact purposes below)
-					[UIDsArray addObject:email];
-					[servicesArray addObject:@"GTalk"];
-					
-				} else if ([email hasSuffix:@"hotmail.com"]) {
-					//GTalk UIDs go into the Jabber dictionary
-					if (!(dict = [addressBookDict objectForKey:@"MSN"])) {
-						dict = [[[NSMutableDictionary alloc] init] autorelease];
-						[addressBookDict setObject:dict forKey:@"MSN"];
-					}
-					
-					[dict setObject:[person uniqueId] forKey:email];
-					
-					[UIDsArray addObject:email];
-					[servicesArray addObject:@"MSN"];
-				}
-			}
-		}
+	for (NSString *uniqueId in uniqueIDs) {
+		NSArray				*matches = [addressBookSync matchesForCardWithUniqueID:uniqueId];
 		
-		//An ABPerson may have multiple hompages; iterate through them looking for fb:// addresses
-		{
-			homepages = [person valueForProperty:kABURLsProperty];
-			homepagesCount = [homepages count];
-			
-			for (i = 0; i < homepagesCount ; i++) {
-				NSURL	*homepage = [NSURL URLWithString:(NSString*)[homepages valueAtIndex:i]];
-				if ([[homepage scheme] isEqualToString:@"fb"]) {
-					//Retrieve all appropriate contacts
-					//This will be fb://profile/XXX where XXX is the UID
-					NSString	*facebookNumber = (NSString*)[(NSString*)homepage lastPathComponent];
-					NSString	*facebookUID = [NSString stringWithFormat:@"-%@@chat.facebook.com", facebookNumber];
-					if (!(dict = [addressBookDict objectForKey:@"Facebook"])) {
-						dict = [[[NSMutableDictionary alloc] init] autorelease];
-						[addressBookDict setObject:dict forKey:@"Facebook"];
-					}
-												
-					[dict setObject:[person uniqueId] forKey:facebookUID];
-												
-					//Add them to our set
-					[UIDsArray addObject:facebookUID];
-					[servicesArray addObject:@"Facebook"];
-				}
-			}
+		if ([matches count] < 2) continue;
+
+		/* Got a record with multiple names. Group the names together, adding them to the meta contact. */
+		NSArray			*UIDsArray = [matches valueForKey:@"UID"];
+		NSArray			*servicesArray = [matches valueForKey:@"serviceID"];
+		AIMetaContact	*metaContact, *metaContactHint;
+
+		metaContactHint = [adium.contactController knownMetaContactForGroupingUIDs:UIDsArray
+																	 forServices:servicesArray];
+		if (!metaContactHint) {
+			/* Find a metacontact we used previously but which wasn't saved, if possible. This keeps us from creating a 
+			 * new metacontact with every launch when the metacontact is created by the address book rather than the user.
+			 *
+			 * We don't make address book metacontacts actually persistent because then we would persist them even if the address
+			 * book card were modified or deleted or if the user disabled "Conslidate contacts listed on the card."
+			 */
+			NSDictionary *prefsDict = [adium.preferenceController preferenceForKey:KEY_AB_TO_METACONTACT_DICT
+																		  group:PREF_GROUP_ADDRESSBOOK];
+			NSNumber *metaContactObjectID = [prefsDict objectForKey:uniqueId];
+			if (metaContactObjectID)
+				metaContactHint = [adium.contactController metaContactWithObjectID:metaContactObjectID];
 		}
-												
-		//Now go through the instant messaging keys
-		for (serviceID in allServiceKeys) {
-			NSString			*addressBookKey = [serviceDict objectForKey:serviceID];
-			ABMultiValue		*names;
-			NSInteger					nameCount;
-			
-			//An ABPerson may have multiple names; iterate through them
-			names = [person valueForProperty:addressBookKey];
-			nameCount = [names count];
-			
-			//Continue to the next serviceID immediately if no names are found
-			if (nameCount == 0) continue;
-			
-			//One or more names were found, so we'll need a dictionary
-			if (!(dict = [addressBookDict objectForKey:serviceID])) {
-				dict = [[NSMutableDictionary alloc] init];
-				[addressBookDict setObject:dict forKey:serviceID];
-				[dict release];
-			}
-			
-			BOOL	isOSCAR = ([serviceID isEqualToString:@"AIM"] || 
-							   [serviceID isEqualToString:@"ICQ"]);
-			BOOL	isJabber = [serviceID isEqualToString:@"Jabber"] ||
-			[serviceID isEqualToString:@"XMPP"];
 			
-			for (i = 0 ; i < nameCount ; i++) {
-				NSString	*UID = [[names valueAtIndex:i] compactedString];
-				if ([UID length]) {
-					[dict setObject:[person uniqueId] forKey:UID];
-					
-					[UIDsArray addObject:UID];
-					
-					if (isOSCAR) {
-						serviceID = serviceIDForOscarUID(UID);
-						
-					} else if (isJabber) {
-						serviceID = serviceIDForJabberUID(UID);
-					}
-					
-					[servicesArray addObject:serviceID];
-				}
-			}
-		}
-
-		if (([UIDsArray count] > 1) && createMetaContacts) {
-			/* Got a record with multiple names. Group the names together, adding them to the meta contact. */
-			AIMetaContact *metaContact, *metaContactHint;
-			NSString *uniqueId = [person uniqueId];
-
-			metaContactHint = [adium.contactController knownMetaContactForGroupingUIDs:UIDsArray
-																		 forServices:servicesArray];
-			if (!metaContactHint) {
-				/* Find a metacontact we used previously but which wasn't saved, if possible. This keeps us from creating a 
-				 * new metacontact with every launch when the metacontact is created by the address book rather than the user.
-				 *
-				 * We don't make address book metacontacts actually persistent because then we would persist them even if the address
-				 * book card were modified or deleted or if the user disabled "Conslidate contacts listed on the card."
-				 */
-				NSDictionary *prefsDict = [adium.preferenceController preferenceForKey:KEY_AB_TO_METACONTACT_DICT
-																			  group:PREF_GROUP_ADDRESSBOOK];
-				NSNumber *metaContactObjectID = [prefsDict objectForKey:uniqueId];
-				if (metaContactObjectID)
-					metaContactHint = [adium.contactController metaContactWithObjectID:metaContactObjectID];
-			}
-				
-			metaContact = [adium.contactController groupUIDs:UIDsArray 
-												   forServices:servicesArray
-										  usingMetaContactHint:metaContactHint];
-			if (metaContact) {
-				[metaContact setValue:uniqueId
-						  forProperty:KEY_AB_UNIQUE_ID
-							   notify:NotifyNever];
-
-				[personUniqueIdToMetaContactDict setObject:metaContact
-													forKey:uniqueId];
-				if (metaContact != metaContactHint) {
-					//Keep track of the use of this metacontact for this address book card
-					NSMutableDictionary *prefsDict = [[[adium.preferenceController preferenceForKey:KEY_AB_TO_METACONTACT_DICT
-																						   group:PREF_GROUP_ADDRESSBOOK] mutableCopy] autorelease];
-					if (!prefsDict) prefsDict = [NSMutableDictionary dictionary];
-					[prefsDict setObject:[metaContact objectID]
-                                  forKey:uniqueId];
-					[adium.preferenceController setPreference:prefsDict
-														 forKey:@"UniqueIDToMetaContactObjectIDDictionary"
-														  group:PREF_GROUP_ADDRESSBOOK];
-				}
+		metaContact = [adium.contactController groupUIDs:UIDsArray 
+											   forServices:servicesArray
+									  usingMetaContactHint:metaContactHint];
+		if (metaContact) {
+			[metaContact setValue:uniqueId
+					  forProperty:KEY_AB_UNIQUE_ID
+						   notify:NotifyNever];
+
+			[personUniqueIdToMetaContactDict setObject:metaContact
+												forKey:uniqueId];
+			if (metaContact != metaContactHint) {
+				//Keep track of the use of this metacontact for this address book card
+				NSMutableDictionary *prefsDict = [[[adium.preferenceController preferenceForKey:KEY_AB_TO_METACONTACT_DICT
+																					   group:PREF_GROUP_ADDRESSBOOK] mutableCopy] autorelease];
+				if (!prefsDict) prefsDict = [NSMutableDictionary dictionary];
+				[prefsDict setObject:[metaContact objectID]
+							  forKey:uniqueId];
+				[adium.preferenceController setPreference:prefsDict
+													 forKey:@"UniqueIDToMetaContactObjectIDDictionary"
+													  group:PREF_GROUP_ADDRESSBOOK];
 			}
 		}
 	}
 }
 
-/*!
- * @brief remove people from our address book lookup dictionary
- */
-- (void)removeFromAddressBookDict:(NSArray *)uniqueIDs
-{
-	for (NSString *uniqueID in uniqueIDs) {
-		
-		//The same person may have multiple services; iterate through them and remove each one.
-		for (NSString *serviceID in [serviceDict allKeys]) {
-			
-			NSMutableDictionary *dict = [addressBookDict objectForKey:serviceID];
-			
-			//The same person may have multiple accounts from the same service; we should remove them all.
-			for (NSString *key in [dict allKeysForObject:uniqueID]) {
-				[dict removeObjectForKey:key];
-			}
-		}
-	}	
-}
-
 #pragma mark AB contextual menu
 
 /*!
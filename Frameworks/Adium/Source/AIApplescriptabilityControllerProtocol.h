@@ -16,7 +16,15 @@
 
 #import <Adium/AIControllerProtocol.h>
 
+@class AIScriptExecutorPool;
+
 @protocol AIApplescriptabilityController <AIController>
+/*!
+ * @brief The pool which runs AppleScripts in the helper; use it directly for timeouts and cached results
+ */
+@property (readonly, nonatomic) AIScriptExecutorPool *scriptExecutorPool;
+
+
 - (void)runApplescriptAtPath:(NSString *)inPath 
 					function:(NSString *)function
 				   arguments:(NSArray *)arguments
@@ -28,6 +28,7 @@
 #define Chat_AttributesChanged					@"Chat_AttributesChanged"
 #define Chat_StatusChanged						@"Chat_StatusChagned"
 #define Chat_ParticipatingListObjectsChanged	@"Chat_ParticipatingListObjectsChanged"
+#define Chat_ParticipantsDidChange				@"Chat_ParticipantsDidChange"
 #define Chat_SourceChanged 						@"Chat_SourceChanged"
 #define Chat_DestinationChanged 				@"Chat_DestinationChanged"
 
@@ -38,6 +39,9 @@
 #define	KEY_CHAT_TIMED_OUT		@"Timed Out"
 #define KEY_CHAT_CLOSED_WINDOW	@"Closed Window"
 
+//userInfo key of Chat_ParticipantsDidChange: an NSArray of AIChatParticipantChange, oldest first
+#define KEY_CHAT_PARTICIPANT_CHANGES	@"ParticipantChanges"
+
 #define KEY_TOPIC @"topic"
 #define KEY_TOPIC_SETTER @"topicSetter"
 
@@ -46,6 +50,13 @@ typedef enum {
 	AIChatClosedWindow
 } AIChatUpdateType;
 
+typedef enum {
+	AIChatParticipantJoined = 0,
+	AIChatParticipantLeft,
+	AIChatParticipantRenamed,
+	AIChatParticipantFlagsChanged
+} AIChatParticipantChangeType;
+
 typedef enum {
 	AIChatCanNotSendMessage = 0,
 	AIChatMayNotBeAbleToSendMessage,
@@ -97,6 +108,22 @@ typedef enum {
 	AIChatInvalidNumberOfArguments
 } AIChatErrorType;
 
+/*!
+ * @class AIChatParticipantChange
+ * @brief One entry in a chat's journal of participant changes
+ */
+@interface AIChatParticipantChange : NSObject {
+	AIChatParticipantChangeType	 type;
+	AIListContact				*contact;
+}
+
++ (AIChatParticipantChange *)changeWithType:(AIChatParticipantChangeType)inType contact:(AIListContact *)inContact;
+
+@property (readonly, nonatomic) AIChatParticipantChangeType type;
+@property (readonly, nonatomic) AIListContact *contact;
+
+@end
+
 @interface AIChat : ESObjectWithProperties <AIContainingObject> {
 	AIAccount			*account;
 	NSDate				*dateOpened;
@@ -112,6 +139,7 @@ typedef enum {
 	NSMutableDictionary	*participatingContactsFlags;
 	NSMutableDictionary	*participatingContactsAliases;
 	NSMutableArray		*participatingContacts;
+	NSMutableArray		*participantChanges;
 	
 	AIListContact		*preferredContact;
 	NSString			*name;
@@ -176,6 +204,8 @@ typedef enum {
 - (void)removeSavedValuesForContactUID:(NSString *)contactUID;
 
 - (void)resortParticipants;
+- (void)flushParticipantChanges;
++ (NSUInteger)participantComparisonCount;
 
 - (void)addParticipatingListObject:(AIListContact *)inObject notify:(BOOL)notify;
 - (void)addParticipatingListObjects:(NSArray *)inObjects notify:(BOOL)notify;
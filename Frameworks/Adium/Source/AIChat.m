@@ -49,6 +49,41 @@
 - (void)clearListObjectStatuses;
 
 - (AIListContact *)visibleObjectAtIndex:(NSUInteger)idx;
+
+- (void)noteParticipantChange:(AIChatParticipantChangeType)type forContact:(AIListContact *)contact;
+- (void)repositionParticipantsForChanges:(NSArray *)changes;
+- (void)removeAllParticipatingContactsUnjournaled;
+@end
+
+//Above one changed participant in this many, resort the whole list rather than moving each one
+#define FULL_RESORT_FRACTION	4
+
+@implementation AIChatParticipantChange
+
++ (AIChatParticipantChange *)changeWithType:(AIChatParticipantChangeType)inType contact:(AIListContact *)inContact
+{
+	AIChatParticipantChange *change = [[self alloc] init];
+
+	change->type = inType;
+	change->contact = [inContact retain];
+
+	return [change autorelease];
+}
+
+- (void)dealloc
+{
+	[contact release];
+
+	[super dealloc];
+}
+
+@synthesize type, contact;
+
+- (NSString *)description
+{
+	return [NSString stringWithFormat:@"<%@: %p; type %d, %@>", NSStringFromClass([self class]), self, type, contact];
+}
+
 @end
 
 @implementation AIChat
@@ -105,8 +140,9 @@ static int nextChatNumber = 0;
 	AILog(@"[%@ dealloc]",self);
 
 	[account release];
-	[self removeAllParticipatingContactsSilently];
+	[self removeAllParticipatingContactsUnjournaled];
 	[participatingContacts release];
+	[participantChanges release];
 	[participatingContactsFlags release];
 	[participatingContactsAliases release];
 	[dateOpened release];
@@ -368,8 +404,13 @@ static int nextChatNumber = 0;
  */
 - (void)setFlags:(AIGroupChatFlags)flags forContact:(AIListObject *)contact
 {
+	NSNumber *oldFlags = [participatingContactsFlags objectForKey:contact.UID];
+
+	if (oldFlags && [oldFlags integerValue] == flags) return;
+
 	[participatingContactsFlags setObject:[NSNumber numberWithInteger:flags]
 								   forKey:contact.UID];
+	[self noteParticipantChange:AIChatParticipantFlagsChanged forContact:(AIListContact *)contact];
 }
 
 /*!
@@ -377,8 +418,11 @@ static int nextChatNumber = 0;
  */
 - (void)setAlias:(NSString *)alias forContact:(AIListObject *)contact
 {
+	if ([alias isEqualToString:[participatingContactsAliases objectForKey:contact.UID]]) return;
+
 	[participatingContactsAliases setObject:alias
 									 forKey:contact.UID];
+	[self noteParticipantChange:AIChatParticipantRenamed forContact:(AIListContact *)contact];
 }
 
 AIGroupChatFlags highestFlag(AIGroupChatFlags flags)
@@ -398,10 +442,14 @@ AIGroupChatFlags highestFlag(AIGroupChatFlags flags)
 	return AIGroupChatNone;
 }
 
+static NSUInteger participantComparisonCount = 0;
+
 NSComparisonResult userListSort (id objectA, id objectB, void *context)
 {
 	AIChat *chat = (AIChat *)context;
 	
+	participantComparisonCount++;
+	
 	AIGroupChatFlags flagA = highestFlag([chat flagsForContact:objectA]), flagB = highestFlag([chat flagsForContact:objectB]);
 	
 	if(flagA > flagB) {
@@ -423,6 +471,107 @@ NSComparisonResult userListSort (id objectA, id objectB, void *context)
 	[participatingContacts sortUsingFunction:userListSort context:self];
 }
 
+/*!
+ * @brief The number of participant comparisons made by every chat so far
+ *
+ * For measuring the cost of keeping user lists sorted. Main thread only.
+ */
++ (NSUInteger)participantComparisonCount
+{
+	return participantComparisonCount;
+}
+
+/*!
+ * @brief Journal a change to a participant
+ *
+ * Changes made in one turn of the run loop, such as a netsplit's worth of parts, are applied and announced together.
+ */
+- (void)noteParticipantChange:(AIChatParticipantChangeType)type forContact:(AIListContact *)contact
+{
+	if (!participantChanges) {
+		participantChanges = [[NSMutableArray alloc] init];
+		[self performSelector:@selector(flushParticipantChanges)
+				   withObject:nil
+				   afterDelay:0];
+	}
+
+	[participantChanges addObject:[AIChatParticipantChange changeWithType:type contact:contact]];
+}
+
+/*!
+ * @brief Apply the journaled participant changes now
+ *
+ * Moves the changed participants to their sorted positions, then posts Chat_ParticipantsDidChange with the journal.
+ * This happens by itself at the end of the run loop turn in which the changes were made.
+ */
+- (void)flushParticipantChanges
+{
+	if (!participantChanges) return;
+
+	NSArray *changes = [participantChanges autorelease];
+	participantChanges = nil;
+
+	[self repositionParticipantsForChanges:changes];
+
+	[[NSNotificationCenter defaultCenter] postNotificationName:Chat_ParticipantsDidChange
+														object:self
+													  userInfo:[NSDictionary dictionaryWithObject:changes
+																						   forKey:KEY_CHAT_PARTICIPANT_CHANGES]];
+}
+
+/*!
+ * @brief Move the participants named in changes to their sorted positions
+ *
+ * Everyone else is still in order, so rather than sorting the whole list, the changed participants are taken out in
+ * one pass and binary searched back in. When much of the list changed at once, as on joining a busy channel, a full
+ * sort is cheaper.
+ */
+- (void)repositionParticipantsForChanges:(NSArray *)changes
+{
+	NSMutableSet	*changedContacts = [NSMutableSet set];
+
+	for (AIChatParticipantChange *change in changes) {
+		if (change.type != AIChatParticipantLeft) [changedContacts addObject:change.contact];
+	}
+
+	if (!changedContacts.count) return;
+
+	if (changedContacts.count > participatingContacts.count / FULL_RESORT_FRACTION) {
+		[self resortParticipants];
+		return;
+	}
+
+	NSMutableArray		*moving = [NSMutableArray arrayWithCapacity:changedContacts.count];
+	NSMutableIndexSet	*movingIndexes = [NSMutableIndexSet indexSet];
+	NSUInteger			idx = 0;
+
+	for (AIListContact *contact in participatingContacts) {
+		if ([changedContacts containsObject:contact]) {
+			[moving addObject:contact];
+			[movingIndexes addIndex:idx];
+		}
+		idx++;
+	}
+
+	[participatingContacts removeObjectsAtIndexes:movingIndexes];
+
+	for (AIListContact *contact in moving) {
+		NSUInteger low = 0, high = participatingContacts.count;
+
+		//After any equals, as a stable sort would leave it
+		while (low < high) {
+			NSUInteger mid = (low + high) / 2;
+
+			if (userListSort([participatingContacts objectAtIndex:mid], contact, self) == NSOrderedDescending)
+				high = mid;
+			else
+				low = mid + 1;
+		}
+
+		[participatingContacts insertObject:contact atIndex:low];
+	}
+}
+
 /*!
  * @brief Remove the saved values for a contact
  *
@@ -450,6 +599,9 @@ NSComparisonResult userListSort (id objectA, id objectB, void *context)
 	}
 	
 	[participatingContacts addObjectsFromArray:contacts];
+	for (AIListContact *contact in contacts) {
+		[self noteParticipantChange:AIChatParticipantJoined forContact:contact];
+	}
 	[adium.chatController chat:self addedListContacts:contacts notify:notify];
 	[contacts release];
 }
@@ -484,6 +636,7 @@ NSComparisonResult userListSort (id objectA, id objectB, void *context)
 {
 	if (inListObject != self.listObject) {
 		if (self.countOfContainedObjects) {
+			[self noteParticipantChange:AIChatParticipantLeft forContact:[participatingContacts objectAtIndex:0]];
 			[participatingContacts removeObjectAtIndex:0];
 		}
 		[self addParticipatingListObject:inListObject notify:YES];
@@ -712,6 +865,7 @@ NSComparisonResult userListSort (id objectA, id objectB, void *context)
 		[inObject retain];
 		
 		[participatingContacts removeObject:inObject];
+		[self noteParticipantChange:AIChatParticipantLeft forContact:contact];
 		
 		[self removeSavedValuesForContactUID:inObject.UID];
 
@@ -736,6 +890,18 @@ NSComparisonResult userListSort (id objectA, id objectB, void *context)
 }
 
 - (void)removeAllParticipatingContactsSilently
+{
+	for (AIListContact *listContact in participatingContacts) {
+		[self noteParticipantChange:AIChatParticipantLeft forContact:listContact];
+	}
+
+	[self removeAllParticipatingContactsUnjournaled];
+}
+
+/*!
+ * @brief Remove every participant without journaling it, as when deallocating
+ */
+- (void)removeAllParticipatingContactsUnjournaled
 {
 	/* Note that allGroupChatsContainingContact won't count this chat if it's already marked as not open */
 	for (AIListContact *listContact in self) {
@@ -749,6 +915,7 @@ NSComparisonResult userListSort (id objectA, id objectB, void *context)
 	[participatingContacts removeAllObjects];
 	[participatingContactsFlags removeAllObjects];
 	[participatingContactsAliases removeAllObjects];
+	[adium.chatController chatRemovedAllListContacts:self];
 
 	[[NSNotificationCenter defaultCenter] postNotificationName:Chat_ParticipatingListObjectsChanged
 											  object:self];
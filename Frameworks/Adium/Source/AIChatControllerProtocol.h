@@ -61,6 +61,7 @@
 	//Addition/removal of contacts to group chats
 - (void)chat:(AIChat *)chat addedListContacts:(NSArray *)contacts notify:(BOOL)notify;
 - (void)chat:(AIChat *)chat removedListContact:(AIListContact *)inContact;
+- (void)chatRemovedAllListContacts:(AIChat *)chat;
 
 - (NSString *)defaultInvitationMessageForRoom:(NSString *)room account:(AIAccount *)inAccount;
 @end
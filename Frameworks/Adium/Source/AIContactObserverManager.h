@@ -15,7 +15,7 @@
  */
 #import <Cocoa/Cocoa.h>
 
-@class AIListObject, AIListContact;
+@class AIListObject, AIListContact, AIWheelTimer;
 
 //Observer which receives notifications of changes in list object status
 @protocol AIListObjectObserver
@@ -26,7 +26,7 @@
 	//Status and Attribute updates
 	NSMutableSet			*contactObservers;
 	NSMutableSet			*removedContactObservers;
-	NSTimer					*delayedUpdateTimer;
+	AIWheelTimer			*delayedUpdateTimer;
 	NSInteger				quietDelayedUpdatePeriodsRemaining;
 	
 	
@@ -41,6 +41,8 @@
 	BOOL						informingObservers;
 	NSInteger				delayedContactChanges;
 	NSInteger				delayedUpdateRequests;
+
+	NSMutableDictionary		*observerCosts;
 }
 
 + (AIContactObserverManager *)sharedManager;
@@ -61,4 +63,7 @@
 
 - (void)noteContactChanged:(AIListObject *)inObject;
 
+- (void)beginProfilingObservers;
+- (NSDictionary *)endProfilingObservers;
+
 @end
@@ -24,6 +24,7 @@
 #import <Adium/AIMetaContact.h>
 #import <Adium/AIListBookmark.h>
 #import <Adium/AISortController.h>
+#import <AIUtilities/AITimerWheel.h>
 
 /*
  #ifdef DEBUG_BUILD
@@ -35,10 +36,18 @@
 	#import <Foundation/NSDebug.h>
 #endif
 
+#import <mach/mach_time.h>
+
+typedef struct {
+	NSUInteger	calls;
+	uint64_t	machTime;
+} AIObserverCost;
+
 @interface AIContactObserverManager ()
 - (NSSet *)_informObserversOfObjectStatusChange:(AIListObject *)inObject withKeys:(NSSet *)modifiedKeys silent:(BOOL)silent;
-- (void)_performDelayedUpdates:(NSTimer *)timer;
-@property (nonatomic, retain) NSTimer *delayedUpdateTimer;
+- (void)_performDelayedUpdates:(AIWheelTimer *)timer;
+- (NSSet *)_observer:(id <AIListObjectObserver>)observer updateListObject:(AIListObject *)inObject keys:(NSSet *)inModifiedKeys silent:(BOOL)silent;
+@property (nonatomic, retain) AIWheelTimer *delayedUpdateTimer;
 @end
 
 #define UPDATE_CLUMP_INTERVAL			1.0
@@ -74,6 +83,7 @@ static AIContactObserverManager *sharedObserverManager = nil;
 	[contactObservers release]; contactObservers = nil;
 	[delayedModifiedStatusKeys release];
 	[delayedModifiedAttributeKeys release];
+	[observerCosts release];
 	self.delayedUpdateTimer = nil;
 
 	[super dealloc];
@@ -168,16 +178,16 @@ static AIContactObserverManager *sharedObserverManager = nil;
 {
     if (!delayedUpdateTimer) {
 		updatesAreDelayedUntilInactivity = YES;
-		self.delayedUpdateTimer = [NSTimer scheduledTimerWithTimeInterval:UPDATE_CLUMP_INTERVAL
-																   target:self
-																 selector:@selector(_performDelayedUpdates:)
-																 userInfo:nil
-																  repeats:YES];
+		self.delayedUpdateTimer = [[AITimerWheel sharedTimerWheel] scheduleTimerWithDelay:UPDATE_CLUMP_INTERVAL
+																		   repeatInterval:UPDATE_CLUMP_INTERVAL
+																				   target:self
+																				 selector:@selector(_performDelayedUpdates:)
+																				 userInfo:nil];
 		quietDelayedUpdatePeriodsRemaining = QUIET_DELAYED_UPDATE_PERIODS; 
 
     } else {
 		//Reset the timer
-		[delayedUpdateTimer setFireDate:[NSDate dateWithTimeIntervalSinceNow:UPDATE_CLUMP_INTERVAL]];
+		[delayedUpdateTimer rescheduleAfterDelay:UPDATE_CLUMP_INTERVAL];
 		quietDelayedUpdatePeriodsRemaining = QUIET_DELAYED_UPDATE_PERIODS;
 	}
 }
@@ -210,6 +220,8 @@ static AIContactObserverManager *sharedObserverManager = nil;
 {
     NSSet			*modifiedAttributeKeys;
 	
+	[inObject incrementDisplayVersion];
+	
     //Let all observers know the contact's status has changed before performing any sorting or further notifications
 	modifiedAttributeKeys = [self _informObserversOfObjectStatusChange:inObject withKeys:inModifiedKeys silent:silent];
 	
@@ -236,6 +248,9 @@ static AIContactObserverManager *sharedObserverManager = nil;
 - (void)listObjectAttributesChanged:(AIListObject *)inObject modifiedKeys:(NSSet *)inModifiedKeys
 {
 	BOOL shouldDelay = [self shouldDelayUpdates];
+	
+	[inObject incrementDisplayVersion];
+	
 	if (shouldDelay) {
 		delayedAttributeChanges++;
 		[delayedModifiedAttributeKeys unionSet:inModifiedKeys];
@@ -261,7 +276,7 @@ static AIContactObserverManager *sharedObserverManager = nil;
 }
 
 //Performs any delayed list object/handle updates
-- (void)_performDelayedUpdates:(NSTimer *)timer
+- (void)_performDelayedUpdates:(AIWheelTimer *)timer
 {
 	BOOL	updatesOccured = (delayedStatusChanges || delayedAttributeChanges || delayedContactChanges);
 	
@@ -372,7 +387,7 @@ static AIContactObserverManager *sharedObserverManager = nil;
 	
 	for (AIListObject *listObject in en) {
 		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
-		NSSet	*attributes = [inObserver updateListObject:listObject keys:nil silent:YES];
+		NSSet	*attributes = [self _observer:inObserver updateListObject:listObject keys:nil silent:YES];
 		if (attributes) [self listObjectAttributesChanged:listObject modifiedKeys:attributes];
 		
 		if ([listObject isKindOfClass:[AIListContact class]]) {
@@ -380,9 +395,10 @@ static AIContactObserverManager *sharedObserverManager = nil;
 			
 			//If this contact is within a meta contact, update the meta contact too
 			if (contact.metaContact) {
-				attributes = [inObserver updateListObject:contact.metaContact
-															keys:nil
-														  silent:YES];
+				attributes = [self _observer:inObserver
+									updateListObject:contact.metaContact
+												keys:nil
+											  silent:YES];
 				if (attributes) [self listObjectAttributesChanged:contact.metaContact
 													 modifiedKeys:attributes];
 			}
@@ -404,19 +420,19 @@ static AIContactObserverManager *sharedObserverManager = nil;
 	
 	//All bookmarks
 	for (AIListBookmark *listBookmark in [(AIContactController *)adium.contactController bookmarkEnumerator]) {
-		NSSet	*attributes = [inObserver updateListObject:listBookmark keys:nil silent:YES];
+		NSSet	*attributes = [self _observer:inObserver updateListObject:listBookmark keys:nil silent:YES];
 		if (attributes) [self listObjectAttributesChanged:listBookmark modifiedKeys:attributes];
 	}
 	
     //Reset all groups
 	for (AIListGroup *listGroup in [(AIContactController *)adium.contactController groupEnumerator]) {
-		NSSet	*attributes = [inObserver updateListObject:listGroup keys:nil silent:YES];
+		NSSet	*attributes = [self _observer:inObserver updateListObject:listGroup keys:nil silent:YES];
 		if (attributes) [self listObjectAttributesChanged:listGroup modifiedKeys:attributes];
 	}
 	
 	//Reset all accounts
 	for (AIAccount *account in adium.accountController.accounts) {
-		NSSet	*attributes = [inObserver updateListObject:account keys:nil silent:YES];
+		NSSet	*attributes = [self _observer:inObserver updateListObject:account keys:nil silent:YES];
 		if (attributes) [self listObjectAttributesChanged:account modifiedKeys:attributes];
 	}
 	
@@ -448,7 +464,7 @@ static AIContactObserverManager *sharedObserverManager = nil;
 		}
 #endif		
 		
-		NSSet *newKeys = [observer updateListObject:inObject keys:modifiedKeys silent:silent];
+		NSSet *newKeys = [self _observer:observer updateListObject:inObject keys:modifiedKeys silent:silent];
 		if (newKeys) {
 			if (!attrChange) attrChange = [[NSMutableSet alloc] init];
 			[attrChange unionSet:newKeys];
@@ -473,6 +489,8 @@ static AIContactObserverManager *sharedObserverManager = nil;
 //Command all observers to apply their attributes to an object
 - (void)_updateAllAttributesOfObject:(AIListObject *)inObject
 {	
+	[inObject incrementDisplayVersion];
+	
 	for (NSValue *observerValue in [[contactObservers copy] autorelease]) {
 		/* Skip any observer which has been removed while we were iterating over observers,
 		 * as we don't retain observers and therefore risk messaging a released object.
@@ -482,7 +500,7 @@ static AIContactObserverManager *sharedObserverManager = nil;
 
 		id <AIListObjectObserver> observer = [observerValue nonretainedObjectValue];
 		
-		[observer updateListObject:inObject keys:nil silent:YES];
+		[self _observer:observer updateListObject:inObject keys:nil silent:YES];
 	}
 	
 	//If we removed any observers while informing them, we don't need that information any more
@@ -505,4 +523,72 @@ static AIContactObserverManager *sharedObserverManager = nil;
 	delayedContactChanges++;
 }
 
+#pragma mark Observer profiling
+
+/*!
+ * @brief Start accumulating the time each observer class spends updating list objects
+ *
+ * Used by the contact list benchmark. Costs are reset each time profiling begins.
+ */
+- (void)beginProfilingObservers
+{
+	[observerCosts release];
+	observerCosts = [[NSMutableDictionary alloc] init];
+}
+
+/*!
+ * @brief Stop profiling observers
+ *
+ * @result A dictionary keyed by observer class name. Each value is a dictionary with the number of updates (@"Count")
+ *         and the total time spent in them (@"Seconds").
+ */
+- (NSDictionary *)endProfilingObservers
+{
+	mach_timebase_info_data_t	timebase;
+	NSMutableDictionary			*result = [NSMutableDictionary dictionary];
+
+	mach_timebase_info(&timebase);
+
+	for (NSString *className in observerCosts) {
+		const AIObserverCost *cost = [[observerCosts objectForKey:className] bytes];
+		double seconds = (double)cost->machTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+
+		[result setObject:[NSDictionary dictionaryWithObjectsAndKeys:
+						   [NSNumber numberWithUnsignedInteger:cost->calls], @"Count",
+						   [NSNumber numberWithDouble:seconds], @"Seconds",
+						   nil]
+				   forKey:className];
+	}
+
+	[observerCosts release]; observerCosts = nil;
+
+	return result;
+}
+
+/*!
+ * @brief Ask an observer to update a list object, timing it if observers are being profiled
+ */
+- (NSSet *)_observer:(id <AIListObjectObserver>)observer updateListObject:(AIListObject *)inObject keys:(NSSet *)inModifiedKeys silent:(BOOL)silent
+{
+	if (!observerCosts)
+		return [observer updateListObject:inObject keys:inModifiedKeys silent:silent];
+
+	uint64_t	start = mach_absolute_time();
+	NSSet		*result = [observer updateListObject:inObject keys:inModifiedKeys silent:silent];
+	uint64_t	elapsed = mach_absolute_time() - start;
+
+	NSString		*className = NSStringFromClass([(NSObject *)observer class]);
+	NSMutableData	*costData = [observerCosts objectForKey:className];
+	if (!costData) {
+		costData = [NSMutableData dataWithLength:sizeof(AIObserverCost)];
+		[observerCosts setObject:costData forKey:className];
+	}
+
+	AIObserverCost *cost = [costData mutableBytes];
+	cost->calls++;
+	cost->machTime += elapsed;
+
+	return result;
+}
+
 @end
@@ -18,6 +18,7 @@
 
 @protocol AIDebugController <AIController>
 	- (void)addMessage:(NSString *)actualMessage;
+	- (void)addMessages:(NSArray *)messages;
 @property (nonatomic, readonly) NSArray *debugLogArray;
 	- (void)clearDebugLogArray;
 @end
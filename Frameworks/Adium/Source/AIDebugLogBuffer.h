@@ -0,0 +1,48 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*!
+ * @brief Debug log message buffering
+ *
+ * AILog() and friends don't format anything on the calling thread. Each thread records the format string and
+ * its raw arguments into its own fixed-size ring; a background thread drains the rings, renders the messages in
+ * order, writes them to the debug log file in one write per pass and hands them to the debug controller in one
+ * batch per pass.
+ *
+ * Objective-C arguments are the exception: strings and numbers are kept as-is, but other objects are described
+ * when the message is recorded, since describing them later on another thread wouldn't be safe.
+ *
+ * If a thread's ring is full, its messages are dropped and the number dropped is logged.
+ */
+
+typedef enum {
+	AIDebugLogMessage = 0,
+	AIDebugLogMessageWithSignature,
+	AIDebugLogMessageWithPrefix
+} AIDebugLogMessageKind;
+
+void AIDebugLogBufferRecord(AIDebugLogMessageKind kind, const char *prefix, int line, const char *queueLabel,
+							NSString *format, va_list arguments);
+
+/*!
+ * @brief Set the file rendered messages are appended to; pass nil to stop writing.
+ */
+void AIDebugLogBufferSetOutputFile(NSFileHandle *fileHandle);
+
+/*!
+ * @brief Render and write out everything recorded so far before returning.
+ */
+void AIDebugLogBufferFlush(void);
@@ -0,0 +1,537 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <Adium/AIDebugLogBuffer.h>
+#import <Adium/AIDebugControllerProtocol.h>
+#import <libkern/OSAtomic.h>
+#import <pthread.h>
+#import <time.h>
+#import <unistd.h>
+
+#define RING_CAPACITY		256		//Records per thread
+#define MAX_ARGUMENTS		10		//Messages with more arguments are formatted when they're recorded
+#define QUEUE_LABEL_LENGTH	48
+#define DRAIN_INTERVAL		(100 * NSEC_PER_MSEC)
+
+typedef enum {
+	AIDebugArgumentInt = 0,
+	AIDebugArgumentLong,
+	AIDebugArgumentLongLong,
+	AIDebugArgumentDouble,
+	AIDebugArgumentCString,
+	AIDebugArgumentPointer,
+	AIDebugArgumentObject
+} AIDebugArgumentType;
+
+typedef union {
+	long long	 i;
+	double		 d;
+	char		*s;
+	void		*p;
+	id			 o;
+} AIDebugArgument;
+
+typedef struct {
+	int64_t			 sequence;
+	CFAbsoluteTime	 time;
+	NSString		*format;
+	char			*prefix;
+	int32_t			 line;
+	uint8_t			 kind;
+	uint8_t			 argumentCount;
+	uint8_t			 argumentTypes[MAX_ARGUMENTS];
+	char			 queueLabel[QUEUE_LABEL_LENGTH];
+	AIDebugArgument	 arguments[MAX_ARGUMENTS];
+} AIDebugLogRecord;
+
+/*!
+ * @brief One thread's records
+ *
+ * Only the owning thread advances head and only the drain advances tail, so neither needs a lock.
+ */
+typedef struct AIDebugLogRing {
+	AIDebugLogRecord		 records[RING_CAPACITY];
+	volatile int64_t		 head;
+	volatile int64_t		 tail;
+	volatile int32_t		 dropped;
+	volatile int32_t		 orphaned;
+	struct AIDebugLogRing	*next;
+} AIDebugLogRing;
+
+static pthread_once_t		 bufferOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t		 ringKey;
+static pthread_mutex_t		 ringListLock = PTHREAD_MUTEX_INITIALIZER;	//Guards the list itself, taken once per thread
+static pthread_mutex_t		 drainLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t		 outputLock = PTHREAD_MUTEX_INITIALIZER;
+static AIDebugLogRing		*rings = NULL;
+static volatile int64_t		 nextSequence = 0;
+static dispatch_semaphore_t	 drainSemaphore = NULL;
+static NSFileHandle			*outputFile = nil;
+
+static void drainRings(void);
+
+#pragma mark Recording
+
+static void ringThreadDidExit(void *ring)
+{
+	//The drain frees it once it's empty
+	OSAtomicCompareAndSwap32Barrier(0, 1, &((AIDebugLogRing *)ring)->orphaned);
+}
+
+static void *drainThread(void *unused)
+{
+	while (1) {
+		dispatch_semaphore_wait(drainSemaphore, dispatch_time(DISPATCH_TIME_NOW, DRAIN_INTERVAL));
+
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		drainRings();
+		[pool release];
+	}
+
+	return NULL;
+}
+
+static void initializeBuffer(void)
+{
+	pthread_t thread;
+
+	pthread_key_create(&ringKey, ringThreadDidExit);
+	drainSemaphore = dispatch_semaphore_create(0);
+
+	pthread_create(&thread, NULL, drainThread, NULL);
+	pthread_detach(thread);
+}
+
+static AIDebugLogRing *ringForCurrentThread(void)
+{
+	AIDebugLogRing *ring = pthread_getspecific(ringKey);
+
+	if (!ring) {
+		ring = calloc(1, sizeof(AIDebugLogRing));
+		pthread_setspecific(ringKey, ring);
+
+		pthread_mutex_lock(&ringListLock);
+		ring->next = rings;
+		rings = ring;
+		pthread_mutex_unlock(&ringListLock);
+	}
+
+	return ring;
+}
+
+/*!
+ * @brief Read the arguments format calls for out of the va_list
+ *
+ * @result NO if the format uses something we don't keep raw (positional arguments, %n, unichar strings, too many arguments).
+ */
+static BOOL captureArguments(AIDebugLogRecord *record, const char *format, va_list arguments)
+{
+	const char *c = format;
+	uint8_t count = 0;
+
+	while ((c = strchr(c, '%'))) {
+		c++;
+		if (*c == '%') {
+			c++;
+			continue;
+		}
+
+		//Flags
+		while (*c && strchr("-+ #0'", *c)) c++;
+
+		//Width and precision; either may be taken from the arguments
+		for (int part = 0; part < 2; part++) {
+			if (*c == '*') {
+				if (count == MAX_ARGUMENTS) return NO;
+				record->argumentTypes[count] = AIDebugArgumentInt;
+				record->arguments[count++].i = va_arg(arguments, int);
+				c++;
+			} else {
+				while (*c >= '0' && *c <= '9') c++;
+				if (*c == '$') return NO;
+			}
+
+			if (part == 0) {
+				if (*c != '.') break;
+				c++;
+			}
+		}
+
+		//Length
+		AIDebugArgumentType integerType = AIDebugArgumentInt;
+		BOOL longDouble = NO;
+		while (*c && strchr("hlqLzjt", *c)) {
+			if (*c == 'q' || *c == 'j' || (*c == 'l' && integerType == AIDebugArgumentLong))
+				integerType = AIDebugArgumentLongLong;
+			else if (*c == 'l' || *c == 'z' || *c == 't')
+				integerType = AIDebugArgumentLong;
+			else if (*c == 'L')
+				longDouble = YES;
+			c++;
+		}
+
+		if (!*c) break;
+		if (count == MAX_ARGUMENTS) return NO;
+
+		AIDebugArgument *argument = &record->arguments[count];
+		switch (*c) {
+			case 'd': case 'i': case 'o': case 'u': case 'x': case 'X': case 'c':
+				record->argumentTypes[count] = integerType;
+				if (integerType == AIDebugArgumentLongLong)
+					argument->i = va_arg(arguments, long long);
+				else if (integerType == AIDebugArgumentLong)
+					argument->i = va_arg(arguments, long);
+				else
+					argument->i = va_arg(arguments, int);
+				break;
+
+			case 'D': case 'O': case 'U':
+				record->argumentTypes[count] = AIDebugArgumentLong;
+				argument->i = va_arg(arguments, long);
+				break;
+
+			case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+				if (longDouble) return NO;
+				record->argumentTypes[count] = AIDebugArgumentDouble;
+				argument->d = va_arg(arguments, double);
+				break;
+
+			case 's':
+				if (integerType != AIDebugArgumentInt) return NO; //%ls
+				record->argumentTypes[count] = AIDebugArgumentCString;
+				{
+					const char *string = va_arg(arguments, const char *);
+					argument->s = (string ? strdup(string) : NULL);
+				}
+				break;
+
+			case 'p':
+				record->argumentTypes[count] = AIDebugArgumentPointer;
+				argument->p = va_arg(arguments, void *);
+				break;
+
+			case '@':
+			{
+				id object = va_arg(arguments, id);
+				record->argumentTypes[count] = AIDebugArgumentObject;
+				if (!object || [object isKindOfClass:[NSString class]])
+					argument->o = [object copy];
+				else if ([object isKindOfClass:[NSNumber class]])
+					argument->o = [object retain];
+				else
+					argument->o = [[object description] copy];
+				break;
+			}
+
+			default:
+				//%C, %S, %n and anything else we don't know how to keep
+				return NO;
+		}
+
+		count++;
+		record->argumentCount = count;
+		c++;
+	}
+
+	return YES;
+}
+
+static void releaseArguments(AIDebugLogRecord *record)
+{
+	for (uint8_t i = 0; i < record->argumentCount; i++) {
+		if (record->argumentTypes[i] == AIDebugArgumentCString)
+			free(record->arguments[i].s);
+		else if (record->argumentTypes[i] == AIDebugArgumentObject)
+			[record->arguments[i].o release];
+	}
+	record->argumentCount = 0;
+}
+
+void AIDebugLogBufferRecord(AIDebugLogMessageKind kind, const char *prefix, int line, const char *queueLabel,
+							NSString *format, va_list arguments)
+{
+	pthread_once(&bufferOnce, initializeBuffer);
+
+	AIDebugLogRing	*ring = ringForCurrentThread();
+	int64_t			 head = ring->head;
+
+	if (head - ring->tail >= RING_CAPACITY) {
+		OSAtomicIncrement32(&ring->dropped);
+		dispatch_semaphore_signal(drainSemaphore);
+		return;
+	}
+
+	AIDebugLogRecord *record = &ring->records[head % RING_CAPACITY];
+	record->sequence = OSAtomicIncrement64(&nextSequence);
+	record->time = CFAbsoluteTimeGetCurrent();
+	record->kind = kind;
+	record->line = line;
+	record->prefix = ((kind == AIDebugLogMessageWithPrefix && prefix) ? strdup(prefix) : (char *)prefix);
+	record->argumentCount = 0;
+
+	if (queueLabel)
+		strlcpy(record->queueLabel, queueLabel, QUEUE_LABEL_LENGTH);
+	else
+		record->queueLabel[0] = '\0';
+
+	const char	*formatCString = CFStringGetCStringPtr((CFStringRef)format, kCFStringEncodingUTF8);
+	va_list		 argumentsCopy;
+	BOOL		 captured = NO;
+
+	if (!formatCString) formatCString = CFStringGetCStringPtr((CFStringRef)format, kCFStringEncodingASCII);
+
+	if (formatCString) {
+		va_copy(argumentsCopy, arguments);
+		captured = captureArguments(record, formatCString, argumentsCopy);
+		va_end(argumentsCopy);
+	}
+
+	if (captured) {
+		record->format = [format copy];
+
+	} else {
+		//Fall back to formatting now
+		releaseArguments(record);
+		record->format = @"%@";
+		record->argumentCount = 1;
+		record->argumentTypes[0] = AIDebugArgumentObject;
+		record->arguments[0].o = [[NSString alloc] initWithFormat:format arguments:arguments];
+	}
+
+	//Publish the record only once it's completely written
+	OSMemoryBarrier();
+	ring->head = head + 1;
+
+	if (head + 1 - ring->tail >= RING_CAPACITY / 2)
+		dispatch_semaphore_signal(drainSemaphore);
+}
+
+#pragma mark Rendering
+
+static void appendArgument(NSMutableString *string, NSString *spec, AIDebugLogRecord *record, uint8_t *index)
+{
+	//A * width or precision takes its own argument before the value
+	NSUInteger stars = [[spec componentsSeparatedByString:@"*"] count] - 1;
+	int starValues[2] = {0, 0};
+
+	for (NSUInteger i = 0; i < stars && i < 2 && *index < record->argumentCount; i++)
+		starValues[i] = (int)record->arguments[(*index)++].i;
+
+	if (*index >= record->argumentCount) return;
+
+	AIDebugArgument argument = record->arguments[*index];
+	AIDebugArgumentType type = record->argumentTypes[(*index)++];
+
+#define APPEND(value) do { \
+		if (stars == 2) [string appendFormat:spec, starValues[0], starValues[1], value]; \
+		else if (stars == 1) [string appendFormat:spec, starValues[0], value]; \
+		else [string appendFormat:spec, value]; \
+	} while (0)
+
+	switch (type) {
+		case AIDebugArgumentInt:		APPEND((int)argument.i); break;
+		case AIDebugArgumentLong:		APPEND((long)argument.i); break;
+		case AIDebugArgumentLongLong:	APPEND(argument.i); break;
+		case AIDebugArgumentDouble:		APPEND(argument.d); break;
+		case AIDebugArgumentCString:	APPEND(argument.s); break;
+		case AIDebugArgumentPointer:	APPEND(argument.p); break;
+		case AIDebugArgumentObject:		APPEND(argument.o); break;
+	}
+
+#undef APPEND
+}
+
+static NSString *renderRecord(AIDebugLogRecord *record)
+{
+	NSMutableString	*string = [NSMutableString stringWithCapacity:128];
+	time_t			 seconds = (time_t)(record->time + kCFAbsoluteTimeIntervalSince1970);
+	struct tm		 components;
+	char			 timestamp[16];
+
+	localtime_r(&seconds, &components);
+	strftime(timestamp, sizeof(timestamp), "%H:%M:%S: ", &components);
+	[string appendFormat:@"%s", timestamp];
+
+	if (record->kind == AIDebugLogMessageWithSignature) {
+		if (record->queueLabel[0])
+			[string appendFormat:@"%s:%d: (on %s) ", record->prefix, record->line, record->queueLabel];
+		else
+			[string appendFormat:@"%s:%d: ", record->prefix, record->line];
+
+	} else if (record->kind == AIDebugLogMessageWithPrefix) {
+		[string appendFormat:@"%s: ", record->prefix];
+	}
+
+	//Walk the format, copying literal text and formatting one conversion at a time
+	NSString	*format = record->format;
+	NSUInteger	 length = [format length], location = 0;
+	uint8_t		 index = 0;
+
+	while (location < length) {
+		NSRange percent = [format rangeOfString:@"%" options:NSLiteralSearch range:NSMakeRange(location, length - location)];
+		if (percent.location == NSNotFound) {
+			[string appendString:[format substringFromIndex:location]];
+			break;
+		}
+
+		[string appendString:[format substringWithRange:NSMakeRange(location, percent.location - location)]];
+
+		NSUInteger end = percent.location + 1;
+		if (end < length && [format characterAtIndex:end] == '%') {
+			[string appendString:@"%"];
+			location = end + 1;
+			continue;
+		}
+
+		while (end < length) {
+			unichar character = [format characterAtIndex:end];
+			if (!character || character > 0x7f || !strchr("-+ #0'123456789.*hlqLzjt", character)) break;
+			end++;
+		}
+		if (end >= length) break;
+
+		appendArgument(string, [format substringWithRange:NSMakeRange(percent.location, end - percent.location + 1)],
+					   record, &index);
+		location = end + 1;
+	}
+
+	if (![string hasSuffix:@"\n"] && ![string hasSuffix:@"\r"])
+		[string appendString:@"\n"];
+
+	return string;
+}
+
+static int compareRecords(const void *a, const void *b)
+{
+	int64_t difference = ((const AIDebugLogRecord *)a)->sequence - ((const AIDebugLogRecord *)b)->sequence;
+	return (difference < 0 ? -1 : (difference > 0 ? 1 : 0));
+}
+
+/*!
+ * @brief Move everything out of the rings, render it in recording order, and write it out
+ */
+static void drainRings(void)
+{
+	AIDebugLogRecord	*records = NULL;
+	NSUInteger			 count = 0, capacity = 0;
+	int32_t				 dropped = 0;
+
+	pthread_mutex_lock(&drainLock);
+
+	pthread_mutex_lock(&ringListLock);
+	AIDebugLogRing **link = &rings;
+	while (*link) {
+		AIDebugLogRing	*ring = *link;
+		int64_t			 tail = ring->tail, head = ring->head;
+
+		OSMemoryBarrier();
+
+		if (head > tail) {
+			NSUInteger available = (NSUInteger)(head - tail);
+			if (count + available > capacity) {
+				capacity = MAX(capacity * 2, count + available);
+				records = reallocf(records, capacity * sizeof(AIDebugLogRecord));
+			}
+
+			for (int64_t i = tail; i < head; i++)
+				records[count++] = ring->records[i % RING_CAPACITY];
+
+			OSMemoryBarrier();
+			ring->tail = head;
+		}
+
+		int32_t ringDropped = ring->dropped;
+		if (ringDropped) {
+			OSAtomicAdd32(-ringDropped, &ring->dropped);
+			dropped += ringDropped;
+		}
+
+		if (ring->orphaned && ring->head == ring->tail) {
+			*link = ring->next;
+			free(ring);
+		} else {
+			link = &ring->next;
+		}
+	}
+	pthread_mutex_unlock(&ringListLock);
+
+	if (count || dropped) {
+		NSMutableArray	*messages = [NSMutableArray arrayWithCapacity:count + 1];
+		NSMutableData	*output = [NSMutableData dataWithCapacity:count * 128];
+
+		qsort(records, count, sizeof(AIDebugLogRecord), compareRecords);
+
+		for (NSUInteger i = 0; i < count; i++) {
+			NSString *message = renderRecord(&records[i]);
+
+			[messages addObject:message];
+			[output appendData:[message dataUsingEncoding:NSUTF8StringEncoding]];
+
+			releaseArguments(&records[i]);
+			[records[i].format release];
+			if (records[i].kind == AIDebugLogMessageWithPrefix) free(records[i].prefix);
+		}
+
+		if (dropped) {
+			NSString *message = [NSString stringWithFormat:@"(%d debug messages were dropped)\n", dropped];
+			[messages addObject:message];
+			[output appendData:[message dataUsingEncoding:NSUTF8StringEncoding]];
+		}
+
+		pthread_mutex_lock(&outputLock);
+		if (outputFile) {
+			const char	*bytes = [output bytes];
+			size_t		 remaining = [output length];
+
+			while (remaining) {
+				ssize_t written = write([outputFile fileDescriptor], bytes, remaining);
+				if (written <= 0) break;
+				bytes += written;
+				remaining -= written;
+			}
+		}
+		pthread_mutex_unlock(&outputLock);
+
+		[adium.debugController performSelectorOnMainThread:@selector(addMessages:)
+												 withObject:messages
+											  waitUntilDone:NO];
+	}
+
+	pthread_mutex_unlock(&drainLock);
+
+	free(records);
+}
+
+#pragma mark -
+
+void AIDebugLogBufferSetOutputFile(NSFileHandle *fileHandle)
+{
+	pthread_mutex_lock(&outputLock);
+	if (fileHandle != outputFile) {
+		[outputFile release];
+		outputFile = [fileHandle retain];
+	}
+	pthread_mutex_unlock(&outputLock);
+}
+
+void AIDebugLogBufferFlush(void)
+{
+	pthread_once(&bufferOnce, initializeBuffer);
+
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+	drainRings();
+	[pool release];
+}
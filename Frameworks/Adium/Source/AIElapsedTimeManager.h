@@ -0,0 +1,49 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+@class AIListObject;
+
+//Posted by the shared AIElapsedTimeManager on the minute, while anyone is observing
+#define AIElapsedTimeMinuteDidChangeNotification	@"AIElapsedTimeMinuteDidChangeNotification"
+
+/*!
+ * @class AIElapsedTimeManager
+ * @brief The one clock behind everything displayed as time elapsed since a date, such as idle times
+ *
+ * List objects only store the date something started, like idleSince; how long ago that was is worked out from it
+ * whenever it is drawn or shown in a tooltip. Nothing is written to the objects as time passes, so no observers run
+ * and no rows are laid out again just because a minute went by.
+ *
+ * Views showing elapsed times redraw what they have on screen when the minute changes. A single timer, aligned to
+ * the wall clock minute, serves all of them, and only runs while at least one is observing.
+ */
+@interface AIElapsedTimeManager : NSObject {
+	NSTimer				*minuteTimer;
+	NSUInteger			observerCount;
+
+	NSMutableDictionary	*idleStrings;
+}
+
++ (AIElapsedTimeManager *)sharedManager;
+
+- (void)addMinuteObserver:(id)observer selector:(SEL)selector;
+- (void)removeMinuteObserver:(id)observer;
+- (void)minuteDidChange;
+
+- (BOOL)displayOfObjectDependsOnTime:(AIListObject *)inObject;
+- (NSString *)idleStringForObject:(AIListObject *)inObject;
+
+@end
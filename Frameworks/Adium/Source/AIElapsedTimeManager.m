@@ -0,0 +1,167 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <Adium/AIElapsedTimeManager.h>
+#import <Adium/AIListObject.h>
+#import <AIUtilities/AIDateFormatterAdditions.h>
+
+//Idle times longer than 999 hours are shown simply as idle
+#define MAX_IDLE_MINUTES			599400
+//Idle strings kept; many more distinct idle times than are ever on screen at once
+#define MAX_CACHED_IDLE_STRINGS		512
+
+static AIElapsedTimeManager *sharedElapsedTimeManager = nil;
+
+@interface AIElapsedTimeManager ()
+- (void)scheduleMinuteTimer;
+- (void)minuteTimerFired:(NSTimer *)inTimer;
+@end
+
+@implementation AIElapsedTimeManager
+
++ (AIElapsedTimeManager *)sharedManager
+{
+	if (!sharedElapsedTimeManager)
+		sharedElapsedTimeManager = [[self alloc] init];
+	return sharedElapsedTimeManager;
+}
+
+- (id)init
+{
+	if ((self = [super init])) {
+		idleStrings = [[NSMutableDictionary alloc] init];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[minuteTimer invalidate];
+	[minuteTimer release];
+	[idleStrings release];
+
+	[super dealloc];
+}
+
+#pragma mark Minute changes
+
+/*!
+ * @brief Call selector on observer whenever the minute changes
+ *
+ * Each call must be paired with removeMinuteObserver:. The timer runs only while there are observers.
+ */
+- (void)addMinuteObserver:(id)observer selector:(SEL)selector
+{
+	[[NSNotificationCenter defaultCenter] addObserver:observer
+											 selector:selector
+												 name:AIElapsedTimeMinuteDidChangeNotification
+											   object:self];
+
+	if (observerCount++ == 0)
+		[self scheduleMinuteTimer];
+}
+
+/*!
+ * @brief Stop calling observer when the minute changes
+ */
+- (void)removeMinuteObserver:(id)observer
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:observer
+													name:AIElapsedTimeMinuteDidChangeNotification
+												  object:self];
+
+	if (observerCount > 0 && --observerCount == 0) {
+		[minuteTimer invalidate];
+		[minuteTimer release]; minuteTimer = nil;
+	}
+}
+
+/*!
+ * @brief Schedule the timer for the start of the next minute
+ *
+ * The timer is rescheduled each time it fires rather than repeating, so it stays on the minute however late it fires,
+ * such as after the computer wakes from sleep.
+ */
+- (void)scheduleMinuteTimer
+{
+	NSTimeInterval	now = [NSDate timeIntervalSinceReferenceDate];
+	NSDate			*nextMinute = [NSDate dateWithTimeIntervalSinceReferenceDate:(floor(now / 60.0) + 1) * 60.0];
+
+	[minuteTimer invalidate];
+	[minuteTimer release];
+	minuteTimer = [[NSTimer alloc] initWithFireDate:nextMinute
+										   interval:0
+											 target:self
+										   selector:@selector(minuteTimerFired:)
+										   userInfo:nil
+											repeats:NO];
+	[[NSRunLoop currentRunLoop] addTimer:minuteTimer forMode:NSDefaultRunLoopMode];
+}
+
+- (void)minuteTimerFired:(NSTimer *)inTimer
+{
+	[self scheduleMinuteTimer];
+	[self minuteDidChange];
+}
+
+/*!
+ * @brief Tell observers the minute changed; called by the timer
+ */
+- (void)minuteDidChange
+{
+	[[NSNotificationCenter defaultCenter] postNotificationName:AIElapsedTimeMinuteDidChangeNotification object:self];
+}
+
+#pragma mark Elapsed times
+
+/*!
+ * @brief Whether anything displayed for an object changes as time passes, so it must be redrawn on the minute
+ */
+- (BOOL)displayOfObjectDependsOnTime:(AIListObject *)inObject
+{
+	return ([inObject valueForProperty:@"idleSince"] != nil);
+}
+
+/*!
+ * @brief How long an object has been idle, for display, such as "5m"
+ *
+ * Worked out from its idleSince now. Strings are shared by all objects idle for the same number of minutes.
+ *
+ * @result The idle time, or nil if the object isn't idle or has been for an unknown time
+ */
+- (NSString *)idleStringForObject:(AIListObject *)inObject
+{
+	NSInteger	idle = inObject.idleTime;
+
+	if (idle <= 0) return nil;
+	if (idle > MAX_IDLE_MINUTES) return AILocalizedString(@"Idle", nil);
+
+	NSNumber	*minutes = [NSNumber numberWithInteger:idle];
+	NSString	*idleString = [idleStrings objectForKey:minutes];
+
+	if (!idleString) {
+		if (idleStrings.count >= MAX_CACHED_IDLE_STRINGS)
+			[idleStrings removeAllObjects];
+
+		idleString = [NSDateFormatter stringForApproximateTimeInterval:(idle * 60) abbreviated:YES];
+		[idleStrings setObject:idleString forKey:minutes];
+	}
+
+	return idleString;
+}
+
+@end
@@ -0,0 +1,55 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+@class AIListObject;
+
+/*!
+ * @class AIListCellLayoutCache
+ * @brief A least-recently-used cache of per-object layout results for contact list cells
+ *
+ * Each cached layout is stored against the list object's displayVersion, and is discarded as soon as the object's
+ * version moves on. Cells must remove all layouts when a setting which affects their layout changes.
+ *
+ * Objects are not retained; a layout belonging to a deallocated object simply ages out, since no other object can
+ * share its version.
+ */
+@interface AIListCellLayoutCache : NSObject {
+	NSString				*name;
+	NSUInteger				capacity;
+	
+	CFMutableDictionaryRef	entries;
+	id						mostRecentEntry;
+	id						leastRecentEntry;
+	
+	NSUInteger				hits;
+	NSUInteger				misses;
+	NSUInteger				evictions;
+}
+
+- (id)initWithName:(NSString *)inName capacity:(NSUInteger)inCapacity;
+
+- (id)layoutForListObject:(AIListObject *)inObject;
+- (void)setLayout:(id)inLayout forListObject:(AIListObject *)inObject;
+- (void)removeAllLayouts;
+
+@property (readonly, nonatomic) NSUInteger count;
+@property (readonly, nonatomic) NSUInteger capacity;
+@property (readonly, nonatomic) NSUInteger hits;
+@property (readonly, nonatomic) NSUInteger misses;
+@property (readonly, nonatomic) NSUInteger evictions;
+@property (readonly, nonatomic) double hitRate;
+
+@end
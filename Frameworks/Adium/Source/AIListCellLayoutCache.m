@@ -0,0 +1,185 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <Adium/AIListCellLayoutCache.h>
+#import <Adium/AIListObject.h>
+
+//Log the hit rate every so many lookups
+#define STATISTICS_LOG_INTERVAL		10000
+
+@interface AIListCellLayoutCacheEntry : NSObject {
+@public
+	AIListObject				*listObject; //Not retained; only used as our key
+	NSUInteger					displayVersion;
+	id							layout;
+	
+	AIListCellLayoutCacheEntry	*previous;
+	AIListCellLayoutCacheEntry	*next;
+}
+@end
+
+@implementation AIListCellLayoutCacheEntry
+- (void)dealloc
+{
+	[layout release];
+	
+	[super dealloc];
+}
+@end
+
+@interface AIListCellLayoutCache ()
+- (void)moveEntryToFront:(AIListCellLayoutCacheEntry *)entry;
+- (void)unlinkEntry:(AIListCellLayoutCacheEntry *)entry;
+- (void)logStatistics;
+@end
+
+@implementation AIListCellLayoutCache
+
+- (id)initWithName:(NSString *)inName capacity:(NSUInteger)inCapacity
+{
+	if ((self = [super init])) {
+		name = [inName copy];
+		capacity = (inCapacity ? inCapacity : 1);
+		
+		//Keys are list objects compared by pointer and not retained; values are our entries
+		entries = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+	}
+	
+	return self;
+}
+
+- (void)dealloc
+{
+	if (hits || misses) [self logStatistics];
+	
+	CFRelease(entries);
+	[name release];
+	
+	[super dealloc];
+}
+
+@synthesize capacity, hits, misses, evictions;
+
+- (NSUInteger)count
+{
+	return (NSUInteger)CFDictionaryGetCount(entries);
+}
+
+- (double)hitRate
+{
+	return ((hits + misses) ? ((double)hits / (double)(hits + misses)) : 0.0);
+}
+
+/*!
+ * @brief The layout cached for inObject, or nil if there is none for its current display version
+ */
+- (id)layoutForListObject:(AIListObject *)inObject
+{
+	AIListCellLayoutCacheEntry *entry = (AIListCellLayoutCacheEntry *)CFDictionaryGetValue(entries, inObject);
+	id layout = nil;
+	
+	if (entry && entry->displayVersion == inObject.displayVersion) {
+		[self moveEntryToFront:entry];
+		layout = entry->layout;
+		hits++;
+	} else {
+		misses++;
+	}
+	
+	if (((hits + misses) % STATISTICS_LOG_INTERVAL) == 0)
+		[self logStatistics];
+	
+	return layout;
+}
+
+/*!
+ * @brief Cache a layout for inObject at its current display version
+ *
+ * If this takes us over capacity, the least recently used layout is evicted.
+ */
+- (void)setLayout:(id)inLayout forListObject:(AIListObject *)inObject
+{
+	AIListCellLayoutCacheEntry *entry = (AIListCellLayoutCacheEntry *)CFDictionaryGetValue(entries, inObject);
+	
+	if (!entry) {
+		entry = [[AIListCellLayoutCacheEntry alloc] init];
+		entry->listObject = inObject;
+		CFDictionarySetValue(entries, inObject, entry);
+		[entry release];
+		
+		if ((NSUInteger)CFDictionaryGetCount(entries) > capacity) {
+			AIListCellLayoutCacheEntry *evictedEntry = leastRecentEntry;
+			
+			[self unlinkEntry:evictedEntry];
+			CFDictionaryRemoveValue(entries, evictedEntry->listObject);
+			evictions++;
+		}
+	}
+	
+	if (entry->layout != inLayout) {
+		[entry->layout release];
+		entry->layout = [inLayout retain];
+	}
+	entry->displayVersion = inObject.displayVersion;
+	
+	[self moveEntryToFront:entry];
+}
+
+/*!
+ * @brief Remove every cached layout, such as when a cell's font or visible elements change
+ */
+- (void)removeAllLayouts
+{
+	CFDictionaryRemoveAllValues(entries);
+	mostRecentEntry = leastRecentEntry = nil;
+}
+
+#pragma mark Recency list
+
+- (void)unlinkEntry:(AIListCellLayoutCacheEntry *)entry
+{
+	if (entry->previous) entry->previous->next = entry->next;
+	if (entry->next) entry->next->previous = entry->previous;
+	if (mostRecentEntry == entry) mostRecentEntry = entry->next;
+	if (leastRecentEntry == entry) leastRecentEntry = entry->previous;
+	
+	entry->previous = entry->next = nil;
+}
+
+- (void)moveEntryToFront:(AIListCellLayoutCacheEntry *)entry
+{
+	if (mostRecentEntry == entry) return;
+	
+	//A new entry isn't linked in yet; unlinking it is harmless
+	[self unlinkEntry:entry];
+	
+	entry->next = mostRecentEntry;
+	if (mostRecentEntry) ((AIListCellLayoutCacheEntry *)mostRecentEntry)->previous = entry;
+	mostRecentEntry = entry;
+	
+	if (!leastRecentEntry) leastRecentEntry = entry;
+}
+
+#pragma mark Statistics
+
+- (void)logStatistics
+{
+	AILogWithSignature(@"%@: %lu hits, %lu misses (%.1f%% hit rate), %lu evictions, %lu of %lu layouts cached",
+					   name, (unsigned long)hits, (unsigned long)misses, self.hitRate * 100.0,
+					   (unsigned long)evictions, (unsigned long)self.count, (unsigned long)capacity);
+}
+
+@end
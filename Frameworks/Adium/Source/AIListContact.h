@@ -41,7 +41,6 @@
 	
 	NSInteger		idle;
 	NSDate			*idleSince;
-	NSString		*idleReadable;
 	
 	NSString		*serverDisplayName;
 	NSString		*formattedUID;
@@ -87,7 +87,6 @@
 	[ABUniqueID release]; ABUniqueID = nil;
 	[textProfile release]; textProfile = nil;
 	[idleSince release]; idleSince = nil;
-	[idleReadable release]; idleReadable = nil;
 	[serverDisplayName release]; serverDisplayName = nil;
 	[formattedUID release]; formattedUID = nil;
 	
@@ -425,9 +424,9 @@
 					   notify:NotifyLater];
 	}
 	
-	/* @"idle", for a contact with an IdleSince date, will be changing every minute.  @"isIdle" provides observers a way
-	* to perform an action when the contact becomes/comes back from idle, regardless of whether an IdleSince is available,
-	* without having to do that action every minute for other contacts.
+	/* @"idle" is only set for a contact idle for an unknown time; otherwise idleTime is worked out from IdleSince.
+	* @"isIdle" provides observers a way to perform an action when the contact becomes/comes back from idle,
+	* regardless of whether an IdleSince is available.
 	*/
 	[self setValue:[NSNumber numberWithBool:inIsIdle]
 				   forProperty:@"isIdle"
@@ -725,6 +724,7 @@
 	
 	/* Ugly: Subclass accessing superclass's ivar */
 	[m_groups removeAllObjects];
+	[AIListObject incrementGroupingVersion];
 }
 
 - (BOOL) existsServerside
@@ -33,6 +33,8 @@
 #define TEXT_WITH_IMAGES_LEFT_PAD   2
 #define TEXT_WITH_IMAGES_RIGHT_PAD  2
 
+@class AIListCellLayoutCache;
+
 @interface AIListContactCell : AIListCell {
 	BOOL				userIconVisible;
 	BOOL				extendedStatusVisible;
@@ -65,6 +67,8 @@
 
 	NSDictionary		*_statusAttributes;
 	NSMutableDictionary	*_statusAttributesInverted;	
+	
+	AIListCellLayoutCache	*layoutCache;
 }
 
 //Status Text
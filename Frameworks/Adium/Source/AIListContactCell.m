@@ -21,6 +21,8 @@
 #import <AIUtilities/AIStringAdditions.h>
 #import <Adium/AIServiceIcons.h>
 #import <Adium/AIUserIcons.h>
+#import <Adium/AIListCellLayoutCache.h>
+#import <Adium/AIElapsedTimeManager.h>
 #import "AIProxyListObject.h"
 
 #define NAME_STATUS_PAD			6
@@ -31,6 +33,58 @@
 #define CONTACT_INVERTED_TEXT_COLOR		[NSColor whiteColor]
 #define CONTACT_INVERTED_STATUS_COLOR	[NSColor whiteColor]
 
+//Objects whose layout is kept; enough for a large contact list to scroll end to end without misses
+#define DEFAULT_LAYOUT_CACHE_CAPACITY	4096
+//Status texts kept per object; an idle time adds a new one each minute without changing the object's display version
+#define MAX_STATUS_TEXTS_PER_LAYOUT		8
+
+/*!
+ * @class AIListContactCellLayout
+ * @brief Layout results for one list object, valid until its display version changes
+ */
+@interface AIListContactCellLayout : NSObject {
+@public
+	CGFloat				contentWidth; //Negative until calculated
+	NSString			*contentWidthIdleReadable; //The idle time contentWidth was calculated with
+	NSMutableDictionary	*statusTexts;
+	NSMutableDictionary	*invertedStatusTexts;
+	NSMutableDictionary	*statusTextSizes;
+}
+@end
+
+@implementation AIListContactCellLayout
+- (id)init
+{
+	if ((self = [super init])) {
+		contentWidth = -1;
+		statusTexts = [[NSMutableDictionary alloc] init];
+		invertedStatusTexts = [[NSMutableDictionary alloc] init];
+		statusTextSizes = [[NSMutableDictionary alloc] init];
+	}
+	
+	return self;
+}
+
+- (void)dealloc
+{
+	[contentWidthIdleReadable release];
+	[statusTexts release];
+	[invertedStatusTexts release];
+	[statusTextSizes release];
+	
+	[super dealloc];
+}
+@end
+
+@interface AIListContactCell ()
+- (AIListContactCellLayout *)layout;
+- (void)invalidateLayoutCache;
+- (NSAttributedString *)extendedStatusStringForMessage:(NSString *)string size:(NSSize *)outSize;
+- (NSString *)idleReadableForListObject:(AIListObject *)listObject;
+- (NSString *)extendedStatusForListObject:(AIListObject *)listObject;
+- (CGFloat)contentWidth;
+@end
+
 @implementation AIListContactCell
 
 //Copy
@@ -42,6 +96,7 @@
 	newCell->statusColor = [statusColor retain];
 	newCell->_statusAttributes = [_statusAttributes retain];
 	newCell->_statusAttributesInverted = [_statusAttributesInverted retain];
+	newCell->layoutCache = [layoutCache retain];
 
 	return newCell;
 }
@@ -58,6 +113,10 @@
 		_statusAttributesInverted = nil;
 		shouldUseContactTextColors = YES;
 		useStatusMessageAsExtendedStatus = NO;
+		
+		NSInteger capacity = [[NSUserDefaults standardUserDefaults] integerForKey:@"AIListCellLayoutCacheCapacity"];
+		layoutCache = [[AIListCellLayoutCache alloc] initWithName:NSStringFromClass([self class])
+														 capacity:((capacity > 0) ? capacity : DEFAULT_LAYOUT_CACHE_CAPACITY)];
 	}
 
 	return self;
@@ -72,6 +131,8 @@
 	[_statusAttributes release];
 	[_statusAttributesInverted release];
 	
+	[layoutCache release];
+	
 	[super dealloc];
 }
 
@@ -109,25 +170,44 @@
 
 - (CGFloat)cellWidth
 {
-	CGFloat		width = [super cellWidth];
+	return [super cellWidth] + [self contentWidth];
+}
+
+/*!
+ * @brief Width of our content, without spacing and padding (Cached per list object)
+ */
+- (CGFloat)contentWidth
+{
+	AIListContactCellLayout *layout = [self layout];
 	AIListObject *listObject = [proxyObject listObject];
 
+	//The idle time changes without the display version changing, so the width is only good for the one it was worked out with
+	NSString *idleReadable = ((extendedStatusVisible && !idleTimeIsBelow) ? [self idleReadableForListObject:listObject] : nil);
+	if (layout->contentWidth >= 0 &&
+		(idleReadable == layout->contentWidthIdleReadable || [idleReadable isEqualToString:layout->contentWidthIdleReadable]))
+		return layout->contentWidth;
+
+	CGFloat		width = 0;
+
+	[layout->contentWidthIdleReadable release];
+	layout->contentWidthIdleReadable = [idleReadable copy];
+
 	//Name
 	width += AIceil(self.displayNameSize.width);
 	
 	// Also account for idle times.
-	if (extendedStatusVisible && idleTimeVisible && !idleTimeIsBelow && [listObject valueForProperty:@"idleReadable"]) {
-		NSString		*idleTimeString = [listObject valueForProperty:@"idleReadable"];
+	if (idleReadable) {
+		NSString		*idleTimeString = idleReadable;
+		NSSize			idleTimeSize;
 		
 		if (statusMessageVisible && !statusMessageIsBelow && [listObject statusMessageString]) {
 			// Account for the size of the ellipsis if there's a status message.
 			idleTimeString = [idleTimeString stringByAppendingEllipsis];
 		}
 		
-		NSAttributedString *idleAttString = [[NSAttributedString alloc] initWithString:idleTimeString attributes:self.statusAttributes];
-		width += AIceil([idleAttString size].width);
+		[self extendedStatusStringForMessage:idleTimeString size:&idleTimeSize];
+		width += AIceil(idleTimeSize.width);
 		width += NAME_STATUS_PAD;
-		[idleAttString release];
 	}
 		
 	//User icon
@@ -164,7 +244,104 @@
 		width += TEXT_WITH_IMAGES_RIGHT_PAD;
 	}
 
-	return width + 1;
+	layout->contentWidth = width + 1;
+	
+	return layout->contentWidth;
+}
+
+
+//Layout cache ---------------------------------------------------------------------------------------------------------
+#pragma mark Layout cache
+/*!
+ * @brief Cached layout for the list object we're drawing, created if there is none for its current display version
+ */
+- (AIListContactCellLayout *)layout
+{
+	AIListObject			*listObject = [proxyObject listObject];
+	AIListContactCellLayout	*layout = [layoutCache layoutForListObject:listObject];
+	
+	if (!layout) {
+		layout = [[AIListContactCellLayout alloc] init];
+		[layoutCache setLayout:layout forListObject:listObject];
+		[layout release];
+	}
+	
+	return layout;
+}
+
+/*!
+ * @brief Forget all cached layouts; called whenever a setting which affects layout changes
+ */
+- (void)invalidateLayoutCache
+{
+	[layoutCache removeAllLayouts];
+}
+
+/*!
+ * @brief The attributed string for an extended status message, and its size (Cached per list object)
+ */
+- (NSAttributedString *)extendedStatusStringForMessage:(NSString *)string size:(NSSize *)outSize
+{
+	AIListContactCellLayout	*layout = [self layout];
+	BOOL					inverted = [self cellIsSelected];
+	NSMutableDictionary		*texts = (inverted ? layout->invertedStatusTexts : layout->statusTexts);
+	NSAttributedString		*extStatus = [texts objectForKey:string];
+	
+	if (!extStatus) {
+		if (texts.count >= MAX_STATUS_TEXTS_PER_LAYOUT) {
+			[texts removeAllObjects];
+			[layout->statusTextSizes removeAllObjects];
+		}
+
+		extStatus = [[NSAttributedString alloc] initWithString:string
+													attributes:(inverted ? [self statusAttributesInverted] : [self statusAttributes])];
+		[texts setObject:extStatus forKey:string];
+		[extStatus release];
+	}
+	
+	if (outSize) {
+		//Only the color differs between normal and inverted text, so the size is shared
+		NSValue *sizeValue = [layout->statusTextSizes objectForKey:string];
+		if (!sizeValue) {
+			sizeValue = [NSValue valueWithSize:[extStatus size]];
+			[layout->statusTextSizes setObject:sizeValue forKey:string];
+		}
+		
+		*outSize = [sizeValue sizeValue];
+	}
+	
+	return extStatus;
+}
+
+/*!
+ * @brief The idle time to show for a list object, such as "(5m)", worked out as it is drawn
+ *
+ * @result The idle time, or nil if it isn't shown or the object isn't idle for a known time
+ */
+- (NSString *)idleReadableForListObject:(AIListObject *)listObject
+{
+	if (!idleTimeVisible) return nil;
+
+	NSString *idleString = [[AIElapsedTimeManager sharedManager] idleStringForObject:listObject];
+
+	return (idleString ? [NSString stringWithFormat:@"(%@)", idleString] : nil);
+}
+
+/*!
+ * @brief The extended status for a list object when its idle time and status message are drawn together
+ *
+ * The status message part is kept in the @"extendedStatus" property; the idle time is added as it is drawn.
+ */
+- (NSString *)extendedStatusForListObject:(AIListObject *)listObject
+{
+	NSString	*statusMessage = [listObject valueForProperty:@"extendedStatus"];
+	NSString	*idleReadable = [self idleReadableForListObject:listObject];
+
+	if (idleReadable && statusMessage) {
+		return [NSString stringWithFormat:@"%@ %@", idleReadable, statusMessage];
+	} else {
+		return (idleReadable ? idleReadable : statusMessage);
+	}
 }
 
 
@@ -182,6 +359,7 @@
 		
 		//Flush the status attributes cache
 		[_statusAttributes release]; _statusAttributes = nil;
+		[self invalidateLayoutCache];
 	}
 }
 - (NSFont *)statusFont{
@@ -197,6 +375,7 @@
 
 		//Flush the status attributes cache
 		[_statusAttributes release]; _statusAttributes = nil;
+		[self invalidateLayoutCache];
 	}
 }
 - (NSColor *)statusColor
@@ -245,11 +424,31 @@
 	return _statusAttributesInverted;
 }
 
+//The label font and color, and whether aliases are shown, all feed into our cached layout
+- (void)setFont:(NSFont *)inFont
+{
+	[super setFont:inFont];
+	[self invalidateLayoutCache];
+}
+
+- (void)setTextColor:(NSColor *)inColor
+{
+	[super setTextColor:inColor];
+	[self invalidateLayoutCache];
+}
+
+- (void)setShouldShowAlias:(BOOL)inFlag
+{
+	[super setShouldShowAlias:inFlag];
+	[self invalidateLayoutCache];
+}
+
 //Flush status attributes when alignment is changed
 - (void)setTextAlignment:(NSTextAlignment)inAlignment
 {
 	[super setTextAlignment:inAlignment];
 	[_statusAttributes release]; _statusAttributes = nil;
+	[self invalidateLayoutCache];
 }
 
 	
@@ -259,6 +458,7 @@
 - (void)setUserIconVisible:(BOOL)inShowIcon
 {
 	userIconVisible = inShowIcon;
+	[self invalidateLayoutCache];
 }
 - (BOOL)userIconVisible{
 	return userIconVisible;
@@ -270,6 +470,7 @@
 	userIconSize = NSMakeSize(inSize, inSize);
 	userIconRoundingRadius = (userIconSize.width / 4);
 	if (userIconRoundingRadius > 3) userIconRoundingRadius = 3;
+	[self invalidateLayoutCache];
 }
 
 - (CGFloat)userIconSize{
@@ -280,6 +481,7 @@
 - (void)setExtendedStatusVisible:(BOOL)inShowStatus
 {
 	extendedStatusVisible = inShowStatus;
+	[self invalidateLayoutCache];
 }
 - (BOOL)extendedStatusVisible{
 	return extendedStatusVisible;
@@ -289,6 +491,7 @@
 - (void)setStatusIconsVisible:(BOOL)inShowStatus
 {
 	statusIconsVisible = inShowStatus;
+	[self invalidateLayoutCache];
 }
 - (BOOL)statusIconsVisible{
 	return statusIconsVisible;
@@ -298,6 +501,7 @@
 - (void)setServiceIconsVisible:(BOOL)inShowService
 {
 	serviceIconsVisible = inShowService;
+	[self invalidateLayoutCache];
 }
 - (BOOL)serviceIconsVisible{
 	return serviceIconsVisible;
@@ -306,27 +510,34 @@
 //Element Positioning
 - (void)setIdleTimeIsBelowName:(BOOL)isBelow{
 	idleTimeIsBelow = isBelow;
+	[self invalidateLayoutCache];
 }
 
 - (void)setStatusMessageIsBelowName:(BOOL)isBelow{
 	statusMessageIsBelow = isBelow;
+	[self invalidateLayoutCache];
 }
 
 - (void)setStatusMessageIsVisible:(BOOL)isVisible{
 	statusMessageVisible = isVisible;
+	[self invalidateLayoutCache];
 }
 - (void)setIdleTimeIsVisible:(BOOL)isVisible{
 	idleTimeVisible = isVisible;	
+	[self invalidateLayoutCache];
 }
 
 - (void)setUserIconPosition:(LIST_POSITION)inPosition{
 	userIconPosition = inPosition;
+	[self invalidateLayoutCache];
 }
 - (void)setStatusIconPosition:(LIST_POSITION)inPosition{
 	statusIconPosition = inPosition;
+	[self invalidateLayoutCache];
 }
 - (void)setServiceIconPosition:(LIST_POSITION)inPosition{
 	serviceIconPosition = inPosition;
+	[self invalidateLayoutCache];
 }
 
 //Opacity
@@ -345,11 +556,13 @@
 - (void)setBackgroundColorIsEvents:(BOOL)isEvents
 {
 	backgroundColorIsEvents = isEvents;
+	[self invalidateLayoutCache];
 }
 
 - (void)setShouldUseContactTextColors:(BOOL)flag
 {
 	shouldUseContactTextColors = flag;
+	[self invalidateLayoutCache];
 }
 
 - (void)setUseStatusMessageAsExtendedStatus:(BOOL)flag
@@ -406,7 +619,7 @@
 		rect = [self drawUserExtendedStatusInRect:rect
 									  withMessage:(useStatusMessageAsExtendedStatus ?
 												   [listObject statusMessageString] : 
-												   [listObject valueForProperty:@"extendedStatus"])
+												   [self extendedStatusForListObject:listObject])
 										drawUnder:YES];
 		
 		[self drawDisplayNameWithFrame:rect];
@@ -418,7 +631,7 @@
 		[self drawUserExtendedStatusInRect:rect
 							   withMessage:(useStatusMessageAsExtendedStatus ?
 											[listObject statusMessageString] :
-											[listObject valueForProperty:@"extendedStatus"])
+											[self extendedStatusForListObject:listObject])
 										drawUnder:NO];	
 	} else {
 		if (statusMessageIsBelow && statusMessageVisible) {
@@ -429,7 +642,7 @@
 		
 		if (idleTimeIsBelow && idleTimeVisible) {
 			rect = [self drawUserExtendedStatusInRect:rect
-										  withMessage:[listObject valueForProperty:@"idleReadable"]
+										  withMessage:[self idleReadableForListObject:listObject]
 											drawUnder:YES];
 		}
 		
@@ -444,7 +657,7 @@
 		
 		if (!idleTimeIsBelow && idleTimeVisible) {
 			[self drawUserExtendedStatusInRect:rect
-								   withMessage:[listObject valueForProperty:@"idleReadable"]
+								   withMessage:[self idleReadableForListObject:listObject]
 									 drawUnder:NO];
 		}
 	}
@@ -588,13 +801,10 @@
 				rect.size.width -= NAME_STATUS_PAD;
 			}
 			
-			NSDictionary		*attributes = ([self cellIsSelected] ?
-											   [self statusAttributesInverted] :
-											   [self statusAttributes]);
-			NSAttributedString 	*extStatus = [[NSAttributedString alloc] initWithString:string attributes:attributes];
+			NSSize				nameSize;
+			NSAttributedString 	*extStatus = [self extendedStatusStringForMessage:string size:&nameSize];
 			
 			//Alignment
-			NSSize		nameSize = [extStatus size];
 			NSRect		drawRect = rect;
 			
 			if (nameSize.width > drawRect.size.width) nameSize = rect.size;
@@ -625,7 +835,6 @@
 											 drawRect.size.width,
 											 drawRect.size.height - (half + offset))];
 
-			[extStatus release];
 			
 			if (drawUnder) {
 				rect.origin.y -= halfHeight;
@@ -638,6 +847,7 @@
 - (void)setUseAliasesOnNonParentContacts:(BOOL)inFlag
 {
 	useAliasesOnNonParentContacts = inFlag;
+	[self invalidateLayoutCache];
 }
 
 - (BOOL)shouldShowAlias
@@ -111,6 +111,8 @@ typedef enum {
 	NSString			*listObjectStatusName;
 	
 	NSString			*webKitUserIconPath;
+	
+	NSUInteger			displayVersion;
 }
 
 - (id)initWithUID:(NSString *)inUID service:(AIService *)inService;
@@ -134,11 +136,15 @@ typedef enum {
 - (void)removeContainingGroup:(AIListGroup *)group;
 - (void)addContainingGroup:(AIListGroup *)group;
 - (void)removeFromGroup:(AIListObject <AIContainingObject> *)group;
++ (NSUInteger)groupingVersion;
++ (void)incrementGroupingVersion;
 
 //Display
 @property (readonly, nonatomic) NSString *formattedUID;
 - (void)setFormattedUID:(NSString *)inFormattedUID notify:(NotifyTiming)notify;
 @property (readonly, nonatomic) NSString *longDisplayName;
+@property (readonly, nonatomic) NSUInteger displayVersion;
+- (void)incrementDisplayVersion;
 
 //Prefs
 - (void)setPreference:(id)value forKey:(NSString *)inKey group:(NSString *)groupName;
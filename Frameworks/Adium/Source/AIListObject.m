@@ -48,6 +48,9 @@
  */
 @implementation AIListObject
 
+static NSUInteger lastDisplayVersion = 0;
+static NSUInteger groupingVersion = 0;
+
 /*!
  * @brief Initialize
  *
@@ -60,6 +63,7 @@
 
 		UID = [inUID retain];	
 		service = inService;
+		displayVersion = ++lastDisplayVersion;
 		
 		// Delay until the next run loop so bookmarks can instantiate their values first.
 		[self performSelector:@selector(setupObservedValues) withObject:nil afterDelay:0.0];
@@ -179,8 +183,10 @@
 	NSParameterAssert(inGroup && [inGroup canContainObject:self]);
 	if (![self.groups containsObject:inGroup]) {
 		
-		if (inGroup)
+		if (inGroup) {
 			[m_groups addObject:inGroup];
+			[AIListObject incrementGroupingVersion];
+		}
 	}
 }
 
@@ -188,6 +194,26 @@
 {
 	NSParameterAssert(group != nil && [m_groups containsObject:group]);
 	[m_groups removeObject:group];
+	[AIListObject incrementGroupingVersion];
+}
+
+/*!
+ * @brief Grouping version
+ *
+ * Changes whenever any object joins or leaves a group or metacontact, so anything derived from the shape of
+ * the contact list, such as inherited preferences, can be cached against it.
+ */
++ (NSUInteger)groupingVersion
+{
+	return groupingVersion;
+}
+
+/*!
+ * @brief Note that the containing objects of some list object changed
+ */
++ (void)incrementGroupingVersion
+{
+	groupingVersion++;
 }
 
 - (NSSet *)containingObjects
@@ -209,6 +235,7 @@
 - (void)setContainingGroup:(AIListGroup *)inGroup
 {
 	[m_groups removeAllObjects];
+	[AIListObject incrementGroupingVersion];
 	if(inGroup)
 		[self addContainingGroup:inGroup];
 }
@@ -410,6 +437,25 @@
     return displayName ? displayName : self.formattedUID;
 }
 
+/*!
+ * @brief Display version
+ *
+ * Changes whenever something drawn for this object may have changed, so anything derived from the object's display
+ * can be cached against it. Versions are drawn from one counter shared by all list objects, so an object never
+ * reuses a version, and neither does another object which later takes its place in memory.
+ */
+@synthesize displayVersion;
+
+/*!
+ * @brief Note that something displayed for this object changed
+ *
+ * Called by AIContactObserverManager as status and attribute changes are posted.
+ */
+- (void)incrementDisplayVersion
+{
+	displayVersion = ++lastDisplayVersion;
+}
+
 /*!
 * @brief The way this object's name should be spoken
  *
@@ -462,8 +508,22 @@
 	[AIUserIcons setManuallySetUserIconData:inData forObject:self];
 }
 
+/*!
+ * @brief Minutes idle
+ *
+ * Worked out from idleSince whenever it's asked for, so nothing needs to update it as time passes.
+ *
+ * @result The minutes idle; -1 if idle for less than a minute or for an unknown time; 0 if not idle
+ */
 - (NSInteger)idleTime
 {
+	NSDate	*idleSince = [self valueForProperty:@"idleSince"];
+
+	if (idleSince) {
+		NSInteger idle = (NSInteger)(-[idleSince timeIntervalSinceNow] / 60.0);
+		return (idle > 0 ? idle : -1);
+	}
+
 	return [self integerValueForProperty:@"idle"];
 }
 
@@ -23,7 +23,12 @@
 
 	AIListContact		*_preferredContact;
 	NSArray				*_listContacts;
+	uint8_t				*_listContactCandidacy;		//How good a preferred contact each of _listContacts is
 	NSArray				*_listContactsIncludingOfflineAccounts;
+	NSCountedSet		*containedObjectIDs;		//internalObjectIDs of our contents; duplicates come from different accounts
+
+	AIListContact		*_preferredDestinationContact;
+	BOOL				preferredDestinationNeedsUpdate;
 	
 	BOOL								containsOnlyOneUniqueContact;
 
@@ -41,6 +41,8 @@
 - (void)updateAllPropertiesForObject:(AIListObject *)inObject;
 
 - (void)determineIfWeShouldAppearToContainOnlyOneContact;
+- (void)updateCandidacyOfContact:(AIListContact *)inContact;
+@property (readonly, nonatomic) AIListContact *preferredDestinationContact;
 
 - (NSArray *)uniqueContainedListContactsIncludingOfflineAccounts:(BOOL)includeOfflineAccounts visibleOnly:(BOOL)visibleOnly;
 
@@ -51,6 +53,23 @@
 + (NSArray *)_forwardedProperties;
 @end
 
+/*!
+ * @brief How good a choice for our preferred contact a contained contact is, best first
+ */
+typedef enum {
+	AIPreferredCandidateAvailable = 0,	//Available and not mobile
+	AIPreferredCandidateOnline,
+	AIPreferredCandidateOffline
+} AIPreferredCandidacy;
+
+static AIPreferredCandidacy candidacyOfContact(AIListContact *listContact)
+{
+	if (listContact.statusSummary == AIAvailableStatus && !listContact.isMobile)
+		return AIPreferredCandidateAvailable;
+
+	return (listContact.online ? AIPreferredCandidateOnline : AIPreferredCandidateOffline);
+}
+
 @implementation AIMetaContact
 
 NSComparisonResult containedContactSort(AIListContact *objectA, AIListContact *objectB, void *context);
@@ -64,6 +83,8 @@ NSComparisonResult containedContactSort(AIListContact *objectA, AIListContact *o
 		_listContactsIncludingOfflineAccounts = nil;
 		
 		_containedObjects = [[NSMutableArray alloc] init];
+		containedObjectIDs = [[NSCountedSet alloc] init];
+		preferredDestinationNeedsUpdate = YES;
 		
 		expanded = [[self preferenceForKey:KEY_EXPANDED group:PREF_GROUP_OBJECT_STATUS_CACHE] boolValue];
 
@@ -81,7 +102,9 @@ NSComparisonResult containedContactSort(AIListContact *objectA, AIListContact *o
 	[[NSRunLoop currentRunLoop] cancelPerformSelectorsWithTarget:self];
 	
 	[_containedObjects release]; _containedObjects = nil;
+	[containedObjectIDs release]; containedObjectIDs = nil;
 	[_listContacts release]; _listContacts = nil;
+	free(_listContactCandidacy); _listContactCandidacy = NULL;
 	[_listContactsIncludingOfflineAccounts release]; _listContactsIncludingOfflineAccounts = nil;
 
 	[super dealloc];
@@ -237,7 +260,10 @@ NSComparisonResult containedContactSort(AIListContact *objectA, AIListContact *o
 - (void)containedObjectsOrOrderDidChange
 {
 	_preferredContact = nil;
+	_preferredDestinationContact = nil;
+	preferredDestinationNeedsUpdate = YES;
 	[_listContacts release]; _listContacts = nil;
+	free(_listContactCandidacy); _listContactCandidacy = NULL;
 	[_listContactsIncludingOfflineAccounts release]; _listContactsIncludingOfflineAccounts = nil;
 	
 	//Our effective icon may have changed
@@ -260,6 +286,7 @@ NSComparisonResult containedContactSort(AIListContact *objectA, AIListContact *o
 		
 		((AIListContact *)inObject).metaContact = self;
 		[_containedObjects addObject:inObject];
+		[containedObjectIDs addObject:inObject.internalObjectID];
 		containedObjectsNeedsSort = YES;
 		
 		[self containedObjectsOrOrderDidChange];
@@ -305,6 +332,7 @@ NSComparisonResult containedContactSort(AIListContact *objectA, AIListContact *o
 		BOOL	wasPreferredContact = (inObject == self.preferredContact);
 
 		[_containedObjects removeObject:inObject];
+		[containedObjectIDs removeObject:inObject.internalObjectID];
 		
 		if (contact.metaContact == self) {
 			/* If the contact is being reassigned to another metaContact, this may already have been done; we shouldn't
@@ -359,6 +387,7 @@ NSComparisonResult containedContactSort(AIListContact *objectA, AIListContact *o
 	[contact retain];
 	
 	[_containedObjects removeObject:inObject];
+	[containedObjectIDs removeObject:inObject.internalObjectID];
 	contact.metaContact = nil;
 	[self containedObjectsOrOrderDidChange];
 
@@ -369,31 +398,54 @@ NSComparisonResult containedContactSort(AIListContact *objectA, AIListContact *o
 	[contact release];
 }
 
+/*!
+ * @brief The contact we last sent to, if we still contain it
+ *
+ * The saved internalObjectID is looked up among our own contents rather than the whole contact list, and is only looked
+ * up again when the preference or our contents change. Of several contacts with that ID on different accounts, the
+ * one in our unique contacts, which is the most available, is used.
+ */
+- (AIListContact *)preferredDestinationContact
+{
+	if (preferredDestinationNeedsUpdate) {
+		NSString *objID = [self preferenceForKey:KEY_PREFERRED_DESTINATION_CONTACT group:PREF_GROUP_OBJECT_STATUS_CACHE];
+
+		_preferredDestinationContact = nil;
+		if (objID && [containedObjectIDs countForObject:objID]) {
+			for (AIListContact *listContact in self.listContactsIncludingOfflineAccounts) {
+				if ([listContact.internalObjectID isEqualToString:objID]) {
+					_preferredDestinationContact = listContact;
+					break;
+				}
+			}
+		}
+
+		preferredDestinationNeedsUpdate = NO;
+	}
+
+	return _preferredDestinationContact;
+}
+
 - (AIListContact *)preferredContactForContentType:(NSString *)inType
 {
-	AIListObject *preferredContact = nil;
-	
 	/* If we've messaged this contact previously, prefer the last contact we sent to 
 	 * if that contact's status is the most-available one the metacontact can offer
 	 */
-	NSString *objID = [self preferenceForKey:KEY_PREFERRED_DESTINATION_CONTACT group:PREF_GROUP_OBJECT_STATUS_CACHE];
-	
-	if (objID)
-		preferredContact = [adium.contactController existingListObjectWithUniqueID:objID];
+	AIListContact *preferredContact = self.preferredDestinationContact;
 	
 	//Use our standard preferred contact if:
 	//a) we no longer contain the saved contact
 	//b) we have a more available contact
 	//c) we have a non-mobile contact and our saved contact is mobile
 	if (
-		(![self containsObject:preferredContact]) ||
+		(!preferredContact) ||
 		(preferredContact.statusSummary != self.statusSummary) ||
 		(!self.isMobile && preferredContact.isMobile)	
 	) {
 		preferredContact = self.preferredContact;
 	}
 	
-	return (AIListContact *)preferredContact;
+	return preferredContact;
 }
 
 /*!
@@ -412,29 +464,26 @@ NSComparisonResult containedContactSort(AIListContact *objectA, AIListContact *o
 {
 	if (!_preferredContact) {
 		AIListContact   *preferredContact = nil;
-		
-		//Search for an available contact who is not mobile
-		for (AIListContact *thisContact in self.uniqueContainedObjects) {
-			if (thisContact.statusSummary == AIAvailableStatus &&	!thisContact.isMobile) {
-				preferredContact = thisContact;
+		NSArray			*listContacts = self.uniqueContainedObjects;
+		NSUInteger		count = listContacts.count;
+		NSUInteger		i, preferredIndex = NSNotFound;
+
+		//Find the first available contact who is not mobile, or failing that the first online contact
+		for (i = 0; i < count; i++) {
+			if (_listContactCandidacy[i] == AIPreferredCandidateAvailable) {
+				preferredIndex = i;
 				break;
 			}
-		}
-		
-		//If no available contacts, find the first online contact
-		if (!preferredContact) {
-			for (AIListContact *thisContact in self.uniqueContainedObjects) {
-				if (thisContact.online) {
-					preferredContact = thisContact;
-					break;
-				}
-			}
+			if (_listContactCandidacy[i] == AIPreferredCandidateOnline && preferredIndex == NSNotFound)
+				preferredIndex = i;
 		}
 
 		//If no online contacts, find the first contact
-		if (!preferredContact && self.uniqueContainedObjectsCount > 0) {
-			preferredContact = [self.uniqueContainedObjects objectAtIndex:0];
-		}
+		if (preferredIndex == NSNotFound && count > 0)
+			preferredIndex = 0;
+
+		if (preferredIndex != NSNotFound)
+			preferredContact = [listContacts objectAtIndex:preferredIndex];
 
 		//If no list contacts at all, try contacts on offline accounts
 		if (!preferredContact) {
@@ -459,29 +508,26 @@ NSComparisonResult containedContactSort(AIListContact *objectA, AIListContact *o
 	if (!inService)
 		return self.preferredContact;
 	
-	NSString	*serviceClass = inService.serviceClass;
-	
-	//Search for an available contact who is not mobile
-	for (AIListContact *thisContact in self.uniqueContainedObjects) {
-		if ([thisContact.service.serviceClass isEqualToString:serviceClass] &&
-			thisContact.statusSummary == AIAvailableStatus &&
-			!thisContact.isMobile) {
-			return thisContact;
-		}
-	}			
-	
-	//If no available contacts, find the first online contact
-	for (AIListContact *thisContact in self.uniqueContainedObjects) {
-		if (thisContact.online && [thisContact.service.serviceClass isEqualToString:serviceClass])
-			return thisContact;
-	}
+	NSString		*serviceClass = inService.serviceClass;
+	NSArray			*listContacts = self.uniqueContainedObjects;
+	NSUInteger		count = listContacts.count;
+	AIListContact	*onlineContact = nil, *firstContact = nil;
 	
-	for (AIListContact *thisContact in self.uniqueContainedObjects) {
-		if ([thisContact.service.serviceClass isEqualToString:serviceClass])
+	//Return the first available contact who is not mobile; failing that, the first online contact, then the first contact
+	for (NSUInteger i = 0; i < count; i++) {
+		AIListContact *thisContact = [listContacts objectAtIndex:i];
+
+		if (![thisContact.service.serviceClass isEqualToString:serviceClass]) continue;
+
+		if (_listContactCandidacy[i] == AIPreferredCandidateAvailable)
 			return thisContact;
+		if (_listContactCandidacy[i] == AIPreferredCandidateOnline && !onlineContact)
+			onlineContact = thisContact;
+		if (!firstContact)
+			firstContact = thisContact;
 	}
 	
-	return nil;
+	return (onlineContact ?: firstContact);
 }
 
 /*!
@@ -497,6 +543,13 @@ NSComparisonResult containedContactSort(AIListContact *objectA, AIListContact *o
 {
 	if (!_listContacts) {
 		_listContacts = [[self uniqueContainedListContactsIncludingOfflineAccounts:NO visibleOnly:NO] retain];
+
+		//Note how good a preferred contact each is; this is kept up to date as their status changes
+		NSUInteger count = _listContacts.count;
+		_listContactCandidacy = malloc(MAX(count, 1U) * sizeof(uint8_t));
+		for (NSUInteger i = 0; i < count; i++) {
+			_listContactCandidacy[i] = candidacyOfContact([_listContacts objectAtIndex:i]);
+		}
 	}
 	
 	return _listContacts;
@@ -587,13 +640,14 @@ NSComparisonResult containedContactSort(AIListContact *objectA, AIListContact *o
 {
 	NSArray			*myContainedObjects = self.containedObjects;
 	NSMutableArray	*listContacts = [[NSMutableArray alloc] init];
+	BOOL			hasDuplicates = (containedObjectIDs.count < myContainedObjects.count);
 	
 	//Search for an available contact
 	for (AIListContact *listContact in myContainedObjects) {
 		AIListContact *previousContact = [listContacts lastObject];
 		
 		//Take advantage of the fact that this is a sorted list. If there are duplicates, they will be right next to each other.
-		if ([listContact.internalObjectID isEqualToString:previousContact.internalObjectID]) {
+		if (hasDuplicates && [listContact.internalObjectID isEqualToString:previousContact.internalObjectID]) {
 			/* If it is a duplicate, but the previous pick is offline and this contact is online, swap 'em out so our array 
 			 * has the best possible listContacts (making display elsewhere more straightforward) 
 			 */ 
@@ -652,28 +706,56 @@ NSComparisonResult containedContactSort(AIListContact *objectA, AIListContact *o
  * @brief Update our preferred ordering as objects that we contain change their status
  *
  * The purpose of this is to determine if we need to recalculate our preferredContact.
- * This will be done "lazily," though in reality it will most likely happen quite soon.
+ * Only a change in how good a candidate the contact is can change that.
  */
 - (void)object:(id)inObject didChangeValueForProperty:(NSString *)key notify:(NotifyTiming)notify
 {
-	/* If the online status of a contained object changed, we should also check if our one-contact-only
-	 * in terms of online contacts has changed
-	 */
-	if ([key isEqualToString:@"isOnline"]) {
-		_preferredContact = nil;
-		[self determineIfWeShouldAppearToContainOnlyOneContact];
+	if (inObject != self) {
+		/* If a contact which is also listed on other accounts goes on or offline, a different one of them may now
+		 * represent it in our unique contacts.
+		 */
+		if ([key isEqualToString:@"isOnline"] &&
+			[containedObjectIDs countForObject:[(AIListObject *)inObject internalObjectID]] > 1) {
+			[self determineIfWeShouldAppearToContainOnlyOneContact];
 
-	} else  if ([key isEqualToString:@"listObjectStatusType"] ||
-		[key isEqualToString:@"idleSince"] ||
-		[key isEqualToString:@"isIdle"] ||
-		[key isEqualToString:@"isMobile"] ||
-		[key isEqualToString:@"listObjectStatusMessage"]) {
-		_preferredContact = nil;
+		} else if ([key isEqualToString:@"isOnline"] ||
+				   [key isEqualToString:@"listObjectStatusType"] ||
+				   [key isEqualToString:@"idleSince"] ||
+				   [key isEqualToString:@"isIdle"] ||
+				   [key isEqualToString:@"isMobile"] ||
+				   [key isEqualToString:@"listObjectStatusMessage"]) {
+			[self updateCandidacyOfContact:inObject];
+		}
 	}
 	
 	[super object:self didChangeValueForProperty:key notify:notify];
 }
 
+/*!
+ * @brief A contained contact's status changed; update our preferred contact if that makes it a better or worse candidate
+ */
+- (void)updateCandidacyOfContact:(AIListContact *)inContact
+{
+	//Candidacy is worked out along with the unique contacts when they're next needed
+	if (!_listContacts) return;
+
+	//Only our unique contacts are candidates
+	NSUInteger idx = [_listContacts indexOfObjectIdenticalTo:inContact];
+	if (idx == NSNotFound) return;
+
+	AIPreferredCandidacy candidacy = candidacyOfContact(inContact);
+	if (candidacy != _listContactCandidacy[idx]) {
+		AIListContact *oldPreferredContact = _preferredContact;
+
+		_listContactCandidacy[idx] = candidacy;
+		_preferredContact = nil;
+
+		//Our effective icon may have changed
+		if (self.preferredContact != oldPreferredContact)
+			[AIUserIcons flushCacheForObject:self];
+	}
+}
+
 /*
  * @brief The properties that should be relayed to the _preferredContact.
  *
@@ -796,6 +878,22 @@ NSComparisonResult containedContactSort(AIListContact *objectA, AIListContact *o
 //Preferences -------------------------------------------------------------------------------------------------
 #pragma mark Preferences
 
+- (void)setPreference:(id)value forKey:(NSString *)key group:(NSString *)group
+{
+	[super setPreference:value forKey:key group:group];
+
+	if ([key isEqualToString:KEY_PREFERRED_DESTINATION_CONTACT])
+		preferredDestinationNeedsUpdate = YES;
+}
+
+- (void)setPreferences:(NSDictionary *)prefs inGroup:(NSString *)group
+{
+	[super setPreferences:prefs inGroup:group];
+
+	if ([prefs objectForKey:KEY_PREFERRED_DESTINATION_CONTACT])
+		preferredDestinationNeedsUpdate = YES;
+}
+
 //Retrieve a preference value (with the option of ignoring inherited values)
 //If we don't find a preference, query our preferredContact to take its preference as our own.
 //We could potentially query all the objects.. but that's possibly overkill.
@@ -977,6 +1075,10 @@ NSComparisonResult containedContactSort(AIListContact *objectA, AIListContact *o
 //Test for the presence of an object in our group
 - (BOOL)containsObject:(AIListObject *)inObject
 {
+	//Most objects asked about aren't ours; their IDs say so without searching
+	if (![containedObjectIDs countForObject:inObject.internalObjectID])
+		return NO;
+
 	return [_containedObjects containsObject:inObject];
 }
 
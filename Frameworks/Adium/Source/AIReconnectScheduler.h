@@ -0,0 +1,182 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+@class AIReconnectScheduler;
+
+/*!
+ * @protocol AIReconnectSchedulerClient
+ * @brief Something which the reconnect scheduler connects, such as an account
+ */
+@protocol AIReconnectSchedulerClient <NSObject>
+
+/*!
+ * @brief Identifies the servers the client connects to, for the per-service limit on how often connections start
+ */
+- (NSString *)reconnectServiceIdentifier;
+
+/*!
+ * @brief The host which must be reachable before the client connects, or nil to ignore reachability
+ */
+- (NSString *)reconnectHost;
+
+/*!
+ * @brief Start connecting now
+ *
+ * Report success with -[AIReconnectScheduler clientDidConnect:]. On failure, schedule the next attempt, or cancel.
+ */
+- (void)performScheduledReconnect;
+
+/*!
+ * @brief The time the client will next connect changed
+ *
+ * Called at once; the client should record the date without telling its observers yet.
+ * <tt>notifyOfScheduledReconnectDate</tt> follows, once for all of the changes made in the same run loop pass.
+ */
+- (void)setScheduledReconnectDate:(NSDate *)date;
+- (void)notifyOfScheduledReconnectDate;
+
+@end
+
+/*!
+ * @protocol AIReconnectSchedulerClock
+ * @brief The scheduler's source of time, which may be simulated
+ */
+@protocol AIReconnectSchedulerClock <NSObject>
+
+/*!
+ * @brief The current time, in seconds
+ */
+- (NSTimeInterval)currentTime;
+
+/*!
+ * @brief Call -[AIReconnectScheduler clockDidReachWakeTime] at time, instead of at any previously requested time
+ *
+ * @param time The time to wake the scheduler, or 0 if it doesn't need waking
+ */
+- (void)wakeScheduler:(AIReconnectScheduler *)scheduler atTime:(NSTimeInterval)time;
+
+@end
+
+/*!
+ * @class AIReconnectScheduler
+ * @brief Decides when accounts which should be online connect
+ *
+ * Each attempt to reconnect after a failure waits a random time between the client's minimum delay and three times
+ * its previous delay (decorrelated jitter), up to maximumDelay, so accounts which dropped together don't come back in
+ * lockstep. Clients which are due wait their turn, oldest first:
+ *	| at most maximumConcurrentConnections connect at once
+ *	| connections to one service start at least minimumIntervalBetweenConnects apart
+ *	| a client whose host is unreachable waits for it to become reachable, at which point it is due within connectSpread
+ *
+ * A connection holds its place among the concurrent ones until the client connects, is scheduled again, or is
+ * cancelled, or until connectionTimeout passes.
+ *
+ * All times are kept in one heap, so the scheduler needs one timer however many clients are waiting. Main thread only.
+ */
+@interface AIReconnectScheduler : NSObject {
+	id <AIReconnectSchedulerClock>	clock;
+
+	CFMutableDictionaryRef		entries;
+	NSMutableArray				*heap;
+	NSMutableArray				*readyEntries;
+	NSMutableSet				*unreachableHosts;
+	NSMutableDictionary			*nextConnectTimes;
+	NSMutableDictionary			*serviceIntervals;
+	NSMutableSet				*clientsToNotify;
+	NSUInteger					connectionCount;
+	NSTimeInterval				wakeTime;
+	uint32_t					randomState;
+	NSUInteger					batchDepth;
+	BOOL						flushScheduled;
+
+	NSUInteger					maximumConcurrentConnections;
+	NSTimeInterval				maximumDelay;
+	NSTimeInterval				connectSpread;
+	NSTimeInterval				connectionTimeout;
+	NSTimeInterval				minimumIntervalBetweenConnects;
+}
+
++ (AIReconnectScheduler *)sharedScheduler;
+
+/*!
+ * @param inClock The source of time, or nil to use the real time and run loop timers
+ */
+- (id)initWithClock:(id <AIReconnectSchedulerClock>)inClock;
+
+/*!
+ * @brief Schedule the next attempt to reconnect a client after a failure
+ *
+ * @param minimumDelay The shortest wait the client accepts between attempts
+ * @result The delay chosen
+ */
+- (NSTimeInterval)scheduleReconnectForClient:(id <AIReconnectSchedulerClient>)client minimumDelay:(NSTimeInterval)minimumDelay;
+
+/*!
+ * @brief Schedule a client to connect after a specific delay
+ */
+- (void)scheduleReconnectForClient:(id <AIReconnectSchedulerClient>)client afterDelay:(NSTimeInterval)delay;
+
+/*!
+ * @brief Schedule a client to connect soon, within connectSpread, such as at launch or when the network returns
+ */
+- (void)scheduleConnectForClient:(id <AIReconnectSchedulerClient>)client;
+
+/*!
+ * @brief Stop scheduling a client and forget its delays
+ */
+- (void)cancelReconnectForClient:(id <AIReconnectSchedulerClient>)client;
+
+/*!
+ * @brief A client connected; forget its delays and let another client connect
+ */
+- (void)clientDidConnect:(id <AIReconnectSchedulerClient>)client;
+
+- (BOOL)isSchedulingClient:(id <AIReconnectSchedulerClient>)client;
+
+/*!
+ * @brief Note a change in a host's reachability
+ *
+ * Hosts are assumed to be reachable until said otherwise. Clients waiting on a host which becomes reachable are
+ * due within connectSpread, and start their delays over.
+ */
+- (void)setHost:(NSString *)host reachable:(BOOL)reachable;
+
+- (void)setMinimumInterval:(NSTimeInterval)interval betweenConnectsForService:(NSString *)serviceIdentifier;
+
+/*!
+ * @brief Make the random delays repeatable
+ */
+- (void)setRandomSeed:(uint32_t)seed;
+
+/*!
+ * @brief Connect the clients which are due; called by the clock
+ */
+- (void)clockDidReachWakeTime;
+
+/*!
+ * @brief Send the pending notifyOfScheduledReconnectDate calls now rather than at the end of the run loop pass
+ */
+- (void)flushClientNotifications;
+
+@property (readonly, nonatomic) id <AIReconnectSchedulerClock> clock;
+@property (readonly, nonatomic) NSUInteger connectionCount;
+@property (readwrite, nonatomic) NSUInteger maximumConcurrentConnections;
+@property (readwrite, nonatomic) NSTimeInterval maximumDelay;
+@property (readwrite, nonatomic) NSTimeInterval connectSpread;
+@property (readwrite, nonatomic) NSTimeInterval connectionTimeout;
+@property (readwrite, nonatomic) NSTimeInterval minimumIntervalBetweenConnects;
+
+@end
@@ -0,0 +1,575 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIReconnectScheduler.h"
+#import <Adium/AIContactObserverManager.h>
+
+#define DEFAULT_MAXIMUM_CONCURRENT_CONNECTIONS	4
+#define DEFAULT_MAXIMUM_DELAY					600.0	//Longest wait between attempts, in seconds
+#define DEFAULT_CONNECT_SPREAD					5.0		//Clients connecting "now" are spread over this many seconds
+#define DEFAULT_CONNECTION_TIMEOUT				60.0	//A connection stops counting against the limit after this long
+#define DEFAULT_INTERVAL_BETWEEN_CONNECTS		0.5		//Shortest time between connections to one service
+
+typedef enum {
+	AIReconnectIdle = 0,	//Not waiting for anything; new, or connecting for longer than the timeout
+	AIReconnectWaiting,		//In the heap, until it is due
+	AIReconnectReady,		//Due, and waiting its turn
+	AIReconnectConnecting	//Connecting; in the heap until the connection times out
+} AIReconnectState;
+
+/*!
+ * @class AIReconnectEntry
+ * @brief What the scheduler knows about one client
+ */
+@interface AIReconnectEntry : NSObject {
+@public
+	id <AIReconnectSchedulerClient>	 client;
+	NSString						*host;
+	NSString						*service;
+	AIReconnectState				 state;
+	NSTimeInterval					 time;
+	NSTimeInterval					 previousDelay;
+	NSUInteger						 heapIndex;
+}
+@end
+
+@implementation AIReconnectEntry
+
+- (void)dealloc
+{
+	[client release];
+	[host release];
+	[service release];
+
+	[super dealloc];
+}
+
+@end
+
+#pragma mark -
+
+/*!
+ * @class AIRunLoopReconnectClock
+ * @brief Real time, with a run loop timer to wake the scheduler
+ */
+@interface AIRunLoopReconnectClock : NSObject <AIReconnectSchedulerClock> {
+	NSTimer	*timer;
+}
+@end
+
+@implementation AIRunLoopReconnectClock
+
+- (void)dealloc
+{
+	[timer invalidate];
+	[timer release];
+
+	[super dealloc];
+}
+
+- (NSTimeInterval)currentTime
+{
+	return [NSDate timeIntervalSinceReferenceDate];
+}
+
+- (void)wakeScheduler:(AIReconnectScheduler *)scheduler atTime:(NSTimeInterval)time
+{
+	[timer invalidate];
+	[timer release]; timer = nil;
+
+	if (time) {
+		//The scheduler owns us, so don't retain it
+		timer = [[NSTimer alloc] initWithFireDate:[NSDate dateWithTimeIntervalSinceReferenceDate:time]
+										 interval:0
+										   target:self
+										 selector:@selector(wake:)
+										 userInfo:[NSValue valueWithNonretainedObject:scheduler]
+										  repeats:NO];
+		[[NSRunLoop currentRunLoop] addTimer:timer forMode:NSRunLoopCommonModes];
+	}
+}
+
+- (void)wake:(NSTimer *)inTimer
+{
+	AIReconnectScheduler *scheduler = [[inTimer userInfo] nonretainedObjectValue];
+
+	[timer release]; timer = nil;
+	[scheduler clockDidReachWakeTime];
+}
+
+@end
+
+#pragma mark -
+
+static inline double AIReconnectRandom(uint32_t *state)
+{
+	//xorshift32; plenty for jitter, and repeatable from a seed
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return x / 4294967296.0;
+}
+
+@interface AIReconnectScheduler ()
+- (AIReconnectEntry *)_entryForClient:(id <AIReconnectSchedulerClient>)client create:(BOOL)create;
+- (void)_detachEntry:(AIReconnectEntry *)entry;
+- (void)_forgetClient:(id <AIReconnectSchedulerClient>)client;
+- (void)_scheduleEntry:(AIReconnectEntry *)entry atTime:(NSTimeInterval)inTime;
+- (void)_scheduleEntrySoon:(AIReconnectEntry *)entry;
+- (void)_beginBatch;
+- (void)_endBatch;
+- (BOOL)_connectDueClients;
+
+- (void)_addToHeap:(AIReconnectEntry *)entry;
+- (void)_removeFromHeap:(AIReconnectEntry *)entry;
+- (void)_siftUpFromIndex:(NSUInteger)index;
+- (void)_siftDownFromIndex:(NSUInteger)index;
+@end
+
+@implementation AIReconnectScheduler
+
+static AIReconnectScheduler *sharedScheduler = nil;
+
++ (AIReconnectScheduler *)sharedScheduler
+{
+	if (!sharedScheduler)
+		sharedScheduler = [[self alloc] init];
+	return sharedScheduler;
+}
+
+- (id)init
+{
+	return [self initWithClock:nil];
+}
+
+- (id)initWithClock:(id <AIReconnectSchedulerClock>)inClock
+{
+	if ((self = [super init])) {
+		clock = (inClock ? [inClock retain] : [[AIRunLoopReconnectClock alloc] init]);
+
+		//Clients are compared by identity
+		entries = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+		heap = [[NSMutableArray alloc] init];
+		readyEntries = [[NSMutableArray alloc] init];
+		unreachableHosts = [[NSMutableSet alloc] init];
+		nextConnectTimes = [[NSMutableDictionary alloc] init];
+		serviceIntervals = [[NSMutableDictionary alloc] init];
+		clientsToNotify = [[NSMutableSet alloc] init];
+		randomState = (arc4random() | 1);
+
+		maximumConcurrentConnections = DEFAULT_MAXIMUM_CONCURRENT_CONNECTIONS;
+		maximumDelay = DEFAULT_MAXIMUM_DELAY;
+		connectSpread = DEFAULT_CONNECT_SPREAD;
+		connectionTimeout = DEFAULT_CONNECTION_TIMEOUT;
+		minimumIntervalBetweenConnects = DEFAULT_INTERVAL_BETWEEN_CONNECTS;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[NSObject cancelPreviousPerformRequestsWithTarget:self];
+	[clock wakeScheduler:self atTime:0];
+
+	[clock release];
+	CFRelease(entries);
+	[heap release];
+	[readyEntries release];
+	[unreachableHosts release];
+	[nextConnectTimes release];
+	[serviceIntervals release];
+	[clientsToNotify release];
+
+	[super dealloc];
+}
+
+@synthesize clock, connectionCount, maximumConcurrentConnections, maximumDelay, connectSpread, connectionTimeout, minimumIntervalBetweenConnects;
+
+- (void)setRandomSeed:(uint32_t)seed
+{
+	randomState = (seed ? seed : 1);
+}
+
+- (void)setMinimumInterval:(NSTimeInterval)interval betweenConnectsForService:(NSString *)serviceIdentifier
+{
+	[serviceIntervals setObject:[NSNumber numberWithDouble:interval] forKey:serviceIdentifier];
+}
+
+#pragma mark Scheduling
+
+- (NSTimeInterval)scheduleReconnectForClient:(id <AIReconnectSchedulerClient>)client minimumDelay:(NSTimeInterval)minimumDelay
+{
+	[self _beginBatch];
+
+	AIReconnectEntry	*entry = [self _entryForClient:client create:YES];
+	NSTimeInterval		previousDelay = MAX(entry->previousDelay, minimumDelay);
+	NSTimeInterval		delay = minimumDelay + AIReconnectRandom(&randomState) * (previousDelay * 3 - minimumDelay);
+
+	if (delay > maximumDelay) delay = MAX(maximumDelay, minimumDelay);
+	entry->previousDelay = delay;
+
+	[self _detachEntry:entry];
+	[self _scheduleEntry:entry atTime:[clock currentTime] + delay];
+
+	[self _endBatch];
+
+	return delay;
+}
+
+- (void)scheduleReconnectForClient:(id <AIReconnectSchedulerClient>)client afterDelay:(NSTimeInterval)delay
+{
+	[self _beginBatch];
+
+	AIReconnectEntry *entry = [self _entryForClient:client create:YES];
+	[self _detachEntry:entry];
+	[self _scheduleEntry:entry atTime:[clock currentTime] + delay];
+
+	[self _endBatch];
+}
+
+- (void)scheduleConnectForClient:(id <AIReconnectSchedulerClient>)client
+{
+	[self _beginBatch];
+	[self _scheduleEntrySoon:[self _entryForClient:client create:YES]];
+	[self _endBatch];
+}
+
+- (void)cancelReconnectForClient:(id <AIReconnectSchedulerClient>)client
+{
+	[self _beginBatch];
+	[self _forgetClient:client];
+	[self _endBatch];
+}
+
+- (void)clientDidConnect:(id <AIReconnectSchedulerClient>)client
+{
+	[self _beginBatch];
+	[self _forgetClient:client];
+	[self _endBatch];
+}
+
+- (BOOL)isSchedulingClient:(id <AIReconnectSchedulerClient>)client
+{
+	return ([self _entryForClient:client create:NO] != nil);
+}
+
+- (void)setHost:(NSString *)host reachable:(BOOL)reachable
+{
+	if (!host) return;
+
+	host = [host lowercaseString];
+
+	[self _beginBatch];
+
+	if (!reachable) {
+		[unreachableHosts addObject:host];
+
+	} else if ([unreachableHosts containsObject:host]) {
+		[unreachableHosts removeObject:host];
+
+		for (AIReconnectEntry *entry in [(NSDictionary *)entries allValues]) {
+			if ([entry->host isEqualToString:host]) [self _scheduleEntrySoon:entry];
+		}
+	}
+
+	[self _endBatch];
+}
+
+- (void)clockDidReachWakeTime
+{
+	wakeTime = 0;
+
+	[self _beginBatch];
+	[self _endBatch];
+}
+
+#pragma mark Entries
+
+- (AIReconnectEntry *)_entryForClient:(id <AIReconnectSchedulerClient>)client create:(BOOL)create
+{
+	AIReconnectEntry *entry = (AIReconnectEntry *)CFDictionaryGetValue(entries, client);
+
+	if (!entry && create) {
+		entry = [[AIReconnectEntry alloc] init];
+		entry->client = [client retain];
+		entry->host = [[[client reconnectHost] lowercaseString] retain];
+		entry->service = [([client reconnectServiceIdentifier] ?: @"") retain];
+
+		CFDictionarySetValue(entries, client, entry);
+		[entry release];
+	}
+
+	return entry;
+}
+
+/*!
+ * @brief Take an entry out of the heap or the ready list, or free its connection, leaving it idle
+ */
+- (void)_detachEntry:(AIReconnectEntry *)entry
+{
+	switch (entry->state) {
+		case AIReconnectWaiting:
+			[self _removeFromHeap:entry];
+			break;
+		case AIReconnectReady:
+			[readyEntries removeObjectIdenticalTo:entry];
+			break;
+		case AIReconnectConnecting:
+			[self _removeFromHeap:entry];
+			connectionCount--;
+			break;
+		case AIReconnectIdle:
+			break;
+	}
+
+	entry->state = AIReconnectIdle;
+}
+
+- (void)_forgetClient:(id <AIReconnectSchedulerClient>)client
+{
+	AIReconnectEntry *entry = [self _entryForClient:client create:NO];
+
+	if (entry) {
+		[self _detachEntry:entry];
+		[clientsToNotify removeObject:client];
+		CFDictionaryRemoveValue(entries, client);
+	}
+}
+
+- (void)_scheduleEntry:(AIReconnectEntry *)entry atTime:(NSTimeInterval)inTime
+{
+	entry->state = AIReconnectWaiting;
+	entry->time = inTime;
+	[self _addToHeap:entry];
+
+	[entry->client setScheduledReconnectDate:[NSDate dateWithTimeIntervalSinceNow:(inTime - [clock currentTime])]];
+	[clientsToNotify addObject:entry->client];
+}
+
+/*!
+ * @brief Make an entry due within connectSpread, and start its delays over
+ *
+ * Entries which are already due sooner, or connecting, are left alone.
+ */
+- (void)_scheduleEntrySoon:(AIReconnectEntry *)entry
+{
+	NSTimeInterval soon = [clock currentTime] + AIReconnectRandom(&randomState) * connectSpread;
+
+	entry->previousDelay = 0;
+
+	if (entry->state == AIReconnectIdle ||
+		(entry->state == AIReconnectWaiting && entry->time > soon)) {
+		[self _detachEntry:entry];
+		[self _scheduleEntry:entry atTime:soon];
+	}
+}
+
+#pragma mark Connecting
+
+- (void)_beginBatch
+{
+	batchDepth++;
+}
+
+/*!
+ * @brief Once the outermost change is made, connect whichever clients are now due
+ *
+ * Clients may call back into the scheduler as they are told to connect; those calls only change the entries, and we
+ * look again once they return.
+ */
+- (void)_endBatch
+{
+	if (--batchDepth) return;
+
+	batchDepth++;
+	while ([self _connectDueClients]);
+	batchDepth--;
+
+	if (clientsToNotify.count && !flushScheduled) {
+		[self performSelector:@selector(flushClientNotifications) withObject:nil afterDelay:0];
+		flushScheduled = YES;
+	}
+}
+
+/*!
+ * @brief Start as many due clients as the limits allow, then arrange to be woken for the next
+ *
+ * @result YES if any clients were started
+ */
+- (BOOL)_connectDueClients
+{
+	NSTimeInterval	now = [clock currentTime];
+	NSTimeInterval	nextWakeTime = 0;
+	NSMutableArray	*clientsToStart = nil;
+	NSUInteger		i = 0;
+
+	//Move clients which are due to the end of the ready list; free connections which have taken too long
+	while (heap.count && ((AIReconnectEntry *)[heap objectAtIndex:0])->time <= now) {
+		AIReconnectEntry *entry = [heap objectAtIndex:0];
+
+		if (entry->state == AIReconnectConnecting) {
+			[self _detachEntry:entry];
+		} else {
+			[self _removeFromHeap:entry];
+			entry->state = AIReconnectReady;
+			[readyEntries addObject:entry];
+		}
+	}
+
+	while (i < readyEntries.count && connectionCount < maximumConcurrentConnections) {
+		AIReconnectEntry	*entry = [readyEntries objectAtIndex:i];
+		NSNumber			*nextConnectTime = [nextConnectTimes objectForKey:entry->service];
+
+		if (entry->host && [unreachableHosts containsObject:entry->host]) {
+			i++;
+			continue;
+		}
+
+		if (nextConnectTime && [nextConnectTime doubleValue] > now) {
+			if (!nextWakeTime || [nextConnectTime doubleValue] < nextWakeTime)
+				nextWakeTime = [nextConnectTime doubleValue];
+			i++;
+			continue;
+		}
+
+		NSNumber *interval = [serviceIntervals objectForKey:entry->service];
+		[nextConnectTimes setObject:[NSNumber numberWithDouble:now + (interval ? [interval doubleValue] : minimumIntervalBetweenConnects)]
+							 forKey:entry->service];
+
+		[entry retain];
+		[readyEntries removeObjectAtIndex:i];
+		entry->state = AIReconnectConnecting;
+		entry->time = now + connectionTimeout;
+		[self _addToHeap:entry];
+		connectionCount++;
+
+		if (!clientsToStart) clientsToStart = [NSMutableArray array];
+		[clientsToStart addObject:entry->client];
+		[entry release];
+	}
+
+	if (heap.count && (!nextWakeTime || ((AIReconnectEntry *)[heap objectAtIndex:0])->time < nextWakeTime))
+		nextWakeTime = ((AIReconnectEntry *)[heap objectAtIndex:0])->time;
+
+	if (nextWakeTime != wakeTime) {
+		wakeTime = nextWakeTime;
+		[clock wakeScheduler:self atTime:wakeTime];
+	}
+
+	for (id <AIReconnectSchedulerClient> client in clientsToStart) {
+		//An earlier client may have cancelled this one
+		if ([self _entryForClient:client create:NO]) [client performScheduledReconnect];
+	}
+
+	return (clientsToStart != nil);
+}
+
+- (void)flushClientNotifications
+{
+	[NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(flushClientNotifications) object:nil];
+	flushScheduled = NO;
+
+	if (!clientsToNotify.count) return;
+
+	NSSet *clients = clientsToNotify;
+	clientsToNotify = [[NSMutableSet alloc] init];
+
+	[[AIContactObserverManager sharedManager] delayListObjectNotifications];
+	for (id <AIReconnectSchedulerClient> client in clients) {
+		[client notifyOfScheduledReconnectDate];
+	}
+	[[AIContactObserverManager sharedManager] endListObjectNotificationsDelay];
+
+	[clients release];
+}
+
+#pragma mark Heap
+
+- (void)_addToHeap:(AIReconnectEntry *)entry
+{
+	entry->heapIndex = heap.count;
+	[heap addObject:entry];
+	[self _siftUpFromIndex:entry->heapIndex];
+}
+
+- (void)_removeFromHeap:(AIReconnectEntry *)entry
+{
+	NSUInteger			index = entry->heapIndex;
+	AIReconnectEntry	*last = [heap lastObject];
+
+	[entry retain];
+	[heap replaceObjectAtIndex:index withObject:last];
+	last->heapIndex = index;
+	[heap removeLastObject];
+
+	if (last != entry) {
+		[self _siftUpFromIndex:index];
+		[self _siftDownFromIndex:last->heapIndex];
+	}
+	[entry release];
+}
+
+- (void)_siftUpFromIndex:(NSUInteger)index
+{
+	AIReconnectEntry *entry = [heap objectAtIndex:index];
+
+	[entry retain];
+	while (index > 0) {
+		NSUInteger			parentIndex = (index - 1) / 2;
+		AIReconnectEntry	*parent = [heap objectAtIndex:parentIndex];
+
+		if (parent->time <= entry->time) break;
+
+		[heap replaceObjectAtIndex:index withObject:parent];
+		parent->heapIndex = index;
+		index = parentIndex;
+	}
+	[heap replaceObjectAtIndex:index withObject:entry];
+	entry->heapIndex = index;
+	[entry release];
+}
+
+- (void)_siftDownFromIndex:(NSUInteger)index
+{
+	NSUInteger			count = heap.count;
+	AIReconnectEntry	*entry = [heap objectAtIndex:index];
+
+	[entry retain];
+	while (YES) {
+		NSUInteger childIndex = index * 2 + 1;
+		if (childIndex >= count) break;
+
+		AIReconnectEntry *child = [heap objectAtIndex:childIndex];
+		if (childIndex + 1 < count && ((AIReconnectEntry *)[heap objectAtIndex:childIndex + 1])->time < child->time) {
+			childIndex++;
+			child = [heap objectAtIndex:childIndex];
+		}
+		if (entry->time <= child->time) break;
+
+		[heap replaceObjectAtIndex:index withObject:child];
+		child->heapIndex = index;
+		index = childIndex;
+	}
+	[heap replaceObjectAtIndex:index withObject:entry];
+	entry->heapIndex = index;
+	[entry release];
+}
+
+@end
@@ -110,6 +110,12 @@
 
 @property (readonly, nonatomic) NSSet *flatStatusSet;
 @property (readonly, nonatomic) NSArray *sortedFullStateArray;
+/*!
+ * @brief Incremented each time the built-in, saved or temporary statuses change
+ *
+ * flatStatusSet and sortedFullStateArray hold the same statuses for as long as this is unchanged.
+ */
+@property (readonly, nonatomic) NSUInteger statusArrayVersion;
 @property (readonly, nonatomic) AIStatus *offlineStatusState;
 @property (readonly, nonatomic) AIStatus *availableStatus;
 @property (readonly, nonatomic) AIStatus *awayStatus;
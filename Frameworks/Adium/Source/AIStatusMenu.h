@@ -21,6 +21,9 @@
 	NSMutableArray	*menuItemArray;
 	NSMutableSet	*stateMenuItemsAlreadyValidated;
 
+	NSArray			*menuStatusItems; //The statuses the menu items were made for
+	NSUInteger		menuStatusArrayVersion;
+
 	id<AIStatusMenuDelegate>				delegate;
 }
 
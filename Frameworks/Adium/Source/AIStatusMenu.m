@@ -37,6 +37,7 @@
 - (void)stateArrayChanged:(NSNotification *)notification;
 - (void)activeStatusStateChanged:(NSNotification *)notification;
 - (void)statusIconSetChanged:(NSNotification *)notification;
+- (void)updateMenuItemsInPlace;
 - (IBAction)selectCustomState:(id)sender;
 - (void)selectState:(id)sender;
 + (void)dummyAction:(id)sender;
@@ -85,6 +86,7 @@
 	[[NSNotificationCenter defaultCenter] removeObserver:self];
 	[stateMenuItemsAlreadyValidated release];
 	[menuItemArray release];
+	[menuStatusItems release];
 
 	self.delegate = nil;
 
@@ -114,9 +116,34 @@
 	[menuItemArray addObjectsFromArray:addedMenuItems];
 }
 
+/*!
+ * @brief The state array may have changed
+ *
+ * Nothing is done if the status controller's statuses haven't changed since the menu was built. If the same statuses
+ * are listed in the same order, the existing menu items are brought up to date in place; the delegate only has to
+ * put in new menu items when statuses come, go or move.
+ */
 - (void)stateArrayChanged:(NSNotification *)notification
-{	
-	[self rebuildMenu];
+{
+	NSUInteger	statusArrayVersion = adium.statusController.statusArrayVersion;
+	BOOL		canUpdateInPlace;
+
+	if (menuStatusItems && (statusArrayVersion == menuStatusArrayVersion)) return;
+
+	canUpdateInPlace = [adium.statusController.sortedFullStateArray isEqualToArray:menuStatusItems];
+
+	//A group's submenu may have changed with it, and the delegate may have tailored it, so groups are always rebuilt
+	for (AIStatusItem *statusItem in menuStatusItems) {
+		if (!canUpdateInPlace) break;
+		if ([statusItem isKindOfClass:[AIStatusGroup class]]) canUpdateInPlace = NO;
+	}
+
+	if (canUpdateInPlace) {
+		[self updateMenuItemsInPlace];
+		menuStatusArrayVersion = statusArrayVersion;
+	} else {
+		[self rebuildMenu];
+	}
 }
 
 - (void)activeStatusStateChanged:(NSNotification *)notification
@@ -170,10 +197,14 @@
 	[menuItemArray removeAllObjects];
 	[stateMenuItemsAlreadyValidated removeAllObjects];
 
+	[menuStatusItems release];
+	menuStatusItems = [adium.statusController.sortedFullStateArray copy];
+	menuStatusArrayVersion = adium.statusController.statusArrayVersion;
+
 	/* Create a menu item for each state.  States must first be sorted such that states of the same AIStatusType
 		* are grouped together.
 		*/
-	enumerator = [[adium.statusController sortedFullStateArray] objectEnumerator];
+	enumerator = [menuStatusItems objectEnumerator];
 	while ((statusState = [enumerator nextObject])) {
 		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
 		AIStatusType thisStatusType = statusState.statusType;
@@ -246,6 +277,37 @@
 	[adium.menuController endDelayMenuItemPostProcessing];
 }
 
+/*!
+ * @brief Bring the titles, tool tips and icons of our menu items, and the delegate's copies, up to date
+ */
+- (void)updateMenuItemsInPlace
+{
+	[adium.menuController delayMenuItemPostProcessing];
+
+	for (NSMenuItem *menuItem in menuItemArray) {
+		id			representedObject = [menuItem representedObject];
+		AIStatus	*statusState;
+		NSString	*title, *toolTip;
+
+		//Separators and Custom... items stay as they are; delegates may also have given us items of their own
+		if (![representedObject isKindOfClass:[NSDictionary class]] ||
+			!(statusState = [representedObject objectForKey:@"AIStatus"]) ||
+			![statusState isKindOfClass:[AIStatus class]]) continue;
+
+		title = [AIStatusMenu titleForMenuDisplayOfState:statusState];
+		if (![[menuItem title] isEqualToString:title]) [menuItem setTitle:title];
+
+		toolTip = [statusState statusMessageTooltipString];
+		if ((toolTip != [menuItem toolTip]) && ![toolTip isEqualToString:[menuItem toolTip]]) [menuItem setToolTip:toolTip];
+
+		[menuItem setImage:[statusState menuIcon]];
+	}
+
+	[stateMenuItemsAlreadyValidated removeAllObjects];
+
+	[adium.menuController endDelayMenuItemPostProcessing];
+}
+
 /*!
 * @brief Menu validation
  *
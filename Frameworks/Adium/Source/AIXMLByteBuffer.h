@@ -0,0 +1,52 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/*!
+ * @class AIXMLByteBuffer
+ * @brief A growable buffer of UTF-8 bytes for serializing XML
+ *
+ * Strings are converted straight into the buffer's storage, and escaping is done on the converted UTF-8
+ * bytes with a lookup table, so serializing an element creates no intermediate strings. The buffer keeps
+ * its storage when emptied with -removeAllBytes, so one buffer can be reused for every element written.
+ *
+ * Escaping matches -[NSString stringByEscapingForXMLWithEntities:] with no entities: the five predefined
+ * entities &amp; &lt; &gt; &quot; and &apos; are written, and everything else is passed through.
+ *
+ * Not thread safe.
+ */
+@interface AIXMLByteBuffer : NSObject {
+	uint8_t		*bytes;
+	NSUInteger	 length;
+	NSUInteger	 capacity;
+}
+
+- (id)initWithCapacity:(NSUInteger)inCapacity;
+
+@property (readonly, nonatomic) const uint8_t *bytes;
+@property (readonly, nonatomic) NSUInteger length;
+
+- (void)appendBytes:(const void *)inBytes length:(NSUInteger)inLength;
+- (void)appendCString:(const char *)cString;
+- (void)appendString:(NSString *)string;
+
+- (void)appendXMLEscapedUTF8Bytes:(const void *)inBytes length:(NSUInteger)inLength;
+- (void)appendXMLEscapedString:(NSString *)string;
+
+- (void)removeAllBytes;
+
+- (NSData *)data;
+
+@end
@@ -0,0 +1,217 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <Adium/AIXMLByteBuffer.h>
+
+#define MINIMUM_CAPACITY	256
+
+/*!
+ * @brief Replacements for the bytes which must be escaped, indexed by byte
+ *
+ * Every byte of a multibyte UTF-8 sequence is 0x80 or above, so looking bytes up one at a time can never
+ * match part of a non-ASCII character.
+ */
+static const char *const xmlEscapes[256] = {
+	['&']  = "&amp;",
+	['<']  = "&lt;",
+	['>']  = "&gt;",
+	['"']  = "&quot;",
+	['\''] = "&apos;"
+};
+
+/*!
+ * @brief How much longer each byte becomes when escaped, indexed by byte
+ */
+static const uint8_t xmlEscapeGrowth[256] = {
+	['&']  = sizeof("&amp;") - 2,
+	['<']  = sizeof("&lt;") - 2,
+	['>']  = sizeof("&gt;") - 2,
+	['"']  = sizeof("&quot;") - 2,
+	['\''] = sizeof("&apos;") - 2
+};
+
+static NSUInteger growthForEscaping(const uint8_t *inBytes, NSUInteger inLength)
+{
+	NSUInteger growth = 0;
+	for (NSUInteger i = 0; i < inLength; i++) {
+		growth += xmlEscapeGrowth[inBytes[i]];
+	}
+
+	return growth;
+}
+
+@interface AIXMLByteBuffer ()
+- (void)ensureCapacity:(NSUInteger)neededCapacity;
+- (NSUInteger)appendUTF8BytesOfString:(NSString *)string;
+@end
+
+@implementation AIXMLByteBuffer
+
+@synthesize bytes, length;
+
+- (id)init
+{
+	return [self initWithCapacity:MINIMUM_CAPACITY];
+}
+
+- (id)initWithCapacity:(NSUInteger)inCapacity
+{
+	if ((self = [super init])) {
+		[self ensureCapacity:inCapacity];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	free(bytes);
+
+	[super dealloc];
+}
+
+/*!
+ * @brief Grow the storage, if needed, to hold at least neededCapacity bytes
+ */
+- (void)ensureCapacity:(NSUInteger)neededCapacity
+{
+	if (neededCapacity <= capacity) return;
+
+	NSUInteger newCapacity = MAX(capacity, MINIMUM_CAPACITY);
+	while (newCapacity < neededCapacity) {
+		newCapacity *= 2;
+	}
+
+	uint8_t *newBytes = realloc(bytes, newCapacity);
+	if (!newBytes) {
+		[NSException raise:NSMallocException format:@"Couldn't grow %@ to %lu bytes", self, (unsigned long)newCapacity];
+	}
+
+	bytes = newBytes;
+	capacity = newCapacity;
+}
+
+- (void)appendBytes:(const void *)inBytes length:(NSUInteger)inLength
+{
+	[self ensureCapacity:length + inLength];
+	memcpy(bytes + length, inBytes, inLength);
+	length += inLength;
+}
+
+- (void)appendCString:(const char *)cString
+{
+	[self appendBytes:cString length:strlen(cString)];
+}
+
+/*!
+ * @brief Convert a string to UTF-8 directly onto the end of the buffer
+ *
+ * @result The number of bytes appended
+ */
+- (NSUInteger)appendUTF8BytesOfString:(NSString *)string
+{
+	CFIndex stringLength = CFStringGetLength((CFStringRef)string);
+	if (!stringLength) return 0;
+
+	CFIndex maximumLength = CFStringGetMaximumSizeForEncoding(stringLength, kCFStringEncodingUTF8);
+	CFIndex usedLength = 0;
+
+	[self ensureCapacity:length + maximumLength];
+	CFStringGetBytes((CFStringRef)string, CFRangeMake(0, stringLength), kCFStringEncodingUTF8, 0, false,
+					 bytes + length, maximumLength, &usedLength);
+	length += usedLength;
+
+	return usedLength;
+}
+
+- (void)appendString:(NSString *)string
+{
+	[self appendUTF8BytesOfString:string];
+}
+
+- (void)appendXMLEscapedUTF8Bytes:(const void *)inBytes length:(NSUInteger)inLength
+{
+	const uint8_t *source = inBytes;
+
+	[self ensureCapacity:length + inLength + growthForEscaping(source, inLength)];
+
+	uint8_t *destination = bytes + length;
+	for (NSUInteger i = 0; i < inLength; i++) {
+		const char *escape = xmlEscapes[source[i]];
+		if (escape) {
+			NSUInteger escapeLength = xmlEscapeGrowth[source[i]] + 1;
+			memcpy(destination, escape, escapeLength);
+			destination += escapeLength;
+		} else {
+			*destination++ = source[i];
+		}
+	}
+
+	length = destination - bytes;
+}
+
+/*!
+ * @brief Append a string, escaping it for use as XML text or an attribute value
+ *
+ * The string is converted in place and then, only if it has anything to escape, spread out from the
+ * back so each byte is moved at most once.
+ */
+- (void)appendXMLEscapedString:(NSString *)string
+{
+	NSUInteger start = length;
+	NSUInteger convertedLength = [self appendUTF8BytesOfString:string];
+	NSUInteger growth = growthForEscaping(bytes + start, convertedLength);
+
+	if (!growth) return;
+
+	[self ensureCapacity:length + growth];
+
+	uint8_t *source = bytes + start + convertedLength;
+	uint8_t *destination = source + growth;
+	while (source > bytes + start) {
+		uint8_t byte = *--source;
+		const char *escape = xmlEscapes[byte];
+		if (escape) {
+			NSUInteger escapeLength = xmlEscapeGrowth[byte] + 1;
+			destination -= escapeLength;
+			memcpy(destination, escape, escapeLength);
+		} else {
+			*--destination = byte;
+		}
+	}
+
+	length += growth;
+}
+
+/*!
+ * @brief Empty the buffer, keeping its storage for reuse
+ */
+- (void)removeAllBytes
+{
+	length = 0;
+}
+
+/*!
+ * @brief A copy of the buffer's contents
+ *
+ * The copy is independent of the buffer, so it may be handed to another queue while the buffer is reused.
+ */
+- (NSData *)data
+{
+	return [NSData dataWithBytes:bytes length:length];
+}
+
+@end
@@ -23,6 +23,8 @@
 
 #import <Cocoa/Cocoa.h>
 
+@class AIXMLByteBuffer;
+
 //FIXME: This class is not CodingStyle compliant.
 @interface AIXMLElement : NSObject <NSCopying> {
 	NSString *name;
@@ -71,5 +73,13 @@
 
 - (NSData *) UTF8XMLData;
 - (void) appendUTF8XMLBytesToData:(NSMutableData *)data;
+- (void) appendUTF8XMLBytesToBuffer:(AIXMLByteBuffer *)buffer;
+
+//Writes the same bytes as an element with these attributes and a single already-escaped string of contents, without building one.
++ (void) appendUTF8XMLBytesForElementWithName:(NSString *)elementName
+							   attributeNames:(NSArray *)attrNames
+									   values:(NSArray *)attrVals
+							  escapedContents:(NSString *)escapedContents
+									 toBuffer:(AIXMLByteBuffer *)buffer;
 
 @end
@@ -22,6 +22,7 @@
  */
 
 #import <Adium/AIXMLElement.h>
+#import <Adium/AIXMLByteBuffer.h>
 
 #import <AIUtilities/AIStringAdditions.h>
 
@@ -396,46 +397,106 @@
 }
 
 /*!
- * @brief Append a UTF-8 XML representation of the element string to a mutable string
- * 
- * @param string The NSMutableString to append to
+ * @brief Write the start tag, less its closing '>', for an element with the given name and attributes
+ *
+ * Names are written as they are; attribute values are escaped the same way as -quotedXMLAttributeValueStringForString:.
  */
-- (void)appendUTF8XMLBytesToData:(NSMutableData *)data
+static void appendUTF8StartTagToBuffer(AIXMLByteBuffer *buffer, NSString *elementName, NSArray *attrNames, NSArray *attrVals)
 {
-	NSMutableString *startTag = [NSMutableString stringWithFormat:@"<%@", name];
-	if ([self numberOfAttributes]) {
-		NSUInteger attributeIdx = 0U;
-		NSString *key;
-		for (key in attributeNames) {
-			NSString *value = [attributeValues objectAtIndex:attributeIdx++];
-			if ([value respondsToSelector:@selector(stringValue)]) {
-				value = [(NSNumber *)value stringValue];
-			} else if ([value respondsToSelector:@selector(absoluteString)]) {
-				value = [(NSURL *)value absoluteString];
-			}
-			[startTag appendFormat:@" %@=%@", key, [self quotedXMLAttributeValueStringForString:value]];
+	[buffer appendBytes:"<" length:1];
+	[buffer appendString:elementName];
+
+	NSUInteger attributeIdx = 0U;
+	for (NSString *key in attrNames) {
+		NSString *value = [attrVals objectAtIndex:attributeIdx++];
+		if ([value respondsToSelector:@selector(stringValue)]) {
+			value = [(NSNumber *)value stringValue];
+		} else if ([value respondsToSelector:@selector(absoluteString)]) {
+			value = [(NSURL *)value absoluteString];
 		}
+
+		[buffer appendBytes:" " length:1];
+		[buffer appendString:key];
+		[buffer appendBytes:"=\"" length:2];
+		[buffer appendXMLEscapedString:value];
+		[buffer appendBytes:"\"" length:1];
 	}
+}
+
+/*!
+ * @brief Append a UTF-8 XML representation of the element to a byte buffer
+ *
+ * Produces the same bytes as converting -XMLString to UTF-8, without creating any intermediate strings.
+ *
+ * @param buffer The AIXMLByteBuffer to append to
+ */
+- (void)appendUTF8XMLBytesToBuffer:(AIXMLByteBuffer *)buffer
+{
+	appendUTF8StartTagToBuffer(buffer, name, attributeNames, attributeValues);
 	if ((![contents count]) && (selfCloses)) {
-		[startTag appendString:@" /"];
+		[buffer appendBytes:" /" length:2];
 	}
-	[startTag appendString:@">"];
-	[data appendData:[startTag dataUsingEncoding:NSUTF8StringEncoding]];
+	[buffer appendBytes:">" length:1];
 
 	id obj;
 	for (obj in contents) {
 		if ([obj isKindOfClass:[NSString class]]) {
-			[data appendData:[(NSString *)obj dataUsingEncoding:NSUTF8StringEncoding]];
+			[buffer appendString:(NSString *)obj];
 		} else if([obj isKindOfClass:[AIXMLElement class]]) {
-			[(AIXMLElement *)obj appendUTF8XMLBytesToData:data];
+			[(AIXMLElement *)obj appendUTF8XMLBytesToBuffer:buffer];
 		}
 	}
 
 	if ([contents count] || !selfCloses) {
-		[data appendData:[[NSString stringWithFormat:@"</%@>", name] dataUsingEncoding:NSUTF8StringEncoding]];
+		[buffer appendBytes:"</" length:2];
+		[buffer appendString:name];
+		[buffer appendBytes:">" length:1];
 	}
 }
 
+/*!
+ * @brief Append a UTF-8 XML representation of an element without creating it
+ *
+ * This writes the same bytes as -appendUTF8XMLBytesToBuffer: would for an element named elementName with the
+ * given attributes, to which escapedContents had been added with -addEscapedObject:. It is meant for callers,
+ * such as the logger, which write many short-lived elements of a fixed shape.
+ *
+ * @param elementName The name of the element
+ * @param attrNames The names of the attributes, as for -setAttributeNames:values:
+ * @param attrVals The values of the attributes, as for -setAttributeNames:values:
+ * @param escapedContents The already-escaped contents of the element
+ * @param buffer The AIXMLByteBuffer to append to
+ */
++ (void)appendUTF8XMLBytesForElementWithName:(NSString *)elementName
+							  attributeNames:(NSArray *)attrNames
+									  values:(NSArray *)attrVals
+							 escapedContents:(NSString *)escapedContents
+									toBuffer:(AIXMLByteBuffer *)buffer
+{
+	NSParameterAssert(elementName != nil);
+	NSAssert2([attrNames count] == [attrVals count], @"Attribute names and values have different lengths, %lui and %lui respectively", (unsigned long)[attrNames count], (unsigned long)[attrVals count]);
+
+	appendUTF8StartTagToBuffer(buffer, elementName, attrNames, attrVals);
+	[buffer appendBytes:">" length:1];
+	if (escapedContents) [buffer appendString:escapedContents];
+	[buffer appendBytes:"</" length:2];
+	[buffer appendString:elementName];
+	[buffer appendBytes:">" length:1];
+}
+
+/*!
+ * @brief Append a UTF-8 XML representation of the element string to a mutable data
+ * 
+ * @param data The NSMutableData to append to
+ */
+- (void)appendUTF8XMLBytesToData:(NSMutableData *)data
+{
+	AIXMLByteBuffer *buffer = [[AIXMLByteBuffer alloc] init];
+	[self appendUTF8XMLBytesToBuffer:buffer];
+	[data appendBytes:buffer.bytes length:buffer.length];
+	[buffer release];
+}
+
 /*!
  * @brief A UTF-8 XML string representation of this element
  *
@@ -447,9 +508,12 @@
  */
 - (NSData *)UTF8XMLData
 {
-	NSMutableData *data = [NSMutableData data];
-	[self appendUTF8XMLBytesToData:data];
-	return [NSData dataWithData:data];
+	AIXMLByteBuffer *buffer = [[AIXMLByteBuffer alloc] init];
+	[self appendUTF8XMLBytesToBuffer:buffer];
+	NSData *data = [buffer data];
+	[buffer release];
+
+	return data;
 }
 
 - (NSString *)description
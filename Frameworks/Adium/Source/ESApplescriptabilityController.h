@@ -20,6 +20,7 @@
 
 @interface ESApplescriptabilityController : NSObject <AIApplescriptabilityController> {
 	AdiumApplescriptRunner	*applescriptRunner;
+	AIScriptExecutorPool	*scriptExecutorPool;
 }
 
 @end
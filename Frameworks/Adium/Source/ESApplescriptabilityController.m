@@ -22,23 +22,33 @@
 #import "AIStatusController.h"
 #import "ESApplescriptabilityController.h"
 #import <AIUtilities/AdiumApplescriptRunner.h>
+#import <AIUtilities/AIScriptExecutorPool.h>
 #import <AIUtilities/AIAttributedStringAdditions.h>
 #import <Adium/AIAccount.h>
 #import <Adium/AIContentMessage.h>
 #import "AIHTMLDecoder.h"
 #import <Adium/AIStatus.h>
 
+//How many scripts are sent to the helper at once, so one slow script doesn't hold up all the others in the pool
+#define APPLESCRIPT_REQUESTS_IN_FLIGHT	4
+//Scripts run through -runApplescriptAtPath:... may wait on the user, such as in a dialog, so they're given a while
+#define APPLESCRIPT_TIMEOUT				300
+
 @implementation ESApplescriptabilityController
 
 - (void)controllerDidLoad
 {
 	applescriptRunner = [[AdiumApplescriptRunner alloc] init];
+	scriptExecutorPool = [[AIScriptExecutorPool alloc] initWithExecutors:[NSArray arrayWithObject:applescriptRunner]
+													 requestsPerExecutor:APPLESCRIPT_REQUESTS_IN_FLIGHT];
 }
 
 
 //close
 - (void)controllerWillClose
 {
+	[scriptExecutorPool invalidate];
+	[scriptExecutorPool release]; scriptExecutorPool = nil;
 	[applescriptRunner release]; applescriptRunner = nil;
 }
 
@@ -158,17 +168,24 @@
 
 #pragma mark Running applescripts
 
+@synthesize scriptExecutorPool;
+
 /*!
  * @brief Run an AppleScript, optionally calling a function with arguments, and notifying a target/selector with its output when it is done.
+ *
+ * The script waits its turn in the script executor pool. If it hasn't finished APPLESCRIPT_TIMEOUT seconds from now,
+ * the target is notified with a nil result.
  */
 - (void)runApplescriptAtPath:(NSString *)path function:(NSString *)function arguments:(NSArray *)arguments notifyingTarget:(id)target selector:(SEL)selector userInfo:(id)userInfo
 {
-	[applescriptRunner runApplescriptAtPath:path
-								   function:function
-								  arguments:arguments
-							notifyingTarget:target
-								   selector:selector
-								   userInfo:userInfo];
+	[scriptExecutorPool runScriptAtPath:path
+							   function:function
+							  arguments:arguments
+							  cacheable:NO
+								timeout:APPLESCRIPT_TIMEOUT
+						notifyingTarget:target
+							   selector:selector
+							   userInfo:userInfo];
 }
 
 @end
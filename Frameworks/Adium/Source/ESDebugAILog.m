@@ -15,6 +15,7 @@
  */
 
 #import <Adium/AIDebugControllerProtocol.h>
+#import <Adium/AIDebugLogBuffer.h>
 #import <stdarg.h>
 #import <execinfo.h>
 
@@ -40,77 +41,41 @@ BOOL AIDebugLoggingIsEnabled()
 /*!
  * @brief Adium debug log function
  *
- * Prints a message to the Adium debug window, which is only enabled in Debug builds or by a hidden preference.  
+ * Records a message for the Adium debug window, which is only enabled in Debug builds or by a hidden preference.
+ * The message is formatted later, off this thread; see AIDebugLogBuffer.h.
  *
  * @param format A printf-style format string
  * @param ... 0 or more arguments to the format string
  */
-void AIAddDebugMessage(NSString *debugMessage)
-{
-	NSString *actualMessage = [[[NSDate date] descriptionWithCalendarFormat:@"%H:%M:%S: "
-																   timeZone:nil
-																	 locale:nil] stringByAppendingString:debugMessage];
-	
-	/* Be careful; we should only modify debugLogArray and the windowController's view on the main thread. */
-	if ([NSRunLoop currentRunLoop] == [NSRunLoop mainRunLoop]) {
-		[adium.debugController addMessage:actualMessage];
-
-	} else {
-		[adium.debugController performSelectorOnMainThread:@selector(addMessage:)
-																		   withObject:actualMessage
-																		waitUntilDone:NO];		
-	}
-}
-
 void AILog_impl (NSString *format, ...) {
 	va_list		ap; /* Points to each unamed argument in turn */
-	NSString	*debugMessage;
 	
 	va_start(ap, format); /* Make ap point to the first unnamed argument */
-	
-	debugMessage = [[NSString alloc] initWithFormat:format
-										  arguments:ap];
-	AIAddDebugMessage(debugMessage);
-	[debugMessage release];
-
+	AIDebugLogBufferRecord(AIDebugLogMessage, NULL, 0, NULL, format, ap);
 	va_end(ap); /* clean up when done */
 }
 
 void AILogWithSignature_impl(const char *name, int line, NSString *format, ...) {
 	va_list		ap; /* Points to each unamed argument in turn */
-	NSString	*debugMessage, *actualMessage;
 	const char	*queue = NULL;
 	
+	//AILogWithSignature() isn't wrapped in a check like the other macros are
+	if (!AIDebugLoggingEnabled) return;
+	
 	if (dispatch_get_current_queue() != dispatch_get_main_queue()) {
 		queue = dispatch_queue_get_label(dispatch_get_current_queue());
 	}
 	
 	va_start(ap, format); /* Make ap point to the first unnamed argument */
-	
-	debugMessage = [[NSString alloc] initWithFormat:format
-										  arguments:ap];
-	if (!queue)
-		actualMessage = [NSString stringWithFormat:@"%s:%d: %@", name, line, debugMessage];
-	else
-		actualMessage = [NSString stringWithFormat:@"%s:%d: (on %s) %@", name, line, (queue ?: ""), debugMessage];
-	AIAddDebugMessage(actualMessage);
-	[debugMessage release];
-	
+	AIDebugLogBufferRecord(AIDebugLogMessageWithSignature, name, line, queue, format, ap);
 	va_end(ap); /* clean up when done */
 }
 
 void AILogWithPrefix_impl (const char *prefix, NSString *format, ...) {
 	va_list		ap; /* Points to each unamed argument in turn */
-	NSString	*debugMessage, *actualMessage;
 	
 	va_start(ap, format); /* Make ap point to the first unnamed argument */
-	
-	debugMessage = [[NSString alloc] initWithFormat:format
-										  arguments:ap];
-	actualMessage = [NSString stringWithFormat:@"%s: %@", prefix, debugMessage];
-	AIAddDebugMessage(actualMessage);
-	[debugMessage release];
-
+	AIDebugLogBufferRecord(AIDebugLogMessageWithPrefix, prefix, 0, NULL, format, ap);
 	va_end(ap); /* clean up when done */
 }
 
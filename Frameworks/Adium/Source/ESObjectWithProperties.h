@@ -27,9 +27,15 @@ typedef enum {
 #define KEY_KEY		@"Key"
 #define KEY_VALUE	@"Value"
 
+struct ESPropertyLayout;
+
 @interface ESObjectWithProperties : NSObject {
-	NSMutableDictionary		*propertiesDictionary;
-	NSMutableSet			*changedProperties;		//Properties that have changed since the last notification
+	NSMutableDictionary		*propertiesDictionary;	//Properties whose keys are not in the key registry
+	NSMutableSet			*changedProperties;		//Unregistered properties that have changed since the last notification
+
+	const struct ESPropertyLayout	*propertyLayout;	//Where our class keeps each registered key; looked up on first use
+	id						*slotValues;			//Registered properties not backed by an ivar, indexed by the layout's slots
+	uint64_t				 changedSlots;			//Registered properties that have changed since the last notification, by key index
 	
 	NSMutableDictionary		*displayDictionary;		//A dictionary of values affecting this object's display
 	
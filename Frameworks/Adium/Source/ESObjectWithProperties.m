@@ -16,15 +16,135 @@
 
 #import <Adium/ESObjectWithProperties.h>
 #import <AIUtilities/AIMutableOwnerArray.h>
+#import <AIUtilities/AITimerWheel.h>
 #import <Adium/AIProxyListObject.h>
 
 #import <objc/runtime.h>
+#import <pthread.h>
 
 @interface ESObjectWithProperties (AIPrivate)
-- (void)_applyDelayedProperties:(NSDictionary *)infoDict;
+- (void)_applyDelayedProperties:(AIWheelTimer *)inTimer;
 - (id)_valueForProperty:(NSString *)key;
 @end
 
+#pragma mark Property key registry
+
+/*!
+ * @brief Keys which are set often enough, on enough objects, to be worth a fixed slot
+ *
+ * Each key's position here is its index in the registry and its bit in changedSlots. Any other key is stored
+ * in propertiesDictionary as before.
+ */
+static NSString *const registeredPropertyKeys[] = {
+	@"isOnline", @"idleSince", @"idle", @"isIdle", @"isMobile", @"isBlocked", @"notAStranger",
+	@"signedOn", @"signedOff", @"Signon Date", @"Warning", @"isEvent", @"New Object",
+	@"listObjectStatusMessage", @"listObjectStatusType", @"listObjectStatusName", @"textProfile",
+	@"typing", @"ExpandedByFiltering", @"TemporaryMetaContactExpansion",
+	@"isConnecting", @"isDisconnecting", @"isWaitingForNetwork", @"waitingToReconnect"
+};
+
+#define REGISTERED_PROPERTY_KEY_COUNT	(sizeof(registeredPropertyKeys) / sizeof(registeredPropertyKeys[0]))
+
+//Fails to compile if a key is added beyond what changedSlots can track
+typedef char ESRegisteredPropertyKeysFitInChangedSlots[(REGISTERED_PROPERTY_KEY_COUNT <= 64) ? 1 : -1];
+
+/*!
+ * @brief Where one class keeps each registered key
+ *
+ * Keys backed by an ivar of the class use the ivar, exactly as unregistered keys do. The rest get consecutive
+ * slots, so the per-object slot array only holds the keys the class can actually store there.
+ */
+typedef struct ESPropertyLayout {
+	Ivar		ivars[REGISTERED_PROPERTY_KEY_COUNT];	//The ivar backing each key, or NULL
+	int8_t		slots[REGISTERED_PROPERTY_KEY_COUNT];	//Index into slotValues, or -1 for ivar-backed keys
+	NSUInteger	slotCount;
+} ESPropertyLayout;
+
+/*!
+ * @brief The registry index of a key, or NSNotFound if it isn't registered
+ */
+static NSUInteger ESPropertyKeyIndex(NSString *key)
+{
+	static CFDictionaryRef keyIndexes;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		CFMutableDictionaryRef indexes = CFDictionaryCreateMutable(NULL, REGISTERED_PROPERTY_KEY_COUNT,
+																   &kCFTypeDictionaryKeyCallBacks, NULL);
+		//Store index + 1 so that a missing key (NULL) can't be mistaken for index 0
+		for (NSUInteger i = 0; i < REGISTERED_PROPERTY_KEY_COUNT; i++)
+			CFDictionarySetValue(indexes, registeredPropertyKeys[i], (const void *)(i + 1));
+		keyIndexes = indexes;
+	});
+
+	NSUInteger index = (NSUInteger)CFDictionaryGetValue(keyIndexes, key);
+	return (index ? index - 1 : NSNotFound);
+}
+
+/*!
+ * @brief The layout for a class, built the first time an instance of it is asked for a registered key
+ *
+ * Layouts are never freed; there is one per class.
+ */
+static const ESPropertyLayout *ESPropertyLayoutForClass(Class inClass)
+{
+	static pthread_mutex_t layoutLock = PTHREAD_MUTEX_INITIALIZER;
+	static CFMutableDictionaryRef layouts = NULL;
+
+	pthread_mutex_lock(&layoutLock);
+	if (!layouts) layouts = CFDictionaryCreateMutable(NULL, 0, NULL, NULL);
+
+	ESPropertyLayout *layout = (ESPropertyLayout *)CFDictionaryGetValue(layouts, inClass);
+	if (!layout) {
+		layout = calloc(1, sizeof(ESPropertyLayout));
+		for (NSUInteger i = 0; i < REGISTERED_PROPERTY_KEY_COUNT; i++) {
+			layout->ivars[i] = class_getInstanceVariable(inClass, [registeredPropertyKeys[i] UTF8String]);
+			layout->slots[i] = (layout->ivars[i] ? -1 : (int8_t)layout->slotCount++);
+		}
+		CFDictionarySetValue(layouts, inClass, layout);
+	}
+	pthread_mutex_unlock(&layoutLock);
+
+	return layout;
+}
+
+/*!
+ * @brief Read a property stored in an ivar, boxing NSInteger ivars
+ */
+static id ESValueOfIvar(id self, Ivar ivar, NSString *key)
+{
+	const char *ivarType = ivar_getTypeEncoding(ivar);
+	void *value = (void *)object_getIvar(self, ivar);
+
+	// attempt to wrap it, if we know how
+	if (strcmp(ivarType, @encode(NSInteger)) == 0) {
+		return [[[NSNumber alloc] initWithInteger:(NSInteger)value] autorelease];
+	} else if (ivarType[0] != _C_ID) {
+		AILogWithSignature(@" *** This ivar is not an object but an %s! Should not use -valueForProperty: @\"%@\" ***", ivarType, key);
+		return nil;
+	}
+
+	return [[(id)value retain] autorelease];
+}
+
+/*!
+ * @brief Store a property in an ivar, unwrapping NSInteger ivars
+ */
+static void ESSetValueOfIvar(id self, Ivar ivar, id value)
+{
+	const char *ivarType = ivar_getTypeEncoding(ivar);
+
+	// check if it's a primitive type, if so, attempt to unwrap value
+	if (ivarType[0] == _C_ID) {
+		id oldValue = object_getIvar(self, ivar);
+		object_setIvar(self, ivar, [value retain]);
+		[oldValue release];
+
+	} else if (strcmp(ivarType, @encode(NSInteger)) == 0) {
+		NSInteger iValue = (value ? [value integerValue] : 0);
+		object_setIvar(self, ivar, (void *)iValue);
+	}
+}
+
 /*!
  * @class ESObjectWithProperties
  * @brief Abstract superclass for objects with a system of properties and display arrays
@@ -33,6 +153,10 @@
  * keys and optional delayed, grouped notification.  They allow storage of arbitrary information associate with
  * an ESObjectWithProperties subclass. Such information is not persistent across sessions.
  *
+ * A property is stored in the ivar of the same name if the class has one. Otherwise, keys in the registry above
+ * live in a small per-object slot array and have their changes noted in a bitset; any other key goes in a
+ * dictionary and a set of changed keys.
+ *
  * Properties are KVO compliant.
  *
  * Display arrays utilize AIMutableOwnerArray.  See its documentation in AIUtilities.framework.
@@ -55,11 +179,27 @@
 
 	[propertiesDictionary release]; propertiesDictionary = nil;
 	[changedProperties release]; changedProperties = nil;
+
+	if (slotValues) {
+		for (NSUInteger i = 0; i < propertyLayout->slotCount; i++)
+			[slotValues[i] release];
+		free(slotValues); slotValues = NULL;
+	}
+
 	[displayDictionary release]; displayDictionary = nil;
 
 	[super dealloc];
 }
 
+/*!
+ * @brief Our class's layout for registered keys
+ */
+- (const ESPropertyLayout *)_propertyLayout
+{
+	if (!propertyLayout) propertyLayout = ESPropertyLayoutForClass([self class]);
+	return propertyLayout;
+}
+
 //Setting properties ---------------------------------------------------------------------------------------------------
 #pragma mark Setting Properties
 
@@ -80,45 +220,47 @@
         
     [self willChangeValueForKey:key];
     	
-	Ivar ivar = class_getInstanceVariable([self class], [key UTF8String]);
+	NSUInteger index = ESPropertyKeyIndex(key);
+	Ivar ivar;
 	
-	// fall back to the dictionary
-	if (ivar == NULL) {
+	if (index != NSNotFound) {
+		const ESPropertyLayout *layout = [self _propertyLayout];
+		ivar = layout->ivars[index];
 		
-		if (!propertiesDictionary && value) {
-			// only allocate the dictionary when we're going to actually use it
-			propertiesDictionary = [[NSMutableDictionary alloc] init];
-		}
-		
-		if (value) {
-			[propertiesDictionary setObject:value forKey:key];
-		} else {
-			[propertiesDictionary removeObjectForKey:key];
+		if (!ivar) {
+			if (!slotValues && value) {
+				// as with the dictionary, only allocate the slots when we're going to actually use them
+				slotValues = calloc(layout->slotCount, sizeof(id));
+			}
+			
+			if (slotValues) {
+				id *slot = &slotValues[layout->slots[index]];
+				[*slot release];
+				*slot = [value retain];
+			}
 		}
 		
 	} else {
-		const char *ivarType = ivar_getTypeEncoding(ivar);
+		ivar = class_getInstanceVariable([self class], [key UTF8String]);
 		
-		// check if it's a primitive type, if so, attempt to unwrap value
-		if (ivarType[0] == _C_ID) {
-			
-			[oldValue release];
-			object_setIvar(self, ivar, [value retain]);
-			
-		} else if (strcmp(ivarType, @encode(NSInteger)) == 0) {
-			
-			NSInteger iValue;
+		// fall back to the dictionary
+		if (ivar == NULL) {
+			if (!propertiesDictionary && value) {
+				// only allocate the dictionary when we're going to actually use it
+				propertiesDictionary = [[NSMutableDictionary alloc] init];
+			}
 			
 			if (value) {
-				iValue = [value integerValue];
+				[propertiesDictionary setObject:value forKey:key];
 			} else {
-				iValue = 0;
+				[propertiesDictionary removeObjectForKey:key];
 			}
-			
-			object_setIvar(self, ivar, (void *)iValue);
-			
 		}
 	}
+	
+	if (ivar) {
+		ESSetValueOfIvar(self, ivar, value);
+	}
     
     [self object:self didChangeValueForProperty:key notify:notify];
     [self didChangeValueForKey:key];
@@ -130,15 +272,19 @@
  * @param value The value
  * @param key The property to set the value to.
  * @param delay The delay until the change is made
+ *
+ * Must be called on the main thread; the change is made from the shared timer wheel.
  */
 - (void)setValue:(id)value forProperty:(NSString *)key afterDelay:(NSTimeInterval)delay
 {
-	[self performSelector:@selector(_applyDelayedProperties:)
-			   withObject:[NSDictionary dictionaryWithObjectsAndKeys:
-				   key, KEY_KEY,
-				   value, KEY_VALUE,
-				   nil]
-			   afterDelay:delay];
+	[[AITimerWheel sharedTimerWheel] scheduleTimerWithDelay:delay
+											 repeatInterval:0
+													 target:self
+												   selector:@selector(_applyDelayedProperties:)
+												   userInfo:[NSDictionary dictionaryWithObjectsAndKeys:
+															 key, KEY_KEY,
+															 value, KEY_VALUE,
+															 nil]];
 }
 
 - (id)valueForUndefinedKey:(NSString *)inKey
@@ -151,8 +297,9 @@
  *
  * Called as a result of -[ESObjectWithProperties setValue:forProperty:afterDelay:]
  */
-- (void)_applyDelayedProperties:(NSDictionary *)infoDict
+- (void)_applyDelayedProperties:(AIWheelTimer *)inTimer
 {
+	NSDictionary	*infoDict = [inTimer userInfo];
 	id				object = [infoDict objectForKey:KEY_VALUE];
 	NSString		*key = [infoDict objectForKey:KEY_KEY];
 	
@@ -166,10 +313,17 @@
  */
 - (void)notifyOfChangedPropertiesSilently:(BOOL)silent
 {
-    if (changedProperties && [changedProperties count]) {
-		//Clear changedProperties in case this status change invokes another, and we re-enter this code
-		NSSet	*keys = changedProperties;
+    if (changedSlots || (changedProperties && [changedProperties count])) {
+		//Clear changedProperties and changedSlots in case this status change invokes another, and we re-enter this code
+		NSMutableSet	*keys = (changedProperties ? changedProperties : [[NSMutableSet alloc] init]);
+		uint64_t		slots = changedSlots;
 		changedProperties = nil;
+		changedSlots = 0;
+		
+		while (slots) {
+			[keys addObject:registeredPropertyKeys[__builtin_ctzll(slots)]];
+			slots &= slots - 1;
+		}
 		
 		[self didModifyProperties:keys silent:silent];
 		
@@ -182,7 +336,24 @@
 //Getting properties ---------------------------------------------------------------------------------------------------
 #pragma mark Getting Properties
 
-@synthesize properties = propertiesDictionary;
+/*!
+ * @brief All properties not stored in ivars
+ */
+- (NSDictionary *)properties
+{
+	if (!slotValues) return propertiesDictionary;
+	
+	NSMutableDictionary *properties = (propertiesDictionary ?
+									   [propertiesDictionary mutableCopy] :
+									   [[NSMutableDictionary alloc] init]);
+	for (NSUInteger i = 0; i < REGISTERED_PROPERTY_KEY_COUNT; i++) {
+		int8_t slot = propertyLayout->slots[i];
+		if (slot != -1 && slotValues[slot])
+			[properties setObject:slotValues[slot] forKey:registeredPropertyKeys[i]];
+	}
+	
+	return [properties autorelease];
+}
 
 /*!
  * @brief Compatibility class
@@ -200,31 +371,32 @@
 - (id)_valueForProperty:(NSString *)key
 {
 	id ret = nil;
-	id value = nil;
+	Ivar ivar;
 	
-	Ivar ivar = object_getInstanceVariable(self, [key UTF8String], (void **)&value);
+	NSUInteger index = ESPropertyKeyIndex(key);
 	
-	if (ivar == NULL) {
+	if (index != NSNotFound) {
+		const ESPropertyLayout *layout = [self _propertyLayout];
+		ivar = layout->ivars[index];
 		
-		// no dictionary -> this property is certainly nil
-		if (propertiesDictionary) {
-			ret = [propertiesDictionary objectForKey:key];
+		// no slots -> this property is certainly nil
+		if (!ivar && slotValues) {
+			ret = [[slotValues[layout->slots[index]] retain] autorelease];
 		}
 		
 	} else {
+		ivar = class_getInstanceVariable([self class], [key UTF8String]);
 		
-		const char *ivarType = ivar_getTypeEncoding(ivar);
-		
-		// attempt to wrap it, if we know how
-		if (strcmp(ivarType, @encode(NSInteger)) == 0) {
-			ret = [[[NSNumber alloc] initWithInteger:(NSInteger)value] autorelease];
-		} else if (ivarType[0] != _C_ID) {
-			AILogWithSignature(@" *** This ivar is not an object but an %s! Should not use -valueForProperty: @\"%@\" ***", ivarType, key);
-		} else {
-			ret = [[value retain] autorelease];
+		// no dictionary -> this property is certainly nil
+		if (!ivar && propertiesDictionary) {
+			ret = [propertiesDictionary objectForKey:key];
 		}
 	}
 	
+	if (ivar) {
+		ret = ESValueOfIvar(self, ivar, key);
+	}
+	
     return ret;
 }
 
@@ -237,7 +409,10 @@
 {
 	NSInteger ret = 0;
 	
-	Ivar ivar = class_getInstanceVariable([self class], [key UTF8String]);
+	NSUInteger index = ESPropertyKeyIndex(key);
+	Ivar ivar = ((index != NSNotFound) ?
+				 [self _propertyLayout]->ivars[index] :
+				 class_getInstanceVariable([self class], [key UTF8String]));
 	
 	if (ivar == NULL) {
 		NSNumber *number = [self numberValueForProperty:key];
@@ -311,9 +486,14 @@
 				break;
 			}
 			case NotifyLater: {
-				//Add this key to changedStatusKeys for later notification 
-				if (!changedProperties) changedProperties = [[NSMutableSet alloc] init];
-				[changedProperties addObject:key];
+				//Note this key for later notification
+				NSUInteger index = ESPropertyKeyIndex(key);
+				if (index != NSNotFound) {
+					changedSlots |= (1ULL << index);
+				} else {
+					if (!changedProperties) changedProperties = [[NSMutableSet alloc] init];
+					[changedProperties addObject:key];
+				}
 				break;
 			}
 			case NotifyNever: break; //Take no notification action
@@ -33,7 +33,7 @@
 #import "AWEzvDefines.h"
 #import "AWEzvXMLStream.h"
 
-@class AWEzvXMLStream, AWEzvRendezvousData, AWEzvContactManager, NSImage, ServiceController, EKEzvOutgoingFileTransfer;
+@class AWEzvXMLStream, AWEzvRendezvousData, AWEzvContactManager, NSImage, EKEzvOutgoingFileTransfer;
 
 @interface AWEzvContact : NSObject <AWEzvXMLStreamProtocol> {
 	NSString *name;
@@ -47,9 +47,11 @@
 	NSString *imageHash;
 	u_int16_t port;
 	AWEzvContactManager *manager;
-	ServiceController *resolveServiceController;
-	ServiceController *imageServiceController;
-	ServiceController *addressServiceController;
+	NSData *TXTRecord;
+	NSString *hostName;
+	id resolveServiceController;
+	id imageServiceController;
+	id addressServiceController;
 }
 
 @property (readwrite, copy, nonatomic) NSString *uniqueID;
@@ -48,7 +48,7 @@
 
 @implementation AWEzvContact
 
-@synthesize uniqueID, name, status, idleSinceDate, contactImageData, port, ipAddr, imageHash, manager, stream, addressServiceController, imageServiceController, resolveServiceController, rendezvous;
+@synthesize uniqueID, name, status, idleSinceDate, contactImageData, port, ipAddr, imageHash, manager, stream, TXTRecord, hostName, addressServiceController, imageServiceController, resolveServiceController, rendezvous;
 
 - (NSString *) statusMessage
 {
@@ -69,6 +69,8 @@
 	self.rendezvous = nil;
 	self.ipAddr = nil;
 	self.imageHash = nil;
+	self.TXTRecord = nil;
+	self.hostName = nil;
 	self.resolveServiceController = nil;
 	self.imageServiceController = nil;
 	self.addressServiceController = nil;
@@ -30,12 +30,12 @@
  * ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
  
-#import <dns_sd.h>
+#import "AWEzvDiscoveryBackend.h"
 
 
-@class AWEzv, AWEzvContact, AWEzvRendezvousData, ServiceController;
+@class AWEzv, AWEzvContact, AWEzvRendezvousData;
 
-@interface AWEzvContactManager : NSObject {
+@interface AWEzvContactManager : NSObject <AWEzvDiscoveryBackendDelegate> {
 	NSFileHandle	*listenSocket;
 	NSMutableDictionary *contacts;
 
@@ -48,25 +48,29 @@
 	/* Rendezvous related instance variables */
 	AWEzvRendezvousData		*userAnnounceData;
 
-	ServiceController		*fDomainBrowser;
-	ServiceController		*fServiceBrowser;
-	
-	
-	DNSServiceRef avDNSReference;
-	DNSServiceRef imageServiceRef;
-	DNSRecordRef imageRef;
+	id <AWEzvDiscoveryBackend>	backend;
 
 	NSString *avInstanceName;
 	NSData *imagehash;
 
+	/* Contacts whose state changed since the last userChangedState:, and what it was last reported as */
+	NSMutableSet			*pendingStateChanges;
+	NSMutableDictionary		*reportedStates;
+
+	/* Pictures by phsh, and the contacts waiting for each picture being fetched; the first one is fetching it */
+	NSMutableDictionary		*imageCache;
+	NSMutableDictionary		*imageFetches;
+
 	int				regCount;
 }
 
 - (id) initWithClient:(AWEzv *)client;
+- (id) initWithClient:(AWEzv *)client backend:(id <AWEzvDiscoveryBackend>)inBackend;
 
 - (AWEzvContact *)contactForIdentifier:(NSString *)uniqueID;
 
 @property (readonly, nonatomic) AWEzv *client;
+@property (readonly, nonatomic) id <AWEzvDiscoveryBackend> backend;
 
 - (void)closeConnections;
 @end
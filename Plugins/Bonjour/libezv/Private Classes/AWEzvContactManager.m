@@ -33,16 +33,32 @@
 #import "AWEzvContactManager.h"
 #import "AWEzvContactPrivate.h"
 #import "AWEzvXMLStream.h"
+#import "AWEzvDNSSDBackend.h"
 #import <SystemConfiguration/SystemConfiguration.h>
 
 @implementation AWEzvContactManager
 
 - (id)initWithClient:(AWEzv *)newClient 
+{
+	AWEzvDNSSDBackend *dnssdBackend = [[[AWEzvDNSSDBackend alloc] init] autorelease];
+
+	return [self initWithClient:newClient backend:dnssdBackend];
+}
+
+- (id)initWithClient:(AWEzv *)newClient backend:(id <AWEzvDiscoveryBackend>)inBackend
 {
     if ((self = [super init])) {
 		contacts = [[NSMutableDictionary alloc] init];
 		client = newClient;
 		isConnected = NO;
+
+		backend = [inBackend retain];
+		backend.delegate = self;
+
+		pendingStateChanges = [[NSMutableSet alloc] init];
+		reportedStates = [[NSMutableDictionary alloc] init];
+		imageCache = [[NSMutableDictionary alloc] init];
+		imageFetches = [[NSMutableDictionary alloc] init];
 		
 		/* find username and computer name */
 		CFStringRef consoleUser = SCDynamicStoreCopyConsoleUser(NULL, NULL, NULL);
@@ -84,14 +100,23 @@
 	}
 }
 
-@synthesize client;
+@synthesize client, backend;
 
 - (void)dealloc {
 	/* AWEzvContactManagerListener adds an observer; remove it */
 	[[NSNotificationCenter defaultCenter] removeObserver:self];
+	[NSObject cancelPreviousPerformRequestsWithTarget:self];
+
+	backend.delegate = nil;
+	[backend release]; backend = nil;
 
 	[userAnnounceData release]; userAnnounceData = nil;
 	[avInstanceName release]; avInstanceName = nil;
+	[imagehash release]; imagehash = nil;
+	[pendingStateChanges release]; pendingStateChanges = nil;
+	[reportedStates release]; reportedStates = nil;
+	[imageCache release]; imageCache = nil;
+	[imageFetches release]; imageFetches = nil;
 
 	[super dealloc];
 }
@@ -39,6 +39,8 @@
  * records of others.Until these bugs are fixed, we will continue to use the
  * Mach messaging interface to mDNSResponder (or another interface with similar
  * capabilities) instead of NSNetService/NSNetServiceBrowser
+ *
+ * That interface is reached through the manager's AWEzvDiscoveryBackend; see AWEzvDNSSDBackend.
  */
 
 #import "AWEzvContactManager.h"
@@ -62,41 +64,30 @@
 - (void) startBrowsing;
 - (void) stopBrowsing;
 
-- (void)browseResultwithFlags:(DNSServiceFlags)flags
-				  onInterface:(uint32_t) interfaceIndex
-						 name:(const char *)replyName
-						 type:(const char *)replyType
-					   domain:(const char *)replyDomain
-						   av:(BOOL) av;
-
-- (void)updateContact:(AWEzvContact *)iccontact
+- (void)updateContact:(AWEzvContact *)contact
 			 withData:(AWEzvRendezvousData *)rendezvousData
 			 withHost:(NSString *)host
 		withInterface:(uint32_t)interface
-			 withPort:(uint16_t)recPort
-				   av:(BOOL)av;
+			 withPort:(uint16_t)recPort;
 
 - (void)findAddressForContact:(AWEzvContact *)contact
 					 withHost:(NSString *)host
 				withInterface:(uint32_t)interface;
 
-- (void)updateAddressForContact:(AWEzvContact *)contact
-						   addr:(const void *)buff
-						addrLen:(uint16_t)addrLen
-						   host:(const char*) host
-				 interfaceIndex:(uint32_t)interface
-						   more:(boolean_t)moreToCome;
-
-- (void)updateImageForContact:(AWEzvContact *)contact
-						 data:(const void *)buff
-					  dataLen:(uint16_t)addrLen
-						 more:(boolean_t)moreToCome;
-
 - (void) updatePHSH;
 
+/* Contact updates are gathered up for a moment before the client hears about them; this sends them now */
+- (void) flushContactStateChanges;
+
 // REALLY PRIVATE STUFF
 - (void) setInstanceName:(NSString *)newName;
-- (void) regCallBack:(int)errorCode;
+- (void) noteStateChangeForContact:(AWEzvContact *)contact;
+- (void) forgetContact:(AWEzvContact *)contact;
+
+- (void)updateImageHash:(NSString *)newHash forContact:(AWEzvContact *)contact interface:(uint32_t)interface;
+- (BOOL)fetchImageWithHash:(NSString *)hash forContacts:(NSArray *)waitingContacts interface:(uint32_t)interface;
+- (void)abandonImageFetchForContact:(AWEzvContact *)contact;
+- (BOOL)cacheImageData:(NSData *)imageData withHash:(NSString *)hash;
 
 - (void) contactWillDeallocate:(AWEzvContact *)contact;
 
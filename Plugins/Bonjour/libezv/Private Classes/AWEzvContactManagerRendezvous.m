@@ -39,107 +39,19 @@
 #import "AWEzvRendezvousData.h"
 #import "AWEzvSupportRoutines.h"
 
-#import <dns_sd.h>
 #include <CommonCrypto/CommonDigest.h>
 
-/* One of the stupidest things I've ever met. Doing DNS lookups using the standard
- * functions does not for mDNS records work unless you're in BIND 8 compatibility
- * mode. And of course how do you get data from say a NULL record for iChat stuff?
- * With the standard DNS functions. So we have to use BIND 8 mode. Which means we
- * have to implement our own DNS packet parser. What were people thinking here?
+/* How long TXT record changes are gathered up before the client hears about them. A contact whose status flaps
+ * within this long, e.g. to away and straight back, is reported once or not at all.
  */
-#define BIND_8_COMPAT 1
-
-#import <sys/types.h>
-#import <sys/socket.h>
-#import <netinet/in.h>
-#import <arpa/nameser.h>
-#import <arpa/inet.h>
-#import <netdb.h>
-#import <resolv.h>
-#import <errno.h>
-#import <ctype.h>
-#import <string.h>
-#import <stdlib.h>
-
-#import <SystemConfiguration/SystemConfiguration.h>
-
-// The ServiceController manages cleanup of DNSServiceRef & runloop info for an outstanding request
-@interface ServiceController : NSObject
-{
-	DNSServiceRef			fServiceRef;
-	CFSocketRef				fSocketRef;
-	CFRunLoopSourceRef		fRunloopSrc;
-	AWEzvContactManager		*contactManager;
-}
+#define STATE_CHANGE_DELAY		0.25
+
+/* How many pictures to keep for contacts who aren't showing them, e.g. because they've gone offline for a moment */
+#define UNUSED_IMAGE_CACHE_LIMIT	64
 
-- (id)initWithServiceRef:(DNSServiceRef)ref forContactManager:(AWEzvContactManager *)inContactManager;
-- (boolean_t)addToCurrentRunLoop;
-- (void)breakdownServiceController;
-- (DNSServiceRef)serviceRef;
-
-@property (readonly, nonatomic) AWEzvContactManager *contactManager;
-
-@end // Interface ServiceController
-
-// C-helper function prototypes
-void register_reply ( 
-    DNSServiceRef sdRef, 
-    DNSServiceFlags flags, 
-    DNSServiceErrorType errorCode, 
-    const char *name, 
-    const char *regtype, 
-    const char *domain, 
-    void *context
-);
-
-static void ProcessSockData (
-   CFSocketRef s,
-   CFSocketCallBackType callbackType,
-   CFDataRef address,
-   const void *data,
-   void *info
-);
-
-void handle_av_browse_reply ( 
-    DNSServiceRef sdRef, 
-    DNSServiceFlags flags, 
-    uint32_t interfaceIndex, 
-    DNSServiceErrorType errorCode, 
-    const char *serviceName, 
-    const char *regtype, 
-    const char *replyDomain, 
-    void *context
-);
-
-void resolve_reply ( 
-    DNSServiceRef sdRef, 
-    DNSServiceFlags flags, 
-    uint32_t interfaceIndex, 
-    DNSServiceErrorType errorCode, 
-    const char *fullname, 
-    const char *hosttarget, 
-    uint16_t port, 
-    uint16_t txtLen, 
-    const unsigned char *txtRecord, 
-    void *context
-);
-
-void AddressQueryRecordReply(DNSServiceRef DNSServiceRef, DNSServiceFlags flags, uint32_t interfaceIndex, 
-								DNSServiceErrorType errorCode, const char *fullname, uint16_t rrtype, uint16_t rrclass, 
-								uint16_t rdlen, const void *rdata, uint32_t ttl, void *context );
-								
-void ImageQueryRecordReply(DNSServiceRef DNSServiceRef, DNSServiceFlags flags, uint32_t interfaceIndex, 
-								DNSServiceErrorType errorCode, const char *fullname, uint16_t rrtype, uint16_t rrclass, 
-								uint16_t rdlen, const void *rdata, uint32_t ttl, void *context );	
-								
-void image_register_reply ( 
-    DNSServiceRef sdRef, 
-    DNSRecordRef RecordRef, 
-    DNSServiceFlags flags, 
-    DNSServiceErrorType errorCode, 
-    void *context
-);							
+static NSString *nicknameFromData(AWEzvRendezvousData *rendezvousData);
+static AWEzvStatus statusFromData(AWEzvRendezvousData *rendezvousData);
+static NSString *stateDescription(AWEzvContact *contact);
 
 @implementation AWEzvContactManager (Rendezvous)
 
@@ -169,38 +81,10 @@ void image_register_reply (
 	[self setStatus:[client status] withMessage:nil];
 	
     // Register service with mDNSResponder
-
-	DNSServiceRef servRef;
-	DNSServiceErrorType dnsError;
-
-	TXTRecordRef txtRecord;
-	txtRecord = [userAnnounceData dataAsTXTRecordRef];
-
-	dnsError = DNSServiceRegister(
-			/* Uninitialized service discovery reference */ &servRef, 
-		    /* Flags indicating how to handle name conflicts */ /* kDNSServiceFlagsNoAutoRename */ 0, 
-		    /* Interface on which to register, 0 for all available */ 0, 
-		    /* Service's name, may be null */ [avInstanceName UTF8String],
-		    /* Service registration type */ "_presence._tcp", 
-		    /* Domain, may be NULL */ NULL,
-		    /* SRV target host name, may be NULL */ NULL,
-		    /* Port number in network byte order */ htons(port), 
-		    /* Length of txt record in bytes, 0 for NULL txt record */ TXTRecordGetLength(&txtRecord) , 
-		    /* Txt record properly formatted, may be NULL */ TXTRecordGetBytesPtr(&txtRecord) ,
-		    /* Call back function, may be NULL */ register_reply,
-			/* Application context pointer, may be null */ self
-	);
-
-	if (dnsError == kDNSServiceErr_NoError) {		
-		fDomainBrowser = [[ServiceController alloc] initWithServiceRef:servRef forContactManager:self];
-		[fDomainBrowser addToCurrentRunLoop];
-		avDNSReference = servRef;
-	} else {
+	if (![backend registerInstanceName:avInstanceName port:port TXTRecord:[userAnnounceData dataAsTXTRecordData]]) {
 		[[client client] reportError:@"Could not register DNS service: _presence._tcp" ofLevel:AWEzvConnectionError];
 		[self disconnect];
 	}
-
-	TXTRecordDeallocate(&txtRecord);
 }
 
 // This is used for a clean logout
@@ -214,16 +98,15 @@ void image_register_reply (
 {
 	AILogWithSignature(@"isDisconnecting");
 
-	[fServiceBrowser release]; fServiceBrowser = nil;
-
-	// Remove Resolvers, this also deallocates the DNSServiceReferences
-	if (fDomainBrowser != nil) {
-		AILogWithSignature(@"Releasing %@",fDomainBrowser);
-		[fDomainBrowser release]; fDomainBrowser = nil;
+	// Stop browsing and remove our registration, which also removes our image record
+	[backend stopBrowsing];
+	[backend unregister];
 
-		avDNSReference = nil;
-		imageServiceRef = nil;
-	}
+	// Nothing still waiting to be reported matters now
+	[NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(flushContactStateChanges) object:nil];
+	[pendingStateChanges removeAllObjects];
+	[reportedStates removeAllObjects];
+	[imageFetches removeAllObjects];
 
 	[self setConnected:NO];
 }
@@ -286,35 +169,15 @@ void image_register_reply (
 // Udpates information announced over network for user
 - (void) updateAnnounceInfo
 {
-	DNSServiceErrorType updateError;
-	TXTRecordRef txtRecord;
-
 	if (!isConnected) {
 		return;
 	}
 
-	if (avDNSReference == NULL) {
-		[[client client] reportError:@"avDNSReference is null when trying to update the TXT Record" ofLevel:AWEzvWarning];
-		return;
-	}
-
-	txtRecord = [userAnnounceData dataAsTXTRecordRef];
 	AILogWithSignature(@"%@", [userAnnounceData dictionary]);
-	updateError = DNSServiceUpdateRecord (
-		/* serviceRef */ avDNSReference,
-		/* recordRef, may be NULL */ NULL,
-		/* Flags, currently ignored */ 0,
-		/* length */ TXTRecordGetLength(&txtRecord),
-		/* data */ TXTRecordGetBytesPtr(&txtRecord),
-		/* time to live */ 0
-	);
-
-	if (updateError != kDNSServiceErr_NoError) {		
+	if (![backend updateTXTRecord:[userAnnounceData dataAsTXTRecordData]]) {
 		[[client client] reportError:@"Error updating TXT Record" ofLevel:AWEzvConnectionError];
 		[self disconnect];
 	}
-	
-	TXTRecordDeallocate(&txtRecord);
 }
 
 - (void) updatedName
@@ -330,75 +193,35 @@ void image_register_reply (
 
 - (void)setImageData:(NSData *)JPEGData
 {
-	DNSServiceErrorType error;
 	unsigned char digest[CC_SHA1_DIGEST_LENGTH];
 
-	if (avDNSReference == NULL) {
+	if (![backend setImageRecord:JPEGData]) {
 		[[client client] reportError:@"Error setting image data" ofLevel:AWEzvWarning];
 		return;
 	}
 
-	if (JPEGData == nil) {
-		// No image so remove record and update txt records
-		error = DNSServiceRemoveRecord ( 
-		    /* Service reference */ avDNSReference, 
-		    /* Record reference */ imageRef, 
-		    /* Flags, ignored */ 0);
-		if (error == kDNSServiceErr_NoError) {
-			imageRef = nil;
-			[userAnnounceData deleteField:@"phsh"];
-			[self updateAnnounceInfo];
-			return;
-		}
-	}
-
-	if (imageRef != nil && JPEGData != nil) {
-		/* Remove the old reference before updating the image. 
-		 * This works around a bug experienced when updating the record to use an image that occupied more space
-		 */
-		error = DNSServiceRemoveRecord ( 
-		    /* service reference */ /*imageServiceRef*/avDNSReference, 
-		    /* record reference */ imageRef, 
-			/* flags, ignored */ 1
-		);
-
-		if (error != kDNSServiceErr_NoError) {
-			[[client client] reportError:@"Error removing old image before setting new image" ofLevel:AWEzvWarning];
-			return;
-		} else {
-			[userAnnounceData deleteField:@"phsh"];
-			imageRef = nil;
-		}
-	}
-
-	error = DNSServiceAddRecord (/* Service reference */ avDNSReference, 
-	                             /* Record reference */ &imageRef, 
-	                             /* Flags, ignored */ 0, 
-	                             /* Type */ kDNSServiceType_NULL, 
-	                             /* Length */ [JPEGData length], 
-	                             /* Data */ [JPEGData bytes], 
-	                             /* Time to live; 0 = default */ 0);
+	[imagehash release]; imagehash = nil;
 
-	if (error == kDNSServiceErr_NoError) {
+	if (JPEGData) {
 		// Let's create the hash
 		CC_SHA1([JPEGData bytes], (CC_LONG)[JPEGData length], digest);
-		imagehash = [[NSData dataWithBytes:digest length:20] retain];
+		imagehash = [[NSData alloc] initWithBytes:digest length:CC_SHA1_DIGEST_LENGTH];
         AILogWithSignature(@"Will update with hash %@; length is %lu", imagehash, (unsigned long)[JPEGData length]);
-		[self updatePHSH];
-	} else {
-		[[client client] reportError:@"Error adding image record" ofLevel:AWEzvWarning];
 	}
+
+	[self updatePHSH];
 }
 
 - (void) updatePHSH
 {
 	if (imagehash != nil) {
-		[userAnnounceData setField:@"phsh" content:[imagehash autorelease]];
-		// Announce to network
-		[self updateAnnounceInfo];
+		[userAnnounceData setField:@"phsh" content:imagehash];
 	} else {
 		[userAnnounceData deleteField:@"phsh"];
 	}
+
+	// Announce to network
+	[self updateAnnounceInfo];
 }
 
 #pragma mark Browsing Functions
@@ -406,7 +229,7 @@ void image_register_reply (
 // Start browsing the network for new rendezvous clients
 - (void) startBrowsing
 {
-	[fServiceBrowser release]; fServiceBrowser = nil;
+	[backend stopBrowsing];
 
 	// Destroy old contact dictionary if one exists
 	[contacts release];
@@ -414,22 +237,7 @@ void image_register_reply (
 	// Allocate new contact dictionary
 	contacts = [[NSMutableDictionary alloc] init];
 
-	// Create AV browser
-	DNSServiceRef browsRef;
-	DNSServiceErrorType avBrowseError;
-
-	avBrowseError = DNSServiceBrowse (/* Uninitialized DNSServiceRef */ &browsRef,
-	                                  /* Flags, currently unused */ 0,
-	                                  /* Interface index, 0 for all available */ 0,
-	                                  /* Registration type */ "_presence._tcp",
-	                                  /* Domain, may be null for default */ NULL,
-	                                  /* CallBack function */ handle_av_browse_reply,
-	                                  /* Context, may be null */ self);
-
-	if (avBrowseError == kDNSServiceErr_NoError) {
-		fServiceBrowser = [[ServiceController alloc] initWithServiceRef:browsRef forContactManager:self];
-		[fServiceBrowser addToCurrentRunLoop];
-	} else {
+	if (![backend startBrowsing]) {
 		[[client client] reportError:@"Could not browse for _presence._tcp instances" ofLevel:AWEzvConnectionError];
 		[self disconnect];
 	}
@@ -438,308 +246,261 @@ void image_register_reply (
 // Stop looking for new rendezvous clients
 - (void)stopBrowsing
 {
-    AILogWithSignature(@"fServiceBrowser is %@ (retain count %lu)", fServiceBrowser, (unsigned long)[fServiceBrowser retainCount]);
-	[fServiceBrowser release]; fServiceBrowser = nil;
+	[backend stopBrowsing];
 }
 
-// Handle a message from our browser
-- (void)browseResultwithFlags:(DNSServiceFlags)flags
-				  onInterface:(uint32_t) interfaceIndex
-						 name:(const char *)replyName
-						 type:(const char *)replyType
-					   domain:(const char *)replyDomain
-						   av:(BOOL) av
-{	
-	AWEzvContact *contact;
-	
-	if (!replyName) {
+- (void)findAddressForContact:(AWEzvContact *)contact
+					 withHost:(NSString *)host
+				withInterface:(uint32_t)interface
+{
+	// Now we need to query the record for the ip address
+	[contact setAddressServiceController:[backend queryAddressForHost:host interface:interface instance:contact.uniqueID]];
+
+	if (![contact addressServiceController]) {
+		[[client client] reportError:@"Error finding adress for contact" ofLevel:AWEzvError];
+	}
+}
+
+/*!
+ * @brief Apply a contact's new TXT record
+ *
+ * Only the fields which differ from the contact's previous record are looked at, and the client is only told about
+ * the contact if one of the fields it shows changed.
+ */
+- (void)updateContact:(AWEzvContact *)contact
+			 withData:(AWEzvRendezvousData *)rendezvousData
+			 withHost:(NSString *)host
+		withInterface:(uint32_t)interface
+			 withPort:(uint16_t)recPort
+{
+	NSSet	*changedFields;
+	BOOL	stateChanged = NO;
+
+	if ([rendezvousData getField:@"slumming"] != nil) {
+		// We don't want to live in a slum
 		return;
 	}
 
-	NSString *replyNameString = [NSString stringWithUTF8String:replyName];
+	// nil if this is the contact's first record, in which case every field is new
+	changedFields = ([contact rendezvous] ? [rendezvousData fieldsChangedSince:[contact rendezvous]] : nil);
+	[contact setRendezvous:rendezvousData];
+
+	// The status message is read straight from the rendezvous data
+	if (!changedFields || [changedFields containsObject:@"msg"]) {
+		stateChanged = YES;
+	}
+
+	// Get the nickname
+	if (!changedFields || [changedFields containsObject:@"1st"] || [changedFields containsObject:@"last"]) {
+		[contact setName:nicknameFromData(rendezvousData)];
+		stateChanged = YES;
+	}
+
+	// Now get the status
+	if (!changedFields || [changedFields containsObject:@"status"]) {
+		[contact setStatus:statusFromData(rendezvousData)];
+		stateChanged = YES;
+	}
 	
-	if (!replyNameString) {
-		return;
+	// Set idle time
+	if (!changedFields || [changedFields containsObject:@"away"]) {
+		NSString *away = [rendezvousData getField:@"away"];
+		[contact setIdleSinceDate:(away ? [NSDate dateWithTimeIntervalSinceReferenceDate:strtol([away UTF8String], NULL, 0)] : nil)];
+		stateChanged = YES;
 	}
 	
-	if (flags == (kDNSServiceFlagsAdd) || flags == (kDNSServiceFlagsMoreComing | kDNSServiceFlagsAdd)) {
-		// Add this contact
-		// Initialise contact
-		contact = [[AWEzvContact alloc] init];
-		contact.uniqueID = replyNameString;
-		contact.manager = self;
-		// Save contact in dictionary
-		[contacts setObject:contact forKey:replyNameString];
-		[contact autorelease];
-
-		// Resolve contact
-		DNSServiceRef resolveRef;
-		DNSServiceErrorType resolveRefError;
-
-		resolveRefError = DNSServiceResolve (
-			/* Serviceref uninitialized */ &resolveRef,
-			/* Flags, currently ignored */ 0,
-			/* InterfaceIndex */ 0,
-			/* Full name */ replyName,
-			/* Registration type */ "_presence._tcp" /* replyType */,
-			/* Domain */ replyDomain,
-			/* Callback */ resolve_reply,
-			/* Contxt, may be NULL */ contact
-		);
-
-		if (resolveRefError == kDNSServiceErr_NoError) {
-			ServiceController *serviceResolver = [[ServiceController alloc] initWithServiceRef:resolveRef forContactManager:self];
-			[contact setResolveServiceController:serviceResolver];
-			[[contact resolveServiceController] addToCurrentRunLoop];
-			[serviceResolver release];
+	// Update Buddy Icon
+	if (!changedFields || [changedFields containsObject:@"phsh"]) {
+		[self updateImageHash:[rendezvousData getField:@"phsh"] forContact:contact interface:interface];
+	}
 
-		} else {
-			[[client client] reportError:@"Could not search for TXT records" ofLevel:AWEzvConnectionError];
-			[self disconnect];
-		}
-	} else {
-		// Delete the contact
-		contact = [contacts objectForKey:replyNameString];
-		
-		if (!contact) {
+	// Now set the port
+	if (recPort == 0) {
+		// Couldn't find port from browse result so use port specified by txt records
+		if ([rendezvousData getField:@"port.p2pj"] == nil) {
+			[[client client] reportError:@"Invalid rendezvous announcement for contact: no port specified" ofLevel:AWEzvError];
 			return;
 		}
-		
-		[[client client] userLoggedOut:contact];
-		// Remove the contact from our data structures
-		[contacts removeObjectForKey:replyNameString];
-		return;
+		[contact setPort:[[rendezvousData getField:@"port.p2pj"] intValue]];
+	} else {
+		// Correctly use port specified by SRV record
+		[contact setPort:recPort];
+	}
+
+	if (stateChanged) {
+		[self noteStateChangeForContact:contact];
 	}
 }
-- (void)findAddressForContact:(AWEzvContact *)contact
-					 withHost:(NSString *)host
-				withInterface:(uint32_t)interface
-{
-	// Now we need to query the record for the ip address
 
-	DNSServiceErrorType err;
-	DNSServiceRef		serviceRef;
+#pragma mark State Changes
 
-	err = DNSServiceQueryRecord( &serviceRef, (DNSServiceFlags) 0, interface, [host UTF8String], 
-	                             kDNSServiceType_A, kDNSServiceClass_IN, AddressQueryRecordReply, contact);
-	
-	if (err == kDNSServiceErr_NoError) {
-		ServiceController *temp = [[ServiceController alloc] initWithServiceRef:serviceRef forContactManager:self];
-		[contact setAddressServiceController:temp];
-		[[contact addressServiceController] addToCurrentRunLoop];
-		[temp release];
-	} else {
-		[[client client] reportError:@"Error finding adress for contact" ofLevel:AWEzvError];
+- (void)noteStateChangeForContact:(AWEzvContact *)contact
+{
+	if (![pendingStateChanges count]) {
+		[self performSelector:@selector(flushContactStateChanges) withObject:nil afterDelay:STATE_CHANGE_DELAY];
 	}
+
+	[pendingStateChanges addObject:contact];
 }
 
-- (void)updateAddressForContact:(AWEzvContact *)contact
-						   addr:(const void *)buff
-						addrLen:(uint16_t)addrLen
-						   host:(const char*) host
-				 interfaceIndex:(uint32_t)interface
-						   more:(boolean_t)moreToCome
+- (void)flushContactStateChanges
 {
-	// Check that contact exists in dictionary
-	if ([contacts objectForKey:contact.uniqueID] == nil) {
-		NSString *uniqueID = contact.uniqueID;
-		// So they haven't been seen before... not to worry we'll add them
-		if (contact.uniqueID != nil) {
-			contact = [[AWEzvContact alloc] init];
-			contact.uniqueID = uniqueID;
-			contact.manager = self;
-			// Save contact in dictionary
-			[contacts setObject:contact forKey:contact.uniqueID];
-			[contact autorelease];
+	[NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(flushContactStateChanges) object:nil];
 
-		} else {
-			[[client client] reportError:@"Contact to update not in dictionary and has bad identifier" ofLevel:AWEzvError];
+	NSArray *changedContacts = [pendingStateChanges allObjects];
+	[pendingStateChanges removeAllObjects];
+
+	for (AWEzvContact *contact in changedContacts) {
+		// A contact who went away and came back since the client last heard hasn't changed as far as it's concerned
+		NSString *state = stateDescription(contact);
+
+		if (![state isEqualToString:[reportedStates objectForKey:contact.uniqueID]]) {
+			[reportedStates setObject:state forKey:contact.uniqueID];
+			// Notify of new user
+			[[client client] userChangedState:contact];
 		}
 	}
+}
 
-	NSString *ipAddr;	// IP address of contact
-	NSRange	range;		// Just a range...
-    
-	char addrBuff[256];
-	
-	inet_ntop( AF_INET, buff, addrBuff, sizeof addrBuff);
+- (void)forgetContact:(AWEzvContact *)contact
+{
+	[self abandonImageFetchForContact:contact];
+	[pendingStateChanges removeObject:contact];
+	[reportedStates removeObjectForKey:contact.uniqueID];
+}
 
-	ipAddr = [NSString stringWithCString:addrBuff encoding:NSUTF8StringEncoding];
-	range = [ipAddr rangeOfCharacterFromSet:[NSCharacterSet characterSetWithCharactersInString:@":"]];
-	
-	if (range.location == NSNotFound) {
-		contact.ipAddr = ipAddr;
-	}
+#pragma mark Pictures
 
-	if (!contact.ipAddr || !contact.ipAddr.length) {
-		[[client client] reportError:@"ip address not set" ofLevel:AWEzvError];
-		[contact setStatus: AWEzvUndefined];
+/*!
+ * @brief A contact's phsh changed
+ *
+ * Pictures are fetched once per hash: one already fetched is taken from the cache, and a contact with the same hash
+ * as a picture being fetched for someone else waits for that one.
+ */
+- (void)updateImageHash:(NSString *)newHash forContact:(AWEzvContact *)contact interface:(uint32_t)interface
+{
+	if (!newHash) {
+		[self abandonImageFetchForContact:contact];
+		[contact setImageHash:nil];
+		[contact setContactImageData:nil];
+		[[client client] userChangedImage:contact];
+		return;
 	}
 
-	if (!moreToCome) {
-		[contact setAddressServiceController: nil];
+	AILogWithSignature(@"received image hash %@ for %@", newHash, contact);
+
+	if ([newHash isEqualToString:[contact imageHash]]) {
+		return;
 	}
-}
 
-- (void)updateImageForContact:(AWEzvContact *)contact
-						 data:(const void *)data
-					  dataLen:(uint16_t)dataLen
-						 more:(boolean_t)moreToCome
-{
-	if (!moreToCome) {
-		[contact setImageServiceController: nil];
+	[self abandonImageFetchForContact:contact];
+	[contact setImageHash:newHash];
+
+	NSData *cachedImageData = [imageCache objectForKey:newHash];
+	if (cachedImageData) {
+		[contact setContactImageData:cachedImageData];
+		[[client client] userChangedImage:contact];
+		return;
 	}
-	
-	AILogWithSignature(@"%@ -> %@ (%i)", [NSData dataWithBytes:data length:dataLen], [[[NSImage alloc] initWithData:[NSData dataWithBytes:data length:dataLen]] autorelease], dataLen);
-	
-	if (dataLen != 0 ) {
-		// We have an image
-		// Parse raw Data
-		[contact setContactImageData:[NSData dataWithBytes:data length:dataLen]];
-	    [[client client] userChangedImage:contact];
 
+	NSMutableArray *waitingContacts = [imageFetches objectForKey:newHash];
+	if (waitingContacts) {
+		[waitingContacts addObject:contact];
 	} else {
-		[contact setImageHash: NULL];
-		[[client client] reportError:@"Error retrieving picture" ofLevel:AWEzvError];
+		[self fetchImageWithHash:newHash forContacts:[NSArray arrayWithObject:contact] interface:interface];
 	}
 }
 
-- (void)updateContact:(AWEzvContact *)contact
-			 withData:(AWEzvRendezvousData *)rendezvousData
-			 withHost:(NSString *)host
-		withInterface:(uint32_t)interface
-			 withPort:(uint16_t)recPort
-				   av:(BOOL)av
+/*!
+ * @brief Fetch the picture with hash from the first of waitingContacts, on behalf of all of them
+ */
+- (BOOL)fetchImageWithHash:(NSString *)hash forContacts:(NSArray *)waitingContacts interface:(uint32_t)interface
 {
-	NSString		*nick = nil;			// Nickname for contact
-	NSMutableString	*mutableNick = nil;		// Nickname we can modify
-	AWEzvRendezvousData	*oldrendezvous;		// XXX not used - Old rendezvous data for user
-	NSNumber           *idleTime = nil;		// Idle time
-
-	// Check that contact exists in dictionary
-	if ([contacts objectForKey:contact.uniqueID] == nil) {
-		NSString *uniqueID = contact.uniqueID;
-		// So they haven't been seen before... not to worry we'll add them
-		if (contact.uniqueID != nil) {
-			contact = [[AWEzvContact alloc] init];
-			contact.uniqueID = uniqueID;
-			contact.manager = self;
-			// Save contact in dictionary
-			[contacts setObject:contact forKey:contact.uniqueID];
-			[contact autorelease];
-		} else {
-			[[client client] reportError:@"Contact to update not in dictionary and has bad identifier" ofLevel:AWEzvError];
+	AWEzvContact	*fetchingContact = [waitingContacts objectAtIndex:0];
+	id				query = [backend queryImageForInstance:fetchingContact.uniqueID interface:interface];
+
+	if (!query) {
+		for (AWEzvContact *contact in waitingContacts) {
+			[contact setImageHash:nil];
 		}
+		[[client client] reportError:@"Error finding image for contact" ofLevel:AWEzvError];
+		return NO;
 	}
 
-	if ([rendezvousData getField:@"slumming"] != nil) {
-		// We don't want to live in a slum
+	AILogWithSignature(@"requesting image with %@", query);
+	[fetchingContact setImageServiceController:query];
+	[imageFetches setObject:[[waitingContacts mutableCopy] autorelease] forKey:hash];
+
+	return YES;
+}
+
+/*!
+ * @brief Stop waiting for the picture contact's imageHash refers to
+ *
+ * If contact was the one fetching it, the fetch is handed on to the next contact waiting for it.
+ */
+- (void)abandonImageFetchForContact:(AWEzvContact *)contact
+{
+	NSString		*hash = [[[contact imageHash] retain] autorelease];
+	NSMutableArray	*waitingContacts = (hash ? [[[imageFetches objectForKey:hash] retain] autorelease] : nil);
+	NSUInteger		index = (waitingContacts ? [waitingContacts indexOfObjectIdenticalTo:contact] : NSNotFound);
+
+	if (index == NSNotFound) {
 		return;
 	}
 
-	if ([contact rendezvous] != nil) {
-		oldrendezvous = [contact rendezvous];
-		// Check serials
-		if ([contact serial] > [contact serial]) {
-			// AWEzvLog(@"Rendezvous update for %@ with lower serial, updating anyway", contact.uniqueID);
-			// We'll update anyway, and hopefully we'll be back in sync with the network
+	[waitingContacts removeObjectAtIndex:index];
+
+	if (index == 0) {
+		[contact setImageServiceController:nil];
+		[imageFetches removeObjectForKey:hash];
+
+		if ([waitingContacts count]) {
+			[self fetchImageWithHash:hash forContacts:waitingContacts interface:0];
 		}
 	}
+}
 
-	[contact setRendezvous:rendezvousData];
-	
-	// Now we can update the contact
-	// Get the nickname
-	if ([rendezvousData getField:@"1st"] != nil) {
-		nick = [rendezvousData getField:@"1st"];
+/*!
+ * @brief Keep imageData for anyone else with hash, if it's really the picture with that hash
+ *
+ * @result YES if imageData matched hash and was cached
+ */
+- (BOOL)cacheImageData:(NSData *)imageData withHash:(NSString *)hash
+{
+	unsigned char	digest[CC_SHA1_DIGEST_LENGTH];
+	NSMutableString	*digestString = [NSMutableString stringWithCapacity:CC_SHA1_DIGEST_LENGTH * 2];
+	int				i;
+
+	CC_SHA1([imageData bytes], (CC_LONG)[imageData length], digest);
+	for (i = 0; i < CC_SHA1_DIGEST_LENGTH; i++) {
+		[digestString appendFormat:@"%02x", digest[i]];
 	}
-	
-	if ([rendezvousData getField:@"last"] != nil) {
-		if (nick == nil) {
-			nick = [rendezvousData getField:@"last"];
-		} else {
-			mutableNick = [[nick mutableCopy] autorelease];
-			[mutableNick appendString:@" "];
-			[mutableNick appendString:[rendezvousData getField:@"last"]];
-			nick = [[mutableNick copy] autorelease];
-		}
-	} else if (nick == nil) {
-	    nick = @"Unnamed contact";
+
+	// Otherwise one contact could show its picture for everyone else using the hash it claims
+	if (!hash || [digestString caseInsensitiveCompare:hash] != NSOrderedSame) {
+		return NO;
 	}
 
-	[contact setName:nick];
+	/* Pictures contacts are showing cost nothing extra, since they share the cached data; once there are too many
+	 * nobody is showing, forget those.
+	 */
+	if ([imageCache count] >= [contacts count] + UNUSED_IMAGE_CACHE_LIMIT) {
+		NSMutableSet *hashesInUse = [NSMutableSet set];
 
-	// Now get the status
-	if ([rendezvousData getField:@"status"] == nil) {
-		[contact setStatus: AWEzvOnline];
-	} else {
-		if ([[rendezvousData getField:@"status"] isEqualToString:@"avail"]) {
-			[contact setStatus: AWEzvOnline];
-		} else if ([[rendezvousData getField:@"status"] isEqualToString:@"dnd"]) {
-			[contact setStatus: AWEzvAway];
-		} else if ([[rendezvousData getField:@"status"] isEqualToString:@"away"]) {
-			[contact setStatus: AWEzvIdle];
-		} else {
-			[contact setStatus: AWEzvOnline];
+		for (AWEzvContact *contact in [contacts objectEnumerator]) {
+			if ([contact imageHash])
+				[hashesInUse addObject:[contact imageHash]];
 		}
-	}
-	
-	// Set idle time
-	if ([rendezvousData getField:@"away"]) {
-		idleTime = [NSNumber numberWithLong:strtol([[rendezvousData getField:@"away"] UTF8String], NULL, 0)];
-	}
-	
-	if (idleTime) {
-		[contact setIdleSinceDate: [NSDate dateWithTimeIntervalSinceReferenceDate:[idleTime doubleValue]]];
-	}
-	
-	// Update Buddy Icon
-	if ([rendezvousData getField:@"phsh"] != nil) {
-		// We should check to see if this is a new phsh
-		NSString *hash = [contact imageHash];
-		NSString *newHash = [rendezvousData getField:@"phsh"];
-		AILogWithSignature(@"received image hash %@ for %@", newHash, contact);
-
-		if (hash == NULL || [newHash compare: hash] != NSOrderedSame) {
-			[contact setImageHash: newHash];	
-			// The two hashes are different or there was no image before so there is an image to be downloaded
-			// Download the image using DNSServiceQueryRecord
-			DNSServiceErrorType err;
-			DNSServiceRef		serviceRef;
-
-			NSString *dnsname = [NSString stringWithFormat:@"%@%s", contact.uniqueID,"._presence._tcp.local."];
-			err = DNSServiceQueryRecord( &serviceRef, (DNSServiceFlags) 0, interface, [dnsname UTF8String], 
-			                            kDNSServiceType_NULL, kDNSServiceClass_IN, ImageQueryRecordReply, contact);
-			if ( err == kDNSServiceErr_NoError) {
-				ServiceController *temp = [[ServiceController alloc] initWithServiceRef:serviceRef forContactManager:self];
-				AILogWithSignature(@"requesting image with %@", temp);
-				[contact setImageServiceController:temp];
-				[[contact imageServiceController] addToCurrentRunLoop];
-				[temp release];
-			} else {
-				[contact setImageHash: NULL];
-				[[client client] reportError:@"Error finding image for contact" ofLevel:AWEzvError];
-			}
+		for (NSString *cachedHash in [imageCache allKeys]) {
+			if (![hashesInUse containsObject:cachedHash])
+				[imageCache removeObjectForKey:cachedHash];
 		}
-	} else {
-		[contact setContactImageData:nil];
-		[[client client] userChangedImage:contact];
 	}
 
-	// Now set the port
-	if (recPort == 0) {
-		// Couldn't find port from browse result so use port specified by txt records
-		if ([rendezvousData getField:@"port.p2pj"] == nil) {
-			[[client client] reportError:@"Invalid rendezvous announcement for contact: no port specified" ofLevel:AWEzvError];
-			return;
-		}
-		[contact setPort:[[rendezvousData getField:@"port.p2pj"] intValue]];
-	} else {
-		// Correctly use port specified by SRV record
-		[contact setPort:recPort];
-	}
-	// Notify of new user
-	[[client client] userChangedState:contact];
+	[imageCache setObject:imageData forKey:hash];
+
+	return YES;
 }
 
 - (NSString *)myInstanceName
@@ -755,24 +516,34 @@ void image_register_reply (
 	}
 }
 
-- (void) regCallBack:(int)errorCode
+- (void)contactWillDeallocate:(AWEzvContact *)contact
 {
+	[[client client] userLoggedOut:contact];
+}
+
+#pragma mark Discovery Backend Delegate
+
+- (void)discoveryBackend:(id <AWEzvDiscoveryBackend>)inBackend didRegisterInstanceName:(NSString *)instanceName error:(AWEzvDiscoveryError)error
+{
+	if (instanceName) {
+		[self setInstanceName:instanceName];
+	}
+
 	// Recover if there was an error
-    if (errorCode != kDNSServiceErr_NoError) {
-		switch (errorCode) {
+    if (error != AWEzvDiscoveryNoError) {
+		switch (error) {
 #warning Localize and report through the connection error system
-			case kDNSServiceErr_Unknown:
+			case AWEzvDiscoveryUnknownError:
 				[[[self client] client] reportError:@"Unknown error in Bonjour Registration"
 						        ofLevel:AWEzvConnectionError];
 				break;
-			case kDNSServiceErr_NameConflict:
+			case AWEzvDiscoveryNameConflict:
 				[[[self client] client] reportError:@"A user with your Bonjour data is already online"
 						        ofLevel:AWEzvConnectionError];
 				break;
 			default:
 				[[[self client] client] reportError:@"An internal error occurred"
 						        ofLevel:AWEzvConnectionError];
-				AWEzvLog(@"Internal error: rendezvous code %d", errorCode);
 				break;
 		}
 		// Kill connections
@@ -783,278 +554,208 @@ void image_register_reply (
 	}
 }
 
-- (void)contactWillDeallocate:(AWEzvContact *)contact
+- (void)discoveryBackend:(id <AWEzvDiscoveryBackend>)inBackend didFindInstance:(NSString *)instanceName domain:(NSString *)domain
 {
-	[[client client] userLoggedOut:contact];
-}
-
-- (void)serviceControllerReceivedFatalError:(ServiceController *)serviceController
-{
-	[[[self client] client] reportError:@"An unrecoverable connection error occurred"
-						        ofLevel:AWEzvConnectionError];
-	[self disconnect];
-}
+	if ([instanceName isEqualToString:[self myInstanceName]]) {
+		return;
+	}
 
-@end
+	// The instance may be seen on more than one interface; its resolve is already running
+	if ([contacts objectForKey:instanceName]) {
+		return;
+	}
 
-#pragma mark mDNS Callbacks
-#pragma mark mDNS Register Callbacks
+	// Add this contact
+	AWEzvContact *contact = [[AWEzvContact alloc] init];
+	contact.uniqueID = instanceName;
+	contact.manager = self;
+	// Save contact in dictionary
+	[contacts setObject:contact forKey:instanceName];
+	[contact release];
 
-void register_reply(DNSServiceRef sdRef, DNSServiceFlags flags, DNSServiceErrorType errorCode, const char *name, const char *regtype, const char *domain, void *context)
-{
-	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
-	
-	AWEzvContactManager *self = context;
-	[self setInstanceName:[NSString stringWithUTF8String:name]];
-	[self regCallBack:errorCode];
-	
-	[pool release];
-}
+	// Resolve contact
+	[contact setResolveServiceController:[backend resolveInstance:instanceName domain:domain]];
 
-void image_register_reply( 
-	DNSServiceRef sdRef, 
-	DNSRecordRef RecordRef, 
-	DNSServiceFlags flags, 
-	DNSServiceErrorType errorCode, 
-	void *context)
-{
-	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
-	
-	if (errorCode != kDNSServiceErr_NoError) {
-		AWEzvLog(@"error %d registering image record", errorCode);
-	} else {
-		AWEzvContactManager *self = context;
-		[self updatePHSH];
+	if (![contact resolveServiceController]) {
+		[[client client] reportError:@"Could not search for TXT records" ofLevel:AWEzvConnectionError];
+		[self disconnect];
 	}
-	
-	[pool release];
 }
 
-#pragma mark mDNS Browse Callback
-
-/*!
- * @brief DNSServiceBrowse callback
- *
- * This may be called multiple times for a single use of DNSServiceBrowse().
- */
-void handle_av_browse_reply(DNSServiceRef sdRef,
-							DNSServiceFlags flags,
-							uint32_t interfaceIndex,
-							DNSServiceErrorType errorCode,
-							const char *serviceName,
-							const char *regtype,
-							const char *replyDomain,
-							void *context)
+- (void)discoveryBackend:(id <AWEzvDiscoveryBackend>)inBackend didLoseInstance:(NSString *)instanceName
 {
-	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
-	
-	// Received a browser reply from DNSServiceBrowse for av, now must handle processing the list of results
-	if (errorCode == kDNSServiceErr_NoError) {
-		AWEzvContactManager *self = context;
-	    if (![[self myInstanceName] isEqualToString:[NSString stringWithUTF8String:serviceName]]) {
-			[self browseResultwithFlags:flags onInterface:interfaceIndex name:serviceName type:regtype domain:replyDomain av:YES];
-		}
-	} else {
-		AWEzvLog(@"Error browsing");
+	// Delete the contact
+	AWEzvContact *contact = [contacts objectForKey:instanceName];
+
+	if (!contact) {
+		return;
 	}
-	
-	[pool release];
-}
 
-#pragma mark mDNS Resolve Callback
+	[self forgetContact:contact];
+	[[client client] userLoggedOut:contact];
+	// Remove the contact from our data structures
+	[contacts removeObjectForKey:instanceName];
+}
 
 /*!
-* @brief DNSServiceResolve callback
+ * @brief A contact was resolved, or its TXT record changed
  *
- * This may be called multiple times for a single use of DNSServiceResolve().
+ * Results for instances we've lost are dropped; their queries stop once their contacts are released, and the
+ * contact is resolved afresh if the instance comes back.
  */
-void resolve_reply( DNSServiceRef sdRef, 
-					DNSServiceFlags flags, 
-					uint32_t interfaceIndex, 
-					DNSServiceErrorType errorCode, 
-					const char *fullname, 
-					const char *hosttarget, 
-					uint16_t port, 
-					uint16_t txtLen, 
-					const unsigned char *txtRecord, 
-					void *context)
+- (void)discoveryBackend:(id <AWEzvDiscoveryBackend>)inBackend
+	  didResolveInstance:(NSString *)instanceName
+					host:(NSString *)host
+			   interface:(uint32_t)interfaceIndex
+					port:(uint16_t)recPort
+			   TXTRecord:(NSData *)TXTRecord
 {
-	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
-	
-	if (errorCode == kDNSServiceErr_NoError) {
-		// Use TXTRecord methods to resolve this
-		AWEzvContact	*contact = context;
-		AWEzvContactManager *self = [contact manager];
-		// AWEzvLog(@"Would update contact");
-		AWEzvRendezvousData *data;
-		data = [[[AWEzvRendezvousData alloc] initWithTXTRecordRef:txtRecord length:txtLen] autorelease];
-		[self findAddressForContact:contact withHost:[NSString stringWithUTF8String:hosttarget] withInterface:interfaceIndex];
-		[self updateContact:contact withData:data withHost:[NSString stringWithUTF8String:hosttarget] withInterface:interfaceIndex withPort:ntohs(port) av:YES];
-	} else {
-		AWEzvLog(@"Error resolving records");
-	}
-	
-	[pool release];
-}
+	AWEzvContact *contact = [contacts objectForKey:instanceName];
 
-#pragma mark mDNS Address Callback
+	if (!contact) {
+		return;
+	}
 
-void AddressQueryRecordReply(DNSServiceRef serviceRef, DNSServiceFlags flags, uint32_t interfaceIndex, 
-							DNSServiceErrorType errorCode, const char *fullname, uint16_t rrtype, uint16_t rrclass, 
-							uint16_t rdlen, const void *rdata, uint32_t ttl, void *context )
-// DNSServiceQueryRecord callback used to look up IP addresses.
-{
-	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
-	
-	AWEzvContact	*contact = context;
-	AWEzvContactManager *self = [contact manager];
+	// Look up the address if the host is new, or the last lookup finished without one
+	if (![host isEqualToString:[contact hostName]] || (![contact ipAddr] && ![contact addressServiceController])) {
+		[contact setHostName:host];
+		[self findAddressForContact:contact withHost:host withInterface:interfaceIndex];
+	}
 
-	[self updateAddressForContact:contact addr:rdata addrLen:rdlen host:fullname interfaceIndex:interfaceIndex
-							 more:((flags & kDNSServiceFlagsMoreComing) != 0)];
+	// An identical record is just the responder refreshing it
+	if ([TXTRecord isEqualToData:[contact TXTRecord]] && (recPort == 0 || recPort == [contact port])) {
+		return;
+	}
 
-	[pool release];
+	[contact setTXTRecord:TXTRecord];
+	[self updateContact:contact
+			   withData:[[[AWEzvRendezvousData alloc] initWithTXTRecordData:TXTRecord] autorelease]
+			   withHost:host
+		  withInterface:interfaceIndex
+			   withPort:recPort];
 }
 
-#pragma mark mDNS Image Callback
-
-void ImageQueryRecordReply(DNSServiceRef serviceRef, DNSServiceFlags flags, uint32_t interfaceIndex, 
-							DNSServiceErrorType errorCode, const char *fullname, uint16_t rrtype, uint16_t rrclass, 
-							uint16_t rdlen, const void *rdata, uint32_t ttl, void *context)
-// DNSServiceQueryRecord callback used to look up buddy icon.
+- (void)discoveryBackend:(id <AWEzvDiscoveryBackend>)inBackend
+		  didFindAddress:(NSString *)ipAddr
+			 forInstance:(NSString *)instanceName
+			  moreComing:(BOOL)moreComing
 {
-	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
-	
-	AWEzvContact	*contact = context;
-	AWEzvContactManager *self = [contact manager];
-	if (errorCode == kDNSServiceErr_NoError) {
-		if (flags & kDNSServiceFlagsAdd) {
-			[self updateImageForContact:contact data:rdata dataLen:rdlen more:((flags & kDNSServiceFlagsMoreComing) != 0)];
-		}
-	}
-	
-	[pool release];
-}
-
-#pragma mark Service Controller
+	AWEzvContact *contact = [contacts objectForKey:instanceName];
 
-// ServiceController was taken from Apple's DNSServiceBrowser.m
-@implementation ServiceController : NSObject
+	if (!contact) {
+		return;
+	}
 
-#pragma mark CFSocket Callback
+	if (ipAddr && [ipAddr rangeOfString:@":"].location == NSNotFound) {
+		contact.ipAddr = ipAddr;
+	}
 
-// This code was taken from Apple's DNSServiceBrowser.m
-static void	ProcessSockData( CFSocketRef s, CFSocketCallBackType type, CFDataRef address, const void *data, void *info)
-// CFRunloop callback that notifies dns_sd when new data appears on a DNSServiceRef's socket.
-{
-	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
-	
-	ServiceController *self = (ServiceController *)info;
-	AILogWithSignature(@"Processing result for %@", self);
+	if (!contact.ipAddr || !contact.ipAddr.length) {
+		[[client client] reportError:@"ip address not set" ofLevel:AWEzvError];
+		[contact setStatus: AWEzvUndefined];
 
-	DNSServiceErrorType err = DNSServiceProcessResult([self serviceRef]);
-	
-	if (err != kDNSServiceErr_NoError) {
-		if ((err == kDNSServiceErr_Unknown) && !data) {
-			// Try to accept(2) a connection. May be the cause of a hang on Tiger; see #7887.
-			int socketFD = CFSocketGetNative(s);
-			int childFD = accept(socketFD, /*addr*/ NULL, /*addrlen*/ NULL);
-			AILog(@"%@: Service ref %p received an unknown error with no data; perhaps mDNSResponder crashed? Result of calling accept(2) on fd %d is %d; will disconnect with error",
-				  self, [self serviceRef], socketFD, childFD);
-			// We don't actually *want* a connection, so close the socket immediately.
-			if (childFD > -1) {
-				close(childFD);
-			}
-
-			[self retain];
-			[[self contactManager] serviceControllerReceivedFatalError:self];
-			[self breakdownServiceController];
-			[self release];
+	} else if ([contact status] == AWEzvUndefined && [contact rendezvous]) {
+		// An earlier lookup failed; the status in the contact's record stands again
+		[contact setStatus:statusFromData([contact rendezvous])];
+		[self noteStateChangeForContact:contact];
+	}
 
-		} else {
-            AILog(@"DNSServiceProcessResult() for socket descriptor %d returned an error! %d with CFSocketCallBackType %lu and data %s\n",
-			DNSServiceRefSockFD(info), err, type, data);
-		}
+	if (!moreComing) {
+		[contact setAddressServiceController: nil];
 	}
-	
-	[pool release];
 }
 
-- (id) initWithServiceRef:(DNSServiceRef) ref forContactManager:(AWEzvContactManager *)inContactManager
+- (void)discoveryBackend:(id <AWEzvDiscoveryBackend>)inBackend
+	   didFetchImageData:(NSData *)imageData
+			 forInstance:(NSString *)instanceName
+			  moreComing:(BOOL)moreComing
 {
-	if ((self = [super init])) {
-		fServiceRef = ref;
-		contactManager = [inContactManager retain];
+	AWEzvContact	*contact = [[[contacts objectForKey:instanceName] retain] autorelease];
+	NSString		*hash = [[[contact imageHash] retain] autorelease];
+	NSMutableArray	*waitingContacts;
+
+	if (!contact) {
+		return;
 	}
 
-	return self;
-}
+	if (!moreComing) {
+		[contact setImageServiceController: nil];
+	}
 
-- (boolean_t) addToCurrentRunLoop
-// Add the service to the current runloop. Returns non-zero on success.
-{
-	CFSocketContext	ctx = { 1, self, NULL, NULL, NULL };
+	AILogWithSignature(@"%@ -> %@ (%lu)", contact, hash, (unsigned long)[imageData length]);
 
-	fSocketRef = CFSocketCreateWithNative(kCFAllocatorDefault, DNSServiceRefSockFD(fServiceRef),
-										kCFSocketReadCallBack, ProcessSockData, &ctx);
-	if (fSocketRef != NULL) {
-		fRunloopSrc = CFSocketCreateRunLoopSource(kCFAllocatorDefault, fSocketRef, 1);
-	}
-	
-	if (fRunloopSrc != NULL) {
-		AILogWithSignature(@"Adding run loop source %p from run loop %p", fRunloopSrc, CFRunLoopGetCurrent());
-		CFRunLoopAddSource(CFRunLoopGetCurrent(), fRunloopSrc, kCFRunLoopDefaultMode);
+	waitingContacts = (hash ? [[[imageFetches objectForKey:hash] retain] autorelease] : nil);
+	if (!waitingContacts || [waitingContacts objectAtIndex:0] != contact) {
+		waitingContacts = [NSMutableArray arrayWithObject:contact];
 	} else {
-		AILog(@"%@: Could not listen to runloop socket", self);
+		[imageFetches removeObjectForKey:hash];
 	}
 
-	return (fRunloopSrc != NULL);
-}
+	if ([imageData length] == 0) {
+		for (AWEzvContact *waitingContact in waitingContacts) {
+			[waitingContact setImageHash:NULL];
+		}
+		[[client client] reportError:@"Error retrieving picture" ofLevel:AWEzvError];
+		return;
+	}
 
-- (DNSServiceRef) serviceRef
-{
-	return fServiceRef;
-}
+	if (![self cacheImageData:imageData withHash:hash] && [waitingContacts count] > 1) {
+		// The picture isn't the one the hash says; the others have to fetch their own
+		[waitingContacts removeObjectAtIndex:0];
+		[self fetchImageWithHash:hash forContacts:waitingContacts interface:0];
+		waitingContacts = [NSMutableArray arrayWithObject:contact];
+	}
 
-- (AWEzvContactManager *)contactManager
-{
-	return contactManager;
+	for (AWEzvContact *waitingContact in waitingContacts) {
+		[waitingContact setContactImageData:imageData];
+	    [[client client] userChangedImage:waitingContact];
+	}
 }
 
-- (void) dealloc
-// Remove service from runloop, deallocate service and associated resources
+- (void)discoveryBackendDidFail:(id <AWEzvDiscoveryBackend>)inBackend
 {
-	AILogWithSignature(@"%@", self);
+	[[[self client] client] reportError:@"An unrecoverable connection error occurred"
+						        ofLevel:AWEzvConnectionError];
+	[self disconnect];
+}
 
-	[self breakdownServiceController];
+@end
 
-	[super dealloc];
-}
+#pragma mark Rendezvous Data
 
-- (void)breakdownServiceController
+static NSString *nicknameFromData(AWEzvRendezvousData *rendezvousData)
 {
-	AILogWithSignature(@"%@", self);
+	NSString *nick = [rendezvousData getField:@"1st"];
+	NSString *last = [rendezvousData getField:@"last"];
 
-	if (fSocketRef != NULL) {
-		CFSocketInvalidate(fSocketRef);	// Note: Also closes the underlying socket
-		CFRelease(fSocketRef);
-		fSocketRef = NULL;
+	if (last != nil) {
+		nick = (nick ? [NSString stringWithFormat:@"%@ %@", nick, last] : last);
+	} else if (nick == nil) {
+	    nick = @"Unnamed contact";
 	}
 
-	if (fRunloopSrc != NULL) {
-		AILogWithSignature(@"Removing run loop source %p from run loop %p", fRunloopSrc, CFRunLoopGetCurrent());
-		CFRunLoopRemoveSource(CFRunLoopGetCurrent(), fRunloopSrc, kCFRunLoopDefaultMode);
-		CFRelease(fRunloopSrc);
-		fRunloopSrc = NULL;
-	}
+	return nick;
+}
 
-	if (fServiceRef) {
-		AILogWithSignature(@"Deallocating DNSServiceRef %p", fServiceRef);
+static AWEzvStatus statusFromData(AWEzvRendezvousData *rendezvousData)
+{
+	NSString *status = [rendezvousData getField:@"status"];
 
-		DNSServiceRefDeallocate(fServiceRef);
-		fServiceRef = NULL;
+	if ([status isEqualToString:@"dnd"]) {
+		return AWEzvAway;
+	} else if ([status isEqualToString:@"away"]) {
+		return AWEzvIdle;
+	} else {
+		// "avail", missing or unknown
+		return AWEzvOnline;
 	}
-
-	[contactManager release]; contactManager = nil;
 }
 
-@end // Implementation ServiceController
+/*!
+ * @brief Everything about a contact that userChangedState: passes on to the client
+ */
+static NSString *stateDescription(AWEzvContact *contact)
+{
+	return [NSString stringWithFormat:@"%d\n%@\n%@\n%f", contact.status, contact.name, contact.statusMessage,
+			[contact.idleSinceDate timeIntervalSinceReferenceDate]];
+}
@@ -43,9 +43,12 @@
 @property (readwrite, retain, nonatomic) NSString *ipAddr;
 @property (readwrite, nonatomic) u_int16_t port;
 @property (readwrite, retain, nonatomic) AWEzvContactManager *manager;
-@property (readwrite, retain, nonatomic) ServiceController * resolveServiceController;
-@property (readwrite, retain, nonatomic) ServiceController * imageServiceController;
-@property (readwrite, retain, nonatomic) ServiceController * addressServiceController;
+@property (readwrite, copy, nonatomic) NSData *TXTRecord;
+@property (readwrite, copy, nonatomic) NSString *hostName;
+/* Queries from the manager's AWEzvDiscoveryBackend, which run for as long as they're retained */
+@property (readwrite, retain, nonatomic) id resolveServiceController;
+@property (readwrite, retain, nonatomic) id imageServiceController;
+@property (readwrite, retain, nonatomic) id addressServiceController;
 @property (readonly, nonatomic) int serial;
 
 - (void)createConnection;
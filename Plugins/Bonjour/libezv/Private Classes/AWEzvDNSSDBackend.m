@@ -0,0 +1,552 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AWEzvDNSSDBackend.h"
+#import "AWEzvSupportRoutines.h"
+
+#import <sys/socket.h>
+#import <netinet/in.h>
+#import <arpa/inet.h>
+
+// The ServiceController manages cleanup of DNSServiceRef & runloop info for an outstanding request
+@interface ServiceController : NSObject
+{
+	DNSServiceRef			fServiceRef;
+	CFSocketRef				fSocketRef;
+	CFRunLoopSourceRef		fRunloopSrc;
+	AWEzvDNSSDBackend		*backend;
+	NSString				*instanceName;
+}
+
+- (id)initWithBackend:(AWEzvDNSSDBackend *)inBackend instanceName:(NSString *)inInstanceName;
+- (void)setServiceRef:(DNSServiceRef)ref;
+- (boolean_t)addToCurrentRunLoop;
+- (void)breakdownServiceController;
+- (DNSServiceRef)serviceRef;
+
+@property (readonly, nonatomic) AWEzvDNSSDBackend *backend;
+@property (readonly, nonatomic) NSString *instanceName;
+
+@end // Interface ServiceController
+
+@interface AWEzvDNSSDBackend ()
+- (ServiceController *)startServiceController:(ServiceController *)controller withError:(DNSServiceErrorType)error serviceRef:(DNSServiceRef)ref;
+- (void)serviceControllerReceivedFatalError:(ServiceController *)serviceController;
+@end
+
+// C-helper function prototypes
+static void register_reply(DNSServiceRef sdRef, DNSServiceFlags flags, DNSServiceErrorType errorCode, const char *name,
+						   const char *regtype, const char *domain, void *context);
+
+static void handle_av_browse_reply(DNSServiceRef sdRef, DNSServiceFlags flags, uint32_t interfaceIndex, DNSServiceErrorType errorCode,
+								   const char *serviceName, const char *regtype, const char *replyDomain, void *context);
+
+static void resolve_reply(DNSServiceRef sdRef, DNSServiceFlags flags, uint32_t interfaceIndex, DNSServiceErrorType errorCode,
+						  const char *fullname, const char *hosttarget, uint16_t port, uint16_t txtLen,
+						  const unsigned char *txtRecord, void *context);
+
+static void AddressQueryRecordReply(DNSServiceRef DNSServiceRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+									DNSServiceErrorType errorCode, const char *fullname, uint16_t rrtype, uint16_t rrclass,
+									uint16_t rdlen, const void *rdata, uint32_t ttl, void *context);
+
+static void ImageQueryRecordReply(DNSServiceRef DNSServiceRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+								  DNSServiceErrorType errorCode, const char *fullname, uint16_t rrtype, uint16_t rrclass,
+								  uint16_t rdlen, const void *rdata, uint32_t ttl, void *context);
+
+static void ProcessSockData(CFSocketRef s, CFSocketCallBackType callbackType, CFDataRef address, const void *data, void *info);
+
+@implementation AWEzvDNSSDBackend
+
+@synthesize delegate;
+
+- (void)dealloc
+{
+	[self stopBrowsing];
+	[self unregister];
+
+	[super dealloc];
+}
+
+/*!
+ * @brief Start reading results for a request made with controller as its context
+ *
+ * @result controller, autoreleased, or nil if the request failed
+ */
+- (ServiceController *)startServiceController:(ServiceController *)controller withError:(DNSServiceErrorType)error serviceRef:(DNSServiceRef)ref
+{
+	if (error != kDNSServiceErr_NoError) {
+		AWEzvLog(@"dns_sd request for %@ failed: %d", controller.instanceName, error);
+		[controller release];
+		return nil;
+	}
+
+	[controller setServiceRef:ref];
+	[controller addToCurrentRunLoop];
+
+	return [controller autorelease];
+}
+
+#pragma mark Announcing
+
+- (BOOL)registerInstanceName:(NSString *)instanceName port:(uint16_t)port TXTRecord:(NSData *)TXTRecord
+{
+	ServiceController	*controller = [[ServiceController alloc] initWithBackend:self instanceName:instanceName];
+	DNSServiceRef		servRef;
+	DNSServiceErrorType dnsError;
+
+	dnsError = DNSServiceRegister(
+			/* Uninitialized service discovery reference */ &servRef, 
+		    /* Flags indicating how to handle name conflicts */ /* kDNSServiceFlagsNoAutoRename */ 0, 
+		    /* Interface on which to register, 0 for all available */ 0, 
+		    /* Service's name, may be null */ [instanceName UTF8String],
+		    /* Service registration type */ "_presence._tcp", 
+		    /* Domain, may be NULL */ NULL,
+		    /* SRV target host name, may be NULL */ NULL,
+		    /* Port number in network byte order */ htons(port), 
+		    /* Length of txt record in bytes, 0 for NULL txt record */ (uint16_t)[TXTRecord length],
+		    /* Txt record properly formatted, may be NULL */ [TXTRecord bytes],
+		    /* Call back function, may be NULL */ register_reply,
+			/* Application context pointer, may be null */ controller
+	);
+
+	[self unregister];
+	registration = [[self startServiceController:controller withError:dnsError serviceRef:servRef] retain];
+
+	return (registration != nil);
+}
+
+- (BOOL)updateTXTRecord:(NSData *)TXTRecord
+{
+	if (!registration) {
+		return NO;
+	}
+
+	return (DNSServiceUpdateRecord (
+		/* serviceRef */ [registration serviceRef],
+		/* recordRef, may be NULL */ NULL,
+		/* Flags, currently ignored */ 0,
+		/* length */ (uint16_t)[TXTRecord length],
+		/* data */ [TXTRecord bytes],
+		/* time to live */ 0
+	) == kDNSServiceErr_NoError);
+}
+
+- (BOOL)setImageRecord:(NSData *)imageData
+{
+	DNSServiceErrorType error;
+
+	if (!registration) {
+		return NO;
+	}
+
+	if (imageRecord != NULL) {
+		/* Remove the old reference before updating the image. 
+		 * This works around a bug experienced when updating the record to use an image that occupied more space
+		 */
+		error = DNSServiceRemoveRecord ( 
+		    /* service reference */ [registration serviceRef], 
+		    /* record reference */ imageRecord, 
+			/* flags, ignored */ 0
+		);
+
+		if (error != kDNSServiceErr_NoError) {
+			return NO;
+		}
+		imageRecord = NULL;
+	}
+
+	if (!imageData) {
+		return YES;
+	}
+
+	error = DNSServiceAddRecord (/* Service reference */ [registration serviceRef], 
+	                             /* Record reference */ &imageRecord, 
+	                             /* Flags, ignored */ 0, 
+	                             /* Type */ kDNSServiceType_NULL, 
+	                             /* Length */ (uint16_t)[imageData length], 
+	                             /* Data */ [imageData bytes], 
+	                             /* Time to live; 0 = default */ 0);
+
+	if (error != kDNSServiceErr_NoError) {
+		imageRecord = NULL;
+		return NO;
+	}
+
+	return YES;
+}
+
+- (void)unregister
+{
+	// Deallocating the DNSServiceRef also removes any records added to it
+	[registration release]; registration = nil;
+	imageRecord = NULL;
+}
+
+#pragma mark Browsing
+
+- (BOOL)startBrowsing
+{
+	ServiceController	*controller = [[ServiceController alloc] initWithBackend:self instanceName:nil];
+	DNSServiceRef		browsRef;
+	DNSServiceErrorType avBrowseError;
+
+	avBrowseError = DNSServiceBrowse (/* Uninitialized DNSServiceRef */ &browsRef,
+	                                  /* Flags, currently unused */ 0,
+	                                  /* Interface index, 0 for all available */ 0,
+	                                  /* Registration type */ "_presence._tcp",
+	                                  /* Domain, may be null for default */ NULL,
+	                                  /* CallBack function */ handle_av_browse_reply,
+	                                  /* Context, may be null */ controller);
+
+	[self stopBrowsing];
+	browser = [[self startServiceController:controller withError:avBrowseError serviceRef:browsRef] retain];
+
+	return (browser != nil);
+}
+
+- (void)stopBrowsing
+{
+	[browser release]; browser = nil;
+}
+
+#pragma mark Queries
+
+- (id)resolveInstance:(NSString *)instanceName domain:(NSString *)domain
+{
+	ServiceController	*controller = [[ServiceController alloc] initWithBackend:self instanceName:instanceName];
+	DNSServiceRef		resolveRef;
+	DNSServiceErrorType resolveRefError;
+
+	resolveRefError = DNSServiceResolve (
+		/* Serviceref uninitialized */ &resolveRef,
+		/* Flags, currently ignored */ 0,
+		/* InterfaceIndex */ 0,
+		/* Full name */ [instanceName UTF8String],
+		/* Registration type */ "_presence._tcp",
+		/* Domain */ [domain UTF8String],
+		/* Callback */ resolve_reply,
+		/* Contxt, may be NULL */ controller
+	);
+
+	return [self startServiceController:controller withError:resolveRefError serviceRef:resolveRef];
+}
+
+- (id)queryAddressForHost:(NSString *)host interface:(uint32_t)interfaceIndex instance:(NSString *)instanceName
+{
+	ServiceController	*controller = [[ServiceController alloc] initWithBackend:self instanceName:instanceName];
+	DNSServiceRef		serviceRef;
+	DNSServiceErrorType err;
+
+	err = DNSServiceQueryRecord(&serviceRef, (DNSServiceFlags) 0, interfaceIndex, [host UTF8String],
+								kDNSServiceType_A, kDNSServiceClass_IN, AddressQueryRecordReply, controller);
+
+	return [self startServiceController:controller withError:err serviceRef:serviceRef];
+}
+
+- (id)queryImageForInstance:(NSString *)instanceName interface:(uint32_t)interfaceIndex
+{
+	ServiceController	*controller = [[ServiceController alloc] initWithBackend:self instanceName:instanceName];
+	DNSServiceRef		serviceRef;
+	DNSServiceErrorType err;
+
+	NSString *dnsname = [NSString stringWithFormat:@"%@%s", instanceName, "._presence._tcp.local."];
+	err = DNSServiceQueryRecord(&serviceRef, (DNSServiceFlags) 0, interfaceIndex, [dnsname UTF8String],
+								kDNSServiceType_NULL, kDNSServiceClass_IN, ImageQueryRecordReply, controller);
+
+	return [self startServiceController:controller withError:err serviceRef:serviceRef];
+}
+
+- (void)serviceControllerReceivedFatalError:(ServiceController *)serviceController
+{
+	[delegate discoveryBackendDidFail:self];
+}
+
+@end
+
+#pragma mark mDNS Callbacks
+#pragma mark mDNS Register Callback
+
+static void register_reply(DNSServiceRef sdRef, DNSServiceFlags flags, DNSServiceErrorType errorCode, const char *name,
+						   const char *regtype, const char *domain, void *context)
+{
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+	AWEzvDNSSDBackend	*self = [(ServiceController *)context backend];
+	AWEzvDiscoveryError	error;
+
+	switch (errorCode) {
+		case kDNSServiceErr_NoError:
+			error = AWEzvDiscoveryNoError;
+			break;
+		case kDNSServiceErr_NameConflict:
+			error = AWEzvDiscoveryNameConflict;
+			break;
+		case kDNSServiceErr_Unknown:
+			error = AWEzvDiscoveryUnknownError;
+			break;
+		default:
+			AWEzvLog(@"Internal error: rendezvous code %d", errorCode);
+			error = AWEzvDiscoveryInternalError;
+			break;
+	}
+
+	[self.delegate discoveryBackend:self
+			didRegisterInstanceName:(name ? [NSString stringWithUTF8String:name] : nil)
+							  error:error];
+
+	[pool release];
+}
+
+#pragma mark mDNS Browse Callback
+
+/*!
+ * @brief DNSServiceBrowse callback
+ *
+ * This may be called multiple times for a single use of DNSServiceBrowse().
+ */
+static void handle_av_browse_reply(DNSServiceRef sdRef, DNSServiceFlags flags, uint32_t interfaceIndex, DNSServiceErrorType errorCode,
+								   const char *serviceName, const char *regtype, const char *replyDomain, void *context)
+{
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+	if (errorCode == kDNSServiceErr_NoError) {
+		AWEzvDNSSDBackend	*self = [(ServiceController *)context backend];
+		NSString			*instanceName = (serviceName ? [NSString stringWithUTF8String:serviceName] : nil);
+
+		if (instanceName) {
+			if (flags & kDNSServiceFlagsAdd) {
+				[self.delegate discoveryBackend:self
+								didFindInstance:instanceName
+										 domain:(replyDomain ? [NSString stringWithUTF8String:replyDomain] : nil)];
+			} else {
+				[self.delegate discoveryBackend:self didLoseInstance:instanceName];
+			}
+		}
+	} else {
+		AWEzvLog(@"Error browsing");
+	}
+
+	[pool release];
+}
+
+#pragma mark mDNS Resolve Callback
+
+/*!
+ * @brief DNSServiceResolve callback
+ *
+ * This is called again each time the instance's TXT record changes, for as long as the resolve is running.
+ */
+static void resolve_reply(DNSServiceRef sdRef, DNSServiceFlags flags, uint32_t interfaceIndex, DNSServiceErrorType errorCode,
+						  const char *fullname, const char *hosttarget, uint16_t port, uint16_t txtLen,
+						  const unsigned char *txtRecord, void *context)
+{
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+	if (errorCode == kDNSServiceErr_NoError) {
+		ServiceController	*controller = context;
+		AWEzvDNSSDBackend	*self = [controller backend];
+
+		[self.delegate discoveryBackend:self
+					 didResolveInstance:[controller instanceName]
+								   host:[NSString stringWithUTF8String:hosttarget]
+							  interface:interfaceIndex
+								   port:ntohs(port)
+							  TXTRecord:[NSData dataWithBytes:txtRecord length:txtLen]];
+	} else {
+		AWEzvLog(@"Error resolving records");
+	}
+
+	[pool release];
+}
+
+#pragma mark mDNS Address Callback
+
+// DNSServiceQueryRecord callback used to look up IP addresses.
+static void AddressQueryRecordReply(DNSServiceRef serviceRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+									DNSServiceErrorType errorCode, const char *fullname, uint16_t rrtype, uint16_t rrclass,
+									uint16_t rdlen, const void *rdata, uint32_t ttl, void *context)
+{
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+	ServiceController	*controller = context;
+	AWEzvDNSSDBackend	*self = [controller backend];
+	char				addrBuff[256];
+	NSString			*ipAddr = nil;
+
+	if (errorCode == kDNSServiceErr_NoError && rdlen == sizeof(struct in_addr) &&
+		inet_ntop(AF_INET, rdata, addrBuff, sizeof addrBuff)) {
+		ipAddr = [NSString stringWithCString:addrBuff encoding:NSUTF8StringEncoding];
+	}
+
+	[self.delegate discoveryBackend:self
+					 didFindAddress:ipAddr
+						forInstance:[controller instanceName]
+						 moreComing:((flags & kDNSServiceFlagsMoreComing) != 0)];
+
+	[pool release];
+}
+
+#pragma mark mDNS Image Callback
+
+// DNSServiceQueryRecord callback used to look up buddy icon.
+static void ImageQueryRecordReply(DNSServiceRef serviceRef, DNSServiceFlags flags, uint32_t interfaceIndex,
+								  DNSServiceErrorType errorCode, const char *fullname, uint16_t rrtype, uint16_t rrclass,
+								  uint16_t rdlen, const void *rdata, uint32_t ttl, void *context)
+{
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+	if (errorCode == kDNSServiceErr_NoError && (flags & kDNSServiceFlagsAdd)) {
+		ServiceController	*controller = context;
+		AWEzvDNSSDBackend	*self = [controller backend];
+
+		[self.delegate discoveryBackend:self
+					  didFetchImageData:[NSData dataWithBytes:rdata length:rdlen]
+							forInstance:[controller instanceName]
+							 moreComing:((flags & kDNSServiceFlagsMoreComing) != 0)];
+	}
+
+	[pool release];
+}
+
+#pragma mark Service Controller
+
+// ServiceController was taken from Apple's DNSServiceBrowser.m
+@implementation ServiceController : NSObject
+
+#pragma mark CFSocket Callback
+
+// This code was taken from Apple's DNSServiceBrowser.m
+static void	ProcessSockData( CFSocketRef s, CFSocketCallBackType type, CFDataRef address, const void *data, void *info)
+// CFRunloop callback that notifies dns_sd when new data appears on a DNSServiceRef's socket.
+{
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+	
+	ServiceController *self = (ServiceController *)info;
+	AILogWithSignature(@"Processing result for %@", self);
+
+	DNSServiceErrorType err = DNSServiceProcessResult([self serviceRef]);
+	
+	if (err != kDNSServiceErr_NoError) {
+		if ((err == kDNSServiceErr_Unknown) && !data) {
+			// Try to accept(2) a connection. May be the cause of a hang on Tiger; see #7887.
+			int socketFD = CFSocketGetNative(s);
+			int childFD = accept(socketFD, /*addr*/ NULL, /*addrlen*/ NULL);
+			AILog(@"%@: Service ref %p received an unknown error with no data; perhaps mDNSResponder crashed? Result of calling accept(2) on fd %d is %d; will disconnect with error",
+				  self, [self serviceRef], socketFD, childFD);
+			// We don't actually *want* a connection, so close the socket immediately.
+			if (childFD > -1) {
+				close(childFD);
+			}
+
+			[self retain];
+			[[self backend] serviceControllerReceivedFatalError:self];
+			[self breakdownServiceController];
+			[self release];
+
+		} else {
+            AILog(@"DNSServiceProcessResult() for socket descriptor %d returned an error! %d with CFSocketCallBackType %lu and data %s\n",
+			DNSServiceRefSockFD([self serviceRef]), err, type, data);
+		}
+	}
+	
+	[pool release];
+}
+
+/*!
+ * @brief Initialize for a request on behalf of inBackend
+ *
+ * The backend isn't retained; it outlives its requests, since contacts retain their manager, which retains the backend.
+ */
+- (id)initWithBackend:(AWEzvDNSSDBackend *)inBackend instanceName:(NSString *)inInstanceName
+{
+	if ((self = [super init])) {
+		backend = inBackend;
+		instanceName = [inInstanceName copy];
+	}
+
+	return self;
+}
+
+- (void)setServiceRef:(DNSServiceRef)ref
+{
+	fServiceRef = ref;
+}
+
+- (boolean_t) addToCurrentRunLoop
+// Add the service to the current runloop. Returns non-zero on success.
+{
+	CFSocketContext	ctx = { 1, self, NULL, NULL, NULL };
+
+	fSocketRef = CFSocketCreateWithNative(kCFAllocatorDefault, DNSServiceRefSockFD(fServiceRef),
+										kCFSocketReadCallBack, ProcessSockData, &ctx);
+	if (fSocketRef != NULL) {
+		fRunloopSrc = CFSocketCreateRunLoopSource(kCFAllocatorDefault, fSocketRef, 1);
+	}
+	
+	if (fRunloopSrc != NULL) {
+		AILogWithSignature(@"Adding run loop source %p from run loop %p", fRunloopSrc, CFRunLoopGetCurrent());
+		CFRunLoopAddSource(CFRunLoopGetCurrent(), fRunloopSrc, kCFRunLoopDefaultMode);
+	} else {
+		AILog(@"%@: Could not listen to runloop socket", self);
+	}
+
+	return (fRunloopSrc != NULL);
+}
+
+- (DNSServiceRef) serviceRef
+{
+	return fServiceRef;
+}
+
+@synthesize backend, instanceName;
+
+- (void) dealloc
+// Remove service from runloop, deallocate service and associated resources
+{
+	AILogWithSignature(@"%@", self);
+
+	[self breakdownServiceController];
+	[instanceName release];
+
+	[super dealloc];
+}
+
+- (void)breakdownServiceController
+{
+	AILogWithSignature(@"%@", self);
+
+	if (fSocketRef != NULL) {
+		CFSocketInvalidate(fSocketRef);	// Note: Also closes the underlying socket
+		CFRelease(fSocketRef);
+		fSocketRef = NULL;
+	}
+
+	if (fRunloopSrc != NULL) {
+		AILogWithSignature(@"Removing run loop source %p from run loop %p", fRunloopSrc, CFRunLoopGetCurrent());
+		CFRunLoopRemoveSource(CFRunLoopGetCurrent(), fRunloopSrc, kCFRunLoopDefaultMode);
+		CFRelease(fRunloopSrc);
+		fRunloopSrc = NULL;
+	}
+
+	if (fServiceRef) {
+		AILogWithSignature(@"Deallocating DNSServiceRef %p", fServiceRef);
+
+		DNSServiceRefDeallocate(fServiceRef);
+		fServiceRef = NULL;
+	}
+}
+
+@end // Implementation ServiceController
@@ -0,0 +1,98 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+/* The mDNS operations libezv needs, so AWEzvContactManager doesn't talk to dns_sd directly. AWEzvDNSSDBackend
+ * is the real thing; AWEzvLoopbackBackend answers from an in-process network for tests and benchmarks.
+ */
+
+typedef enum {
+	AWEzvDiscoveryNoError = 0,
+	AWEzvDiscoveryNameConflict,
+	AWEzvDiscoveryUnknownError,
+	AWEzvDiscoveryInternalError
+} AWEzvDiscoveryError;
+
+@protocol AWEzvDiscoveryBackend;
+
+/*!
+ * @brief Receives the results of an AWEzvDiscoveryBackend's registration, browse and queries
+ *
+ * Instances are identified by their service instance name, which libezv uses as the contact's unique ID.
+ * Results are delivered on the run loop which started the operation.
+ */
+@protocol AWEzvDiscoveryBackendDelegate <NSObject>
+- (void)discoveryBackend:(id <AWEzvDiscoveryBackend>)backend didRegisterInstanceName:(NSString *)instanceName error:(AWEzvDiscoveryError)error;
+
+- (void)discoveryBackend:(id <AWEzvDiscoveryBackend>)backend didFindInstance:(NSString *)instanceName domain:(NSString *)domain;
+- (void)discoveryBackend:(id <AWEzvDiscoveryBackend>)backend didLoseInstance:(NSString *)instanceName;
+
+/*!
+ * @brief An instance was resolved, or its TXT record changed while it was being resolved
+ *
+ * @param TXTRecord The raw TXT record, as passed to -[AWEzvRendezvousData initWithTXTRecordRef:length:]
+ */
+- (void)discoveryBackend:(id <AWEzvDiscoveryBackend>)backend
+	  didResolveInstance:(NSString *)instanceName
+					host:(NSString *)host
+			   interface:(uint32_t)interfaceIndex
+					port:(uint16_t)port
+			   TXTRecord:(NSData *)TXTRecord;
+
+- (void)discoveryBackend:(id <AWEzvDiscoveryBackend>)backend
+		  didFindAddress:(NSString *)ipAddr
+			 forInstance:(NSString *)instanceName
+			  moreComing:(BOOL)moreComing;
+
+/*!
+ * @brief The NULL record holding an instance's picture arrived
+ *
+ * @param imageData The picture, or an empty NSData if the record was empty
+ */
+- (void)discoveryBackend:(id <AWEzvDiscoveryBackend>)backend
+	   didFetchImageData:(NSData *)imageData
+			 forInstance:(NSString *)instanceName
+			  moreComing:(BOOL)moreComing;
+
+/*!
+ * @brief The backend lost its connection to the responder; everything it was doing has stopped
+ */
+- (void)discoveryBackendDidFail:(id <AWEzvDiscoveryBackend>)backend;
+@end
+
+/*!
+ * @brief Publishes our _presence._tcp service and discovers everyone else's
+ *
+ * The query methods return an object which keeps the query running for as long as it is retained, or nil if the
+ * query couldn't be started. Registration and browsing are owned by the backend and run until stopped.
+ */
+@protocol AWEzvDiscoveryBackend <NSObject>
+@property (assign, nonatomic) id <AWEzvDiscoveryBackendDelegate> delegate;
+
+- (BOOL)registerInstanceName:(NSString *)instanceName port:(uint16_t)port TXTRecord:(NSData *)TXTRecord;
+- (BOOL)updateTXTRecord:(NSData *)TXTRecord;
+/*!
+ * @brief Publish a picture in our NULL record, replacing any previous one; nil removes it
+ */
+- (BOOL)setImageRecord:(NSData *)imageData;
+- (void)unregister;
+
+- (BOOL)startBrowsing;
+- (void)stopBrowsing;
+
+- (id)resolveInstance:(NSString *)instanceName domain:(NSString *)domain;
+- (id)queryAddressForHost:(NSString *)host interface:(uint32_t)interfaceIndex instance:(NSString *)instanceName;
+- (id)queryImageForInstance:(NSString *)instanceName interface:(uint32_t)interfaceIndex;
+@end
@@ -0,0 +1,96 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AWEzvDiscoveryBackend.h"
+
+/*!
+ * @class AWEzvLoopbackNetwork
+ * @brief An in-process stand-in for mDNSResponder and the LAN behind it
+ *
+ * Every AWEzvLoopbackBackend on a network sees the services the others register, and resolves and picture
+ * queries are answered again whenever the service changes, as they are by dns_sd. Results are queued and delivered
+ * from the run loop; with deliversAutomatically set to NO they wait for -deliverPendingResults, so a test can
+ * decide when the network has caught up.
+ */
+@interface AWEzvLoopbackNetwork : NSObject {
+	NSMutableDictionary	*services;			// Instance name -> registered AWEzvLoopbackBackend, not retained
+	NSMutableSet		*backends;			// Not retained
+	NSMutableSet		*browsers;			// Not retained
+	NSMutableSet		*queries;			// Not retained
+	NSMutableDictionary	*queriesByInstance;	// Instance name -> NSMutableSet of queries, not retained
+	NSUInteger			 lastQueryID;
+
+	NSMutableArray		*pendingResults;
+	BOOL				 deliversAutomatically;
+	BOOL				 deliveryScheduled;
+
+	NSUInteger			 resolveResultCount;
+	NSUInteger			 imageResultCount;
+}
+
++ (AWEzvLoopbackNetwork *)sharedNetwork;
+
+/*!
+ * @brief Deliver every queued result, including those queued while delivering
+ *
+ * @result The number of results delivered
+ */
+- (NSUInteger)deliverPendingResults;
+
+@property (nonatomic) BOOL deliversAutomatically;
+
+/*!
+ * @brief Resolve results delivered so far; each one is a TXT record for the delegate to take in
+ */
+@property (readonly, nonatomic) NSUInteger resolveResultCount;
+/*!
+ * @brief Picture records delivered so far
+ */
+@property (readonly, nonatomic) NSUInteger imageResultCount;
+
+@end
+
+/*!
+ * @class AWEzvLoopbackBackend
+ * @brief AWEzvDiscoveryBackend which publishes to and browses an AWEzvLoopbackNetwork
+ *
+ * Lets libezv run without mDNSResponder, e.g. on Linux or in a benchmark which simulates a LAN of peers, each of
+ * them a backend with no delegate.
+ */
+@interface AWEzvLoopbackBackend : NSObject <AWEzvDiscoveryBackend> {
+	id <AWEzvDiscoveryBackendDelegate> delegate;
+	AWEzvLoopbackNetwork	*network;
+
+	NSString				*instanceName;
+	uint16_t				 port;
+	NSData					*TXTRecord;
+	NSData					*imageData;
+	BOOL					 registered;
+}
+
+/*!
+ * @brief Create a backend on the shared network
+ */
+- (id)init;
+- (id)initWithNetwork:(AWEzvLoopbackNetwork *)inNetwork;
+
+@property (readonly, nonatomic) AWEzvLoopbackNetwork *network;
+@property (readonly, nonatomic) NSString *instanceName;
+@property (readonly, nonatomic) uint16_t port;
+@property (readonly, nonatomic) NSData *TXTRecord;
+@property (readonly, nonatomic) NSData *imageData;
+
+@end
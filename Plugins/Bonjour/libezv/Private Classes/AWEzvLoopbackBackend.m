@@ -0,0 +1,499 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AWEzvLoopbackBackend.h"
+
+#define LOOPBACK_HOST		@"loopback.local."
+#define LOOPBACK_ADDRESS	@"127.0.0.1"
+#define LOOPBACK_DOMAIN		@"local."
+
+typedef enum {
+	AWEzvLoopbackResolve = 0,
+	AWEzvLoopbackAddress,
+	AWEzvLoopbackImage
+} AWEzvLoopbackQueryType;
+
+/*!
+ * @class AWEzvLoopbackQuery
+ * @brief The object an AWEzvLoopbackBackend hands out for a query; releasing it stops the query
+ */
+@interface AWEzvLoopbackQuery : NSObject {
+@public
+	AWEzvLoopbackNetwork	*network;
+	AWEzvLoopbackBackend	*backend;
+	AWEzvLoopbackQueryType	 type;
+	NSString				*instanceName;
+	NSUInteger				 queryID;
+}
+- (id)initWithBackend:(AWEzvLoopbackBackend *)inBackend type:(AWEzvLoopbackQueryType)inType instanceName:(NSString *)inInstanceName;
+@end
+
+@interface AWEzvLoopbackNetwork ()
+- (void)addBackend:(AWEzvLoopbackBackend *)backend;
+- (void)removeBackend:(AWEzvLoopbackBackend *)backend;
+- (BOOL)registerBackend:(AWEzvLoopbackBackend *)backend;
+- (void)unregisterBackend:(AWEzvLoopbackBackend *)backend;
+- (void)backendDidUpdateTXTRecord:(AWEzvLoopbackBackend *)backend;
+- (void)backendDidUpdateImageRecord:(AWEzvLoopbackBackend *)backend;
+- (void)startBrowsingForBackend:(AWEzvLoopbackBackend *)backend;
+- (void)stopBrowsingForBackend:(AWEzvLoopbackBackend *)backend;
+- (void)addQuery:(AWEzvLoopbackQuery *)query;
+- (void)removeQuery:(AWEzvLoopbackQuery *)query;
+
+- (void)enqueueResult:(void (^)(void))result;
+- (void)enqueueResultForQuery:(AWEzvLoopbackQuery *)query fromService:(AWEzvLoopbackBackend *)service;
+- (void)enqueueBrowseResultForBackend:(AWEzvLoopbackBackend *)browser instanceName:(NSString *)name added:(BOOL)added;
+@end
+
+/*!
+ * @brief A mutable set which doesn't retain its members, so results can check that their target is still alive
+ */
+static NSMutableSet *nonretainingSet(void)
+{
+	return [(NSMutableSet *)CFSetCreateMutable(kCFAllocatorDefault, 0, NULL) autorelease];
+}
+
+@implementation AWEzvLoopbackNetwork
+
++ (AWEzvLoopbackNetwork *)sharedNetwork
+{
+	static AWEzvLoopbackNetwork *sharedNetwork = nil;
+
+	if (!sharedNetwork) {
+		sharedNetwork = [[AWEzvLoopbackNetwork alloc] init];
+	}
+
+	return sharedNetwork;
+}
+
+- (id)init
+{
+	if ((self = [super init])) {
+		services = [[NSMutableDictionary alloc] init];
+		backends = [nonretainingSet() retain];
+		browsers = [nonretainingSet() retain];
+		queries = [nonretainingSet() retain];
+		queriesByInstance = [[NSMutableDictionary alloc] init];
+		pendingResults = [[NSMutableArray alloc] init];
+		deliversAutomatically = YES;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[NSObject cancelPreviousPerformRequestsWithTarget:self];
+
+	[services release];
+	[backends release];
+	[browsers release];
+	[queries release];
+	[queriesByInstance release];
+	[pendingResults release];
+
+	[super dealloc];
+}
+
+@synthesize deliversAutomatically, resolveResultCount, imageResultCount;
+
+#pragma mark Delivery
+
+/*!
+ * @brief Is target, which may have been deallocated, still the query which was given queryID?
+ */
+- (BOOL)isQuery:(AWEzvLoopbackQuery *)target stillRunningWithID:(NSUInteger)queryID
+{
+	// A query which has been released may have been replaced by another at the same address
+	return ([queries containsObject:target] && target->queryID == queryID);
+}
+
+- (void)enqueueResult:(void (^)(void))result
+{
+	void (^resultCopy)(void) = [result copy];
+	[pendingResults addObject:resultCopy];
+	[resultCopy release];
+
+	if (deliversAutomatically && !deliveryScheduled) {
+		deliveryScheduled = YES;
+		[self performSelector:@selector(deliverScheduledResults) withObject:nil afterDelay:0];
+	}
+}
+
+- (void)deliverScheduledResults
+{
+	deliveryScheduled = NO;
+	[self deliverPendingResults];
+}
+
+- (NSUInteger)deliverPendingResults
+{
+	NSUInteger delivered = 0;
+
+	while (pendingResults.count) {
+		NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+		NSArray				*results = [pendingResults copy];
+
+		[pendingResults removeAllObjects];
+		for (void (^result)(void) in results) {
+			result();
+		}
+		delivered += results.count;
+
+		[results release];
+		[pool release];
+	}
+
+	return delivered;
+}
+
+/*!
+ * @brief Queue the current state of service for query
+ *
+ * The state is captured now, so each change is delivered in turn, but the query is only answered if it's still
+ * running when the result is delivered.
+ */
+- (void)enqueueResultForQuery:(AWEzvLoopbackQuery *)query fromService:(AWEzvLoopbackBackend *)service
+{
+	// Not retained by the block: releasing the query has to stop it
+	__block AWEzvLoopbackQuery	*target = query;
+	NSUInteger					queryID = query->queryID;
+	NSString					*name = query->instanceName;
+	NSData						*TXTRecord = service.TXTRecord;
+	NSData						*imageData = service.imageData;
+	uint16_t					port = service.port;
+
+	switch (query->type) {
+		case AWEzvLoopbackResolve:
+			[self enqueueResult:^{
+				if (![self isQuery:target stillRunningWithID:queryID]) return;
+				resolveResultCount++;
+				[target->backend.delegate discoveryBackend:target->backend
+										didResolveInstance:name
+													  host:LOOPBACK_HOST
+												 interface:0
+													  port:port
+												 TXTRecord:TXTRecord];
+			}];
+			break;
+
+		case AWEzvLoopbackAddress:
+			[self enqueueResult:^{
+				if (![self isQuery:target stillRunningWithID:queryID]) return;
+				[target->backend.delegate discoveryBackend:target->backend
+											didFindAddress:LOOPBACK_ADDRESS
+											   forInstance:name
+												moreComing:NO];
+			}];
+			break;
+
+		case AWEzvLoopbackImage:
+			if (!imageData) break;
+			[self enqueueResult:^{
+				if (![self isQuery:target stillRunningWithID:queryID]) return;
+				imageResultCount++;
+				[target->backend.delegate discoveryBackend:target->backend
+										 didFetchImageData:imageData
+											   forInstance:name
+												moreComing:NO];
+			}];
+			break;
+	}
+}
+
+- (void)enqueueBrowseResultForBackend:(AWEzvLoopbackBackend *)browser instanceName:(NSString *)name added:(BOOL)added
+{
+	__block AWEzvLoopbackBackend *target = browser;
+
+	[self enqueueResult:^{
+		if (![browsers containsObject:target]) return;
+		if (added) {
+			[target.delegate discoveryBackend:target didFindInstance:name domain:LOOPBACK_DOMAIN];
+		} else {
+			[target.delegate discoveryBackend:target didLoseInstance:name];
+		}
+	}];
+}
+
+#pragma mark Backends
+
+- (void)addBackend:(AWEzvLoopbackBackend *)backend
+{
+	[backends addObject:backend];
+}
+
+- (void)removeBackend:(AWEzvLoopbackBackend *)backend
+{
+	[backends removeObject:backend];
+}
+
+- (BOOL)registerBackend:(AWEzvLoopbackBackend *)backend
+{
+	__block AWEzvLoopbackBackend	*target = backend;
+	NSString						*name = backend.instanceName;
+	BOOL							conflict = ([services objectForKey:name] != nil);
+
+	[self enqueueResult:^{
+		if (![backends containsObject:target]) return;
+		[target.delegate discoveryBackend:target
+				  didRegisterInstanceName:name
+									error:(conflict ? AWEzvDiscoveryNameConflict : AWEzvDiscoveryNoError)];
+	}];
+
+	if (conflict) {
+		return NO;
+	}
+
+	[services setObject:[NSValue valueWithNonretainedObject:backend] forKey:name];
+	for (AWEzvLoopbackBackend *browser in browsers) {
+		[self enqueueBrowseResultForBackend:browser instanceName:name added:YES];
+	}
+	// A resolve started before the service appeared is answered once it does
+	for (AWEzvLoopbackQuery *query in [queriesByInstance objectForKey:name]) {
+		[self enqueueResultForQuery:query fromService:backend];
+	}
+
+	return YES;
+}
+
+- (void)unregisterBackend:(AWEzvLoopbackBackend *)backend
+{
+	NSString *name = backend.instanceName;
+
+	if ([[services objectForKey:name] nonretainedObjectValue] != backend) {
+		return;
+	}
+
+	[services removeObjectForKey:name];
+	for (AWEzvLoopbackBackend *browser in browsers) {
+		[self enqueueBrowseResultForBackend:browser instanceName:name added:NO];
+	}
+}
+
+- (void)backendDidUpdateTXTRecord:(AWEzvLoopbackBackend *)backend
+{
+	for (AWEzvLoopbackQuery *query in [queriesByInstance objectForKey:backend.instanceName]) {
+		if (query->type == AWEzvLoopbackResolve) {
+			[self enqueueResultForQuery:query fromService:backend];
+		}
+	}
+}
+
+- (void)backendDidUpdateImageRecord:(AWEzvLoopbackBackend *)backend
+{
+	for (AWEzvLoopbackQuery *query in [queriesByInstance objectForKey:backend.instanceName]) {
+		if (query->type == AWEzvLoopbackImage) {
+			[self enqueueResultForQuery:query fromService:backend];
+		}
+	}
+}
+
+- (void)startBrowsingForBackend:(AWEzvLoopbackBackend *)backend
+{
+	[browsers addObject:backend];
+
+	for (NSString *name in services) {
+		[self enqueueBrowseResultForBackend:backend instanceName:name added:YES];
+	}
+}
+
+- (void)stopBrowsingForBackend:(AWEzvLoopbackBackend *)backend
+{
+	[browsers removeObject:backend];
+}
+
+#pragma mark Queries
+
+- (void)addQuery:(AWEzvLoopbackQuery *)query
+{
+	NSMutableSet *instanceQueries = [queriesByInstance objectForKey:query->instanceName];
+
+	if (!instanceQueries) {
+		instanceQueries = nonretainingSet();
+		[queriesByInstance setObject:instanceQueries forKey:query->instanceName];
+	}
+
+	query->queryID = ++lastQueryID;
+	[queries addObject:query];
+	[instanceQueries addObject:query];
+
+	AWEzvLoopbackBackend *service = [[services objectForKey:query->instanceName] nonretainedObjectValue];
+	if (service || query->type == AWEzvLoopbackAddress) {
+		[self enqueueResultForQuery:query fromService:service];
+	}
+}
+
+- (void)removeQuery:(AWEzvLoopbackQuery *)query
+{
+	NSMutableSet *instanceQueries = [queriesByInstance objectForKey:query->instanceName];
+
+	[instanceQueries removeObject:query];
+	if (!instanceQueries.count) {
+		[queriesByInstance removeObjectForKey:query->instanceName];
+	}
+
+	[queries removeObject:query];
+}
+
+@end
+
+@implementation AWEzvLoopbackQuery
+
+/*!
+ * @brief Start a query for inBackend
+ *
+ * The backend isn't retained; it outlives its queries, since contacts retain their manager, which retains the backend.
+ */
+- (id)initWithBackend:(AWEzvLoopbackBackend *)inBackend type:(AWEzvLoopbackQueryType)inType instanceName:(NSString *)inInstanceName
+{
+	if ((self = [super init])) {
+		backend = inBackend;
+		network = [inBackend.network retain];
+		type = inType;
+		instanceName = [inInstanceName copy];
+
+		[network addQuery:self];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[network removeQuery:self];
+
+	[network release];
+	[instanceName release];
+
+	[super dealloc];
+}
+
+@end
+
+@implementation AWEzvLoopbackBackend
+
+- (id)init
+{
+	return [self initWithNetwork:[AWEzvLoopbackNetwork sharedNetwork]];
+}
+
+- (id)initWithNetwork:(AWEzvLoopbackNetwork *)inNetwork
+{
+	if ((self = [super init])) {
+		network = [inNetwork retain];
+		[network addBackend:self];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[self stopBrowsing];
+	[self unregister];
+	[network removeBackend:self];
+
+	[network release];
+	[instanceName release];
+	[TXTRecord release];
+	[imageData release];
+
+	[super dealloc];
+}
+
+@synthesize delegate, network, instanceName, port, TXTRecord, imageData;
+
+#pragma mark Announcing
+
+- (BOOL)registerInstanceName:(NSString *)inInstanceName port:(uint16_t)inPort TXTRecord:(NSData *)inTXTRecord
+{
+	[self unregister];
+
+	[instanceName release]; instanceName = [inInstanceName copy];
+	[TXTRecord release]; TXTRecord = [inTXTRecord copy];
+	[imageData release]; imageData = nil;
+	port = inPort;
+
+	// A name conflict is reported to the delegate, as it is by dns_sd
+	registered = [network registerBackend:self];
+
+	return YES;
+}
+
+- (BOOL)updateTXTRecord:(NSData *)inTXTRecord
+{
+	if (!registered) {
+		return NO;
+	}
+
+	[TXTRecord release]; TXTRecord = [inTXTRecord copy];
+	[network backendDidUpdateTXTRecord:self];
+
+	return YES;
+}
+
+- (BOOL)setImageRecord:(NSData *)inImageData
+{
+	if (!registered) {
+		return NO;
+	}
+
+	[imageData release]; imageData = [inImageData copy];
+	[network backendDidUpdateImageRecord:self];
+
+	return YES;
+}
+
+- (void)unregister
+{
+	if (registered) {
+		[network unregisterBackend:self];
+		registered = NO;
+	}
+}
+
+#pragma mark Browsing
+
+- (BOOL)startBrowsing
+{
+	[network startBrowsingForBackend:self];
+
+	return YES;
+}
+
+- (void)stopBrowsing
+{
+	[network stopBrowsingForBackend:self];
+}
+
+#pragma mark Queries
+
+- (id)resolveInstance:(NSString *)name domain:(NSString *)domain
+{
+	return [[[AWEzvLoopbackQuery alloc] initWithBackend:self type:AWEzvLoopbackResolve instanceName:name] autorelease];
+}
+
+- (id)queryAddressForHost:(NSString *)host interface:(uint32_t)interfaceIndex instance:(NSString *)name
+{
+	return [[[AWEzvLoopbackQuery alloc] initWithBackend:self type:AWEzvLoopbackAddress instanceName:name] autorelease];
+}
+
+- (id)queryImageForInstance:(NSString *)name interface:(uint32_t)interfaceIndex
+{
+	return [[[AWEzvLoopbackQuery alloc] initWithBackend:self type:AWEzvLoopbackImage instanceName:name] autorelease];
+}
+
+@end
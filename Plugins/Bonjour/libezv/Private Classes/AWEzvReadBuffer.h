@@ -0,0 +1,102 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+struct AWEzvReadSegment;
+
+/*!
+ * @class AWEzvReadBuffer
+ * @brief Bytes read from a socket, held in a ring of reusable fixed-size segments
+ *
+ * Reads fill the free space at the end of the last segment and then fresh segments, with one readv() per call
+ * for a file descriptor. Segments which have been consumed go back on a short spare list, so a connection
+ * which keeps up with its reads stops allocating once it has warmed up.
+ *
+ * Buffered bytes are taken out either by copying (for callers which need an NSData) or slice by slice, in place,
+ * for a consumer such as expat which can take its input in pieces.
+ */
+@interface AWEzvReadBuffer : NSObject {
+	struct AWEzvReadSegment	*head;
+	struct AWEzvReadSegment	*tail;
+	struct AWEzvReadSegment	*spareSegments;
+	NSUInteger				 spareSegmentCount;
+	NSUInteger				 length;
+
+	NSUInteger				 readCallCount;
+	NSUInteger				 byteCount;
+	NSUInteger				 segmentAllocationCount;
+}
+
+/*!
+ * @brief Read whatever is available on a descriptor with a single readv()
+ *
+ * @result The result of readv(): the number of bytes read, 0 at end of file, or -1 with errno set
+ */
+- (NSInteger)readFromFileDescriptor:(int)fd;
+
+/*!
+ * @brief Read whatever is available on a stream, up to the free space in one segment
+ *
+ * @result The result of CFReadStreamRead()
+ */
+- (CFIndex)readFromStream:(CFReadStreamRef)stream;
+
+/*!
+ * @brief The offset of the first occurrence of data which starts at or after offset, or NSNotFound
+ *
+ * Matches may span segments.
+ */
+- (NSUInteger)offsetOfData:(NSData *)data startingAt:(NSUInteger)offset;
+
+/*!
+ * @brief Copy up to count bytes out of the buffer and consume them
+ *
+ * @result The number of bytes copied
+ */
+- (NSUInteger)readBytes:(void *)outBytes length:(NSUInteger)count;
+
+/*!
+ * @brief Move up to count bytes onto the end of data
+ *
+ * @result The number of bytes moved
+ */
+- (NSUInteger)appendBytesOfLength:(NSUInteger)count toData:(NSMutableData *)data;
+
+/*!
+ * @brief Pass every buffered slice to block in order, without copying, and consume them
+ */
+- (void)consumeSlicesUsingBlock:(void (^)(const unsigned char *bytes, NSUInteger sliceLength))block;
+
+- (void)removeAllBytes;
+
+/*!
+ * @brief The number of bytes buffered
+ */
+@property (readonly, nonatomic) NSUInteger length;
+
+/*!
+ * @brief readv() and CFReadStreamRead() calls made so far
+ */
+@property (readonly, nonatomic) NSUInteger readCallCount;
+/*!
+ * @brief Bytes read so far
+ */
+@property (readonly, nonatomic) NSUInteger byteCount;
+/*!
+ * @brief Segments allocated so far, as opposed to reused
+ */
+@property (readonly, nonatomic) NSUInteger segmentAllocationCount;
+
+@end
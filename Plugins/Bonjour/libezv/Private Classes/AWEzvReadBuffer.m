@@ -0,0 +1,298 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AWEzvReadBuffer.h"
+#import <sys/uio.h>
+
+#define READ_SEGMENT_SIZE		(16 * 1024)
+//Segments offered to each readv()
+#define MAX_READ_SEGMENTS		4
+//Consumed segments kept for reuse
+#define MAX_SPARE_SEGMENTS		MAX_READ_SEGMENTS
+
+typedef struct AWEzvReadSegment AWEzvReadSegment;
+
+struct AWEzvReadSegment {
+	AWEzvReadSegment	*next;
+	size_t				 start;		//First unconsumed byte
+	size_t				 end;		//One past the last byte read
+	unsigned char		 bytes[READ_SEGMENT_SIZE];
+};
+
+/*!
+ * @brief Does pattern appear at index in segment, continuing into the segments after it?
+ */
+static BOOL segmentMatches(AWEzvReadSegment *segment, size_t index, const unsigned char *pattern, NSUInteger patternLength)
+{
+	while (patternLength > 0 && segment) {
+		size_t count = MIN(patternLength, segment->end - index);
+
+		if (memcmp(segment->bytes + index, pattern, count) != 0) return NO;
+
+		pattern += count;
+		patternLength -= count;
+		segment = segment->next;
+		if (segment) index = segment->start;
+	}
+
+	return (patternLength == 0);
+}
+
+@interface AWEzvReadBuffer ()
+- (AWEzvReadSegment *)takeSpareSegment;
+- (void)returnSegment:(AWEzvReadSegment *)segment;
+- (void)appendSegment:(AWEzvReadSegment *)segment;
+- (void)removeHeadSegment;
+@end
+
+@implementation AWEzvReadBuffer
+
+- (void)dealloc
+{
+	[self removeAllBytes];
+
+	while (spareSegments) {
+		AWEzvReadSegment *segment = spareSegments;
+		spareSegments = segment->next;
+		free(segment);
+	}
+
+	[super dealloc];
+}
+
+@synthesize length, readCallCount, byteCount, segmentAllocationCount;
+
+- (AWEzvReadSegment *)takeSpareSegment
+{
+	AWEzvReadSegment *segment = spareSegments;
+
+	if (segment) {
+		spareSegments = segment->next;
+		spareSegmentCount--;
+	} else {
+		segment = malloc(sizeof(AWEzvReadSegment));
+		segmentAllocationCount++;
+	}
+
+	segment->next = NULL;
+	segment->start = segment->end = 0;
+
+	return segment;
+}
+
+- (void)returnSegment:(AWEzvReadSegment *)segment
+{
+	if (spareSegmentCount < MAX_SPARE_SEGMENTS) {
+		segment->next = spareSegments;
+		spareSegments = segment;
+		spareSegmentCount++;
+	} else {
+		free(segment);
+	}
+}
+
+- (void)appendSegment:(AWEzvReadSegment *)segment
+{
+	if (tail) {
+		tail->next = segment;
+	} else {
+		head = segment;
+	}
+	tail = segment;
+}
+
+- (void)removeHeadSegment
+{
+	AWEzvReadSegment *segment = head;
+
+	head = segment->next;
+	if (!head) tail = NULL;
+
+	[self returnSegment:segment];
+}
+
+- (NSInteger)readFromFileDescriptor:(int)fd
+{
+	struct iovec		iov[MAX_READ_SEGMENTS];
+	AWEzvReadSegment	*segments[MAX_READ_SEGMENTS];
+	BOOL				fillsTail = (tail && tail->end < READ_SEGMENT_SIZE);
+	int					count = 0, i;
+	ssize_t				bytesRead;
+	size_t				remaining;
+
+	//The rest of the last segment first, then fresh ones
+	if (fillsTail) {
+		segments[count] = tail;
+		iov[count].iov_base = tail->bytes + tail->end;
+		iov[count].iov_len = READ_SEGMENT_SIZE - tail->end;
+		count++;
+	}
+	while (count < MAX_READ_SEGMENTS) {
+		segments[count] = [self takeSpareSegment];
+		iov[count].iov_base = segments[count]->bytes;
+		iov[count].iov_len = READ_SEGMENT_SIZE;
+		count++;
+	}
+
+	bytesRead = readv(fd, iov, count);
+	readCallCount++;
+
+	remaining = (bytesRead > 0 ? (size_t)bytesRead : 0);
+	for (i = 0; i < count; i++) {
+		size_t filled = MIN(remaining, iov[i].iov_len);
+		remaining -= filled;
+
+		if (i == 0 && fillsTail) {
+			tail->end += filled;
+		} else if (filled > 0) {
+			segments[i]->end = filled;
+			[self appendSegment:segments[i]];
+		} else {
+			[self returnSegment:segments[i]];
+		}
+	}
+
+	if (bytesRead > 0) {
+		length += bytesRead;
+		byteCount += bytesRead;
+	}
+
+	return bytesRead;
+}
+
+- (CFIndex)readFromStream:(CFReadStreamRef)stream
+{
+	BOOL	appended = NO;
+	CFIndex	bytesRead;
+
+	if (!tail || tail->end == READ_SEGMENT_SIZE) {
+		[self appendSegment:[self takeSpareSegment]];
+		appended = YES;
+	}
+
+	bytesRead = CFReadStreamRead(stream, tail->bytes + tail->end, READ_SEGMENT_SIZE - tail->end);
+	readCallCount++;
+
+	if (bytesRead > 0) {
+		tail->end += bytesRead;
+		length += bytesRead;
+		byteCount += bytesRead;
+
+	} else if (appended) {
+		//Don't leave an empty segment behind
+		AWEzvReadSegment *empty = tail;
+
+		if (head == empty) {
+			head = tail = NULL;
+		} else {
+			AWEzvReadSegment *segment = head;
+			while (segment->next != empty) segment = segment->next;
+			segment->next = NULL;
+			tail = segment;
+		}
+		[self returnSegment:empty];
+	}
+
+	return bytesRead;
+}
+
+- (NSUInteger)offsetOfData:(NSData *)data startingAt:(NSUInteger)offset
+{
+	const unsigned char	*pattern = [data bytes];
+	NSUInteger			patternLength = [data length];
+	NSUInteger			segmentOffset = 0;
+	AWEzvReadSegment	*segment;
+
+	if (patternLength == 0 || offset + patternLength > length) return NSNotFound;
+
+	for (segment = head; segment; segment = segment->next) {
+		NSUInteger segmentLength = segment->end - segment->start;
+
+		if (offset < segmentOffset + segmentLength) {
+			const unsigned char	*bytes = segment->bytes + segment->start;
+			const unsigned char	*limit = bytes + segmentLength;
+			const unsigned char	*cursor = bytes + (offset > segmentOffset ? offset - segmentOffset : 0);
+
+			while ((cursor = memchr(cursor, pattern[0], limit - cursor))) {
+				NSUInteger matchOffset = segmentOffset + (cursor - bytes);
+
+				if (matchOffset + patternLength > length) return NSNotFound;
+				if (segmentMatches(segment, cursor - segment->bytes, pattern, patternLength)) return matchOffset;
+
+				cursor++;
+			}
+		}
+
+		segmentOffset += segmentLength;
+	}
+
+	return NSNotFound;
+}
+
+- (NSUInteger)readBytes:(void *)outBytes length:(NSUInteger)count
+{
+	NSUInteger copied = 0;
+
+	while (head && copied < count) {
+		size_t available = MIN(count - copied, head->end - head->start);
+
+		memcpy((unsigned char *)outBytes + copied, head->bytes + head->start, available);
+		head->start += available;
+		copied += available;
+
+		if (head->start == head->end) [self removeHeadSegment];
+	}
+
+	length -= copied;
+
+	return copied;
+}
+
+- (NSUInteger)appendBytesOfLength:(NSUInteger)count toData:(NSMutableData *)data
+{
+	NSUInteger	oldLength = [data length];
+	NSUInteger	copied;
+
+	count = MIN(count, length);
+	[data setLength:oldLength + count];
+	copied = [self readBytes:((unsigned char *)[data mutableBytes] + oldLength) length:count];
+
+	return copied;
+}
+
+- (void)consumeSlicesUsingBlock:(void (^)(const unsigned char *bytes, NSUInteger sliceLength))block
+{
+	while (head) {
+		AWEzvReadSegment	*segment = head;
+		size_t				start = segment->start, end = segment->end;
+
+		//Consumed before the block runs, in case it comes back to us
+		segment->start = end;
+		length -= (end - start);
+
+		if (end > start) block(segment->bytes + start, end - start);
+
+		if (segment == head) [self removeHeadSegment];
+	}
+}
+
+- (void)removeAllBytes
+{
+	while (head) [self removeHeadSegment];
+	length = 0;
+}
+
+@end
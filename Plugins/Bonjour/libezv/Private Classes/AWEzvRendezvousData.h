@@ -43,16 +43,20 @@
 - (AWEzvRendezvousData *) initWithDictionary:(NSDictionary *)dictionary;
 - (AWEzvRendezvousData *) initWithAVTxt:(NSString *)txt;
 - (AWEzvRendezvousData *) initWithTXTRecordRef:(const unsigned char *) txtRecord length:(uint16_t)len;
+- (AWEzvRendezvousData *) initWithTXTRecordData:(NSData *)TXTRecord;
++ (NSUInteger) TXTRecordParseCount;
 - (void) setField:(NSString *)fieldName content:(NSObject *)content;
 - (NSString *) getField:(NSString *)fieldName;
 - (BOOL) fieldExists:(NSString *)fieldName;
 - (void) deleteField:(NSString *)fieldName;
 - (UInt32) serial;
 - (NSDictionary *)dictionary;
+- (NSSet *) fieldsChangedSince:(AWEzvRendezvousData *)oldData;
 - (NSString *) dataAsDNSTXT;
 - (NSString *) avDataAsDNSTXT;
 - (NSData *) dataAsPackedPString;
 - (NSData *) avDataAsPackedPString;
 - (TXTRecordRef)dataAsTXTRecordRef;
+- (NSData *) dataAsTXTRecordData;
 
 @end
@@ -44,6 +44,9 @@ const char subn[] = { 's', 'u', 'b', 'n', '\x00', '\x00', '\x00', '\x01'};
 /*                        Reserved unknown       */
 const char endn[] = { '\x00', '\x00', '\x00', '\x00'};
 
+/* number of TXT records parsed, for benchmarking */
+static NSUInteger TXTRecordParseCount = 0;
+
 /* initialization, create our dictionary */
 -(AWEzvRendezvousData *) init 
 {
@@ -237,6 +240,7 @@ const char endn[] = { '\x00', '\x00', '\x00', '\x00'};
 - (AWEzvRendezvousData *) initWithTXTRecordRef:(const unsigned char *) txtRecord length:(uint16_t)len{
 	
 	self = [self init];
+	TXTRecordParseCount++;
     
 	DNSServiceErrorType txtRecordError;
 	
@@ -298,6 +302,17 @@ const char endn[] = { '\x00', '\x00', '\x00', '\x00'};
 	
 }
 
+/* initialise from a TXT record held in an NSData, as delivered by an AWEzvDiscoveryBackend */
+- (AWEzvRendezvousData *)initWithTXTRecordData:(NSData *)TXTRecord
+{
+	return [self initWithTXTRecordRef:[TXTRecord bytes] length:(uint16_t)[TXTRecord length]];
+}
+
++ (NSUInteger)TXTRecordParseCount
+{
+	return TXTRecordParseCount;
+}
+
 /* deallocate, destroy our dictionary */
 - (void)dealloc
 {
@@ -335,6 +350,24 @@ const char endn[] = { '\x00', '\x00', '\x00', '\x00'};
     return serial;
 }
 
+/* return the names of fields which were added, removed or changed since oldData */
+- (NSSet *)fieldsChangedSince:(AWEzvRendezvousData *)oldData
+{
+	NSMutableSet	*changedFields = [NSMutableSet set];
+	NSDictionary	*oldKeys = oldData->keys;
+
+	for (NSString *key in keys) {
+		if (![[keys objectForKey:key] isEqual:[oldKeys objectForKey:key]])
+			[changedFields addObject:key];
+	}
+	for (NSString *key in oldKeys) {
+		if (![keys objectForKey:key])
+			[changedFields addObject:key];
+	}
+
+	return changedFields;
+}
+
 /* return the dictionary */
 -(NSDictionary *)dictionary {
     return [[keys copy] autorelease];
@@ -559,6 +592,18 @@ const char endn[] = { '\x00', '\x00', '\x00', '\x00'};
 	
 	return txtRecord;
 }
+
+/* the TXT record from dataAsTXTRecordRef, copied into an NSData */
+- (NSData *)dataAsTXTRecordData
+{
+	TXTRecordRef	txtRecord = [self dataAsTXTRecordRef];
+	NSData			*data = [NSData dataWithBytes:TXTRecordGetBytesPtr(&txtRecord) length:TXTRecordGetLength(&txtRecord)];
+
+	TXTRecordDeallocate(&txtRecord);
+
+	return data;
+}
+
 /*
  * Converts data: to packed PString format as required by the low level rendezvous
  * functions when passing an opaque RData structure
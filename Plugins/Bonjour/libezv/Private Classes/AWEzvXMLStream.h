@@ -33,13 +33,14 @@
 #define XMLCALL
 #import <expat.h> 
 
-@class AWEzvStack, AWEzvXMLNode, AWEzvContactManager;
+@class AWEzvStack, AWEzvXMLNode, AWEzvContactManager, AWEzvReadBuffer;
 @protocol AWEzvXMLStreamProtocol;
 
 @interface AWEzvXMLStream : NSObject {
     XML_Parser	parser;
     id <AWEzvXMLStreamProtocol>	delegate;
     NSFileHandle *connection;
+    AWEzvReadBuffer *readBuffer;
     AWEzvStack	*nodeStack;
     int		initiator, negotiated;
 }
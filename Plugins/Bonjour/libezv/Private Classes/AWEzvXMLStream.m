@@ -37,6 +37,7 @@
 #import <AIUtilities/AIStringAdditions.h>
 #import "AWEzvSupportRoutines.h"
 #import "AWEzvContactManagerRendezvous.h"
+#import "AWEzvReadBuffer.h"
 
 #define XMLCALL
 #import <expat.h> 
@@ -53,7 +54,6 @@ void xml_char_data	(void *userData,
 
 @interface AWEzvXMLStream ()
 - (void) connectionDidEnd;
-- (void) dataReceived:(NSNotification *)aNotification;
 - (void) dataAvailable:(NSNotification *)aNotification;
 @end
 
@@ -65,6 +65,7 @@ void xml_char_data	(void *userData,
 		connection = [myConnection retain];
 		delegate = nil;
 		nodeStack = [[AWEzvStack alloc] init];
+		readBuffer = [[AWEzvReadBuffer alloc] init];
 		initiator = myInitiator;
 		negotiated = 0;
 	}	
@@ -81,6 +82,9 @@ void xml_char_data	(void *userData,
 	
 	[[NSNotificationCenter defaultCenter] removeObserver:self];
 	[nodeStack release];
+	[readBuffer release];
+	if (parser != NULL)
+		XML_ParserFree(parser);
 	
 	[super dealloc];
 }
@@ -88,10 +92,6 @@ void xml_char_data	(void *userData,
 @synthesize fileHandle = connection;
 
 - (void) readAndParse {
-    [[NSNotificationCenter defaultCenter] addObserver:self
-					  selector:@selector(dataReceived:)
-					  name:NSFileHandleReadCompletionNotification
-					  object:connection];
     [[NSNotificationCenter defaultCenter] addObserver:self
 					  selector:@selector(dataAvailable:)
 					  name:NSFileHandleDataAvailableNotification
@@ -133,26 +133,35 @@ void xml_char_data	(void *userData,
 	}
 }
 
-- (void) dataReceived:(NSNotification *)aNotification {
-    NSData *data = [[aNotification userInfo] objectForKey:NSFileHandleNotificationDataItem];
-    NSInteger	status;
+/*
+ * Data is waiting on the connection: read what there is with one readv() and hand it to expat slice by slice,
+ * straight from the read buffer.
+ */
+- (void)dataAvailable:(NSNotification *)aNotification {
+    NSInteger	bytesRead = [readBuffer readFromFileDescriptor:[connection fileDescriptor]];
+    
+    if (bytesRead < 0 && (errno == EINTR || errno == EAGAIN)) {
+        [connection waitForDataInBackgroundAndNotify];
+        return;
+    }
     
-    if ([data length] == 0) {
+    /* The delegate may let go of us when a stanza ends the stream */
+    [[self retain] autorelease];
+    
+    [readBuffer consumeSlicesUsingBlock:^(const unsigned char *bytes, NSUInteger sliceLength) {
+        NSAssert( INT_MAX >= sliceLength, @"Received too much data to parse" );
+        XML_Parse(parser, (const char *)bytes, (int)sliceLength, 0);
+    }];
+    
+    if (bytesRead <= 0) {
         if (connection != nil)
-           [[aNotification object] autorelease];
+           [connection autorelease];
         connection = nil;
         [delegate XMLConnectionClosed];
+        XML_Parse(parser, NULL, 0, 1);
+    } else if (connection != nil) {
+        [connection waitForDataInBackgroundAndNotify];
     }
-    
-    NSAssert( UINT_MAX >= [data length], @"Received too much data to parse" );
-    status = XML_Parse(parser, [data bytes], (unsigned int)[data length], [data length] == 0 ? 1 : 0);
-    
-    if (connection != nil)
-       [[aNotification object] waitForDataInBackgroundAndNotify];
-}
-
-- (void)dataAvailable:(NSNotification *)aNotification {
-    [[aNotification object] readInBackgroundAndNotify];
 }
 
 @synthesize delegate;
@@ -13,6 +13,7 @@
 @class AsyncSocket;
 @class AsyncReadPacket;
 @class AsyncWritePacket;
+@class AWEzvReadBuffer;
 
 extern NSString *const AsyncSocketException;
 extern NSString *const AsyncSocketErrorDomain;
@@ -110,6 +111,7 @@ typedef enum AsyncSocketError AsyncSocketError;
 	AsyncReadPacket *theCurrentRead;
 	NSTimer *theReadTimer;
 	NSMutableData *partialReadBuffer;
+	AWEzvReadBuffer *readBuffer;       // Bytes read from theReadStream but not yet claimed by a read
 	
 	NSMutableArray *theWriteQueue;
 	AsyncWritePacket *theCurrentWrite;
@@ -9,6 +9,7 @@
 //
 
 #import "AsyncSocket.h"
+#import "AWEzvReadBuffer.h"
 #import <sys/socket.h>
 #import <netinet/in.h>
 #import <arpa/inet.h>
@@ -18,7 +19,7 @@
 
 #define READQUEUE_CAPACITY	5           // Initial capacity
 #define WRITEQUEUE_CAPACITY 5           // Initial capacity
-#define READALL_CHUNKSIZE	256         // Incremental increase in buffer size
+#define READALL_CHUNKSIZE	256         // Incremental increase in buffer size (unreadData only)
 #define WRITE_CHUNKSIZE    (1024 * 4)   // Limit on size of each write pass
 
 NSString *const AsyncSocketException = @"AsyncSocketException";
@@ -83,6 +84,7 @@ enum AsyncSocketFlags
 
 // Reading
 - (void) doBytesAvailable;
+- (BOOL) fillCurrentReadFromBuffer;
 - (void) completeCurrentRead;
 - (void) endCurrentRead;
 - (void) scheduleDequeueRead;
@@ -125,6 +127,7 @@ static void MyCFWriteStreamCallback (CFWriteStreamRef stream, CFStreamEventType
 	NSTimeInterval timeout;
 	long tag;
 	NSData *term;
+	CFIndex termScanOffset;	// Where in the read buffer the terminator could next start
 	BOOL readAllAvailableData;
 }
 - (id)initWithData:(NSMutableData *)d
@@ -243,6 +246,7 @@ static void MyCFWriteStreamCallback (CFWriteStreamRef stream, CFStreamEventType
 	theReadTimer = nil;
 	
 	partialReadBuffer = nil;
+	readBuffer = [[AWEzvReadBuffer alloc] init];
 	
 	theWriteQueue = [[NSMutableArray alloc] initWithCapacity:WRITEQUEUE_CAPACITY];
 	theCurrentWrite = nil;
@@ -265,6 +269,7 @@ static void MyCFWriteStreamCallback (CFWriteStreamRef stream, CFStreamEventType
 	[self close];
 	[theReadQueue release];
 	[theWriteQueue release];
+	[readBuffer release];
 	[NSObject cancelPreviousPerformRequestsWithTarget:theDelegate selector:@selector(onSocketDidDisconnect:) object:self];
 	[NSObject cancelPreviousPerformRequestsWithTarget:self];
 	[super dealloc];
@@ -1077,6 +1082,9 @@ Failed:;
 		partialReadBuffer = [[NSMutableData alloc] initWithLength:0];
 	}
 	
+	// Bytes read from the stream which no read has claimed yet
+	[readBuffer appendBytesOfLength:[readBuffer length] toData:partialReadBuffer];
+	
 	[self emptyQueues];
 }
 
@@ -1097,6 +1105,7 @@ Failed:;
 	[self emptyQueues];
 	[partialReadBuffer release];
 	partialReadBuffer = nil;
+	[readBuffer removeAllBytes];
 	[NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(disconnect) object:nil];
 	
 	// Close streams.
@@ -1734,6 +1743,10 @@ Failed:;
 
 /**
  * This method is called when a new read is taken from the read queue or when new data becomes available on the stream.
+ * 
+ * Bytes are read from the stream a segment at a time into readBuffer, and the current read takes what it needs from
+ * there; whatever is left over waits for the next read. A fixed length read with nothing buffered reads straight
+ * into its own buffer.
 **/
 - (void)doBytesAvailable
 {
@@ -1742,24 +1755,29 @@ Failed:;
 	if(theCurrentRead != nil && theReadStream != NULL)
 	{
 		CFIndex totalBytesRead = 0;
-		BOOL error = NO, done = NO;
+		BOOL error = NO;
+		
+		// An earlier read may have left enough behind
+		BOOL done = [self fillCurrentReadFromBuffer];
+		
 		while(!done && !error && CFReadStreamHasBytesAvailable(theReadStream))
 		{
-			// If reading all available data, make sure there's room in the packet buffer.
-			if(theCurrentRead->readAllAvailableData == YES)
-				[theCurrentRead->buffer increaseLengthBy:READALL_CHUNKSIZE];
-
-			// If reading until data, just do one byte.
-			if(theCurrentRead->term != nil)
-				[theCurrentRead->buffer increaseLengthBy:1];
+			CFIndex bytesRead;
+			
+			if(theCurrentRead->term == nil && !theCurrentRead->readAllAvailableData && [readBuffer length] == 0)
+			{
+				// Number of bytes to read is space left in packet buffer.
+				CFIndex bytesToRead = [theCurrentRead->buffer length] - theCurrentRead->bytesDone;
+				UInt8 *packetbuf = (UInt8 *)( [theCurrentRead->buffer mutableBytes] + theCurrentRead->bytesDone );
+				
+				bytesRead = CFReadStreamRead(theReadStream, packetbuf, bytesToRead);
+				if(bytesRead > 0) theCurrentRead->bytesDone += bytesRead;
+			}
+			else
+			{
+				bytesRead = [readBuffer readFromStream:theReadStream];
+			}
 			
-			// Number of bytes to read is space left in packet buffer.
-			CFIndex bytesToRead = [theCurrentRead->buffer length] - theCurrentRead->bytesDone;
-
-			// Read data into packet buffer
-			UInt8 *packetbuf = (UInt8 *)( [theCurrentRead->buffer mutableBytes] + theCurrentRead->bytesDone );
-			CFIndex bytesRead = CFReadStreamRead(theReadStream, packetbuf, bytesToRead);
-						
 			// Check results
 			if(bytesRead < 0)
 			{
@@ -1767,34 +1785,11 @@ Failed:;
 			}
 			else
 			{
-				// Update total amound read for the current read
-				theCurrentRead->bytesDone += bytesRead;
-				
 				// Update total amount read in this method invocation
 				totalBytesRead += bytesRead;
+				
+				done = [self fillCurrentReadFromBuffer];
 			}
-
-			// Is packet done?
-			if(theCurrentRead->readAllAvailableData != YES)
-			{
-				if(theCurrentRead->term != nil)
-				{
-					// Search for the terminating sequence in the buffer.
-					NSInteger termlen = [theCurrentRead->term length];
-					if(theCurrentRead->bytesDone >= termlen)
-					{
-						const void *buf = [theCurrentRead->buffer bytes] + (theCurrentRead->bytesDone - termlen);
-						const void *seq = [theCurrentRead->term bytes];
-						done = (memcmp (buf, seq, termlen) == 0);
-					}
-				}
-				else
-				{
-					// Done when (sized) buffer is full.
-					done = ([theCurrentRead->buffer length] == theCurrentRead->bytesDone);
-				}
-			}
-			// else readAllAvailable doesn't end until all readable is read.
 		}
 		
 		if(theCurrentRead->readAllAvailableData && theCurrentRead->bytesDone > 0)
@@ -1805,7 +1800,7 @@ Failed:;
 			[self completeCurrentRead];
 			if (!error) [self scheduleDequeueRead];
 		}
-		else if(theCurrentRead->bytesDone > 0)
+		else if(totalBytesRead > 0)
 		{
 			// We're not done with the readToLength or readToData yet, but we have read in some bytes
 			if ([theDelegate respondsToSelector:@selector(onSocket:didReadPartialDataOfLength:tag:)])
@@ -1823,6 +1818,46 @@ Failed:;
 	}
 }
 
+/**
+ * Moves what the current read needs from readBuffer into the read's buffer, and returns whether the read is done.
+ * A read-all-data read takes everything buffered, but isn't done until the stream has nothing more.
+**/
+- (BOOL)fillCurrentReadFromBuffer
+{
+	if(theCurrentRead->readAllAvailableData)
+	{
+		[theCurrentRead->buffer setLength:theCurrentRead->bytesDone];
+		theCurrentRead->bytesDone += [readBuffer appendBytesOfLength:[readBuffer length] toData:theCurrentRead->buffer];
+		return NO;
+	}
+	
+	if(theCurrentRead->term != nil)
+	{
+		// Search for the terminating sequence in the buffer.
+		NSUInteger termlen = [theCurrentRead->term length];
+		NSUInteger offset = [readBuffer offsetOfData:theCurrentRead->term startingAt:theCurrentRead->termScanOffset];
+		
+		if(offset == NSNotFound)
+		{
+			// The terminator can only start in what may be the front of a partial match
+			if([readBuffer length] >= termlen)
+				theCurrentRead->termScanOffset = [readBuffer length] - termlen + 1;
+			return NO;
+		}
+		
+		[theCurrentRead->buffer setLength:theCurrentRead->bytesDone];
+		theCurrentRead->bytesDone += [readBuffer appendBytesOfLength:(offset + termlen) toData:theCurrentRead->buffer];
+		return YES;
+	}
+	
+	// Done when (sized) buffer is full.
+	CFIndex bytesToRead = [theCurrentRead->buffer length] - theCurrentRead->bytesDone;
+	UInt8 *packetbuf = (UInt8 *)( [theCurrentRead->buffer mutableBytes] + theCurrentRead->bytesDone );
+	
+	theCurrentRead->bytesDone += [readBuffer readBytes:packetbuf length:bytesToRead];
+	return ([theCurrentRead->buffer length] == theCurrentRead->bytesDone);
+}
+
 // Ends current read and calls delegate.
 - (void)completeCurrentRead
 {
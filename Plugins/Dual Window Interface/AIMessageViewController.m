@@ -52,7 +52,7 @@
 @interface AIMessageViewController ()
 - (id)initForChat:(AIChat *)inChat;
 - (void)chatStatusChanged:(NSNotification *)notification;
-- (void)chatParticipatingListObjectsChanged:(NSNotification *)notification;
+- (void)chatParticipantsDidChange:(NSNotification *)notification;
 - (void)_configureMessageDisplay;
 - (void)_createAccountSelectionView;
 - (void)_destroyAccountSelectionView;
@@ -118,8 +118,8 @@
 										   name:Chat_StatusChanged
 										 object:chat];
 		[[NSNotificationCenter defaultCenter] addObserver:self 
-									   selector:@selector(chatParticipatingListObjectsChanged:)
-										   name:Chat_ParticipatingListObjectsChanged
+									   selector:@selector(chatParticipantsDidChange:)
+										   name:Chat_ParticipantsDidChange
 										 object:chat];
 		[[NSNotificationCenter defaultCenter] addObserver:self
 									   selector:@selector(redisplaySourceAndDestinationSelector:) 
@@ -135,11 +135,11 @@
 		[adium.preferenceController registerPreferenceObserver:self forGroup:PREF_GROUP_DUAL_WINDOW_INTERFACE];
 
 		/* Update chat status and participating list objects to configure the user list if necessary
-		 * Call chatParticipatingListObjectsChanged first, which will set up the user list. This allows other sizing to match.
+		 * Call chatParticipantsDidChange first, which will set up the user list. This allows other sizing to match.
 		 */
 		[self setUserListVisible:(chat.isGroupChat && [self userListInitiallyVisible])];
 		
-		[self chatParticipatingListObjectsChanged:nil];
+		[self chatParticipantsDidChange:nil];
 		[self chatStatusChanged:nil];
 		
 		//Configure our views
@@ -1193,15 +1193,13 @@
 /*!
  * @brief Update the user list in response to changes
  *
- * This method is invoked when the chat's participating contacts change.  In resopnse, it sets correct visibility of
- * the user list, and updates the displayed users.
+ * This method is invoked once per run loop turn in which the chat's participants changed, after the chat has moved
+ * them to their sorted positions. In response, it updates the displayed users and the user count.
  */
-- (void)chatParticipatingListObjectsChanged:(NSNotification *)notification
+- (void)chatParticipantsDidChange:(NSNotification *)notification
 {
-	[chat resortParticipants];
-
-	/* Even if we're not viewing the user list, we can't risk it keeping stale information about potentially released objects */
-	[userListController reloadData];
+	/* Even if we're not viewing the user list, keep it current; it holds on to the participants it shows */
+	[userListController updateParticipantsWithChanges:[[notification userInfo] objectForKey:KEY_CHAT_PARTICIPANT_CHANGES]];
 
     if ([self userListVisible]) {
 		[self updateUserCount];
@@ -18,7 +18,9 @@
 
 @interface ESChatUserListController : AIAbstractListController
 {
-
+	NSMutableArray	*displayedParticipants;
 }
 
+- (void)updateParticipantsWithChanges:(NSArray *)changes;
+
 @end
@@ -15,16 +15,116 @@
  */
 
 #import "ESChatUserListController.h"
+#import <Adium/AIChat.h>
 #import <Adium/AIMenuControllerProtocol.h>
 #import <Adium/AIMetaContact.h>
 #import <Adium/AIService.h>
 #import <Adium/AIListContactGroupChatCell.h>
 #import <Adium/AIProxyListObject.h>
+#import <AIUtilities/AIArrayEditScript.h>
 #import "AIMessageTabViewItem.h"
 #import "AIListBookmark.h"
 
 @implementation ESChatUserListController
 
+- (void)dealloc
+{
+	[displayedParticipants release];
+
+	[super dealloc];
+}
+
+#pragma mark Participants
+
+/*!
+ * @brief The rows show a copy of the chat's participants, so the outline view can be told exactly what changed
+ */
+- (void)setContactListRoot:(ESObjectWithProperties<AIContainingObject> *)newContactListRoot
+{
+	[displayedParticipants release];
+	displayedParticipants = [newContactListRoot.containedObjects mutableCopy];
+
+	[super setContactListRoot:newContactListRoot];
+}
+
+- (void)reloadData
+{
+	[displayedParticipants setArray:contactList.containedObjects];
+
+	[super reloadData];
+}
+
+/*!
+ * @brief Bring the rows up to date with the chat's participants
+ *
+ * Only rows which joined, left or moved are inserted, removed or moved, and only rows whose name or flags changed are
+ * redrawn, rather than reloading the whole list for every change.
+ *
+ * @param changes The AIChatParticipantChanges from Chat_ParticipantsDidChange
+ */
+- (void)updateParticipantsWithChanges:(NSArray *)changes
+{
+	if (!hideRoot) {
+		[self reloadData];
+		return;
+	}
+
+	NSArray				*participants = contactList.containedObjects;
+	AIArrayEditScript	*script = [AIArrayEditScript editScriptFromArray:displayedParticipants toArray:participants];
+
+	if (!script.isEmpty) {
+		[displayedParticipants setArray:participants];
+
+		[contactListView beginUpdates];
+		if (script.removedIndexes.count) {
+			[contactListView removeItemsAtIndexes:script.removedIndexes inParent:nil withAnimation:NSTableViewAnimationEffectNone];
+		}
+		[script enumerateMovesUsingBlock:^(NSUInteger fromIndex, NSUInteger toIndex) {
+			[contactListView moveItemAtIndex:fromIndex inParent:nil toIndex:toIndex inParent:nil];
+		}];
+		if (script.insertedIndexes.count) {
+			[contactListView insertItemsAtIndexes:script.insertedIndexes inParent:nil withAnimation:NSTableViewAnimationEffectNone];
+		}
+		[contactListView endUpdates];
+	}
+
+	//Inserted rows are drawn fresh; the others only need redrawing if something shown in them changed
+	NSSet			*insertedContacts = [NSSet setWithArray:[participants objectsAtIndexes:script.insertedIndexes]];
+	NSMutableSet	*redrawnContacts = [NSMutableSet set];
+
+	for (AIChatParticipantChange *change in changes) {
+		if (change.type == AIChatParticipantLeft || [insertedContacts containsObject:change.contact] ||
+			[redrawnContacts containsObject:change.contact]) continue;
+
+		AIProxyListObject *proxyObject = [AIProxyListObject existingProxyListObjectForListObject:change.contact
+																					inListObject:contactList];
+		if (proxyObject) [contactListView reloadItem:proxyObject];
+
+		[redrawnContacts addObject:change.contact];
+	}
+}
+
+#pragma mark Outline View data source
+
+- (id)outlineView:(NSOutlineView *)outlineView child:(NSInteger)idx ofItem:(AIProxyListObject *)item
+{
+	if (!item && hideRoot) {
+		return [AIProxyListObject proxyListObjectForListObject:[displayedParticipants objectAtIndex:idx]
+												  inListObject:contactList];
+	}
+
+	return [super outlineView:outlineView child:idx ofItem:item];
+}
+
+- (NSInteger)outlineView:(NSOutlineView *)outlineView numberOfChildrenOfItem:(AIProxyListObject *)item
+{
+	if (!item && hideRoot) return displayedParticipants.count;
+
+	return [super outlineView:outlineView numberOfChildrenOfItem:item];
+}
+
+#pragma mark Selection
+
 /*!
  * @brief Notify our delegate when the selection changes.
  */
@@ -23,6 +23,8 @@
 	AIImageUploaderPlugin		*uploader;
 	
 	AIProgressDataUploader		*dataUploader;
+	NSString					*imagePath;
+	BOOL						cancelled;
 }
 
 @property (readonly, nonatomic) NSUInteger maximumSize;
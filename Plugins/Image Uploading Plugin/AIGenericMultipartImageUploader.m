@@ -21,6 +21,8 @@
 #import <AIUtilities/AIStringAdditions.h>
 #import <AIUtilities/AIProgressDataUploader.h>
 #import <AIUtilities/AIImageAdditions.h>
+#import <AIUtilities/AIImageTranscoder.h>
+#import <AIUtilities/AIMultipartFormBody.h>
 
 #define MULTIPART_FORM_BOUNDARY	@"bf5faadd239c17e35f91e6dafe1d2f96"
 
@@ -29,6 +31,8 @@
 		   uploader:(AIImageUploaderPlugin *)inUploader
 			   chat:(AIChat *)inChat;
 - (void)uploadImage;
+- (void)uploadFileAtPath:(NSString *)path MIMEType:(NSString *)MIMEType;
+- (void)removeImageFile;
 @end
 
 @implementation AIGenericMultipartImageUploader
@@ -93,6 +97,7 @@
 
 - (void)dealloc
 {
+	[self removeImageFile];
 	[dataUploader release]; dataUploader = nil;
 	[image release]; image = nil;
 	
@@ -108,6 +113,8 @@
 
 - (void)uploadCompleted:(id)context result:(NSData *)result
 {
+	[self removeImageFile];
+	
 	if (result.length) {
 		[self parseResponse:result];
 	} else {
@@ -117,64 +124,81 @@
 
 - (void)uploadFailed:(id)context
 {
+	[self removeImageFile];
 	[uploader errorWithMessage:AILocalizedString(@"Unable to upload", nil) forChat:chat];
 }
 
 #pragma mark Image upload
 
+/*!
+ * @brief Encode the image in the background, then upload it
+ *
+ * Only picking the bitmap to encode happens on the main thread; NSImage may not be used from other threads.
+ */
 - (void)uploadImage
 {
-	NSMutableData *body = [NSMutableData data];
-	
-	NSBitmapImageFileType bestType;
-	
-    NSData *pngRepresentation = [[image largestBitmapImageRep] representationUsingType:NSPNGFileType properties:@{}];
-	NSData *jpgRepresentation = [[image largestBitmapImageRep] representationUsingType:NSJPEGFileType properties:@{}];
-	NSData *imageRepresentation;
-	
-	if (pngRepresentation.length > jpgRepresentation.length) {
-		bestType = NSJPEGFileType;
-		imageRepresentation = jpgRepresentation;
-	} else {
-		bestType = NSPNGFileType;
-		imageRepresentation = pngRepresentation;
-	}
+	CGImageRef			cgImage = [[image largestBitmapImageRep] CGImage];
+	AIImageTranscoder	*transcoder = [[[AIImageTranscoder alloc] init] autorelease];
 	
-	if (imageRepresentation.length > self.maximumSize) {
-		imageRepresentation = [image representationWithFileType:bestType maximumFileSize:self.maximumSize];
-	}
-	
-	if (!imageRepresentation) {
+	if (!cgImage) {
 		[uploader errorWithMessage:AILocalizedString(@"Unable to upload", nil) forChat:chat];
 		return;
 	}
 	
-	[body appendData:[[NSString stringWithFormat:@"--%@\r\n", MULTIPART_FORM_BOUNDARY] dataUsingEncoding:NSUTF8StringEncoding]];
-	[body appendData:[[NSString stringWithFormat:@"Content-Disposition: form-data; name=\"%@\"; filename=\"image\"\r\n", self.fieldName] dataUsingEncoding:NSUTF8StringEncoding]];
-	[body appendData:[[NSString stringWithFormat:@"Content-Type: %@\r\n\r\n", (bestType == NSJPEGFileType) ? @"image/jpeg" : @"image/png"] dataUsingEncoding:NSUTF8StringEncoding]];
-	[body appendData:imageRepresentation];
-	[body appendData:[[NSString stringWithFormat:@"\r\n--%@--\r\n", MULTIPART_FORM_BOUNDARY] dataUsingEncoding:NSUTF8StringEncoding]];
+	transcoder.maximumFileSize = self.maximumSize;
+	
+	[self retain];
+	[transcoder transcodeImage:cgImage completion:^(NSString *path, NSString *MIMEType, unsigned long long length, NSError *error) {
+		if (cancelled) {
+			if (path) [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+		} else if (!path) {
+			[uploader errorWithMessage:AILocalizedString(@"Unable to upload", nil) forChat:chat];
+		} else {
+			imagePath = [path retain];
+			[self uploadFileAtPath:path MIMEType:MIMEType];
+		}
+		
+		[self release];
+	}];
+}
+
+/*!
+ * @brief Stream a multipart body with the additional fields and the image file
+ */
+- (void)uploadFileAtPath:(NSString *)path MIMEType:(NSString *)MIMEType
+{
+	AIMultipartFormBody *body = [[[AIMultipartFormBody alloc] initWithBoundary:MULTIPART_FORM_BOUNDARY] autorelease];
+	
 	for (NSDictionary *field in [self additionalFields]) {
-		[body appendData:[[NSString stringWithFormat:@"--%@\r\n", MULTIPART_FORM_BOUNDARY] dataUsingEncoding:NSUTF8StringEncoding]];
-		[body appendData:[[NSString stringWithFormat:@"Content-Disposition: form-data; name= \"%@\"\r\n\r\n", [field objectForKey:@"name"]] dataUsingEncoding:NSUTF8StringEncoding]];
-		[body appendData:[[NSString stringWithFormat:@"%@", [field objectForKey:@"value"]] dataUsingEncoding:NSUTF8StringEncoding]];
+		[body addFieldWithName:[field objectForKey:@"name"] value:[NSString stringWithFormat:@"%@", [field objectForKey:@"value"]]];
 	}
+	[body addFileAtPath:path name:self.fieldName fileName:@"image" contentType:MIMEType];
 	
-	NSDictionary *headers = [NSDictionary dictionaryWithObjectsAndKeys:
-							 [NSString stringWithFormat:@"multipart/form-data; boundary=%@", MULTIPART_FORM_BOUNDARY], @"Content-type", nil];
+	NSDictionary *headers = [NSDictionary dictionaryWithObjectsAndKeys:body.contentType, @"Content-type", nil];
 	
-	dataUploader = [[AIProgressDataUploader dataUploaderWithData:body
-															 URL:[NSURL URLWithString:self.uploadURL]
-														 headers:headers
-														delegate:self
-														 context:nil] retain];
+	dataUploader = [[AIProgressDataUploader dataUploaderWithStream:[body inputStream]
+															length:body.contentLength
+															   URL:[NSURL URLWithString:self.uploadURL]
+														   headers:headers
+														  delegate:self
+														   context:nil] retain];
 	
 	[dataUploader upload];
 }
 
+- (void)removeImageFile
+{
+	if (imagePath) {
+		[[NSFileManager defaultManager] removeItemAtPath:imagePath error:NULL];
+		[imagePath release]; imagePath = nil;
+	}
+}
+
 - (void)cancel
 {
+	cancelled = YES;
 	[dataUploader cancel];
+	[self removeImageFile];
 }
 
 @end
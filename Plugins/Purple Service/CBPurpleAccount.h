@@ -45,6 +45,8 @@
 	BOOL				shouldIncludeNowPlayingInformationInAllStatuses;
 
 	PurpleConnectionError lastDisconnectionReason;
+
+	AIListContact		*contactBeingUpdated;
 }
 
 - (const char*)protocolPlugin;
@@ -120,6 +122,9 @@
 - (void)removeContact:(AIListContact *)theContact fromGroupName:(NSString *)groupName;
 - (void)updateContact:(AIListContact *)theContact toAlias:(NSString *)purpleAlias;
 - (void)updateContact:(AIListContact *)theContact forEvent:(NSNumber *)event;
+- (void)beginUpdatesForContact:(AIListContact *)theContact;
+- (void)endUpdatesForContact:(AIListContact *)theContact;
+- (void)notifyOfChangedPropertiesOfContact:(AIListContact *)theContact;
 - (void)updateSignon:(AIListContact *)theContact withData:(void *)data;
 - (void)updateSignoff:(AIListContact *)theContact withData:(void *)data;
 - (void)updateSignonTime:(AIListContact *)theContact withData:(NSDate *)signonDate;
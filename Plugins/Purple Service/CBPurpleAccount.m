@@ -217,6 +217,35 @@ static SLPurpleCocoaAdapter *purpleAdapter = nil;
 {
 }		
 
+/*!
+ * @brief Make several updates to a contact and apply them together
+ *
+ * Until -endUpdatesForContact:, the update methods below set theContact's properties without applying them.
+ */
+- (void)beginUpdatesForContact:(AIListContact *)theContact
+{
+	contactBeingUpdated = theContact;
+}
+
+/*!
+ * @brief Apply the updates made since -beginUpdatesForContact: with one notification
+ */
+- (void)endUpdatesForContact:(AIListContact *)theContact
+{
+	contactBeingUpdated = nil;
+
+	[theContact notifyOfChangedPropertiesSilently:silentAndDelayed];
+}
+
+/*!
+ * @brief Apply changes to a contact's properties, unless they're to be applied together by -endUpdatesForContact:
+ */
+- (void)notifyOfChangedPropertiesOfContact:(AIListContact *)theContact
+{
+	if (theContact != contactBeingUpdated)
+		[theContact notifyOfChangedPropertiesSilently:silentAndDelayed];
+}
+
 
 //Signed online
 - (void)updateSignon:(AIListContact *)theContact withData:(void *)data
@@ -225,7 +254,7 @@ static SLPurpleCocoaAdapter *purpleAdapter = nil;
 				   notify:NotifyLater
 				 silently:silentAndDelayed];
 
-	[theContact notifyOfChangedPropertiesSilently:silentAndDelayed];
+	[self notifyOfChangedPropertiesOfContact:theContact];
 }
 
 //Signed offline
@@ -235,7 +264,7 @@ static SLPurpleCocoaAdapter *purpleAdapter = nil;
 				   notify:NotifyLater
 				 silently:silentAndDelayed];
 	
-	[theContact notifyOfChangedPropertiesSilently:silentAndDelayed];
+	[self notifyOfChangedPropertiesOfContact:theContact];
 }
 
 //Signon Time
@@ -245,7 +274,7 @@ static SLPurpleCocoaAdapter *purpleAdapter = nil;
 					   notify:NotifyLater];
 	
 	//Apply any changes
-	[theContact notifyOfChangedPropertiesSilently:silentAndDelayed];
+	[self notifyOfChangedPropertiesOfContact:theContact];
 }
 
 /*!
@@ -300,7 +329,7 @@ static SLPurpleCocoaAdapter *purpleAdapter = nil;
 	[theContact setIsMobile:isMobile notify:NotifyLater];
 
 	//Apply the change
-	[theContact notifyOfChangedPropertiesSilently:silentAndDelayed];
+	[self notifyOfChangedPropertiesOfContact:theContact];
 }
 
 //Idle time
@@ -309,7 +338,7 @@ static SLPurpleCocoaAdapter *purpleAdapter = nil;
 	[theContact setIdle:YES sinceDate:idleSinceDate notify:NotifyLater];
 
 	//Apply any changes
-	[theContact notifyOfChangedPropertiesSilently:silentAndDelayed];
+	[self notifyOfChangedPropertiesOfContact:theContact];
 }
 - (void)updateIdleReturn:(AIListContact *)theContact withData:(void *)data
 {
@@ -318,7 +347,7 @@ static SLPurpleCocoaAdapter *purpleAdapter = nil;
 				 notify:NotifyLater];
 
 	//Apply any changes
-	[theContact notifyOfChangedPropertiesSilently:silentAndDelayed];
+	[self notifyOfChangedPropertiesOfContact:theContact];
 }
 	
 //Evil level (warning level)
@@ -352,7 +381,7 @@ static SLPurpleCocoaAdapter *purpleAdapter = nil;
 								   notify:NotifyLater];
 		
 		//Apply any changes
-		[theContact notifyOfChangedPropertiesSilently:silentAndDelayed];
+		[self notifyOfChangedPropertiesOfContact:theContact];
 
 	} else {
 		/* We may receive an empty icon update just before an actual change. We don't want to flicker through no-icon.
@@ -35,6 +35,7 @@
 #import <Adium/AIUserIcons.h>
 #import <Adium/AIContactObserverManager.h>
 #import <AIUtilities/AIImageAdditions.h>
+#import <AIUtilities/AIHostResolver.h>
 
 #import <CoreFoundation/CoreFoundation.h>
 #import <libpurple/libpurple.h>
@@ -158,6 +159,9 @@ static void ZombieKiller_Signal(int i)
 
 - (void)networkDidChange:(NSNotification *)inNotification
 {
+	//Addresses looked up on the old network may not be right on the new one
+	[[AIHostResolver sharedResolver] flushCache];
+
 	purple_signal_emit(purple_network_get_handle(), "network-configuration-changed", NULL);
 }
 
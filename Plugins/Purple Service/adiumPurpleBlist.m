@@ -15,6 +15,7 @@
  */
 
 #import "adiumPurpleBlist.h"
+#import "adiumPurpleSignals.h"
 #import <AIUtilities/AIObjectAdditions.h>
 #import <Adium/AIListContact.h>
 
@@ -41,6 +42,7 @@ static void adiumPurpleBlistRemove(PurpleBuddyList *list, PurpleBlistNode *node)
     if (PURPLE_BLIST_NODE_IS_BUDDY(node)) {
 		PurpleBuddy	*buddy = (PurpleBuddy *)node;
 
+		forgetAdiumPurpleBuddyChanges(buddy);
 		[accountLookup(purple_buddy_get_account(buddy)) removeContact:contactLookupFromBuddy(buddy)];
 
 		//Clear the ui_data
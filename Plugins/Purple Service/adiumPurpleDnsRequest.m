@@ -17,6 +17,7 @@
 #import "adiumPurpleDnsRequest.h"
 
 #import <libpurple/internal.h>
+#import <AIUtilities/AIHostResolver.h>
 
 #import <sys/socket.h>
 #import <netdb.h>
@@ -25,14 +26,13 @@
 	PurpleDnsQueryData *query_data;
 	PurpleDnsQueryResolvedCallback resolved_cb;
 	PurpleDnsQueryFailedCallback failed_cb;
-	CFHostRef host;
-	BOOL finished_lookup;
+	AIHostResolution *resolution;
 }
 
 + (AdiumPurpleDnsRequest *)lookupRequestForData:(PurpleDnsQueryData *)query_data;
 - (id)initWithData:(PurpleDnsQueryData *)data resolvedCB:(PurpleDnsQueryResolvedCallback)resolved failedCB:(PurpleDnsQueryFailedCallback)failed;
 - (BOOL)startLookup;
-- (void)lookupFailedWithError:(const CFStreamError *)streamError;
+- (void)lookupFailedWithError:(NSError *)error;
 - (void)lookupSucceededWithAddresses:(NSArray *)addresses;
 - (void)cancel;
 @end
@@ -72,7 +72,6 @@ static NSMutableDictionary *lookupRequestsByQueryData = nil;
 	query_data = data;
 	resolved_cb = resolved;
 	failed_cb = failed;
-	finished_lookup = NO;
 
 	[lookupRequestsByQueryData setObject:self forKey:[NSValue valueWithPointer:query_data]];
 
@@ -84,8 +83,7 @@ static NSMutableDictionary *lookupRequestsByQueryData = nil;
 
 - (void)dealloc
 {
-	if (host)
-		CFRelease(host);
+	[resolution release];
 	
 	[super dealloc];
 }
@@ -95,36 +93,6 @@ static NSMutableDictionary *lookupRequestsByQueryData = nil;
 	return query_data;
 }
 
-/*!
- * @brief Called by CFHost when the resolve is complete or fails
- */
-static void host_client_cb(CFHostRef theHost, CFHostInfoType typeInfo,
-						   const CFStreamError *streamError,
-						   void *info)
-{
-	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
-	
-	AdiumPurpleDnsRequest *self = (AdiumPurpleDnsRequest *)info;
-	if (streamError && (streamError->error != 0)) {
-		[self lookupFailedWithError:streamError];
-
-	} else {
-		Boolean hasBeenResolved;
-
-		/* CFHostGetAddressing retrieves the known addresses from the given host. Returns a
-		 CFArrayRef of addresses.  Each address is a CFDataRef wrapping a struct sockaddr. */
-		CFArrayRef addresses = CFHostGetAddressing(theHost, &hasBeenResolved);
-		if (hasBeenResolved) {
-			[self lookupSucceededWithAddresses:(NSArray *)addresses];
-
-		} else {
-			[self lookupFailedWithError:NULL];
-		}
-	}
-	
-	[pool release];
-}
-
 /*!
  * @brief Lookup succeeded
  *
@@ -155,8 +123,6 @@ static void host_client_cb(CFHostRef theHost, CFHostInfoType typeInfo,
 		returnAddresses = g_slist_append(returnAddresses, addr_to_return);
 	}
 
-	finished_lookup = YES;
-
 	resolved_cb(query_data, returnAddresses);
 }
 
@@ -165,53 +131,42 @@ static void host_client_cb(CFHostRef theHost, CFHostInfoType typeInfo,
  *
  * This will call the failed callback provided by libpurple
  */
-- (void)lookupFailedWithError:(const CFStreamError *)streamError
+- (void)lookupFailedWithError:(NSError *)error
 {
-	AILogWithSignature(@"Failed lookup for %s. Error domain %lu, error %i",
+	AILogWithSignature(@"Failed lookup for %s. Error %ld",
 					   purple_dnsquery_get_host([self queryData]),
-					   (long)(streamError ? streamError->domain : 0),
-					   (streamError ? streamError->error : 0));
-
-	finished_lookup = YES;
+					   (long)[error code]);
 
 	//Failure :( Send an error message to the failed callback
 	char message[1024];
 	
 	g_snprintf(message, sizeof(message), _("Error resolving %s:\n%s"),
-			   purple_dnsquery_get_host(query_data), (streamError ? gai_strerror(streamError->error) : _("Unknown")));
+			   purple_dnsquery_get_host(query_data), (error ? gai_strerror((int)[error code]) : _("Unknown")));
 	failed_cb(query_data, message);	
 }
 
 /*!
  * @brief Begin an asynchronous lookup
  *
+ * The shared resolver answers from its cache, or joins a lookup of the same host already in progress, when it can.
+ *
  * @result YES if the lookup started successfully
  */
 - (BOOL)startLookup
 {
-	CFStreamError		streamError;
-	Boolean				success;
-	CFHostClientContext context =  { /* Version */ 0, /* info */ self, CFRetain, CFRelease, NULL};
-
 	AILogWithSignature(@"Performing DNS resolve: %s:%d",
 					   purple_dnsquery_get_host(query_data),
 					   purple_dnsquery_get_port(query_data));
-	
-	host = CFHostCreateWithName(kCFAllocatorDefault,
-								(CFStringRef)[NSString stringWithUTF8String:purple_dnsquery_get_host(query_data)]);
-	success = CFHostSetClient(host, host_client_cb, &context);
 
-	if (!success) {
-		[self lookupFailedWithError:NULL];
-		return TRUE;
-	}
+	//The handler retains us until it is called or the resolution is cancelled
+	resolution = [[[AIHostResolver sharedResolver] resolveHostName:[NSString stringWithUTF8String:purple_dnsquery_get_host(query_data)]
+														   handler:^(NSArray *addresses, NSError *error) {
+		if (error)
+			[self lookupFailedWithError:error];
+		else
+			[self lookupSucceededWithAddresses:addresses];
+	}] retain];
 
-	CFHostScheduleWithRunLoop(host, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
-
-	success = CFHostStartInfoResolution(host, kCFHostAddresses, &streamError);
-	if (!success)
-		[self lookupFailedWithError:&streamError];
-	
 	return TRUE;
 }
 
@@ -223,11 +178,6 @@ static void host_client_cb(CFHostRef theHost, CFHostInfoType typeInfo,
  */
 - (void)_finishDnsRequest
 {
-	if (host) {
-		CFHostUnscheduleFromRunLoop(host, CFRunLoopGetCurrent(), kCFRunLoopDefaultMode);
-		CFHostSetClient(host, /* callback */ NULL, /* context */ NULL);
-	}
-
 	/* Immediately remove ourselves from the global lookup dictionary so we won't be double-released */
 	if (query_data) {
 		[lookupRequestsByQueryData removeObjectForKey:[NSValue valueWithPointer:query_data]];
@@ -243,8 +193,7 @@ static void host_client_cb(CFHostRef theHost, CFHostInfoType typeInfo,
  */
 - (void)cancel
 {
-	if (!finished_lookup && host)
-		CFHostCancelInfoResolution(host, kCFHostAddresses);
+	[resolution cancel];
 
 	[self _finishDnsRequest];
 }
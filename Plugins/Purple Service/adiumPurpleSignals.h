@@ -17,3 +17,8 @@
 #import <AdiumLibpurple/SLPurpleCocoaAdapter.h>
 
 void configureAdiumPurpleSignals(void);
+
+/*!
+ * @brief Drop the buddy's changes which haven't been applied yet. Call before the buddy is freed.
+ */
+void forgetAdiumPurpleBuddyChanges(PurpleBuddy *buddy);
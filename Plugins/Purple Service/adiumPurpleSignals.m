@@ -17,153 +17,45 @@
 #import "adiumPurpleSignals.h"
 #import <AIUtilities/AIObjectAdditions.h>
 #import <AIUtilities/AIAttributedStringAdditions.h>
+#import <AIUtilities/AIChangeCoalescer.h>
 #import <Adium/AIChatControllerProtocol.h>
 #import <Adium/AIChat.h>
 #import <Adium/AIListContact.h>
 #import <Adium/ESFileTransfer.h>
 
-static void buddy_status_changed_cb(PurpleBuddy *buddy, PurpleStatus *oldstatus, PurpleStatus *status, PurpleBuddyEvent event);
-static void buddy_idle_changed_cb(PurpleBuddy *buddy, gboolean old_idle, gboolean idle, PurpleBuddyEvent event);
+/* Buddy events are coalesced: each signal only notes what changed for its buddy, and once per run loop turn
+ * apply_buddy_changes() reads each changed buddy's presence and applies everything to its contact at once.
+ * A signon, for example, arrives as separate signon, status, idle, login time and often icon signals.
+ */
+enum {
+	AIBuddySignedOnOrOff		= 1 << 0,
+	AIBuddyStatusChanged		= 1 << 1,
+	AIBuddyIdleChanged			= 1 << 2,
+	AIBuddySignonTimeChanged	= 1 << 3,
+	AIBuddyIconChanged			= 1 << 4
+};
 
-static void buddy_event_cb(PurpleBuddy *buddy, PurpleBuddyEvent event)
-{
-	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
-	
-	if (buddy) {
-		SEL				updateSelector = nil;
-		id				data = nil;
-		BOOL			letAccountHandleUpdate = YES;
-		CBPurpleAccount	*account = accountLookup(purple_buddy_get_account(buddy));
-		AIListContact   *theContact = contactLookupFromBuddy(buddy);
-
-		switch (event) {
-			case PURPLE_BUDDY_SIGNON: {
-				updateSelector = @selector(updateSignon:withData:);
-				break;
-			}
-			case PURPLE_BUDDY_SIGNOFF: {
-				updateSelector = @selector(updateSignoff:withData:);
-				break;
-			}
-			case PURPLE_BUDDY_SIGNON_TIME: {
-				PurplePresence	*presence = purple_buddy_get_presence(buddy);
-				time_t			loginTime = purple_presence_get_login_time(presence);
-				
-				updateSelector = @selector(updateSignonTime:withData:);
-				data = (loginTime ? [NSDate dateWithTimeIntervalSince1970:loginTime] : nil);
-
-				break;
-			}
-
-			case PURPLE_BUDDY_EVIL: {
-				updateSelector = @selector(updateEvil:withData:);
-				//This is an update of the AIM Warning Level. We really, really don't care.
-				/*
-				if (buddy->evil) {
-					data = [NSNumber numberWithInt:buddy->evil];
-				}
-				 */
-				break;
-			}
-			case PURPLE_BUDDY_ICON: {
-				PurpleBuddyIcon *buddyIcon = purple_buddy_get_icon(buddy);
-				updateSelector = @selector(updateIcon:withData:);
-				AILog(@"Buddy icon update for %s",purple_buddy_get_name(buddy));
-				if (buddyIcon) {
-					const guchar  *iconData;
-					size_t		len;
-					
-					iconData = purple_buddy_icon_get_data(buddyIcon, &len);
-					
-					if (iconData && len) {
-						data = [NSData dataWithBytes:iconData
-											  length:len];
-						AILog(@"[buddy icon: %s got data]",purple_buddy_get_name(buddy));
-					}
-				}
-				break;
-			}
-			case PURPLE_BUDDY_NAME: {
-				updateSelector = @selector(renameContact:toUID:);
-
-				data = [NSString stringWithUTF8String:purple_buddy_get_name(buddy)];
-				AILog(@"Renaming %@ to %@",theContact,data);
-				break;
-			}
-			default: {
-				data = [NSNumber numberWithInteger:event];
-				break;
-			}
-		}
-		
-		if (letAccountHandleUpdate) {
-			if (updateSelector) {
-				[account performSelector:updateSelector
-							  withObject:theContact
-							  withObject:data];
-			} else {
-				[account updateContact:theContact
-							  forEvent:data];
-			}
-		}
-		
-		/* If a status event didn't change from its previous value, we won't be notified of it.
-		 * That's generally a good thing, but we clear some values when a contact signs off, including
-		 * status, idle time, and signed-on time.  Manually update these as appropriate when we're informed of
-		 * a signon.
-		 */
-		if ((event == PURPLE_BUDDY_SIGNON) || (event == PURPLE_BUDDY_SIGNOFF)) {
-			PurplePresence	*presence = purple_buddy_get_presence(buddy);
-			PurpleStatus		*status = purple_presence_get_active_status(presence);
-			buddy_status_changed_cb(buddy, NULL, status, event);
-			
-			if (event == PURPLE_BUDDY_SIGNON) {
-				buddy_idle_changed_cb(buddy, FALSE, purple_presence_is_idle(presence), event);
-				buddy_event_cb(buddy, PURPLE_BUDDY_SIGNON_TIME);
-			}
-		}
-	}
-	
-	[pool release];
-}
+static AIChangeCoalescer *buddyChanges = nil;
 
-static void buddy_status_changed_cb(PurpleBuddy *buddy, PurpleStatus *oldstatus, PurpleStatus *status, PurpleBuddyEvent event)
+static void update_status(CBPurpleAccount *account, AIListContact *theContact, PurpleBuddy *buddy, PurplePresence *presence)
 {
-	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
-	CBPurpleAccount		*account = accountLookup(purple_buddy_get_account(buddy));
-	AIListContact		*theContact = contactLookupFromBuddy(buddy);
-	NSNumber			*statusTypeNumber;
-	NSString			*statusName;
-	NSAttributedString	*statusMessage;	
+	PurpleStatus		*status = purple_presence_get_active_status(presence);
+	PurpleStatusPrimitive	primitive = purple_status_type_get_primitive(purple_status_get_type(status));
 	BOOL				isAvailable, isMobile;
 
-	isAvailable = ((purple_status_type_get_primitive(purple_status_get_type(status)) == PURPLE_STATUS_AVAILABLE) ||
-				   (purple_status_type_get_primitive(purple_status_get_type(status)) == PURPLE_STATUS_OFFLINE));
-	isMobile = purple_presence_is_status_primitive_active(purple_buddy_get_presence(buddy), PURPLE_STATUS_MOBILE);
-	statusTypeNumber = [NSNumber numberWithInteger:(isAvailable ? 
-												AIAvailableStatusType : 
-												AIAwayStatusType)];
+	isAvailable = ((primitive == PURPLE_STATUS_AVAILABLE) || (primitive == PURPLE_STATUS_OFFLINE));
+	isMobile = purple_presence_is_status_primitive_active(presence, PURPLE_STATUS_MOBILE);
 
-	statusName = [account statusNameForPurpleBuddy:buddy];
-	statusMessage = [account statusMessageForPurpleBuddy:buddy];
-
-	//Will also notify
 	[account updateStatusForContact:theContact
-					   toStatusType:statusTypeNumber
-						 statusName:statusName
-					  statusMessage:statusMessage
+					   toStatusType:[NSNumber numberWithInteger:(isAvailable ? AIAvailableStatusType : AIAwayStatusType)]
+						 statusName:[account statusNameForPurpleBuddy:buddy]
+					  statusMessage:[account statusMessageForPurpleBuddy:buddy]
 						   isMobile:isMobile];
-	[pool release];
 }
 
-static void buddy_idle_changed_cb(PurpleBuddy *buddy, gboolean old_idle, gboolean idle, PurpleBuddyEvent event)
+static void update_idle(CBPurpleAccount *account, AIListContact *theContact, PurplePresence *presence)
 {
-	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
-	CBPurpleAccount	*account = accountLookup(purple_buddy_get_account(buddy));
-	AIListContact	*theContact = contactLookupFromBuddy(buddy);
-	PurplePresence	*presence = purple_buddy_get_presence(buddy);
-				
-	if (idle) {
+	if (purple_presence_is_idle(presence)) {
 		time_t		idleTime = purple_presence_get_idle_time(presence);
 
 		[account updateWentIdle:theContact
@@ -174,8 +66,109 @@ static void buddy_idle_changed_cb(PurpleBuddy *buddy, gboolean old_idle, gboolea
 		[account updateIdleReturn:theContact
 						 withData:nil];
 	}
-	
-	[pool release];
+}
+
+static void update_icon(CBPurpleAccount *account, AIListContact *theContact, PurpleBuddy *buddy)
+{
+	PurpleBuddyIcon *buddyIcon = purple_buddy_get_icon(buddy);
+	NSData			*data = nil;
+
+	AILog(@"Buddy icon update for %s",purple_buddy_get_name(buddy));
+	if (buddyIcon) {
+		const guchar  *iconData;
+		size_t		len;
+		
+		iconData = purple_buddy_icon_get_data(buddyIcon, &len);
+		
+		if (iconData && len) {
+			//Only the icon the buddy has by the end of the run loop turn is copied
+			data = [NSData dataWithBytes:iconData
+								  length:len];
+			AILog(@"[buddy icon: %s got data]",purple_buddy_get_name(buddy));
+		}
+	}
+
+	[account updateIcon:theContact withData:data];
+}
+
+static void apply_buddy_changes(PurpleBuddy *buddy, NSUInteger changes)
+{
+	CBPurpleAccount	*account = accountLookup(purple_buddy_get_account(buddy));
+	AIListContact   *theContact = contactLookupFromBuddy(buddy);
+	PurplePresence	*presence = purple_buddy_get_presence(buddy);
+	BOOL			online = purple_presence_is_online(presence);
+
+	/* If a status event didn't change from its previous value, we won't be notified of it.
+	 * That's generally a good thing, but we clear some values when a contact signs off, including
+	 * status, idle time, and signed-on time.  Manually update these as appropriate when we're informed of
+	 * a signon.
+	 */
+	if (changes & AIBuddySignedOnOrOff) {
+		changes |= AIBuddyStatusChanged;
+		if (online) changes |= (AIBuddyIdleChanged | AIBuddySignonTimeChanged);
+	}
+
+	[account beginUpdatesForContact:theContact];
+
+	//Signing off and back on within one turn leaves the contact online
+	if (changes & AIBuddySignedOnOrOff) {
+		if (online)
+			[account updateSignon:theContact withData:NULL];
+		else
+			[account updateSignoff:theContact withData:NULL];
+	}
+
+	if (changes & AIBuddyStatusChanged) update_status(account, theContact, buddy, presence);
+	if (changes & AIBuddyIdleChanged) update_idle(account, theContact, presence);
+
+	if (changes & AIBuddySignonTimeChanged) {
+		time_t loginTime = purple_presence_get_login_time(presence);
+
+		[account updateSignonTime:theContact
+						 withData:(loginTime ? [NSDate dateWithTimeIntervalSince1970:loginTime] : nil)];
+	}
+
+	if (changes & AIBuddyIconChanged) update_icon(account, theContact, buddy);
+
+	[account endUpdatesForContact:theContact];
+}
+
+static void note_buddy_changes(PurpleBuddy *buddy, NSUInteger changes)
+{
+	if (buddy) [buddyChanges addChanges:changes forKey:buddy];
+}
+
+void forgetAdiumPurpleBuddyChanges(PurpleBuddy *buddy)
+{
+	[buddyChanges removeKey:buddy];
+}
+
+static void buddy_event_cb(PurpleBuddy *buddy, PurpleBuddyEvent event)
+{
+	switch (event) {
+		case PURPLE_BUDDY_SIGNON:
+		case PURPLE_BUDDY_SIGNOFF:
+			note_buddy_changes(buddy, AIBuddySignedOnOrOff);
+			break;
+		case PURPLE_BUDDY_SIGNON_TIME:
+			note_buddy_changes(buddy, AIBuddySignonTimeChanged);
+			break;
+		case PURPLE_BUDDY_ICON:
+			note_buddy_changes(buddy, AIBuddyIconChanged);
+			break;
+		default:
+			break;
+	}
+}
+
+static void buddy_status_changed_cb(PurpleBuddy *buddy, PurpleStatus *oldstatus, PurpleStatus *status)
+{
+	note_buddy_changes(buddy, AIBuddyStatusChanged);
+}
+
+static void buddy_idle_changed_cb(PurpleBuddy *buddy, gboolean old_idle, gboolean idle)
+{
+	note_buddy_changes(buddy, AIBuddyIdleChanged);
 }
 
 //This is called when a buddy is added or changes groups
@@ -210,7 +203,7 @@ static void buddy_added_cb(PurpleBuddy *buddy)
 		}
 		
 		// Force a status update for the user. Useful for things like XMPP which might display an error message for an offline contact.
-		buddy_status_changed_cb(buddy, NULL, purple_presence_get_active_status(purple_buddy_get_presence(buddy)), PURPLE_BUDDY_NONE);
+		note_buddy_changes(buddy, AIBuddyStatusChanged);
 	}
 	[pool release];
 }
@@ -418,6 +411,14 @@ void configureAdiumPurpleSignals(void)
 	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
 	void *blist_handle = purple_blist_get_handle();
 	void *handle       = adium_purple_get_handle();
+
+	if (!buddyChanges) {
+		buddyChanges = [[AIChangeCoalescer alloc] initWithHandler:^(void *buddy, NSUInteger changes) {
+			NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+			apply_buddy_changes((PurpleBuddy *)buddy, changes);
+			[pool release];
+		}];
+	}
 	
 	//Idle
 	purple_signal_connect(blist_handle, "buddy-idle-changed",
@@ -445,10 +446,6 @@ void configureAdiumPurpleSignals(void)
 						handle, PURPLE_CALLBACK(buddy_event_cb),
 						GINT_TO_POINTER(PURPLE_BUDDY_SIGNON_TIME));	
 
-	purple_signal_connect(blist_handle, "buddy-got-login-time",
-						  handle, PURPLE_CALLBACK(buddy_event_cb),
-						  GINT_TO_POINTER(PURPLE_BUDDY_SIGNON_TIME));	
-
 	purple_signal_connect(blist_handle, "buddy-added",
 						  handle, PURPLE_CALLBACK(buddy_added_cb),
 						  NULL);
@@ -583,13 +583,15 @@
 /*!
  * @brief List Observer delegate method
  *
- * Updates the menu icon if our accounts change connecting state.
+ * Updates the menu icon if our accounts change connecting state or go idle. Idleness doesn't change the active
+ * status state, so it doesn't come with AIStatusActiveStateChangedNotification.
  */
 - (NSSet *)updateListObject:(AIListObject *)inObject keys:(NSSet *)inModifiedKeys silent:(BOOL)silent
 {
 	if ([inObject isKindOfClass:[AIAccount class]]) {
 		if ([inModifiedKeys containsObject:@"isConnecting"] ||
-			[inModifiedKeys containsObject:@"waitingToReconnect"]) {
+			[inModifiedKeys containsObject:@"waitingToReconnect"] ||
+			[inModifiedKeys containsObject:@"idleSince"]) {
 			[self updateMenuIcons];
 		}
 	}
@@ -113,6 +113,14 @@
 	return [[self preferenceForKey:LACONICA_PREFERENCE_SSL group:LACONICA_PREF_GROUP] boolValue];
 }
 
+/*!
+ * @brief Our link addresses are built from preferences, which may only be read on the main thread.
+ */
+- (BOOL)canParseStatusesInBackground
+{
+	return NO;
+}
+
 /*!
  * @brief Laconica does not yet support OAuth.
  */
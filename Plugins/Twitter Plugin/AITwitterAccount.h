@@ -88,6 +88,8 @@ typedef enum {
 #define TWITTER_UPDATE_REPLIES_COUNT		20
 #define TWITTER_UPDATE_USER_INFO_COUNT		10
 
+#define TWITTER_TIMELINE_DISPLAY_BATCH_SIZE	50
+
 #define TWITTER_INCORRECT_PASSWORD_MESSAGE	AILocalizedString(@"Incorrect username or password","Error message displayed when the server reports username or password as being incorrect.")
 #define TWITTER_OAUTH_NOT_AUTHORIZED		AILocalizedString(@"Adium isn't allowed access to your account.", "Error message displayed when the server reports that our access has been revoked or invalid.")
 
@@ -159,6 +161,10 @@ typedef enum {
 	NSString			*futureTimelineLastID;
 	NSString			*futureRepliesLastID;
 	
+	dispatch_queue_t	timelineQueue;
+	NSDateFormatter		*timelineDateFormatter;
+	NSUInteger			timelineGeneration;
+	
 	NSMutableDictionary	*pendingRequests;
 }
 
@@ -172,6 +178,7 @@ typedef enum {
 @property (readonly, nonatomic) BOOL useSSL;
 @property (readonly, nonatomic) BOOL useOAuth;
 @property (readonly, nonatomic) BOOL supportsCursors;
+@property (readonly, nonatomic) BOOL canParseStatusesInBackground;
 @property (weak, readonly, nonatomic) NSString *consumerKey;
 @property (weak, readonly, nonatomic) NSString *secretKey;
 @property (weak, readonly, nonatomic) NSString *tokenRequestURL;
@@ -56,6 +56,9 @@
 
 - (void)periodicUpdate;
 - (void)displayQueuedUpdatesForRequestType:(AITwitterRequestType)requestType;
+- (NSArray *)preparedUpdatesFromStatuses:(NSArray *)statuses parseMessages:(BOOL)parseMessages;
+- (void)displayPreparedUpdates:(NSArray *)preparedUpdates trackContent:(BOOL)trackContent;
+- (NSAttributedString *)messageForStatus:(NSDictionary *)status retweeter:(NSString *)retweeter;
 
 - (void)getRateLimitAmount;
 
@@ -78,6 +81,13 @@
 	queuedOutgoingDM = [[NSMutableArray alloc] init];
 	supportsCursors = YES;
 	
+	timelineQueue = dispatch_queue_create("im.adium.AITwitterAccount.timelineQueue", 0);
+	
+	// Only used on timelineQueue
+	timelineDateFormatter = [[NSDateFormatter alloc] init];
+	[timelineDateFormatter setLocale:[[[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"] autorelease]];
+	[timelineDateFormatter setDateFormat:@"EEE MMM dd HH:mm:ss Z yyyy"];
+	
 	[[NSNotificationCenter defaultCenter] addObserver:self
 											 selector:@selector(chatDidOpen:)
 												 name:Chat_DidOpen
@@ -118,6 +128,8 @@
 	[queuedUpdates release];
 	[queuedDM release];
 	[queuedOutgoingDM release];
+	[timelineDateFormatter release];
+	dispatch_release(timelineQueue);
 	
 	[super dealloc];
 }
@@ -311,6 +323,9 @@
 	[queuedOutgoingDM removeAllObjects];
 	[queuedUpdates removeAllObjects];
 	
+	// Drop anything still making its way through the timeline queue
+	timelineGeneration++;
+	
 	[super didDisconnect];
 }
 
@@ -352,6 +367,16 @@
 	return YES;
 }
 
+/*!
+ * @brief Returns whether statuses can be parsed into messages on the timeline queue.
+ *
+ * Subclasses whose link addresses depend on preferences must parse on the main thread.
+ */
+- (BOOL)canParseStatusesInBackground
+{
+	return YES;
+}
+
 /*!
  * @brief Returns whether or not this account is connected via an encrypted connection.
  */
@@ -1809,37 +1834,158 @@ NSInteger queuedDMSort(id dm1, id dm2, void *context)
 	return [[dm1 objectForKey:TWITTER_DM_CREATED] compare:[dm2 objectForKey:TWITTER_DM_CREATED]];
 }
 
+#define KEY_PREPARED_STATUS		@"Status"
+#define KEY_PREPARED_RETWEETER	@"Retweeter"
+#define KEY_PREPARED_MESSAGE	@"Message"
+
+/*!
+ * @brief Parse a status's creation date. Timeline queue only.
+ */
+- (NSDate *)dateFromStatusDateString:(NSString *)dateString
+{
+	NSDate *date = [timelineDateFormatter dateFromString:dateString];
+	
+	// Not every StatusNet server uses Twitter's format.
+	if (!date)
+		date = [NSDate dateWithNaturalLanguageString:dateString];
+	
+	return date;
+}
+
 /*!
- * @brief Remove duplicate status updates.
+ * @brief Prepare status updates for display. Timeline queue only.
  *
- * If we're following someone who replies to us, we'll receive a status update in both the
- * timeline and the reply feed.
+ * Drops duplicates: if we're following someone who replies to us, we'll receive a status update in
+ * both the timeline and the reply feed. The result is sorted oldest first.
  *
- * @param inArray The sorted array of Tweets
+ * @param statuses The statuses as received from the server
+ * @param parseMessages If YES, the message for each update is built here, too
+ * @result An array of dictionaries containing the date, status, retweeter, and (optionally) message
+ */
+- (NSArray *)preparedUpdatesFromStatuses:(NSArray *)statuses parseMessages:(BOOL)parseMessages
+{
+	NSMutableArray	*preparedUpdates = [NSMutableArray arrayWithCapacity:statuses.count];
+	NSMutableSet	*seenTweetIDs = [NSMutableSet setWithCapacity:statuses.count];
+	
+	for (NSDictionary *status in statuses) {
+		NSString *tweetID = [status objectForKey:TWITTER_STATUS_ID];
+		
+		if (tweetID) {
+			if ([seenTweetIDs containsObject:tweetID])
+				continue;
+			
+			[seenTweetIDs addObject:tweetID];
+		}
+		
+		NSDate *date = [self dateFromStatusDateString:[status objectForKey:TWITTER_STATUS_CREATED]];
+		if (!date)
+			date = [NSDate date];
+		
+		NSDictionary *retweet = [status objectForKey:TWITTER_STATUS_RETWEET];
+		NSString *retweeter = nil;
+		if (retweet && [retweet isKindOfClass:[NSDictionary class]]) {
+			retweeter = [[status objectForKey:TWITTER_STATUS_USER] objectForKey:TWITTER_STATUS_UID];
+			status = retweet;
+		}
+		
+		NSMutableDictionary *preparedUpdate = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+											   date, TWITTER_STATUS_CREATED,
+											   status, KEY_PREPARED_STATUS, nil];
+		if (retweeter)
+			[preparedUpdate setObject:retweeter forKey:KEY_PREPARED_RETWEETER];
+		if (parseMessages)
+			[preparedUpdate setObject:[self messageForStatus:status retweeter:retweeter] forKey:KEY_PREPARED_MESSAGE];
+		
+		[preparedUpdates addObject:preparedUpdate];
+	}
+	
+	// Sort the updates (since we're intermingling pages of data from different souces)
+	[preparedUpdates sortUsingFunction:queuedUpdatesSort context:nil];
+	
+	return preparedUpdates;
+}
+
+/*!
+ * @brief Build the message for a status, including a link to the retweeter if there is one
  */
-- (NSArray *)arrayWithDuplicateTweetsRemoved:(NSArray *)inArray
+- (NSAttributedString *)messageForStatus:(NSDictionary *)status retweeter:(NSString *)retweeter
 {
-	NSMutableArray *mutableArray = [inArray mutableCopy];
+	NSAttributedString *message = [self parseStatus:status
+											tweetID:[status objectForKey:TWITTER_STATUS_ID]
+											 userID:[[status objectForKey:TWITTER_STATUS_USER] objectForKey:TWITTER_STATUS_UID]
+									  inReplyToUser:[status objectForKey:TWITTER_STATUS_REPLY_UID]
+								   inReplyToTweetID:[status objectForKey:TWITTER_STATUS_REPLY_ID]];
 	
-	NSDictionary *status = nil, *previousStatus = nil;
+	//Add a link to the retweeter
+	if (retweeter) {
+		NSMutableAttributedString *m = [[message mutableCopy] autorelease];
+		NSString *linkURL = [self addressForLinkType:AITwitterLinkUserPage
+											  userID:retweeter
+											statusID:nil
+											 context:nil];
+		NSAttributedString *rt = [NSAttributedString attributedStringWithString:[NSString stringWithFormat:@" [@%@]", retweeter]
+																	  linkRange:NSMakeRange(2, retweeter.length+1)
+																linkDestination:linkURL];
+		[m appendAttributedString:rt];
+		message = m;
+	}
 	
-	// Starting at index 1, checking backwards. We'll never exceed bounds this way.
-	for(NSUInteger idx = 1; idx < inArray.count; idx++)
-	{
-		status = [inArray objectAtIndex:idx];
-		previousStatus = [inArray objectAtIndex:idx-1];
+	return message;
+}
+
+/*!
+ * @brief Display one batch of prepared updates in the timeline chat
+ */
+- (void)displayPreparedUpdates:(NSArray *)preparedUpdates trackContent:(BOOL)trackContent
+{
+	AIChat *timelineChat = self.timelineChat;
+	
+	[[AIContactObserverManager sharedManager] delayListObjectNotifications];
+	
+	for (NSDictionary *preparedUpdate in preparedUpdates) {
+		NSDate *date = [preparedUpdate objectForKey:TWITTER_STATUS_CREATED];
+		NSDictionary *status = [preparedUpdate objectForKey:KEY_PREPARED_STATUS];
+		NSAttributedString *message = [preparedUpdate objectForKey:KEY_PREPARED_MESSAGE];
+		
+		if (!message)
+			message = [self messageForStatus:status retweeter:[preparedUpdate objectForKey:KEY_PREPARED_RETWEETER]];
 		
-		if([[status objectForKey:TWITTER_STATUS_ID] isEqualToString:[previousStatus objectForKey:TWITTER_STATUS_ID]]) {
-			[mutableArray removeObject:status];
+		NSString *contactUID = [[status objectForKey:TWITTER_STATUS_USER] objectForKey:TWITTER_STATUS_UID];
+		id fromObject = nil;
+		
+		if (![self.UID isCaseInsensitivelyEqualToString:contactUID]) {
+			AIListContact *listContact = [self contactWithUID:contactUID];
+			
+			[self updateContact:listContact withInfo:[status objectForKey:TWITTER_STATUS_USER] andStatusMessage:message];
+			
+			[timelineChat addParticipatingListObject:listContact notify:NotifyNow];
+			
+			fromObject = (id)listContact;
+		} else {
+			fromObject = (id)self;
 		}
+		
+		AIContentMessage *contentMessage = [AIContentMessage messageInChat:timelineChat
+																withSource:fromObject
+															   destination:self
+																	  date:date
+																   message:message
+																 autoreply:NO];
+		
+		contentMessage.trackContent = trackContent;
+		
+		[adium.contentController receiveContentObject:contentMessage];
 	}
 	
-	return [mutableArray autorelease];
+	[[AIContactObserverManager sharedManager] endListObjectNotificationsDelay];
 }
 
 /*!
  * @brief Display queued updates or direct messages
  *
+ * Status updates are dated, deduplicated, sorted and (where possible) parsed on the timeline queue,
+ * then handed back to the main thread in batches so a large backlog doesn't stall the interface.
+ *
  * This could potentially be simplified since both DMs and updates have the same format.
  */
 - (void)displayQueuedUpdatesForRequestType:(AITwitterRequestType)requestType
@@ -1851,77 +1997,46 @@ NSInteger queuedDMSort(id dm1, id dm2, void *context)
 		
 		AILogWithSignature(@"%@ Displaying %lu updates", self, (unsigned long)queuedUpdates.count);
 		
-		// Sort the queued updates (since we're intermingling pages of data from different souces)
-		NSArray *sortedQueuedUpdates = [queuedUpdates sortedArrayUsingFunction:queuedUpdatesSort context:nil];
-		
-		sortedQueuedUpdates = [self arrayWithDuplicateTweetsRemoved:sortedQueuedUpdates];
+		NSArray *statuses = [[queuedUpdates copy] autorelease];
+		[queuedUpdates removeAllObjects];
 		
 		BOOL trackContent = [[self preferenceForKey:TWITTER_PREFERENCE_EVER_LOADED_TIMELINE group:TWITTER_PREFERENCE_GROUP_UPDATES] boolValue];
+		BOOL parseMessages = self.canParseStatusesInBackground;
+		NSUInteger generation = timelineGeneration;
+		NSTimeInterval startTime = [NSDate timeIntervalSinceReferenceDate];
 		
-		AIChat *timelineChat = self.timelineChat;
-		
-		[[AIContactObserverManager sharedManager] delayListObjectNotifications];
+		// internalObjectID is created lazily; make sure that happens here rather than on the queue.
+		(void)self.internalObjectID;
 		
-		for (NSDictionary *status in sortedQueuedUpdates) {
-			NSDate *date = [status objectForKey:TWITTER_STATUS_CREATED];
+		dispatch_async(timelineQueue, ^{
+			NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
 			
-			NSDictionary    *retweet = [status objectForKey:TWITTER_STATUS_RETWEET];
-			NSString *retweeter = nil;
-			if (retweet && [retweet isKindOfClass:[NSDictionary class]]) {
-				retweeter = [[status objectForKey:TWITTER_STATUS_USER] objectForKey:TWITTER_STATUS_UID];
-				status = retweet;
-			}
+			NSArray *preparedUpdates = [self preparedUpdatesFromStatuses:statuses parseMessages:parseMessages];
+			NSUInteger count = preparedUpdates.count;
 			
-			NSString *contactUID = [[status objectForKey:TWITTER_STATUS_USER] objectForKey:TWITTER_STATUS_UID];
-			NSAttributedString *message = [self parseStatus:status
-													tweetID:[status objectForKey:TWITTER_STATUS_ID]
-													 userID:contactUID
-											  inReplyToUser:[status objectForKey:TWITTER_STATUS_REPLY_UID]
-										   inReplyToTweetID:[status objectForKey:TWITTER_STATUS_REPLY_ID]];
+			AILogWithSignature(@"%@ Prepared %lu of %lu updates in %.3f seconds", self, (unsigned long)count, (unsigned long)statuses.count,
+							   [NSDate timeIntervalSinceReferenceDate] - startTime);
 			
-			//Add a link to the retweeter
-			if (retweeter) {
-				NSMutableAttributedString *m = [[message mutableCopy] autorelease];
-				NSString *linkURL = [self addressForLinkType:AITwitterLinkUserPage
-													  userID:retweeter
-													statusID:nil
-													 context:nil];
-				NSAttributedString *rt = [NSAttributedString attributedStringWithString:[NSString stringWithFormat:@" [@%@]", retweeter]
-																			  linkRange:NSMakeRange(2, retweeter.length+1)
-																		linkDestination:linkURL];
-				[m appendAttributedString:rt];
-				message = m;
-			}
-			
-			id fromObject = nil;
-			
-			if (![self.UID isCaseInsensitivelyEqualToString:contactUID]) {
-				AIListContact *listContact = [self contactWithUID:contactUID];
-				
-				[self updateContact:listContact withInfo:[status objectForKey:TWITTER_STATUS_USER] andStatusMessage:message];
-				
-				[timelineChat addParticipatingListObject:listContact notify:NotifyNow];
+			for (NSUInteger idx = 0; idx < count; idx += TWITTER_TIMELINE_DISPLAY_BATCH_SIZE) {
+				NSArray *batch = [preparedUpdates subarrayWithRange:NSMakeRange(idx, MIN(TWITTER_TIMELINE_DISPLAY_BATCH_SIZE, count - idx))];
+				BOOL lastBatch = (idx + TWITTER_TIMELINE_DISPLAY_BATCH_SIZE >= count);
 				
-				fromObject = (id)listContact;
-			} else {
-				fromObject = (id)self;
+				dispatch_async(dispatch_get_main_queue(), ^{
+					// We disconnected while these were being prepared.
+					if (generation != timelineGeneration)
+						return;
+					
+					[self displayPreparedUpdates:batch trackContent:trackContent];
+					
+					if (lastBatch) {
+						AILogWithSignature(@"%@ Displayed %lu updates in %.3f seconds", self, (unsigned long)count,
+										   [NSDate timeIntervalSinceReferenceDate] - startTime);
+					}
+				});
 			}
 			
-			AIContentMessage *contentMessage = [AIContentMessage messageInChat:timelineChat
-																	withSource:fromObject
-																   destination:self
-																		  date:date
-																	   message:message
-																	 autoreply:NO];
-			
-			contentMessage.trackContent = trackContent;
-			
-			[adium.contentController receiveContentObject:contentMessage];
-		}
-		
-		[[AIContactObserverManager sharedManager] endListObjectNotificationsDelay];
-		
-		[queuedUpdates removeAllObjects];
+			[pool release];
+		});
 	} else if (requestType == AITwitterUpdateDirectMessage || requestType == AITwitterDirectMessageSend) {
 		NSMutableArray **unsortedArray = (requestType == AITwitterUpdateDirectMessage) ? &queuedDM : &queuedOutgoingDM;
 		
@@ -2148,14 +2263,8 @@ NSInteger queuedDMSort(id dm1, id dm2, void *context)
 		if (statuses.count)
 			largestTweet = [[statuses objectAtIndex:0] objectForKey:TWITTER_STATUS_ID];
 		
-		//Convert the TWITTER_STATUS_CREATED datestrings to NSDates
-		NSMutableArray *ms = CFPropertyListCreateDeepCopy(kCFAllocatorDefault, (CFArrayRef)statuses, kCFPropertyListMutableContainers);
-		[ms enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
-			[obj setObject:[NSDate dateWithNaturalLanguageString:[obj objectForKey:TWITTER_STATUS_CREATED]]
-					forKey:TWITTER_STATUS_CREATED];
-		}];
-		
-		[queuedUpdates addObjectsFromArray:ms];
+		// Dates are parsed, and duplicates dropped, on the timeline queue once both feeds are in.
+		[queuedUpdates addObjectsFromArray:statuses];
 		
 		AILogWithSignature(@"%@ Last ID: %@ Largest Tweet: %@", self, lastID, largestTweet);
 		
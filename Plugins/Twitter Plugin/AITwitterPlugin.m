@@ -16,10 +16,16 @@
 
 #import "AITwitterPlugin.h"
 #import "AITwitterService.h"
+#import "STTwitterOAuth.h"
 
 @implementation AITwitterPlugin
 - (void)installPlugin
 {
 	[AITwitterService registerService];
+	
+	// Hidden preference to talk to a local stand-in for api.twitter.com, such as Utilities/TwitterMockServer.py
+	NSString *baseURLString = [[NSUserDefaults standardUserDefaults] stringForKey:@"AITwitterAPIBaseURL"];
+	if (baseURLString.length)
+		[STTwitterOAuth setBaseURLString:baseURLString];
 }
 @end
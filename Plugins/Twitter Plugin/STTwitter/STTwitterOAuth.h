@@ -63,6 +63,9 @@
                                    successBlock:(void(^)(NSString *oauthToken, NSString *oauthTokenSecret, NSString *userID, NSString *screenName))successBlock
                                      errorBlock:(void(^)(NSError *error))errorBlock;
 
++ (NSString *)baseURLString;
++ (void)setBaseURLString:(NSString *)baseURLString; // no trailing slash; nil restores https://api.twitter.com
+
 - (BOOL)canVerifyCredentials;
 
 - (void)verifyCredentialsWithSuccessBlock:(void(^)(NSString *username))successBlock errorBlock:(void(^)(NSError *error))errorBlock;
@@ -34,6 +34,8 @@
 
 @end
 
+static NSString *STTwitterBaseURLString = nil;
+
 @implementation STTwitterOAuth
 
 @synthesize username = _username;
@@ -68,6 +70,17 @@
     [super dealloc];
 }
 
++ (NSString *)baseURLString {
+    return STTwitterBaseURLString ? STTwitterBaseURLString : @"https://api.twitter.com";
+}
+
+// lets a local stand-in server take the place of api.twitter.com
++ (void)setBaseURLString:(NSString *)baseURLString {
+    if(baseURLString == STTwitterBaseURLString) return;
+    [STTwitterBaseURLString release];
+    STTwitterBaseURLString = [baseURLString copy];
+}
+
 + (STTwitterOAuth *)twitterServiceWithConsumerName:(NSString *)consumerName
                                        consumerKey:(NSString *)consumerKey
                                     consumerSecret:(NSString *)consumerSecret {
@@ -275,14 +288,14 @@
     NSString *theOAuthCallback = [oauthCallback length] ? oauthCallback : @"oob"; // out of band, ie PIN instead of redirect
     
     [self postResource:@"oauth/request_token"
-         baseURLString:@"https://api.twitter.com"
+         baseURLString:[[self class] baseURLString]
             parameters:@{}
          oauthCallback:theOAuthCallback
           successBlock:^(id body) {
         
         NSDictionary *d = [body parametersDictionary];
         
-        NSString *s = [NSString stringWithFormat:@"https://api.twitter.com/oauth/authorize?%@", body];
+        NSString *s = [NSString stringWithFormat:@"%@/oauth/authorize?%@", [[self class] baseURLString], body];
         
         NSURL *url = [NSURL URLWithString:s];
         
@@ -306,7 +319,7 @@
                         @"x_auth_mode"     : @"client_auth"};
     
     [self postResource:@"oauth/access_token"
-         baseURLString:@"https://api.twitter.com"
+         baseURLString:[[self class] baseURLString]
             parameters:d
           successBlock:^(NSString *body) {
         NSDictionary *dict = [body parametersDictionary];
@@ -336,7 +349,7 @@
     NSDictionary *d = @{@"oauth_verifier" : pin};
     
     [self postResource:@"oauth/access_token"
-         baseURLString:@"https://api.twitter.com"
+         baseURLString:[[self class] baseURLString]
             parameters:d
           successBlock:^(NSString *body) {
         NSDictionary *dict = [body parametersDictionary];
@@ -414,7 +427,7 @@
        successBlock:(void(^)(id response))successBlock
          errorBlock:(void(^)(NSError *error))errorBlock {
     
-    NSMutableString *urlString = [NSMutableString stringWithFormat:@"https://api.twitter.com/1.1/%@", resource];
+    NSMutableString *urlString = [NSMutableString stringWithFormat:@"%@/1.1/%@", [[self class] baseURLString], resource];
     
     NSMutableArray *parameters = [NSMutableArray array];
     
@@ -435,15 +448,26 @@
     
     r.completionBlock = ^(NSDictionary *headers, NSString *body) {
         
-        NSError *jsonError = nil;
-        id json = [r.responseData objectFromJSONDataWithParseOptions:JKParseOptionNone error:&jsonError];
-        
-        if(json == nil) {
-            errorBlock(jsonError);
-            return;
-        }
-        
-        successBlock(json);
+        // timelines can run to megabytes; decode off the main thread, call back on it
+        NSData *responseData = r.responseData;
+        
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+            
+            NSError *jsonError = nil;
+            id json = [responseData objectFromJSONDataWithParseOptions:JKParseOptionNone error:&jsonError];
+            
+            dispatch_async(dispatch_get_main_queue(), ^{
+                if(json == nil) {
+                    errorBlock(jsonError);
+                    return;
+                }
+                
+                successBlock(json);
+            });
+            
+            [pool release];
+        });
     };
     
     r.errorBlock = ^(NSError *error) {
@@ -537,7 +561,7 @@
         successBlock:(void(^)(id response))successBlock
           errorBlock:(void(^)(NSError *error))errorBlock {
     
-    [self postResource:resource baseURLString:@"https://api.twitter.com/1.1" parameters:params oauthCallback:oauthCallback successBlock:successBlock errorBlock:errorBlock];
+    [self postResource:resource baseURLString:[[[self class] baseURLString] stringByAppendingString:@"/1.1"] parameters:params oauthCallback:oauthCallback successBlock:successBlock errorBlock:errorBlock];
 }
 
 - (void)postResource:(NSString *)resource
@@ -16,11 +16,11 @@
 
 #import <Adium/AIChatControllerProtocol.h>
 
-@class AIChat, AdiumChatEvents;
+@class AIChat, AIChatRegistry, AdiumChatEvents;
 
 @interface AIChatController : NSObject <AIChatController> {
 @private
-    NSMutableSet			*openChats;
+	AIChatRegistry			*chatRegistry;
 	NSMutableArray			*chatObserverArray;
 	
     AIChat					*mostRecentChat;	
@@ -22,6 +22,7 @@
 #import <Adium/AIMenuControllerProtocol.h>
 #import <Adium/AIStatusControllerProtocol.h>
 #import "AdiumChatEvents.h"
+#import "AIChatRegistry.h"
 #import <Adium/AIAccount.h>
 #import <Adium/AIChat.h>
 #import <Adium/AIContentObject.h>
@@ -46,6 +47,7 @@
 - (void)didExchangeContent:(NSNotification *)notification;
 
 - (void)adiumWillTerminate:(NSNotification *)inNotification;
+- (AIChat *)existingChatWithListContact:(AIListContact *)inContact;
 @end
 
 /*!
@@ -68,7 +70,7 @@
 		adiumChatEvents = [[AdiumChatEvents alloc] init];
 
 		//Chat tracking
-		openChats = [[NSMutableSet alloc] init];
+		chatRegistry = [[AIChatRegistry alloc] init];
 	}
 	return self;
 }
@@ -141,8 +143,8 @@
 {
 	//Every open chat is about to close. We perform the internal closing here rather than calling on the interface controller since the UI need not change.
 	//Also, we don't care for still processing content, the user won't see it anyway, and it can make Adium refuse to quit.
-	while ([openChats count] > 0) {
-		AIChat *chat = [[openChats anyObject] retain];
+	while ([chatRegistry.chats count] > 0) {
+		AIChat *chat = [[chatRegistry.chats anyObject] retain];
 		
 		if (mostRecentChat == chat) {
 			[mostRecentChat release];
@@ -153,8 +155,8 @@
 		[[NSNotificationCenter defaultCenter] postNotificationName:Chat_WillClose object:chat userInfo:nil];
 		
 		[chat.account closeChat:chat];
-		[openChats removeObject:chat];
-		AILogWithSignature(@"Removed <<%@>> [%@]", chat, openChats);
+		[chatRegistry removeChat:chat];
+		AILogWithSignature(@"Removed <<%@>> [%@]", chat, chatRegistry.chats);
 		
 		[chat setIsOpen:NO];
 		[chat release];
@@ -166,7 +168,7 @@
  */
 - (void)dealloc
 {
-	[openChats release]; openChats = nil;
+	[chatRegistry release]; chatRegistry = nil;
 	[chatObserverArray release]; chatObserverArray = nil;
 	[[NSNotificationCenter defaultCenter] removeObserver:self];
 
@@ -206,6 +208,13 @@
 {
 	NSSet			*modifiedAttributeKeys;
 	
+	//Keep the unviewed totals current before observers such as the dock ask for them
+	if (!inModifiedKeys ||
+		[inModifiedKeys containsObject:KEY_UNVIEWED_CONTENT] ||
+		[inModifiedKeys containsObject:KEY_UNVIEWED_MENTION]) {
+		[chatRegistry chatUnviewedContentChanged:inChat];
+	}
+
     //Let all observers know the chat's status has changed before performing any further notifications
 	modifiedAttributeKeys = [self _informObserversOfChatStatusChange:inChat withKeys:inModifiedKeys silent:silent];
 	
@@ -236,7 +245,7 @@
  */
 - (void)updateAllChatsForObserver:(id <AIChatObserver>)observer
 {	
-	for (AIChat *chat in openChats) {
+	for (AIChat *chat in chatRegistry.chats) {
 		[self chatStatusChanged:chat modifiedStatusKeys:nil silent:NO];
 	}
 }
@@ -341,24 +350,32 @@
 	}
 
 	//Search for an existing chat we can switch instead of replacing
-	for (chat in openChats) {
+	for (chat in [chatRegistry oneToOneChatsWithContact:targetContact]) {
 		//If a chat for this object already exists
-		if ([chat.uniqueChatID isEqualToString:targetContact.internalObjectID]) {
-			if (!(chat.listObject == targetContact)) {
-				[self switchChat:chat toAccount:targetContact.account];
-			}
-			
-			break;
+		if (!(chat.listObject == targetContact)) {
+			[self switchChat:chat toAccount:targetContact.account];
 		}
 		
-		//If this object is within a meta contact, and a chat for an object in that meta contact already exists
-		if (chat.listObject.parentContact == targetContact.parentContact) {
+		break;
+	}
 
-			//Switch the chat to be on this contact (and its account) now
-			[self switchChat:chat toListContact:targetContact usingContactAccount:YES];
-			
-			break;
+	//If this object is within a meta contact, and a chat for an object in that meta contact already exists
+	if (!chat && [targetContact.parentContact isKindOfClass:[AIMetaContact class]]) {
+		AIMetaContact *metaContact = (AIMetaContact *)targetContact.parentContact;
+
+		for (AIListContact *listContact in metaContact.containedObjects) {
+			for (AIChat *candidate in [chatRegistry oneToOneChatsWithContact:listContact]) {
+				if (candidate.listObject.parentContact == metaContact) {
+					chat = candidate;
+					break;
+				}
+			}
+
+			if (chat) break;
 		}
+
+		//Switch the chat to be on this contact (and its account) now
+		if (chat) [self switchChat:chat toListContact:targetContact usingContactAccount:YES];
 	}
 
 	if (!chat) {
@@ -367,13 +384,13 @@
 		//Create a new chat
 		chat = [AIChat chatForAccount:account];
 		[chat addParticipatingListObject:targetContact notify:YES];
-		[openChats addObject:chat];
-		AILog(@"chatWithContact: Added <<%@>> [%@]",chat,openChats);
+		[chatRegistry addChat:chat];
+		AILog(@"chatWithContact: Added <<%@>> [%@]",chat,chatRegistry.chats);
 
 		//Inform the account of its creation
 		if (![targetContact.account openChat:chat]) {
-			[openChats removeObject:chat];
-			AILog(@"chatWithContact: Immediately removed <<%@>> [%@]",chat,openChats);
+			[chatRegistry removeChat:chat];
+			AILog(@"chatWithContact: Immediately removed <<%@>> [%@]",chat,chatRegistry.chats);
 			chat = nil;
 		}
 	}
@@ -392,22 +409,30 @@
 
 	if ([inContact isKindOfClass:[AIMetaContact class]]) {
 		//Search for a chat with any contact within this AIMetaContact
-		for (chat in openChats) {
-			if (!chat.isGroupChat &&
-				[[(AIMetaContact *)inContact containedObjects] containsObjectIdenticalTo:chat.listObject]) break;
+		for (AIListContact *listContact in [(AIMetaContact *)inContact containedObjects]) {
+			if ((chat = [self existingChatWithListContact:listContact])) break;
 		}
 
 	} else {
 		//Search for a chat with this AIListContact
-		for (chat in openChats) {
-			if (!chat.isGroupChat &&
-				chat.listObject == inContact) break;
-		}
+		chat = [self existingChatWithListContact:inContact];
 	}
 	
 	return chat;
 }
 
+/*!
+ * @brief Return a pre-existing one-to-one chat with exactly this contact, which may not be a metacontact
+ */
+- (AIChat *)existingChatWithListContact:(AIListContact *)inContact
+{
+	for (AIChat *chat in [chatRegistry oneToOneChatsWithContact:inContact]) {
+		if (chat.listObject == inContact) return chat;
+	}
+
+	return nil;
+}
+
 /*!
  * @brief Open a group chat
  *
@@ -461,14 +486,14 @@
 		/* Negative preference so (default == NO) -> showing join/leave messages */
 		chat.showJoinLeave = ![[[adium preferenceController] preferenceForKey:[NSString stringWithFormat:@"HideJoinLeave-%@", name]
 																	    group:PREF_GROUP_STATUS_PREFERENCES] boolValue];		
-		[openChats addObject:chat];
+		[chatRegistry addChat:chat];
 		
-		AILog(@"chatWithName:%@ identifier:%@ onAccount:%@ added <<%@>> [%@] [%@]",name,identifier,account,chat,openChats,chatCreationInfo);
+		AILog(@"chatWithName:%@ identifier:%@ onAccount:%@ added <<%@>> [%@] [%@]",name,identifier,account,chat,chatRegistry.chats,chatCreationInfo);
 
 		//Inform the account of its creation
 		if (![account openChat:chat]) {
-			[openChats removeObject:chat];
-			AILog(@"chatWithName: Immediately removed <<%@>> [%@]",chat,openChats);
+			[chatRegistry removeChat:chat];
+			AILog(@"chatWithName: Immediately removed <<%@>> [%@]",chat,chatRegistry.chats);
 			chat = nil;
 		}
 	}
@@ -488,7 +513,7 @@
 	
 	name = [account.service normalizeChatName:name];
 	
-	for (chat in openChats) {
+	for (chat in chatRegistry.chats) {
 		if ((chat.account == account) &&
 			([chat.name isEqualToString:name])) {
 			break;
@@ -508,7 +533,7 @@
 	AIChat			*chat = nil;
 	
 
-	for (chat in openChats) {
+	for (chat in chatRegistry.chats) {
 		if ((chat.account == account) &&
 		   ([[chat identifier] isEqual:identifier])) {
 			break;
@@ -528,7 +553,7 @@
 	AIChat			*chat = nil;
 	
 	
-	for (chat in openChats) {
+	for (chat in chatRegistry.chats) {
 		if ([chat.uniqueChatID isEqualToString:uniqueChatID]) {
 			break;
 		}
@@ -571,10 +596,10 @@
 		 * to close down the chat.
 		 */
 		[inChat.account closeChat:inChat];
-		[openChats removeObject:inChat];
-		AILog(@"closeChat: Removed <<%@>> [%@]",inChat, openChats);
+		[chatRegistry removeChat:inChat];
+		AILog(@"closeChat: Removed <<%@>> [%@]",inChat, chatRegistry.chats);
 	} else {
-		AILog(@"closeChat: Did not remove <<%@>> [%@]",inChat, openChats);		
+		AILog(@"closeChat: Did not remove <<%@>> [%@]",inChat, chatRegistry.chats);		
 	}
 	
 	[inChat setIsOpen:NO];
@@ -585,7 +610,7 @@
 
 - (void)restoreChat:(AIChat *)inChat
 {
-	[openChats addObject:inChat];
+	[chatRegistry addChat:inChat];
 }
 
 /*!
@@ -602,7 +627,7 @@
 	 * ever opened, such as when an error occurs while joining a group chat.
 	 */
 	if (![inChat isOpen])
-		[openChats removeObject:inChat];
+		[chatRegistry removeChat:inChat];
 }
 
 /*!
@@ -685,19 +710,16 @@
 {
     NSMutableSet	*foundChats = [NSMutableSet set];
 	
-	//Scan the objects participating in each chat, looking for the requested object
 	if ([inContact isKindOfClass:[AIMetaContact class]]) {
-		if ([openChats count]) {
+		if ([chatRegistry.chats count]) {
 			for (AIListContact *listContact in ((AIMetaContact *)inContact).uniqueContainedObjects) {
 				[foundChats unionSet:[self allChatsWithContact:listContact]];
 			}
 		}
 		
 	} else {
-		for (AIChat *chat in openChats) {
-			if (!chat.isGroupChat &&
-				[chat.listObject.internalObjectID isEqualToString:inContact.internalObjectID] &&
-				chat.isOpen) {
+		for (AIChat *chat in [chatRegistry oneToOneChatsWithContact:inContact]) {
+			if (chat.isOpen) {
 				[foundChats addObject:chat];
 			}
 		}
@@ -716,25 +738,15 @@
 {
 	NSMutableSet *groupChats = [NSMutableSet set];
 	
-	//Search for a chat containing this AIListContact
 	if ([inContact isKindOfClass:[AIMetaContact class]]) {
-		//Search for a chat with any contact within this AIMetaContact
-		for (AIChat *chat in openChats) {
-			if (!chat.isGroupChat)
-				continue;
-			
-			for (AIListContact *contact in (AIMetaContact *)inContact) {
-				if([chat containsObject:contact]) {
-					[groupChats addObject:chat];
-					break;
-				}
-			}
+		//Any chat containing any contact within this AIMetaContact
+		for (AIListContact *contact in (AIMetaContact *)inContact) {
+			[groupChats unionSet:[chatRegistry groupChatsContainingContact:contact]];
 		}
 		
 	} else {
-		//Search for a chat with this AIListContact
-		for (AIChat *chat in openChats) {
-			if (chat.isGroupChat && [chat containsObject:inContact] && chat.account.shouldBeOnline) {
+		for (AIChat *chat in [chatRegistry groupChatsContainingContact:inContact]) {
+			if (chat.account.shouldBeOnline) {
 				[groupChats addObject:chat];
 			}
 		}
@@ -750,7 +762,7 @@
  */
 - (NSSet *)openChats
 {
-    return [[openChats copy] autorelease];
+    return [[chatRegistry.chats copy] autorelease];
 }
 
 /*!
@@ -769,8 +781,8 @@
 		
 	} else {
 		//Second choice: switch to the first chat we can find which has unviewed content
-		for (AIChat *chat in openChats) {
-			if (chat.unviewedContentCount && (!chat.isGroupChat || !onlyMentions || chat.unviewedMentionCount))
+		for (AIChat *chat in chatRegistry.chatsWithUnviewedContent) {
+			if (!chat.isGroupChat || !onlyMentions || chat.unviewedMentionCount)
 				return chat;
 		}
 	}
@@ -785,18 +797,10 @@
  */
 - (NSUInteger)unviewedContentCount
 {
-	NSUInteger	count = 0;
+	BOOL onlyMentions = [[adium.preferenceController preferenceForKey:KEY_STATUS_MENTION_COUNT
+																group:PREF_GROUP_STATUS_PREFERENCES] boolValue];
 
-	for (AIChat *chat in openChats) {
-		if (chat.isGroupChat &&
-			[[adium.preferenceController preferenceForKey:KEY_STATUS_MENTION_COUNT
-													group:PREF_GROUP_STATUS_PREFERENCES] boolValue]) {
-			count += [chat unviewedMentionCount];
-		} else {
-			count += [chat unviewedContentCount];
-		}
-	}
-	return count;
+	return [chatRegistry unviewedContentCountCountingOnlyGroupChatMentions:onlyMentions];
 }
 
 /*!
@@ -806,20 +810,10 @@
  */
 - (NSUInteger)unviewedConversationCount
 {
-	NSUInteger count = 0;
+	BOOL onlyMentions = [[adium.preferenceController preferenceForKey:KEY_STATUS_MENTION_COUNT
+																group:PREF_GROUP_STATUS_PREFERENCES] boolValue];
 
-	for (AIChat *chat in openChats) {
-		if (chat.isGroupChat &&
-			[[adium.preferenceController preferenceForKey:KEY_STATUS_MENTION_COUNT
-													group:PREF_GROUP_STATUS_PREFERENCES] boolValue]) {
-			if (chat.unviewedMentionCount) {
-				count++;
-			}
-		} else if (chat.unviewedContentCount) {
-			count++;
-		}
-	}
-	return count;
+	return [chatRegistry unviewedConversationCountCountingOnlyGroupChatMentions:onlyMentions];
 }
 
 /*!
@@ -829,18 +823,7 @@
  */
 - (BOOL)contactIsInGroupChat:(AIListContact *)listContact
 {
-	BOOL			contactIsInGroupChat = NO;
-	
-	for (AIChat *chat in openChats) {
-		if (chat.isGroupChat &&
-			[chat containsObject:listContact]) {
-			
-			contactIsInGroupChat = YES;
-			break;
-		}
-	}
-	
-	return contactIsInGroupChat;
+	return ([[chatRegistry groupChatsContainingContact:listContact] count] > 0);
 }
 
 /*!
@@ -956,6 +939,8 @@
  */
 - (void)chat:(AIChat *)chat addedListContacts:(NSArray *)inObjects notify:(BOOL)notify
 {
+	[chatRegistry chat:chat addedListContacts:inObjects];
+
 	if (notify && chat.isGroupChat) {
 		/* Prevent triggering of the event when we are informed that the chat's own account entered the chat
 		 * If the UID of a contact in a chat differs from a normal UID, such as is the case with Jabber where a chat
@@ -981,6 +966,8 @@
  */
 - (void)chat:(AIChat *)chat removedListContact:(AIListContact *)inContact
 {
+	[chatRegistry chat:chat removedListContact:inContact];
+
 	if (chat.isGroupChat) {
 		[adiumChatEvents chat:chat removedListContact:inContact];
 	}
@@ -989,6 +976,16 @@
 											  object:chat];
 }
 
+/*!
+ * @brief A chat silently removed all of its participants
+ *
+ * @param chat The chat
+ */
+- (void)chatRemovedAllListContacts:(AIChat *)chat
+{
+	[chatRegistry chatRemovedAllListContacts:chat];
+}
+
 - (NSString *)defaultInvitationMessageForRoom:(NSString *)room account:(AIAccount *)inAccount
 {
 	return [NSString stringWithFormat:AILocalizedString(@"%@ invites you to join the chat \"%@\"", nil), inAccount.formattedUID, room];
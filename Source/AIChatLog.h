@@ -16,8 +16,6 @@
 
 #define ChatLog_WillDelete			@"ChatLog_WillDelete"
 
-@class ISO8601DateFormatter;
-
 NSDate *dateFromFileName(NSString *fileName);
 
 @interface AIChatLog : NSObject <NSXMLParserDelegate> {
@@ -28,7 +26,6 @@ NSDate *dateFromFileName(NSString *fileName);
     NSDate			*date;
 	CGFloat			rankingPercentage;
 	CGFloat			rankingValue;
-	ISO8601DateFormatter *formatter;
 }
 
 - (id)initWithPath:(NSString *)inPath from:(NSString *)inFrom to:(NSString *)inTo serviceClass:(NSString *)inServiceClass;
@@ -19,7 +19,7 @@
 #import "AILogViewerWindowController.h"
 #import "AILoggerPlugin.h"
 
-#import <AIUtilities/ISO8601DateFormatter.h>
+#import <AIUtilities/AITimestampCodec.h>
 
 @implementation AIChatLog
 
@@ -31,8 +31,6 @@
 		to = [inTo retain];
 		serviceClass = [inServiceClass retain];
 		rankingPercentage = 0;
-		
-		formatter = [[ISO8601DateFormatter alloc] init];
 	}
 
     return self;
@@ -75,7 +73,6 @@
     [to release];
 	[serviceClass release];
     [date release];
-	[formatter release];
     
     [super dealloc];
 }
@@ -115,7 +112,7 @@
 	//Stop at the first element with a date.
 	NSString *dateString = nil;
 	if ((dateString = [attributeDict objectForKey:@"time"])) {
-		date = [[formatter dateFromString:dateString] retain];
+		date = [[AITimestampCodec dateFromString:dateString timeSeparator:':'] retain];
 		if (date)
 			[parser abortParsing];
 	}
@@ -304,17 +301,17 @@
 //Given an Adium log file name, return an NSDate with year, month, and day specified
 NSDate *dateFromFileName(NSString *fileName)
 {
-	ISO8601DateFormatter *formatter = [[[ISO8601DateFormatter alloc] init] autorelease];
-	formatter.timeSeparator = '.';
 	NSRange openParenRange, closeParenRange;
 	
 	if ((openParenRange = [fileName rangeOfString:@"(" options:NSBackwardsSearch]).location != NSNotFound) {
 		openParenRange = NSMakeRange(openParenRange.location, [fileName length] - openParenRange.location);
 		if ((closeParenRange = [fileName rangeOfString:@")" options:0 range:openParenRange]).location != NSNotFound) {
-			//Add and subtract one to remove the parenthesis
-			NSString *dateString = [fileName substringWithRange:NSMakeRange(openParenRange.location + 1, (closeParenRange.location - openParenRange.location))];
+			//Add and subtract one to remove the parentheses
+			NSString *dateString = [fileName substringWithRange:NSMakeRange(openParenRange.location + 1, (closeParenRange.location - openParenRange.location - 1))];
 			// Fix really old chatlogs which use "(2005|05|07)".
-			return [formatter dateFromString:[dateString stringByReplacingOccurrencesOfString:@"|" withString:@"-"]];
+			if ([dateString rangeOfString:@"|"].location != NSNotFound)
+				dateString = [dateString stringByReplacingOccurrencesOfString:@"|" withString:@"-"];
+			return [AITimestampCodec dateFromString:dateString timeSeparator:'.'];
 		}
 	}
 	return nil;
@@ -0,0 +1,66 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+@class AIChat, AIListContact;
+
+/*!
+ * @class AIChatRegistry
+ * @brief The chat controller's set of open chats, indexed for the lookups made on every message
+ *
+ * Besides the chats themselves, the registry keeps
+ *	- one-to-one chats by the internalObjectID of their list object,
+ *	- group chats by the internalUniqueObjectID of each participant, and
+ *	- running totals of unviewed content and mentions.
+ *
+ * The chat controller feeds it every change which affects those: chats opening and closing, participants joining and
+ * leaving, and changes to a chat's unviewed counts. Lookups are then independent of how many chats are open and of
+ * how many contacts are in them.
+ */
+@interface AIChatRegistry : NSObject {
+	NSMutableSet			*chats;
+	CFMutableDictionaryRef	entries;
+
+	NSMutableDictionary		*oneToOneChatsByContactID;
+	NSMutableDictionary		*groupChatsByParticipantID;
+
+	NSMutableSet			*chatsWithUnviewedContent;
+	NSUInteger				oneToOneUnviewedContent;
+	NSUInteger				oneToOneChatsWithUnviewedContent;
+	NSUInteger				groupUnviewedContent;
+	NSUInteger				groupChatsWithUnviewedContent;
+	NSUInteger				groupUnviewedMentions;
+	NSUInteger				groupChatsWithUnviewedMentions;
+}
+
+- (void)addChat:(AIChat *)inChat;
+- (void)removeChat:(AIChat *)inChat;
+- (BOOL)containsChat:(AIChat *)inChat;
+
+- (void)chat:(AIChat *)inChat addedListContacts:(NSArray *)inContacts;
+- (void)chat:(AIChat *)inChat removedListContact:(AIListContact *)inContact;
+- (void)chatRemovedAllListContacts:(AIChat *)inChat;
+- (void)chatUnviewedContentChanged:(AIChat *)inChat;
+
+- (NSSet *)oneToOneChatsWithContact:(AIListContact *)inContact;
+- (NSSet *)groupChatsContainingContact:(AIListContact *)inContact;
+
+- (NSUInteger)unviewedContentCountCountingOnlyGroupChatMentions:(BOOL)onlyMentions;
+- (NSUInteger)unviewedConversationCountCountingOnlyGroupChatMentions:(BOOL)onlyMentions;
+
+@property (readonly, nonatomic) NSSet *chats;
+@property (readonly, nonatomic) NSSet *chatsWithUnviewedContent;
+
+@end
@@ -0,0 +1,359 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIChatRegistry.h"
+#import <Adium/AIChat.h>
+#import <Adium/AIListContact.h>
+
+/*!
+ * @brief What a registered chat is currently indexed and counted under
+ *
+ * Removing a chat from an index needs the key it was added with, which may no longer be what the chat or contact
+ * would report; likewise a chat's old unviewed counts have to be known to take them back out of the totals.
+ */
+@interface AIChatRegistryEntry : NSObject {
+@public
+	BOOL			isGroupChat;
+	NSString		*oneToOneContactID;	//internalObjectID of the list object of a one-to-one chat
+	NSMutableSet	*participantIDs;	//internalUniqueObjectIDs of the participants of a group chat
+	NSUInteger		unviewedContent;
+	NSUInteger		unviewedMentions;
+}
+@end
+
+@implementation AIChatRegistryEntry
+- (void)dealloc
+{
+	[oneToOneContactID release];
+	[participantIDs release];
+
+	[super dealloc];
+}
+@end
+
+@interface AIChatRegistry ()
+- (AIChatRegistryEntry *)entryForChat:(AIChat *)inChat;
+- (void)reindexOneToOneChat:(AIChat *)inChat entry:(AIChatRegistryEntry *)entry;
+- (void)indexParticipants:(NSArray *)inContacts ofChat:(AIChat *)inChat entry:(AIChatRegistryEntry *)entry;
+- (void)unindexAllParticipantsOfChat:(AIChat *)inChat entry:(AIChatRegistryEntry *)entry;
+- (void)setUnviewedContent:(NSUInteger)content mentions:(NSUInteger)mentions forChat:(AIChat *)inChat entry:(AIChatRegistryEntry *)entry;
+@end
+
+static void addChatToIndex(NSMutableDictionary *index, NSString *key, AIChat *chat)
+{
+	NSMutableSet *bucket = [index objectForKey:key];
+
+	if (!bucket) {
+		bucket = [[NSMutableSet alloc] initWithCapacity:1];
+		[index setObject:bucket forKey:key];
+		[bucket release];
+	}
+
+	[bucket addObject:chat];
+}
+
+static void removeChatFromIndex(NSMutableDictionary *index, NSString *key, AIChat *chat)
+{
+	NSMutableSet *bucket = [index objectForKey:key];
+
+	[bucket removeObject:chat];
+	if (bucket && ![bucket count]) [index removeObjectForKey:key];
+}
+
+@implementation AIChatRegistry
+
+- (id)init
+{
+	if ((self = [super init])) {
+		chats = [[NSMutableSet alloc] init];
+
+		//Keys are chats compared by pointer and not retained (chats retains them); values are our entries
+		entries = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+
+		oneToOneChatsByContactID = [[NSMutableDictionary alloc] init];
+		groupChatsByParticipantID = [[NSMutableDictionary alloc] init];
+		chatsWithUnviewedContent = [[NSMutableSet alloc] init];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	CFRelease(entries);
+	[chats release];
+	[oneToOneChatsByContactID release];
+	[groupChatsByParticipantID release];
+	[chatsWithUnviewedContent release];
+
+	[super dealloc];
+}
+
+@synthesize chats, chatsWithUnviewedContent;
+
+- (AIChatRegistryEntry *)entryForChat:(AIChat *)inChat
+{
+	return (AIChatRegistryEntry *)CFDictionaryGetValue(entries, inChat);
+}
+
+- (BOOL)containsChat:(AIChat *)inChat
+{
+	return ([self entryForChat:inChat] != nil);
+}
+
+#pragma mark Chats
+
+/*!
+ * @brief Add a chat, indexing its current participants and counting its unviewed content
+ *
+ * Adding a chat which is already registered has no effect.
+ */
+- (void)addChat:(AIChat *)inChat
+{
+	if ([self entryForChat:inChat]) return;
+
+	AIChatRegistryEntry *entry = [[AIChatRegistryEntry alloc] init];
+	entry->isGroupChat = inChat.isGroupChat;
+	if (entry->isGroupChat) entry->participantIDs = [[NSMutableSet alloc] init];
+
+	[chats addObject:inChat];
+	CFDictionarySetValue(entries, inChat, entry);
+	[entry release];
+
+	if (entry->isGroupChat) {
+		[self indexParticipants:inChat.containedObjects ofChat:inChat entry:entry];
+	} else {
+		[self reindexOneToOneChat:inChat entry:entry];
+	}
+
+	[self chatUnviewedContentChanged:inChat];
+}
+
+/*!
+ * @brief Remove a chat from the registry and from every index and total it is part of
+ */
+- (void)removeChat:(AIChat *)inChat
+{
+	AIChatRegistryEntry *entry = [self entryForChat:inChat];
+	if (!entry) return;
+
+	//Our set may hold the last reference to the chat
+	[inChat retain];
+
+	if (entry->isGroupChat) {
+		[self unindexAllParticipantsOfChat:inChat entry:entry];
+	} else if (entry->oneToOneContactID) {
+		removeChatFromIndex(oneToOneChatsByContactID, entry->oneToOneContactID, inChat);
+	}
+
+	[self setUnviewedContent:0 mentions:0 forChat:inChat entry:entry];
+
+	CFDictionaryRemoveValue(entries, inChat);
+	[chats removeObject:inChat];
+
+	[inChat release];
+}
+
+#pragma mark Participants
+
+/*!
+ * @brief A registered chat added participants
+ *
+ * A one-to-one chat reports its new list object this way after -[AIChat setListObject:], so it is reindexed under
+ * whatever its list object is now.
+ */
+- (void)chat:(AIChat *)inChat addedListContacts:(NSArray *)inContacts
+{
+	AIChatRegistryEntry *entry = [self entryForChat:inChat];
+	if (!entry) return;
+
+	if (entry->isGroupChat) {
+		[self indexParticipants:inContacts ofChat:inChat entry:entry];
+	} else {
+		[self reindexOneToOneChat:inChat entry:entry];
+	}
+}
+
+- (void)chat:(AIChat *)inChat removedListContact:(AIListContact *)inContact
+{
+	AIChatRegistryEntry *entry = [self entryForChat:inChat];
+	if (!entry) return;
+
+	if (entry->isGroupChat) {
+		NSString *participantID = inContact.internalUniqueObjectID;
+
+		if ([entry->participantIDs containsObject:participantID]) {
+			removeChatFromIndex(groupChatsByParticipantID, participantID, inChat);
+			[entry->participantIDs removeObject:participantID];
+		}
+	} else {
+		[self reindexOneToOneChat:inChat entry:entry];
+	}
+}
+
+- (void)chatRemovedAllListContacts:(AIChat *)inChat
+{
+	AIChatRegistryEntry *entry = [self entryForChat:inChat];
+	if (!entry) return;
+
+	if (entry->isGroupChat) {
+		[self unindexAllParticipantsOfChat:inChat entry:entry];
+	} else {
+		[self reindexOneToOneChat:inChat entry:entry];
+	}
+}
+
+- (void)reindexOneToOneChat:(AIChat *)inChat entry:(AIChatRegistryEntry *)entry
+{
+	NSString *contactID = inChat.listObject.internalObjectID;
+
+	if (contactID == entry->oneToOneContactID || [contactID isEqualToString:entry->oneToOneContactID])
+		return;
+
+	if (entry->oneToOneContactID) {
+		removeChatFromIndex(oneToOneChatsByContactID, entry->oneToOneContactID, inChat);
+		[entry->oneToOneContactID release]; entry->oneToOneContactID = nil;
+	}
+
+	if (contactID) {
+		entry->oneToOneContactID = [contactID copy];
+		addChatToIndex(oneToOneChatsByContactID, contactID, inChat);
+	}
+}
+
+- (void)indexParticipants:(NSArray *)inContacts ofChat:(AIChat *)inChat entry:(AIChatRegistryEntry *)entry
+{
+	for (AIListContact *listContact in inContacts) {
+		NSString *participantID = listContact.internalUniqueObjectID;
+
+		if (participantID && ![entry->participantIDs containsObject:participantID]) {
+			[entry->participantIDs addObject:participantID];
+			addChatToIndex(groupChatsByParticipantID, participantID, inChat);
+		}
+	}
+}
+
+- (void)unindexAllParticipantsOfChat:(AIChat *)inChat entry:(AIChatRegistryEntry *)entry
+{
+	for (NSString *participantID in entry->participantIDs) {
+		removeChatFromIndex(groupChatsByParticipantID, participantID, inChat);
+	}
+
+	[entry->participantIDs removeAllObjects];
+}
+
+#pragma mark Lookups
+
+/*!
+ * @brief One-to-one chats whose list object has the same internalObjectID as inContact
+ *
+ * This is every such chat regardless of account; callers wanting a chat with inContact itself should compare list
+ * objects. inContact should not be a metacontact.
+ */
+- (NSSet *)oneToOneChatsWithContact:(AIListContact *)inContact
+{
+	NSSet *bucket = [oneToOneChatsByContactID objectForKey:inContact.internalObjectID];
+
+	//Return a copy, as callers may switch the chats they find, which reindexes them
+	return (bucket ? [[bucket copy] autorelease] : [NSSet set]);
+}
+
+/*!
+ * @brief Group chats in which inContact is a participant
+ *
+ * inContact should not be a metacontact.
+ */
+- (NSSet *)groupChatsContainingContact:(AIListContact *)inContact
+{
+	NSSet *bucket = [groupChatsByParticipantID objectForKey:inContact.internalUniqueObjectID];
+
+	return (bucket ? [[bucket copy] autorelease] : [NSSet set]);
+}
+
+#pragma mark Unviewed content
+
+/*!
+ * @brief A registered chat's unviewed content or mention count may have changed
+ */
+- (void)chatUnviewedContentChanged:(AIChat *)inChat
+{
+	AIChatRegistryEntry *entry = [self entryForChat:inChat];
+	if (!entry) return;
+
+	[self setUnviewedContent:inChat.unviewedContentCount
+					mentions:inChat.unviewedMentionCount
+					 forChat:inChat
+					   entry:entry];
+}
+
+- (void)setUnviewedContent:(NSUInteger)content mentions:(NSUInteger)mentions forChat:(AIChat *)inChat entry:(AIChatRegistryEntry *)entry
+{
+	if (content == entry->unviewedContent && mentions == entry->unviewedMentions)
+		return;
+
+	if (entry->isGroupChat) {
+		groupUnviewedContent = groupUnviewedContent - entry->unviewedContent + content;
+		groupUnviewedMentions = groupUnviewedMentions - entry->unviewedMentions + mentions;
+
+		if (!entry->unviewedContent != !content) {
+			if (content) groupChatsWithUnviewedContent++;
+			else groupChatsWithUnviewedContent--;
+		}
+		if (!entry->unviewedMentions != !mentions) {
+			if (mentions) groupChatsWithUnviewedMentions++;
+			else groupChatsWithUnviewedMentions--;
+		}
+
+	} else {
+		oneToOneUnviewedContent = oneToOneUnviewedContent - entry->unviewedContent + content;
+
+		if (!entry->unviewedContent != !content) {
+			if (content) oneToOneChatsWithUnviewedContent++;
+			else oneToOneChatsWithUnviewedContent--;
+		}
+	}
+
+	if (content) {
+		[chatsWithUnviewedContent addObject:inChat];
+	} else {
+		[chatsWithUnviewedContent removeObject:inChat];
+	}
+
+	entry->unviewedContent = content;
+	entry->unviewedMentions = mentions;
+}
+
+/*!
+ * @brief The total number of unviewed messages
+ *
+ * @param onlyMentions If YES, group chats count only their unviewed mentions
+ */
+- (NSUInteger)unviewedContentCountCountingOnlyGroupChatMentions:(BOOL)onlyMentions
+{
+	return oneToOneUnviewedContent + (onlyMentions ? groupUnviewedMentions : groupUnviewedContent);
+}
+
+/*!
+ * @brief The number of chats with unviewed messages
+ *
+ * @param onlyMentions If YES, group chats count only if they have unviewed mentions
+ */
+- (NSUInteger)unviewedConversationCountCountingOnlyGroupChatMentions:(BOOL)onlyMentions
+{
+	return oneToOneChatsWithUnviewedContent + (onlyMentions ? groupChatsWithUnviewedMentions : groupChatsWithUnviewedContent);
+}
+
+@end
@@ -14,13 +14,10 @@
  * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
-#import <Adium/AIContactObserverManager.h>
 #import <Adium/AIInterfaceControllerProtocol.h>
 
-@interface AIContactIdlePlugin : AIPlugin <AIListObjectObserver, AIContactListTooltipEntry> {
+@interface AIContactIdlePlugin : AIPlugin <AIContactListTooltipEntry> {
 
-    NSMutableArray	*idleObjectArray;
-    NSTimer		*idleObjectTimer;
 }
 
 @end
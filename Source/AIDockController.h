@@ -18,11 +18,12 @@
 #import <Adium/AIInterfaceControllerProtocol.h>
 #import <Adium/AIChatControllerProtocol.h>
 
+@class AIWheelTimer;
 
 @interface AIDockController: NSObject <AIDockController, AIFlashObserver, AIChatObserver> {
 @private
-    NSTimer 				*animationTimer;
-    NSTimer					*bounceTimer;
+    AIWheelTimer			*animationTimer;
+    AIWheelTimer			*bounceTimer;
     NSTimeInterval			currentBounceInterval;
     
     NSMutableDictionary		*availableIconStateDict;
@@ -24,6 +24,7 @@
 #import <Adium/AIChat.h>
 #import <Adium/AIStatusControllerProtocol.h>
 #import <AIUtilities/AIApplicationAdditions.h>
+#import <AIUtilities/AITimerWheel.h>
 
 #define DOCK_DEFAULT_PREFS			@"DockPrefs"
 #define ICON_DISPLAY_DELAY			0.1
@@ -40,7 +41,7 @@
 @interface AIDockController ()
 - (void)_setNeedsDisplay;
 - (void)_buildIcon;
-- (void)animateIcon:(NSTimer *)timer;
+- (void)animateIcon:(AIWheelTimer *)timer;
 - (void)_singleBounce;
 - (BOOL)_continuousBounce;
 - (void)_stopBouncing;
@@ -52,7 +53,7 @@
 - (void)animateDockIcon;
 
 - (void)appWillChangeActive:(NSNotification *)notification;
-- (void)bounceWithTimer:(NSTimer *)timer;
+- (void)bounceWithTimer:(AIWheelTimer *)timer;
 @end
 
 @implementation AIDockController
@@ -388,11 +389,11 @@
 		needsDisplay = YES;
 
 		//Invoke a display after a short delay
-		[NSTimer scheduledTimerWithTimeInterval:ICON_DISPLAY_DELAY
-										 target:self
-									   selector:@selector(_buildIcon)
-									   userInfo:nil
-										repeats:NO];
+		[[AITimerWheel sharedTimerWheel] scheduleTimerWithDelay:ICON_DISPLAY_DELAY
+												 repeatInterval:0
+														 target:self
+													   selector:@selector(_buildIcon)
+													   userInfo:nil];
 	}
 }
 
@@ -486,11 +487,11 @@
 - (void)flash:(int)value
 {
     //Start the flash timer
-    animationTimer = [[NSTimer scheduledTimerWithTimeInterval:[currentIconState animationDelay]
-                                                       target:self
-                                                     selector:@selector(animateIcon:)
-                                                     userInfo:nil
-                                                      repeats:YES] retain];
+    animationTimer = [[[AITimerWheel sharedTimerWheel] scheduleTimerWithDelay:[currentIconState animationDelay]
+                                                               repeatInterval:[currentIconState animationDelay]
+                                                                       target:self
+                                                                     selector:@selector(animateIcon:)
+                                                                     userInfo:nil] retain];
 
     //Animate the icon
     [self animateIcon:animationTimer]; //Set the icon and move to the next frame
@@ -501,7 +502,7 @@
 }
 
 //Move the dock to the next animation frame (Assumes the current state is animated)
-- (void)animateIcon:(NSTimer *)timer
+- (void)animateIcon:(AIWheelTimer *)timer
 {
 	//Move to the next image
 	if (timer) {
@@ -575,11 +576,14 @@
 		
 		currentBounceInterval = delay;
 		
-		bounceTimer = [[NSTimer scheduledTimerWithTimeInterval:delay
-														target:self
-													  selector:@selector(bounceWithTimer:)
-													  userInfo:nil
-													   repeats:YES] retain];
+		//Replace the slower bounce, if any
+		[bounceTimer invalidate];
+		[bounceTimer release];
+		bounceTimer = [[[AITimerWheel sharedTimerWheel] scheduleTimerWithDelay:delay
+																repeatInterval:delay
+																		target:self
+																	  selector:@selector(bounceWithTimer:)
+																	  userInfo:nil] retain];
 		
 		return YES;
 	}
@@ -587,7 +591,7 @@
 }
 
 //Activated by the time after each delay
-- (void)bounceWithTimer:(NSTimer *)timer
+- (void)bounceWithTimer:(AIWheelTimer *)timer
 {
 	//Bounce
 	[self _singleBounce];
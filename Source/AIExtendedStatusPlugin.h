@@ -20,11 +20,8 @@
 @interface AIExtendedStatusPlugin : AIPlugin <AIListObjectObserver> {
 	BOOL	showIdle;
 	BOOL	showStatus;
-	BOOL	includeIdleInExtendedStatus;
 	
 	NSCharacterSet	*whitespaceAndNewlineCharacterSet;
 }
 
-- (NSString *)idleStringForMinutes:(NSInteger)minutes;
-
 @end
@@ -20,7 +20,6 @@
 #import <AIUtilities/AIMutableOwnerArray.h>
 #import <AIUtilities/AIAttributedStringAdditions.h>
 #import <AIUtilities/AIMutableStringAdditions.h>
-#import <AIUtilities/AIDateFormatterAdditions.h>
 #import <Adium/AIAbstractListController.h>
 #import <Adium/AIListObject.h>
 #import <Adium/AIListContact.h>
@@ -31,8 +30,11 @@
  * @class AIExtendedStatusPlugin
  * @brief Manage the 'extended status' shown in the contact list
  *
- * If the contact list layout calls for displaying a status message or idle time (or both), this component manages
- * generating the appropriate string, storing it in the @"extendedStatus" property, and updating it as necessary.
+ * If the contact list layout calls for displaying a status message, this component manages generating the appropriate
+ * string, storing it in the @"extendedStatus" property, and updating it as necessary.
+ *
+ * Idle times change every minute, so they aren't stored; contact list cells add them to the extended status as they
+ * draw it, from AIElapsedTimeManager.
  */
 @implementation AIExtendedStatusPlugin
 
@@ -65,21 +67,16 @@
 {
 	BOOL oldShowStatus = showStatus;
 	BOOL oldShowIdle = showIdle;
-	BOOL oldIncludeIdleInExtendedStatus = includeIdleInExtendedStatus;
 
 	EXTENDED_STATUS_STYLE statusStyle = [(NSNumber *)[prefDict objectForKey:KEY_LIST_LAYOUT_EXTENDED_STATUS_STYLE] intValue];
 	showStatus = ((statusStyle == STATUS_ONLY) || (statusStyle == IDLE_AND_STATUS));
 	showIdle = ((statusStyle == IDLE_ONLY) || (statusStyle == IDLE_AND_STATUS));
 	
-	EXTENDED_STATUS_POSITION statusPosition = [(NSNumber *)[prefDict objectForKey:KEY_LIST_LAYOUT_EXTENDED_STATUS_POSITION] intValue];
-	includeIdleInExtendedStatus = (statusPosition != EXTENDED_STATUS_POSITION_BOTH);
-	
 	if (firstTime) {
 		[[AIContactObserverManager sharedManager] registerListObjectObserver:self];
 	} else {
 		if ((oldShowStatus != showStatus) ||
-			(oldShowIdle != showIdle) ||
-			(oldIncludeIdleInExtendedStatus != includeIdleInExtendedStatus)) {
+			(oldShowIdle != showIdle)) {
 			[[AIContactObserverManager sharedManager] updateAllListObjectsForObserver:self];
 		}
 	}
@@ -94,15 +91,17 @@
 
 	/* Work at the parent contact (metacontact, etc.) level for extended status, since that's what's displayed in the contact list.
 	 * We completely ignore status updates sent for an object which isn't the highest-level up (e.g. is within a metacontact).
+	 *
+	 * The idle time itself is drawn from idleSince, but the extended status changes shape when a contact goes idle or
+	 * comes back, so note that as a change to it.
 	 */
     if ((inModifiedKeys == nil || 
-		 (showIdle && [inModifiedKeys containsObject:@"idle"]) ||
+		 (showIdle && ([inModifiedKeys containsObject:@"idleSince"] ||
+					   [inModifiedKeys containsObject:@"isIdle"])) ||
 		 (showStatus && ([inModifiedKeys containsObject:@"listObjectStatusMessage"] ||
 						 [inModifiedKeys containsObject:@"listObjectStatusName"]))) &&
 		[inObject isKindOfClass:[AIListContact class]]){
 		NSMutableString	*statusMessage = nil;
-		NSString		*finalMessage = nil, *finalIdleReadable = nil;
-		NSInteger		idle;
 
 		if (showStatus) {
 			NSAttributedString *filteredMessage;
@@ -127,30 +126,7 @@
 			[statusMessage convertNewlinesToSlashes];	
 		}
 
-		idle = (showIdle ? inObject.idleTime : 0);
-
-		//
-		NSString *idleString = ((idle > 0) ? [self idleStringForMinutes:idle] : nil);
-
-		if (idle > 0 && statusMessage) {
-			finalMessage = (includeIdleInExtendedStatus ?
-							[NSString stringWithFormat:@"(%@) %@",idleString, statusMessage] :
-							statusMessage);
-			finalIdleReadable = [NSString stringWithFormat:@"(%@)", idleString];
-		} else if (idle > 0) {			
-			finalIdleReadable = [NSString stringWithFormat:@"(%@)",idleString];
-			finalMessage = (includeIdleInExtendedStatus ?
-							finalIdleReadable :
-							statusMessage);			
-		} else {
-			finalMessage = statusMessage;
-		}
-
-		[inObject setValue:finalIdleReadable
-			   forProperty:@"idleReadable"
-					notify:NotifyNever];
-
-		[inObject setValue:finalMessage
+		[inObject setValue:statusMessage
 			   forProperty:@"extendedStatus"
 					notify:NotifyNever];
 		modifiedAttributes = [NSSet setWithObject:@"extendedStatus"];
@@ -159,17 +135,4 @@
 	return modifiedAttributes;
 }
 
-
-/*!
- * @brief Determine the idle string
- *
- * @param minutes Number of minutes idle
- * @result A localized string to display for the idle time
- */
-- (NSString *)idleStringForMinutes:(NSInteger)minutes //input is actualy minutes
-{
-	// Cap Idletime at 599400 minutes (999 hours)
-	return ((minutes > 599400) ? AILocalizedString(@"Idle",nil) : [NSDateFormatter stringForApproximateTimeInterval:(minutes * 60) abbreviated:YES]);
-}
-
 @end
@@ -456,12 +456,25 @@
 	//Resize the contact list horizontally
 	if (self.autoResizeHorizontally) {
 		if ([keys containsObject:@"Display Name"] || [keys containsObject:@"Long Display Name"] ||
-				(self.autoResizeHorizontallyWithIdleTime && [keys containsObject:@"idleReadable"])) {
+				(self.autoResizeHorizontallyWithIdleTime && [keys containsObject:@"extendedStatus"])) {
 			[self contactListDesiredSizeChanged];
 		}
 	}
 }
 
+/*!
+ * @brief The minute changed
+ *
+ * Idle times may be wider or narrower now; resize once for all of them, if the width depends on them.
+ */
+- (void)elapsedTimeMinuteDidChange:(NSNotification *)notification
+{
+	[super elapsedTimeMinuteDidChange:notification];
+
+	if (self.autoResizeHorizontally && self.autoResizeHorizontallyWithIdleTime)
+		[self contactListDesiredSizeChanged];
+}
+
 /*!
  * @brief The outline view selection changed
  *
@@ -24,6 +24,7 @@
 #import "AILogFromGroup.h"
 #import "AILoggerPlugin.h"
 #import "AILogToGroup.h"
+#import "AIMessageTailCache.h"
 #import "AILogDateFormatter.h"
 #import "AIXMLChatlogConverter.h"
 #import "ESRankingCell.h" 
@@ -2604,6 +2605,7 @@ static NSInteger toArraySort(id itemA, id itemB, void *context)
 							  error:NULL];
 		
 		[plugin markLogDirtyAtPath:logPath];
+		[[AILoggerPlugin messageTailCache] removeRecordsForKey:[[aLog relativePath] stringByDeletingLastPathComponent]];
 	}
 	
 	[self rebuildIndices];
@@ -2751,6 +2753,8 @@ static NSInteger toArraySort(id itemA, id itemB, void *context)
 		while ((aLog = [logEnumerator nextObject])) {
 			[plugin markLogDirtyAtPath:[logBasePath stringByAppendingPathComponent:[aLog relativePath]]];
 		}
+		
+		[[AILoggerPlugin messageTailCache] removeRecordsForKey:[toGroup relativePath]];
 	}
 	
 	[self rebuildIndices];
@@ -2775,6 +2779,7 @@ static NSInteger toArraySort(id itemA, id itemB, void *context)
 			
 			AILogFromGroup	*logFromGroup = [logFromGroupDict objectForKey:[NSString stringWithFormat:@"%@.%@",[logToGroup serviceClass],[logToGroup from]]];
 			[logFromGroup removeToGroup:logToGroup];
+			[[AILoggerPlugin messageTailCache] removeRecordsForKey:[logToGroup relativePath]];
 		}
 		
 		[plugin removePathsFromIndex:logPaths];
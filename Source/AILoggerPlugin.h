@@ -28,7 +28,7 @@
 
 #define XML_LOGGING_NAMESPACE         @"http://purl.org/net/ulf/ns/0.4-02"
 
-@class AIAccount, AIHTMLDecoder, AIChat, ISO8601DateFormatter;
+@class AIAccount, AIHTMLDecoder, AIChat, AITimestampCodec, AIMessageTailCache;
 
 @interface AILoggerPlugin : AIPlugin {
 	
@@ -45,7 +45,7 @@
 	NSDictionary        *statusTranslation;
 	BOOL                 logHTML;
 	
-	ISO8601DateFormatter *formatter;
+	AITimestampCodec     *formatter;
 	
 	// Log Indexing
 	NSMutableSet        *dirtyLogSet;
@@ -71,9 +71,11 @@
 //Paths
 + (NSString *)logBasePath;
 + (NSString *)relativePathForLogWithObject:(NSString *)object onAccount:(AIAccount *)account;
++ (NSString *)relativePathForLogsLikeChat:(AIChat *)chat;
 
 //Message History
 + (NSArray *)sortedArrayOfLogFilesForChat:(AIChat *)chat;
++ (AIMessageTailCache *)messageTailCache;
 
 //Log indexing
 - (void)prepareLogContentSearching;
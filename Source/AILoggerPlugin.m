@@ -20,6 +20,7 @@
 #import "AILogToGroup.h"
 #import "AILogViewerWindowController.h"
 #import "AIXMLAppender.h"
+#import "AIMessageTailCache.h"
 #import <Adium/AIXMLElement.h>
 #import <Adium/AIContentControllerProtocol.h>
 #import <Adium/AIInterfaceControllerProtocol.h>
@@ -46,7 +47,7 @@
 #import <AIUtilities/AIToolbarUtilities.h>
 #import <AIUtilities/AIDateFormatterAdditions.h>
 #import <AIUtilities/AIImageAdditions.h>
-#import <AIUtilities/ISO8601DateFormatter.h>
+#import <AIUtilities/AITimestampCodec.h>
 
 #import <libkern/OSAtomic.h>
 
@@ -60,6 +61,7 @@
 #define LOG_INDEX_NAME				@"Logs.index"
 #define KEY_LOG_INDEX_VERSION		@"Log Index Version"
 #define DIRTY_LOG_SET_NAME			@"DirtyLogs.plist"
+#define MESSAGE_TAIL_CACHE_NAME		@"Message Context"
 #define KEY_LOG_INDEX_VERSION		@"Log Index Version"
 
 //Version of the log index.  Increase this number to reset everyone's index.
@@ -118,6 +120,13 @@ CFStringRef CopyTextContentForFileData(CFStringRef contentTypeUTI, NSURL *urlToF
 - (NSString *)keyForChat:(AIChat *)chat;
 - (void)closeAppenderForChat:(AIChat *)chat;
 - (void)finishClosingAppender:(NSString *)chatKey;
+- (void)_appendElementWithName:(NSString *)elementName
+				attributeNames:(NSArray *)attrNames
+						values:(NSArray *)attrVals
+			   escapedContents:(NSString *)escapedContents
+					toAppender:(AIXMLAppender *)appender
+					   forChat:(AIChat *)chat;
+- (void)_appendElement:(AIXMLElement *)element toAppender:(AIXMLAppender *)appender forChat:(AIChat *)chat;
 
 // Log Indexing
 - (NSString *)_logIndexPath;
@@ -165,6 +174,8 @@ NSComparisonResult sortPaths(NSString *path1, NSString *path2, void *context);
 static NSString     *logBasePath = nil;
 //If the usual Logs folder path refers to an alias file, this is that path, and logBasePath is the destination of the alias; otherwise, this is nil and logBasePath is the usual Logs folder path.
 static NSString     *logBaseAliasPath = nil;
+//The newest messages of each log folder, kept up to date as we log
+static AIMessageTailCache *messageTailCache = nil;
 
 #pragma mark Dispatch
 static dispatch_queue_t     defaultDispatchQueue;
@@ -222,8 +233,7 @@ static dispatch_semaphore_t logLoadingPrefetchSemaphore; //limit prefetching log
 	jobSemaphore = dispatch_semaphore_create(3 * cpuCount);
     logLoadingPrefetchSemaphore = dispatch_semaphore_create(3 * cpuCount + 1); //prefetch one log
 	
-	formatter = [[ISO8601DateFormatter alloc] init];
-	formatter.includeTime = YES;
+	formatter = [[AITimestampCodec alloc] init];
 	
 	self.xhtmlDecoder = [[[AIHTMLDecoder alloc] initWithHeaders:NO
 													   fontTags:YES
@@ -259,6 +269,7 @@ static dispatch_semaphore_t logLoadingPrefetchSemaphore; //limit prefetching log
 	static dispatch_once_t setLogBasePath;
 	dispatch_once(&setLogBasePath, ^{
 		logBasePath = [[[[adium.loginController userDirectory] stringByAppendingPathComponent:PATH_LOGS] stringByExpandingTildeInPath] retain];
+		messageTailCache = [[AIMessageTailCache alloc] initWithCachePath:[[adium cachesPath] stringByAppendingPathComponent:MESSAGE_TAIL_CACHE_NAME]];
 	});
 	
 	[[NSFileManager defaultManager] createDirectoryAtPath:logBasePath withIntermediateDirectories:YES attributes:nil error:NULL];
@@ -374,6 +385,20 @@ static dispatch_semaphore_t logLoadingPrefetchSemaphore; //limit prefetching log
 	return [NSString stringWithFormat:@"%@.%@/%@", account.service.serviceID, [account.UID safeFilenameString], object];
 }
 
+/*!
+ * @brief The folder, relative to the logs folder, holding the logs of a chat
+ *
+ * This is also the key for the chat's entry in +messageTailCache.
+ */
++ (NSString *)relativePathForLogsLikeChat:(AIChat *)chat
+{
+	NSString	*objectUID = chat.name;
+	
+	if (!objectUID) objectUID = chat.listObject.UID;
+	
+	return [self relativePathForLogWithObject:[objectUID safeFilenameString] onAccount:chat.account];
+}
+
 //Message History
 + (NSArray *)sortedArrayOfLogFilesForChat:(AIChat *)chat
 {
@@ -389,6 +414,14 @@ static dispatch_semaphore_t logLoadingPrefetchSemaphore; //limit prefetching log
 	return (files ? [files sortedArrayUsingFunction:&sortPaths context:cache] : nil);
 }
 
+/*!
+ * @brief The newest messages and statuses logged for each chat, keyed by +relativePathForLogsLikeChat:
+ */
++ (AIMessageTailCache *)messageTailCache
+{
+	return messageTailCache;
+}
+
 //Log indexing
 - (void)prepareLogContentSearching
 {
@@ -578,13 +611,7 @@ NSComparisonResult sortPaths(NSString *path1, NSString *path2, void *context)
 #pragma mark Private Class Methods
 + (NSString *)pathForLogsLikeChat:(AIChat *)chat
 {
-	NSString	*objectUID = chat.name;
-	AIAccount	*account = chat.account;
-	
-	if (!objectUID) objectUID = chat.listObject.UID;
-	objectUID = [objectUID safeFilenameString];
-	
-	return [[self logBasePath] stringByAppendingPathComponent:[self relativePathForLogWithObject:objectUID onAccount:account]];
+	return [[self logBasePath] stringByAppendingPathComponent:[self relativePathForLogsLikeChat:chat]];
 }
 
 + (NSString *)fullPathForLogOfChat:(AIChat *)chat onDate:(NSDate *)date
@@ -1026,7 +1053,7 @@ NSComparisonResult sortPaths(NSString *path1, NSString *path2, void *context)
 		dispatch_group_async(logAppendingGroup, dispatch_get_main_queue(), blockWithAutoreleasePool(^{
 			BOOL			dirty = NO;
 			NSString		*contentType = [content type];
-			NSString		*date = [formatter stringFromDate:[[content date] dateWithCalendarFormat:nil timeZone:nil]];
+			NSString		*date = [formatter stringFromDate:[content date]];
 			
 			if ([contentType isEqualToString:CONTENT_MESSAGE_TYPE] ||
 				[contentType isEqualToString:CONTENT_CONTEXT_TYPE]) {
@@ -1045,14 +1072,13 @@ NSComparisonResult sortPaths(NSString *path1, NSString *path2, void *context)
 					[attributeValues addObject:displayName];
 				}
 				
-				AIXMLElement *messageElement = [[[AIXMLElement alloc] initWithName:@"message"] autorelease];
-				
-				[messageElement addEscapedObject:[xhtmlDecoder encodeHTML:[content message]
-															   imagesPath:[appender.path stringByDeletingLastPathComponent]]];
-				
-				[messageElement setAttributeNames:attributeKeys values:attributeValues];
-				
-				[appender appendElement:messageElement];
+				[self _appendElementWithName:@"message"
+							  attributeNames:attributeKeys
+									  values:attributeValues
+							 escapedContents:[xhtmlDecoder encodeHTML:[content message]
+														   imagesPath:[appender.path stringByDeletingLastPathComponent]]
+								  toAppender:appender
+									 forChat:chat];
 				
 				dirty = YES;
 			} else {
@@ -1087,15 +1113,14 @@ NSComparisonResult sortPaths(NSString *path1, NSString *path2, void *context)
 							[attributeValues addObject:actualObject.displayName];				
 						}
 						
-						AIXMLElement *statusElement = [[[AIXMLElement alloc] initWithName:@"status"] autorelease];
-						
-						[statusElement addEscapedObject:([(AIContentStatus *)content loggedMessage] ?
-														 [xhtmlDecoder encodeHTML:[(AIContentStatus *)content loggedMessage] imagesPath:nil] :
-														 @"")];
-						
-						[statusElement setAttributeNames:attributeKeys values:attributeValues];
-						
-						[[bself _appenderForChat:chat] appendElement:statusElement];
+						[bself _appendElementWithName:@"status"
+									   attributeNames:attributeKeys
+											   values:attributeValues
+									  escapedContents:([(AIContentStatus *)content loggedMessage] ?
+													   [xhtmlDecoder encodeHTML:[(AIContentStatus *)content loggedMessage] imagesPath:nil] :
+													   @"")
+										   toAppender:[bself _appenderForChat:chat]
+											  forChat:chat];
 						
 						dirty = YES;
 					}
@@ -1120,14 +1145,13 @@ NSComparisonResult sortPaths(NSString *path1, NSString *path2, void *context)
 						[attributeValues addObject:[[content source] displayName]];				
 					}
 					
-					AIXMLElement *statusElement = [[[AIXMLElement alloc] initWithName:@"status"] autorelease];
-					
-					[statusElement addEscapedObject:[xhtmlDecoder encodeHTML:[content message]
-																  imagesPath:[[appender path] stringByDeletingLastPathComponent]]];
-					
-					[statusElement setAttributeNames:attributeKeys values:attributeValues];
-					
-					[appender appendElement:statusElement];
+					[self _appendElementWithName:@"status"
+								  attributeNames:attributeKeys
+										  values:attributeValues
+								 escapedContents:[xhtmlDecoder encodeHTML:[content message]
+															   imagesPath:[[appender path] stringByDeletingLastPathComponent]]
+									  toAppender:appender
+										 forChat:chat];
 					dirty = YES;
 				}
 			}
@@ -1163,9 +1187,9 @@ NSComparisonResult sortPaths(NSString *path1, NSString *path2, void *context)
 		AIXMLElement *eventElement = [[[AIXMLElement alloc] initWithName:@"event"] autorelease];
 		
 		[eventElement setAttributeNames:[NSArray arrayWithObjects:@"type", @"sender", @"time", nil]
-								 values:[NSArray arrayWithObjects:@"windowOpened", chat.account.UID, [formatter stringFromDate:[[NSDate date] dateWithCalendarFormat:nil timeZone:nil]], nil]];
+								 values:[NSArray arrayWithObjects:@"windowOpened", chat.account.UID, [formatter stringFromDate:[NSDate date]], nil]];
 		
-		[appender appendElement:eventElement];
+		[self _appendElement:eventElement toAppender:appender forChat:chat];
 		
 		[self _markLogDirtyAtPath:[appender path] forChat:chat];
 	}
@@ -1185,10 +1209,10 @@ NSComparisonResult sortPaths(NSString *path1, NSString *path2, void *context)
 		AIXMLElement *eventElement = [[[AIXMLElement alloc] initWithName:@"event"] autorelease];
 		
 		[eventElement setAttributeNames:[NSArray arrayWithObjects:@"type", @"sender", @"time", nil]
-								 values:[NSArray arrayWithObjects:@"windowClosed", chat.account.UID, [formatter stringFromDate:[[NSDate date] dateWithCalendarFormat:nil timeZone:nil]], nil]];
+								 values:[NSArray arrayWithObjects:@"windowClosed", chat.account.UID, [formatter stringFromDate:[NSDate date]], nil]];
 		
 		
-		[appender appendElement:eventElement];
+		[self _appendElement:eventElement toAppender:appender forChat:chat];
 		[self closeAppenderForChat:chat];
 		
 		[self _markLogDirtyAtPath:[appender path] forChat:chat];
@@ -1210,6 +1234,9 @@ NSComparisonResult sortPaths(NSString *path1, NSString *path2, void *context)
 			[self finishClosingAppender:chatID];
 		}
 	}
+	
+	//The deleted log may hold messages the cache would otherwise show as history
+	[messageTailCache removeRecordsForKey:[[chatLog relativePath] stringByDeletingLastPathComponent]];
 }
 
 #pragma mark Logging Internals
@@ -1245,9 +1272,9 @@ NSComparisonResult sortPaths(NSString *path1, NSString *path2, void *context)
 		AIXMLElement *eventElement = [[[AIXMLElement alloc] initWithName:@"event"] autorelease];
 		
 		[eventElement setAttributeNames:[NSArray arrayWithObjects:@"type", @"sender", @"time", nil]
-								 values:[NSArray arrayWithObjects:@"windowOpened", chat.account.UID, [formatter stringFromDate:[[NSDate date] dateWithCalendarFormat:nil timeZone:nil]], nil]];
+								 values:[NSArray arrayWithObjects:@"windowOpened", chat.account.UID, [formatter stringFromDate:[NSDate date]], nil]];
 		
-		[appender appendElement:eventElement];
+		[self _appendElement:eventElement toAppender:appender forChat:chat];
 		
 		[activeAppenders setObject:appender forKey:[self keyForChat:chat]];
 		
@@ -1289,6 +1316,46 @@ NSComparisonResult sortPaths(NSString *path1, NSString *path2, void *context)
 	[activeAppenders removeObjectForKey:chatKey];
 }
 
+/*!
+ * @brief Log a message or status, adding it to the chat's message tail cache
+ */
+- (void)_appendElementWithName:(NSString *)elementName
+				attributeNames:(NSArray *)attrNames
+						values:(NSArray *)attrVals
+			   escapedContents:(NSString *)escapedContents
+					toAppender:(AIXMLAppender *)appender
+					   forChat:(AIChat *)chat
+{
+	NSDictionary *record = [AIMessageTailCache recordWithName:elementName
+											   attributeNames:attrNames
+													   values:attrVals
+											  escapedContents:escapedContents
+												  inLogBundle:[[appender.path stringByDeletingLastPathComponent] lastPathComponent]];
+	
+	[messageTailCache appendRecord:record
+					   toLogAtPath:appender.path
+							forKey:[[self class] relativePathForLogsLikeChat:chat]
+						   writing:^{
+							   [appender appendElementWithName:elementName
+												attributeNames:attrNames
+														values:attrVals
+											   escapedContents:escapedContents];
+						   }];
+}
+
+/*!
+ * @brief Log any other element, letting the chat's message tail cache know the log changed
+ */
+- (void)_appendElement:(AIXMLElement *)element toAppender:(AIXMLAppender *)appender forChat:(AIChat *)chat
+{
+	[messageTailCache appendRecord:nil
+					   toLogAtPath:appender.path
+							forKey:[[self class] relativePathForLogsLikeChat:chat]
+						   writing:^{
+							   [appender appendElement:element];
+						   }];
+}
+
 #pragma mark Log Indexing
 - (NSString *)_logIndexPath
 {
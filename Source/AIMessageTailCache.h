@@ -0,0 +1,85 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+//Record keys
+#define KEY_TAIL_RECORD_NAME		@"Name"
+#define KEY_TAIL_RECORD_ATTRIBUTES	@"Attributes"
+#define KEY_TAIL_RECORD_CONTENTS	@"Contents"
+#define KEY_TAIL_RECORD_LOG			@"Log"
+
+/*!
+ * @class AIMessageTailCache
+ * @brief Keeps the last few logged messages for each contact, so message history doesn't have to be parsed out of the logs
+ *
+ * There is one entry per log folder (an account and a contact or chat name, as in
+ * +[AILoggerPlugin relativePathForLogWithObject:onAccount:]), held in memory and on disk beneath the cache path. An
+ * entry holds the newest messages and statuses as records: dictionaries of the element name, its attributes, and its
+ * already-escaped XML contents, which is everything needed to recreate the content object.
+ *
+ * On disk, an entry is a small property list and a journal of the writes since it was saved. Each write appends to
+ * the journal; once the journal holds as many writes as the entry holds records, the property list is saved again
+ * and the journal started over.
+ *
+ * The logger keeps entries current by passing every write to a log through -appendRecord:toLogAtPath:forKey:writing:.
+ * Each entry remembers the size and modification date of the log it last saw written; if the log no longer matches,
+ * something other than the logger changed it, and the entry is started over.
+ *
+ * Entries are updated on the shared writer queue, in order with the log writes themselves. The other methods are
+ * meant for the main thread.
+ */
+@interface AIMessageTailCache : NSObject {
+	NSString			*cachePath;
+	NSUInteger			 capacity;
+
+	NSMutableDictionary	*entries;
+	NSMutableArray		*entryKeysByUse;
+	dispatch_queue_t	 entryQueue;
+
+	NSCountedSet		*pendingKeys;
+	NSCondition			*pendingCondition;
+}
+
+- (id)initWithCachePath:(NSString *)inCachePath;
+
+/*!
+ * @brief How many messages each entry keeps. Statuses in between them are kept as well.
+ */
+@property (readwrite, nonatomic) NSUInteger capacity;
+
+/*!
+ * @brief The most records an entry keeps, messages and statuses together
+ */
+@property (readonly, nonatomic) NSUInteger recordLimit;
+
++ (NSDictionary *)recordWithName:(NSString *)elementName
+				  attributeNames:(NSArray *)attrNames
+						  values:(NSArray *)attrVals
+				 escapedContents:(NSString *)escapedContents
+				     inLogBundle:(NSString *)bundleName;
+
+- (void)appendRecord:(NSDictionary *)record toLogAtPath:(NSString *)xmlPath forKey:(NSString *)key writing:(dispatch_block_t)writeBlock;
+- (void)waitForPendingWritesForKey:(NSString *)key;
+- (BOOL)waitForPendingWritesForKey:(NSString *)key untilDate:(NSDate *)limitDate;
+
+- (NSArray *)recordsForKey:(NSString *)key lines:(NSUInteger)lines alsoStatus:(BOOL)alsoStatus;
+- (void)setRecords:(NSArray *)records
+   includingStatus:(BOOL)includesStatus
+		  complete:(BOOL)complete
+	   toLogAtPath:(NSString *)xmlPath
+			forKey:(NSString *)key;
+- (void)removeRecordsForKey:(NSString *)key;
+
+@end
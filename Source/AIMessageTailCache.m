@@ -0,0 +1,667 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AIMessageTailCache.h"
+#import <Adium/ESDebugAILog.h>
+#import <AIUtilities/AISharedWriterQueue.h>
+#import <sys/stat.h>
+#import <fcntl.h>
+
+#define TAIL_CACHE_VERSION				1
+//Entries beyond this many are dropped from memory, least recently used first; they're still on disk
+#define MAX_ENTRIES_IN_MEMORY			200
+//However many statuses come between them, an entry never keeps more than this many times its capacity in records
+#define MAX_RECORDS_PER_MESSAGE			4
+
+#define KEY_TAIL_CACHE_VERSION			@"Version"
+#define KEY_TAIL_CACHE_RECORDS			@"Records"
+#define KEY_TAIL_CACHE_INCLUDES_STATUS	@"Includes Status"
+#define KEY_TAIL_CACHE_COMPLETE			@"Complete"
+#define KEY_TAIL_CACHE_LOG_PATH			@"Log Path"
+#define KEY_TAIL_CACHE_LOG_SIZE			@"Log Size"
+#define KEY_TAIL_CACHE_LOG_TIME			@"Log Modification Time"
+#define KEY_TAIL_JOURNAL_RECORD			@"Record"
+
+static BOOL isMessageRecord(NSDictionary *record)
+{
+	return [[record objectForKey:KEY_TAIL_RECORD_NAME] isEqualToString:@"message"];
+}
+
+/*!
+ * @brief Get the size and modification time, in nanoseconds, of a log
+ */
+static BOOL getLogState(NSString *path, unsigned long long *outSize, long long *outModificationTime)
+{
+	struct stat sb;
+
+	if (!path || stat([path fileSystemRepresentation], &sb) != 0) return NO;
+
+	*outSize = sb.st_size;
+	*outModificationTime = (long long)sb.st_mtimespec.tv_sec * NSEC_PER_SEC + sb.st_mtimespec.tv_nsec;
+
+	return YES;
+}
+
+/*!
+ * @class AIMessageTailCacheEntry
+ * @brief The newest records of one log folder, and the state of the log they were last seen in
+ */
+@interface AIMessageTailCacheEntry : NSObject {
+@public
+	NSMutableArray		*records;
+	NSUInteger			 messageCount;
+	BOOL				 includesStatus;
+	BOOL				 complete;
+
+	NSString			*logPath;
+	unsigned long long	 logSize;
+	long long			 logModificationTime;
+
+	NSUInteger			 journalLength;	//Writes journaled since the entry was last saved
+}
+- (id)initWithPropertyList:(NSDictionary *)propertyList;
+- (NSDictionary *)propertyList;
+- (NSDictionary *)journalEntryWithRecord:(NSDictionary *)record;
+- (void)replayJournal:(NSData *)journal capacity:(NSUInteger)capacity;
+- (BOOL)matchesLog;
+- (void)noteLogAtPath:(NSString *)path;
+- (void)addRecord:(NSDictionary *)record capacity:(NSUInteger)capacity;
+- (void)trimToCapacity:(NSUInteger)capacity;
+- (NSArray *)recordsForLines:(NSUInteger)lines alsoStatus:(BOOL)alsoStatus;
+@end
+
+@implementation AIMessageTailCacheEntry
+
+/*!
+ * @brief A new, empty entry, which holds everything logged from now on
+ */
+- (id)init
+{
+	if ((self = [super init])) {
+		records = [[NSMutableArray alloc] init];
+		includesStatus = YES;
+	}
+
+	return self;
+}
+
+- (id)initWithPropertyList:(NSDictionary *)propertyList
+{
+	if ([[propertyList objectForKey:KEY_TAIL_CACHE_VERSION] integerValue] != TAIL_CACHE_VERSION) {
+		[self release];
+		return nil;
+	}
+
+	if ((self = [self init])) {
+		[records setArray:[propertyList objectForKey:KEY_TAIL_CACHE_RECORDS]];
+		for (NSDictionary *record in records) {
+			if (isMessageRecord(record)) messageCount++;
+		}
+
+		includesStatus = [[propertyList objectForKey:KEY_TAIL_CACHE_INCLUDES_STATUS] boolValue];
+		complete = [[propertyList objectForKey:KEY_TAIL_CACHE_COMPLETE] boolValue];
+		logPath = [[propertyList objectForKey:KEY_TAIL_CACHE_LOG_PATH] copy];
+		logSize = [[propertyList objectForKey:KEY_TAIL_CACHE_LOG_SIZE] unsignedLongLongValue];
+		logModificationTime = [[propertyList objectForKey:KEY_TAIL_CACHE_LOG_TIME] longLongValue];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[records release];
+	[logPath release];
+
+	[super dealloc];
+}
+
+- (NSDictionary *)propertyList
+{
+	NSMutableDictionary *propertyList = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+										 [NSNumber numberWithInteger:TAIL_CACHE_VERSION], KEY_TAIL_CACHE_VERSION,
+										 [[records copy] autorelease], KEY_TAIL_CACHE_RECORDS,
+										 [NSNumber numberWithBool:includesStatus], KEY_TAIL_CACHE_INCLUDES_STATUS,
+										 [NSNumber numberWithBool:complete], KEY_TAIL_CACHE_COMPLETE,
+										 [NSNumber numberWithUnsignedLongLong:logSize], KEY_TAIL_CACHE_LOG_SIZE,
+										 [NSNumber numberWithLongLong:logModificationTime], KEY_TAIL_CACHE_LOG_TIME,
+										 nil];
+	if (logPath) [propertyList setObject:logPath forKey:KEY_TAIL_CACHE_LOG_PATH];
+
+	return propertyList;
+}
+
+/*!
+ * @brief A journal entry for a write: its record, if any, and the log as the write left it
+ */
+- (NSDictionary *)journalEntryWithRecord:(NSDictionary *)record
+{
+	NSMutableDictionary *journalEntry = [NSMutableDictionary dictionaryWithObjectsAndKeys:
+										 [NSNumber numberWithUnsignedLongLong:logSize], KEY_TAIL_CACHE_LOG_SIZE,
+										 [NSNumber numberWithLongLong:logModificationTime], KEY_TAIL_CACHE_LOG_TIME,
+										 nil];
+	if (record) [journalEntry setObject:record forKey:KEY_TAIL_JOURNAL_RECORD];
+	if (logPath) [journalEntry setObject:logPath forKey:KEY_TAIL_CACHE_LOG_PATH];
+
+	return journalEntry;
+}
+
+/*!
+ * @brief Apply the writes journaled since this entry was saved
+ *
+ * The journal is a series of binary property lists, each preceded by its length as a big-endian 32-bit integer. A
+ * write cut short at the end, such as by a crash, is ignored; the log then won't match and the entry is started over.
+ */
+- (void)replayJournal:(NSData *)journal capacity:(NSUInteger)capacity
+{
+	const uint8_t	*bytes = [journal bytes];
+	NSUInteger		 length = [journal length];
+	NSUInteger		 offset = 0;
+
+	while (length - offset >= sizeof(uint32_t)) {
+		uint32_t entryLength;
+		memcpy(&entryLength, bytes + offset, sizeof(entryLength));
+		entryLength = CFSwapInt32BigToHost(entryLength);
+		offset += sizeof(entryLength);
+
+		if (length - offset < entryLength) break;
+
+		NSDictionary *journalEntry = [NSPropertyListSerialization propertyListFromData:[journal subdataWithRange:NSMakeRange(offset, entryLength)]
+																	  mutabilityOption:NSPropertyListImmutable
+																				format:NULL
+																	  errorDescription:NULL];
+		offset += entryLength;
+		if (![journalEntry isKindOfClass:[NSDictionary class]]) break;
+
+		NSDictionary *record = [journalEntry objectForKey:KEY_TAIL_JOURNAL_RECORD];
+		if (record) [self addRecord:record capacity:capacity];
+
+		NSString *journaledLogPath = [journalEntry objectForKey:KEY_TAIL_CACHE_LOG_PATH];
+		if (journaledLogPath != logPath) {
+			[logPath release];
+			logPath = [journaledLogPath copy];
+		}
+		logSize = [[journalEntry objectForKey:KEY_TAIL_CACHE_LOG_SIZE] unsignedLongLongValue];
+		logModificationTime = [[journalEntry objectForKey:KEY_TAIL_CACHE_LOG_TIME] longLongValue];
+
+		journalLength++;
+	}
+}
+
+/*!
+ * @brief Is the log this entry last saw written still as it was then?
+ *
+ * An entry which hasn't seen a log yet has nothing to be out of date with.
+ */
+- (BOOL)matchesLog
+{
+	if (!logPath) return YES;
+
+	unsigned long long	size;
+	long long			modificationTime;
+
+	return (getLogState(logPath, &size, &modificationTime) && size == logSize && modificationTime == logModificationTime);
+}
+
+- (void)noteLogAtPath:(NSString *)path
+{
+	if (logPath != path) {
+		[logPath release];
+		logPath = [path copy];
+	}
+
+	if (!getLogState(logPath, &logSize, &logModificationTime)) {
+		logSize = 0;
+		logModificationTime = 0;
+	}
+}
+
+- (void)addRecord:(NSDictionary *)record capacity:(NSUInteger)capacity
+{
+	[records addObject:record];
+	if (isMessageRecord(record)) messageCount++;
+
+	[self trimToCapacity:capacity];
+}
+
+/*!
+ * @brief Drop the oldest records while there are more than capacity messages, or too many records altogether
+ *
+ * Statuses older than the oldest message kept are dropped along with it.
+ */
+- (void)trimToCapacity:(NSUInteger)capacity
+{
+	NSUInteger removeCount = 0;
+	NSUInteger remainingMessages = messageCount;
+	NSUInteger count = records.count;
+
+	while (count - removeCount > capacity) {
+		BOOL isMessage = isMessageRecord([records objectAtIndex:removeCount]);
+
+		if (isMessage && remainingMessages <= capacity && count - removeCount <= capacity * MAX_RECORDS_PER_MESSAGE)
+			break;
+
+		if (isMessage) remainingMessages--;
+		removeCount++;
+	}
+
+	if (removeCount) {
+		[records removeObjectsInRange:NSMakeRange(0, removeCount)];
+		messageCount = remainingMessages;
+		complete = NO;
+	}
+}
+
+/*!
+ * @brief The newest lines records, oldest first, or nil if this entry doesn't hold enough to say
+ *
+ * @param alsoStatus If YES, statuses are returned and counted as lines along with messages
+ */
+- (NSArray *)recordsForLines:(NSUInteger)lines alsoStatus:(BOOL)alsoStatus
+{
+	if (alsoStatus) {
+		if (!includesStatus || (records.count < lines && !complete)) return nil;
+
+		NSUInteger count = MIN(lines, records.count);
+		return [records subarrayWithRange:NSMakeRange(records.count - count, count)];
+	}
+
+	if (messageCount < lines && !complete) return nil;
+
+	NSMutableArray *found = [NSMutableArray arrayWithCapacity:MIN(lines, messageCount)];
+	for (NSDictionary *record in [records reverseObjectEnumerator]) {
+		if (found.count == lines) break;
+		if (isMessageRecord(record)) [found insertObject:record atIndex:0];
+	}
+
+	return found;
+}
+
+@end
+
+#pragma mark -
+
+@interface AIMessageTailCache ()
+- (NSString *)pathForKey:(NSString *)key;
+- (NSString *)journalPathForKey:(NSString *)key;
+- (AIMessageTailCacheEntry *)entryForKey:(NSString *)key;
+- (void)rememberEntry:(AIMessageTailCacheEntry *)entry forKey:(NSString *)key;
+- (void)forgetEntryForKey:(NSString *)key;
+- (void)writePropertyList:(NSDictionary *)propertyList forKey:(NSString *)key;
+- (void)appendJournalEntry:(NSDictionary *)journalEntry forKey:(NSString *)key;
+- (void)removeFilesForKey:(NSString *)key;
+- (void)finishPendingWriteForKey:(NSString *)key;
+@end
+
+@implementation AIMessageTailCache
+
+- (id)initWithCachePath:(NSString *)inCachePath
+{
+	if ((self = [super init])) {
+		cachePath = [inCachePath copy];
+		capacity = 50;
+		entries = [[NSMutableDictionary alloc] init];
+		entryKeysByUse = [[NSMutableArray alloc] init];
+		entryQueue = dispatch_queue_create("im.adium.AIMessageTailCache.entryQueue", 0);
+		pendingKeys = [[NSCountedSet alloc] init];
+		pendingCondition = [[NSCondition alloc] init];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	dispatch_release(entryQueue);
+	[pendingKeys release];
+	[pendingCondition release];
+	[entries release];
+	[entryKeysByUse release];
+	[cachePath release];
+
+	[super dealloc];
+}
+
+@synthesize capacity;
+
+- (NSUInteger)recordLimit
+{
+	return capacity * MAX_RECORDS_PER_MESSAGE;
+}
+
+/*!
+ * @brief A record for an element the logger is about to write
+ *
+ * @param bundleName The name of the .chatlog bundle the element is written into, against which any images in
+ *                   its contents are resolved; nil if the log isn't a bundle
+ */
++ (NSDictionary *)recordWithName:(NSString *)elementName
+				  attributeNames:(NSArray *)attrNames
+						  values:(NSArray *)attrVals
+				 escapedContents:(NSString *)escapedContents
+				     inLogBundle:(NSString *)bundleName
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			elementName, KEY_TAIL_RECORD_NAME,
+			[NSDictionary dictionaryWithObjects:attrVals forKeys:attrNames], KEY_TAIL_RECORD_ATTRIBUTES,
+			(escapedContents ?: @""), KEY_TAIL_RECORD_CONTENTS,
+			bundleName, KEY_TAIL_RECORD_LOG,
+			nil];
+}
+
+- (NSString *)pathForKey:(NSString *)key
+{
+	return [[cachePath stringByAppendingPathComponent:key] stringByAppendingPathExtension:@"plist"];
+}
+
+- (NSString *)journalPathForKey:(NSString *)key
+{
+	return [[cachePath stringByAppendingPathComponent:key] stringByAppendingPathExtension:@"journal"];
+}
+
+/*!
+ * @brief The entry for a key, from memory or disk. Call on entryQueue.
+ */
+- (AIMessageTailCacheEntry *)entryForKey:(NSString *)key
+{
+	AIMessageTailCacheEntry *entry = [entries objectForKey:key];
+
+	if (entry) {
+		//Move this entry to the front, so the least used entries are at the back for removal
+		[entryKeysByUse removeObject:key];
+		[entryKeysByUse insertObject:key atIndex:0];
+
+	} else {
+		NSData			*data = [NSData dataWithContentsOfFile:[self pathForKey:key]];
+		NSDictionary	*propertyList = (data ?
+										 [NSPropertyListSerialization propertyListFromData:data
+																		  mutabilityOption:NSPropertyListImmutable
+																					format:NULL
+																		  errorDescription:NULL] :
+										 nil);
+
+		if ([propertyList isKindOfClass:[NSDictionary class]]) {
+			entry = [[[AIMessageTailCacheEntry alloc] initWithPropertyList:propertyList] autorelease];
+			[entry replayJournal:[NSData dataWithContentsOfFile:[self journalPathForKey:key]] capacity:capacity];
+			if (entry) [self rememberEntry:entry forKey:key];
+		}
+	}
+
+	return entry;
+}
+
+/*!
+ * @brief Keep an entry in memory, dropping the least recently used entry if there are too many. Call on entryQueue.
+ */
+- (void)rememberEntry:(AIMessageTailCacheEntry *)entry forKey:(NSString *)key
+{
+	if (entries.count >= MAX_ENTRIES_IN_MEMORY && ![entries objectForKey:key])
+		[self forgetEntryForKey:[entryKeysByUse lastObject]];
+
+	[entries setObject:entry forKey:key];
+	[entryKeysByUse removeObject:key];
+	[entryKeysByUse insertObject:key atIndex:0];
+}
+
+/*!
+ * @brief Drop an entry from memory. Call on entryQueue.
+ */
+- (void)forgetEntryForKey:(NSString *)key
+{
+	[entries removeObjectForKey:key];
+	[entryKeysByUse removeObject:key];
+}
+
+/*!
+ * @brief Save an entry, starting its journal over. Call on the shared writer queue.
+ *
+ * The old journal goes first: an entry whose journal is lost is merely out of date, whereas one whose journal is
+ * replayed over a newer save would repeat records.
+ */
+- (void)writePropertyList:(NSDictionary *)propertyList forKey:(NSString *)key
+{
+	NSString	*path = [self pathForKey:key];
+	NSData		*data = [NSPropertyListSerialization dataFromPropertyList:propertyList
+																format:NSPropertyListBinaryFormat_v1_0
+													  errorDescription:NULL];
+
+	[[NSFileManager defaultManager] removeItemAtPath:[self journalPathForKey:key] error:NULL];
+	[[NSFileManager defaultManager] createDirectoryAtPath:[path stringByDeletingLastPathComponent]
+							  withIntermediateDirectories:YES
+											   attributes:nil
+													error:NULL];
+	if (![data writeToFile:path atomically:YES])
+		AILogWithSignature(@"Couldn't write message tail cache %@", path);
+}
+
+/*!
+ * @brief Append a write to an entry's journal. Call on the shared writer queue.
+ */
+- (void)appendJournalEntry:(NSDictionary *)journalEntry forKey:(NSString *)key
+{
+	NSString		*path = [self journalPathForKey:key];
+	NSData			*data = [NSPropertyListSerialization dataFromPropertyList:journalEntry
+																	format:NSPropertyListBinaryFormat_v1_0
+														  errorDescription:NULL];
+	uint32_t		 length = CFSwapInt32HostToBig((uint32_t)[data length]);
+	NSMutableData	*frame = [NSMutableData dataWithBytes:&length length:sizeof(length)];
+	int				 fd;
+
+	[frame appendData:data];
+
+	fd = open([path fileSystemRepresentation], O_WRONLY | O_APPEND | O_CREAT, 0644);
+	if (fd == -1 || write(fd, [frame bytes], [frame length]) != (ssize_t)[frame length])
+		AILogWithSignature(@"Couldn't append to message tail cache journal %@", path);
+	if (fd != -1) close(fd);
+}
+
+/*!
+ * @brief Remove an entry from disk. Call on the shared writer queue.
+ */
+- (void)removeFilesForKey:(NSString *)key
+{
+	[[NSFileManager defaultManager] removeItemAtPath:[self journalPathForKey:key] error:NULL];
+	[[NSFileManager defaultManager] removeItemAtPath:[self pathForKey:key] error:NULL];
+}
+
+/*!
+ * @brief Write to a log, keeping its entry current
+ *
+ * Call this on the main thread for every write to a log, including ones which aren't messages or statuses, so that
+ * the entry can tell the logger's own changes to the log from anyone else's.
+ *
+ * @param record The record for what is written, or nil if it's neither a message nor a status
+ * @param xmlPath The path of the XML file being written to
+ * @param key The log folder's path relative to the logs folder
+ * @param writeBlock Performs the write, by adding it to the shared writer queue
+ */
+- (void)appendRecord:(NSDictionary *)record toLogAtPath:(NSString *)xmlPath forKey:(NSString *)key writing:(dispatch_block_t)writeBlock
+{
+	__block BOOL wasCurrent = NO;
+
+	[pendingCondition lock];
+	[pendingKeys addObject:key];
+	[pendingCondition unlock];
+
+	//Before the write: was the log as this entry last saw it?
+	[AISharedWriterQueue addOperation:^{
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		dispatch_sync(entryQueue, ^{
+			AIMessageTailCacheEntry *entry = [self entryForKey:key];
+			wasCurrent = (entry && [entry matchesLog]);
+		});
+		[pool release];
+	}];
+
+	writeBlock();
+
+	//After the write: add the record, note the log as we left it, and save or journal the change
+	[AISharedWriterQueue addOperation:^{
+		NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+		__block NSDictionary *propertyList = nil;
+		__block NSDictionary *journalEntry = nil;
+		__block BOOL		 removeFiles = NO;
+
+		dispatch_sync(entryQueue, ^{
+			AIMessageTailCacheEntry *entry = [self entryForKey:key];
+
+			if (!wasCurrent) {
+				//Without a record there's nothing to start a new entry with
+				if (!record) {
+					if (entry) [self forgetEntryForKey:key];
+					removeFiles = YES;
+					return;
+				}
+
+				entry = [[[AIMessageTailCacheEntry alloc] init] autorelease];
+				[self rememberEntry:entry forKey:key];
+			}
+
+			if (record) [entry addRecord:record capacity:capacity];
+			[entry noteLogAtPath:xmlPath];
+
+			if (!wasCurrent || entry->journalLength >= self.recordLimit) {
+				propertyList = [[entry propertyList] retain];
+				entry->journalLength = 0;
+			} else {
+				journalEntry = [[entry journalEntryWithRecord:record] retain];
+				entry->journalLength++;
+			}
+		});
+
+		if (removeFiles) {
+			[self removeFilesForKey:key];
+		} else if (propertyList) {
+			[self writePropertyList:propertyList forKey:key];
+			[propertyList release];
+		} else if (journalEntry) {
+			[self appendJournalEntry:journalEntry forKey:key];
+			[journalEntry release];
+		}
+
+		[self finishPendingWriteForKey:key];
+
+		[pool release];
+	}];
+}
+
+- (void)finishPendingWriteForKey:(NSString *)key
+{
+	[pendingCondition lock];
+	[pendingKeys removeObject:key];
+	[pendingCondition broadcast];
+	[pendingCondition unlock];
+}
+
+/*!
+ * @brief Wait until every write passed to -appendRecord:toLogAtPath:forKey:writing: for a key is in its log
+ *
+ * Writes for other keys may still be pending when this returns; if there are none for key, it returns at once.
+ */
+- (void)waitForPendingWritesForKey:(NSString *)key
+{
+	[self waitForPendingWritesForKey:key untilDate:[NSDate distantFuture]];
+}
+
+/*!
+ * @brief Wait no later than limitDate for the writes for a key to be in its log
+ *
+ * @result YES if there are no writes pending for key, NO if some still were at limitDate
+ */
+- (BOOL)waitForPendingWritesForKey:(NSString *)key untilDate:(NSDate *)limitDate
+{
+	BOOL finished;
+
+	[pendingCondition lock];
+	while ([pendingKeys countForObject:key] && [pendingCondition waitUntilDate:limitDate]) {}
+	finished = ([pendingKeys countForObject:key] == 0);
+	[pendingCondition unlock];
+
+	return finished;
+}
+
+/*!
+ * @brief The newest records for a key, oldest first
+ *
+ * @result The records, or nil if the entry is missing, out of date, or too short to provide that many lines
+ */
+- (NSArray *)recordsForKey:(NSString *)key lines:(NSUInteger)lines alsoStatus:(BOOL)alsoStatus
+{
+	__block NSArray *records = nil;
+
+	dispatch_sync(entryQueue, ^{
+		AIMessageTailCacheEntry *entry = [self entryForKey:key];
+
+		if (entry && entry->logPath && [entry matchesLog])
+			records = [[entry recordsForLines:lines alsoStatus:alsoStatus] retain];
+	});
+
+	return [records autorelease];
+}
+
+/*!
+ * @brief Replace the records for a key with ones read from the logs
+ *
+ * Call -waitForPendingWritesForKey: first, so that the logs hold everything the logger has written for key.
+ *
+ * @param records The newest records, oldest first
+ * @param includesStatus YES if statuses were read as well as messages
+ * @param complete YES if these are all the records in the logs
+ * @param xmlPath The newest log, which will be written to next
+ */
+- (void)setRecords:(NSArray *)records
+   includingStatus:(BOOL)includesStatus
+		  complete:(BOOL)complete
+	   toLogAtPath:(NSString *)xmlPath
+			forKey:(NSString *)key
+{
+	AIMessageTailCacheEntry *entry = [[[AIMessageTailCacheEntry alloc] init] autorelease];
+
+	for (NSDictionary *record in records) {
+		[entry addRecord:record capacity:capacity];
+	}
+	entry->includesStatus = includesStatus;
+	entry->complete = (complete && entry->records.count == records.count);
+	[entry noteLogAtPath:xmlPath];
+
+	NSDictionary *propertyList = [entry propertyList];
+
+	dispatch_sync(entryQueue, ^{
+		[self rememberEntry:entry forKey:key];
+	});
+
+	[AISharedWriterQueue addOperation:^{
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		[self writePropertyList:propertyList forKey:key];
+		[pool release];
+	}];
+}
+
+/*!
+ * @brief Forget the records for a key, such as when its logs are deleted
+ */
+- (void)removeRecordsForKey:(NSString *)key
+{
+	dispatch_sync(entryQueue, ^{
+		[self forgetEntryForKey:key];
+	});
+
+	[AISharedWriterQueue addOperation:^{
+		[self removeFilesForKey:key];
+	}];
+}
+
+@end
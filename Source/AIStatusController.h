@@ -24,14 +24,24 @@
 	//Status states
 	AIStatusGroup			*_rootStateGroup;
 	NSMutableSet			*_flatStatusSet;
+	NSMutableDictionary		*_statusesByUniqueStatusID; //Cached index of _flatStatusSet
+	NSUInteger				statusArrayVersion;
 	NSMutableArray			*builtInStateArray;
 
 	AIStatus				*offlineStatusState; //Shared state used to symbolize the offline 'status'
 	
 	AIStatus				*_activeStatusState; //Cached active status state
-	NSMutableSet			*_allActiveStatusStates; //Cached all active status states
+	NSSet					*_allActiveStatusStates; //Cached all active status states
 	NSMutableDictionary		*statusDictsByServiceCodeUniqueID[STATUS_TYPES_COUNT];
 	NSMutableSet			*builtInStatusTypes[STATUS_TYPES_COUNT];
+	NSMutableDictionary		*statusMenuTemplates;
+
+	//What each account contributes to the active status states, kept up to date as accounts change
+	NSMutableDictionary		*onlineStatusByAccountID;
+	NSMutableDictionary		*enabledStatusByAccountID;
+	NSCountedSet			*onlineStatusCounts;
+	NSCountedSet			*enabledStatusCounts;
+	BOOL					activeStatusChangedWhileDelayed;
 
 	NSMutableSet			*accountsToConnect;
 
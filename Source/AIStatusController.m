@@ -50,8 +50,16 @@
 							 fromSet:(NSSet *)sourceArray
 							 toArray:(NSMutableArray *)menuItems
 				  alreadyAddedTitles:(NSMutableSet *)alreadyAddedTitles;
+- (NSArray *)_statusMenuTemplateForServiceCodeUniqueID:(NSString *)inServiceCodeUniqueID;
 - (void)buildBuiltInStatusTypes;
 - (void)notifyOfChangedStatusArray;
+- (void)_invalidateStatusArrayCaches;
+- (void)_discardActiveStatusAggregates;
+- (void)_buildActiveStatusAggregates;
+- (BOOL)_updateActiveStatusAggregatesForAccount:(AIAccount *)account;
+- (void)_updateActiveStatusForAccounts:(NSArray *)accounts;
+- (void)statusIconSetChanged:(NSNotification *)notification;
+- (void)accountListChanged:(NSNotification *)notification;
 @end
 
 /*!
@@ -73,6 +81,7 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 		stateMenuItemArraysDict = [[NSMutableDictionary alloc] init];
 		stateMenuPluginsArray = [[NSMutableArray alloc] init];
 		stateMenuItemsNeedingUpdating = [[NSMutableSet alloc] init];
+		statusMenuTemplates = [[NSMutableDictionary alloc] init];
 		activeStatusUpdateDelays = 0;
 		_sortedFullStateArray = nil;
 		_activeStatusState = nil;
@@ -96,6 +105,15 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 {
 	[[AIContactObserverManager sharedManager] registerListObjectObserver:self];
 
+	[[NSNotificationCenter defaultCenter] addObserver:self
+											 selector:@selector(statusIconSetChanged:)
+												 name:AIStatusIconSetDidChangeNotification
+											   object:nil];
+	[[NSNotificationCenter defaultCenter] addObserver:self
+											 selector:@selector(accountListChanged:)
+												 name:Account_ListChanged
+											   object:nil];
+
 	[self buildBuiltInStatusTypes];
 
 	//Put each account into the status it was in last time we quit.
@@ -128,6 +146,8 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 				 * so modify it directly for efficiency.
 				 */
 				[_flatStatusSet addObject:lastStatus];
+				if ([lastStatus preexistingUniqueStatusID] != -1)
+					[_statusesByUniqueStatusID setObject:lastStatus forKey:[lastStatus uniqueStatusID]];
 
 				needToRebuildMenus = YES;
 			}
@@ -139,6 +159,9 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 		}
 	}
 
+	//The accounts were put into their states without notifying us, so count them up again when next asked
+	[self _discardActiveStatusAggregates];
+
 	if (needToRebuildMenus) {
 		[self notifyOfChangedStatusArray];
 	}
@@ -185,6 +208,9 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 {
 	[_rootStateGroup release]; _rootStateGroup = nil;
 	[_sortedFullStateArray release]; _sortedFullStateArray = nil;
+	[_statusesByUniqueStatusID release]; _statusesByUniqueStatusID = nil;
+	[statusMenuTemplates release]; statusMenuTemplates = nil;
+	[self _discardActiveStatusAggregates];
 	[super dealloc];
 }
 
@@ -222,12 +248,17 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 		nil];
 
 	[statusDicts addObject:statusDict];
+
+	//Menus for this service, and for all active services, need to include the new status
+	[statusMenuTemplates removeAllObjects];
 }
 
 #pragma mark Status menus
 /*!
  * @brief Generate and return a menu of status types (Away, Be right back, etc.)
  *
+ * The menu items are copied from a template which is built the first time a service's menu is requested.
+ *
  * @param service The service for which to return a specific list of types, or nil to return all available types
  * @param target The target for the menu items, which will have an action of @selector(selectStatus:)
  *
@@ -236,31 +267,85 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 - (NSMenu *)menuOfStatusesForService:(AIService *)service withTarget:(id)target
 {
 	NSMenu			*menu = [[NSMenu allocWithZone:[NSMenu menuZone]] init];
-	NSMenuItem		*menuItem;
-	NSString		*serviceCodeUniqueID = service.serviceCodeUniqueID;
+	NSArray			*template = [self _statusMenuTemplateForServiceCodeUniqueID:service.serviceCodeUniqueID];
 	AIStatusType	type;
 
-	for (type = AIAvailableStatusType ; type < STATUS_TYPES_COUNT ; type++) {
-		NSArray		*menuItemArray;
+	[menu setMenuChangedMessagesEnabled:NO];
 
-		menuItemArray = [self _menuItemsForStatusesOfType:type
-								   forServiceCodeUniqueID:serviceCodeUniqueID
-											   withTarget:target];
+	for (type = AIAvailableStatusType ; type < STATUS_TYPES_COUNT ; type++) {
+		NSArray		*templateItems = [template objectAtIndex:type];
 
 		//Add a separator between each type after available
-		if ((type > AIAvailableStatusType) && [menuItemArray count]) {
+		if ((type > AIAvailableStatusType) && [templateItems count]) {
 			[menu addItem:[NSMenuItem separatorItem]];
 		}
 
 		//Add the items for this type
-		for (menuItem in menuItemArray) {
+		for (NSMenuItem *templateItem in templateItems) {
+			NSMenuItem	*menuItem = [templateItem copy];
+
+			[menuItem setTarget:target];
 			[menu addItem:menuItem];
+			[menuItem release];
 		}
 	}
 
+	[menu setMenuChangedMessagesEnabled:YES];
+
 	return [menu autorelease];
 }
 
+/*!
+ * @brief Return the menu items, by AIStatusType, from which menus of statuses for a service are copied
+ *
+ * Templates are kept until a status is registered or the status icon set changes.
+ *
+ * @param inServiceCodeUniqueID The service, or nil for all statuses of the services of active accounts
+ *
+ * @result An <tt>NSArray</tt> with an <tt>NSArray</tt> of target-less <tt>NSMenuItem</tt> objects for each AIStatusType
+ */
+- (NSArray *)_statusMenuTemplateForServiceCodeUniqueID:(NSString *)inServiceCodeUniqueID
+{
+	NSString	*templateKey = inServiceCodeUniqueID;
+	NSArray		*template;
+
+	if (!templateKey) {
+		//The menu for all services depends on which services are active, so key it by them
+		NSMutableArray	*serviceCodeUniqueIDs = [NSMutableArray array];
+
+		for (AIService *service in [adium.accountController activeServicesIncludingCompatibleServices:NO]) {
+			[serviceCodeUniqueIDs addObject:service.serviceCodeUniqueID];
+		}
+		[serviceCodeUniqueIDs sortUsingSelector:@selector(compare:)];
+
+		templateKey = [@"\n" stringByAppendingString:[serviceCodeUniqueIDs componentsJoinedByString:@"\n"]];
+	}
+
+	if (!(template = [statusMenuTemplates objectForKey:templateKey])) {
+		NSMutableArray	*templateItemArrays = [NSMutableArray arrayWithCapacity:STATUS_TYPES_COUNT];
+		AIStatusType	type;
+
+		for (type = AIAvailableStatusType ; type < STATUS_TYPES_COUNT ; type++) {
+			[templateItemArrays addObject:[self _menuItemsForStatusesOfType:type
+													 forServiceCodeUniqueID:inServiceCodeUniqueID
+																 withTarget:nil]];
+		}
+
+		template = templateItemArrays;
+		[statusMenuTemplates setObject:template forKey:templateKey];
+	}
+
+	return template;
+}
+
+/*!
+ * @brief The status icon set changed; the icons in our menu templates are out of date
+ */
+- (void)statusIconSetChanged:(NSNotification *)notification
+{
+	[statusMenuTemplates removeAllObjects];
+}
+
 /*!
  * @brief Return an array of menu items for an AIStatusType and service
  *
@@ -499,43 +584,146 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 }
 
 /*!
- * @brief Reset the active status state
+ * @brief Replace the status an account contributes to one of the active status counts
+ *
+ * @result YES if the account's status changed
+ */
+static BOOL replaceCountedStatus(NSMutableDictionary *statusByAccountID, NSCountedSet *statusCounts, NSString *accountID, AIStatus *newStatus)
+{
+	AIStatus	*oldStatus = [statusByAccountID objectForKey:accountID];
+
+	if (oldStatus == newStatus) return NO;
+
+	if (oldStatus) [statusCounts removeObject:oldStatus];
+
+	if (newStatus) {
+		[statusCounts addObject:newStatus];
+		[statusByAccountID setObject:newStatus forKey:accountID];
+	} else {
+		[statusByAccountID removeObjectForKey:accountID];
+	}
+
+	return YES;
+}
+
+/*!
+ * @brief Bring an account's contribution to the active status counts up to date
+ *
+ * Online accounts count towards activeStatusState, and enabled accounts towards allActiveStatusStates.
  *
- * All active status states cache will also reset.  Posts an active status changed notification.  The active state
- * will be regenerated the next time it is requested.
+ * @result YES if the account's status state changed, or it came online, went offline, was enabled or was disabled
  */
-- (void)_resetActiveStatusState
+- (BOOL)_updateActiveStatusAggregatesForAccount:(AIAccount *)account
 {
-	//Clear the active status state.  It will be rebuilt next time it is requested
+	NSString	*accountID = account.internalObjectID;
+	AIStatus	*statusState = account.statusState;
+	AIStatus	*onlineStatus = nil;
+	BOOL		changed;
+
+	if (account.online) {
+		onlineStatus = (statusState ? statusState : self.defaultInitialStatusState);
+	}
+
+	changed = replaceCountedStatus(onlineStatusByAccountID, onlineStatusCounts, accountID, onlineStatus);
+	if (replaceCountedStatus(enabledStatusByAccountID, enabledStatusCounts, accountID, (account.enabled ? statusState : nil))) {
+		changed = YES;
+	}
+
+	return changed;
+}
+
+/*!
+ * @brief Forget the active status counts; they will be counted up from all accounts when next needed
+ */
+- (void)_discardActiveStatusAggregates
+{
+	[onlineStatusByAccountID release]; onlineStatusByAccountID = nil;
+	[enabledStatusByAccountID release]; enabledStatusByAccountID = nil;
+	[onlineStatusCounts release]; onlineStatusCounts = nil;
+	[enabledStatusCounts release]; enabledStatusCounts = nil;
+
 	[_activeStatusState release]; _activeStatusState = nil;
 	[_allActiveStatusStates release]; _allActiveStatusStates = nil;
+}
 
-	//Let observers know the active state has changed
-	if (!activeStatusUpdateDelays) {
-		[[NSNotificationCenter defaultCenter] postNotificationName:AIStatusActiveStateChangedNotification object:nil];
+/*!
+ * @brief Count up the active statuses of all accounts
+ */
+- (void)_buildActiveStatusAggregates
+{
+	[self _discardActiveStatusAggregates];
+
+	onlineStatusByAccountID = [[NSMutableDictionary alloc] init];
+	enabledStatusByAccountID = [[NSMutableDictionary alloc] init];
+	onlineStatusCounts = [[NSCountedSet alloc] init];
+	enabledStatusCounts = [[NSCountedSet alloc] init];
+
+	for (AIAccount *account in adium.accountController.accounts) {
+		[self _updateActiveStatusAggregatesForAccount:account];
+	}
+}
+
+/*!
+ * @brief Some accounts may have changed status
+ *
+ * Update their contributions to the active status counts. If any changed, the cached active states are cleared and
+ * an active status changed notification is posted, or will be when active status updates are no longer delayed.
+ */
+- (void)_updateActiveStatusForAccounts:(NSArray *)accounts
+{
+	BOOL	changed = NO;
+
+	if (onlineStatusCounts) {
+		for (AIAccount *account in accounts) {
+			if ([self _updateActiveStatusAggregatesForAccount:account]) changed = YES;
+		}
+	} else {
+		//Nothing has been counted yet, so we can't tell; assume a change
+		changed = YES;
+	}
+
+	if (changed) {
+		[_activeStatusState release]; _activeStatusState = nil;
+		[_allActiveStatusStates release]; _allActiveStatusStates = nil;
+
+		//Let observers know the active state has changed
+		if (activeStatusUpdateDelays) {
+			activeStatusChangedWhileDelayed = YES;
+		} else {
+			[[NSNotificationCenter defaultCenter] postNotificationName:AIStatusActiveStateChangedNotification object:nil];
+		}
 	}
 }
 
 /*!
  * @brief Account status changed.
  *
- * Rebuild all our state menus
+ * Update the active status states for it. Observers are only told if the account's state or its part in the
+ * active states really changed; accounts commonly report being set to the status they already have.
  */
 - (NSSet *)updateListObject:(AIListObject *)inObject keys:(NSSet *)inModifiedKeys silent:(BOOL)silent
 {
 	if ([inObject isKindOfClass:[AIAccount class]]) {
 		if ([inModifiedKeys containsObject:@"isOnline"] ||
-			[inModifiedKeys containsObject:@"idleSince"] ||
 			[inModifiedKeys containsObject:@"accountStatus"] ||
 			[inModifiedKeys containsObject:KEY_ENABLED]) {
 			
-			[self _resetActiveStatusState];
+			[self _updateActiveStatusForAccounts:[NSArray arrayWithObject:inObject]];
 		}
 	}
 	
     return nil;
 }
 
+/*!
+ * @brief Accounts were added or removed; count the active statuses again
+ */
+- (void)accountListChanged:(NSNotification *)notification
+{
+	[self _discardActiveStatusAggregates];
+	[self _updateActiveStatusForAccounts:nil];
+}
+
 
 /*!
  * @brief Delay activee status menu updates
@@ -549,7 +737,8 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 	else
 		activeStatusUpdateDelays--;
 	
-	if (!activeStatusUpdateDelays) {
+	if (!activeStatusUpdateDelays && activeStatusChangedWhileDelayed) {
+		activeStatusChangedWhileDelayed = NO;
 		[[NSNotificationCenter defaultCenter] postNotificationName:AIStatusActiveStateChangedNotification object:nil];
 	}
 }
@@ -623,6 +812,9 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 		shouldRebuild = YES;
 	}
 
+	//Accounts which were left offline weren't notified of their new state, so check them all here
+	[self _updateActiveStatusForAccounts:accountArray];
+
 	//If this is not an offline status, we've now made use of accountsToConnect and should clear it so it isn't used again.
 	if (!isOfflineStatus) {
 		[accountsToConnect removeAllObjects];
@@ -841,34 +1033,21 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 - (AIStatus *)activeStatusState
 {
 	if (!_activeStatusState) {
-		NSCountedSet		*statusCounts = [NSCountedSet set];
-		NSUInteger			 highestCount = 0;
-
-		if (adium.accountController.oneOrMoreConnectedAccounts) {
-			AIStatus	*bestStatusState = nil;
-
-			for (AIAccount *account in adium.accountController.accounts) {
-				if (account.online) {
-					AIStatus *accountStatusState = account.statusState;
-					[statusCounts addObject:(accountStatusState ?
-											 accountStatusState :
-											 self.defaultInitialStatusState)];
-				}
-			}
-
-			for (AIStatus *statusState in statusCounts) {
-				NSUInteger thisCount = [statusCounts countForObject:statusState];
-				if (thisCount > highestCount) {
-					bestStatusState = statusState;
-					highestCount = thisCount;
-				}
-			}
+		AIStatus	*bestStatusState = nil;
+		NSUInteger	 highestCount = 0;
 
-			_activeStatusState = (bestStatusState ? [bestStatusState retain]: [offlineStatusState retain]);
+		if (!onlineStatusCounts) [self _buildActiveStatusAggregates];
 
-		} else {
-			_activeStatusState = [offlineStatusState retain];
+		//Only the distinct statuses of online accounts are visited; the counts are kept as accounts change
+		for (AIStatus *statusState in onlineStatusCounts) {
+			NSUInteger thisCount = [onlineStatusCounts countForObject:statusState];
+			if (thisCount > highestCount) {
+				bestStatusState = statusState;
+				highestCount = thisCount;
+			}
 		}
+
+		_activeStatusState = (bestStatusState ? [bestStatusState retain] : [self.offlineStatusState retain]);
 	}
 
 	return _activeStatusState;
@@ -927,13 +1106,9 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 - (NSSet *)allActiveStatusStates
 {
 	if (!_allActiveStatusStates) {
-		_allActiveStatusStates = [[NSMutableSet alloc] init];
+		if (!enabledStatusCounts) [self _buildActiveStatusAggregates];
 
-		for (AIAccount *account in adium.accountController.accounts) {
-			if (account.enabled) {
-				[_allActiveStatusStates addObject:account.statusState];
-			}
-		}
+		_allActiveStatusStates = [[NSSet alloc] initWithSet:enabledStatusCounts];
 	}
 
 	return _allActiveStatusStates;
@@ -1008,15 +1183,45 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 
 /*!
  * @brief Find the status state with the requested uniqueStatusID
+ *
+ * Statuses are looked up in an index of flatStatusSet by their unique IDs, which is rebuilt along with it.
+ * Looking doesn't assign a unique ID to statuses which don't have one yet.
  */
 - (AIStatus *)statusStateWithUniqueStatusID:(NSNumber *)uniqueStatusID
 {
 	AIStatus		*statusState = nil;
 
 	if (uniqueStatusID) {
-		for (statusState in self.flatStatusSet) {
-			if ([statusState.uniqueStatusID compare:uniqueStatusID] == NSOrderedSame)
-				break;
+		NSSet	*flatStatusSet = self.flatStatusSet;
+
+		if (!_statusesByUniqueStatusID) {
+			_statusesByUniqueStatusID = [[NSMutableDictionary alloc] initWithCapacity:[flatStatusSet count]];
+
+			for (AIStatus *aStatusState in flatStatusSet) {
+				int preexistingUniqueStatusID = [aStatusState preexistingUniqueStatusID];
+
+				//Keep the first status with a given ID, as a linear search would find
+				if ((preexistingUniqueStatusID != -1) &&
+					![_statusesByUniqueStatusID objectForKey:[NSNumber numberWithInt:preexistingUniqueStatusID]]) {
+					[_statusesByUniqueStatusID setObject:aStatusState
+												  forKey:[NSNumber numberWithInt:preexistingUniqueStatusID]];
+				}
+			}
+		}
+
+		statusState = [_statusesByUniqueStatusID objectForKey:uniqueStatusID];
+
+		if (!statusState) {
+			/* A status outside of any group, such as a temporary one, may have been given its ID since the index was
+			 * built. Look for it, and start a fresh index next time if it turns up.
+			 */
+			for (AIStatus *aStatusState in flatStatusSet) {
+				if ([aStatusState preexistingUniqueStatusID] == [uniqueStatusID intValue]) {
+					statusState = aStatusState;
+					[_statusesByUniqueStatusID release]; _statusesByUniqueStatusID = nil;
+					break;
+				}
+			}
 		}
 	}
 
@@ -1061,11 +1266,27 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 	[self savedStatusesChanged];
 }
 
-- (void)notifyOfChangedStatusArray
+/*!
+ * @brief Clear everything cached about the state array, which has changed
+ */
+- (void)_invalidateStatusArrayCaches
 {
-	//Clear the sorted menu items array since our state array changed.
 	[_sortedFullStateArray release]; _sortedFullStateArray = nil;
 	[_flatStatusSet release]; _flatStatusSet = nil;
+	[_statusesByUniqueStatusID release]; _statusesByUniqueStatusID = nil;
+
+	statusArrayVersion++;
+}
+
+- (NSUInteger)statusArrayVersion
+{
+	return statusArrayVersion;
+}
+
+- (void)notifyOfChangedStatusArray
+{
+	//Clear the sorted menu items array since our state array changed.
+	[self _invalidateStatusArrayCaches];
 
 	if (!statusMenuRebuildDelays) {
 		[[NSNotificationCenter defaultCenter] postNotificationName:AIStatusStateArrayChangedNotification object:nil];	
@@ -1091,6 +1312,9 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 
 - (void)statusStateDidSetUniqueStatusID
 {
+	//Our index of statuses by ID doesn't know about the new one
+	[_statusesByUniqueStatusID release]; _statusesByUniqueStatusID = nil;
+
 	[adium.preferenceController setPreference:[NSKeyedArchiver archivedDataWithRootObject:[[self rootStateGroup] containedStatusItems]]
 										 forKey:KEY_SAVED_STATUS
 										  group:PREF_GROUP_SAVED_STATUS];
@@ -1127,6 +1351,7 @@ static 	NSMutableSet			*temporaryStateArray = nil;
 
 		if (count <= 1) {
 			[temporaryStateArray removeObject:originalState];
+			[self _invalidateStatusArrayCaches];
 			didRemove = YES;
 		}
 	}
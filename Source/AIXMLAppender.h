@@ -31,13 +31,14 @@
  ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-@class AIAppendXMLOperation, AIXMLElement;
+@class AIAppendXMLOperation, AIXMLElement, AIXMLByteBuffer;
 
 @interface AIXMLAppender : NSObject {
 	NSFileHandle			*file;
 	NSString				*path;
 
 	AIXMLElement			*rootElement;
+	AIXMLByteBuffer			*writeBuffer;
 	
 	BOOL					initialized;
 }
@@ -47,4 +48,8 @@
 
 @property (readonly, copy, nonatomic) NSString *path;
 - (void)appendElement:(AIXMLElement *)element;
+- (void)appendElementWithName:(NSString *)elementName
+			   attributeNames:(NSArray *)attrNames
+					   values:(NSArray *)attrVals
+			  escapedContents:(NSString *)escapedContents;
 @end
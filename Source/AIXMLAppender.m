@@ -40,6 +40,7 @@
 
 #import "AIXMLAppender.h"
 #import <Adium/AIXMLElement.h>
+#import <Adium/AIXMLByteBuffer.h>
 #import <AIUtilities/AISharedWriterQueue.h>
 #define BSD_LICENSE_ONLY 1
 #import <AIUtilities/AIStringAdditions.h>
@@ -58,6 +59,7 @@ enum {
 @interface AIXMLAppender()
 - (void)writeData:(NSData *)data seekBackLength:(NSInteger)seekBackLength;
 - (NSString *)rootElementNameForFileAtPath:(NSString *)path;
+- (void)writeBufferAppendingClosingTag;
 @property (readwrite, retain, nonatomic) NSFileHandle *fileHandle;
 @property (readwrite) BOOL initialized;
 @property (readwrite, copy, nonatomic) AIXMLElement *rootElement;
@@ -102,13 +104,13 @@ enum {
 		self.rootElement = root;
 		self.path = inPath;
 		self.initialized = NO;
+		writeBuffer = [[AIXMLByteBuffer alloc] init];
 		
-		//Create our strings
-		NSInteger closingTagLength = [self.rootElement.name length] + 3; //</rootElementName>
-		NSString *initialDocument = [NSString stringWithFormat:@"%@\n%@", XML_MARKER, [rootElement XMLString]];
-		
-		//Write the data, and then seek backwards
-		[self writeData:[initialDocument dataUsingEncoding:NSUTF8StringEncoding] seekBackLength:closingTagLength];
+		//Write the marker and the root element, and then seek backwards over its closing tag
+		[writeBuffer appendString:XML_MARKER];
+		[writeBuffer appendBytes:"\n" length:1];
+		[rootElement appendUTF8XMLBytesToBuffer:writeBuffer];
+		[self writeData:[writeBuffer data] seekBackLength:[[self.rootElement.name dataUsingEncoding:NSUTF8StringEncoding] length] + 3]; //</rootElementName>
 	}
 
 	return self;
@@ -122,6 +124,7 @@ enum {
 	self.path = nil;
 	self.fileHandle = nil; //This will also close the fd, since we set the closeOnDealloc flag to YES
 	self.rootElement = nil;
+	[writeBuffer release];
 	[super dealloc];
 }
 
@@ -266,19 +269,53 @@ enum {
 
 - (void)appendElement:(AIXMLElement *)element
 {
-	//Create our strings
-	NSString *elementString = [NSString stringWithFormat:@"\n%@", [element XMLString]];
-	NSString *closingTag = [NSString stringWithFormat:@"</%@>", self.rootElement.name];
-	
-	if (elementString != nil) {
-		//Write the data, and then seek backwards
-		[self writeData:[[elementString stringByAppendingString:closingTag] dataUsingEncoding:NSUTF8StringEncoding]
-		 seekBackLength:[closingTag length]];
-	}
+	[writeBuffer removeAllBytes];
+	[writeBuffer appendBytes:"\n" length:1];
+	[element appendUTF8XMLBytesToBuffer:writeBuffer];
+
+	[self writeBufferAppendingClosingTag];
+}
+
+/*!
+ * @brief Adds a node to the document without creating an AIXMLElement for it
+ *
+ * Writes the same bytes as -appendElement: would for an element with the given attributes and escapedContents
+ * added with -addEscapedObject:, serializing straight into the write buffer.
+ */
+- (void)appendElementWithName:(NSString *)elementName
+			   attributeNames:(NSArray *)attrNames
+					   values:(NSArray *)attrVals
+			  escapedContents:(NSString *)escapedContents
+{
+	[writeBuffer removeAllBytes];
+	[writeBuffer appendBytes:"\n" length:1];
+	[AIXMLElement appendUTF8XMLBytesForElementWithName:elementName
+										attributeNames:attrNames
+												values:attrVals
+									   escapedContents:escapedContents
+											  toBuffer:writeBuffer];
+
+	[self writeBufferAppendingClosingTag];
 }
 
 #pragma mark Private Methods
 
+/*!
+ * @brief Close the root element after what's in the write buffer, write it all, and seek back to before the closing tag
+ *
+ * The buffer is copied for the writer queue, so it may be reused as soon as this returns.
+ */
+- (void)writeBufferAppendingClosingTag
+{
+	NSUInteger elementLength = writeBuffer.length;
+
+	[writeBuffer appendBytes:"</" length:2];
+	[writeBuffer appendString:self.rootElement.name];
+	[writeBuffer appendBytes:">" length:1];
+
+	[self writeData:[writeBuffer data] seekBackLength:writeBuffer.length - elementLength];
+}
+
 /*!
  * @brief Get the root element name for file
  * 
@@ -25,13 +25,13 @@ typedef enum {
 	AIScreenName = 4
 } AINameFormat;
 
-@class AIHTMLDecoder, ISO8601DateFormatter;
+@class AIHTMLDecoder, AITimestampCodec;
 
 @interface AIXMLChatlogConverter : NSObject {
 	NSDictionary	*statusLookup;
     NSAttributedString *newlineAttributedString;
 	AIHTMLDecoder	*htmlDecoder;
-	ISO8601DateFormatter *formatter;
+	AITimestampCodec *formatter;
 }
 
 + (NSAttributedString *)readFile:(NSString *)filePath withOptions:(NSDictionary *)options;
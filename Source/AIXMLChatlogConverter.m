@@ -23,7 +23,7 @@
 #import <Adium/AIContactControllerProtocol.h>
 #import <Adium/AIContentControllerProtocol.h>
 #import <Adium/AIStatusControllerProtocol.h>
-#import <AIUtilities/ISO8601DateFormatter.h>
+#import <AIUtilities/AITimestampCodec.h>
 #import <AIUtilities/AIDateFormatterAdditions.h>
 #import <AIUtilities/AIStringAdditions.h>
 
@@ -142,7 +142,7 @@
 			[adium.statusController localizedDescriptionForCoreStatusName:STATUS_NAME_STEPPED_OUT], @"steppedOut",
 			nil];
 		
-		formatter = [[ISO8601DateFormatter alloc] init];
+		formatter = [[AITimestampCodec alloc] init];
 	}
 
 	return self;
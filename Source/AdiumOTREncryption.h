@@ -18,7 +18,7 @@
 #import <libotr/userstate.h>
 #import <Adium/AIContentControllerProtocol.h>
 
-@class ESOTRPreferences, AIContentMessage, AIAccount, AIListContact, AIChat;
+@class ESOTRPreferences, AdiumOTRPrivateKeyGenerator, AIContentMessage, AIAccount, AIListContact, AIChat;
 
 typedef enum {
     TRUST_NOT_PRIVATE,
@@ -28,7 +28,12 @@ typedef enum {
 } TrustLevel;
 
 @interface AdiumOTREncryption : NSObject <AdiumMessageEncryptor> {
-	ESOTRPreferences	*OTRPrefs;
+	ESOTRPreferences				*OTRPrefs;
+	AdiumOTRPrivateKeyGenerator		*keyGenerator;
+
+	NSMutableDictionary				*messagesAwaitingPrivateKey;
+	NSMutableSet					*accountIDsConsideredForPregeneration;
+	BOOL							 fingerprintWriteScheduled;
 }
 
 - (void)willSendContentMessage:(AIContentMessage *)inContentMessage;
@@ -47,7 +52,7 @@ void otrg_ui_update_keylist(void);
 
 TrustLevel otrg_plugin_context_to_trust(ConnContext *context);
 
-/* Generate a private key for the given accountname/protocol */
+/* Generate a private key for the given accountname/protocol in the background */
 void otrg_plugin_create_privkey(const char *accountname,
 								const char *protocol);
 
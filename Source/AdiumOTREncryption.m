@@ -32,6 +32,7 @@
 
 #import <AIUtilities/AIStringAdditions.h>
 
+#import "AdiumOTRPrivateKeyGenerator.h"
 #import "ESOTRPrivateKeyGenerationWindowController.h"
 #import "ESOTRPreferences.h"
 #import "ESOTRUnknownFingerprintController.h"
@@ -42,6 +43,12 @@
 #define PRIVKEY_PATH [[[adium.loginController userDirectory] stringByAppendingPathComponent:@"otr.private_key"] UTF8String]
 #define STORE_PATH	 [[[adium.loginController userDirectory] stringByAppendingPathComponent:@"otr.fingerprints"] UTF8String]
 
+//Fingerprint changes come in bursts (a new fingerprint, then its trust); write the store once they settle
+#define FINGERPRINT_WRITE_DELAY		2.0
+
+//Set to have keys generated in the background for enabled accounts which don't have one yet
+#define KEY_OTR_PREGENERATE_PRIVATE_KEYS	@"AIOTRPregeneratePrivateKeys"
+
 #define CLOSED_CONNECTION_MESSAGE "has closed his private connection to you"
 
 /* OTRL_POLICY_MANUAL doesn't let us respond to other users' automatic attempts at encryption.
@@ -53,8 +60,14 @@
 													  OTRL_POLICY_WHITESPACE_START_AKE | \
 													  OTRL_POLICY_ERROR_START_AKE )
 
-@interface AdiumOTREncryption ()
+@interface AdiumOTREncryption () <AdiumOTRPrivateKeyGeneratorDelegate>
 - (void)prepareEncryption;
+- (void)pregeneratePrivateKeys;
+- (void)accountListChanged:(NSNotification *)inNotification;
+- (void)generatePrivateKeyForAccountname:(const char *)accountname protocol:(const char *)protocol;
+- (BOOL)queueContentMessageIfAwaitingPrivateKey:(AIContentMessage *)inContentMessage;
+- (void)setNeedsToWriteFingerprints;
+- (void)writeFingerprintsIfNeeded;
 
 - (void)setSecurityDetails:(NSDictionary *)securityDetailsDict forChat:(AIChat *)inChat;
 - (NSString *)localizedOTRMessage:(NSString *)message withUsername:(NSString *)username isWorthOpeningANewChat:(BOOL *)isWorthOpeningANewChat;
@@ -137,6 +150,12 @@ TrustLevel otrg_plugin_context_to_trust(ConnContext *context);
 
 	otrg_ui_update_keylist();
 
+	keyGenerator = [[AdiumOTRPrivateKeyGenerator alloc] initWithUserState:otrg_plugin_userstate
+														   privateKeyPath:[[adium.loginController userDirectory] stringByAppendingPathComponent:@"otr.private_key"]];
+	keyGenerator.delegate = self;
+	messagesAwaitingPrivateKey = [[NSMutableDictionary alloc] init];
+	accountIDsConsideredForPregeneration = [[NSMutableSet alloc] init];
+
 	err = otrl_privkey_read_fingerprints(otrg_plugin_userstate, STORE_PATH,
 								   NULL, NULL);
 	if (err) {
@@ -168,12 +187,23 @@ TrustLevel otrg_plugin_context_to_trust(ConnContext *context);
 									   name:Chat_DidOpen
 									 object:nil];
 
+	[[NSNotificationCenter defaultCenter] addObserver:self
+								   selector:@selector(accountListChanged:)
+									   name:Account_ListChanged
+									 object:nil];
+
 	//Add the Encryption preferences
 	OTRPrefs = [(ESOTRPreferences *)[ESOTRPreferences preferencePane] retain];
+
+	[self pregeneratePrivateKeys];
 }
 
 - (void)dealloc
 {
+	keyGenerator.delegate = nil;
+	[keyGenerator release];
+	[messagesAwaitingPrivateKey release];
+	[accountIDsConsideredForPregeneration release];
 	[OTRPrefs release];
 	[[NSNotificationCenter defaultCenter] removeObserver:self];
 
@@ -381,28 +411,29 @@ static OtrlPolicy policy_cb(void *opdata, ConnContext *context)
 	return ret;
 }
 
-/* Generate a private key for the given accountname/protocol */
-void otrg_plugin_create_privkey(const char *accountname,
-								const char *protocol)
-{	
+static NSString* key_generation_identifier(const char *accountname, const char *protocol)
+{
 	AIAccount	*account = accountFromAccountID(accountname);
 	AIService	*service = serviceFromServiceID(protocol);
 	
-	NSString	*identifier = [NSString stringWithFormat:@"%@ (%@)",account.formattedUID, [service shortDescription]];
-	
-	[ESOTRPrivateKeyGenerationWindowController startedGeneratingForIdentifier:identifier];
-	
-    /* Generate the key */
-    otrl_privkey_generate(otrg_plugin_userstate, PRIVKEY_PATH,
-						  accountname, protocol);
-    otrg_ui_update_keylist();
-	
-    /* Mark the dialog as done. */
-	[ESOTRPrivateKeyGenerationWindowController finishedGeneratingForIdentifier:identifier];
+	return [NSString stringWithFormat:@"%@ (%@)",account.formattedUID, [service shortDescription]];
+}
+
+/*!
+ * @brief Generate a private key for the given accountname/protocol
+ *
+ * Generation happens in the background; this returns immediately. The key will be available
+ * once -[AdiumOTREncryption privateKeyGenerator:didFinishGeneratingForAccountname:protocol:succeeded:] is called.
+ */
+void otrg_plugin_create_privkey(const char *accountname,
+								const char *protocol)
+{	
+	[adiumOTREncryption generatePrivateKeyForAccountname:accountname protocol:protocol];
 }
 
 /* Create a private key for the given accountname/protocol if
- * desired. */
+ * desired. libotr will find no key when this returns; the AKE which wanted it is restarted
+ * once the key is ready. */
 static void create_privkey_cb(void *opdata, const char *accountname,
 							  const char *protocol)
 {
@@ -772,6 +803,9 @@ static OtrlMessageAppOps ui_ops = {
     if (!username || !originalMessage)
 		return;
 
+	if ([self queueContentMessageIfAwaitingPrivateKey:inContentMessage])
+		return;
+
     err = otrl_message_sending(otrg_plugin_userstate, &ui_ops, /* opData */ NULL,
 							   accountname, protocol, username, originalMessage, /* tlvs */ NULL, &fullOutgoingMessage,
 							   /* add_appdata cb */NULL, /* appdata */ NULL);
@@ -968,6 +1002,8 @@ static void otrg_dialog_update_smp(ConnContext *context, CGFloat percentage)
  */
 - (void)adiumWillTerminate:(NSNotification *)inNotification
 {
+	[self writeFingerprintsIfNeeded];
+
 	ConnContext *context = otrg_plugin_userstate->context_root;
 	while(context) {
 		ConnContext *next = context->next;
@@ -1085,9 +1121,14 @@ void otrg_ui_forget_fingerprint(Fingerprint *fingerprint)
     otrg_plugin_write_fingerprints();
 }
 
+/*!
+ * @brief The fingerprint store changed
+ *
+ * The in-memory store is already current, so the UI is updated immediately; the file is rewritten once changes settle.
+ */
 void otrg_plugin_write_fingerprints(void)
 {
-    otrl_privkey_write_fingerprints(otrg_plugin_userstate, STORE_PATH);
+	[adiumOTREncryption setNeedsToWriteFingerprints];
 	otrg_ui_update_fingerprint();
 }
 
@@ -1106,6 +1147,167 @@ OtrlUserState otrg_get_userstate(void)
 	return otrg_plugin_userstate;
 }
 
+- (void)setNeedsToWriteFingerprints
+{
+	if (fingerprintWriteScheduled) return;
+
+	fingerprintWriteScheduled = YES;
+	[self performSelector:@selector(writeFingerprintsIfNeeded)
+			   withObject:nil
+			   afterDelay:FINGERPRINT_WRITE_DELAY];
+}
+
+- (void)writeFingerprintsIfNeeded
+{
+	if (!fingerprintWriteScheduled) return;
+
+	[NSObject cancelPreviousPerformRequestsWithTarget:self
+											 selector:@selector(writeFingerprintsIfNeeded)
+											   object:nil];
+	fingerprintWriteScheduled = NO;
+
+	otrl_privkey_write_fingerprints(otrg_plugin_userstate, STORE_PATH);
+}
+
+#pragma mark Private key generation
+
+- (void)generatePrivateKeyForAccountname:(const char *)accountname protocol:(const char *)protocol
+{
+	[ESOTRPrivateKeyGenerationWindowController startedGeneratingForIdentifier:key_generation_identifier(accountname, protocol)];
+
+	[keyGenerator generatePrivateKeyForAccountname:[NSString stringWithUTF8String:accountname]
+										  protocol:[NSString stringWithUTF8String:protocol]];
+}
+
+/*!
+ * @brief Start generating keys for enabled accounts which have none, if the user asked us to
+ *
+ * Each account is considered once: at launch for the accounts which exist then, and afterwards as accounts are added.
+ */
+- (void)pregeneratePrivateKeys
+{
+	if (![[NSUserDefaults standardUserDefaults] boolForKey:KEY_OTR_PREGENERATE_PRIVATE_KEYS])
+		return;
+
+	for (AIAccount *account in adium.accountController.accounts) {
+		if ([accountIDsConsideredForPregeneration containsObject:account.internalObjectID]) continue;
+		[accountIDsConsideredForPregeneration addObject:account.internalObjectID];
+
+		if (!account.enabled) continue;
+
+		[keyGenerator pregeneratePrivateKeyForAccountname:account.internalObjectID
+												 protocol:account.service.serviceCodeUniqueID];
+	}
+}
+
+/*!
+ * @brief Accounts were added, removed or reordered; pregenerate keys for any which are new
+ */
+- (void)accountListChanged:(NSNotification *)inNotification
+{
+	[self pregeneratePrivateKeys];
+}
+
+/*!
+ * @brief Hold on to an outgoing message while its account's private key is generated
+ *
+ * Sending now would go out in the clear if an AKE is underway or the contact requires encryption.
+ * Such messages are displayed now and sent once the key is ready.
+ *
+ * @result YES if the message was queued; its encoded message is cleared so that it isn't sent yet.
+ */
+- (BOOL)queueContentMessageIfAwaitingPrivateKey:(AIContentMessage *)inContentMessage
+{
+	AIAccount	*account = (AIAccount *)[inContentMessage source];
+	NSString	*accountname = account.internalObjectID;
+	NSString	*protocol = account.service.serviceCodeUniqueID;
+
+	if (![keyGenerator isGeneratingForAccountname:accountname protocol:protocol])
+		return NO;
+
+	ConnContext *context = contextForChat(inContentMessage.chat);
+	OtrlPolicy	policy = policyForContact((AIListContact *)[inContentMessage destination]);
+	BOOL		akeInProgress = (context && context->auth.authstate != OTRL_AUTHSTATE_NONE);
+
+	if (!akeInProgress && !(policy & OTRL_POLICY_REQUIRE_ENCRYPTION))
+		return NO;
+
+	NSString		*key = [NSString stringWithFormat:@"%@\n%@", accountname, protocol];
+	NSMutableArray	*queue = [messagesAwaitingPrivateKey objectForKey:key];
+	if (!queue) {
+		queue = [NSMutableArray array];
+		[messagesAwaitingPrivateKey setObject:queue forKey:key];
+	}
+
+	[queue addObject:[NSArray arrayWithObjects:inContentMessage, [inContentMessage encodedMessage], nil]];
+	[inContentMessage setEncodedMessage:nil];
+
+	//Let the user know why nothing is happening yet
+	[ESOTRPrivateKeyGenerationWindowController startedGeneratingForIdentifier:key_generation_identifier([accountname UTF8String],
+																										[protocol UTF8String])];
+
+	AILogWithSignature(@"Queued %@ until a private key exists for %@", inContentMessage, accountname);
+
+	return YES;
+}
+
+- (void)privateKeyGenerator:(AdiumOTRPrivateKeyGenerator *)generator
+didFinishGeneratingForAccountname:(NSString *)accountname
+				   protocol:(NSString *)protocol
+				  succeeded:(BOOL)succeeded
+{
+	const char *accountnameUTF8 = [accountname UTF8String];
+	const char *protocolUTF8 = [protocol UTF8String];
+
+	otrg_ui_update_keylist();
+	[ESOTRPrivateKeyGenerationWindowController finishedGeneratingForIdentifier:key_generation_identifier(accountnameUTF8, protocolUTF8)];
+
+	if (succeeded) {
+		//Restart any AKE which stalled for lack of our key
+		for (ConnContext *context = otrg_plugin_userstate->context_root; context; context = context->next) {
+			if (context->auth.authstate != OTRL_AUTHSTATE_NONE &&
+				!strcmp(context->accountname, accountnameUTF8) &&
+				!strcmp(context->protocol, protocolUTF8)) {
+				send_default_query_to_chat(chatForContext(context));
+			}
+		}
+	}
+
+	NSString	*key = [NSString stringWithFormat:@"%@\n%@", accountname, protocol];
+	NSArray		*queue = [[[messagesAwaitingPrivateKey objectForKey:key] retain] autorelease];
+	[messagesAwaitingPrivateKey removeObjectForKey:key];
+
+	if (!succeeded) {
+		/* Sending again would find no key and ask for one again, so drop the held messages and say so in each
+		 * chat which had one rather than letting them go out in the clear.
+		 */
+		NSMutableSet *chats = [NSMutableSet set];
+		for (NSArray *queuedMessage in queue)
+			[chats addObject:[[queuedMessage objectAtIndex:0] chat]];
+
+		for (AIChat *chat in chats) {
+			[adium.contentController displayEvent:AILocalizedString(@"Your private key could not be generated, so your messages were not sent.", nil)
+										   ofType:@"encryption"
+										   inChat:chat];
+		}
+
+		if (queue.count)
+			AILogWithSignature(@"Dropped %lu messages for %@: no private key could be generated", (unsigned long)queue.count, accountname);
+		return;
+	}
+
+	for (NSArray *queuedMessage in queue) {
+		AIContentMessage	*contentMessage = [queuedMessage objectAtIndex:0];
+		AIAccount			*account = (AIAccount *)[contentMessage source];
+
+		[contentMessage setEncodedMessage:[queuedMessage objectAtIndex:1]];
+		[self willSendContentMessage:contentMessage];
+
+		if ([contentMessage encodedMessage])
+			[account sendMessageObject:contentMessage];
+	}
+}
+
 #pragma mark -
 
 - (void)verifyUnknownFingerprint:(NSValue *)contextValue
@@ -0,0 +1,62 @@
+/*
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import <libotr/userstate.h>
+
+@class AdiumOTRPrivateKeyGenerator;
+
+@protocol AdiumOTRPrivateKeyGeneratorDelegate <NSObject>
+/*!
+ * @brief A private key finished generating and has been loaded into the user state
+ *
+ * Always called on the main thread.
+ */
+- (void)privateKeyGenerator:(AdiumOTRPrivateKeyGenerator *)generator
+didFinishGeneratingForAccountname:(NSString *)accountname
+				   protocol:(NSString *)protocol
+				  succeeded:(BOOL)succeeded;
+@end
+
+/*!
+ * @class AdiumOTRPrivateKeyGenerator
+ * @brief Generates OTR private keys off the main thread
+ *
+ * DSA key generation takes several seconds. Generation is split the way libotr 4's
+ * otrl_privkey_generate_start/calculate/finish is: the job is registered on the main thread, the key
+ * is calculated on a background queue, and the result is written out and loaded into the
+ * OtrlUserState back on the main thread, since the user state is not thread safe.
+ *
+ * Keys which are needed right now run ahead of pre-generated keys, which are calculated one at a
+ * time at low priority.
+ */
+@interface AdiumOTRPrivateKeyGenerator : NSObject {
+	OtrlUserState							 userState;
+	NSString								*privateKeyPath;
+	id <AdiumOTRPrivateKeyGeneratorDelegate> delegate;
+
+	NSMutableDictionary						*jobs;
+	dispatch_queue_t						 pregenerationQueue;
+}
+
+- (id)initWithUserState:(OtrlUserState)inUserState privateKeyPath:(NSString *)inPath;
+
+@property (assign, nonatomic) id <AdiumOTRPrivateKeyGeneratorDelegate> delegate;
+
+- (BOOL)isGeneratingForAccountname:(NSString *)accountname protocol:(NSString *)protocol;
+- (void)generatePrivateKeyForAccountname:(NSString *)accountname protocol:(NSString *)protocol;
+- (void)pregeneratePrivateKeyForAccountname:(NSString *)accountname protocol:(NSString *)protocol;
+
+@end
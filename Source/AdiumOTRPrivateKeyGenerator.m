@@ -0,0 +1,300 @@
+/*
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "AdiumOTRPrivateKeyGenerator.h"
+#import "OTRCommon.h"
+
+#import <errno.h>
+#import <sys/stat.h>
+
+/*!
+ * @class AdiumOTRKeyGenerationJob
+ * @brief A key being generated for one accountname/protocol pair
+ *
+ * A job may be scheduled on both the pregeneration queue and the urgent queue; whichever gets to it first
+ * claims it and calculates the key.
+ */
+@interface AdiumOTRKeyGenerationJob : NSObject {
+@public
+	NSString	*accountname;
+	NSString	*protocol;
+	gcry_sexp_t	 privkey;
+	BOOL		 claimed;
+	BOOL		 urgent;
+}
+- (id)initWithAccountname:(NSString *)inAccountname protocol:(NSString *)inProtocol;
+- (BOOL)claim;
+@end
+
+@implementation AdiumOTRKeyGenerationJob
+
+- (id)initWithAccountname:(NSString *)inAccountname protocol:(NSString *)inProtocol
+{
+	if ((self = [super init])) {
+		accountname = [inAccountname copy];
+		protocol = [inProtocol copy];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	if (privkey) gcry_sexp_release(privkey);
+	[accountname release];
+	[protocol release];
+
+	[super dealloc];
+}
+
+- (BOOL)claim
+{
+	@synchronized(self) {
+		if (claimed) return NO;
+		claimed = YES;
+	}
+
+	return YES;
+}
+
+@end
+
+#pragma mark -
+
+/* libotr 3.2 only offers the blocking otrl_privkey_generate(). These mirror the split API from libotr 4. */
+
+/*!
+ * @brief Calculate a new DSA private key. Safe to call off the main thread; touches no OtrlUserState.
+ */
+static gcry_error_t otrg_privkey_generate_calculate(gcry_sexp_t *privkeyp)
+{
+	gcry_sexp_t		parms, key;
+	gcry_error_t	err;
+
+	*privkeyp = NULL;
+
+	err = gcry_sexp_new(&parms, "(genkey (dsa (nbits 4:1024)))", 0, 1);
+	if (err) return err;
+
+	err = gcry_pk_genkey(&key, parms);
+	gcry_sexp_release(parms);
+	if (err) return err;
+
+	*privkeyp = gcry_sexp_find_token(key, "private-key", 0);
+	gcry_sexp_release(key);
+
+	return (*privkeyp ? gcry_error(GPG_ERR_NO_ERROR) : gcry_error(GPG_ERR_INV_VALUE));
+}
+
+/*!
+ * @brief Write one (account ...) entry of a private key file
+ */
+static gcry_error_t otrg_privkey_account_write(FILE *privf, const char *accountname, const char *protocol, gcry_sexp_t privkey)
+{
+	gcry_sexp_t		account;
+	gcry_error_t	err;
+	size_t			len;
+	char			*buf;
+
+	err = gcry_sexp_build(&account, NULL, "(account (name %s) (protocol %s) %S)", accountname, protocol, privkey);
+	if (err) return err;
+
+	len = gcry_sexp_sprint(account, GCRYSEXP_FMT_ADVANCED, NULL, 0);
+	buf = malloc(len);
+	if (!buf) {
+		gcry_sexp_release(account);
+		return gcry_error(GPG_ERR_ENOMEM);
+	}
+
+	gcry_sexp_sprint(account, GCRYSEXP_FMT_ADVANCED, buf, len);
+	fprintf(privf, " %s\n", buf);
+
+	free(buf);
+	gcry_sexp_release(account);
+
+	return gcry_error(GPG_ERR_NO_ERROR);
+}
+
+/*!
+ * @brief Store a calculated key alongside the existing ones and load the result into the user state. Main thread only.
+ *
+ * The file is written to a temporary path and renamed into place so a crash mid-write can't lose existing keys.
+ */
+static gcry_error_t otrg_privkey_generate_finish(OtrlUserState us, const char *filename,
+												 const char *accountname, const char *protocol, gcry_sexp_t newkey)
+{
+	char			*tempFilename;
+	FILE			*privf;
+	OtrlPrivKey		*p;
+	gcry_error_t	err = gcry_error(GPG_ERR_NO_ERROR);
+	mode_t			oldmask;
+
+	if (asprintf(&tempFilename, "%s.new", filename) < 0)
+		return gcry_error(GPG_ERR_ENOMEM);
+
+	oldmask = umask(077);
+	privf = fopen(tempFilename, "w+b");
+	umask(oldmask);
+
+	if (!privf) {
+		err = gcry_error_from_errno(errno);
+		free(tempFilename);
+		return err;
+	}
+
+	fprintf(privf, "(privkeys\n");
+	for (p = us->privkey_root; p && !err; p = p->next) {
+		//Skip the key we're replacing
+		if (!strcmp(p->accountname, accountname) && !strcmp(p->protocol, protocol)) continue;
+		err = otrg_privkey_account_write(privf, p->accountname, p->protocol, p->privkey);
+	}
+	if (!err) err = otrg_privkey_account_write(privf, accountname, protocol, newkey);
+	fprintf(privf, ")\n");
+
+	if (!err && fflush(privf) != 0) err = gcry_error_from_errno(errno);
+	if (!err) {
+		fseek(privf, 0, SEEK_SET);
+		err = otrl_privkey_read_FILEp(us, privf);
+	}
+	fclose(privf);
+
+	if (!err && rename(tempFilename, filename) != 0) err = gcry_error_from_errno(errno);
+	if (err) unlink(tempFilename);
+
+	free(tempFilename);
+
+	return err;
+}
+
+#pragma mark -
+
+@interface AdiumOTRPrivateKeyGenerator ()
+- (void)calculateJob:(AdiumOTRKeyGenerationJob *)job onQueue:(dispatch_queue_t)queue;
+- (void)finishJob:(AdiumOTRKeyGenerationJob *)job error:(gcry_error_t)err;
+@end
+
+@implementation AdiumOTRPrivateKeyGenerator
+
+@synthesize delegate;
+
+- (id)initWithUserState:(OtrlUserState)inUserState privateKeyPath:(NSString *)inPath
+{
+	if ((self = [super init])) {
+		userState = inUserState;
+		privateKeyPath = [inPath copy];
+		jobs = [[NSMutableDictionary alloc] init];
+
+		pregenerationQueue = dispatch_queue_create("im.adium.AdiumOTRPrivateKeyGenerator.pregenerationQueue", 0);
+		dispatch_set_target_queue(pregenerationQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	dispatch_release(pregenerationQueue);
+	[jobs release];
+	[privateKeyPath release];
+
+	[super dealloc];
+}
+
+static NSString *jobKey(NSString *accountname, NSString *protocol)
+{
+	return [NSString stringWithFormat:@"%@\n%@", accountname, protocol];
+}
+
+- (BOOL)isGeneratingForAccountname:(NSString *)accountname protocol:(NSString *)protocol
+{
+	return ([jobs objectForKey:jobKey(accountname, protocol)] != nil);
+}
+
+/*!
+ * @brief Generate a key which is needed now
+ *
+ * If the key is already waiting on the pregeneration queue, it is moved ahead.
+ */
+- (void)generatePrivateKeyForAccountname:(NSString *)accountname protocol:(NSString *)protocol
+{
+	AdiumOTRKeyGenerationJob *job = [jobs objectForKey:jobKey(accountname, protocol)];
+
+	if (!job) {
+		job = [[[AdiumOTRKeyGenerationJob alloc] initWithAccountname:accountname protocol:protocol] autorelease];
+		[jobs setObject:job forKey:jobKey(accountname, protocol)];
+
+	} else if (job->urgent) {
+		//Already on its way
+		return;
+	}
+
+	job->urgent = YES;
+	[self calculateJob:job onQueue:dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0)];
+}
+
+/*!
+ * @brief Generate a key ahead of time, at low priority, one at a time
+ *
+ * Has no effect if the key already exists or is being generated.
+ */
+- (void)pregeneratePrivateKeyForAccountname:(NSString *)accountname protocol:(NSString *)protocol
+{
+	if ([jobs objectForKey:jobKey(accountname, protocol)] ||
+		otrl_privkey_find(userState, [accountname UTF8String], [protocol UTF8String])) return;
+
+	AdiumOTRKeyGenerationJob *job = [[AdiumOTRKeyGenerationJob alloc] initWithAccountname:accountname protocol:protocol];
+	[jobs setObject:job forKey:jobKey(accountname, protocol)];
+	[self calculateJob:job onQueue:pregenerationQueue];
+	[job release];
+}
+
+- (void)calculateJob:(AdiumOTRKeyGenerationJob *)job onQueue:(dispatch_queue_t)queue
+{
+	dispatch_async(queue, ^{
+		if (![job claim]) return;
+
+		gcry_sexp_t privkey = NULL;
+		gcry_error_t err = otrg_privkey_generate_calculate(&privkey);
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			job->privkey = privkey;
+			[self finishJob:job error:err];
+		});
+	});
+}
+
+- (void)finishJob:(AdiumOTRKeyGenerationJob *)job error:(gcry_error_t)err
+{
+	if (!err) {
+		err = otrg_privkey_generate_finish(userState, [privateKeyPath fileSystemRepresentation],
+										   [job->accountname UTF8String], [job->protocol UTF8String], job->privkey);
+	}
+
+	if (err) {
+		AILogWithSignature(@"Error generating OTR private key for %@ (%@): %s", job->accountname, job->protocol, gcry_strerror(err));
+	}
+
+	[job retain];
+	[jobs removeObjectForKey:jobKey(job->accountname, job->protocol)];
+
+	[delegate privateKeyGenerator:self
+didFinishGeneratingForAccountname:job->accountname
+						 protocol:job->protocol
+						succeeded:(err == GPG_ERR_NO_ERROR)];
+	[job release];
+}
+
+@end
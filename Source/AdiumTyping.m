@@ -21,9 +21,11 @@
 #import "AIContentTyping.h"
 #import <Adium/AIChat.h>
 #import <Adium/AIAccount.h>
+#import <AIUtilities/AITimerWheel.h>
 
 #define OUR_TYPING_STATE						@"ourTypingState"
 #define ENTERED_TEXT_TIMER						@"enteredTextTimer"
+#define CLEAR_TYPING_TIMER						@"clearTypingTimer"
 
 #define DELAY_BEFORE_PAUSING_TYPING		3.0		//Wait for 3 seconds of inactivity before pausing typing
 #define DELAY_BEFORE_CLEARING_TYPING	2.0		//Wait 2 seconds before clearing the typing flag
@@ -33,7 +35,8 @@
 - (void)monitorTypingInChat:(AIChat *)chat;
 - (void)stopMonitoringTypingInChat:(AIChat *)chat;
 - (void)_clearUserTypingForChat:(AIChat *)chat;
-- (void)_typingHasPausedInChat:(NSTimer *)inTimer;
+- (void)_clearTypingTimerFired:(AIWheelTimer *)inTimer;
+- (void)_typingHasPausedInChat:(AIWheelTimer *)inTimer;
 
 - (void)didSendMessage:(NSNotification *)notification;
 - (void)chatWillClose:(NSNotification *)notification;
@@ -75,23 +78,38 @@
  */
 - (void)userIsTypingContentForChat:(AIChat *)chat hasEnteredText:(BOOL)hasEnteredText
 {
-	//Cancel any existing delayed perform selectors waiting to clear our typing flag
-	[NSObject cancelPreviousPerformRequestsWithTarget:self
-											 selector:@selector(_clearUserTypingForChat:)
-											   object:chat];
+	AIWheelTimer	*clearTimer = [chat valueForProperty:CLEAR_TYPING_TIMER];
 
 	//To prevent "Flickering" of our typing state, we wait a short period of time before clearing our typing flag.
 	//Setting our typing flag always happens immediately.
 	if (hasEnteredText) {
+		//Cancel any timer waiting to clear our typing flag
+		if (clearTimer) {
+			[clearTimer invalidate];
+			[chat setValue:nil forProperty:CLEAR_TYPING_TIMER notify:NotifyNever];
+		}
+
 		[self monitorTypingInChat:chat];
 		[self setTypingState:AITyping ofChat:chat];
+
+	} else if (clearTimer) {
+		[clearTimer rescheduleAfterDelay:DELAY_BEFORE_CLEARING_TYPING];
+
 	} else {
-		[self performSelector:@selector(_clearUserTypingForChat:)
-				   withObject:chat
-				   afterDelay:DELAY_BEFORE_CLEARING_TYPING];
+		clearTimer = [[AITimerWheel sharedTimerWheel] scheduleTimerWithDelay:DELAY_BEFORE_CLEARING_TYPING
+															  repeatInterval:0
+																	  target:self
+																	selector:@selector(_clearTypingTimerFired:)
+																	userInfo:chat];
+		[chat setValue:clearTimer forProperty:CLEAR_TYPING_TIMER notify:NotifyNever];
 	}
 }
 
+- (void)_clearTypingTimerFired:(AIWheelTimer *)inTimer
+{
+	[self _clearUserTypingForChat:[inTimer userInfo]];
+}
+
 /*!
  * @brief Clear the typing state of a chat
  */
@@ -165,19 +183,19 @@
  */
 - (void)monitorTypingInChat:(AIChat *)chat
 {
-	NSTimer	*existingTimer = [chat valueForProperty:ENTERED_TEXT_TIMER];
+	AIWheelTimer	*existingTimer = [chat valueForProperty:ENTERED_TEXT_TIMER];
 	
 	if (existingTimer) {
-		//If a timer exists, it is cheaper to reset it rather than create a new one
-		[existingTimer setFireDate:[NSDate dateWithTimeIntervalSinceNow:DELAY_BEFORE_PAUSING_TYPING]];
+		//If a timer exists, it is cheaper to reset it rather than create a new one; this happens on every keystroke
+		[existingTimer rescheduleAfterDelay:DELAY_BEFORE_PAUSING_TYPING];
 		
 	} else {
 		//If no timer exists, create one for the chat
-		existingTimer = [NSTimer scheduledTimerWithTimeInterval:DELAY_BEFORE_PAUSING_TYPING
-														 target:self
-													   selector:@selector(_typingHasPausedInChat:)
-													   userInfo:chat
-														repeats:NO];
+		existingTimer = [[AITimerWheel sharedTimerWheel] scheduleTimerWithDelay:DELAY_BEFORE_PAUSING_TYPING
+																 repeatInterval:0
+																		 target:self
+																	   selector:@selector(_typingHasPausedInChat:)
+																	   userInfo:chat];
 		[chat setValue:existingTimer forProperty:ENTERED_TEXT_TIMER notify:NotifyNever];
 		
 	}
@@ -190,12 +208,14 @@
 {
 	[[chat valueForProperty:ENTERED_TEXT_TIMER] invalidate];
 	[chat setValue:nil forProperty:ENTERED_TEXT_TIMER notify:NotifyNever];
+	[[chat valueForProperty:CLEAR_TYPING_TIMER] invalidate];
+	[chat setValue:nil forProperty:CLEAR_TYPING_TIMER notify:NotifyNever];
 }
 
 /*!
  * @brief Invoked when the user 
  */
-- (void)_typingHasPausedInChat:(NSTimer *)inTimer
+- (void)_typingHasPausedInChat:(AIWheelTimer *)inTimer
 {
 	AIChat	*chat = [inTimer userInfo];
 	
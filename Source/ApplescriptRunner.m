@@ -88,12 +88,16 @@
 /*!
  * @brief Observer method which responds to the @"AdiumApplescriptRunner_RespondIfReady" distributed notification
  *
- * This allows simple two-way communicatino from the host application to the daemon without setting up proxy or ports
+ * This allows simple two-way communicatino from the host application to the daemon without setting up proxy or ports.
+ * It also counts as activity for the automatic quit timer.
  */
 - (void)respondIfReady:(NSNotification *)inNotification
 {
 	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
 	[self applescriptRunnerIsReady];
+
+	//Adium asks periodically while it expects to run scripts, to keep us from quitting
+	[self resetAutomaticQuitTimer];
 	[pool release];
 }
 
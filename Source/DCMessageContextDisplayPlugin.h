@@ -25,19 +25,20 @@
 
 #define CONTEXT_DISPLAY_DEFAULTS	@"MessageContextDisplayDefaults"
 
-@class SMSQLiteLoggerPlugin, ISO8601DateFormatter;
+@class SMSQLiteLoggerPlugin, AITimestampCodec;
 
 @interface DCMessageContextDisplayPlugin : AIPlugin {	
 	BOOL							isObserving;
 	BOOL							shouldDisplay;
 	BOOL							dimRecentContext;
 	NSInteger						linesToDisplay;
-	ISO8601DateFormatter			*formatter;
+	AITimestampCodec				*formatter;
 }
 
 + (DCMessageContextDisplayPlugin *)sharedInstance;
 
 - (NSArray *)contextForChat:(AIChat *)chat;
 - (NSArray *)contextForChat:(AIChat *)chat lines:(NSInteger)linesLeftToFind alsoStatus:(BOOL)alsoStatus;
+- (NSArray *)contextFromLogsForChat:(AIChat *)chat lines:(NSInteger)linesLeftToFind alsoStatus:(BOOL)alsoStatus;
 
 @end
@@ -17,6 +17,7 @@
 #import <Adium/AIContentControllerProtocol.h>
 #import "DCMessageContextDisplayPlugin.h"
 #import <AIUtilities/AIDictionaryAdditions.h>
+#import <Adium/AIAccount.h>
 #import <Adium/AIChat.h>
 #import <Adium/AIContentContext.h>
 #import <Adium/AIContentStatus.h>
@@ -35,11 +36,14 @@
 #import <Adium/AIXMLElement.h>
 #import <AIUtilities/AIStringAdditions.h>
 #import "unistd.h"
-#import <AIUtilities/ISO8601DateFormatter.h>
+#import <AIUtilities/AITimestampCodec.h>
 #import <Adium/AIContactControllerProtocol.h>
 #import <Adium/AIHTMLDecoder.h>
+#import "AIMessageTailCache.h"
 
 #define RESTORED_CHAT_CONTEXT_LINE_NUMBER 50
+//How long opening a chat may wait for the logger's pending writes before reading the logs without them
+#define PENDING_WRITES_WAIT_LIMIT			0.25
 
 static DCMessageContextDisplayPlugin *sharedInstance = nil;
 
@@ -53,6 +57,19 @@ static DCMessageContextDisplayPlugin *sharedInstance = nil;
 - (void)preferencesChangedForGroup:(NSString *)group key:(NSString *)key
 							object:(AIListObject *)object preferenceDict:(NSDictionary *)prefDict firstTime:(BOOL)firstTime;
 - (NSArray *)contextForChat:(AIChat *)chat;
+- (BOOL)fillTailCacheForChat:(AIChat *)chat;
+- (NSArray *)contextFromLogsForChat:(AIChat *)chat
+							  lines:(NSInteger)linesLeftToFind
+						 alsoStatus:(BOOL)alsoStatus
+						  asRecords:(BOOL)asRecords
+						  newestLog:(NSString **)outNewestLog
+						   complete:(BOOL *)outComplete;
+- (AIContentObject *)contentObjectWithName:(NSString *)elementName
+								attributes:(NSDictionary *)attributes
+							   XMLContents:(NSString *)contents
+								   forChat:(AIChat *)chat
+							   serviceName:(NSString *)serviceName
+								   decoder:(AIHTMLDecoder *)decoder;
 - (void)addContextDisplayToWindow:(NSNotification *)notification;
 + (DCMessageContextDisplayPlugin *)sharedInstance;
 @end
@@ -81,7 +98,7 @@ static DCMessageContextDisplayPlugin *sharedInstance = nil;
 	[adium.preferenceController registerPreferenceObserver:self forGroup:PREF_GROUP_LOGGING];
 	
 	sharedInstance = self;
-	formatter = [[ISO8601DateFormatter alloc] init];
+	formatter = [[AITimestampCodec alloc] init];
 }
 
 /**
@@ -107,6 +124,9 @@ static DCMessageContextDisplayPlugin *sharedInstance = nil;
 				&& [[adium.preferenceController preferenceForKey:KEY_LOGGER_ENABLE
 														  group:PREF_GROUP_LOGGING] boolValue];
 			linesToDisplay = [[prefDict objectForKey:KEY_DISPLAY_LINES] integerValue];
+			
+			//Keep enough in the message tail cache for chat windows and restored chats alike
+			[AILoggerPlugin messageTailCache].capacity = MAX(linesToDisplay, RESTORED_CHAT_CONTEXT_LINE_NUMBER);
 		}
 		
 		if (shouldDisplay && linesToDisplay > 0 && !isObserving) {
@@ -157,8 +177,6 @@ static DCMessageContextDisplayPlugin *sharedInstance = nil;
 }
 /*!
  * @brief Retrieve the message history for a particular chat
- *
- * Asks AILoggerPlugin for the path to the right file, and then uses LMX to parse that file backwards.
  */
 - (NSArray *)contextForChat:(AIChat *)chat
 {
@@ -173,22 +191,129 @@ static DCMessageContextDisplayPlugin *sharedInstance = nil;
 	return [self contextForChat:chat lines:linesLeftToFind alsoStatus:NO];
 }
 
+/*!
+ * @brief Retrieve the newest messages, and statuses if alsoStatus, logged for a chat
+ *
+ * These come from AILoggerPlugin's message tail cache. If the chat's entry is missing or out of date, it is filled
+ * from the logs first; only requests for more than an entry holds parse the logs each time.
+ */
 - (NSArray *)contextForChat:(AIChat *)chat lines:(NSInteger)linesLeftToFind alsoStatus:(BOOL)alsoStatus
 {
+	if (linesLeftToFind <= 0) return nil;
+	
+	AIMessageTailCache	*tailCache = [AILoggerPlugin messageTailCache];
+	NSString			*key = [AILoggerPlugin relativePathForLogsLikeChat:chat];
+	NSArray				*records = [tailCache recordsForKey:key lines:linesLeftToFind alsoStatus:alsoStatus];
+	
+	if (!records && (NSUInteger)linesLeftToFind <= tailCache.capacity && [self fillTailCacheForChat:chat])
+		records = [tailCache recordsForKey:key lines:linesLeftToFind alsoStatus:alsoStatus];
+	
+	if (!records)
+		return [self contextFromLogsForChat:chat lines:linesLeftToFind alsoStatus:alsoStatus];
+	
+	NSMutableArray	*context = [NSMutableArray arrayWithCapacity:records.count];
+	AIHTMLDecoder	*decoder = [AIHTMLDecoder decoder];
+	NSString		*baseLogPath = [[AILoggerPlugin logBasePath] stringByAppendingPathComponent:key];
+	NSString		*serviceName = [[[[key pathComponents] objectAtIndex:0U] componentsSeparatedByString:@"."] objectAtIndex:0U];
+	
+	for (NSDictionary *record in records) {
+		NSString *bundleName = [record objectForKey:KEY_TAIL_RECORD_LOG];
+		[decoder setBaseURL:(bundleName ? [baseLogPath stringByAppendingPathComponent:bundleName] : nil)];
+		
+		AIContentObject *content = [self contentObjectWithName:[record objectForKey:KEY_TAIL_RECORD_NAME]
+													attributes:[record objectForKey:KEY_TAIL_RECORD_ATTRIBUTES]
+												   XMLContents:[record objectForKey:KEY_TAIL_RECORD_CONTENTS]
+													   forChat:chat
+												   serviceName:serviceName
+													   decoder:decoder];
+		if (content) [context addObject:content];
+	}
+	
+	return context;
+}
+
+/*!
+ * @brief Fill a chat's message tail cache entry from its logs
+ *
+ * An entry's worth of messages is read, along with the statuses between them, so that a single pass serves requests
+ * both with and without statuses.
+ *
+ * @result NO if the logger's writes for the chat didn't finish in time, and the entry was left as it was
+ */
+- (BOOL)fillTailCacheForChat:(AIChat *)chat
+{
+	AIMessageTailCache	*tailCache = [AILoggerPlugin messageTailCache];
+	NSString			*key = [AILoggerPlugin relativePathForLogsLikeChat:chat];
+	NSString			*newestLog = nil;
+	BOOL				 complete = NO;
+	
+	/* The logs have to hold everything the logger has written for this chat before we read them. This runs on the
+	 * main thread as the chat opens, so don't wait behind a slow writer queue for long.
+	 */
+	if (![tailCache waitForPendingWritesForKey:key
+									 untilDate:[NSDate dateWithTimeIntervalSinceNow:PENDING_WRITES_WAIT_LIMIT]]) {
+		AILogWithSignature(@"Writes to %@ are still pending; reading message history without the tail cache", key);
+		return NO;
+	}
+	
+	NSArray *records = [self contextFromLogsForChat:chat
+											  lines:tailCache.capacity
+										 alsoStatus:NO
+										  asRecords:YES
+										  newestLog:&newestLog
+										   complete:&complete];
+	
+	//With no log, there's nothing for an entry to keep up with
+	if (newestLog) {
+		[tailCache setRecords:records
+			  includingStatus:YES
+					 complete:complete
+				  toLogAtPath:newestLog
+					   forKey:key];
+	}
+
+	return YES;
+}
+
+/*!
+ * @brief Parse the message history for a particular chat out of its logs
+ *
+ * Asks AILoggerPlugin for the path to the right file, and then uses LMX to parse that file backwards.
+ */
+- (NSArray *)contextFromLogsForChat:(AIChat *)chat lines:(NSInteger)linesLeftToFind alsoStatus:(BOOL)alsoStatus
+{
+	return [self contextFromLogsForChat:chat lines:linesLeftToFind alsoStatus:alsoStatus asRecords:NO newestLog:NULL complete:NULL];
+}
+
+/*!
+ * @brief Parse the message history for a particular chat out of its logs
+ *
+ * @param alsoStatus If YES, statuses are returned and count as lines along with messages
+ * @param asRecords If YES, AIMessageTailCache records are returned instead of content objects. Statuses are always
+ *                  returned, but count as lines only if alsoStatus; no more than the cache's recordLimit are returned.
+ * @param outNewestLog If not NULL, set to the path of the newest XML log, or nil if there are no logs
+ * @param outComplete If not NULL, set to YES if the result is everything in the logs
+ */
+- (NSArray *)contextFromLogsForChat:(AIChat *)chat
+							  lines:(NSInteger)linesLeftToFind
+						 alsoStatus:(BOOL)alsoStatus
+						  asRecords:(BOOL)asRecords
+						  newestLog:(NSString **)outNewestLog
+						   complete:(BOOL *)outComplete
+{
+	if (outNewestLog) *outNewestLog = nil;
+	if (outComplete) *outComplete = NO;
+	
 	//If there's no log there, there's no message history. Bail out.
 	NSArray *logPaths = [AILoggerPlugin sortedArrayOfLogFilesForChat:chat];
 	
 	if(!logPaths || linesLeftToFind == 0) return nil;
 	
-	NSString *logObjectUID = chat.name;
-	if (!logObjectUID) logObjectUID = chat.listObject.UID;
-	logObjectUID = [logObjectUID safeFilenameString];
-	
 	AIHTMLDecoder *decoder = [AIHTMLDecoder decoder];
 	
-	NSString *baseLogPath = [[AILoggerPlugin logBasePath] stringByAppendingPathComponent:
-							 [AILoggerPlugin relativePathForLogWithObject:logObjectUID onAccount:chat.account]];	
-
+	NSString *baseLogPath = [[AILoggerPlugin logBasePath] stringByAppendingPathComponent:[AILoggerPlugin relativePathForLogsLikeChat:chat]];
+	NSInteger recordsLeftToFind = (asRecords ? (NSInteger)[AILoggerPlugin messageTailCache].recordLimit : NSIntegerMax);
+	BOOL parsedCompletely = YES;
 	
 	//Initialize a place to store found messages
 	NSMutableArray *outerFoundContentContexts = [NSMutableArray arrayWithCapacity:linesLeftToFind]; 
@@ -196,7 +321,7 @@ static DCMessageContextDisplayPlugin *sharedInstance = nil;
 	//Iterate over the elements of the log path array.
 	NSEnumerator *pathsEnumerator = [logPaths objectEnumerator];
 	NSString *logPath = nil;
-	while (linesLeftToFind > 0 && (logPath = [pathsEnumerator nextObject])) {
+	while (linesLeftToFind > 0 && recordsLeftToFind > 0 && (logPath = [pathsEnumerator nextObject])) {
 		//If it's not a .chatlog, ignore it.
 		if (![logPath hasSuffix:@".chatlog"])
 			continue;
@@ -206,6 +331,7 @@ static DCMessageContextDisplayPlugin *sharedInstance = nil;
 
 		//By default, the xmlFilePath is the chat log file/bundle... if we find that the chatlog is a bundle, we'll use the xml file inside.
 		NSString *xmlFilePath = logPath;
+		NSString *bundleName = nil;
 
 		BOOL isDir;
 		if ([[NSFileManager defaultManager] fileExistsAtPath:logPath isDirectory:&isDir]) {
@@ -213,17 +339,22 @@ static DCMessageContextDisplayPlugin *sharedInstance = nil;
 			NSString *baseURL;
 			if (isDir) {
 				baseURL = logPath;
+				bundleName = [logPath lastPathComponent];
 				xmlFilePath = [logPath stringByAppendingPathComponent:
-							   [[[logPath lastPathComponent] stringByDeletingPathExtension] stringByAppendingPathExtension:@"xml"]];
+							   [[bundleName stringByDeletingPathExtension] stringByAppendingPathExtension:@"xml"]];
 			} else {
 				baseURL = nil;
 			}
 			[decoder setBaseURL:baseURL];
 		}
+		
+		//The logs are sorted newest first
+		if (outNewestLog && !*outNewestLog) *outNewestLog = xmlFilePath;
 
 		//Initialize the found messages array and element stack for us-as-delegate
 		NSMutableArray *foundMessages = [NSMutableArray arrayWithCapacity:linesLeftToFind];
 		NSMutableArray *elementStack = [NSMutableArray array];
+		NSInteger linesFound = 0;
 
 		//Create the parser and set ourselves as the delegate
 		LMXParser *parser = [LMXParser parser];
@@ -235,20 +366,20 @@ static DCMessageContextDisplayPlugin *sharedInstance = nil;
 			//Get the service name from the path name
 			NSString *serviceName = [[[[[logPath stringByDeletingLastPathComponent] stringByDeletingLastPathComponent] lastPathComponent] componentsSeparatedByString:@"."] objectAtIndex:0U];
 
-			AIListObject *account = chat.account;
-			NSString	 *accountID = [NSString stringWithFormat:@"%@.%@", account.service.serviceID, account.UID];
-
 			contextInfo = [NSMutableDictionary dictionaryWithObjectsAndKeys:
 						   serviceName, @"Service name",
-						   account, @"Account",
-						   accountID, @"Account ID",
 						   chat, @"Chat",
 						   decoder, @"AIHTMLDecoder",
 						   [NSValue valueWithPointer:&linesLeftToFind], @"LinesLeftToFindValue",
+						   [NSValue valueWithPointer:&linesFound], @"LinesFoundValue",
+						   [NSNumber numberWithInteger:recordsLeftToFind], @"RecordsLeftToFind",
 						   foundMessages, @"FoundMessages",
 						   elementStack, @"ElementStack",
-                           [NSNumber numberWithBool:alsoStatus], @"AlsoAllowStatus",
+                           [NSNumber numberWithBool:(alsoStatus || asRecords)], @"AlsoAllowStatus",
+						   [NSNumber numberWithBool:alsoStatus], @"StatusIsLine",
+						   [NSNumber numberWithBool:asRecords], @"AsRecords",
 						   nil];
+			if (bundleName) [contextInfo setObject:bundleName forKey:@"Log bundle"];
 			[parser setContextInfo:(void *)contextInfo];
 		}
 
@@ -305,12 +436,13 @@ static DCMessageContextDisplayPlugin *sharedInstance = nil;
 				result = [parser parseChunk:chunk];
 				
 				//Continue to parse as long as we need more elements, we have data to read, and LMX doesn't think we're done.
-			} while ([foundMessages count] < linesLeftToFind && offset > 0 && result != LMXParsedCompletely);
+			} while (linesFound < linesLeftToFind && [foundMessages count] < recordsLeftToFind && offset > 0 && result != LMXParsedCompletely);
 
 		} @catch (id theException) {
 			AILogWithSignature(@"Error \"%@\" while parsing %@; foundMessages at that point was %@, and the chunk to be parsed was %@",
 							   theException, logPath, 
 							   foundMessages, chunk);
+			parsedCompletely = NO;
 
 		} @finally {
 			//Drain our autorelease pool.
@@ -322,7 +454,8 @@ static DCMessageContextDisplayPlugin *sharedInstance = nil;
 			//Add our locals to the outer array; we're probably looping again.
 			AILog(@"Context: %lu messages from %@: %@", (unsigned long)foundMessages.count, [xmlFilePath lastPathComponent], foundMessages);
 			[outerFoundContentContexts replaceObjectsInRange:NSMakeRange(0, 0) withObjectsFromArray:foundMessages];
-			linesLeftToFind -= [outerFoundContentContexts count];
+			linesLeftToFind -= linesFound;
+			recordsLeftToFind -= [foundMessages count];
 		}
 	}
 	
@@ -330,9 +463,77 @@ static DCMessageContextDisplayPlugin *sharedInstance = nil;
 		AILogWithSignature(@"Unable to find %lu logs for %@; we needed %lu more", (unsigned long)linesToDisplay, chat, (unsigned long)linesLeftToFind);
 	}
 	
+	//We only ran out of logs if we stopped for lack of another one
+	if (outComplete) *outComplete = (!logPath && parsedCompletely);
+	
 	return outerFoundContentContexts;
 }
 
+/*!
+ * @brief Create the content object for a logged message or status
+ *
+ * @param serviceName The service ID of the account the log folder is for
+ * @param decoder The decoder for the message, whose base URL is the log bundle it is in
+ * @result The content object, or nil if the element has no time
+ */
+- (AIContentObject *)contentObjectWithName:(NSString *)elementName
+								attributes:(NSDictionary *)attributes
+							   XMLContents:(NSString *)contents
+								   forChat:(AIChat *)chat
+							   serviceName:(NSString *)serviceName
+								   decoder:(AIHTMLDecoder *)decoder
+{
+	NSString	*timeString = [attributes objectForKey:@"time"];
+	
+	if ([elementName isEqualToString:@"status"]) {
+		if (!timeString) return nil;
+		
+		return [[[AIContentStatus alloc] initWithChat:chat
+											   source:nil
+										  destination:nil
+												 date:[formatter dateFromString:timeString]] autorelease];
+	}
+	
+	if (!timeString) {
+		NSLog(@"Null message context display time for %@ %@", elementName, attributes);
+		return nil;
+	}
+	
+	NSDate			*timeVal = [formatter dateFromString:timeString];
+	AIAccount		*account = chat.account;
+	NSString		*accountID = [NSString stringWithFormat:@"%@.%@", account.service.serviceID, account.UID];
+	NSString		*autoreplyAttribute = [attributes objectForKey:@"auto"];
+	NSString		*sender = [NSString stringWithFormat:@"%@.%@", serviceName, [attributes objectForKey:@"sender"]];
+	BOOL			sentByMe = ([sender isEqualToString:accountID]);
+	
+	/*don't fade the messages if they're within the last 5 minutes
+	 *since that will be resuming a conversation, not starting a new one.
+	 *Why the class trickery? Less code duplication, clearer what is actually different between the two cases.
+	 */
+	Class messageClass = (-[timeVal timeIntervalSinceNow] > 300.0) ? [AIContentContext class] : [AIContentMessage class];
+	
+	AIListContact *listContact = nil;
+	
+	if (chat.isGroupChat) {
+		listContact = [account contactWithUID:[attributes objectForKey:@"sender"]];
+	} else {
+		listContact = chat.listObject;
+	}
+	
+	AIContentMessage *message = [messageClass messageInChat:chat 
+												 withSource:(sentByMe ? account : listContact)
+												destination:(sentByMe ? (chat.isGroupChat ? nil : chat.listObject) : account)
+													   date:timeVal
+													message:[decoder decodeHTML:contents]
+												  autoreply:(autoreplyAttribute && [autoreplyAttribute caseInsensitiveCompare:@"true"] == NSOrderedSame)];
+	
+	//Don't log this object
+	[message setPostProcessContent:NO];
+	[message setTrackContent:NO];
+	
+	return message;
+}
+
 #pragma mark LMX delegate
 
 - (void)parser:(LMXParser *)parser elementEnded:(NSString *)elementName
@@ -372,77 +573,40 @@ static DCMessageContextDisplayPlugin *sharedInstance = nil;
 		
 		NSMutableArray	*foundMessages = [contextInfo objectForKey:@"FoundMessages"];
 		NSInteger	 *linesLeftToFind = [[contextInfo objectForKey:@"LinesLeftToFindValue"] pointerValue];
+		NSInteger	 *linesFound = [[contextInfo objectForKey:@"LinesFoundValue"] pointerValue];
+		BOOL		 isMessage = [elementName isEqualToString:@"message"];
 		
-		if ([elementName isEqualToString:@"message"]) {
+		if (isMessage || ([[contextInfo valueForKey:@"AlsoAllowStatus"] boolValue] && [elementName isEqualToString:@"status"])) {
 			//A message element has started!
 			//This means that we have all of this message now, and therefore can create a single content object from the AIXMLElement tree and then throw away that tree.
 			//This saves memory when a message element contains many elements (since each one is represented by an AIXMLElement sub-tree in the AIXMLElement tree, as opposed to a simple NSAttributeRun in the NSAttributedString of the content object).
-
-			NSString     *serviceName = [contextInfo objectForKey:@"Service name"];
-			AIListObject *account     = [contextInfo objectForKey:@"Account"];
-			NSString     *accountID   = [contextInfo objectForKey:@"Account ID"];
-			AIChat       *chat        = [contextInfo objectForKey:@"Chat"];
-			
-			//Set up some doohickers.
 			NSDictionary	*attributes = [element attributes];
-			NSString		*timeString = [attributes objectForKey:@"time"];
-			//Create the context object
-			if (timeString) {
-				NSDate *timeVal = [formatter dateFromString:timeString];
-
-				NSString		*autoreplyAttribute = [attributes objectForKey:@"auto"];
-				NSString		*sender = [NSString stringWithFormat:@"%@.%@", serviceName, [attributes objectForKey:@"sender"]];
-				BOOL			sentByMe = ([sender isEqualToString:accountID]);
-				
-				/*don't fade the messages if they're within the last 5 minutes
-				 *since that will be resuming a conversation, not starting a new one.
-				 *Why the class trickery? Less code duplication, clearer what is actually different between the two cases.
-				 */
-				Class messageClass = (-[timeVal timeIntervalSinceNow] > 300.0) ? [AIContentContext class] : [AIContentMessage class];
-				
-				AIListContact *listContact = nil;
-				
-				if (chat.isGroupChat) {
-					listContact = [chat.account contactWithUID:[attributes objectForKey:@"sender"]];
-				} else {
-					listContact = chat.listObject;
-				}
-				
-				AIContentMessage *message = [messageClass messageInChat:chat 
-															 withSource:(sentByMe ? account : listContact)
-															destination:(sentByMe ? (chat.isGroupChat ? nil : chat.listObject) : account)
-																   date:timeVal
-																message:[[contextInfo objectForKey:@"AIHTMLDecoder"] decodeHTML:[element contentsAsXMLString]]
-															  autoreply:(autoreplyAttribute && [autoreplyAttribute caseInsensitiveCompare:@"true"] == NSOrderedSame)];
-				
-				//Don't log this object
-				[message setPostProcessContent:NO];
-				[message setTrackContent:NO];
-				
-				//Add it to the array (in front, since we're working backwards, and we want the array in forward order)
-				[foundMessages insertObject:message atIndex:0];
-			} else {
-				NSLog(@"Null message context display time for %@",element);
-			}
-		} else if ([[contextInfo valueForKey:@"AlsoAllowStatus"] boolValue] && [elementName isEqualToString:@"status"]) {
-            
-			AIChat          *chat = [contextInfo objectForKey:@"Chat"];
+			id				found = nil;
 			
-			NSDictionary	*attributes = [element attributes];
-			NSString		*timeString = [attributes objectForKey:@"time"];
+			if (![[contextInfo objectForKey:@"AsRecords"] boolValue]) {
+				found = [self contentObjectWithName:elementName
+										 attributes:attributes
+										XMLContents:[element contentsAsXMLString]
+											forChat:[contextInfo objectForKey:@"Chat"]
+										serviceName:[contextInfo objectForKey:@"Service name"]
+											decoder:[contextInfo objectForKey:@"AIHTMLDecoder"]];
+			} else if ([attributes objectForKey:@"time"]) {
+				found = [AIMessageTailCache recordWithName:elementName
+											attributeNames:[attributes allKeys]
+													values:[attributes allValues]
+										   escapedContents:[element contentsAsXMLString]
+											   inLogBundle:[contextInfo objectForKey:@"Log bundle"]];
+			}
 			
-			if (timeString) {
-				NSDate *timeVal = [formatter dateFromString:timeString];
-                
-                AIContentStatus *status = [[AIContentStatus alloc] initWithChat:chat source:nil destination:nil date:timeVal];
-                
-                [foundMessages insertObject:status atIndex:0];
-                [status release];
-            }
-        }
+			if (found) {
+				//Add it to the array (in front, since we're working backwards, and we want the array in forward order)
+				[foundMessages insertObject:found atIndex:0];
+				if (isMessage || [[contextInfo valueForKey:@"StatusIsLine"] boolValue]) (*linesFound)++;
+			}
+		}
 		
 		[elementStack removeObjectAtIndex:0U];
-		if ([foundMessages count] == *linesLeftToFind) {
+		if (*linesFound == *linesLeftToFind || [foundMessages count] == [[contextInfo objectForKey:@"RecordsLeftToFind"] unsignedIntegerValue]) {
 			if ([elementStack count]) [elementStack removeAllObjects];
 			[parser abortParsing];
 		}
@@ -22,6 +22,7 @@
 #import <AIUtilities/AISleepNotification.h>
 #import <Adium/AIAccount.h>
 #import <Adium/AIListObject.h>
+#import <Adium/AIReconnectScheduler.h>
 
 @interface ESAccountNetworkConnectivityPlugin ()
 - (void)handleConnectivityForAccount:(AIAccount *)account reachable:(BOOL)reachable;
@@ -42,7 +43,8 @@
  *  | Network connectivity (disconnect when the Internet is not available and connect when it is available again)
  *  | System sleep (disconnect when the system sleeps and connect when it wakes up)
  *
- * Uses AIHostReachabilityMonitor and AISleepNotification from AIUtilities.
+ * Uses AIHostReachabilityMonitor and AISleepNotification from AIUtilities. Accounts coming back online together are
+ * handed to AIReconnectScheduler, which spreads them out and holds back those whose host is unreachable.
  */
 @implementation ESAccountNetworkConnectivityPlugin
 
@@ -168,6 +170,8 @@
  */
 - (void)hostReachabilityChanged:(BOOL)networkIsReachable forHost:(NSString *)host
 {
+	[[AIReconnectScheduler sharedScheduler] setHost:host reachable:networkIsReachable];
+
 	//Connect or disconnect accounts in response to the connectivity change
 	for (AIAccount *account in adium.accountController.accounts) {
 		if (networkIsReachable && [accountsToNotConnect containsObject:account]) {
@@ -211,13 +215,13 @@
 
 	if (reachable) {
 		//If we are now online and are waiting to connect this account, do it if the account hasn't already
-		//been taken care of.
+		//been taken care of. Every account on this host is coming back at once, so let the scheduler spread them out.
 		[account setValue:nil forProperty:@"isWaitingForNetwork" notify:NotifyNow];
 		if ([accountsToConnect containsObject:account] ||
 			[account valueForProperty:@"waitingToReconnect"]) {
 			if (!account.online &&
 				![account boolValueForProperty:@"isConnecting"]) {
-				[account setShouldBeOnline:YES];
+				[account scheduleConnect];
 				[accountsToConnect removeObject:account];
 			}
 		}
@@ -370,10 +374,10 @@
 	 */
 	waitingToSleep = NO;
 
-	//Immediately re-connect accounts which are ignoring the server reachability
+	//Re-connect accounts which are ignoring the server reachability without waiting for the network
 	for (AIAccount *account in adium.accountController.accounts) {
 		if (![account connectivityBasedOnNetworkReachability] && [accountsToConnect containsObject:account]) {
-			[account setShouldBeOnline:YES];
+			[account scheduleConnect];
 			[accountsToConnect removeObject:account];
 		} else if ([accountsToConnect containsObject:account]) {
 			[account setValue:[NSNumber numberWithBool:YES] forProperty:@"isWaitingForNetwork" notify:NotifyNow];
@@ -21,8 +21,13 @@
 	NSMutableDictionary			*globalOnlyEventHandlers;
 	NSMutableDictionary			*eventHandlers;
 	NSMutableDictionary			*actionHandlers;
+
+	NSMutableDictionary			*compiledAlerts;
+	NSUInteger					compiledGroupingVersion;
 }
 
+- (NSArray *)resolvedAlertsForEventID:(NSString *)eventID listObject:(AIListObject *)listObject;
+
 @end
 
 @interface NSObject (ESContactAlertsController_EventsTarget)
@@ -23,9 +23,9 @@
 @interface ESContactAlertsController ()
 - (NSArray *)arrayOfMenuItemsForEventsWithTarget:(id)target forGlobalMenu:(BOOL)global;
 
-- (NSMutableArray *)appendEventsForObject:(AIListObject *)listObject eventID:(NSString *)eventID toArray:(NSMutableArray *)events;
 - (void)addMenuItemsForEventHandlers:(NSDictionary *)inEventHandlers toArray:(NSMutableArray *)menuItemArray withTarget:(id)target forGlobalMenu:(BOOL)global;
 - (void)removeAllAlertsFromListObject:(AIListObject *)listObject;
+- (void)flushCompiledAlerts;
 @end
 
 @implementation ESContactAlertsController
@@ -42,6 +42,7 @@ static	NSMutableDictionary		*globalOnlyEventHandlersByGroup[EVENT_HANDLER_GROUP_
 		globalOnlyEventHandlers = [[NSMutableDictionary alloc] init];
 		eventHandlers = [[NSMutableDictionary alloc] init];
 		actionHandlers = [[NSMutableDictionary alloc] init];
+		compiledAlerts = [[NSMutableDictionary alloc] init];
 	}
 	
 	return self;
@@ -49,11 +50,24 @@ static	NSMutableDictionary		*globalOnlyEventHandlersByGroup[EVENT_HANDLER_GROUP_
 
 - (void)controllerDidLoad
 {
+	[adium.preferenceController registerPreferenceObserver:self forGroup:PREF_GROUP_CONTACT_ALERTS];
 }
 
 - (void)controllerWillClose
 {
-	
+	[adium.preferenceController unregisterPreferenceObserver:self];
+}
+
+/*!
+ * @brief Contact alert preferences changed
+ *
+ * Any change, at any level, may change what every object below it inherits.
+ */
+- (void)preferencesChangedForGroup:(NSString *)group key:(NSString *)key
+							object:(AIListObject *)object preferenceDict:(NSDictionary *)prefDict firstTime:(BOOL)firstTime
+{
+	if (!key || [key isEqualToString:KEY_CONTACT_ALERTS])
+		[self flushCompiledAlerts];
 }
 
 /*!
@@ -64,6 +78,7 @@ static	NSMutableDictionary		*globalOnlyEventHandlersByGroup[EVENT_HANDLER_GROUP_
 	[globalOnlyEventHandlers release]; globalOnlyEventHandlers = nil;
 	[eventHandlers release]; eventHandlers = nil;
 	[actionHandlers release]; actionHandlers = nil;
+	[compiledAlerts release]; compiledAlerts = nil;
 	
 	[super dealloc];
 }
@@ -287,10 +302,11 @@ NSInteger eventIDSort(id objectA, id objectB, void *context) {
  */
 - (NSSet *)generateEvent:(NSString *)eventID forListObject:(AIListObject *)listObject userInfo:(id)userInfo previouslyPerformedActionIDs:(NSSet *)previouslyPerformedActionIDs
 {
-	NSArray			*alerts = [self appendEventsForObject:listObject eventID:eventID toArray:nil];
+	//Removing a one time alert below flushes the compiled table, so hold on to our alerts until we're done with them
+	NSArray			*alerts = [[[self resolvedAlertsForEventID:eventID listObject:listObject] retain] autorelease];
 	NSMutableSet	*performedActionIDs = nil;
 	
-	if (alerts && [alerts count]) {
+	if ([alerts count]) {
 		performedActionIDs = (previouslyPerformedActionIDs ?
 							  [[previouslyPerformedActionIDs mutableCopy] autorelease]:
 							  [NSMutableSet set]);
@@ -333,48 +349,80 @@ NSInteger eventIDSort(id objectA, id objectB, void *context) {
 }
 
 /*!
- * @brief Append events for the passed object to the specified array.
- *
- * @param events The array of events so far. Create the array if passed nil.
- * @param The object for which we're retrieving events. If nil, we retrieve the global preferences.
+ * @brief The alerts which fire for an event on a list object, inheritance already resolved
  *
- * This method is intended to be called recursively; it should generate an array which has alerts from:
- * contact->metaContact->group->global preferences (skipping any which don't exist).
+ * An object's own alerts come first, followed by those it inherits from each of its containing objects in turn, or
+ * the global alerts if it has none; a Do Nothing alert stops inheritance. An alert inherited more than once (from a
+ * group and from global, through both of a contact's groups, ...) is only listed the first time. Results are
+ * compiled once per event and object, objects without alerts included, and kept until contact alert preferences
+ * change or any object joins or leaves a group or metacontact.
  *
- * @result An array which contains the object's own events followed by its containingObject's events.
+ * @param eventID The event
+ * @param listObject The object, or nil for global alerts only
  */
-- (NSMutableArray *)appendEventsForObject:(AIListObject *)listObject eventID:(NSString *)eventID toArray:(NSMutableArray *)events
+- (NSArray *)resolvedAlertsForEventID:(NSString *)eventID listObject:(AIListObject *)listObject
 {
-	NSArray			*newEvents;
+	static NSArray	*noAlerts = nil;
+	if (!noAlerts) noAlerts = [[NSArray alloc] init];
 
-	//Add events for this object (replacing any inherited from the containing object so that this object takes precendence)
-	newEvents = [[adium.preferenceController preferenceForKey:KEY_CONTACT_ALERTS
-														  group:PREF_GROUP_CONTACT_ALERTS
-									  objectIgnoringInheritance:listObject] objectForKey:eventID];
-	
-	if (newEvents && [newEvents count]) {
-		if (!events) events = [NSMutableArray array];
-		[events addObjectsFromArray:newEvents];
-		
-		//Don't add any more events if there's a Do Nothing action
-		for (NSDictionary *event in newEvents){
-			NSString *actionID = [event objectForKey:KEY_ACTION_ID];
-			if ([actionID isEqualToString:DO_NOTHING_ALERT_IDENTIFIER])
-				return events;
-		}
+	if (compiledGroupingVersion != [AIListObject groupingVersion]) {
+		[self flushCompiledAlerts];
+		compiledGroupingVersion = [AIListObject groupingVersion];
 	}
 
-	//Get all events from the contanining object if we have an object
-	if (listObject) {
-		if (listObject.containingObjects.count > 0) {
-			for (AIListObject<AIContainingObject> *container in listObject.containingObjects) {
-				events = [self appendEventsForObject:container eventID:eventID toArray:events];
+	NSMutableDictionary	*alertsByObject = [compiledAlerts objectForKey:eventID];
+	id					objectKey = (listObject ? (id)listObject.internalObjectID : (id)[NSNull null]);
+	NSArray				*alerts = [alertsByObject objectForKey:objectKey];
+
+	if (alerts) return alerts;
+
+	NSArray			*ownAlerts = [[adium.preferenceController preferenceForKey:KEY_CONTACT_ALERTS
+																	 group:PREF_GROUP_CONTACT_ALERTS
+												 objectIgnoringInheritance:listObject] objectForKey:eventID];
+	NSMutableArray	*compiled = [NSMutableArray array];
+	BOOL			doNothing = NO;
+
+	for (NSDictionary *alert in ownAlerts) {
+		if (![compiled containsObject:alert]) [compiled addObject:alert];
+		if ([[alert objectForKey:KEY_ACTION_ID] isEqualToString:DO_NOTHING_ALERT_IDENTIFIER]) doNothing = YES;
+	}
+
+	//Then what we inherit, unless there's a Do Nothing action. Containers are compiled (and cached) on the way.
+	if (listObject && !doNothing) {
+		NSSet	*containers = listObject.containingObjects;
+
+		if (containers.count > 0) {
+			for (AIListObject<AIContainingObject> *container in containers) {
+				for (NSDictionary *alert in [self resolvedAlertsForEventID:eventID listObject:container]) {
+					if (![compiled containsObject:alert]) [compiled addObject:alert];
+				}
+			}
+		} else {
+			for (NSDictionary *alert in [self resolvedAlertsForEventID:eventID listObject:nil]) {
+				if (![compiled containsObject:alert]) [compiled addObject:alert];
 			}
-		} else
-			events = [self appendEventsForObject:nil eventID:eventID toArray:events];
+		}
+	}
+
+	alerts = ([compiled count] ? [[compiled copy] autorelease] : noAlerts);
+
+	//Compiling a container may have replaced the table for this event, so look it up again
+	alertsByObject = [compiledAlerts objectForKey:eventID];
+	if (!alertsByObject) {
+		alertsByObject = [NSMutableDictionary dictionary];
+		[compiledAlerts setObject:alertsByObject forKey:eventID];
 	}
+	[alertsByObject setObject:alerts forKey:objectKey];
 
-	return events;
+	return alerts;
+}
+
+/*!
+ * @brief Forget all compiled alerts
+ */
+- (void)flushCompiledAlerts
+{
+	[compiledAlerts removeAllObjects];
 }
 
 /*!
@@ -658,6 +706,9 @@ NSInteger eventIDSort(id objectA, id objectB, void *context) {
 											 forKey:KEY_CONTACT_ALERTS
 											  group:PREF_GROUP_CONTACT_ALERTS
 											 object:listObject];	
+		
+		//Notification of a global change waits for the delay to end
+		[self flushCompiledAlerts];
 	}
 
 	//Update the default events if requested
@@ -814,6 +865,9 @@ NSInteger eventIDSort(id objectA, id objectB, void *context) {
 										  group:PREF_GROUP_CONTACT_ALERTS
 										 object:nil];
 	[contactAlerts release];
+	
+	//Notification of a global change waits for the delay to end
+	[self flushCompiledAlerts];
 
 	[adium.preferenceController delayPreferenceChangedNotifications:NO];
 	
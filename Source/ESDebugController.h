@@ -26,5 +26,6 @@
 
 - (NSFileHandle *)debugLogFile;
 - (void)addMessage:(NSString *)actualMessage;
+- (void)addMessages:(NSArray *)messages;
 
 @end
@@ -17,6 +17,7 @@
 #import "ESDebugWindowController.h"
 
 #import <Adium/AIMenuControllerProtocol.h>
+#import <Adium/AIDebugLogBuffer.h>
 #import <AIUtilities/AIMenuAdditions.h>
 
 #import <fcntl.h>  //open(2)
@@ -112,6 +113,8 @@ void AIExplodeOnEnumerationMutation(id dummy) {
 
 - (void)controllerWillClose
 {
+	AIDebugLogBufferFlush();
+
 	[[NSNotificationCenter defaultCenter] removeObserver:self];
 	//Save the open state of the debug window
 	[adium.preferenceController setPreference:([ESDebugWindowController debugWindowIsOpen] ?
@@ -125,6 +128,9 @@ void AIExplodeOnEnumerationMutation(id dummy) {
 - (void)dealloc
 {
 	[debugLogArray release];
+
+	//Detach the file from the drain thread before closing it
+	AIDebugLogBufferSetOutputFile(nil);
 	[debugLogFile closeFile];
 	[debugLogFile release];
 
@@ -137,6 +143,11 @@ void AIExplodeOnEnumerationMutation(id dummy) {
 	[ESDebugWindowController showDebugWindow];
 }
 
+/*!
+ * @brief Add a single, already formatted message
+ *
+ * Messages logged with AILog() arrive through -addMessages: instead and have already been written to the log file.
+ */
 - (void)addMessage:(NSString *)actualMessage
 {
 	if ((![actualMessage hasSuffix:@"\n"]) && (![actualMessage hasSuffix:@"\r"])) {
@@ -155,15 +166,30 @@ void AIExplodeOnEnumerationMutation(id dummy) {
 	[ESDebugWindowController addedDebugMessage:actualMessage];
 }
 
+/*!
+ * @brief Add a batch of rendered messages from the debug log buffer
+ */
+- (void)addMessages:(NSArray *)messages
+{
+	[debugLogArray addObjectsFromArray:messages];
+
+	//Keep debugLogArray to a reasonable size
+	if ([debugLogArray count] > CACHED_DEBUG_LOGS)
+		[debugLogArray removeObjectsInRange:NSMakeRange(0, [debugLogArray count] - CACHED_DEBUG_LOGS)];
+
+	[ESDebugWindowController addedDebugMessages:messages];
+}
+
 - (void)preferencesChangedForGroup:(NSString *)group key:(NSString *)key
 							object:(AIListObject *)object preferenceDict:(NSDictionary *)prefDict firstTime:(BOOL)firstTime
 {
 	if (firstTime || [key isEqualToString:KEY_DEBUG_WRITE_LOG]) {
 		BOOL	writeLogs = [[prefDict objectForKey:KEY_DEBUG_WRITE_LOG] boolValue];
 		if (writeLogs) {
-			[self debugLogFile];
+			AIDebugLogBufferSetOutputFile([self debugLogFile]);
 			
 		} else {
+			AIDebugLogBufferSetOutputFile(nil);
 			[debugLogFile release]; debugLogFile = nil;
 		}
 	}
@@ -33,6 +33,7 @@
 + (void)closeDebugWindow;
 + (BOOL)debugWindowIsOpen;
 + (void)addedDebugMessage:(NSString *)message;
++ (void)addedDebugMessages:(NSArray *)messages;
 - (IBAction)toggleLogWriting:(id)sender;
 - (IBAction)clearLog:(id)sender;
 
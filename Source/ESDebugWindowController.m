@@ -87,6 +87,36 @@ static ESDebugWindowController *sharedDebugWindowInstance = nil;
 	if (sharedDebugWindowInstance) [sharedDebugWindowInstance addedDebugMessage:aDebugString];
 }
 
+/*!
+ * @brief Append several messages, touching the text storage once
+ */
+- (void)addedDebugMessages:(NSArray *)debugStrings
+{
+	NSUInteger	startLength = [mutableDebugString length];
+
+	[fullDebugLogArray addObjectsFromArray:debugStrings];
+
+	[[textView_debug textStorage] beginEditing];
+	for (NSString *aDebugString in debugStrings) {
+		if (!filter || 
+			[aDebugString rangeOfString:filter options:NSCaseInsensitiveSearch].location != NSNotFound) {
+			[mutableDebugString appendString:aDebugString];
+		}
+	}
+
+	if ([mutableDebugString length] > startLength) {
+		[[textView_debug textStorage] addAttribute:NSParagraphStyleAttributeName
+											 value:debugParagraphStyle
+											 range:NSMakeRange(startLength, [mutableDebugString length] - startLength)];
+	}
+	[[textView_debug textStorage] endEditing];
+}
+
++ (void)addedDebugMessages:(NSArray *)debugStrings
+{
+	if (sharedDebugWindowInstance) [sharedDebugWindowInstance addedDebugMessages:debugStrings];
+}
+
 - (NSString *)adiumFrameAutosaveName
 {
 	return KEY_DEBUG_WINDOW_FRAME;
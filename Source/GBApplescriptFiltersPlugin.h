@@ -16,12 +16,15 @@
 
 #import <Adium/AIContentControllerProtocol.h>
 
+@class AIKeywordMatcher;
+
 @interface GBApplescriptFiltersPlugin : AIPlugin <AIDelayedContentFilter> {
 	NSMenuItem				*scriptMenuItem;			//Script menu parent
 	NSMenuItem				*contextualScriptMenuItem;	//Script menu parent
 	NSMenu 					*scriptMenu;				//Submenu of scripts
 
-	NSMutableArray			*flatScriptArray;			//Flat array of scripts
+	NSMutableArray			*flatScriptArray;			//Flat array of scripts, longest keyword first
+	AIKeywordMatcher		*keywordMatcher;			//Finds the keywords of flatScriptArray, in the same order
 	NSMutableArray			*scriptArray;				//Ordered array for script menu
 	
 	BOOL					buildingScriptMenu;
@@ -23,6 +23,8 @@
 #import <AIUtilities/AIToolbarUtilities.h>
 #import <AIUtilities/AIImageAdditions.h>
 #import <AIUtilities/MVMenuButton.h>
+#import <AIUtilities/AIKeywordMatcher.h>
+#import <AIUtilities/AIScriptExecutorPool.h>
 #import <Adium/AIContentObject.h>
 #import <Adium/AIHTMLDecoder.h>
 
@@ -47,12 +49,16 @@
 - (void)applescriptDidRun:(id)userInfo resultString:(NSString *)resultString;
 - (IBAction)dummyTarget:(id)sender;
 
-- (void)_replaceKeyword:(NSString *)keyword
-			 withScript:(NSMutableDictionary *)infoDict
-			   inString:(NSString *)inString
-	 inAttributedString:(NSMutableAttributedString *)attributedString
-				context:(id)context
-			   uniqueID:(unsigned long long)uniqueID;
+- (BOOL)_filterAttributedString:(NSAttributedString *)inAttributedString
+				  mutableString:(NSMutableAttributedString *)mutableAttributedString
+						context:(id)context
+					   uniqueID:(unsigned long long)uniqueID;
+
+- (void)_replaceKeywordInRange:(NSRange)keywordRange
+					withScript:(NSMutableDictionary *)infoDict
+			inAttributedString:(NSMutableAttributedString *)attributedString
+					   context:(id)context
+					  uniqueID:(unsigned long long)uniqueID;
 
 - (void)_executeScript:(NSMutableDictionary *)infoDict 
 		 withArguments:(NSArray *)arguments
@@ -123,6 +129,7 @@ NSInteger _scriptKeywordLengthSort(id scriptA, id scriptB, void *context);
 	
 	[scriptArray release]; scriptArray = nil;
     [flatScriptArray release]; flatScriptArray = nil;
+	[keywordMatcher release]; keywordMatcher = nil;
 	[scriptMenuItem release]; scriptMenuItem = nil;
 	[contextualScriptMenuItem release]; contextualScriptMenuItem = nil;
 	
@@ -152,7 +159,8 @@ NSInteger _scriptKeywordLengthSort(id scriptA, id scriptB, void *context);
 /*!
  * @brief Load our scripts
  *
- * This will clear out and then load from available scripts (external and internal) into flatScriptArray and scriptArray.
+ * This will clear out and then load from available scripts (external and internal) into flatScriptArray and scriptArray,
+ * sort flatScriptArray by keyword length and build the keyword matcher for it.
  */
 - (void)loadScripts
 {
@@ -208,7 +216,9 @@ NSInteger _scriptKeywordLengthSort(id scriptA, id scriptB, void *context);
 
 						newInfoDict = [NSMutableDictionary dictionaryWithObjectsAndKeys:
 							scriptFilePath, @"Path", keyword, @"Keyword", title, @"Title", 
-							prefixOnlyNumber, @"PrefixOnly", nil];
+							prefixOnlyNumber, @"PrefixOnly",
+							//Scripts whose result depends only on their arguments may say so, and have their results cached
+							[NSNumber numberWithBool:[[scriptDict objectForKey:@"Idempotent"] boolValue]], @"Idempotent", nil];
 						
 						//The bundle may not be part of (or for defining) a set of scripts
 						if (scriptsSetName) {
@@ -232,6 +242,15 @@ NSInteger _scriptKeywordLengthSort(id scriptA, id scriptB, void *context);
 			NSLog(@"Warning: Could not load Adium script bundle at %@",filePath);
 		}
 	}
+	
+	//The longest keyword that matches wins, so that one keyword may begin with another
+	[flatScriptArray sortUsingFunction:_scriptKeywordLengthSort context:nil];
+	
+	[keywordMatcher release];
+	keywordMatcher = [[AIKeywordMatcher alloc] initWithKeywords:[flatScriptArray valueForKey:@"Keyword"]];
+	
+	//The scripts may have changed since their results were cached
+	[adium.applescriptabilityController.scriptExecutorPool flushCachedResults];
 }
 
 
@@ -249,7 +268,6 @@ NSInteger _scriptKeywordLengthSort(id scriptA, id scriptB, void *context);
 	
 	//Sort the scripts
 	[scriptArray sortUsingFunction:_scriptTitleSort context:nil];
-	[flatScriptArray sortUsingFunction:_scriptKeywordLengthSort context:nil];
 	
 	//Build the menu
 	[scriptMenu release]; scriptMenu = [[NSMenu alloc] initWithTitle:TITLE_INSERT_SCRIPT];
@@ -452,40 +470,10 @@ NSInteger _scriptKeywordLengthSort(id scriptA, id scriptB, void *context)
  */
 - (BOOL)delayedFilterAttributedString:(NSAttributedString *)inAttributedString context:(id)context uniqueID:(unsigned long long)uniqueID
 {
-	BOOL		beganProcessing = NO; 
-	NSString	*stringMessage;
-
-	if ((stringMessage = [inAttributedString string])) {
-		//Replace all keywords
-		for (NSMutableDictionary *infoDict in flatScriptArray) {
-			NSString	*keyword = [infoDict objectForKey:@"Keyword"];
-			BOOL		prefixOnly = [[infoDict objectForKey:@"PrefixOnly"] boolValue];
-
-			if ((prefixOnly && ([stringMessage rangeOfString:keyword options:(NSCaseInsensitiveSearch | NSAnchoredSearch)].location == 0)) ||
-			   (!prefixOnly && [stringMessage rangeOfString:keyword options:NSCaseInsensitiveSearch].location != NSNotFound)) {
-				NSNumber	*shouldSendNumber;
-
-				[self _replaceKeyword:keyword
-						   withScript:infoDict
-							 inString:stringMessage
-				   inAttributedString:[[inAttributedString mutableCopy] autorelease]
-							  context:context
-							 uniqueID:uniqueID];
-
-				shouldSendNumber = [infoDict objectForKey:@"ShouldSend"];
-				if ((shouldSendNumber) &&
-					(![shouldSendNumber boolValue]) &&
-					([context isKindOfClass:[AIContentObject class]])) {
-					[(AIContentObject *)context setSendContent:NO];
-				}
-				
-				beganProcessing = YES;
-				break;
-			}
-		}
-	}
-	
-    return beganProcessing;
+	return [self _filterAttributedString:inAttributedString
+						   mutableString:nil
+								 context:context
+								uniqueID:uniqueID];
 }
 
 /*!
@@ -499,61 +487,97 @@ NSInteger _scriptKeywordLengthSort(id scriptA, id scriptB, void *context)
 }
 
 /*!
- * @brief Replace one instance of a keyword within a string. This will be called once for each instance.
+ * @brief Look for script keywords and run the script for the first one found
+ *
+ * All keywords are found in a single pass over the string. Of those which occur outside of a link, the longest wins,
+ * as before; a PrefixOnly script's keyword only counts at the start of the message.
+ *
+ * @param mutableAttributedString inAttributedString itself if we already own a mutable copy of it, or nil to make one
+ * @result YES if we began running a script; NO if there was no keyword to replace
  */
-- (void)_replaceKeyword:(NSString *)keyword
-			 withScript:(NSMutableDictionary *)infoDict
-			   inString:(NSString *)inString
-	 inAttributedString:(NSMutableAttributedString *)attributedString
-				context:(id)context
-			   uniqueID:(unsigned long long)uniqueID
+- (BOOL)_filterAttributedString:(NSAttributedString *)inAttributedString
+				  mutableString:(NSMutableAttributedString *)mutableAttributedString
+						context:(id)context
+					   uniqueID:(unsigned long long)uniqueID
 {
-	NSScanner	*scanner;
-	BOOL		foundKeyword = NO;
+	NSUInteger	count = [flatScriptArray count];
+	
+	if (!count || ![inAttributedString length]) return NO;
 
-	//Scan for the keyword
-	scanner = [NSScanner scannerWithString:inString];
-	while (![scanner isAtEnd] && !foundKeyword) {
-		[scanner scanUpToString:keyword intoString:nil];
-		
-		if (([scanner scanString:keyword intoString:nil]) &&
-			([attributedString attribute:NSLinkAttributeName
-								 atIndex:([scanner scanLocation]-1) /* The scanner ends up one past the keyword */
-						  effectiveRange:nil] == nil)) {
-			//Scan the keyword and ensure it was not found within a link
-			NSInteger 		keywordStart, keywordEnd;
-			NSArray 	*argArray = nil;
-			NSString	*argString;
-			
-			//Scan arguments
-			keywordStart = [scanner scanLocation] - [keyword length];
-			if ([scanner scanString:@"{" intoString:nil]) {
-				if ([scanner scanUpToString:@"}" intoString:&argString]) {
-					argArray = [self _argumentsFromString:argString forScript:infoDict];
-					[scanner scanString:@"}" intoString:nil];
-				}				
-			}
-			keywordEnd = [scanner scanLocation];		
-			
-			//Run the script.
-			NSRange	keywordRange = NSMakeRange(keywordStart, keywordEnd - keywordStart);
-			[self _executeScript:infoDict 
-				   withArguments:argArray
-			 forAttributedString:attributedString
-					keywordRange:keywordRange
-						 context:context
-						uniqueID:uniqueID];
-			
-			foundKeyword = YES;
+	NSRange		*keywordRanges = malloc(count * sizeof(NSRange));
+	NSUInteger	i;
+
+	[keywordMatcher getFirstRanges:keywordRanges inAttributedString:inAttributedString excludingAttribute:NSLinkAttributeName];
+	
+	//flatScriptArray is sorted longest keyword first
+	for (i = 0; i < count; i++) {
+		NSMutableDictionary	*infoDict = [flatScriptArray objectAtIndex:i];
+		NSRange				keywordRange = keywordRanges[i];
+
+		if (keywordRange.location == NSNotFound ||
+			([[infoDict objectForKey:@"PrefixOnly"] boolValue] && keywordRange.location != 0)) continue;
+
+		NSNumber *shouldSendNumber = [infoDict objectForKey:@"ShouldSend"];
+		if ((shouldSendNumber) &&
+			(![shouldSendNumber boolValue]) &&
+			([context isKindOfClass:[AIContentObject class]])) {
+			[(AIContentObject *)context setSendContent:NO];
+		}
+
+		if (!mutableAttributedString) mutableAttributedString = [[inAttributedString mutableCopy] autorelease];
+
+		[self _replaceKeywordInRange:keywordRange
+						  withScript:infoDict
+				  inAttributedString:mutableAttributedString
+							 context:context
+							uniqueID:uniqueID];
+		break;
+	}
+
+	free(keywordRanges);
+	
+	return (i < count);
+}
+
+/*!
+ * @brief Scan the arguments following a keyword, then run its script to replace both
+ */
+- (void)_replaceKeywordInRange:(NSRange)keywordRange
+					withScript:(NSMutableDictionary *)infoDict
+			inAttributedString:(NSMutableAttributedString *)attributedString
+					   context:(id)context
+					  uniqueID:(unsigned long long)uniqueID
+{
+	NSScanner	*scanner = [NSScanner scannerWithString:[attributedString string]];
+	NSArray		*argArray = nil;
+	NSString	*argString;
+
+	//Scan arguments
+	[scanner setScanLocation:NSMaxRange(keywordRange)];
+	if ([scanner scanString:@"{" intoString:nil]) {
+		if ([scanner scanUpToString:@"}" intoString:&argString]) {
+			argArray = [self _argumentsFromString:argString forScript:infoDict];
+			[scanner scanString:@"}" intoString:nil];
 		}
 	}
+	keywordRange.length = [scanner scanLocation] - keywordRange.location;
+
+	//Run the script.
+	[self _executeScript:infoDict 
+		   withArguments:argArray
+	 forAttributedString:attributedString
+			keywordRange:keywordRange
+				 context:context
+				uniqueID:uniqueID];
 }
 
 /*!
  * @brief Execute the script as a separate task
  *
  * When the task is complete, we will be notified, at which point we perform the replacement for the script result
- * and pass the modified attributed string back to the content controller for use.
+ * and pass the modified attributed string back to the content controller for use. A script which takes longer than
+ * SCRIPT_TIMEOUT seconds is treated as having failed, counting any time spent waiting behind other scripts (such as
+ * contact alert scripts, which are allowed much longer) so the message is never held indefinitely.
  */
 - (void)_executeScript:(NSMutableDictionary *)infoDict 
 			   withArguments:(NSArray *)arguments
@@ -569,12 +593,14 @@ NSInteger _scriptKeywordLengthSort(id scriptA, id scriptB, void *context)
 		(context ? context : [NSNull null]), @"context",
 		nil];
 	
-	[adium.applescriptabilityController runApplescriptAtPath:[infoDict objectForKey:@"Path"]
-													  function:@"substitute"
-													 arguments:arguments
-											   notifyingTarget:self
-													  selector:@selector(applescriptDidRun:resultString:)
-													  userInfo:userInfo];
+	[adium.applescriptabilityController.scriptExecutorPool runScriptAtPath:[infoDict objectForKey:@"Path"]
+																  function:@"substitute"
+																 arguments:arguments
+																 cacheable:[[infoDict objectForKey:@"Idempotent"] boolValue]
+																   timeout:SCRIPT_TIMEOUT
+														   notifyingTarget:self
+																  selector:@selector(applescriptDidRun:resultString:)
+																  userInfo:userInfo];
 }
 
 /*!
@@ -605,10 +631,13 @@ NSInteger _scriptKeywordLengthSort(id scriptA, id scriptB, void *context)
 		}
 	}
 
-	//Inform the content controller that we're done if we don't need to do any more filtering
-	if (![self delayedFilterAttributedString:attributedString
-									 context:[userInfo objectForKey:@"context"]
-									uniqueID:uniqueID]) {
+	//Inform the content controller that we're done if we don't need to do any more filtering.
+	//The string is already ours to change, so keep replacing keywords in it rather than in a copy.
+	id context = [userInfo objectForKey:@"context"];
+	if (![self _filterAttributedString:attributedString
+						 mutableString:attributedString
+							   context:(context == [NSNull null] ? nil : context)
+							  uniqueID:uniqueID]) {
 		[adium.contentController delayedFilterDidFinish:attributedString
 												 uniqueID:uniqueID];
 	}
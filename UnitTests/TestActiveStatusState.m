@@ -0,0 +1,354 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestActiveStatusState.h"
+
+#import "AIStatusController.h"
+#import <Adium/AIAccount.h>
+#import <Adium/AIStatus.h>
+
+#define ACCOUNT_COUNT			4
+#define RANDOM_ACCOUNT_COUNT	20
+#define RANDOM_STEP_COUNT		2000
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+/*!
+ * @brief Just the parts of an account which count towards the active status states
+ */
+@interface TestActiveStatusAccount : NSObject {
+	NSString	*internalObjectID;
+	AIStatus	*statusState;
+	BOOL		online;
+	BOOL		enabled;
+}
++ (TestActiveStatusAccount *)accountWithID:(NSString *)internalObjectID statusState:(AIStatus *)statusState;
+@property (readonly, nonatomic) NSString *internalObjectID;
+@property (readwrite, retain, nonatomic) AIStatus *statusState;
+@property (readwrite, nonatomic) BOOL online;
+@property (readwrite, nonatomic) BOOL enabled;
+@end
+
+@implementation TestActiveStatusAccount
++ (TestActiveStatusAccount *)accountWithID:(NSString *)internalObjectID statusState:(AIStatus *)statusState {
+	TestActiveStatusAccount *account = [[[self alloc] init] autorelease];
+
+	account->internalObjectID = [internalObjectID copy];
+	account.statusState = statusState;
+	account.enabled = YES;
+
+	return account;
+}
+- (void)dealloc {
+	[internalObjectID release];
+	[statusState release];
+	[super dealloc];
+}
+//The status controller only looks at accounts
+- (BOOL)isKindOfClass:(Class)aClass {
+	return ((aClass == [AIAccount class]) || [super isKindOfClass:aClass]);
+}
+@synthesize internalObjectID, statusState, online, enabled;
+@end
+
+@interface TestActiveStatusAccountController : NSObject {
+	NSArray	*accounts;
+}
+@property (readwrite, retain, nonatomic) NSArray *accounts;
+@end
+
+@implementation TestActiveStatusAccountController
+- (void)dealloc {
+	[accounts release];
+	[super dealloc];
+}
+@synthesize accounts;
+@end
+
+/*!
+ * @brief Stands in for the shared AIAdium, providing only the account controller
+ */
+@interface TestActiveStatusAdium : NSObject {
+	TestActiveStatusAccountController	*accountController;
+}
+@property (readwrite, retain, nonatomic) TestActiveStatusAccountController *accountController;
+@end
+
+@implementation TestActiveStatusAdium
+- (void)dealloc {
+	[accountController release];
+	[super dealloc];
+}
+@synthesize accountController;
+@end
+
+/*!
+ * @brief A status controller with fixed offline and default statuses, rather than those from the built in state array
+ */
+@interface TestActiveStatusController : AIStatusController {
+@public
+	AIStatus	*testOfflineStatusState;
+	AIStatus	*testDefaultInitialStatusState;
+}
+@end
+
+@implementation TestActiveStatusController
+- (void)dealloc {
+	[testOfflineStatusState release];
+	[testDefaultInitialStatusState release];
+	[super dealloc];
+}
+- (AIStatus *)offlineStatusState {
+	return testOfflineStatusState;
+}
+- (AIStatus *)defaultInitialStatusState {
+	return testDefaultInitialStatusState;
+}
+@end
+
+static AIStatus *statusWithTitle(NSString *title, AIStatusType statusType)
+{
+	AIStatus *status = [AIStatus status];
+
+	[status setStatusType:statusType];
+	[status setTitle:title];
+
+	return status;
+}
+
+@interface TestActiveStatusState ()
+- (void)activeStatusStateChanged:(NSNotification *)notification;
+- (void)setAccount:(TestActiveStatusAccount *)account online:(BOOL)online;
+- (void)setAccount:(TestActiveStatusAccount *)account enabled:(BOOL)enabled;
+- (void)setAccount:(TestActiveStatusAccount *)account statusState:(AIStatus *)statusState;
+- (void)checkAgainstRecount:(NSString *)step;
+@end
+
+@implementation TestActiveStatusState
+
+- (void)setUp {
+	TestActiveStatusAdium *testAdium = [[[TestActiveStatusAdium alloc] init] autorelease];
+	NSUInteger i;
+
+	testAdium.accountController = [[[TestActiveStatusAccountController alloc] init] autorelease];
+	savedAdium = adium;
+	adium = (id<AIAdium>)[testAdium retain];
+
+	availableStatus = [statusWithTitle(@"Available", AIAvailableStatusType) retain];
+	awayStatus = [statusWithTitle(@"Away", AIAwayStatusType) retain];
+	busyStatus = [statusWithTitle(@"Busy", AIAwayStatusType) retain];
+
+	statusController = [[TestActiveStatusController alloc] init];
+	statusController->testOfflineStatusState = [statusWithTitle(@"Offline", AIOfflineStatusType) retain];
+	statusController->testDefaultInitialStatusState = [availableStatus retain];
+
+	accounts = [[NSMutableArray alloc] init];
+	for (i = 0; i < ACCOUNT_COUNT; i++) {
+		[accounts addObject:[TestActiveStatusAccount accountWithID:[NSString stringWithFormat:@"Test.%lu", (unsigned long)i]
+													  statusState:availableStatus]];
+	}
+	testAdium.accountController.accounts = accounts;
+
+	[[NSNotificationCenter defaultCenter] addObserver:self
+											 selector:@selector(activeStatusStateChanged:)
+												 name:AIStatusActiveStateChangedNotification
+											   object:nil];
+}
+
+- (void)tearDown {
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+
+	[statusController release]; statusController = nil;
+	[accounts release]; accounts = nil;
+	[availableStatus release]; availableStatus = nil;
+	[awayStatus release]; awayStatus = nil;
+	[busyStatus release]; busyStatus = nil;
+
+	[(id)adium release];
+	adium = savedAdium;
+}
+
+- (void)testMostCommonOnlineStatusActive {
+	[self setAccount:[accounts objectAtIndex:0] statusState:awayStatus];
+	[self setAccount:[accounts objectAtIndex:1] statusState:awayStatus];
+	[self setAccount:[accounts objectAtIndex:3] statusState:busyStatus];
+	[self setAccount:[accounts objectAtIndex:0] online:YES];
+	[self setAccount:[accounts objectAtIndex:1] online:YES];
+	[self setAccount:[accounts objectAtIndex:2] online:YES];
+	[self setAccount:[accounts objectAtIndex:3] enabled:NO];
+
+	STAssertEquals(statusController.activeStatusState, awayStatus, @"The status most online accounts have should be active");
+	STAssertEqualObjects([statusController allActiveStatusStates], ([NSSet setWithObjects:availableStatus, awayStatus, nil]),
+						 @"Every enabled account's status should be active");
+
+	[self setAccount:[accounts objectAtIndex:0] online:NO];
+	[self setAccount:[accounts objectAtIndex:1] online:NO];
+
+	STAssertEquals(statusController.activeStatusState, availableStatus, @"Offline accounts should not count");
+	[self checkAgainstRecount:@"After going offline"];
+}
+
+- (void)testOfflineWithNoAccountsOnline {
+	STAssertEquals(statusController.activeStatusState, statusController->testOfflineStatusState,
+				   @"With no accounts online, the offline status should be active");
+
+	TestActiveStatusAccount *account = [accounts objectAtIndex:2];
+	[self setAccount:account statusState:nil];
+	[self setAccount:account online:YES];
+
+	STAssertEquals(statusController.activeStatusState, availableStatus, @"An online account with no status should count as the default");
+	[self checkAgainstRecount:@"After an account with no status came online"];
+}
+
+- (void)testUnchangedAccountNotNotified {
+	TestActiveStatusAccount	*account = [accounts objectAtIndex:0];
+
+	[statusController activeStatusState];
+	notificationCount = 0;
+
+	[self setAccount:account statusState:availableStatus];
+	[self setAccount:account enabled:YES];
+	STAssertEquals(notificationCount, (NSUInteger)0, @"An account set to the status it already had should not notify");
+
+	[self setAccount:account online:YES];
+	STAssertEquals(notificationCount, (NSUInteger)1, @"An account coming online should notify");
+
+	[self setAccount:account statusState:awayStatus];
+	STAssertEquals(notificationCount, (NSUInteger)2, @"A new status should notify");
+	[self checkAgainstRecount:@"After changing status"];
+}
+
+- (void)testIdleNotNotified {
+	TestActiveStatusAccount	*account = [accounts objectAtIndex:0];
+
+	[self setAccount:account online:YES];
+	[statusController activeStatusState];
+	notificationCount = 0;
+
+	[statusController updateListObject:(AIListObject *)account keys:[NSSet setWithObject:@"idleSince"] silent:NO];
+	STAssertEquals(notificationCount, (NSUInteger)0, @"Going idle changes neither active state, so should not notify");
+}
+
+- (void)testDelayedChangesNotifiedOnce {
+	[statusController activeStatusState];
+	notificationCount = 0;
+
+	[statusController setDelayActiveStatusUpdates:YES];
+	for (TestActiveStatusAccount *account in accounts) {
+		[self setAccount:account online:YES];
+		[self setAccount:account statusState:awayStatus];
+	}
+	STAssertEquals(notificationCount, (NSUInteger)0, @"Nothing should be posted while delayed");
+	[statusController setDelayActiveStatusUpdates:NO];
+
+	STAssertEquals(notificationCount, (NSUInteger)1, @"Changes while delayed should be posted once");
+	STAssertEquals(statusController.activeStatusState, awayStatus, @"The active state should reflect every change while delayed");
+
+	[statusController setDelayActiveStatusUpdates:YES];
+	[self setAccount:[accounts objectAtIndex:0] statusState:awayStatus];
+	[statusController setDelayActiveStatusUpdates:NO];
+
+	STAssertEquals(notificationCount, (NSUInteger)1, @"A delay with no changes should post nothing");
+	[self checkAgainstRecount:@"After delays"];
+}
+
+- (void)testRandomChangesMatchRecount {
+	uint32_t	random = 48;
+	AIStatus	*randomStatuses[] = {availableStatus, awayStatus, busyStatus, nil};
+	NSUInteger	i, step;
+
+	for (i = ACCOUNT_COUNT; i < RANDOM_ACCOUNT_COUNT; i++) {
+		[accounts addObject:[TestActiveStatusAccount accountWithID:[NSString stringWithFormat:@"Test.%lu", (unsigned long)i]
+													  statusState:availableStatus]];
+	}
+
+	for (step = 0; step < RANDOM_STEP_COUNT; step++) {
+		TestActiveStatusAccount	*account = [accounts objectAtIndex:nextRandom(&random) % accounts.count];
+		uint32_t				action = nextRandom(&random) % 10;
+		BOOL					delayed = (nextRandom(&random) % 8 == 0);
+
+		if (delayed) [statusController setDelayActiveStatusUpdates:YES];
+
+		if (action < 4) {
+			[self setAccount:account online:!account.online];
+		} else if (action < 5) {
+			[self setAccount:account enabled:!account.enabled];
+		} else {
+			[self setAccount:account statusState:randomStatuses[nextRandom(&random) % 4]];
+		}
+
+		if (delayed) [statusController setDelayActiveStatusUpdates:NO];
+
+		[self checkAgainstRecount:[NSString stringWithFormat:@"Step %lu", (unsigned long)step]];
+	}
+}
+
+- (void)activeStatusStateChanged:(NSNotification *)notification {
+	notificationCount++;
+}
+
+- (void)setAccount:(TestActiveStatusAccount *)account online:(BOOL)online {
+	account.online = online;
+	[statusController updateListObject:(AIListObject *)account keys:[NSSet setWithObject:@"isOnline"] silent:NO];
+}
+
+- (void)setAccount:(TestActiveStatusAccount *)account enabled:(BOOL)enabled {
+	account.enabled = enabled;
+	[statusController updateListObject:(AIListObject *)account keys:[NSSet setWithObject:KEY_ENABLED] silent:NO];
+}
+
+- (void)setAccount:(TestActiveStatusAccount *)account statusState:(AIStatus *)statusState {
+	account.statusState = statusState;
+	[statusController updateListObject:(AIListObject *)account keys:[NSSet setWithObject:@"accountStatus"] silent:NO];
+}
+
+/*!
+ * @brief Check both active states against counting up every account, as the status controller used to
+ *
+ * When statuses tie for the most online accounts, any of them may be active.
+ */
+- (void)checkAgainstRecount:(NSString *)step {
+	NSCountedSet	*onlineStatusCounts = [NSCountedSet set];
+	NSMutableSet	*enabledStatuses = [NSMutableSet set];
+	NSUInteger		highestCount = 0;
+
+	for (TestActiveStatusAccount *account in accounts) {
+		if (account.online) [onlineStatusCounts addObject:(account.statusState ? account.statusState : availableStatus)];
+		if (account.enabled && account.statusState) [enabledStatuses addObject:account.statusState];
+	}
+
+	for (AIStatus *statusState in onlineStatusCounts) {
+		highestCount = MAX(highestCount, [onlineStatusCounts countForObject:statusState]);
+	}
+
+	AIStatus *activeStatusState = statusController.activeStatusState;
+	if (highestCount) {
+		STAssertEquals([onlineStatusCounts countForObject:activeStatusState], highestCount,
+					   @"%@: the active state %@ is not used by the most online accounts", step, activeStatusState);
+	} else {
+		STAssertEquals(activeStatusState, statusController->testOfflineStatusState,
+					   @"%@: with no accounts online, %@ is active rather than offline", step, activeStatusState);
+	}
+
+	STAssertEqualObjects([statusController allActiveStatusStates], enabledStatuses,
+						 @"%@: the statuses of enabled accounts differ from a recount", step);
+}
+
+@end
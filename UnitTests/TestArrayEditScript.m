@@ -0,0 +1,143 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestArrayEditScript.h"
+
+#import <AIUtilities/AIArrayEditScript.h>
+
+#define RANDOM_TRIALS	500
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static NSArray *applied(AIArrayEditScript *script, NSArray *oldArray, NSArray *newArray)
+{
+	NSMutableArray *array = [[oldArray mutableCopy] autorelease];
+
+	[script applyToArray:array withObjectsFromArray:newArray];
+
+	return array;
+}
+
+@implementation TestArrayEditScript
+
+- (void)testIdenticalArrays {
+	NSArray				*array = [NSArray arrayWithObjects:@"a", @"b", @"c", nil];
+	AIArrayEditScript	*script = [AIArrayEditScript editScriptFromArray:array toArray:array];
+
+	STAssertTrue(script.isEmpty, @"Nothing should change between identical arrays");
+	STAssertTrue([[AIArrayEditScript editScriptFromArray:[NSArray array] toArray:[NSArray array]] isEmpty], @"Nor between empty ones");
+}
+
+- (void)testRemovalsAndInsertions {
+	NSArray				*oldArray = [NSArray arrayWithObjects:@"a", @"b", @"c", @"d", nil];
+	NSArray				*newArray = [NSArray arrayWithObjects:@"x", @"a", @"c", @"y", nil];
+	AIArrayEditScript	*script = [AIArrayEditScript editScriptFromArray:oldArray toArray:newArray];
+
+	STAssertEquals(script.removedIndexes.count, (NSUInteger)2, @"b and d should be removed");
+	STAssertTrue([script.removedIndexes containsIndex:1] && [script.removedIndexes containsIndex:3], @"Removals should use old indexes");
+	STAssertEquals(script.moveCount, (NSUInteger)0, @"a and c keep their order, so nothing should move");
+	STAssertEquals(script.insertedIndexes.count, (NSUInteger)2, @"x and y should be inserted");
+	STAssertTrue([script.insertedIndexes containsIndex:0] && [script.insertedIndexes containsIndex:3], @"Insertions should use new indexes");
+	STAssertEqualObjects(applied(script, oldArray, newArray), newArray, @"Applying the script should give the new array");
+}
+
+- (void)testSingleMove {
+	NSArray				*oldArray = [NSArray arrayWithObjects:@"a", @"b", @"c", @"d", @"e", nil];
+	NSArray				*newArray = [NSArray arrayWithObjects:@"b", @"c", @"d", @"e", @"a", nil];
+	AIArrayEditScript	*script = [AIArrayEditScript editScriptFromArray:oldArray toArray:newArray];
+	__block NSUInteger	from = NSNotFound, to = NSNotFound;
+
+	STAssertEquals(script.moveCount, (NSUInteger)1, @"Moving one object to the end should take one move");
+	[script enumerateMovesUsingBlock:^(NSUInteger fromIndex, NSUInteger toIndex) {
+		from = fromIndex;
+		to = toIndex;
+	}];
+	STAssertEquals(from, (NSUInteger)0, @"a should move from the front");
+	STAssertEquals(to, (NSUInteger)4, @"to the end");
+	STAssertEqualObjects(applied(script, oldArray, newArray), newArray, @"Applying the script should give the new array");
+}
+
+- (void)testReverse {
+	NSMutableArray	*oldArray = [NSMutableArray array];
+
+	for (NSUInteger i = 0; i < 50; i++) {
+		[oldArray addObject:[NSNumber numberWithUnsignedInteger:i]];
+	}
+
+	NSArray				*newArray = [[oldArray reverseObjectEnumerator] allObjects];
+	AIArrayEditScript	*script = [AIArrayEditScript editScriptFromArray:oldArray toArray:newArray];
+
+	STAssertEquals(script.moveCount, (NSUInteger)49, @"Reversing should keep one object in place and move the rest");
+	STAssertEqualObjects(applied(script, oldArray, newArray), newArray, @"Applying the script should give the new array");
+}
+
+- (void)testMatchesByIdentity {
+	NSString			*first = [NSMutableString stringWithString:@"same"];
+	NSString			*second = [NSMutableString stringWithString:@"same"];
+	AIArrayEditScript	*script = [AIArrayEditScript editScriptFromArray:[NSArray arrayWithObject:first]
+															   toArray:[NSArray arrayWithObject:second]];
+
+	STAssertEquals(script.removedIndexes.count, (NSUInteger)1, @"An equal but distinct object should count as removed");
+	STAssertEquals(script.insertedIndexes.count, (NSUInteger)1, @"and its replacement as inserted");
+}
+
+/*!
+ * @brief Random removals, insertions and shuffles should always be reproduced, with no more moves than needed
+ *
+ * The fewest moves is the number of kept objects less the longest run of them which is already in order.
+ */
+- (void)testRandomEdits {
+	uint32_t	seed = 45;
+	NSUInteger	nextValue = 0;
+
+	for (NSUInteger trial = 0; trial < RANDOM_TRIALS; trial++) {
+		NSMutableArray	*oldArray = [NSMutableArray array];
+		NSUInteger		count = nextRandom(&seed) % 40;
+
+		for (NSUInteger i = 0; i < count; i++) {
+			[oldArray addObject:[NSNumber numberWithUnsignedInteger:nextValue++]];
+		}
+
+		NSMutableArray *newArray = [NSMutableArray array];
+		for (id object in oldArray) {
+			if (nextRandom(&seed) % 4) [newArray addObject:object];
+		}
+
+		NSUInteger shuffles = nextRandom(&seed) % 4;
+		for (NSUInteger i = 0; i < shuffles && newArray.count; i++) {
+			id object = [[newArray objectAtIndex:nextRandom(&seed) % newArray.count] retain];
+			[newArray removeObject:object];
+			[newArray insertObject:object atIndex:nextRandom(&seed) % (newArray.count + 1)];
+			[object release];
+		}
+
+		NSUInteger insertions = nextRandom(&seed) % 5;
+		for (NSUInteger i = 0; i < insertions; i++) {
+			[newArray insertObject:[NSNumber numberWithUnsignedInteger:nextValue++] atIndex:nextRandom(&seed) % (newArray.count + 1)];
+		}
+
+		AIArrayEditScript *script = [AIArrayEditScript editScriptFromArray:oldArray toArray:newArray];
+
+		STAssertEqualObjects(applied(script, oldArray, newArray), newArray, @"Trial %lu should reproduce the new array", trial);
+		STAssertTrue(script.moveCount <= shuffles, @"Trial %lu moved %lu objects after %lu shuffles", trial, script.moveCount, shuffles);
+	}
+}
+
+@end
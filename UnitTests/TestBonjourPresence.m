@@ -0,0 +1,506 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestBonjourPresence.h"
+
+#import "AWEzv.h"
+#import "AWEzvContact.h"
+#import "AWEzvContactManager.h"
+#import "AWEzvContactManagerRendezvous.h"
+#import "AWEzvRendezvousData.h"
+#import "AWEzvLoopbackBackend.h"
+#import <CommonCrypto/CommonDigest.h>
+
+#define PEER_PORT				@"5298"
+#define PICTURE_LENGTH			4096
+#define RANDOM_PEER_COUNT		30
+#define RANDOM_ROUND_COUNT		40
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static NSData *randomPicture(uint32_t *random)
+{
+	NSMutableData	*picture = [NSMutableData dataWithLength:PICTURE_LENGTH];
+	unsigned char	*bytes = [picture mutableBytes];
+	NSUInteger		i;
+
+	for (i = 0; i < PICTURE_LENGTH; i++) bytes[i] = (unsigned char)nextRandom(random);
+
+	return picture;
+}
+
+static NSData *pictureHash(NSData *picture)
+{
+	unsigned char digest[CC_SHA1_DIGEST_LENGTH];
+	CC_SHA1([picture bytes], (CC_LONG)[picture length], digest);
+
+	return [NSData dataWithBytes:digest length:CC_SHA1_DIGEST_LENGTH];
+}
+
+static NSString *stateDescription(NSString *name, AWEzvStatus status, NSString *message)
+{
+	return [NSString stringWithFormat:@"%@, status %d, message \"%@\"", name, status, (message ? message : @"")];
+}
+
+static AWEzvStatus statusForField(NSString *status)
+{
+	if ([status isEqualToString:@"dnd"]) return AWEzvAway;
+	if ([status isEqualToString:@"away"]) return AWEzvIdle;
+	return AWEzvOnline;
+}
+
+/*!
+ * @brief Stands in for AWBonjourAccount, remembering what it was last told about each contact
+ */
+@interface TestBonjourClient : NSObject <AWEzvClientProtocol> {
+@public
+	NSMutableDictionary	*reportedStates;
+	NSMutableDictionary	*reportedPictures;
+	NSMutableArray		*errors;
+	NSUInteger			stateChangeCount;
+	NSUInteger			imageChangeCount;
+}
+@end
+
+@implementation TestBonjourClient
+
+- (id)init
+{
+	if ((self = [super init])) {
+		reportedStates = [[NSMutableDictionary alloc] init];
+		reportedPictures = [[NSMutableDictionary alloc] init];
+		errors = [[NSMutableArray alloc] init];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[reportedStates release];
+	[reportedPictures release];
+	[errors release];
+
+	[super dealloc];
+}
+
+- (void)reportLoggedIn {}
+- (void)reportLoggedOut {}
+
+- (void)userLoggedOut:(AWEzvContact *)contact
+{
+	[reportedStates removeObjectForKey:contact.uniqueID];
+	[reportedPictures removeObjectForKey:contact.uniqueID];
+}
+
+- (void)userChangedState:(AWEzvContact *)contact
+{
+	stateChangeCount++;
+	[reportedStates setObject:stateDescription(contact.name, contact.status, contact.statusMessage) forKey:contact.uniqueID];
+}
+
+- (void)userChangedImage:(AWEzvContact *)contact
+{
+	imageChangeCount++;
+	if (contact.contactImageData) {
+		[reportedPictures setObject:contact.contactImageData forKey:contact.uniqueID];
+	} else {
+		[reportedPictures removeObjectForKey:contact.uniqueID];
+	}
+}
+
+- (void)user:(AWEzvContact *)contact sentMessage:(NSString *)message withHtml:(NSString *)html {}
+- (void)user:(AWEzvContact *)contact typingNotification:(AWEzvTyping)typingStatus {}
+- (void)user:(AWEzvContact *)contact typeAhead:(NSString *)message withHtml:(NSString *)html {}
+- (void)updateProgressForFileTransfer:(EKEzvFileTransfer *)fileTransfer percent:(NSNumber *)percent bytesSent:(NSNumber *)bytesSent {}
+- (void)remoteCanceledFileTransfer:(EKEzvFileTransfer *)fileTransfer {}
+- (void)transferFailed:(EKEzvFileTransfer *)fileTransfer {}
+- (void)user:(AWEzvContact *)contact sentFile:(EKEzvFileTransfer *)fileTransfer {}
+- (void)remoteUserBeganDownload:(EKEzvOutgoingFileTransfer *)fileTransfer {}
+- (void)remoteUserFinishedDownload:(EKEzvOutgoingFileTransfer *)fileTransfer {}
+
+- (void)reportError:(NSString *)error ofLevel:(AWEzvErrorSeverity)severity
+{
+	[errors addObject:error];
+}
+
+- (void)reportError:(NSString *)error ofLevel:(AWEzvErrorSeverity)severity forUser:(NSString *)contact
+{
+	[errors addObject:[NSString stringWithFormat:@"%@: %@", contact, error]];
+}
+
+@end
+
+/*!
+ * @brief Someone else on the loopback LAN, publishing a _presence._tcp service as iChat would
+ */
+@interface TestBonjourPeer : NSObject {
+	AWEzvLoopbackBackend	*backend;
+	NSString				*name;
+	NSString				*nickname;
+	NSString				*status;
+	NSString				*message;
+	NSData					*picture;
+	BOOL					online;
+}
+- (id)initWithIndex:(NSUInteger)index network:(AWEzvLoopbackNetwork *)network;
+- (void)join;
+- (void)leave;
+- (void)announce;
+- (void)setPicture:(NSData *)inPicture;
+@property (readonly, nonatomic) NSString *name;
+@property (readonly, nonatomic) NSString *nickname;
+@property (readwrite, copy, nonatomic) NSString *status;
+@property (readwrite, copy, nonatomic) NSString *message;
+@property (readonly, nonatomic) NSData *picture;
+@property (readonly, nonatomic) BOOL online;
+@end
+
+@implementation TestBonjourPeer
+
+- (id)initWithIndex:(NSUInteger)index network:(AWEzvLoopbackNetwork *)network
+{
+	if ((self = [super init])) {
+		backend = [[AWEzvLoopbackBackend alloc] initWithNetwork:network];
+		name = [[NSString alloc] initWithFormat:@"peer%lu@test%lu", (unsigned long)index, (unsigned long)index];
+		nickname = [[NSString alloc] initWithFormat:@"Peer %lu", (unsigned long)index];
+		status = @"avail";
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[backend release];
+	[name release];
+	[nickname release];
+	[status release];
+	[message release];
+	[picture release];
+
+	[super dealloc];
+}
+
+- (NSData *)TXTRecord
+{
+	AWEzvRendezvousData *data = [[[AWEzvRendezvousData alloc] init] autorelease];
+
+	[data setField:@"1st" content:nickname];
+	[data setField:@"status" content:status];
+	[data setField:@"port.p2pj" content:PEER_PORT];
+	[data setField:@"txtvers" content:@"1"];
+	[data setField:@"version" content:@"1"];
+	if (message) [data setField:@"msg" content:message];
+	if (picture) [data setField:@"phsh" content:pictureHash(picture)];
+
+	return [data dataAsTXTRecordData];
+}
+
+- (void)join
+{
+	[backend registerInstanceName:name port:0 TXTRecord:[self TXTRecord]];
+	if (picture) [backend setImageRecord:picture];
+	online = YES;
+}
+
+- (void)leave
+{
+	[backend unregister];
+	online = NO;
+}
+
+- (void)announce
+{
+	[backend updateTXTRecord:[self TXTRecord]];
+}
+
+- (void)setPicture:(NSData *)inPicture
+{
+	if (picture != inPicture) {
+		[picture release];
+		picture = [inPicture retain];
+	}
+
+	if (online) [backend setImageRecord:picture];
+}
+
+@synthesize name, nickname, status, message, picture, online;
+
+@end
+
+@interface TestBonjourPresence ()
+- (TestBonjourPeer *)addPeer;
+- (void)catchUp;
+- (void)checkClientAgainstPeers:(NSString *)step;
+@end
+
+@implementation TestBonjourPresence
+
+- (void)setUp {
+	network = [[AWEzvLoopbackNetwork alloc] init];
+	network.deliversAutomatically = NO;
+
+	client = [[TestBonjourClient alloc] init];
+	ezv = [[AWEzv alloc] initWithClient:client];
+	[ezv setName:@"Test"];
+	[ezv setStatus:AWEzvOnline withMessage:nil];
+
+	AWEzvLoopbackBackend *backend = [[[AWEzvLoopbackBackend alloc] initWithNetwork:network] autorelease];
+	manager = [[AWEzvContactManager alloc] initWithClient:ezv backend:backend];
+
+	peers = [[NSMutableArray alloc] init];
+}
+
+- (void)tearDown {
+	[manager logout];
+	[manager release]; manager = nil;
+	[ezv release]; ezv = nil;
+	[client release]; client = nil;
+	[peers release]; peers = nil;
+	[network release]; network = nil;
+}
+
+- (void)testJoiningPeerReported {
+	uint32_t		random = 46;
+	TestBonjourPeer	*peer = [self addPeer];
+
+	[peer setPicture:randomPicture(&random)];
+	[peer join];
+	[manager login];
+	[self catchUp];
+
+	STAssertEquals(client->stateChangeCount, (NSUInteger)1, @"Joining should be reported once");
+	STAssertEquals(client->imageChangeCount, (NSUInteger)1, @"The picture should be reported once");
+	STAssertNotNil([manager contactForIdentifier:peer.name], @"The peer should be a contact");
+	[self checkClientAgainstPeers:@"After joining"];
+}
+
+- (void)testUnchangedRecordIgnored {
+	TestBonjourPeer	*peer = [self addPeer];
+
+	[peer join];
+	[manager login];
+	[self catchUp];
+
+	NSUInteger	parseCount = [AWEzvRendezvousData TXTRecordParseCount];
+	NSUInteger	stateChangeCount = client->stateChangeCount;
+
+	[peer announce];
+	[peer announce];
+	[self catchUp];
+
+	STAssertEquals([AWEzvRendezvousData TXTRecordParseCount] - parseCount, (NSUInteger)0, @"An identical record should not be parsed again");
+	STAssertEquals(client->stateChangeCount, stateChangeCount, @"An identical record should not be reported");
+	[self checkClientAgainstPeers:@"After refreshing"];
+}
+
+- (void)testOnlyChangedFieldsReported {
+	uint32_t		random = 47;
+	TestBonjourPeer	*peer = [self addPeer];
+
+	[peer setPicture:randomPicture(&random)];
+	[peer join];
+	[manager login];
+	[self catchUp];
+
+	NSUInteger	stateChangeCount = client->stateChangeCount;
+	NSUInteger	imageChangeCount = client->imageChangeCount;
+	NSUInteger	imageResultCount = network.imageResultCount;
+
+	peer.status = @"dnd";
+	[peer announce];
+	[self catchUp];
+
+	STAssertEquals(client->stateChangeCount, stateChangeCount + 1, @"The new status should be reported");
+	STAssertEquals([manager contactForIdentifier:peer.name].status, AWEzvAway, @"dnd should be shown as away");
+	STAssertEquals(client->imageChangeCount, imageChangeCount, @"An unchanged picture should not be reported again");
+	STAssertEquals(network.imageResultCount, imageResultCount, @"An unchanged picture should not be fetched again");
+
+	peer.message = @"Lunch";
+	[peer announce];
+	[self catchUp];
+
+	STAssertEquals(client->stateChangeCount, stateChangeCount + 2, @"The new message should be reported");
+	[self checkClientAgainstPeers:@"After changing status and message"];
+}
+
+- (void)testAwayAndBackReportsNothing {
+	TestBonjourPeer	*peer = [self addPeer];
+
+	[peer join];
+	[manager login];
+	[self catchUp];
+
+	NSUInteger	stateChangeCount = client->stateChangeCount;
+
+	peer.status = @"away";
+	[peer announce];
+	peer.status = @"avail";
+	[peer announce];
+	[self catchUp];
+
+	STAssertEquals(client->stateChangeCount, stateChangeCount, @"Away and straight back should not be reported");
+	[self checkClientAgainstPeers:@"After away and back"];
+}
+
+- (void)testPictureFetchedOncePerHash {
+	uint32_t	random = 48;
+	NSData		*stockPicture = randomPicture(&random);
+	NSUInteger	i;
+
+	for (i = 0; i < 3; i++) {
+		TestBonjourPeer *peer = [self addPeer];
+		[peer setPicture:stockPicture];
+		[peer join];
+	}
+
+	TestBonjourPeer *peer = [self addPeer];
+	[peer setPicture:randomPicture(&random)];
+	[peer join];
+
+	[manager login];
+	[self catchUp];
+
+	STAssertEquals(network.imageResultCount, (NSUInteger)2, @"Each distinct picture should be fetched once");
+	STAssertEquals(client->imageChangeCount, (NSUInteger)4, @"Every peer's picture should be reported");
+	[self checkClientAgainstPeers:@"After sharing a picture"];
+}
+
+- (void)testLeavingPeerForgotten {
+	TestBonjourPeer	*stayingPeer = [self addPeer];
+	TestBonjourPeer	*leavingPeer = [self addPeer];
+
+	[stayingPeer join];
+	[leavingPeer join];
+	[manager login];
+	[self catchUp];
+
+	[leavingPeer leave];
+	[self catchUp];
+
+	STAssertNil([manager contactForIdentifier:leavingPeer.name], @"A peer who left should be forgotten");
+	STAssertNotNil([manager contactForIdentifier:stayingPeer.name], @"Other peers should stay");
+	[self checkClientAgainstPeers:@"After leaving"];
+
+	[leavingPeer join];
+	[self catchUp];
+
+	STAssertNotNil([manager contactForIdentifier:leavingPeer.name], @"A peer who came back should be a contact again");
+	[self checkClientAgainstPeers:@"After coming back"];
+}
+
+- (void)testRandomFlapsMatchPeers {
+	uint32_t	random = 49;
+	NSUInteger	i, round;
+
+	for (i = 0; i < RANDOM_PEER_COUNT; i++) {
+		TestBonjourPeer	*peer = [self addPeer];
+		if (nextRandom(&random) % 2) [peer setPicture:randomPicture(&random)];
+		[peer join];
+	}
+
+	[manager login];
+	[self catchUp];
+	[self checkClientAgainstPeers:@"After login"];
+
+	for (round = 0; round < RANDOM_ROUND_COUNT; round++) {
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+		for (TestBonjourPeer *peer in peers) {
+			uint32_t action = nextRandom(&random) % 100;
+
+			if (!peer.online) {
+				if (action < 30) [peer join];
+
+			} else if (action < 15) {
+				NSString *status = [[peer.status retain] autorelease];
+				peer.status = @"away";
+				[peer announce];
+				peer.status = status;
+				[peer announce];
+
+			} else if (action < 25) {
+				peer.status = ([peer.status isEqualToString:@"dnd"] ? @"avail" : @"dnd");
+				[peer announce];
+
+			} else if (action < 30) {
+				peer.message = (peer.message ? nil : [NSString stringWithFormat:@"Round %lu", (unsigned long)round]);
+				[peer announce];
+
+			} else if (action < 35) {
+				[peer announce];
+
+			} else if (action < 38) {
+				[peer setPicture:randomPicture(&random)];
+				[peer announce];
+
+			} else if (action < 45) {
+				[peer leave];
+			}
+		}
+
+		[self catchUp];
+		[self checkClientAgainstPeers:[NSString stringWithFormat:@"Round %lu", (unsigned long)round]];
+
+		[pool release];
+	}
+}
+
+- (TestBonjourPeer *)addPeer {
+	TestBonjourPeer *peer = [[[TestBonjourPeer alloc] initWithIndex:peers.count network:network] autorelease];
+	[peers addObject:peer];
+
+	return peer;
+}
+
+/*!
+ * @brief Deliver everything the peers published, then report the debounced state changes straight away
+ */
+- (void)catchUp {
+	[network deliverPendingResults];
+	[manager flushContactStateChanges];
+}
+
+/*!
+ * @brief Check that the client was left with every peer's latest state and picture
+ */
+- (void)checkClientAgainstPeers:(NSString *)step {
+	for (TestBonjourPeer *peer in peers) {
+		NSString	*reportedState = [client->reportedStates objectForKey:peer.name];
+		NSData		*reportedPicture = [client->reportedPictures objectForKey:peer.name];
+
+		if (!peer.online) {
+			STAssertNil(reportedState, @"%@: %@ is offline, but is still listed", step, peer.name);
+			STAssertNil([manager contactForIdentifier:peer.name], @"%@: %@ is offline, but is still a contact", step, peer.name);
+			continue;
+		}
+
+		STAssertEqualObjects(reportedState, stateDescription(peer.nickname, statusForField(peer.status), peer.message),
+							 @"%@: %@ was reported with the wrong state", step, peer.name);
+		STAssertTrue(reportedPicture == peer.picture || [reportedPicture isEqualToData:peer.picture],
+					 @"%@: %@ was shown with a picture of %lu bytes, expected %lu", step, peer.name,
+					 (unsigned long)reportedPicture.length, (unsigned long)peer.picture.length);
+	}
+
+	STAssertEquals(client->errors.count, (NSUInteger)0, @"%@: errors were reported: %@", step, client->errors);
+}
+
+@end
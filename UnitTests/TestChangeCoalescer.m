@@ -0,0 +1,195 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestChangeCoalescer.h"
+
+#import <AIUtilities/AIChangeCoalescer.h>
+
+#define RANDOM_KEYS		64
+#define RANDOM_CHANGES	5000
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+@implementation TestChangeCoalescer
+
+- (void)testMergesChangesPerKey {
+	int					keyStorage[2], *keys = keyStorage;
+	__block NSUInteger	calls = 0, changesA = 0, changesB = 0;
+	AIChangeCoalescer	*coalescer = [[[AIChangeCoalescer alloc] initWithHandler:^(void *key, NSUInteger changes) {
+		calls++;
+		if (key == &keys[0]) changesA = changes;
+		if (key == &keys[1]) changesB = changes;
+	}] autorelease];
+
+	coalescer.schedulesFlushes = NO;
+	[coalescer addChanges:1 forKey:&keys[0]];
+	[coalescer addChanges:4 forKey:&keys[1]];
+	[coalescer addChanges:2 forKey:&keys[0]];
+	[coalescer addChanges:1 forKey:&keys[0]];
+	STAssertEquals(coalescer.pendingKeyCount, (NSUInteger)2, @"Two keys should have changes pending");
+	STAssertEquals([coalescer changesForKey:&keys[0]], (NSUInteger)3, @"Changes for a key should be ORed together");
+
+	[coalescer flush];
+	STAssertEquals(calls, (NSUInteger)2, @"The handler should be called once per key");
+	STAssertEquals(changesA, (NSUInteger)3, @"with all of the first key's changes");
+	STAssertEquals(changesB, (NSUInteger)4, @"and all of the second's");
+	STAssertEquals(coalescer.pendingKeyCount, (NSUInteger)0, @"Nothing should be pending after a flush");
+	STAssertEquals(coalescer.flushCount, (NSUInteger)1, @"One flush should be counted");
+
+	[coalescer flush];
+	STAssertEquals(calls, (NSUInteger)2, @"Flushing with nothing pending should do nothing");
+	STAssertEquals(coalescer.flushCount, (NSUInteger)1, @"nor be counted");
+}
+
+- (void)testFirstChangeOrder {
+	int					keyStorage[4], *keys = keyStorage;
+	NSMutableArray		*order = [NSMutableArray array];
+	AIChangeCoalescer	*coalescer = [[[AIChangeCoalescer alloc] initWithHandler:^(void *key, NSUInteger changes) {
+		[order addObject:[NSNumber numberWithInteger:(int *)key - keys]];
+	}] autorelease];
+
+	coalescer.schedulesFlushes = NO;
+	[coalescer addChanges:1 forKey:&keys[2]];
+	[coalescer addChanges:1 forKey:&keys[0]];
+	[coalescer addChanges:1 forKey:&keys[3]];
+	[coalescer addChanges:2 forKey:&keys[2]];
+	[coalescer addChanges:1 forKey:&keys[1]];
+	[coalescer flush];
+
+	STAssertEqualObjects(order, ([NSArray arrayWithObjects:[NSNumber numberWithInt:2], [NSNumber numberWithInt:0],
+								  [NSNumber numberWithInt:3], [NSNumber numberWithInt:1], nil]),
+						 @"Keys should be handed over in the order they first had changes added");
+}
+
+- (void)testRemoveKey {
+	int					keyStorage[2], *keys = keyStorage;
+	NSMutableArray		*order = [NSMutableArray array];
+	AIChangeCoalescer	*coalescer = [[[AIChangeCoalescer alloc] initWithHandler:^(void *key, NSUInteger changes) {
+		[order addObject:[NSNumber numberWithInteger:(int *)key - keys]];
+	}] autorelease];
+
+	coalescer.schedulesFlushes = NO;
+	[coalescer addChanges:1 forKey:&keys[0]];
+	[coalescer addChanges:1 forKey:&keys[1]];
+	[coalescer removeKey:&keys[0]];
+	STAssertEquals([coalescer changesForKey:&keys[0]], (NSUInteger)0, @"A removed key should have nothing pending");
+	[coalescer flush];
+	STAssertEqualObjects(order, [NSArray arrayWithObject:[NSNumber numberWithInt:1]], @"A removed key should not be handed over");
+
+	//Removed and added again: handed over once, with only the later changes
+	[order removeAllObjects];
+	[coalescer addChanges:1 forKey:&keys[0]];
+	[coalescer removeKey:&keys[0]];
+	[coalescer addChanges:2 forKey:&keys[0]];
+	STAssertEquals([coalescer changesForKey:&keys[0]], (NSUInteger)2, @"Changes from before the removal should be gone");
+	[coalescer flush];
+	STAssertEqualObjects(order, [NSArray arrayWithObject:[NSNumber numberWithInt:0]], @"A key added back should be handed over once");
+}
+
+- (void)testChangesAddedWhileFlushing {
+	int					keyStorage[3], *keys = keyStorage;
+	NSMutableArray		*order = [NSMutableArray array];
+	__block AIChangeCoalescer	*coalescer = nil;
+
+	coalescer = [[[AIChangeCoalescer alloc] initWithHandler:^(void *key, NSUInteger changes) {
+		[order addObject:[NSNumber numberWithInteger:(int *)key - keys]];
+		if (key == &keys[0]) {
+			//Handing over one key adds changes for itself, one still waiting and one not yet pending
+			[coalescer addChanges:8 forKey:&keys[0]];
+			[coalescer addChanges:8 forKey:&keys[1]];
+			[coalescer addChanges:8 forKey:&keys[2]];
+		}
+	}] autorelease];
+
+	coalescer.schedulesFlushes = NO;
+	[coalescer addChanges:1 forKey:&keys[0]];
+	[coalescer addChanges:1 forKey:&keys[1]];
+	[coalescer flush];
+
+	STAssertEqualObjects(order, ([NSArray arrayWithObjects:[NSNumber numberWithInt:0], [NSNumber numberWithInt:1],
+								  [NSNumber numberWithInt:0], [NSNumber numberWithInt:2], nil]),
+						 @"Changes added while flushing should be handed over in the same flush");
+	STAssertEquals(coalescer.pendingKeyCount, (NSUInteger)0, @"Nothing should be left pending");
+}
+
+- (void)testFlushesAtEndOfRunLoopTurn {
+	int					key;
+	__block NSUInteger	calls = 0, handedOver = 0;
+	AIChangeCoalescer	*coalescer = [[[AIChangeCoalescer alloc] initWithHandler:^(void *key, NSUInteger changes) {
+		calls++;
+		handedOver = changes;
+	}] autorelease];
+
+	[coalescer addChanges:1 forKey:&key];
+	[coalescer addChanges:2 forKey:&key];
+	STAssertEquals(calls, (NSUInteger)0, @"Nothing should be handed over until the run loop turns");
+
+	NSDate *limit = [NSDate dateWithTimeIntervalSinceNow:2.0];
+	while (!calls && [limit timeIntervalSinceNow] > 0) {
+		[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+	}
+	STAssertEquals(calls, (NSUInteger)1, @"The changes should be handed over once the run loop turns");
+	STAssertEquals(handedOver, (NSUInteger)3, @"all together");
+}
+
+- (void)testRandomChanges {
+	int					keyStorage[RANDOM_KEYS], *keys = keyStorage;
+	NSUInteger			expected[RANDOM_KEYS], received[RANDOM_KEYS];
+	uint32_t			random = 1;
+	NSUInteger			*receivedChanges = received;
+	__block NSUInteger	calls = 0, expectedCalls = 0;
+	AIChangeCoalescer	*coalescer = [[[AIChangeCoalescer alloc] initWithHandler:^(void *key, NSUInteger changes) {
+		receivedChanges[(int *)key - keys] |= changes;
+		calls++;
+	}] autorelease];
+	NSUInteger			i, k;
+
+	coalescer.schedulesFlushes = NO;
+	memset(expected, 0, sizeof(expected));
+	memset(received, 0, sizeof(received));
+
+	for (i = 0; i < RANDOM_CHANGES; i++) {
+		k = nextRandom(&random) % RANDOM_KEYS;
+
+		switch (nextRandom(&random) % 10) {
+			case 0:
+				[coalescer removeKey:&keys[k]];
+				expected[k] = 0;
+				break;
+			case 1:
+				[coalescer flush];
+				for (k = 0; k < RANDOM_KEYS; k++) {
+					STAssertEquals(received[k], expected[k], @"Key %lu should be handed over what was added since the last flush", (unsigned long)k);
+					if (expected[k]) expectedCalls++;
+					expected[k] = received[k] = 0;
+				}
+				STAssertEquals(calls, expectedCalls, @"Each key with changes should be handed over once per flush");
+				break;
+			default: {
+				NSUInteger changes = (NSUInteger)1 << (nextRandom(&random) % 8);
+				[coalescer addChanges:changes forKey:&keys[k]];
+				expected[k] |= changes;
+				break;
+			}
+		}
+	}
+}
+
+@end
@@ -0,0 +1,307 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestChatRegistry.h"
+
+#import "AIChatRegistry.h"
+
+#define RANDOM_UID_COUNT		20
+#define RANDOM_ACCOUNT_COUNT	2
+#define RANDOM_CHANGE_COUNT		3000
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+/*!
+ * @brief Just enough of a list contact for the registry, which only asks for its IDs
+ */
+@interface TestRegistryContact : NSObject {
+	NSString	*internalObjectID;
+	NSString	*internalUniqueObjectID;
+}
++ (TestRegistryContact *)contactWithUID:(NSString *)UID account:(NSString *)account;
+@property (readonly, nonatomic) NSString *internalObjectID;
+@property (readonly, nonatomic) NSString *internalUniqueObjectID;
+@end
+
+@implementation TestRegistryContact
++ (TestRegistryContact *)contactWithUID:(NSString *)UID account:(NSString *)account {
+	TestRegistryContact *contact = [[[self alloc] init] autorelease];
+	contact->internalObjectID = [[@"Test." stringByAppendingString:UID] retain];
+	contact->internalUniqueObjectID = [[NSString alloc] initWithFormat:@"%@.Test.%@", account, UID];
+	return contact;
+}
+- (void)dealloc {
+	[internalObjectID release];
+	[internalUniqueObjectID release];
+	[super dealloc];
+}
+- (NSString *)description {
+	return internalUniqueObjectID;
+}
+@synthesize internalObjectID, internalUniqueObjectID;
+@end
+
+/*!
+ * @brief Just enough of a chat for the registry
+ */
+@interface TestRegistryChat : NSObject {
+	BOOL			isGroupChat;
+	id				listObject;
+	NSMutableArray	*containedObjects;
+	NSUInteger		unviewedContentCount;
+	NSUInteger		unviewedMentionCount;
+}
++ (TestRegistryChat *)chatWithListObject:(id)listObject;
++ (TestRegistryChat *)groupChat;
+@property (readonly, nonatomic) BOOL isGroupChat;
+@property (retain, nonatomic) id listObject;
+@property (readonly, nonatomic) NSMutableArray *containedObjects;
+@property (assign, nonatomic) NSUInteger unviewedContentCount;
+@property (assign, nonatomic) NSUInteger unviewedMentionCount;
+@end
+
+@implementation TestRegistryChat
++ (TestRegistryChat *)chatWithListObject:(id)listObject {
+	TestRegistryChat *chat = [[[self alloc] init] autorelease];
+	chat.listObject = listObject;
+	return chat;
+}
++ (TestRegistryChat *)groupChat {
+	TestRegistryChat *chat = [[[self alloc] init] autorelease];
+	chat->isGroupChat = YES;
+	chat->containedObjects = [[NSMutableArray alloc] init];
+	return chat;
+}
+- (void)dealloc {
+	[listObject release];
+	[containedObjects release];
+	[super dealloc];
+}
+@synthesize isGroupChat, listObject, containedObjects, unviewedContentCount, unviewedMentionCount;
+@end
+
+/*!
+ * @brief One-to-one chats with inContact's internalObjectID, found by scanning every chat
+ */
+static NSSet *linearOneToOneChats(AIChatRegistry *registry, TestRegistryContact *inContact)
+{
+	NSMutableSet *found = [NSMutableSet set];
+
+	for (TestRegistryChat *chat in registry.chats) {
+		if (!chat.isGroupChat && [[chat.listObject internalObjectID] isEqualToString:inContact.internalObjectID])
+			[found addObject:chat];
+	}
+
+	return found;
+}
+
+/*!
+ * @brief Group chats containing inContact, found by scanning every chat
+ */
+static NSSet *linearGroupChats(AIChatRegistry *registry, TestRegistryContact *inContact)
+{
+	NSMutableSet *found = [NSMutableSet set];
+
+	for (TestRegistryChat *chat in registry.chats) {
+		if (chat.isGroupChat && [chat.containedObjects containsObjectIdenticalTo:inContact])
+			[found addObject:chat];
+	}
+
+	return found;
+}
+
+@interface TestChatRegistry ()
+- (void)checkRegistry:(AIChatRegistry *)registry againstContacts:(NSArray *)contacts;
+@end
+
+@implementation TestChatRegistry
+
+- (void)testOneToOneLookups {
+	AIChatRegistry		*registry = [[[AIChatRegistry alloc] init] autorelease];
+	TestRegistryContact	*alice = [TestRegistryContact contactWithUID:@"alice" account:@"one"];
+	TestRegistryContact	*aliceElsewhere = [TestRegistryContact contactWithUID:@"alice" account:@"two"];
+	TestRegistryContact	*bob = [TestRegistryContact contactWithUID:@"bob" account:@"one"];
+	TestRegistryChat	*chat = [TestRegistryChat chatWithListObject:alice];
+
+	[registry addChat:(AIChat *)chat];
+	STAssertTrue([registry containsChat:(AIChat *)chat], @"An added chat should be registered");
+	STAssertEqualObjects([registry oneToOneChatsWithContact:(AIListContact *)alice], [NSSet setWithObject:chat], @"The chat should be found by its contact");
+	STAssertEqualObjects([registry oneToOneChatsWithContact:(AIListContact *)aliceElsewhere], [NSSet setWithObject:chat], @"The chat should be found by the same contact on another account");
+	STAssertEquals([[registry oneToOneChatsWithContact:(AIListContact *)bob] count], (NSUInteger)0, @"Other contacts should have no chats");
+
+	chat.listObject = bob;
+	[registry chat:(AIChat *)chat addedListContacts:[NSArray arrayWithObject:bob]];
+	STAssertEquals([[registry oneToOneChatsWithContact:(AIListContact *)alice] count], (NSUInteger)0, @"A chat switched to another contact should no longer be found by the old one");
+	STAssertEqualObjects([registry oneToOneChatsWithContact:(AIListContact *)bob], [NSSet setWithObject:chat], @"It should be found by the new one");
+
+	[registry removeChat:(AIChat *)chat];
+	STAssertFalse([registry containsChat:(AIChat *)chat], @"A removed chat should not be registered");
+	STAssertEquals([[registry oneToOneChatsWithContact:(AIListContact *)bob] count], (NSUInteger)0, @"A removed chat should not be found");
+}
+
+- (void)testGroupChatLookups {
+	AIChatRegistry		*registry = [[[AIChatRegistry alloc] init] autorelease];
+	TestRegistryContact	*alice = [TestRegistryContact contactWithUID:@"alice" account:@"one"];
+	TestRegistryContact	*aliceElsewhere = [TestRegistryContact contactWithUID:@"alice" account:@"two"];
+	TestRegistryContact	*bob = [TestRegistryContact contactWithUID:@"bob" account:@"one"];
+	TestRegistryChat	*chat = [TestRegistryChat groupChat];
+
+	[chat.containedObjects addObject:alice];
+	[registry addChat:(AIChat *)chat];
+	STAssertEqualObjects([registry groupChatsContainingContact:(AIListContact *)alice], [NSSet setWithObject:chat], @"A chat should be found by the participants it was added with");
+	STAssertEquals([[registry groupChatsContainingContact:(AIListContact *)aliceElsewhere] count], (NSUInteger)0, @"Group chats should only be found by the contact on their own account");
+
+	[chat.containedObjects addObject:bob];
+	[registry chat:(AIChat *)chat addedListContacts:[NSArray arrayWithObject:bob]];
+	STAssertEqualObjects([registry groupChatsContainingContact:(AIListContact *)bob], [NSSet setWithObject:chat], @"A chat should be found by a participant who joined");
+
+	[chat.containedObjects removeObject:alice];
+	[registry chat:(AIChat *)chat removedListContact:(AIListContact *)alice];
+	STAssertEquals([[registry groupChatsContainingContact:(AIListContact *)alice] count], (NSUInteger)0, @"A chat should not be found by a participant who left");
+
+	[chat.containedObjects removeAllObjects];
+	[registry chatRemovedAllListContacts:(AIChat *)chat];
+	STAssertEquals([[registry groupChatsContainingContact:(AIListContact *)bob] count], (NSUInteger)0, @"A chat which removed everyone should not be found");
+	STAssertTrue([registry containsChat:(AIChat *)chat], @"It should still be registered");
+}
+
+- (void)testUnviewedTotals {
+	AIChatRegistry		*registry = [[[AIChatRegistry alloc] init] autorelease];
+	TestRegistryChat	*oneToOne = [TestRegistryChat chatWithListObject:[TestRegistryContact contactWithUID:@"alice" account:@"one"]];
+	TestRegistryChat	*group = [TestRegistryChat groupChat];
+
+	oneToOne.unviewedContentCount = 2;
+	[registry addChat:(AIChat *)oneToOne];
+	[registry addChat:(AIChat *)group];
+	group.unviewedContentCount = 5;
+	[registry chatUnviewedContentChanged:(AIChat *)group];
+
+	STAssertEquals([registry unviewedContentCountCountingOnlyGroupChatMentions:NO], (NSUInteger)7, @"Every unviewed message should count");
+	STAssertEquals([registry unviewedContentCountCountingOnlyGroupChatMentions:YES], (NSUInteger)2, @"Group chats without mentions should not count when only mentions do");
+	STAssertEquals([registry unviewedConversationCountCountingOnlyGroupChatMentions:NO], (NSUInteger)2, @"Both chats have unviewed content");
+	STAssertEquals([registry unviewedConversationCountCountingOnlyGroupChatMentions:YES], (NSUInteger)1, @"Only the one-to-one chat counts when only mentions do");
+
+	group.unviewedMentionCount = 1;
+	[registry chatUnviewedContentChanged:(AIChat *)group];
+	STAssertEquals([registry unviewedContentCountCountingOnlyGroupChatMentions:YES], (NSUInteger)3, @"A mention should count");
+	STAssertEquals([registry unviewedConversationCountCountingOnlyGroupChatMentions:YES], (NSUInteger)2, @"A group chat with a mention should count");
+
+	[registry removeChat:(AIChat *)oneToOne];
+	STAssertEquals([registry unviewedContentCountCountingOnlyGroupChatMentions:NO], (NSUInteger)5, @"A removed chat's content should no longer count");
+	STAssertEqualObjects(registry.chatsWithUnviewedContent, [NSSet setWithObject:group], @"Only the group chat has unviewed content left");
+}
+
+/*!
+ * @brief Make random changes like the chat controller does, checking every lookup against a scan after each
+ */
+- (void)testRandomChangesMatchLinearScan {
+	AIChatRegistry	*registry = [[[AIChatRegistry alloc] init] autorelease];
+	NSMutableArray	*contacts = [NSMutableArray array];
+	uint32_t		seed = 1;
+
+	for (NSUInteger account = 0; account < RANDOM_ACCOUNT_COUNT; account++) {
+		for (NSUInteger uid = 0; uid < RANDOM_UID_COUNT; uid++) {
+			[contacts addObject:[TestRegistryContact contactWithUID:[NSString stringWithFormat:@"contact%lu", (unsigned long)uid]
+															account:[NSString stringWithFormat:@"account%lu", (unsigned long)account]]];
+		}
+	}
+
+	for (NSUInteger change = 0; change < RANDOM_CHANGE_COUNT; change++) {
+		NSArray				*chats = [registry.chats allObjects];
+		TestRegistryChat	*chat = ([chats count] ? [chats objectAtIndex:nextRandom(&seed) % [chats count]] : nil);
+		TestRegistryContact	*contact = [contacts objectAtIndex:nextRandom(&seed) % [contacts count]];
+
+		switch (chat ? nextRandom(&seed) % 7 : 0) {
+			case 0:
+				//Open a chat
+				if (nextRandom(&seed) % 2) {
+					[registry addChat:(AIChat *)[TestRegistryChat chatWithListObject:contact]];
+				} else {
+					TestRegistryChat *group = [TestRegistryChat groupChat];
+					[group.containedObjects addObject:contact];
+					[registry addChat:(AIChat *)group];
+				}
+				break;
+			case 1:
+				[registry removeChat:(AIChat *)chat];
+				break;
+			case 2:
+			case 3:
+				//A participant joins, or a one-to-one chat switches contact
+				if (chat.isGroupChat) {
+					if (![chat.containedObjects containsObjectIdenticalTo:contact]) [chat.containedObjects addObject:contact];
+				} else {
+					chat.listObject = contact;
+				}
+				[registry chat:(AIChat *)chat addedListContacts:[NSArray arrayWithObject:contact]];
+				break;
+			case 4:
+				if (chat.isGroupChat && [chat.containedObjects count]) {
+					TestRegistryContact *leaving = [chat.containedObjects objectAtIndex:nextRandom(&seed) % [chat.containedObjects count]];
+					[chat.containedObjects removeObjectIdenticalTo:leaving];
+					[registry chat:(AIChat *)chat removedListContact:(AIListContact *)leaving];
+				}
+				break;
+			case 5:
+				chat.unviewedContentCount = nextRandom(&seed) % 3;
+				if (chat.isGroupChat) chat.unviewedMentionCount = MIN(chat.unviewedContentCount, nextRandom(&seed) % 2);
+				[registry chatUnviewedContentChanged:(AIChat *)chat];
+				break;
+			case 6:
+				if (chat.isGroupChat && !(nextRandom(&seed) % 4)) {
+					[chat.containedObjects removeAllObjects];
+					[registry chatRemovedAllListContacts:(AIChat *)chat];
+				}
+				break;
+		}
+
+		[self checkRegistry:registry againstContacts:contacts];
+	}
+}
+
+- (void)checkRegistry:(AIChatRegistry *)registry againstContacts:(NSArray *)contacts {
+	NSUInteger	content = 0, mentions = 0, conversations = 0, conversationsWithMentions = 0;
+
+	for (TestRegistryContact *contact in contacts) {
+		STAssertEqualObjects([registry oneToOneChatsWithContact:(AIListContact *)contact], linearOneToOneChats(registry, contact),
+							 @"One-to-one chats with %@ should match a scan", contact);
+		STAssertEqualObjects([registry groupChatsContainingContact:(AIListContact *)contact], linearGroupChats(registry, contact),
+							 @"Group chats containing %@ should match a scan", contact);
+	}
+
+	for (TestRegistryChat *chat in registry.chats) {
+		content += chat.unviewedContentCount;
+		if (chat.unviewedContentCount) conversations++;
+		if (chat.isGroupChat) {
+			mentions += chat.unviewedMentionCount;
+			if (chat.unviewedMentionCount) conversationsWithMentions++;
+		} else {
+			mentions += chat.unviewedContentCount;
+			if (chat.unviewedContentCount) conversationsWithMentions++;
+		}
+	}
+
+	STAssertEquals([registry unviewedContentCountCountingOnlyGroupChatMentions:NO], content, @"Unviewed content should match a scan");
+	STAssertEquals([registry unviewedContentCountCountingOnlyGroupChatMentions:YES], mentions, @"Unviewed mentions should match a scan");
+	STAssertEquals([registry unviewedConversationCountCountingOnlyGroupChatMentions:NO], conversations, @"Unviewed conversations should match a scan");
+	STAssertEquals([registry unviewedConversationCountCountingOnlyGroupChatMentions:YES], conversationsWithMentions, @"Conversations with mentions should match a scan");
+}
+
+@end
@@ -0,0 +1,420 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestContactAlerts.h"
+
+#import "ESContactAlertsController.h"
+#import "AIDoNothingContactAlertPlugin.h"
+#import <Adium/AIContactAlertsControllerProtocol.h>
+#import <Adium/AIListObject.h>
+
+#define TEST_EVENT				@"TestEvent"
+#define TEST_OTHER_EVENT		@"TestOtherEvent"
+#define TEST_ACTION_ONCE		@"TestActionOnce"
+#define TEST_ACTION_REPEAT		@"TestActionRepeat"
+#define KEY_TEST_LEVEL			@"Level"
+
+#define RANDOM_GROUP_COUNT		5
+#define RANDOM_CONTACT_COUNT	30
+#define RANDOM_ROUND_COUNT		300
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static NSDictionary *alertWithAction(NSString *actionID, NSString *level)
+{
+	return [NSDictionary dictionaryWithObjectsAndKeys:
+			actionID, KEY_ACTION_ID,
+			[NSDictionary dictionaryWithObject:level forKey:KEY_TEST_LEVEL], KEY_ACTION_DETAILS,
+			nil];
+}
+
+/*!
+ * @brief Just enough of a list object for the contact alerts controller
+ */
+@interface TestAlertsObject : NSObject {
+	NSString		*internalObjectID;
+	NSMutableSet	*containingObjects;
+}
++ (TestAlertsObject *)objectWithID:(NSString *)internalObjectID;
+@property (readonly, nonatomic) NSString *internalObjectID;
+@property (readonly, nonatomic) NSMutableSet *containingObjects;
+@end
+
+@implementation TestAlertsObject
++ (TestAlertsObject *)objectWithID:(NSString *)inInternalObjectID {
+	TestAlertsObject *object = [[[self alloc] init] autorelease];
+	object->internalObjectID = [inInternalObjectID copy];
+	object->containingObjects = [[NSMutableSet alloc] init];
+	return object;
+}
+- (void)dealloc {
+	[internalObjectID release];
+	[containingObjects release];
+	[super dealloc];
+}
+- (NSString *)description {
+	return internalObjectID;
+}
+@synthesize internalObjectID, containingObjects;
+@end
+
+/*!
+ * @brief Contact alert preferences: for each object, or global for nil, a dictionary of alerts by event
+ */
+@interface TestAlertsPreferences : NSObject {
+	NSMutableDictionary	*alertsByObjectID;
+}
+- (void)setAlerts:(NSArray *)alerts forEventID:(NSString *)eventID object:(TestAlertsObject *)object;
+@end
+
+@implementation TestAlertsPreferences
+- (id)init {
+	if ((self = [super init])) {
+		alertsByObjectID = [[NSMutableDictionary alloc] init];
+	}
+	return self;
+}
+- (void)dealloc {
+	[alertsByObjectID release];
+	[super dealloc];
+}
+- (void)setAlerts:(NSArray *)alerts forEventID:(NSString *)eventID object:(TestAlertsObject *)object {
+	NSString			*objectID = (object ? object.internalObjectID : @"");
+	NSMutableDictionary	*alertsByEvent = [alertsByObjectID objectForKey:objectID];
+
+	if (!alertsByEvent) {
+		alertsByEvent = [NSMutableDictionary dictionary];
+		[alertsByObjectID setObject:alertsByEvent forKey:objectID];
+	}
+	[alertsByEvent setObject:alerts forKey:eventID];
+}
+- (id)preferenceForKey:(NSString *)key group:(NSString *)group objectIgnoringInheritance:(TestAlertsObject *)object {
+	if (![key isEqualToString:KEY_CONTACT_ALERTS] || ![group isEqualToString:PREF_GROUP_CONTACT_ALERTS]) return nil;
+	return [[[alertsByObjectID objectForKey:(object ? object.internalObjectID : @"")] copy] autorelease];
+}
+@end
+
+/*!
+ * @brief Stands in for the shared AIAdium, providing only the preference controller
+ */
+@interface TestAlertsAdium : NSObject {
+	TestAlertsPreferences *preferenceController;
+}
+@property (readwrite, retain, nonatomic) TestAlertsPreferences *preferenceController;
+@end
+
+@implementation TestAlertsAdium
+- (void)dealloc {
+	[preferenceController release];
+	[super dealloc];
+}
+@synthesize preferenceController;
+@end
+
+/*!
+ * @brief An action which notes each time it is performed, as its ID and the level of the alert
+ */
+@interface TestAlertsAction : NSObject <AIActionHandler> {
+	NSMutableArray *performed;
+}
+@property (readonly, nonatomic) NSMutableArray *performed;
+@end
+
+@implementation TestAlertsAction
+- (id)init {
+	if ((self = [super init])) {
+		performed = [[NSMutableArray alloc] init];
+	}
+	return self;
+}
+- (void)dealloc {
+	[performed release];
+	[super dealloc];
+}
+@synthesize performed;
+- (NSString *)shortDescriptionForActionID:(NSString *)actionID { return actionID; }
+- (NSString *)longDescriptionForActionID:(NSString *)actionID withDetails:(NSDictionary *)details { return actionID; }
+- (NSImage *)imageForActionID:(NSString *)actionID { return nil; }
+- (AIActionDetailsPane *)detailsPaneForActionID:(NSString *)actionID { return nil; }
+- (BOOL)performActionID:(NSString *)actionID forListObject:(AIListObject *)listObject withDetails:(NSDictionary *)details triggeringEventID:(NSString *)eventID userInfo:(id)userInfo {
+	[performed addObject:[NSString stringWithFormat:@"%@ %@", actionID, [details objectForKey:KEY_TEST_LEVEL]]];
+	return YES;
+}
+- (BOOL)allowMultipleActionsWithID:(NSString *)actionID {
+	return [actionID isEqualToString:TEST_ACTION_REPEAT];
+}
+@end
+
+@interface TestContactAlerts ()
+- (NSArray *)resolve:(NSString *)eventID for:(TestAlertsObject *)object;
+- (NSArray *)linearResolve:(NSString *)eventID for:(TestAlertsObject *)object;
+- (NSMutableArray *)appendLinearAlertsFor:(TestAlertsObject *)object eventID:(NSString *)eventID toArray:(NSMutableArray *)alerts;
+- (NSArray *)expectedActionsForAlerts:(NSArray *)alerts;
+@end
+
+@implementation TestContactAlerts
+
+- (void)setUp {
+	TestAlertsAdium *testAdium = [[[TestAlertsAdium alloc] init] autorelease];
+
+	preferences = [[TestAlertsPreferences alloc] init];
+	testAdium.preferenceController = preferences;
+	savedAdium = adium;
+	adium = (id<AIAdium>)[testAdium retain];
+
+	action = [[TestAlertsAction alloc] init];
+	controller = [[ESContactAlertsController alloc] init];
+	[controller registerActionID:TEST_ACTION_ONCE withHandler:action];
+	[controller registerActionID:TEST_ACTION_REPEAT withHandler:action];
+}
+
+- (void)tearDown {
+	[controller release]; controller = nil;
+	[action release]; action = nil;
+	[preferences release]; preferences = nil;
+
+	[(id)adium release];
+	adium = savedAdium;
+}
+
+- (NSArray *)resolve:(NSString *)eventID for:(TestAlertsObject *)object {
+	return [controller resolvedAlertsForEventID:eventID listObject:(AIListObject *)object];
+}
+
+/*!
+ * @brief Resolve alerts from preferences on every call, as the controller used to, listing each alert once
+ */
+- (NSArray *)linearResolve:(NSString *)eventID for:(TestAlertsObject *)object {
+	NSMutableArray *unique = [NSMutableArray array];
+
+	for (NSDictionary *alert in [self appendLinearAlertsFor:object eventID:eventID toArray:nil]) {
+		if (![unique containsObject:alert]) [unique addObject:alert];
+	}
+
+	return unique;
+}
+
+- (NSMutableArray *)appendLinearAlertsFor:(TestAlertsObject *)object eventID:(NSString *)eventID toArray:(NSMutableArray *)alerts {
+	NSArray *ownAlerts = [[preferences preferenceForKey:KEY_CONTACT_ALERTS group:PREF_GROUP_CONTACT_ALERTS objectIgnoringInheritance:object] objectForKey:eventID];
+
+	if ([ownAlerts count]) {
+		if (!alerts) alerts = [NSMutableArray array];
+		[alerts addObjectsFromArray:ownAlerts];
+
+		for (NSDictionary *alert in ownAlerts) {
+			if ([[alert objectForKey:KEY_ACTION_ID] isEqualToString:DO_NOTHING_ALERT_IDENTIFIER]) return alerts;
+		}
+	}
+
+	if (object) {
+		if (object.containingObjects.count > 0) {
+			for (TestAlertsObject *container in object.containingObjects) {
+				alerts = [self appendLinearAlertsFor:container eventID:eventID toArray:alerts];
+			}
+		} else {
+			alerts = [self appendLinearAlertsFor:nil eventID:eventID toArray:alerts];
+		}
+	}
+
+	return alerts;
+}
+
+/*!
+ * @brief The actions generating an event with these alerts should perform: each once, unless it allows repeats
+ */
+- (NSArray *)expectedActionsForAlerts:(NSArray *)alerts {
+	NSMutableArray	*expected = [NSMutableArray array];
+	NSMutableSet	*performedIDs = [NSMutableSet set];
+
+	for (NSDictionary *alert in alerts) {
+		NSString *actionID = [alert objectForKey:KEY_ACTION_ID];
+
+		if ([actionID isEqualToString:DO_NOTHING_ALERT_IDENTIFIER]) continue;
+		if ([performedIDs containsObject:actionID] && ![action allowMultipleActionsWithID:actionID]) continue;
+
+		[expected addObject:[NSString stringWithFormat:@"%@ %@", actionID, [[alert objectForKey:KEY_ACTION_DETAILS] objectForKey:KEY_TEST_LEVEL]]];
+		[performedIDs addObject:actionID];
+	}
+
+	return expected;
+}
+
+- (void)testOwnAlertsBeforeInherited {
+	TestAlertsObject	*group = [TestAlertsObject objectWithID:@"group"];
+	TestAlertsObject	*contact = [TestAlertsObject objectWithID:@"contact"];
+	NSDictionary		*own = alertWithAction(TEST_ACTION_REPEAT, @"contact");
+	NSDictionary		*fromGroup = alertWithAction(TEST_ACTION_REPEAT, @"group");
+	NSDictionary		*global = alertWithAction(TEST_ACTION_REPEAT, @"global");
+
+	[contact.containingObjects addObject:group];
+	[preferences setAlerts:[NSArray arrayWithObject:own] forEventID:TEST_EVENT object:contact];
+	[preferences setAlerts:[NSArray arrayWithObject:fromGroup] forEventID:TEST_EVENT object:group];
+	[preferences setAlerts:[NSArray arrayWithObject:global] forEventID:TEST_EVENT object:nil];
+
+	STAssertEqualObjects([self resolve:TEST_EVENT for:contact], ([NSArray arrayWithObjects:own, fromGroup, global, nil]), @"Own alerts should come before the group's, then global ones");
+	STAssertEqualObjects([self resolve:TEST_EVENT for:group], ([NSArray arrayWithObjects:fromGroup, global, nil]), @"A group should inherit global alerts");
+	STAssertEqualObjects([self resolve:TEST_EVENT for:nil], [NSArray arrayWithObject:global], @"Global alerts should resolve alone");
+	STAssertEquals([[self resolve:TEST_OTHER_EVENT for:contact] count], (NSUInteger)0, @"Other events have no alerts");
+}
+
+- (void)testDoNothingStopsInheritance {
+	TestAlertsObject	*group = [TestAlertsObject objectWithID:@"group"];
+	TestAlertsObject	*contact = [TestAlertsObject objectWithID:@"contact"];
+	NSDictionary		*doNothing = alertWithAction(DO_NOTHING_ALERT_IDENTIFIER, @"group");
+
+	[contact.containingObjects addObject:group];
+	[preferences setAlerts:[NSArray arrayWithObject:doNothing] forEventID:TEST_EVENT object:group];
+	[preferences setAlerts:[NSArray arrayWithObject:alertWithAction(TEST_ACTION_ONCE, @"global")] forEventID:TEST_EVENT object:nil];
+
+	STAssertEqualObjects([self resolve:TEST_EVENT for:contact], [NSArray arrayWithObject:doNothing], @"A Do Nothing alert should stop global alerts being inherited");
+
+	[controller generateEvent:TEST_EVENT forListObject:(AIListObject *)contact userInfo:nil previouslyPerformedActionIDs:nil];
+	STAssertEquals([action.performed count], (NSUInteger)0, @"Nothing should be performed");
+}
+
+- (void)testAlertInheritedTwiceListedOnce {
+	TestAlertsObject	*first = [TestAlertsObject objectWithID:@"first"];
+	TestAlertsObject	*second = [TestAlertsObject objectWithID:@"second"];
+	TestAlertsObject	*contact = [TestAlertsObject objectWithID:@"contact"];
+	NSDictionary		*global = alertWithAction(TEST_ACTION_REPEAT, @"global");
+
+	[contact.containingObjects addObject:first];
+	[contact.containingObjects addObject:second];
+	[preferences setAlerts:[NSArray arrayWithObject:global] forEventID:TEST_EVENT object:nil];
+
+	STAssertEqualObjects([self resolve:TEST_EVENT for:contact], [NSArray arrayWithObject:global], @"A global alert inherited through two groups should be listed once");
+
+	[controller generateEvent:TEST_EVENT forListObject:(AIListObject *)contact userInfo:nil previouslyPerformedActionIDs:nil];
+	STAssertEqualObjects(action.performed, [NSArray arrayWithObject:@"TestActionRepeat global"], @"Even a repeating action should be performed once for it");
+}
+
+- (void)testActionsPerformedOnce {
+	TestAlertsObject	*group = [TestAlertsObject objectWithID:@"group"];
+	TestAlertsObject	*contact = [TestAlertsObject objectWithID:@"contact"];
+
+	[contact.containingObjects addObject:group];
+	[preferences setAlerts:[NSArray arrayWithObjects:alertWithAction(TEST_ACTION_ONCE, @"contact"), alertWithAction(TEST_ACTION_REPEAT, @"contact"), nil]
+				forEventID:TEST_EVENT object:contact];
+	[preferences setAlerts:[NSArray arrayWithObjects:alertWithAction(TEST_ACTION_ONCE, @"group"), alertWithAction(TEST_ACTION_REPEAT, @"group"), nil]
+				forEventID:TEST_EVENT object:group];
+
+	NSSet *performedIDs = [controller generateEvent:TEST_EVENT forListObject:(AIListObject *)contact userInfo:nil previouslyPerformedActionIDs:nil];
+	STAssertEqualObjects(action.performed, ([NSArray arrayWithObjects:@"TestActionOnce contact", @"TestActionRepeat contact", @"TestActionRepeat group", nil]),
+						 @"An action should be performed once, by the nearest alert, unless it allows repeats");
+	STAssertEqualObjects(performedIDs, ([NSSet setWithObjects:TEST_ACTION_ONCE, TEST_ACTION_REPEAT, nil]), @"Both actions were performed");
+
+	[action.performed removeAllObjects];
+	[controller generateEvent:TEST_EVENT forListObject:(AIListObject *)group userInfo:nil previouslyPerformedActionIDs:performedIDs];
+	STAssertEqualObjects(action.performed, [NSArray arrayWithObject:@"TestActionRepeat group"], @"Actions performed before shouldn't be performed again");
+}
+
+- (void)testChangesFlushCompiledAlerts {
+	TestAlertsObject	*group = [TestAlertsObject objectWithID:@"group"];
+	TestAlertsObject	*contact = [TestAlertsObject objectWithID:@"contact"];
+	NSDictionary		*fromGroup = alertWithAction(TEST_ACTION_ONCE, @"group");
+	NSDictionary		*global = alertWithAction(TEST_ACTION_ONCE, @"global");
+
+	[preferences setAlerts:[NSArray arrayWithObject:fromGroup] forEventID:TEST_EVENT object:group];
+	[preferences setAlerts:[NSArray arrayWithObject:global] forEventID:TEST_EVENT object:nil];
+	STAssertEqualObjects([self resolve:TEST_EVENT for:contact], [NSArray arrayWithObject:global], @"A contact in no group inherits global alerts");
+
+	[contact.containingObjects addObject:group];
+	[AIListObject incrementGroupingVersion];
+	STAssertEqualObjects([self resolve:TEST_EVENT for:contact], ([NSArray arrayWithObjects:fromGroup, global, nil]), @"Joining a group should be noticed");
+
+	[preferences setAlerts:[NSArray array] forEventID:TEST_EVENT object:group];
+	[controller preferencesChangedForGroup:PREF_GROUP_CONTACT_ALERTS key:KEY_CONTACT_ALERTS object:(AIListObject *)group preferenceDict:nil firstTime:NO];
+	STAssertEqualObjects([self resolve:TEST_EVENT for:contact], [NSArray arrayWithObject:global], @"A change to the group's alerts should be noticed");
+}
+
+/*!
+ * @brief Replay random changes to alerts and grouping, generating events for every contact after each
+ *
+ * Each contact's compiled alerts should be its linearly resolved ones, and the actions performed those expected of them.
+ */
+- (void)testRandomReplayMatchesLinearResolution {
+	NSMutableArray	*groups = [NSMutableArray array];
+	NSMutableArray	*contacts = [NSMutableArray array];
+	NSArray			*events = [NSArray arrayWithObjects:TEST_EVENT, TEST_OTHER_EVENT, nil];
+	NSArray			*actionIDs = [NSArray arrayWithObjects:TEST_ACTION_ONCE, TEST_ACTION_REPEAT, TEST_ACTION_REPEAT, DO_NOTHING_ALERT_IDENTIFIER, nil];
+	uint32_t		seed = 1;
+
+	for (NSUInteger i = 0; i < RANDOM_GROUP_COUNT; i++) {
+		[groups addObject:[TestAlertsObject objectWithID:[NSString stringWithFormat:@"group%lu", (unsigned long)i]]];
+	}
+	for (NSUInteger i = 0; i < RANDOM_CONTACT_COUNT; i++) {
+		TestAlertsObject *contact = [TestAlertsObject objectWithID:[NSString stringWithFormat:@"contact%lu", (unsigned long)i]];
+		[contact.containingObjects addObject:[groups objectAtIndex:i % RANDOM_GROUP_COUNT]];
+		[contacts addObject:contact];
+	}
+
+	for (NSUInteger round = 0; round < RANDOM_ROUND_COUNT; round++) {
+		TestAlertsObject *contact = [contacts objectAtIndex:nextRandom(&seed) % RANDOM_CONTACT_COUNT];
+
+		switch (nextRandom(&seed) % 3) {
+			case 0: {
+				//Set alerts on a contact, a group or global
+				NSUInteger			pick = nextRandom(&seed) % (RANDOM_CONTACT_COUNT + RANDOM_GROUP_COUNT + 1);
+				TestAlertsObject	*object = (pick < RANDOM_CONTACT_COUNT ? [contacts objectAtIndex:pick] :
+											   (pick < RANDOM_CONTACT_COUNT + RANDOM_GROUP_COUNT ? [groups objectAtIndex:pick - RANDOM_CONTACT_COUNT] : nil));
+				NSMutableArray		*alerts = [NSMutableArray array];
+				NSUInteger			alertCount = nextRandom(&seed) % 3;
+
+				for (NSUInteger i = 0; i < alertCount; i++) {
+					[alerts addObject:alertWithAction([actionIDs objectAtIndex:nextRandom(&seed) % [actionIDs count]],
+													  (object ? object.internalObjectID : @"global"))];
+				}
+				[preferences setAlerts:alerts forEventID:[events objectAtIndex:nextRandom(&seed) % 2] object:object];
+				[controller preferencesChangedForGroup:PREF_GROUP_CONTACT_ALERTS key:KEY_CONTACT_ALERTS object:(AIListObject *)object preferenceDict:nil firstTime:NO];
+				break;
+			}
+			case 1:
+				//Join another group, or leave one
+				if (contact.containingObjects.count > 1 && (nextRandom(&seed) % 2)) {
+					[contact.containingObjects removeObject:[contact.containingObjects anyObject]];
+				} else {
+					[contact.containingObjects addObject:[groups objectAtIndex:nextRandom(&seed) % RANDOM_GROUP_COUNT]];
+				}
+				[AIListObject incrementGroupingVersion];
+				break;
+			case 2:
+				//Leave every group
+				[contact.containingObjects removeAllObjects];
+				[AIListObject incrementGroupingVersion];
+				break;
+		}
+
+		for (TestAlertsObject *eventContact in contacts) {
+			for (NSString *eventID in events) {
+				NSArray *expectedAlerts = [self linearResolve:eventID for:eventContact];
+
+				STAssertEqualObjects([self resolve:eventID for:eventContact], expectedAlerts,
+									 @"Round %lu: compiled alerts for %@ on %@ should match linear resolution", (unsigned long)round, eventID, eventContact);
+
+				[action.performed removeAllObjects];
+				[controller generateEvent:eventID forListObject:(AIListObject *)eventContact userInfo:nil previouslyPerformedActionIDs:nil];
+				STAssertEqualObjects(action.performed, [self expectedActionsForAlerts:expectedAlerts],
+									 @"Round %lu: actions performed for %@ on %@", (unsigned long)round, eventID, eventContact);
+			}
+		}
+	}
+}
+
+@end
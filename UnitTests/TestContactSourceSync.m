@@ -0,0 +1,192 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestContactSourceSync.h"
+
+#import <AIUtilities/AIContactCard.h>
+#import <AIUtilities/AIContactSourceSync.h>
+#import <AIUtilities/AIVCardDirectoryContactSource.h>
+
+static NSString *vCardString(NSString *name, NSString *properties)
+{
+	return [NSString stringWithFormat:@"BEGIN:VCARD\r\nVERSION:3.0\r\nN:%@;;;;\r\nFN:%@\r\n%@END:VCARD\r\n", name, name, properties];
+}
+
+@implementation TestContactSourceSync
+
+- (void)setUp {
+	directoryPath = [[NSTemporaryDirectory() stringByAppendingPathComponent:
+					  [NSString stringWithFormat:@"TestContactSourceSync-%@", [[NSProcessInfo processInfo] globallyUniqueString]]] retain];
+	[[NSFileManager defaultManager] createDirectoryAtPath:directoryPath withIntermediateDirectories:YES attributes:nil error:NULL];
+}
+
+- (void)tearDown {
+	[[NSFileManager defaultManager] removeItemAtPath:directoryPath error:NULL];
+	[directoryPath release]; directoryPath = nil;
+}
+
+- (NSString *)statePath {
+	return [directoryPath stringByAppendingPathComponent:@"State.plist"];
+}
+
+- (AIVCardDirectoryContactSource *)source {
+	NSString *cardsPath = [directoryPath stringByAppendingPathComponent:@"Cards"];
+	[[NSFileManager defaultManager] createDirectoryAtPath:cardsPath withIntermediateDirectories:YES attributes:nil error:NULL];
+
+	return [[[AIVCardDirectoryContactSource alloc] initWithDirectoryPath:cardsPath] autorelease];
+}
+
+/*!
+ * @brief Write a card, dated as given
+ */
+- (void)writeCard:(NSString *)uniqueID name:(NSString *)name properties:(NSString *)properties date:(NSDate *)date {
+	AIVCardDirectoryContactSource	*source = [self source];
+	NSString						*path = [source pathForCardWithUniqueID:uniqueID];
+
+	[vCardString(name, properties) writeToFile:path atomically:YES encoding:NSUTF8StringEncoding error:NULL];
+	[[NSFileManager defaultManager] setAttributes:[NSDictionary dictionaryWithObject:date forKey:NSFileModificationDate]
+									 ofItemAtPath:path
+											error:NULL];
+}
+
+/*!
+ * @brief Three cards, written an hour ago so that they predate any synchronization
+ */
+- (void)writeInitialCards {
+	NSDate *anHourAgo = [NSDate dateWithTimeIntervalSinceNow:-3600];
+
+	[self writeCard:@"alice" name:@"Smith;Alice" properties:@"X-AIM:Alice Smith\r\nEMAIL;TYPE=INTERNET:alice@mac.com\r\n" date:anHourAgo];
+	[self writeCard:@"bob" name:@"Jones;Bob" properties:@"IMPP:xmpp:bob@gmail.com\r\n" date:anHourAgo];
+	[self writeCard:@"carol" name:@"Doe;Carol" properties:@"X-ICQ:12345678\r\n" date:anHourAgo];
+}
+
+- (void)testVCardParsing {
+	NSString		*vCard = @"BEGIN:VCARD\r\nVERSION:3.0\r\nN:Smith;Alice;Q.;;\r\nNICKNAME:Al\\, the Great\r\n"
+							 @"ORG:Adium\\; Inc.;Engineering\r\nitem1.EMAIL;TYPE=INTERNET:alice@exa\r\n mple.com\r\n"
+							 @"URL:fb://profile/1234\r\nX-AIM;TYPE=HOME:AliceSmith\r\nIMPP:ymsgr:alice_s\r\nEND:VCARD\r\n";
+	AIContactCard	*card = [AIVCardDirectoryContactSource cardWithUniqueID:@"alice" vCardString:vCard];
+
+	STAssertEqualObjects(card.uniqueID, @"alice", @"The unique ID should be the one given");
+	STAssertEqualObjects([card.nameComponents objectForKey:AIContactCardFirstNameKey], @"Alice", @"First name");
+	STAssertEqualObjects([card.nameComponents objectForKey:AIContactCardLastNameKey], @"Smith", @"Last name");
+	STAssertEqualObjects([card.nameComponents objectForKey:AIContactCardMiddleNameKey], @"Q.", @"Middle name");
+	STAssertEqualObjects([card.nameComponents objectForKey:AIContactCardNicknameKey], @"Al, the Great", @"Escaped commas should be unescaped");
+	STAssertEqualObjects([card.nameComponents objectForKey:AIContactCardOrganizationKey], @"Adium; Inc.", @"The organization is the first component");
+	STAssertEqualObjects(card.emails, [NSArray arrayWithObject:@"alice@example.com"], @"Folded lines and groups should be handled");
+	STAssertEqualObjects(card.homepages, [NSArray arrayWithObject:@"fb://profile/1234"], @"URLs are homepages");
+	STAssertEqualObjects([card.instantMessageNames objectForKey:@"AIM"], [NSArray arrayWithObject:@"AliceSmith"], @"X-AIM names");
+	STAssertEqualObjects([card.instantMessageNames objectForKey:@"Yahoo!"], [NSArray arrayWithObject:@"alice_s"], @"IMPP names");
+}
+
+- (void)testMatchesFollowServiceRules {
+	NSDictionary	*names = [NSDictionary dictionaryWithObjectsAndKeys:
+							  [NSArray arrayWithObjects:@"Some Name", @"123456", @"someone@me.com", nil], @"AIM",
+							  [NSArray arrayWithObjects:@"friend@livejournal.com", @"friend@jabber.org", nil], @"Jabber",
+							  nil];
+	AIContactCard	*card = [[[AIContactCard alloc] initWithUniqueID:@"card"
+												 nameComponents:nil
+														 emails:[NSArray arrayWithObjects:@"a@mac.com", @"b@me.com", @"c@googlemail.com", @"d@hotmail.com", @"e@example.com", nil]
+													  homepages:[NSArray arrayWithObject:@"fb://profile/42"]
+											instantMessageNames:names] autorelease];
+	NSMutableArray	*found = [NSMutableArray array];
+
+	for (AIContactCardMatch *match in card.matches) {
+		[found addObject:[NSString stringWithFormat:@"%@ %@/%@", match.UID, match.indexServiceID, match.serviceID]];
+	}
+
+	STAssertEqualObjects(found, ([NSArray arrayWithObjects:
+								  @"a@mac.com AIM/Mac", @"b@me.com AIM/MobileMe", @"c@googlemail.com Jabber/GTalk", @"d@hotmail.com MSN/MSN",
+								  @"-42@chat.facebook.com Facebook/Facebook",
+								  @"somename AIM/AIM", @"123456 AIM/ICQ", @"someone@me.com AIM/MobileMe",
+								  @"friend@livejournal.com Jabber/LiveJournal", @"friend@jabber.org Jabber/Jabber",
+								  nil]), @"Each name should be indexed and told apart as before");
+}
+
+- (void)testReverseIndex {
+	[self writeInitialCards];
+
+	AIContactSourceSync *sync = [[[AIContactSourceSync alloc] initWithContactSource:[self source] statePath:nil] autorelease];
+	[sync synchronize];
+
+	STAssertEqualObjects([sync cardUniqueIDForUID:@"Alice Smith" indexServiceID:@"AIM"], @"alice", @"Lookups should ignore spaces and case");
+	STAssertEqualObjects([sync cardUniqueIDForUID:@"alice@mac.com" indexServiceID:@"AIM"], @"alice", @".Mac addresses are AIM names");
+	STAssertEqualObjects([sync cardUniqueIDForUID:@"bob@gmail.com" indexServiceID:@"Jabber"], @"bob", @"IMPP names");
+	STAssertEqualObjects([sync cardUniqueIDForUID:@"12345678" indexServiceID:@"ICQ"], @"carol", @"ICQ names");
+	STAssertNil([sync cardUniqueIDForUID:@"12345678" indexServiceID:@"AIM"], @"Names are indexed per service");
+	STAssertEqualObjects([sync uniqueIDsOfCardsWithMultipleMatches], [NSArray arrayWithObject:@"alice"], @"Only Alice has two names");
+}
+
+- (void)testUnchangedCardsAreNotRead {
+	[self writeInitialCards];
+
+	AIContactSourceSync *sync = [[[AIContactSourceSync alloc] initWithContactSource:[self source] statePath:[self statePath]] autorelease];
+	STAssertEquals([[sync synchronize] count], (NSUInteger)3, @"Every card is new the first time");
+	STAssertEquals(sync.cardsRead, (NSUInteger)3, @"Every card is read the first time");
+
+	AIContactSourceSync *secondSync = [[[AIContactSourceSync alloc] initWithContactSource:[self source] statePath:[self statePath]] autorelease];
+	STAssertEquals([[secondSync synchronize] count], (NSUInteger)0, @"Nothing changed");
+	STAssertEquals(secondSync.cardsRead, (NSUInteger)0, @"No card should be read when nothing changed");
+}
+
+- (void)testOnlyModifiedCardsAreRead {
+	[self writeInitialCards];
+
+	AIContactSourceSync *sync = [[[AIContactSourceSync alloc] initWithContactSource:[self source] statePath:[self statePath]] autorelease];
+	[sync synchronize];
+
+	[self writeCard:@"bob" name:@"Jones;Bob" properties:@"IMPP:xmpp:bob@jabber.org\r\n" date:[NSDate date]];
+
+	AIContactSourceSync *secondSync = [[[AIContactSourceSync alloc] initWithContactSource:[self source] statePath:[self statePath]] autorelease];
+	STAssertEqualObjects([secondSync synchronize], [NSSet setWithObject:@"bob"], @"Only Bob changed");
+	STAssertEquals(secondSync.cardsRead, (NSUInteger)1, @"Only Bob's card should be read");
+	STAssertNil([secondSync cardUniqueIDForUID:@"bob@gmail.com" indexServiceID:@"Jabber"], @"Bob's old name should be gone");
+	STAssertEqualObjects([secondSync cardUniqueIDForUID:@"bob@jabber.org" indexServiceID:@"Jabber"], @"bob", @"Bob's new name should be indexed");
+
+	//Touching a card without changing it reads it, but changes nothing
+	[self writeCard:@"carol" name:@"Doe;Carol" properties:@"X-ICQ:12345678\r\n" date:[NSDate date]];
+	STAssertEquals([[secondSync updateCardsWithUniqueIDs:[NSArray arrayWithObject:@"carol"]] count], (NSUInteger)0, @"Carol's card is the same");
+}
+
+- (void)testRemovedCardsAreUnindexed {
+	[self writeInitialCards];
+
+	AIContactSourceSync *sync = [[[AIContactSourceSync alloc] initWithContactSource:[self source] statePath:[self statePath]] autorelease];
+	[sync synchronize];
+
+	[[NSFileManager defaultManager] removeItemAtPath:[[self source] pathForCardWithUniqueID:@"carol"] error:NULL];
+
+	AIContactSourceSync *secondSync = [[[AIContactSourceSync alloc] initWithContactSource:[self source] statePath:[self statePath]] autorelease];
+	STAssertEqualObjects([secondSync synchronize], [NSSet setWithObject:@"carol"], @"Carol was removed");
+	STAssertEquals(secondSync.cardsRead, (NSUInteger)0, @"Removals need no reading");
+	STAssertNil([secondSync cardUniqueIDForUID:@"12345678" indexServiceID:@"ICQ"], @"Carol's name should be gone");
+	STAssertNil([secondSync matchesForCardWithUniqueID:@"carol"], @"Carol should be forgotten");
+}
+
+- (void)testStatePersists {
+	[self writeInitialCards];
+
+	AIContactSourceSync *sync = [[[AIContactSourceSync alloc] initWithContactSource:[self source] statePath:[self statePath]] autorelease];
+	[sync synchronize];
+
+	AIContactSourceSync *secondSync = [[[AIContactSourceSync alloc] initWithContactSource:[self source] statePath:[self statePath]] autorelease];
+	[secondSync synchronize];
+
+	STAssertEqualObjects(secondSync.allCardUniqueIDs, ([NSSet setWithObjects:@"alice", @"bob", @"carol", nil]), @"Every card should be remembered");
+	STAssertEqualObjects([secondSync matchesForCardWithUniqueID:@"alice"], [sync matchesForCardWithUniqueID:@"alice"], @"Matches should be remembered");
+	STAssertEqualObjects([secondSync cardUniqueIDForUID:@"alicesmith" indexServiceID:@"AIM"], @"alice", @"The index should be rebuilt from the saved matches");
+}
+
+@end
@@ -0,0 +1,176 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestElapsedTimeManager.h"
+
+#import <Adium/AIElapsedTimeManager.h>
+#import <Adium/AIListObject.h>
+#import <AIUtilities/AIDateFormatterAdditions.h>
+
+//As in AIElapsedTimeManager
+#define MAX_IDLE_MINUTES		599400
+#define RANDOM_OBJECT_COUNT		1000
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+/*!
+ * @brief A list object idle since minutes and seconds ago, or not idle if idleSince is nil
+ */
+static AIListObject *objectIdleFor(NSInteger minutes, NSInteger seconds)
+{
+	AIListObject *listObject = [[[AIListObject alloc] initWithUID:@"Test" service:nil] autorelease];
+
+	//Nothing it would observe is set up in the tests
+	[NSObject cancelPreviousPerformRequestsWithTarget:listObject];
+
+	[listObject setValue:[NSDate dateWithTimeIntervalSinceNow:-(minutes * 60 + seconds)] forProperty:@"idleSince" notify:NotifyNever];
+
+	return listObject;
+}
+
+/*!
+ * @brief Minutes idle since a date, as AIContactIdlePlugin worked them out
+ */
+static NSInteger minutesIdleSince(NSDate *idleSince)
+{
+	NSInteger idle = (CGFloat)(-[idleSince timeIntervalSinceNow]) / 60.0f;
+
+	return (idle == 0 ? -1 : idle);
+}
+
+/*!
+ * @brief The idle string for some minutes, as AIExtendedStatusPlugin formatted it
+ */
+static NSString *idleStringForMinutes(NSInteger minutes)
+{
+	return ((minutes > MAX_IDLE_MINUTES) ?
+			AILocalizedStringFromTableInBundle(@"Idle", nil, [NSBundle bundleForClass:[AIElapsedTimeManager class]], nil) :
+			[NSDateFormatter stringForApproximateTimeInterval:(minutes * 60) abbreviated:YES]);
+}
+
+@interface TestElapsedTimeManager ()
+- (void)minuteDidChange:(NSNotification *)notification;
+@end
+
+@implementation TestElapsedTimeManager
+
+- (void)testIdleTimeWorkedOutFromIdleSince {
+	STAssertEquals(objectIdleFor(5, 30).idleTime, (NSInteger)5, @"Idle time should be whole minutes since idleSince");
+	STAssertEquals(objectIdleFor(0, 20).idleTime, (NSInteger)-1, @"Idle for less than a minute should be -1");
+
+	AIListObject *listObject = objectIdleFor(0, 0);
+	[listObject setValue:nil forProperty:@"idleSince" notify:NotifyNever];
+	STAssertEquals(listObject.idleTime, (NSInteger)0, @"An object which isn't idle should have no idle time");
+
+	[listObject setValue:[NSNumber numberWithInteger:-1] forProperty:@"idle" notify:NotifyNever];
+	STAssertEquals(listObject.idleTime, (NSInteger)-1, @"Idle for an unknown time should come from idle");
+	STAssertNil([[AIElapsedTimeManager sharedManager] idleStringForObject:listObject], @"Idle for an unknown time should have no idle string");
+}
+
+- (void)testIdleStringsShared {
+	AIElapsedTimeManager	*manager = [[[AIElapsedTimeManager alloc] init] autorelease];
+	NSString				*idleString = [manager idleStringForObject:objectIdleFor(5, 10)];
+
+	STAssertEqualObjects(idleString, idleStringForMinutes(5), @"The idle string should be formatted as before");
+	STAssertTrue([manager idleStringForObject:objectIdleFor(5, 40)] == idleString, @"Objects idle for the same minutes should share a string");
+	STAssertEqualObjects([manager idleStringForObject:objectIdleFor(6, 10)], idleStringForMinutes(6), @"Another minute should have its own string");
+	STAssertNil([manager idleStringForObject:objectIdleFor(0, 20)], @"Less than a minute idle should have no idle string");
+}
+
+- (void)testVeryLongIdleShownAsIdle {
+	AIElapsedTimeManager	*manager = [[[AIElapsedTimeManager alloc] init] autorelease];
+
+	STAssertEqualObjects([manager idleStringForObject:objectIdleFor(MAX_IDLE_MINUTES + 60, 10)], idleStringForMinutes(MAX_IDLE_MINUTES + 60),
+						 @"Idle for over 999 hours should be shown simply as idle");
+	STAssertEqualObjects([manager idleStringForObject:objectIdleFor(MAX_IDLE_MINUTES, 10)], idleStringForMinutes(MAX_IDLE_MINUTES),
+						 @"Idle for 999 hours should still be shown as a time");
+}
+
+- (void)testDisplayDependsOnTimeOnlyWhenIdleSince {
+	AIElapsedTimeManager	*manager = [[[AIElapsedTimeManager alloc] init] autorelease];
+	AIListObject			*listObject = objectIdleFor(3, 0);
+
+	STAssertTrue([manager displayOfObjectDependsOnTime:listObject], @"An object idle since a date should be redrawn on the minute");
+
+	[listObject setValue:nil forProperty:@"idleSince" notify:NotifyNever];
+	[listObject setValue:[NSNumber numberWithInteger:-1] forProperty:@"idle" notify:NotifyNever];
+	STAssertFalse([manager displayOfObjectDependsOnTime:listObject], @"An object idle for an unknown time shouldn't need redrawing");
+}
+
+- (void)testMinuteTimerOnlyWhileObserved {
+	AIElapsedTimeManager	*manager = [[[AIElapsedTimeManager alloc] init] autorelease];
+	NSMutableArray			*notifications = [NSMutableArray array];
+	NSTimer					*minuteTimer;
+
+	STAssertNil([manager valueForKey:@"minuteTimer"], @"No timer should run without observers");
+
+	[manager addMinuteObserver:self selector:@selector(minuteDidChange:)];
+	[manager addMinuteObserver:notifications selector:@selector(addObject:)];
+	minuteTimer = [[[manager valueForKey:@"minuteTimer"] retain] autorelease];
+
+	STAssertTrue([minuteTimer isValid], @"The timer should run while observed");
+	STAssertEqualsWithAccuracy(fmod([[minuteTimer fireDate] timeIntervalSinceReferenceDate], 60.0), 0.0, 1e-3,
+							   @"The timer should fire on the minute");
+	STAssertTrue([[minuteTimer fireDate] timeIntervalSinceNow] <= 60.0, @"The timer should fire within a minute");
+
+	[manager minuteDidChange];
+	STAssertEquals(minuteCount, (NSUInteger)1, @"Observers should be told of a new minute");
+	STAssertEquals(notifications.count, (NSUInteger)1, @"Every observer should be told of a new minute");
+
+	[manager removeMinuteObserver:self];
+	STAssertTrue([[manager valueForKey:@"minuteTimer"] isValid], @"The timer should run until the last observer is removed");
+
+	[manager minuteDidChange];
+	STAssertEquals(minuteCount, (NSUInteger)1, @"Removed observers should not be told");
+	STAssertEquals(notifications.count, (NSUInteger)2, @"Remaining observers should still be told");
+
+	[manager removeMinuteObserver:notifications];
+	STAssertNil([manager valueForKey:@"minuteTimer"], @"The timer should stop with no observers");
+	STAssertFalse([minuteTimer isValid], @"The stopped timer should be invalidated");
+}
+
+- (void)testRandomIdleTimesMatchOldCalculation {
+	uint32_t				random = 50;
+	AIElapsedTimeManager	*manager = [[[AIElapsedTimeManager alloc] init] autorelease];
+	NSUInteger				i;
+
+	for (i = 0; i < RANDOM_OBJECT_COUNT; i++) {
+		NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+		uint32_t			kind = nextRandom(&random) % 10;
+		NSInteger			minutes = (kind < 1 ? 0 : (kind < 8 ? nextRandom(&random) % 600 : nextRandom(&random) % (2 * MAX_IDLE_MINUTES)));
+		//Keep clear of the minute boundary, so the test doesn't depend on how long it takes
+		AIListObject		*listObject = objectIdleFor(minutes, 5 + nextRandom(&random) % 50);
+		NSInteger			expected = minutesIdleSince([listObject valueForProperty:@"idleSince"]);
+		NSString			*expectedString = (expected > 0 ? idleStringForMinutes(expected) : nil);
+		NSString			*idleString = [manager idleStringForObject:listObject];
+
+		STAssertEquals(listObject.idleTime, expected, @"Idle for %ld minutes: wrong idle time", (long)minutes);
+		STAssertTrue(idleString == expectedString || [idleString isEqualToString:expectedString],
+					 @"Idle for %ld minutes: %@ rather than %@", (long)minutes, idleString, expectedString);
+
+		[pool release];
+	}
+}
+
+- (void)minuteDidChange:(NSNotification *)notification {
+	minuteCount++;
+}
+
+@end
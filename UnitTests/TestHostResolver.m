@@ -0,0 +1,261 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestHostResolver.h"
+
+#import <AIUtilities/AIHostResolver.h>
+#import <AIUtilities/AIHostsFileHostResolverBackend.h>
+
+#import <sys/socket.h>
+#import <arpa/inet.h>
+#import <netdb.h>
+
+#define HOSTS_FILE	@"# Test hosts\n" \
+					@"2001:db8::1	example.org www.example.org\n" \
+					@"2001:db8::2	example.org\n" \
+					@"192.0.2.1		example.org	# the IPv4 address\n" \
+					@"192.0.2.2		example.org\n" \
+					@"198.51.100.7	chat.example.net\n"
+
+static NSString *stringFromSocketAddress(NSData *address)
+{
+	const struct sockaddr	*addr = [address bytes];
+	char					buffer[INET6_ADDRSTRLEN];
+
+	if (addr->sa_family == AF_INET6)
+		inet_ntop(AF_INET6, &((const struct sockaddr_in6 *)addr)->sin6_addr, buffer, sizeof(buffer));
+	else
+		inet_ntop(AF_INET, &((const struct sockaddr_in *)addr)->sin_addr, buffer, sizeof(buffer));
+
+	return [NSString stringWithUTF8String:buffer];
+}
+
+@interface TestHostResolver ()
+- (AIHostResolver *)resolver;
+- (AIHostResolution *)resolve:(NSString *)hostName withResolver:(AIHostResolver *)resolver;
+- (void)waitForAnswerCount:(NSUInteger)count timeout:(NSTimeInterval)timeout;
+- (void)waitFor:(NSTimeInterval)seconds;
+@end
+
+@implementation TestHostResolver
+
+- (void)setUp {
+	backend = [[AIHostsFileHostResolverBackend alloc] initWithHostsFileContents:HOSTS_FILE];
+	answers = [[NSMutableArray alloc] init];
+}
+
+- (void)tearDown {
+	[backend release]; backend = nil;
+	[answers release]; answers = nil;
+}
+
+- (AIHostResolver *)resolver {
+	return [[[AIHostResolver alloc] initWithBackend:backend] autorelease];
+}
+
+/*!
+ * @brief Resolve a host, noting the answer as the host name and then the addresses as strings, or the error code
+ */
+- (AIHostResolution *)resolve:(NSString *)hostName withResolver:(AIHostResolver *)resolver {
+	return [resolver resolveHostName:hostName handler:^(NSArray *addresses, NSError *error) {
+		NSMutableArray *answer = [NSMutableArray arrayWithObject:hostName];
+
+		if (error) {
+			[answer addObject:[NSNumber numberWithInteger:[error code]]];
+		} else {
+			for (NSData *address in addresses) [answer addObject:stringFromSocketAddress(address)];
+		}
+
+		[answers addObject:answer];
+	}];
+}
+
+- (void)waitForAnswerCount:(NSUInteger)count timeout:(NSTimeInterval)timeout {
+	NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:timeout];
+	while (answers.count < count && [deadline timeIntervalSinceNow] > 0) {
+		[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+	}
+}
+
+- (void)waitFor:(NSTimeInterval)seconds {
+	[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:seconds]];
+}
+
+- (void)testAnswersFromHostsFile {
+	AIHostResolver *resolver = [self resolver];
+
+	[self resolve:@"WWW.Example.org" withResolver:resolver];
+	STAssertEquals(answers.count, (NSUInteger)0, @"The handler should be called asynchronously");
+
+	[self waitForAnswerCount:1 timeout:5];
+	STAssertEqualObjects([answers lastObject], ([NSArray arrayWithObjects:@"WWW.Example.org", @"2001:db8::1", nil]),
+						 @"Names should be matched without regard to case");
+
+	[self resolve:@"nowhere.example" withResolver:resolver];
+	[self waitForAnswerCount:2 timeout:5];
+	STAssertEqualObjects([answers lastObject], ([NSArray arrayWithObjects:@"nowhere.example", [NSNumber numberWithInteger:EAI_NONAME], nil]),
+						 @"Unknown names should fail with EAI_NONAME");
+}
+
+- (void)testAddressFamiliesAlternate {
+	AIHostResolver *resolver = [self resolver];
+
+	[self resolve:@"example.org" withResolver:resolver];
+	[self waitForAnswerCount:1 timeout:5];
+	STAssertEqualObjects([answers lastObject],
+						 ([NSArray arrayWithObjects:@"example.org", @"2001:db8::1", @"192.0.2.1", @"2001:db8::2", @"192.0.2.2", nil]),
+						 @"IPv6 and IPv4 addresses should alternate, IPv6 first as listed, keeping their own order");
+
+	NSArray *addresses = [NSArray arrayWithObjects:
+						  [AIHostsFileHostResolverBackend socketAddressWithString:@"192.0.2.9"],
+						  [AIHostsFileHostResolverBackend socketAddressWithString:@"2001:db8::9"],
+						  [AIHostsFileHostResolverBackend socketAddressWithString:@"2001:db8::a"], nil];
+	STAssertEqualObjects(AIHostResolverInterleavedAddresses(addresses), addresses, @"The first family listed should go first");
+}
+
+- (void)testAnswersAreCached {
+	AIHostResolver *resolver = [self resolver];
+
+	[self resolve:@"chat.example.net" withResolver:resolver];
+	[self waitForAnswerCount:1 timeout:5];
+	[self resolve:@"CHAT.example.net" withResolver:resolver];
+	STAssertEquals(answers.count, (NSUInteger)1, @"Cached answers should also be given asynchronously");
+	[self waitForAnswerCount:2 timeout:5];
+
+	STAssertEqualObjects([[answers lastObject] lastObject], @"198.51.100.7", @"The cached address should be given");
+	STAssertEquals(backend.queryCount, (NSUInteger)1, @"The backend should be asked once");
+	STAssertEquals(resolver.cacheHitCount, (NSUInteger)1, @"The second lookup should hit the cache");
+}
+
+- (void)testExpiredAnswersAreLookedUpAgain {
+	AIHostResolver *resolver = [self resolver];
+
+	backend.timeToLive = 0.1;
+	resolver.minimumTimeToLive = 0;
+
+	[self resolve:@"chat.example.net" withResolver:resolver];
+	[self waitForAnswerCount:1 timeout:5];
+	[self waitFor:0.2];
+	[self resolve:@"chat.example.net" withResolver:resolver];
+	[self waitForAnswerCount:2 timeout:5];
+	STAssertEquals(backend.queryCount, (NSUInteger)2, @"An expired answer should be looked up again");
+
+	//The backend's time to live is stretched to the minimum
+	resolver.minimumTimeToLive = 60;
+	[self resolve:@"example.org" withResolver:resolver];
+	[self waitForAnswerCount:3 timeout:5];
+	[self waitFor:0.2];
+	[self resolve:@"example.org" withResolver:resolver];
+	[self waitForAnswerCount:4 timeout:5];
+	STAssertEquals(backend.queryCount, (NSUInteger)3, @"The minimum time to live should apply");
+}
+
+- (void)testConcurrentLookupsAreShared {
+	AIHostResolver	*resolver = [self resolver];
+	NSUInteger		i;
+
+	backend.latency = 0.1;
+	for (i = 0; i < 10; i++) [self resolve:@"example.org" withResolver:resolver];
+	[self waitForAnswerCount:10 timeout:5];
+
+	STAssertEquals(answers.count, (NSUInteger)10, @"Every request should be answered");
+	STAssertEquals(backend.queryCount, (NSUInteger)1, @"Requests for a host being looked up should wait for that lookup");
+	STAssertEquals(resolver.coalescedLookupCount, (NSUInteger)9, @"The waiting requests should be counted");
+	STAssertEqualObjects([answers objectAtIndex:0], [answers objectAtIndex:9], @"Every request should get the same addresses");
+}
+
+- (void)testFailuresAreCachedBriefly {
+	AIHostResolver *resolver = [self resolver];
+
+	resolver.negativeTimeToLive = 0.1;
+	[self resolve:@"nowhere.example" withResolver:resolver];
+	[self waitForAnswerCount:1 timeout:5];
+	[self resolve:@"nowhere.example" withResolver:resolver];
+	[self waitForAnswerCount:2 timeout:5];
+
+	STAssertEquals(backend.queryCount, (NSUInteger)1, @"A failure should be remembered");
+	STAssertEquals(resolver.negativeCacheHitCount, (NSUInteger)1, @"The remembered failure should be counted");
+	STAssertEqualObjects([answers objectAtIndex:1], [answers objectAtIndex:0], @"The remembered failure should be given");
+
+	[self waitFor:0.2];
+	[self resolve:@"nowhere.example" withResolver:resolver];
+	[self waitForAnswerCount:3 timeout:5];
+	STAssertEquals(backend.queryCount, (NSUInteger)2, @"A failure should only be remembered for negativeTimeToLive");
+}
+
+- (void)testCancelledRequestsAreNotAnswered {
+	AIHostResolver		*resolver = [self resolver];
+
+	backend.latency = 0.1;
+	AIHostResolution	*cancelled = [self resolve:@"example.org" withResolver:resolver];
+	[self resolve:@"chat.example.net" withResolver:resolver];
+	[cancelled cancel];
+	STAssertTrue(cancelled.isCancelled, @"The resolution should know it was cancelled");
+
+	[self waitForAnswerCount:1 timeout:5];
+	[self waitFor:0.2];
+	STAssertEquals(answers.count, (NSUInteger)1, @"Only the request which wasn't cancelled should be answered");
+	STAssertEqualObjects([[answers lastObject] objectAtIndex:0], @"chat.example.net", @"The other request should be answered");
+
+	[self resolve:@"example.org" withResolver:resolver];
+	[self waitForAnswerCount:2 timeout:5];
+	STAssertEquals(backend.queryCount, (NSUInteger)2, @"The cancelled request's lookup should still have been cached");
+}
+
+- (void)testFlushingForgetsAnswers {
+	AIHostResolver *resolver = [self resolver];
+
+	[self resolve:@"chat.example.net" withResolver:resolver];
+	[self waitForAnswerCount:1 timeout:5];
+
+	[resolver flushCache];
+	[self resolve:@"chat.example.net" withResolver:resolver];
+	[self waitForAnswerCount:2 timeout:5];
+	STAssertEquals(backend.queryCount, (NSUInteger)2, @"A flushed answer should be looked up again");
+
+	//A lookup in progress when the cache is flushed is answered, but not cached
+	backend.latency = 0.1;
+	[resolver flushCache];
+	[self resolve:@"example.org" withResolver:resolver];
+	[resolver flushCache];
+	[self resolve:@"example.org" withResolver:resolver];
+	[self waitForAnswerCount:4 timeout:5];
+	STAssertEquals(backend.queryCount, (NSUInteger)4, @"A request after a flush should not wait for a lookup from before it");
+	[self resolve:@"example.org" withResolver:resolver];
+	[self waitForAnswerCount:5 timeout:5];
+	STAssertEquals(backend.queryCount, (NSUInteger)4, @"The lookup after the flush should be cached");
+}
+
+- (void)testStatistics {
+	AIHostResolver	*resolver = [self resolver];
+	NSUInteger		i;
+
+	backend.latency = 0.05;
+	for (i = 0; i < 4; i++) [self resolve:@"example.org" withResolver:resolver];
+	[self waitForAnswerCount:4 timeout:5];
+
+	STAssertEquals(resolver.lookupCount, (NSUInteger)4, @"Every request should be counted");
+	STAssertEquals(resolver.backendQueryCount, (NSUInteger)1, @"One lookup should have been made");
+	STAssertEqualsWithAccuracy(resolver.hitRate, 0.75, 1e-9, @"Three of four requests were answered without a lookup");
+	STAssertTrue(resolver.averageBackendLatency >= 0.05, @"The backend's latency should be measured");
+	STAssertEqualsWithAccuracy(resolver.maximumBackendLatency, resolver.averageBackendLatency, 1e-9, @"One lookup: the maximum is the average");
+
+	[resolver resetStatistics];
+	STAssertEquals(resolver.lookupCount, (NSUInteger)0, @"Resetting should zero the counters");
+	STAssertEquals(resolver.hitRate, 0.0, @"Resetting should zero the hit rate");
+}
+
+@end
@@ -0,0 +1,131 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestImageTranscoder.h"
+
+#import <AIUtilities/AIImageTranscoder.h>
+#import <ApplicationServices/ApplicationServices.h>
+
+//A screenshot-sized image
+#define IMAGE_WIDTH		1440
+#define IMAGE_HEIGHT	900
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+/*!
+ * @brief An opaque image, either one colour or random noise, which neither PNG nor JPEG can compress
+ */
+static CGImageRef copyImage(BOOL noisy)
+{
+	CGColorSpaceRef	colorSpace = CGColorSpaceCreateDeviceRGB();
+	CGContextRef	context = CGBitmapContextCreate(NULL, IMAGE_WIDTH, IMAGE_HEIGHT, 8, IMAGE_WIDTH * 4, colorSpace, kCGImageAlphaNoneSkipLast);
+	uint8_t			*pixels = CGBitmapContextGetData(context);
+	uint32_t		state = 1;
+
+	for (NSUInteger i = 0; i < IMAGE_WIDTH * IMAGE_HEIGHT * 4; i++) {
+		pixels[i] = (noisy ? (uint8_t)nextRandom(&state) : 0xC0);
+	}
+
+	CGImageRef image = CGBitmapContextCreateImage(context);
+	CGContextRelease(context);
+	CGColorSpaceRelease(colorSpace);
+
+	return image;
+}
+
+@interface TestImageTranscoder ()
+- (NSArray *)transcode:(BOOL)noisy maximumFileSize:(NSUInteger)maximumFileSize encodingCount:(NSUInteger *)encodingCount;
+@end
+
+@implementation TestImageTranscoder
+
+- (void)setUp {
+	results = [[NSMutableArray alloc] init];
+}
+
+- (void)tearDown {
+	for (NSArray *result in results) {
+		if ([[result objectAtIndex:0] isKindOfClass:[NSString class]])
+			[[NSFileManager defaultManager] removeItemAtPath:[result objectAtIndex:0] error:NULL];
+	}
+	[results release]; results = nil;
+}
+
+/*!
+ * @brief Transcode an image and wait for the path, MIME type and length, or NSNull for each if it failed
+ */
+- (NSArray *)transcode:(BOOL)noisy maximumFileSize:(NSUInteger)maximumFileSize encodingCount:(NSUInteger *)encodingCount {
+	AIImageTranscoder	*transcoder = [[[AIImageTranscoder alloc] init] autorelease];
+	CGImageRef			image = copyImage(noisy);
+	NSDate				*deadline = [NSDate dateWithTimeIntervalSinceNow:60.0];
+	NSUInteger			count = results.count;
+
+	transcoder.maximumFileSize = maximumFileSize;
+	[transcoder transcodeImage:image completion:^(NSString *path, NSString *MIMEType, unsigned long long length, NSError *error) {
+		STAssertTrue([NSThread isMainThread], @"The completion should be called on the main thread");
+		STAssertTrue((path == nil) == (error != nil), @"There should be a file or an error");
+		[results addObject:[NSArray arrayWithObjects:(path ? (id)path : [NSNull null]), (MIMEType ? (id)MIMEType : [NSNull null]),
+							[NSNumber numberWithUnsignedLongLong:length], nil]];
+	}];
+	CGImageRelease(image);
+
+	while (results.count == count && [deadline timeIntervalSinceNow] > 0) {
+		[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+	}
+
+	STAssertEquals(results.count, count + 1, @"The transcoder should have finished");
+	if (encodingCount) *encodingCount = transcoder.encodingCount;
+
+	return [results lastObject];
+}
+
+- (void)testFlatImageStaysPNG {
+	NSUInteger	encodingCount = 0;
+	NSArray		*result = [self transcode:NO maximumFileSize:0 encodingCount:&encodingCount];
+
+	STAssertEqualObjects([result objectAtIndex:1], @"image/png", @"A flat image should be smaller as PNG");
+	STAssertEquals([[[NSFileManager defaultManager] attributesOfItemAtPath:[result objectAtIndex:0] error:NULL] fileSize],
+				   [[result objectAtIndex:2] unsignedLongLongValue], @"The length should be the file's");
+	STAssertEquals(encodingCount, (NSUInteger)2, @"Only the PNG and the JPEG it beat should have been encoded");
+}
+
+- (void)testNoisyImageIsShrunkToFit {
+	NSUInteger	encodingCount = 0;
+	NSArray		*result = [self transcode:YES maximumFileSize:500000 encodingCount:&encodingCount];
+
+	STAssertEqualObjects([result objectAtIndex:1], @"image/jpeg", @"Noise should only fit as a JPEG");
+	STAssertTrue([[result objectAtIndex:2] unsignedLongLongValue] <= 500000, @"The file should fit the maximum");
+	STAssertEquals([[[NSFileManager defaultManager] attributesOfItemAtPath:[result objectAtIndex:0] error:NULL] fileSize],
+				   [[result objectAtIndex:2] unsignedLongLongValue], @"The length should be the file's");
+	STAssertTrue(encodingCount > 2, @"Lower qualities or sizes should have been tried");
+
+	NSData				*data = [NSData dataWithContentsOfFile:[result objectAtIndex:0]];
+	CGImageSourceRef	source = CGImageSourceCreateWithData((CFDataRef)data, NULL);
+	STAssertTrue(source && CGImageSourceGetCount(source) == 1, @"The file should be a readable image");
+	if (source) CFRelease(source);
+}
+
+- (void)testImpossibleSizeFails {
+	NSArray *result = [self transcode:YES maximumFileSize:100 encodingCount:NULL];
+
+	STAssertEqualObjects([result objectAtIndex:0], [NSNull null], @"Nothing should fit in 100 bytes");
+}
+
+@end
@@ -0,0 +1,92 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#import "TestKeywordMatcher.h"
+
+#import <AIUtilities/AIKeywordMatcher.h>
+
+@implementation TestKeywordMatcher
+
+- (void)testFindsFirstOccurrenceOfEachKeyword {
+	AIKeywordMatcher *matcher = [[[AIKeywordMatcher alloc] initWithKeywords:[NSArray arrayWithObjects:@"%_uptime", @"%_itunes", nil]] autorelease];
+	NSRange ranges[2];
+
+	[matcher getFirstRanges:ranges inString:@"up %_uptime, playing %_itunes and still %_uptime"];
+	STAssertEquals(ranges[0], NSMakeRange(3, 8), @"The first occurrence of the first keyword should be found");
+	STAssertEquals(ranges[1], NSMakeRange(22, 8), @"The first occurrence of the second keyword should be found");
+}
+
+- (void)testIgnoresCase {
+	AIKeywordMatcher *matcher = [[[AIKeywordMatcher alloc] initWithKeywords:[NSArray arrayWithObject:@"%_activeApp"]] autorelease];
+	NSRange range;
+
+	[matcher getFirstRanges:&range inString:@"using %_ACTIVEAPP"];
+	STAssertEquals(range, NSMakeRange(6, 11), @"Keywords should match regardless of case");
+}
+
+- (void)testOverlappingKeywords {
+	//One keyword beginning another, one ending another, and one inside another
+	NSArray *keywords = [NSArray arrayWithObjects:@"%_adium", @"%_adiumversion", @"version", @"iumv", nil];
+	AIKeywordMatcher *matcher = [[[AIKeywordMatcher alloc] initWithKeywords:keywords] autorelease];
+	NSRange ranges[4];
+
+	[matcher getFirstRanges:ranges inString:@"I use %_adiumversion"];
+	STAssertEquals(ranges[0], NSMakeRange(6, 7), @"A keyword which begins a longer one should be found");
+	STAssertEquals(ranges[1], NSMakeRange(6, 14), @"A keyword which contains others should be found");
+	STAssertEquals(ranges[2], NSMakeRange(13, 7), @"A keyword which ends a longer one should be found");
+	STAssertEquals(ranges[3], NSMakeRange(10, 4), @"A keyword inside a longer one should be found");
+}
+
+- (void)testMissingAndEmptyKeywords {
+	NSArray *keywords = [NSArray arrayWithObjects:@"", @"%_safari", @"%_safari", @"%_growl", nil];
+	AIKeywordMatcher *matcher = [[[AIKeywordMatcher alloc] initWithKeywords:keywords] autorelease];
+	NSRange ranges[4];
+
+	[matcher getFirstRanges:ranges inString:@"reading %_safari"];
+	STAssertEquals(ranges[0].location, (NSUInteger)NSNotFound, @"An empty keyword should never match");
+	STAssertEquals(ranges[1], NSMakeRange(8, 8), @"A repeated keyword should be found");
+	STAssertEquals(ranges[2], NSMakeRange(8, 8), @"Every copy of a repeated keyword should be found");
+	STAssertEquals(ranges[3].location, (NSUInteger)NSNotFound, @"A missing keyword should not be found");
+
+	[matcher getFirstRanges:ranges inString:@""];
+	STAssertEquals(ranges[1].location, (NSUInteger)NSNotFound, @"Nothing should be found in an empty string");
+}
+
+- (void)testExcludedAttribute {
+	AIKeywordMatcher *matcher = [[[AIKeywordMatcher alloc] initWithKeywords:[NSArray arrayWithObjects:@"%_mood", @"%_link", nil]] autorelease];
+	NSMutableAttributedString *string = [[[NSMutableAttributedString alloc] initWithString:@"see %_mood at %_mood and %_link"] autorelease];
+	NSRange ranges[2];
+
+	[string addAttribute:NSLinkAttributeName value:[NSURL URLWithString:@"http://adium.im/"] range:NSMakeRange(4, 6)];
+	//A link which only covers the end of a keyword still excludes it
+	[string addAttribute:NSLinkAttributeName value:[NSURL URLWithString:@"http://adium.im/"] range:NSMakeRange(29, 2)];
+
+	[matcher getFirstRanges:ranges inAttributedString:string excludingAttribute:NSLinkAttributeName];
+	STAssertEquals(ranges[0], NSMakeRange(14, 6), @"A keyword inside a link should be skipped for the next one outside");
+	STAssertEquals(ranges[1].location, (NSUInteger)NSNotFound, @"A keyword partly inside a link should not be found");
+
+	[matcher getFirstRanges:ranges inAttributedString:string excludingAttribute:nil];
+	STAssertEquals(ranges[0], NSMakeRange(4, 6), @"With no attribute excluded, links should be searched too");
+}
+
+- (void)testNonASCII {
+	AIKeywordMatcher *matcher = [[[AIKeywordMatcher alloc] initWithKeywords:[NSArray arrayWithObject:@"%_ÜBERΣ"]] autorelease];
+	NSRange range;
+
+	[matcher getFirstRanges:&range inString:@"☃ %_überσ"];
+	STAssertEquals(range, NSMakeRange(2, 7), @"Keywords outside ASCII should match regardless of case");
+}
+
+@end
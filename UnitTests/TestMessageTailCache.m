@@ -0,0 +1,257 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestMessageTailCache.h"
+
+#import "AIMessageTailCache.h"
+#import <AIUtilities/AISharedWriterQueue.h>
+
+#define TEST_KEY		@"Test.account/contact"
+#define TEST_CAPACITY	5
+
+@interface TestMessageTailCache ()
+- (AIMessageTailCache *)cache;
+- (NSDictionary *)log:(NSString *)elementName number:(NSUInteger)number with:(AIMessageTailCache *)cache;
+- (void)appendToLog:(NSString *)string;
+- (NSArray *)writtenRecordsForLines:(NSUInteger)lines alsoStatus:(BOOL)alsoStatus;
+@end
+
+@implementation TestMessageTailCache
+
+- (void)setUp {
+	directory = [[NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]] retain];
+	logPath = [[directory stringByAppendingPathComponent:@"contact.xml"] retain];
+	written = [[NSMutableArray alloc] init];
+
+	[[NSFileManager defaultManager] createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+	[@"<chat>\n" writeToFile:logPath atomically:NO encoding:NSUTF8StringEncoding error:NULL];
+}
+
+- (void)tearDown {
+	[AISharedWriterQueue waitUntilAllOperationsAreFinished];
+	[[NSFileManager defaultManager] removeItemAtPath:directory error:NULL];
+
+	[directory release]; directory = nil;
+	[logPath release]; logPath = nil;
+	[written release]; written = nil;
+}
+
+- (AIMessageTailCache *)cache {
+	AIMessageTailCache *cache = [[[AIMessageTailCache alloc] initWithCachePath:[directory stringByAppendingPathComponent:@"Cache"]] autorelease];
+	cache.capacity = TEST_CAPACITY;
+	return cache;
+}
+
+/*!
+ * @brief Log a message or status through the cache, as the logger does
+ */
+- (NSDictionary *)log:(NSString *)elementName number:(NSUInteger)number with:(AIMessageTailCache *)cache {
+	NSString		*contents = [NSString stringWithFormat:@"%@ %lu", elementName, (unsigned long)number];
+	NSDictionary	*record = [AIMessageTailCache recordWithName:elementName
+												  attributeNames:[NSArray arrayWithObject:@"sender"]
+														  values:[NSArray arrayWithObject:@"contact"]
+												 escapedContents:contents
+													 inLogBundle:nil];
+
+	[cache appendRecord:record toLogAtPath:logPath forKey:TEST_KEY writing:^{
+		[self appendToLog:[NSString stringWithFormat:@"<%@ sender=\"contact\">%@</%@>\n", elementName, contents, elementName]];
+	}];
+	[written addObject:record];
+
+	return record;
+}
+
+- (void)appendToLog:(NSString *)string {
+	NSString *path = [[logPath retain] autorelease];
+
+	[AISharedWriterQueue addOperation:^{
+		NSFileHandle *handle = [NSFileHandle fileHandleForWritingAtPath:path];
+		[handle seekToEndOfFile];
+		[handle writeData:[string dataUsingEncoding:NSUTF8StringEncoding]];
+		[handle closeFile];
+	}];
+}
+
+/*!
+ * @brief The newest lines written, as the log would give them
+ */
+- (NSArray *)writtenRecordsForLines:(NSUInteger)lines alsoStatus:(BOOL)alsoStatus {
+	NSMutableArray *found = [NSMutableArray array];
+
+	for (NSDictionary *record in [written reverseObjectEnumerator]) {
+		if (found.count == lines) break;
+		if (alsoStatus || [[record objectForKey:KEY_TAIL_RECORD_NAME] isEqualToString:@"message"])
+			[found insertObject:record atIndex:0];
+	}
+
+	return found;
+}
+
+- (void)testRecordsMatchLog {
+	AIMessageTailCache *cache = [self cache];
+
+	for (NSUInteger i = 0; i < 3 * TEST_CAPACITY; i++) {
+		[self log:@"message" number:i with:cache];
+	}
+	[cache waitForPendingWritesForKey:TEST_KEY];
+
+	STAssertEqualObjects([cache recordsForKey:TEST_KEY lines:TEST_CAPACITY alsoStatus:NO], [self writtenRecordsForLines:TEST_CAPACITY alsoStatus:NO], @"The cache should hold the newest messages logged");
+	STAssertEqualObjects([cache recordsForKey:TEST_KEY lines:2 alsoStatus:NO], [self writtenRecordsForLines:2 alsoStatus:NO], @"Fewer lines should be the newest of them");
+	STAssertNil([cache recordsForKey:TEST_KEY lines:TEST_CAPACITY + 1 alsoStatus:NO], @"The cache can't say what's beyond its capacity");
+	STAssertNil([cache recordsForKey:@"Test.account/other" lines:1 alsoStatus:NO], @"Nothing was logged for other keys");
+}
+
+- (void)testStatusesKeptBetweenMessages {
+	AIMessageTailCache *cache = [self cache];
+
+	for (NSUInteger i = 0; i < 2 * TEST_CAPACITY; i++) {
+		[self log:@"message" number:i with:cache];
+		if (i % 2) [self log:@"status" number:i with:cache];
+	}
+	[cache waitForPendingWritesForKey:TEST_KEY];
+
+	STAssertEqualObjects([cache recordsForKey:TEST_KEY lines:TEST_CAPACITY alsoStatus:NO], [self writtenRecordsForLines:TEST_CAPACITY alsoStatus:NO], @"Statuses shouldn't count as messages");
+	STAssertEqualObjects([cache recordsForKey:TEST_KEY lines:TEST_CAPACITY alsoStatus:YES], [self writtenRecordsForLines:TEST_CAPACITY alsoStatus:YES], @"Statuses should be returned with messages when asked for");
+}
+
+/*!
+ * @brief A new cache on the same path, as after relaunching, should read back the saved entry and its journal
+ */
+- (void)testJournalSurvivesRelaunch {
+	AIMessageTailCache	*cache = [self cache];
+	NSUInteger			writeCount = 2 * cache.recordLimit + 5;	//Saved on the first write and every recordLimit + 1 after, so the last few are journaled
+
+	for (NSUInteger i = 0; i < writeCount; i++) {
+		[self log:(i % 3 ? @"message" : @"status") number:i with:cache];
+	}
+	[cache waitForPendingWritesForKey:TEST_KEY];
+
+	NSString *cachePath = [directory stringByAppendingPathComponent:@"Cache"];
+	STAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:[[cachePath stringByAppendingPathComponent:TEST_KEY] stringByAppendingPathExtension:@"plist"]], @"The entry should have been saved");
+	STAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:[[cachePath stringByAppendingPathComponent:TEST_KEY] stringByAppendingPathExtension:@"journal"]], @"Writes since it was saved should be journaled");
+
+	AIMessageTailCache *relaunched = [self cache];
+	STAssertEqualObjects([relaunched recordsForKey:TEST_KEY lines:TEST_CAPACITY alsoStatus:NO], [self writtenRecordsForLines:TEST_CAPACITY alsoStatus:NO], @"Messages read back should match the log");
+	STAssertEqualObjects([relaunched recordsForKey:TEST_KEY lines:TEST_CAPACITY alsoStatus:YES], [self writtenRecordsForLines:TEST_CAPACITY alsoStatus:YES], @"Statuses read back should match the log");
+
+	[self log:@"message" number:writeCount with:relaunched];
+	[relaunched waitForPendingWritesForKey:TEST_KEY];
+	STAssertEqualObjects([[self cache] recordsForKey:TEST_KEY lines:TEST_CAPACITY alsoStatus:NO], [self writtenRecordsForLines:TEST_CAPACITY alsoStatus:NO], @"A write after relaunching should be journaled onto the entry read back");
+}
+
+- (void)testLogChangedElsewhere {
+	AIMessageTailCache *cache = [self cache];
+
+	for (NSUInteger i = 0; i < TEST_CAPACITY; i++) {
+		[self log:@"message" number:i with:cache];
+	}
+	[cache waitForPendingWritesForKey:TEST_KEY];
+	STAssertNotNil([cache recordsForKey:TEST_KEY lines:1 alsoStatus:NO], @"The entry should be current");
+
+	[self appendToLog:@"<message sender=\"contact\">written by someone else</message>\n"];
+	[AISharedWriterQueue waitUntilAllOperationsAreFinished];
+	STAssertNil([cache recordsForKey:TEST_KEY lines:1 alsoStatus:NO], @"An entry whose log was changed by someone else is out of date");
+	STAssertNil([[self cache] recordsForKey:TEST_KEY lines:1 alsoStatus:NO], @"It should be out of date when read back, too");
+
+	[written removeAllObjects];
+	[self log:@"message" number:0 with:cache];
+	[cache waitForPendingWritesForKey:TEST_KEY];
+	STAssertEqualObjects([cache recordsForKey:TEST_KEY lines:1 alsoStatus:NO], [self writtenRecordsForLines:1 alsoStatus:NO], @"The next write should start the entry over");
+}
+
+- (void)testWaitForPendingWrites {
+	AIMessageTailCache	*cache = [self cache];
+	__block BOOL		otherWriteFinished = NO;
+
+	[self log:@"message" number:0 with:cache];
+	[cache waitForPendingWritesForKey:TEST_KEY];
+
+	NSString *log = [NSString stringWithContentsOfFile:logPath encoding:NSUTF8StringEncoding error:NULL];
+	STAssertTrue([log hasSuffix:@"<message sender=\"contact\">message 0</message>\n"], @"The write should be in the log once waited for");
+
+	//A slow write for another key shouldn't hold up a key with nothing pending
+	[AISharedWriterQueue addOperation:^{
+		[NSThread sleepForTimeInterval:0.5];
+		otherWriteFinished = YES;
+	}];
+	[cache waitForPendingWritesForKey:TEST_KEY];
+	STAssertFalse(otherWriteFinished, @"Waiting for a key with nothing pending shouldn't wait for the writer queue");
+}
+
+- (void)testWaitForPendingWritesUntilDate {
+	AIMessageTailCache	*cache = [self cache];
+	NSCondition			*writerHeld = [[[NSCondition alloc] init] autorelease];
+	__block BOOL		released = NO;
+
+	//Hold up the writer queue until we say
+	[AISharedWriterQueue addOperation:^{
+		[writerHeld lock];
+		while (!released)
+			[writerHeld wait];
+		[writerHeld unlock];
+	}];
+
+	[self log:@"message" number:0 with:cache];
+	STAssertFalse([cache waitForPendingWritesForKey:TEST_KEY untilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]], @"The write can't be finished while the writer queue is held up");
+
+	[writerHeld lock];
+	released = YES;
+	[writerHeld signal];
+	[writerHeld unlock];
+
+	STAssertTrue([cache waitForPendingWritesForKey:TEST_KEY untilDate:[NSDate dateWithTimeIntervalSinceNow:10.0]], @"The write should finish once the writer queue moves");
+	STAssertEqualObjects([cache recordsForKey:TEST_KEY lines:1 alsoStatus:NO], [self writtenRecordsForLines:1 alsoStatus:NO], @"The write should be in the entry");
+}
+
+- (void)testLeastRecentlyUsedEntryDropped {
+	AIMessageTailCache	*cache = [self cache];
+	NSArray				*records = [NSArray arrayWithObject:[AIMessageTailCache recordWithName:@"message"
+																			attributeNames:[NSArray arrayWithObject:@"sender"]
+																					values:[NSArray arrayWithObject:@"contact"]
+																		   escapedContents:@"message"
+																			   inLogBundle:nil]];
+	NSString			*usedKey = @"Test.account/contact 0";
+	NSUInteger			count = 0;
+
+	//Add entries, using the first all the while, until the cache starts dropping them from memory
+	for (NSUInteger i = 0; [[cache valueForKey:@"entries"] count] == i; i++) {
+		[cache setRecords:records includingStatus:YES complete:YES toLogAtPath:logPath forKey:[NSString stringWithFormat:@"Test.account/contact %lu", (unsigned long)i]];
+		[cache recordsForKey:usedKey lines:1 alsoStatus:NO];
+		count = i + 1;
+	}
+
+	NSDictionary *entries = [cache valueForKey:@"entries"];
+	STAssertTrue(count > 2, @"The cache should keep more than two entries in memory");
+	STAssertNotNil([entries objectForKey:usedKey], @"The entry used all the while shouldn't be dropped");
+	STAssertNil([entries objectForKey:@"Test.account/contact 1"], @"The least recently used entry should be dropped");
+	STAssertNotNil([entries objectForKey:[NSString stringWithFormat:@"Test.account/contact %lu", (unsigned long)(count - 1)]], @"The newest entry should be kept");
+}
+
+- (void)testRemoveRecords {
+	AIMessageTailCache *cache = [self cache];
+
+	for (NSUInteger i = 0; i < TEST_CAPACITY; i++) {
+		[self log:@"message" number:i with:cache];
+	}
+	[cache waitForPendingWritesForKey:TEST_KEY];
+
+	[cache removeRecordsForKey:TEST_KEY];
+	[AISharedWriterQueue waitUntilAllOperationsAreFinished];
+	STAssertNil([cache recordsForKey:TEST_KEY lines:1 alsoStatus:NO], @"Removed records should be gone");
+	STAssertNil([[self cache] recordsForKey:TEST_KEY lines:1 alsoStatus:NO], @"Removed records should be gone from disk");
+}
+
+@end
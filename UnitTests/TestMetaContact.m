@@ -0,0 +1,598 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestMetaContact.h"
+
+#import <Adium/AIMetaContact.h>
+#import <Adium/AIListContact.h>
+#import <Adium/AIService.h>
+#import <Adium/AIContentMessage.h>
+#import <Adium/AIContactControllerProtocol.h>
+
+#define RANDOM_UID_COUNT		8
+#define RANDOM_ACCOUNT_COUNT	3
+#define RANDOM_STEP_COUNT		3000
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+/*!
+ * @brief Sorts contacts as a metacontact does, from the order indexes the test set
+ */
+static NSComparisonResult rebuiltContactSort(AIListContact *contactA, AIListContact *contactB, void *context)
+{
+	NSDictionary		*orderIndexes = (NSDictionary *)context;
+	NSComparisonResult	result = [[orderIndexes objectForKey:contactA.internalObjectID] compare:[orderIndexes objectForKey:contactB.internalObjectID]];
+
+	if (result == NSOrderedSame)
+		result = [contactA.internalUniqueObjectID caseInsensitiveCompare:contactB.internalUniqueObjectID];
+
+	return result;
+}
+
+/*!
+ * @brief Just the service ID and class of a service
+ */
+@interface TestMetaService : NSObject {
+	NSString	*serviceID;
+	NSString	*serviceClass;
+}
++ (TestMetaService *)serviceWithID:(NSString *)serviceID serviceClass:(NSString *)serviceClass;
+@property (readonly, nonatomic) NSString *serviceID;
+@property (readonly, nonatomic) NSString *serviceClass;
+@end
+
+@implementation TestMetaService
++ (TestMetaService *)serviceWithID:(NSString *)inServiceID serviceClass:(NSString *)inServiceClass {
+	TestMetaService *service = [[[self alloc] init] autorelease];
+	service->serviceID = [inServiceID copy];
+	service->serviceClass = [inServiceClass copy];
+	return service;
+}
+- (void)dealloc {
+	[serviceID release];
+	[serviceClass release];
+	[super dealloc];
+}
+@synthesize serviceID, serviceClass;
+@end
+
+/*!
+ * @brief A contact on a named account, which is listed on it or not without any remote groups being looked up
+ */
+@interface TestMetaListContact : AIListContact {
+	NSString	*accountUID;
+	BOOL		listed;
+}
++ (TestMetaListContact *)contactWithUID:(NSString *)UID service:(TestMetaService *)service accountUID:(NSString *)accountUID;
+@property (readwrite, nonatomic) BOOL listed;
+@end
+
+@implementation TestMetaListContact
++ (TestMetaListContact *)contactWithUID:(NSString *)inUID service:(TestMetaService *)inService accountUID:(NSString *)inAccountUID {
+	TestMetaListContact *contact = [[[self alloc] initWithUID:inUID service:(AIService *)inService] autorelease];
+	contact->accountUID = [inAccountUID copy];
+	contact->listed = YES;
+
+	//Nothing it would observe is set up in the tests
+	[NSObject cancelPreviousPerformRequestsWithTarget:contact];
+
+	return contact;
+}
+- (void)dealloc {
+	[accountUID release];
+	[super dealloc];
+}
+- (NSString *)internalUniqueObjectID {
+	return [NSString stringWithFormat:@"%@.%@.%@", self.service.serviceClass, accountUID, self.UID];
+}
+- (NSUInteger)countOfRemoteGroupNames {
+	return (listed ? 1 : 0);
+}
+- (NSSet *)remoteGroups {
+	return [NSSet set];
+}
+- (NSString *)description {
+	return self.internalUniqueObjectID;
+}
+@synthesize listed;
+@end
+
+/*!
+ * @brief Object preferences kept in memory
+ */
+@interface TestMetaPreferences : NSObject {
+	NSMutableDictionary	*preferencesByObjectID;
+}
+@end
+
+@implementation TestMetaPreferences
+- (id)init {
+	if ((self = [super init])) {
+		preferencesByObjectID = [[NSMutableDictionary alloc] init];
+	}
+	return self;
+}
+- (void)dealloc {
+	[preferencesByObjectID release];
+	[super dealloc];
+}
+- (id)preferenceForKey:(NSString *)key group:(NSString *)group objectIgnoringInheritance:(AIListObject *)object {
+	NSDictionary *preferences = [preferencesByObjectID objectForKey:(object ? object.internalObjectID : @"")];
+	return [preferences objectForKey:[NSString stringWithFormat:@"%@:%@", group, key]];
+}
+- (void)setPreference:(id)value forKey:(NSString *)key group:(NSString *)group object:(AIListObject *)object {
+	NSString			*objectID = (object ? object.internalObjectID : @"");
+	NSMutableDictionary	*preferences = [preferencesByObjectID objectForKey:objectID];
+
+	if (!preferences) {
+		preferences = [NSMutableDictionary dictionary];
+		[preferencesByObjectID setObject:preferences forKey:objectID];
+	}
+
+	if (value)
+		[preferences setObject:value forKey:[NSString stringWithFormat:@"%@:%@", group, key]];
+	else
+		[preferences removeObjectForKey:[NSString stringWithFormat:@"%@:%@", group, key]];
+}
+- (void)setPreferences:(NSDictionary *)prefs inGroup:(NSString *)group object:(AIListObject *)object {
+	for (NSString *key in prefs) {
+		[self setPreference:[prefs objectForKey:key] forKey:key group:group object:object];
+	}
+}
+- (void)registerPreferenceObserver:(id)observer forGroup:(NSString *)group {}
+- (void)unregisterPreferenceObserver:(id)observer {}
+@end
+
+/*!
+ * @brief A contact list which uses groups, has no offline group, and ignores moves between groups
+ */
+@interface TestMetaContactController : NSObject {}
+@property (readonly, nonatomic) BOOL useContactListGroups;
+@property (readonly, nonatomic) BOOL useOfflineGroup;
+@property (readonly, nonatomic) AIListGroup *offlineGroup;
+@property (readonly, nonatomic) AIContactList *contactList;
+@end
+
+@implementation TestMetaContactController
+- (BOOL)useContactListGroups {
+	return YES;
+}
+- (BOOL)useOfflineGroup {
+	return NO;
+}
+- (AIListGroup *)offlineGroup {
+	return nil;
+}
+- (AIContactList *)contactList {
+	return nil;
+}
+- (AIListGroup *)groupWithUID:(NSString *)groupUID {
+	return nil;
+}
+- (void)_moveContactLocally:(AIListContact *)listContact fromGroups:(NSSet *)oldGroups toGroups:(NSSet *)groups {}
+@end
+
+/*!
+ * @brief Stands in for the shared AIAdium, providing only the preference and contact controllers
+ */
+@interface TestMetaAdium : NSObject {
+	TestMetaPreferences			*preferenceController;
+	TestMetaContactController	*contactController;
+}
+@property (readwrite, retain, nonatomic) TestMetaPreferences *preferenceController;
+@property (readwrite, retain, nonatomic) TestMetaContactController *contactController;
+@end
+
+@implementation TestMetaAdium
+- (void)dealloc {
+	[preferenceController release];
+	[contactController release];
+	[super dealloc];
+}
+@synthesize preferenceController, contactController;
+@end
+
+@interface TestMetaContact ()
+- (TestMetaListContact *)contactWithUID:(NSString *)UID service:(TestMetaService *)service accountUID:(NSString *)accountUID;
+- (void)addContact:(TestMetaListContact *)contact;
+- (void)removeContact:(TestMetaListContact *)contact;
+- (void)setContact:(TestMetaListContact *)contact online:(BOOL)online;
+- (void)setContact:(TestMetaListContact *)contact away:(BOOL)away;
+- (void)setContact:(TestMetaListContact *)contact mobile:(BOOL)mobile;
+- (void)setContact:(TestMetaListContact *)contact listed:(BOOL)listed;
+- (void)moveContactToBottom:(TestMetaListContact *)contact;
+- (void)setDestinationContact:(TestMetaListContact *)contact;
+- (NSArray *)rebuiltUniqueContactsIncludingOfflineAccounts:(BOOL)includeOfflineAccounts;
+- (AIListContact *)rebuiltPreferredContactWithServiceClass:(NSString *)serviceClass;
+- (AIListContact *)rebuiltPreferredDestinationContact;
+- (void)checkAgainstRebuild:(NSString *)step preferredContactFirst:(BOOL)preferredContactFirst;
+@end
+
+@implementation TestMetaContact
+
+- (void)setUp {
+	TestMetaAdium *testAdium = [[[TestMetaAdium alloc] init] autorelease];
+
+	testAdium.preferenceController = [[[TestMetaPreferences alloc] init] autorelease];
+	testAdium.contactController = [[[TestMetaContactController alloc] init] autorelease];
+	savedAdium = adium;
+	adium = (id<AIAdium>)[testAdium retain];
+
+	metaContact = [[AIMetaContact alloc] initWithObjectID:[NSNumber numberWithInt:1]];
+	[NSObject cancelPreviousPerformRequestsWithTarget:metaContact];
+
+	aimService = [[TestMetaService serviceWithID:@"AIM" serviceClass:@"AIM-compatible"] retain];
+	jabberService = [[TestMetaService serviceWithID:@"Jabber" serviceClass:@"Jabber"] retain];
+	containedContacts = [[NSMutableArray alloc] init];
+	orderIndexes = [[NSMutableDictionary alloc] init];
+	nextOrderIndex = 1;
+	destinationID = nil;
+}
+
+- (void)tearDown {
+	[metaContact release]; metaContact = nil;
+	[containedContacts release]; containedContacts = nil;
+	[orderIndexes release]; orderIndexes = nil;
+	[destinationID release]; destinationID = nil;
+	[aimService release]; aimService = nil;
+	[jabberService release]; jabberService = nil;
+
+	[(id)adium release];
+	adium = savedAdium;
+}
+
+#pragma mark Changes
+
+/*!
+ * @brief A new contact, with an order index in the metacontact if it is the first with its ID
+ */
+- (TestMetaListContact *)contactWithUID:(NSString *)UID service:(TestMetaService *)service accountUID:(NSString *)accountUID {
+	TestMetaListContact *contact = [TestMetaListContact contactWithUID:UID service:service accountUID:accountUID];
+
+	if (![orderIndexes objectForKey:contact.internalObjectID])
+		[self moveContactToBottom:contact];
+
+	return contact;
+}
+
+- (void)addContact:(TestMetaListContact *)contact {
+	STAssertTrue([metaContact addObject:contact], @"%@ should have been added", contact);
+	[containedContacts addObject:contact];
+}
+
+- (void)removeContact:(TestMetaListContact *)contact {
+	STAssertTrue([metaContact removeObject:contact], @"%@ should have been removed", contact);
+	[containedContacts removeObjectIdenticalTo:contact];
+}
+
+//Status is changed as an account changes it, which lets the metacontact know of each change
+- (void)setContact:(TestMetaListContact *)contact online:(BOOL)online {
+	[contact setValue:[NSNumber numberWithBool:online] forProperty:@"isOnline" notify:NotifyNever];
+}
+
+- (void)setContact:(TestMetaListContact *)contact away:(BOOL)away {
+	[contact setValue:[NSNumber numberWithInt:(away ? AIAwayStatusType : AIAvailableStatusType)]
+		  forProperty:@"listObjectStatusType"
+			   notify:NotifyNever];
+}
+
+- (void)setContact:(TestMetaListContact *)contact mobile:(BOOL)mobile {
+	[contact setIsMobile:mobile notify:NotifyNever];
+}
+
+- (void)setContact:(TestMetaListContact *)contact listed:(BOOL)listed {
+	contact.listed = listed;
+	[contact restoreGrouping];
+}
+
+- (void)moveContactToBottom:(TestMetaListContact *)contact {
+	[metaContact listObject:contact didSetOrderIndex:nextOrderIndex];
+	[orderIndexes setObject:[NSNumber numberWithFloat:nextOrderIndex] forKey:contact.internalObjectID];
+	nextOrderIndex++;
+}
+
+//As a chat does when a message is sent to a contact in the metacontact
+- (void)setDestinationContact:(TestMetaListContact *)contact {
+	[destinationID release];
+	destinationID = [contact.internalObjectID retain];
+	[metaContact setPreference:destinationID forKey:KEY_PREFERRED_DESTINATION_CONTACT group:PREF_GROUP_OBJECT_STATUS_CACHE];
+}
+
+#pragma mark Rebuilding
+
+/*!
+ * @brief The metacontact's unique contacts, worked out from scratch
+ *
+ * Of contacts with the same ID, which sort next to each other, the first is kept unless it is offline and a later
+ * one is online. Only contacts listed on their accounts are kept unless offline accounts are included.
+ */
+- (NSArray *)rebuiltUniqueContactsIncludingOfflineAccounts:(BOOL)includeOfflineAccounts {
+	NSMutableArray *uniqueContacts = [NSMutableArray array];
+
+	for (AIListContact *listContact in [containedContacts sortedArrayUsingFunction:rebuiltContactSort context:orderIndexes]) {
+		AIListContact *previousContact = [uniqueContacts lastObject];
+
+		if ([listContact.internalObjectID isEqualToString:previousContact.internalObjectID]) {
+			if (!previousContact.online && listContact.online)
+				[uniqueContacts replaceObjectAtIndex:uniqueContacts.count - 1 withObject:listContact];
+
+		} else if (listContact.countOfRemoteGroupNames > 0 || includeOfflineAccounts) {
+			[uniqueContacts addObject:listContact];
+		}
+	}
+
+	return uniqueContacts;
+}
+
+/*!
+ * @brief The first available, non-mobile unique contact; failing that the first online one, then the first
+ *
+ * With a service class, only unique contacts of that class are considered. Without one, the first contained contact
+ * is used when there are no unique contacts.
+ */
+- (AIListContact *)rebuiltPreferredContactWithServiceClass:(NSString *)serviceClass {
+	AIListContact *onlineContact = nil, *firstContact = nil;
+
+	for (AIListContact *listContact in [self rebuiltUniqueContactsIncludingOfflineAccounts:NO]) {
+		if (serviceClass && ![listContact.service.serviceClass isEqualToString:serviceClass]) continue;
+
+		if (listContact.statusSummary == AIAvailableStatus && !listContact.isMobile)
+			return listContact;
+		if (listContact.online && !onlineContact)
+			onlineContact = listContact;
+		if (!firstContact)
+			firstContact = listContact;
+	}
+
+	if (onlineContact) return onlineContact;
+	if (firstContact || serviceClass) return firstContact;
+
+	NSArray *sortedContacts = [containedContacts sortedArrayUsingFunction:rebuiltContactSort context:orderIndexes];
+	return (sortedContacts.count ? [sortedContacts objectAtIndex:0] : nil);
+}
+
+/*!
+ * @brief The contact last sent to while it is as available as the metacontact, otherwise the preferred contact
+ *
+ * The metacontact's own status is that of its preferred contact, which is checked separately.
+ */
+- (AIListContact *)rebuiltPreferredDestinationContact {
+	AIListContact *destinationContact = nil;
+
+	if (destinationID) {
+		for (AIListContact *listContact in [self rebuiltUniqueContactsIncludingOfflineAccounts:YES]) {
+			if ([listContact.internalObjectID isEqualToString:destinationID]) {
+				destinationContact = listContact;
+				break;
+			}
+		}
+	}
+
+	if (!destinationContact ||
+		destinationContact.statusSummary != metaContact.statusSummary ||
+		(!metaContact.isMobile && destinationContact.isMobile))
+		destinationContact = [self rebuiltPreferredContactWithServiceClass:nil];
+
+	return destinationContact;
+}
+
+/*!
+ * @brief Check everything the metacontact keeps up to date as it changes against a rebuild
+ *
+ * @param preferredContactFirst Ask for the preferred contact before the unique contacts it is chosen from
+ */
+- (void)checkAgainstRebuild:(NSString *)step preferredContactFirst:(BOOL)preferredContactFirst {
+	NSArray			*uniqueContacts = [self rebuiltUniqueContactsIncludingOfflineAccounts:NO];
+	AIListContact	*preferredContact = [self rebuiltPreferredContactWithServiceClass:nil];
+
+	if (preferredContactFirst)
+		STAssertTrue(metaContact.preferredContact == preferredContact, @"%@: preferred contact %@, rebuilt %@", step, metaContact.preferredContact, preferredContact);
+
+	STAssertEqualObjects(metaContact.uniqueContainedObjects, uniqueContacts, @"%@: unique contacts", step);
+	STAssertEquals(metaContact.uniqueContainedObjectsCount, uniqueContacts.count, @"%@: unique contact count", step);
+	STAssertEqualObjects(metaContact.listContactsIncludingOfflineAccounts, [self rebuiltUniqueContactsIncludingOfflineAccounts:YES], @"%@: contacts including offline accounts", step);
+	STAssertTrue(metaContact.preferredContact == preferredContact, @"%@: preferred contact %@, rebuilt %@", step, metaContact.preferredContact, preferredContact);
+
+	for (TestMetaService *service in [NSArray arrayWithObjects:aimService, jabberService, nil]) {
+		AIListContact *compatibleContact = [metaContact preferredContactWithCompatibleService:(AIService *)service];
+		AIListContact *rebuiltContact = [self rebuiltPreferredContactWithServiceClass:service.serviceClass];
+
+		STAssertTrue(compatibleContact == rebuiltContact, @"%@: preferred %@ contact %@, rebuilt %@", step, service.serviceClass, compatibleContact, rebuiltContact);
+	}
+
+	AIListContact *destinationContact = [metaContact preferredContactForContentType:CONTENT_MESSAGE_TYPE];
+	AIListContact *rebuiltDestinationContact = [self rebuiltPreferredDestinationContact];
+	STAssertTrue(destinationContact == rebuiltDestinationContact, @"%@: destination %@, rebuilt %@", step, destinationContact, rebuiltDestinationContact);
+}
+
+#pragma mark Tests
+
+- (void)testDuplicateOnOnlineAccountChosen {
+	TestMetaListContact *aliceOne = [self contactWithUID:@"alice" service:aimService accountUID:@"one"];
+	TestMetaListContact *aliceTwo = [self contactWithUID:@"alice" service:aimService accountUID:@"two"];
+	TestMetaListContact *bob = [self contactWithUID:@"bob" service:aimService accountUID:@"one"];
+
+	[self addContact:aliceOne];
+	[self addContact:aliceTwo];
+	[self addContact:bob];
+	STAssertEqualObjects(metaContact.uniqueContainedObjects, ([NSArray arrayWithObjects:aliceOne, bob, nil]), @"Alice should be listed once, from the first account");
+
+	[self setContact:aliceTwo online:YES];
+	STAssertEqualObjects(metaContact.uniqueContainedObjects, ([NSArray arrayWithObjects:aliceTwo, bob, nil]), @"Alice should be listed from the account she is online on");
+	STAssertTrue(metaContact.preferredContact == aliceTwo, @"Alice online should be preferred");
+
+	[self setContact:aliceOne online:YES];
+	[self setContact:aliceTwo online:NO];
+	STAssertEqualObjects(metaContact.uniqueContainedObjects, ([NSArray arrayWithObjects:aliceOne, bob, nil]), @"Alice should move back to the first account");
+	STAssertTrue(metaContact.preferredContact == aliceOne, @"Alice online should be preferred");
+	[self checkAgainstRebuild:@"duplicate" preferredContactFirst:NO];
+}
+
+- (void)testUnlistedContactsNotUnique {
+	TestMetaListContact *alice = [self contactWithUID:@"alice" service:aimService accountUID:@"one"];
+	TestMetaListContact *bob = [self contactWithUID:@"bob" service:aimService accountUID:@"one"];
+
+	alice.listed = NO;
+	[self addContact:alice];
+	[self addContact:bob];
+	STAssertEqualObjects(metaContact.uniqueContainedObjects, [NSArray arrayWithObject:bob], @"Only the listed contact should be unique");
+	STAssertEqualObjects(metaContact.listContactsIncludingOfflineAccounts, ([NSArray arrayWithObjects:alice, bob, nil]), @"Both contacts should be included with offline accounts");
+
+	[self setContact:bob listed:NO];
+	STAssertEquals(metaContact.uniqueContainedObjectsCount, (NSUInteger)0, @"No contact should be unique");
+	STAssertTrue(metaContact.preferredContact == alice, @"With no unique contacts, the first contact should be preferred");
+
+	[self setContact:alice listed:YES];
+	STAssertEqualObjects(metaContact.uniqueContainedObjects, [NSArray arrayWithObject:alice], @"The newly listed contact should be unique");
+	[self checkAgainstRebuild:@"unlisted" preferredContactFirst:NO];
+}
+
+- (void)testPreferredContactFollowsStatus {
+	TestMetaListContact *alice = [self contactWithUID:@"alice" service:aimService accountUID:@"one"];
+	TestMetaListContact *bob = [self contactWithUID:@"bob" service:aimService accountUID:@"one"];
+	TestMetaListContact *carol = [self contactWithUID:@"carol" service:aimService accountUID:@"one"];
+
+	[self addContact:alice];
+	[self addContact:bob];
+	[self addContact:carol];
+	STAssertTrue(metaContact.preferredContact == alice, @"With everyone offline, the first contact should be preferred");
+
+	[self setContact:carol online:YES];
+	STAssertTrue(metaContact.preferredContact == carol, @"The available contact should be preferred");
+
+	[self setContact:bob online:YES];
+	[self setContact:bob away:YES];
+	STAssertTrue(metaContact.preferredContact == carol, @"An available contact should be preferred over an earlier away one");
+
+	[self setContact:carol mobile:YES];
+	STAssertTrue(metaContact.preferredContact == bob, @"A mobile contact should count only as online");
+
+	[self setContact:carol mobile:NO];
+	STAssertTrue(metaContact.preferredContact == carol, @"Carol should be preferred again once she is not mobile");
+
+	[self setContact:carol online:NO];
+	STAssertTrue(metaContact.preferredContact == bob, @"The online contact should be preferred");
+
+	[self setContact:bob online:NO];
+	STAssertTrue(metaContact.preferredContact == alice, @"With everyone offline, the first contact should be preferred");
+	[self checkAgainstRebuild:@"status" preferredContactFirst:NO];
+}
+
+- (void)testPreferredContactWithCompatibleService {
+	TestMetaListContact *alice = [self contactWithUID:@"alice" service:aimService accountUID:@"one"];
+	TestMetaListContact *bob = [self contactWithUID:@"bob" service:jabberService accountUID:@"one"];
+	TestMetaListContact *carol = [self contactWithUID:@"carol" service:jabberService accountUID:@"one"];
+
+	[self addContact:alice];
+	[self addContact:bob];
+	[self addContact:carol];
+	[self setContact:carol online:YES];
+
+	STAssertTrue([metaContact preferredContactWithCompatibleService:(AIService *)aimService] == alice, @"The only AIM contact should be preferred on AIM");
+	STAssertTrue([metaContact preferredContactWithCompatibleService:(AIService *)jabberService] == carol, @"The online Jabber contact should be preferred on Jabber");
+	STAssertTrue([metaContact preferredContactWithCompatibleService:nil] == carol, @"Without a service the preferred contact should be used");
+
+	[self setContact:carol online:NO];
+	STAssertTrue([metaContact preferredContactWithCompatibleService:(AIService *)jabberService] == bob, @"The first Jabber contact should be preferred when none is online");
+	[self checkAgainstRebuild:@"service" preferredContactFirst:NO];
+}
+
+- (void)testPreferredDestinationOnlyWhileAsAvailable {
+	TestMetaListContact *alice = [self contactWithUID:@"alice" service:aimService accountUID:@"one"];
+	TestMetaListContact *bob = [self contactWithUID:@"bob" service:aimService accountUID:@"one"];
+
+	[self addContact:alice];
+	[self addContact:bob];
+	[self setContact:alice online:YES];
+	[self setContact:bob online:YES];
+	[self setDestinationContact:bob];
+	STAssertTrue([metaContact preferredContactForContentType:CONTENT_MESSAGE_TYPE] == bob, @"The contact last sent to should be used");
+
+	[self setContact:bob away:YES];
+	STAssertTrue([metaContact preferredContactForContentType:CONTENT_MESSAGE_TYPE] == alice, @"A more available contact should be used");
+
+	[self setContact:bob away:NO];
+	[self setContact:bob mobile:YES];
+	STAssertTrue([metaContact preferredContactForContentType:CONTENT_MESSAGE_TYPE] == alice, @"A contact which is not mobile should be used");
+
+	[self setContact:bob mobile:NO];
+	STAssertTrue([metaContact preferredContactForContentType:CONTENT_MESSAGE_TYPE] == bob, @"The contact last sent to should be used again");
+
+	[self removeContact:bob];
+	STAssertTrue([metaContact preferredContactForContentType:CONTENT_MESSAGE_TYPE] == alice, @"A contact no longer contained should not be used");
+	[self checkAgainstRebuild:@"destination" preferredContactFirst:NO];
+}
+
+/*!
+ * @brief Random changes to contacts on several accounts, checked against a rebuild after most of them
+ */
+- (void)testRandomReplayMatchesRebuild {
+	NSMutableArray	*allContacts = [NSMutableArray array];
+	uint32_t		state = 41;
+
+	for (NSUInteger i = 0; i < RANDOM_UID_COUNT; i++) {
+		TestMetaService	*service = (i % 3 ? aimService : jabberService);
+		NSString		*UID = [NSString stringWithFormat:@"buddy%lu", (unsigned long)i];
+
+		for (NSUInteger account = 0; account < RANDOM_ACCOUNT_COUNT; account++) {
+			[allContacts addObject:[self contactWithUID:UID
+												service:service
+											 accountUID:[NSString stringWithFormat:@"account%lu", (unsigned long)account]]];
+		}
+	}
+
+	for (NSUInteger step = 0; step < RANDOM_STEP_COUNT; step++) {
+		TestMetaListContact *contact = [allContacts objectAtIndex:nextRandom(&state) % allContacts.count];
+
+		switch (nextRandom(&state) % 8) {
+			case 0:
+			case 1:
+				if ([containedContacts indexOfObjectIdenticalTo:contact] == NSNotFound)
+					[self addContact:contact];
+				else
+					[self removeContact:contact];
+				break;
+			case 2:
+				[self setContact:contact online:!contact.online];
+				break;
+			case 3:
+				[self setContact:contact away:(nextRandom(&state) % 2)];
+				break;
+			case 4:
+				[self setContact:contact mobile:!contact.isMobile];
+				break;
+			case 5:
+				[self setContact:contact listed:!contact.listed];
+				break;
+			case 6:
+				[self moveContactToBottom:contact];
+				break;
+			case 7:
+				[self setDestinationContact:(nextRandom(&state) % 4 ? contact : nil)];
+				break;
+		}
+
+		//Let several changes build up between some checks
+		if (nextRandom(&state) % 3)
+			[self checkAgainstRebuild:[NSString stringWithFormat:@"Step %lu", (unsigned long)step] preferredContactFirst:(nextRandom(&state) % 2)];
+	}
+}
+
+@end
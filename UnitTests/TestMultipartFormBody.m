@@ -0,0 +1,119 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestMultipartFormBody.h"
+
+#import <AIUtilities/AIMultipartFormBody.h>
+
+//Several times the producer's buffer, and not a multiple of it
+#define FILE_LENGTH		(300 * 1024 + 17)
+
+@interface TestMultipartFormBody ()
+- (NSData *)contentsOfStream:(NSInputStream *)stream;
+- (NSMutableData *)dataWithString:(NSString *)string;
+@end
+
+@implementation TestMultipartFormBody
+
+- (void)setUp {
+	NSMutableData	*contents = [NSMutableData dataWithLength:FILE_LENGTH];
+	uint8_t			*bytes = [contents mutableBytes];
+
+	for (NSUInteger i = 0; i < FILE_LENGTH; i++) bytes[i] = (uint8_t)(i * 7 + i / 251);
+
+	fileContents = [contents copy];
+	filePath = [[NSTemporaryDirectory() stringByAppendingPathComponent:
+				 [NSString stringWithFormat:@"TestMultipartFormBody-%d.png", getpid()]] retain];
+	[fileContents writeToFile:filePath atomically:YES];
+}
+
+- (void)tearDown {
+	[[NSFileManager defaultManager] removeItemAtPath:filePath error:NULL];
+	[filePath release]; filePath = nil;
+	[fileContents release]; fileContents = nil;
+}
+
+/*!
+ * @brief Read a stream to its end, running the run loop so the body can be produced
+ */
+- (NSData *)contentsOfStream:(NSInputStream *)stream {
+	NSMutableData	*data = [NSMutableData data];
+	NSDate			*deadline = [NSDate dateWithTimeIntervalSinceNow:10.0];
+	uint8_t			buffer[4096];
+
+	[stream open];
+	while ([stream streamStatus] != NSStreamStatusAtEnd && [stream streamStatus] != NSStreamStatusError &&
+		   [deadline timeIntervalSinceNow] > 0) {
+		if ([stream hasBytesAvailable]) {
+			NSInteger bytesRead = [stream read:buffer maxLength:sizeof(buffer)];
+			if (bytesRead > 0) [data appendBytes:buffer length:bytesRead];
+		} else {
+			[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+		}
+	}
+	[stream close];
+
+	STAssertEquals([stream streamStatus], (NSStreamStatus)NSStreamStatusClosed, @"The stream should have been read to its end");
+
+	return data;
+}
+
+- (NSMutableData *)dataWithString:(NSString *)string {
+	return [[[string dataUsingEncoding:NSUTF8StringEncoding] mutableCopy] autorelease];
+}
+
+- (void)testFieldsFileAndClosingBoundaryInOrder {
+	AIMultipartFormBody *body = [[[AIMultipartFormBody alloc] initWithBoundary:@"BOUNDARY"] autorelease];
+
+	[body addFieldWithName:@"key" value:@"c8f0b307"];
+	[body addFileAtPath:filePath name:@"image" fileName:@"image" contentType:@"image/png"];
+	[body addFieldWithName:@"caption" value:@"Screenshot"];
+
+	NSMutableData *expected = [self dataWithString:@"--BOUNDARY\r\nContent-Disposition: form-data; name=\"key\"\r\n\r\nc8f0b307\r\n"
+							   @"--BOUNDARY\r\nContent-Disposition: form-data; name=\"image\"; filename=\"image\"\r\nContent-Type: image/png\r\n\r\n"];
+	[expected appendData:fileContents];
+	[expected appendData:[self dataWithString:@"\r\n--BOUNDARY\r\nContent-Disposition: form-data; name=\"caption\"\r\n\r\nScreenshot\r\n"
+						  @"--BOUNDARY--\r\n"]];
+
+	STAssertEqualObjects(body.contentType, @"multipart/form-data; boundary=BOUNDARY", @"The content type should carry the boundary");
+	STAssertEquals(body.contentLength, (unsigned long long)expected.length, @"The content length should count the file without reading it");
+	STAssertEqualObjects([self contentsOfStream:[body inputStream]], expected, @"Parts should be sent in order, each closed by CRLF, then the closing boundary");
+}
+
+- (void)testEachStreamSendsTheWholeBody {
+	AIMultipartFormBody *body = [[[AIMultipartFormBody alloc] init] autorelease];
+
+	[body addFileAtPath:filePath name:@"image" fileName:@"image" contentType:@"image/png"];
+
+	NSData *first = [self contentsOfStream:[body inputStream]];
+	NSData *second = [self contentsOfStream:[body inputStream]];
+
+	STAssertTrue(body.boundary.length > 0, @"A boundary should be made up");
+	STAssertEquals((unsigned long long)first.length, body.contentLength, @"The whole body should be streamed");
+	STAssertEqualObjects(first, second, @"A second stream should start over from the beginning");
+}
+
+- (void)testFieldsWithoutFiles {
+	AIMultipartFormBody *body = [[[AIMultipartFormBody alloc] initWithBoundary:@"b"] autorelease];
+
+	[body addFieldWithName:@"name" value:@"Adium"];
+
+	STAssertEqualObjects([self contentsOfStream:[body inputStream]],
+						 [self dataWithString:@"--b\r\nContent-Disposition: form-data; name=\"name\"\r\n\r\nAdium\r\n--b--\r\n"],
+						 @"A body of fields alone should still be closed");
+}
+
+@end
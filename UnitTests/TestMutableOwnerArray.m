@@ -0,0 +1,183 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#import "TestMutableOwnerArray.h"
+
+#import <AIUtilities/AIMutableOwnerArray.h>
+
+@interface TestMutableOwnerArrayDelegate : NSObject {
+@public
+	NSMutableArray *calls;
+}
+@end
+
+@implementation TestMutableOwnerArrayDelegate
+- (id)init {
+	if ((self = [super init])) calls = [[NSMutableArray alloc] init];
+	return self;
+}
+- (void)dealloc {
+	[calls release];
+	[super dealloc];
+}
+- (void)mutableOwnerArray:(AIMutableOwnerArray *)inArray didSetObject:(id)anObject withOwner:(id)inOwner priorityLevel:(float)priority {
+	[calls addObject:[NSString stringWithFormat:@"%@ %@ %g", inOwner, anObject, priority]];
+}
+@end
+
+@implementation TestMutableOwnerArray
+
+- (void)testHighestPriorityWins {
+	AIMutableOwnerArray *array = [[[AIMutableOwnerArray alloc] init] autorelease];
+	STAssertNil(array.objectValue, @"An empty owner array should have no object value");
+
+	[array setObject:@"medium" withOwner:@"A"];
+	[array setObject:@"high" withOwner:@"B" priorityLevel:High_Priority];
+	[array setObject:@"low" withOwner:@"C" priorityLevel:Low_Priority];
+	STAssertEqualObjects(array.objectValue, @"high", @"The highest priority object should win");
+
+	//Ties go to the earliest object
+	[array setObject:@"also high" withOwner:@"D" priorityLevel:High_Priority];
+	STAssertEqualObjects(array.objectValue, @"high", @"The earlier of two equally high priority objects should win");
+
+	[array setObject:@"highest" withOwner:@"E" priorityLevel:Highest_Priority];
+	STAssertEqualObjects(array.objectValue, @"highest", @"A newly set higher priority object should win");
+
+	//Out of range priorities are treated as medium
+	[array setObject:@"out of range" withOwner:@"F" priorityLevel:-1.0f];
+	STAssertEquals([array priorityOfObjectWithOwner:@"F"], Medium_Priority, @"Out of range priorities should become Medium_Priority");
+}
+
+- (void)testSettingReplacesOwnersObject {
+	AIMutableOwnerArray *array = [[[AIMutableOwnerArray alloc] init] autorelease];
+
+	[array setObject:@"first" withOwner:@"A" priorityLevel:Low_Priority];
+	[array setObject:@"second" withOwner:@"A" priorityLevel:High_Priority];
+	STAssertEquals(array.count, (NSUInteger)1, @"An owner should only own one object");
+	STAssertEqualObjects([array objectWithOwner:@"A"], @"second", @"Setting again should replace the owner's object");
+	STAssertEquals([array priorityOfObjectWithOwner:@"A"], High_Priority, @"Setting again should replace the owner's priority");
+	STAssertEqualObjects([array ownerWithObject:@"second"], @"A", @"The owner should be found by its object");
+	STAssertEquals([array priorityOfObject:@"second"], High_Priority, @"The priority should be found by the object");
+	STAssertNil([array ownerWithObject:@"first"], @"The replaced object should be gone");
+}
+
+- (void)testSettingNilRemoves {
+	AIMutableOwnerArray *array = [[[AIMutableOwnerArray alloc] init] autorelease];
+
+	[array setObject:@"a" withOwner:@"A" priorityLevel:High_Priority];
+	[array setObject:@"b" withOwner:@"B" priorityLevel:Low_Priority];
+	STAssertEqualObjects(array.objectValue, @"a", @"The highest priority object should win");
+
+	[array setObject:nil withOwner:@"A"];
+	STAssertEquals(array.count, (NSUInteger)1, @"Setting nil should remove the owner's object");
+	STAssertNil([array objectWithOwner:@"A"], @"Setting nil should remove the owner's object");
+	STAssertEqualObjects(array.objectValue, @"b", @"The remaining object should win");
+
+	[array setObject:nil withOwner:@"B"];
+	[array setObject:nil withOwner:@"Nobody"];
+	STAssertEquals(array.count, (NSUInteger)0, @"The array should be empty");
+	STAssertNil(array.objectValue, @"An emptied owner array should have no object value");
+	STAssertEquals([array priorityOfObjectWithOwner:@"B"], 0.0f, @"A missing owner should have priority 0");
+}
+
+- (void)testOwnersAreComparedWithIsEqual {
+	AIMutableOwnerArray *array = [[[AIMutableOwnerArray alloc] init] autorelease];
+	NSString *owner = [NSString stringWithFormat:@"%@", @"Owner"];
+	NSString *equalOwner = [NSMutableString stringWithString:@"Owner"];
+
+	[array setObject:@"first" withOwner:owner];
+	[array setObject:@"second" withOwner:equalOwner];
+	STAssertEquals(array.count, (NSUInteger)1, @"Equal owners should be the same owner");
+	STAssertEqualObjects([array objectWithOwner:@"Owner"], @"second", @"An equal owner should find the object");
+}
+
+- (void)testGrowsPastInlineStorageAndShrinksBack {
+	AIMutableOwnerArray *array = [[[AIMutableOwnerArray alloc] init] autorelease];
+	NSUInteger i, count = OWNER_ARRAY_INLINE_CAPACITY * 8;
+
+	for (i = 0; i < count; i++) {
+		[array setObject:[NSNumber numberWithUnsignedInteger:i]
+			   withOwner:[NSString stringWithFormat:@"%lu", (unsigned long)i]
+		   priorityLevel:(i == count / 2 ? Highest_Priority : Low_Priority)];
+	}
+	STAssertEquals(array.count, count, @"Every owner's object should be kept");
+	STAssertEqualObjects(array.objectValue, [NSNumber numberWithUnsignedInteger:count / 2], @"The highest priority object should win");
+	for (i = 0; i < count; i++) {
+		STAssertEqualObjects([array objectWithOwner:[NSString stringWithFormat:@"%lu", (unsigned long)i]],
+							 [NSNumber numberWithUnsignedInteger:i], @"Each owner should still own its object");
+	}
+
+	for (i = 0; i < count - 1; i++) {
+		[array setObject:nil withOwner:[NSString stringWithFormat:@"%lu", (unsigned long)i]];
+	}
+	STAssertEquals(array.count, (NSUInteger)1, @"Only the last object should be left");
+	STAssertEqualObjects(array.objectValue, [NSNumber numberWithUnsignedInteger:count - 1], @"The last object should be left");
+}
+
+- (void)testValueAccessors {
+	AIMutableOwnerArray *array = [[[AIMutableOwnerArray alloc] init] autorelease];
+	NSDate *earlier = [NSDate dateWithTimeIntervalSinceReferenceDate:1000.0];
+	NSDate *later = [NSDate dateWithTimeIntervalSinceReferenceDate:2000.0];
+
+	[array setObject:[NSNumber numberWithInteger:3] withOwner:@"A"];
+	[array setObject:[NSNumber numberWithInteger:7] withOwner:@"B"];
+	[array setObject:[NSNumber numberWithInteger:5] withOwner:@"C"];
+	STAssertEquals(array.intValue, (NSInteger)7, @"intValue should be the largest value");
+	STAssertEqualObjects(array.numberValue, [NSNumber numberWithInteger:7], @"numberValue should be the largest value");
+	STAssertEquals(array.doubleValue, 7.0, @"doubleValue should be the largest value");
+
+	AIMutableOwnerArray *dates = [[[AIMutableOwnerArray alloc] init] autorelease];
+	[dates setObject:later withOwner:@"A"];
+	[dates setObject:earlier withOwner:@"B"];
+	STAssertEqualObjects(dates.date, earlier, @"date should be the earliest date");
+}
+
+- (void)testFastEnumeration {
+	AIMutableOwnerArray *array = [[[AIMutableOwnerArray alloc] init] autorelease];
+	NSMutableSet *expected = [NSMutableSet set];
+
+	for (NSUInteger i = 0; i < 20; i++) {
+		NSNumber *number = [NSNumber numberWithUnsignedInteger:i];
+		[array setObject:number withOwner:number];
+		[expected addObject:number];
+	}
+
+	NSMutableSet *enumerated = [NSMutableSet set];
+	for (id object in array) {
+		[enumerated addObject:object];
+	}
+	STAssertEqualObjects(enumerated, expected, @"Fast enumeration should return every object");
+	STAssertEqualObjects([NSSet setWithArray:array.allValues], expected, @"allValues should return every object");
+	STAssertEqualObjects([NSSet setWithArray:[array.objectEnumerator allObjects]], expected, @"objectEnumerator should return every object");
+}
+
+- (void)testDelegateIsToldOfEverySet {
+	AIMutableOwnerArray *array = [[[AIMutableOwnerArray alloc] init] autorelease];
+	TestMutableOwnerArrayDelegate *delegate = [[[TestMutableOwnerArrayDelegate alloc] init] autorelease];
+	array.delegate = delegate;
+
+	[array setObject:@"a" withOwner:@"A" priorityLevel:High_Priority];
+	[array setObject:@"b" withOwner:@"A" priorityLevel:Low_Priority];
+	[array setObject:nil withOwner:@"A"];
+
+	NSArray *expected = [NSArray arrayWithObjects:
+						 [NSString stringWithFormat:@"A a %g", High_Priority],
+						 [NSString stringWithFormat:@"A b %g", Low_Priority],
+						 [NSString stringWithFormat:@"A (null) %g", Medium_Priority],
+						 nil];
+	STAssertEqualObjects(delegate->calls, expected, @"The delegate should be told of every set, removals included");
+}
+
+@end
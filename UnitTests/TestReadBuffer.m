@@ -0,0 +1,275 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestReadBuffer.h"
+
+#import "AWEzvReadBuffer.h"
+#import <unistd.h>
+
+//Matches AWEzvReadBuffer's own segment size, so tests can put bytes either side of a boundary
+#define READ_SEGMENT_SIZE		(16 * 1024)
+//Small enough for a pipe to take in one write
+#define MAX_WRITE_LENGTH		4096
+#define RANDOM_STEP_COUNT		2000
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+static NSData *randomData(NSUInteger length, uint32_t *random)
+{
+	NSMutableData	*data = [NSMutableData dataWithLength:length];
+	unsigned char	*bytes = [data mutableBytes];
+	NSUInteger		i;
+
+	//Letters only, so tests can choose patterns which cannot turn up by chance
+	for (i = 0; i < length; i++) bytes[i] = 'a' + nextRandom(random) % 26;
+
+	return data;
+}
+
+/*!
+ * @brief A buffer holding data, read from a stream a segment at a time
+ */
+static AWEzvReadBuffer *bufferWithData(NSData *data)
+{
+	AWEzvReadBuffer		*buffer = [[[AWEzvReadBuffer alloc] init] autorelease];
+	CFReadStreamRef		stream = CFReadStreamCreateWithBytesNoCopy(kCFAllocatorDefault, [data bytes], [data length], kCFAllocatorNull);
+
+	CFReadStreamOpen(stream);
+	while ([buffer readFromStream:stream] > 0) {}
+	CFReadStreamClose(stream);
+	CFRelease(stream);
+
+	return buffer;
+}
+
+@interface TestReadBuffer ()
+- (void)writeData:(NSData *)data toBuffer:(AWEzvReadBuffer *)buffer;
+@end
+
+@implementation TestReadBuffer
+
+- (void)setUp {
+	int descriptors[2];
+
+	STAssertEquals(pipe(descriptors), 0, @"Could not make a pipe");
+	readDescriptor = descriptors[0];
+	writeDescriptor = descriptors[1];
+}
+
+- (void)tearDown {
+	close(readDescriptor);
+	close(writeDescriptor);
+}
+
+- (void)testReadsAcrossSegments {
+	uint32_t		random = 47;
+	AWEzvReadBuffer	*buffer = [[[AWEzvReadBuffer alloc] init] autorelease];
+	NSMutableData	*written = [NSMutableData data];
+
+	//Enough small writes to fill a few segments
+	while (written.length < 3 * READ_SEGMENT_SIZE + 100) {
+		NSData *data = randomData(1 + nextRandom(&random) % MAX_WRITE_LENGTH, &random);
+		[self writeData:data toBuffer:buffer];
+		[written appendData:data];
+	}
+
+	STAssertEquals(buffer.length, written.length, @"Every byte written should be buffered");
+	STAssertEquals(buffer.byteCount, written.length, @"Every byte written should be counted");
+
+	NSMutableData	*read = [NSMutableData dataWithLength:written.length];
+	STAssertEquals([buffer readBytes:[read mutableBytes] length:read.length], written.length, @"Every byte should be copied out");
+	STAssertEqualObjects(read, written, @"Bytes should come out as they went in");
+	STAssertEquals(buffer.length, (NSUInteger)0, @"Copied bytes should be consumed");
+
+	char byte;
+	STAssertEquals([buffer readBytes:&byte length:1], (NSUInteger)0, @"An empty buffer should copy nothing");
+}
+
+- (void)testFindsDataSpanningSegments {
+	uint32_t		random = 48;
+	NSMutableData	*data = [[randomData(2 * READ_SEGMENT_SIZE + 500, &random) mutableCopy] autorelease];
+	NSData			*terminator = [@"\r\n\r\n" dataUsingEncoding:NSASCIIStringEncoding];
+	NSUInteger		offsets[] = {10, READ_SEGMENT_SIZE - 2, 2 * READ_SEGMENT_SIZE - 1};
+	NSUInteger		i;
+
+	for (i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++) {
+		[data replaceBytesInRange:NSMakeRange(offsets[i], terminator.length) withBytes:[terminator bytes]];
+	}
+
+	AWEzvReadBuffer	*buffer = bufferWithData(data);
+
+	STAssertEquals(buffer.length, data.length, @"The whole stream should be buffered");
+	STAssertEquals([buffer offsetOfData:terminator startingAt:0], offsets[0], @"The first match should be found");
+	STAssertEquals([buffer offsetOfData:terminator startingAt:offsets[0] + 1], offsets[1], @"A match straddling two segments should be found");
+	STAssertEquals([buffer offsetOfData:terminator startingAt:offsets[1] + 1], offsets[2], @"A match ending in the last segment should be found");
+	STAssertEquals([buffer offsetOfData:terminator startingAt:offsets[2] + 1], (NSUInteger)NSNotFound, @"There should be no more matches");
+	STAssertEquals([buffer offsetOfData:[@"\r\n\r\n\r" dataUsingEncoding:NSASCIIStringEncoding] startingAt:0], (NSUInteger)NSNotFound,
+				   @"A pattern running past a match should not be found");
+
+	//Offsets count from what is left after a partial read
+	NSMutableData *read = [NSMutableData data];
+	STAssertEquals([buffer appendBytesOfLength:offsets[1] toData:read], offsets[1], @"Bytes before the second match should be moved");
+	STAssertEqualObjects(read, [data subdataWithRange:NSMakeRange(0, offsets[1])], @"Moved bytes should be the start of the stream");
+	STAssertEquals([buffer offsetOfData:terminator startingAt:0], (NSUInteger)0, @"The straddling match should now be first");
+	STAssertEquals([buffer offsetOfData:terminator startingAt:1], offsets[2] - offsets[1], @"Later matches should move up");
+}
+
+- (void)testConsumesSlicesInOrder {
+	uint32_t			random = 49;
+	NSData				*data = randomData(2 * READ_SEGMENT_SIZE + 1234, &random);
+	AWEzvReadBuffer		*buffer = bufferWithData(data);
+	NSMutableData		*consumed = [NSMutableData data];
+	__block NSUInteger	sliceCount = 0;
+
+	//Drop the first few bytes so the first slice starts part way into a segment
+	char skipped[7];
+	[buffer readBytes:skipped length:sizeof(skipped)];
+
+	[buffer consumeSlicesUsingBlock:^(const unsigned char *bytes, NSUInteger sliceLength) {
+		STAssertTrue(sliceLength > 0, @"Empty slices should not be passed on");
+		[consumed appendBytes:bytes length:sliceLength];
+		sliceCount++;
+	}];
+
+	STAssertEqualObjects(consumed, [data subdataWithRange:NSMakeRange(sizeof(skipped), data.length - sizeof(skipped))],
+						 @"Slices should make up the rest of the stream in order");
+	STAssertEquals(sliceCount, (NSUInteger)3, @"Each segment should be passed as one slice");
+	STAssertEquals(buffer.length, (NSUInteger)0, @"Everything should be consumed");
+}
+
+- (void)testStreamEndLeavesNoEmptySegment {
+	uint32_t		random = 50;
+	NSData			*data = randomData(READ_SEGMENT_SIZE, &random);
+	AWEzvReadBuffer	*buffer = bufferWithData(data);
+	NSUInteger		readCallCount = buffer.readCallCount;
+
+	//The segment is full, so the read at end of stream had to add one; it should have gone again
+	__block NSUInteger	sliceCount = 0;
+	[buffer consumeSlicesUsingBlock:^(const unsigned char *bytes, NSUInteger sliceLength) {
+		sliceCount++;
+	}];
+	STAssertEquals(sliceCount, (NSUInteger)1, @"Only the full segment should be left");
+	STAssertEquals(readCallCount, (NSUInteger)2, @"One read for the data and one for the end");
+
+	buffer = bufferWithData([NSData data]);
+	STAssertEquals(buffer.length, (NSUInteger)0, @"An empty stream should buffer nothing");
+	[buffer consumeSlicesUsingBlock:^(const unsigned char *bytes, NSUInteger sliceLength) {
+		STFail(@"An empty stream should leave no slices");
+	}];
+}
+
+- (void)testSegmentsReused {
+	uint32_t		random = 51;
+	AWEzvReadBuffer	*buffer = [[[AWEzvReadBuffer alloc] init] autorelease];
+	NSMutableData	*read = [NSMutableData data];
+	NSUInteger		i, allocationCount = 0;
+
+	for (i = 0; i < 50; i++) {
+		[self writeData:randomData(MAX_WRITE_LENGTH, &random) toBuffer:buffer];
+		[buffer appendBytesOfLength:buffer.length toData:read];
+
+		if (i == 0) allocationCount = buffer.segmentAllocationCount;
+	}
+
+	STAssertTrue(allocationCount > 0, @"The first read should allocate segments");
+	STAssertEquals(buffer.segmentAllocationCount, allocationCount, @"Once warmed up, reads which keep up should not allocate");
+	STAssertEquals(read.length, (NSUInteger)(50 * MAX_WRITE_LENGTH), @"Every byte should have been read");
+
+	[buffer removeAllBytes];
+	STAssertEquals(buffer.length, (NSUInteger)0, @"Removing all bytes should empty the buffer");
+}
+
+- (void)testRandomReadsMatchCopy {
+	uint32_t		random = 52;
+	AWEzvReadBuffer	*buffer = [[[AWEzvReadBuffer alloc] init] autorelease];
+	NSMutableData	*expected = [NSMutableData data];
+	NSData			*pattern = [@"</" dataUsingEncoding:NSASCIIStringEncoding];
+	NSUInteger		step;
+
+	for (step = 0; step < RANDOM_STEP_COUNT; step++) {
+		NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+		uint32_t			action = nextRandom(&random) % 10;
+
+		if (action < 4) {
+			NSMutableData *data = [[randomData(1 + nextRandom(&random) % MAX_WRITE_LENGTH, &random) mutableCopy] autorelease];
+			if (data.length > 2 && nextRandom(&random) % 2) {
+				[data replaceBytesInRange:NSMakeRange(nextRandom(&random) % (data.length - 1), 2) withBytes:[pattern bytes]];
+			}
+			[self writeData:data toBuffer:buffer];
+			[expected appendData:data];
+
+		} else if (action < 6) {
+			NSUInteger		count = nextRandom(&random) % (2 * MAX_WRITE_LENGTH);
+			NSMutableData	*read = [NSMutableData dataWithLength:count];
+			NSUInteger		copied = [buffer readBytes:[read mutableBytes] length:count];
+
+			STAssertEquals(copied, MIN(count, expected.length), @"Step %lu: the wrong number of bytes was copied", (unsigned long)step);
+			[read setLength:copied];
+			STAssertEqualObjects(read, [expected subdataWithRange:NSMakeRange(0, copied)], @"Step %lu: the wrong bytes were copied", (unsigned long)step);
+			[expected replaceBytesInRange:NSMakeRange(0, copied) withBytes:NULL length:0];
+
+		} else if (action < 7) {
+			NSMutableData	*read = [NSMutableData dataWithData:pattern];
+			NSUInteger		count = nextRandom(&random) % (2 * MAX_WRITE_LENGTH);
+			NSUInteger		moved = [buffer appendBytesOfLength:count toData:read];
+
+			STAssertEquals(moved, MIN(count, expected.length), @"Step %lu: the wrong number of bytes was moved", (unsigned long)step);
+			STAssertEqualObjects([read subdataWithRange:NSMakeRange(pattern.length, moved)], [expected subdataWithRange:NSMakeRange(0, moved)],
+								 @"Step %lu: the wrong bytes were moved", (unsigned long)step);
+			[expected replaceBytesInRange:NSMakeRange(0, moved) withBytes:NULL length:0];
+
+		} else if (action < 8) {
+			NSMutableData *consumed = [NSMutableData data];
+			[buffer consumeSlicesUsingBlock:^(const unsigned char *bytes, NSUInteger sliceLength) {
+				[consumed appendBytes:bytes length:sliceLength];
+			}];
+			STAssertEqualObjects(consumed, expected, @"Step %lu: the wrong slices were consumed", (unsigned long)step);
+			[expected setLength:0];
+
+		} else {
+			NSUInteger	start = (expected.length ? nextRandom(&random) % expected.length : 0);
+			NSRange		range = (start < expected.length ?
+								 [expected rangeOfData:pattern options:0 range:NSMakeRange(start, expected.length - start)] :
+								 NSMakeRange(NSNotFound, 0));
+
+			STAssertEquals([buffer offsetOfData:pattern startingAt:start], range.location,
+						   @"Step %lu: the pattern was found in the wrong place", (unsigned long)step);
+		}
+
+		STAssertEquals(buffer.length, expected.length, @"Step %lu: the wrong number of bytes is buffered", (unsigned long)step);
+
+		[pool release];
+	}
+}
+
+/*!
+ * @brief Write data into the pipe and read all of it into buffer
+ */
+- (void)writeData:(NSData *)data toBuffer:(AWEzvReadBuffer *)buffer {
+	NSUInteger	length = buffer.length;
+
+	STAssertEquals(write(writeDescriptor, [data bytes], data.length), (ssize_t)data.length, @"Could not write to the pipe");
+
+	while (buffer.length < length + data.length) {
+		STAssertTrue([buffer readFromFileDescriptor:readDescriptor] > 0, @"Could not read from the pipe");
+	}
+}
+
+@end
@@ -0,0 +1,436 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestReconnectScheduler.h"
+
+#import <Adium/AIReconnectScheduler.h>
+
+#define SIMULATED_CLIENT_COUNT		40
+#define SIMULATED_SERVICE_COUNT		3
+#define SIMULATED_STEP_COUNT		2000
+#define SIMULATED_CONCURRENT		3
+#define SIMULATED_INTERVAL			1.0
+#define SIMULATED_TIMEOUT			30.0
+#define SIMULATED_MINIMUM_DELAY		5.0
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+/*!
+ * @brief Simulated time; the tests advance it and wake the scheduler when it asked to be
+ */
+@interface TestReconnectClock : NSObject <AIReconnectSchedulerClock> {
+@public
+	NSTimeInterval	time;
+	NSTimeInterval	wakeTime;
+}
+@end
+
+@implementation TestReconnectClock
+- (NSTimeInterval)currentTime {
+	return time;
+}
+- (void)wakeScheduler:(AIReconnectScheduler *)scheduler atTime:(NSTimeInterval)inTime {
+	wakeTime = inTime;
+}
+@end
+
+/*!
+ * @brief A client which notes when the scheduler starts it
+ */
+@interface TestReconnectClient : NSObject <AIReconnectSchedulerClient> {
+@public
+	NSString			*service;
+	NSString			*host;
+	TestReconnectClock	*clock;
+	NSMutableArray		*startedClients;
+	NSTimeInterval		performedTime;
+
+	//Kept by the simulation
+	BOOL				online;
+	BOOL				connecting;
+	NSTimeInterval		dueTime;
+	NSTimeInterval		startTime;
+}
++ (TestReconnectClient *)clientWithService:(NSString *)service host:(NSString *)host clock:(TestReconnectClock *)clock startedClients:(NSMutableArray *)startedClients;
+@end
+
+@implementation TestReconnectClient
++ (TestReconnectClient *)clientWithService:(NSString *)inService host:(NSString *)inHost clock:(TestReconnectClock *)inClock startedClients:(NSMutableArray *)inStartedClients {
+	TestReconnectClient *client = [[[self alloc] init] autorelease];
+	client->service = [inService copy];
+	client->host = [inHost copy];
+	client->clock = inClock;
+	client->startedClients = inStartedClients;
+	return client;
+}
+- (void)dealloc {
+	[service release];
+	[host release];
+	[super dealloc];
+}
+- (NSString *)reconnectServiceIdentifier {
+	return service;
+}
+- (NSString *)reconnectHost {
+	return host;
+}
+- (void)performScheduledReconnect {
+	performedTime = clock->time;
+	[startedClients addObject:self];
+}
+- (void)setScheduledReconnectDate:(NSDate *)date {}
+- (void)notifyOfScheduledReconnectDate {}
+@end
+
+@interface TestReconnectScheduler ()
+- (void)runUntil:(NSTimeInterval)time;
+- (void)checkStartsAgainstClients:(NSArray *)clients unreachableHosts:(NSSet *)unreachableHosts
+			   lastStartByService:(NSMutableDictionary *)lastStartByService;
+@end
+
+@implementation TestReconnectScheduler
+
+- (void)setUp {
+	clock = [[TestReconnectClock alloc] init];
+	clock->time = 1000.0;
+	scheduler = [[AIReconnectScheduler alloc] initWithClock:clock];
+	[scheduler setRandomSeed:1];
+	startedClients = [[NSMutableArray alloc] init];
+}
+
+- (void)tearDown {
+	//Sends the notifications the scheduler has queued for the end of the run loop pass, which retains it until then
+	[scheduler flushClientNotifications];
+	[scheduler release]; scheduler = nil;
+	[clock release]; clock = nil;
+	[startedClients release]; startedClients = nil;
+}
+
+/*!
+ * @brief Advance simulated time, waking the scheduler each time it asked to be woken on the way
+ */
+- (void)runUntil:(NSTimeInterval)time {
+	while (clock->wakeTime && clock->wakeTime <= time) {
+		clock->time = MAX(clock->time, clock->wakeTime);
+		clock->wakeTime = 0;
+		[scheduler clockDidReachWakeTime];
+	}
+	clock->time = MAX(clock->time, time);
+}
+
+- (void)testDelaysAreJitteredWithinBounds {
+	TestReconnectClient	*client = [TestReconnectClient clientWithService:@"Test" host:nil clock:clock startedClients:startedClients];
+	NSTimeInterval		previousDelay = 0;
+	NSMutableSet		*delays = [NSMutableSet set];
+
+	scheduler.maximumDelay = 120;
+	for (NSUInteger i = 0; i < 100; i++) {
+		NSTimeInterval delay = [scheduler scheduleReconnectForClient:client minimumDelay:5];
+
+		STAssertTrue(delay >= 5, @"Attempt %lu waited %f, less than the minimum delay", (unsigned long)i, delay);
+		STAssertTrue(delay <= MAX(previousDelay, 5) * 3, @"Attempt %lu waited %f, more than three times the last delay %f", (unsigned long)i, delay, previousDelay);
+		STAssertTrue(delay <= 120, @"Attempt %lu waited %f, more than the maximum delay", (unsigned long)i, delay);
+		[delays addObject:[NSNumber numberWithDouble:delay]];
+		previousDelay = delay;
+	}
+	STAssertTrue(delays.count > 10, @"Delays should vary, not settle on one value");
+	STAssertEquals(startedClients.count, (NSUInteger)0, @"Nothing should start before time passes");
+
+	[scheduler clientDidConnect:client];
+	STAssertTrue([scheduler scheduleReconnectForClient:client minimumDelay:5] <= 15, @"Connecting should start the delays over");
+}
+
+- (void)testSameSeedSameDelays {
+	TestReconnectClient		*client = [TestReconnectClient clientWithService:@"Test" host:nil clock:clock startedClients:startedClients];
+	TestReconnectClock		*otherClock = [[[TestReconnectClock alloc] init] autorelease];
+	AIReconnectScheduler	*other = [[[AIReconnectScheduler alloc] initWithClock:otherClock] autorelease];
+
+	[other setRandomSeed:1];
+	for (NSUInteger i = 0; i < 20; i++) {
+		STAssertEquals([scheduler scheduleReconnectForClient:client minimumDelay:5], [other scheduleReconnectForClient:client minimumDelay:5],
+					   @"Attempt %lu should wait the same with the same seed", (unsigned long)i);
+	}
+	[other cancelReconnectForClient:client];
+	[other flushClientNotifications];
+}
+
+- (void)testConcurrentConnectionsLimited {
+	NSMutableArray *clients = [NSMutableArray array];
+
+	scheduler.maximumConcurrentConnections = 2;
+	scheduler.minimumIntervalBetweenConnects = 0;
+	for (NSUInteger i = 0; i < 5; i++) {
+		TestReconnectClient *client = [TestReconnectClient clientWithService:@"Test" host:nil clock:clock startedClients:startedClients];
+		[clients addObject:client];
+		[scheduler scheduleReconnectForClient:client afterDelay:i * 0.1];
+	}
+
+	[self runUntil:clock->time + 1];
+	STAssertEqualObjects(startedClients, [clients subarrayWithRange:NSMakeRange(0, 2)], @"Only two clients should connect at once, oldest first");
+	STAssertEquals(scheduler.connectionCount, (NSUInteger)2, @"Two connections should be counted");
+
+	[scheduler clientDidConnect:[clients objectAtIndex:0]];
+	STAssertEqualObjects([startedClients lastObject], [clients objectAtIndex:2], @"A finished connection should let the next client start");
+
+	[scheduler scheduleReconnectForClient:[clients objectAtIndex:1] minimumDelay:60];
+	STAssertEqualObjects([startedClients lastObject], [clients objectAtIndex:3], @"A failed connection should let the next client start");
+	STAssertEquals(startedClients.count, (NSUInteger)4, @"Only one client should start for each place freed");
+	STAssertTrue([scheduler isSchedulingClient:[clients objectAtIndex:1]], @"A client which failed is scheduled again");
+	STAssertFalse([scheduler isSchedulingClient:[clients objectAtIndex:0]], @"A client which connected is forgotten");
+}
+
+- (void)testConnectsToOneServiceSpacedOut {
+	NSMutableArray	*clients = [NSMutableArray array];
+	NSTimeInterval	start = clock->time;
+
+	scheduler.minimumIntervalBetweenConnects = 0;
+	[scheduler setMinimumInterval:2.0 betweenConnectsForService:@"Slow"];
+	for (NSUInteger i = 0; i < 3; i++) {
+		TestReconnectClient *client = [TestReconnectClient clientWithService:@"Slow" host:nil clock:clock startedClients:startedClients];
+		[clients addObject:client];
+		[scheduler scheduleReconnectForClient:client afterDelay:0];
+	}
+	TestReconnectClient *other = [TestReconnectClient clientWithService:@"Other" host:nil clock:clock startedClients:startedClients];
+	[scheduler scheduleReconnectForClient:other afterDelay:0];
+
+	STAssertEqualObjects(startedClients, ([NSArray arrayWithObjects:[clients objectAtIndex:0], other, nil]),
+						 @"One client per service should start at once; other services aren't held up");
+
+	[self runUntil:start + 1.9];
+	STAssertEquals(startedClients.count, (NSUInteger)2, @"The next client of the service should wait out the interval");
+	[self runUntil:start + 2];
+	STAssertEqualObjects([startedClients lastObject], [clients objectAtIndex:1], @"The next client should start once the interval passes");
+	[self runUntil:start + 4];
+	STAssertEqualObjects([startedClients lastObject], [clients objectAtIndex:2], @"And the next after another interval");
+}
+
+- (void)testUnreachableHostHoldsClients {
+	TestReconnectClient *client = [TestReconnectClient clientWithService:@"Test" host:@"Chat.Example.com" clock:clock startedClients:startedClients];
+	TestReconnectClient *later = [TestReconnectClient clientWithService:@"Test" host:@"chat.example.com" clock:clock startedClients:startedClients];
+	TestReconnectClient *elsewhere = [TestReconnectClient clientWithService:@"Test" host:@"other.example.com" clock:clock startedClients:startedClients];
+
+	scheduler.minimumIntervalBetweenConnects = 0;
+	scheduler.connectSpread = 5;
+	[scheduler setHost:@"chat.example.com" reachable:NO];
+	[scheduler scheduleReconnectForClient:client afterDelay:10];
+	[scheduler scheduleReconnectForClient:elsewhere afterDelay:20];
+	[scheduler scheduleReconnectForClient:later afterDelay:500];
+
+	[self runUntil:clock->time + 100];
+	STAssertEqualObjects(startedClients, [NSArray arrayWithObject:elsewhere], @"A client whose host is unreachable should wait; hosts compare case-insensitively");
+
+	NSTimeInterval reachableTime = clock->time;
+	[scheduler setHost:@"CHAT.example.com" reachable:YES];
+	STAssertTrue([startedClients containsObject:client], @"A client which was due should connect as soon as its host is reachable");
+
+	[self runUntil:reachableTime + 5];
+	STAssertTrue([startedClients containsObject:later], @"A client due later should connect within the connect spread instead");
+	STAssertEquals(startedClients.count, (NSUInteger)3, @"Each client should connect once");
+}
+
+- (void)testConnectionTimeoutFreesPlace {
+	TestReconnectClient *slow = [TestReconnectClient clientWithService:@"Test" host:nil clock:clock startedClients:startedClients];
+	TestReconnectClient *next = [TestReconnectClient clientWithService:@"Test" host:nil clock:clock startedClients:startedClients];
+
+	scheduler.maximumConcurrentConnections = 1;
+	scheduler.minimumIntervalBetweenConnects = 0;
+	scheduler.connectionTimeout = 60;
+	[scheduler scheduleReconnectForClient:slow afterDelay:0];
+	[scheduler scheduleReconnectForClient:next afterDelay:0];
+	STAssertEqualObjects(startedClients, [NSArray arrayWithObject:slow], @"Only one client should connect at once");
+
+	[self runUntil:clock->time + 59];
+	STAssertEquals(startedClients.count, (NSUInteger)1, @"The connection should hold its place until it times out");
+	[self runUntil:clock->time + 1];
+	STAssertEqualObjects([startedClients lastObject], next, @"A timed out connection should let the next client start");
+	STAssertEquals(scheduler.connectionCount, (NSUInteger)1, @"The timed out connection should no longer be counted");
+	STAssertTrue([scheduler isSchedulingClient:slow], @"A timed out client is still known, though no longer waiting");
+}
+
+- (void)testCancelledClientNeverConnects {
+	TestReconnectClient *client = [TestReconnectClient clientWithService:@"Test" host:nil clock:clock startedClients:startedClients];
+
+	[scheduler scheduleReconnectForClient:client minimumDelay:5];
+	STAssertTrue([scheduler isSchedulingClient:client], @"The client should be scheduled");
+	[scheduler cancelReconnectForClient:client];
+	STAssertFalse([scheduler isSchedulingClient:client], @"The client should be forgotten");
+
+	[self runUntil:clock->time + 1000];
+	STAssertEquals(startedClients.count, (NSUInteger)0, @"A cancelled client should never connect");
+	STAssertEquals(clock->wakeTime, (NSTimeInterval)0, @"Nothing is left to wake the scheduler for");
+}
+
+/*!
+ * @brief Check each client started since the last check against the scheduler's limits, and mark it connecting
+ */
+- (void)checkStartsAgainstClients:(NSArray *)clients unreachableHosts:(NSSet *)unreachableHosts
+			   lastStartByService:(NSMutableDictionary *)lastStartByService {
+	for (TestReconnectClient *client in startedClients) {
+		NSTimeInterval	now = client->performedTime;
+		NSUInteger		connections = 0;
+		NSNumber		*lastStart = [lastStartByService objectForKey:client->service];
+
+		for (TestReconnectClient *other in clients) {
+			if (other->connecting && other->startTime + SIMULATED_TIMEOUT > now) connections++;
+		}
+
+		STAssertFalse(client->online, @"%@ started while online", client->host);
+		STAssertFalse(client->connecting && client->startTime + SIMULATED_TIMEOUT > now, @"%@ started while still connecting", client->host);
+		STAssertTrue(connections < SIMULATED_CONCURRENT, @"%@ started with %lu connections going", client->host, (unsigned long)connections);
+		STAssertTrue(now >= client->dueTime, @"%@ started at %f, before it was due at %f", client->host, now, client->dueTime);
+		STAssertFalse([unreachableHosts containsObject:client->host], @"%@ started while its host was unreachable", client->host);
+		STAssertTrue(!lastStart || now - [lastStart doubleValue] >= SIMULATED_INTERVAL - 0.0001,
+					 @"%@ started %f after the last connect to its service", client->host, now - [lastStart doubleValue]);
+
+		client->connecting = YES;
+		client->startTime = now;
+		[lastStartByService setObject:[NSNumber numberWithDouble:now] forKey:client->service];
+	}
+
+	[startedClients removeAllObjects];
+}
+
+/*!
+ * @brief Replay random failures, connections and reachability changes, checking every start against the limits
+ *
+ * Once the network settles and every attempt succeeds, every client should get online.
+ */
+- (void)testRandomSimulationKeepsLimits {
+	NSMutableArray		*clients = [NSMutableArray array];
+	NSMutableSet		*unreachableHosts = [NSMutableSet set];
+	NSMutableDictionary	*lastStartByService = [NSMutableDictionary dictionary];
+	uint32_t			seed = 1;
+
+	scheduler.maximumConcurrentConnections = SIMULATED_CONCURRENT;
+	scheduler.minimumIntervalBetweenConnects = SIMULATED_INTERVAL;
+	scheduler.connectionTimeout = SIMULATED_TIMEOUT;
+	scheduler.maximumDelay = 300;
+
+	for (NSUInteger i = 0; i < SIMULATED_CLIENT_COUNT; i++) {
+		TestReconnectClient *client = [TestReconnectClient clientWithService:[NSString stringWithFormat:@"service%lu", (unsigned long)(i % SIMULATED_SERVICE_COUNT)]
+																		host:[NSString stringWithFormat:@"host%lu", (unsigned long)(i % (SIMULATED_SERVICE_COUNT + 1))]
+															  clock:clock startedClients:startedClients];
+		[clients addObject:client];
+		client->dueTime = clock->time;
+		[scheduler scheduleConnectForClient:client];
+		[self checkStartsAgainstClients:clients unreachableHosts:unreachableHosts lastStartByService:lastStartByService];
+	}
+
+	for (NSUInteger step = 0; step < SIMULATED_STEP_COUNT; step++) {
+		TestReconnectClient	*client = [clients objectAtIndex:nextRandom(&seed) % SIMULATED_CLIENT_COUNT];
+		NSString			*host = [NSString stringWithFormat:@"host%lu", (unsigned long)(nextRandom(&seed) % (SIMULATED_SERVICE_COUNT + 1))];
+
+		[self runUntil:clock->time + (nextRandom(&seed) % 1000) / 100.0];
+		[self checkStartsAgainstClients:clients unreachableHosts:unreachableHosts lastStartByService:lastStartByService];
+
+		switch (nextRandom(&seed) % 6) {
+			case 0:
+			case 1:
+				//A connection attempt finishes, either way
+				if (client->connecting) {
+					client->connecting = NO;
+					if (nextRandom(&seed) % 2) {
+						client->online = YES;
+						[scheduler clientDidConnect:client];
+					} else {
+						client->dueTime = clock->time + SIMULATED_MINIMUM_DELAY;
+						[scheduler scheduleReconnectForClient:client minimumDelay:SIMULATED_MINIMUM_DELAY];
+					}
+				}
+				break;
+			case 2:
+				//An online client drops
+				if (client->online) {
+					client->online = NO;
+					client->dueTime = clock->time + SIMULATED_MINIMUM_DELAY;
+					[scheduler scheduleReconnectForClient:client minimumDelay:SIMULATED_MINIMUM_DELAY];
+				}
+				break;
+			case 3:
+				//A host goes away or comes back
+				if ([unreachableHosts containsObject:host]) {
+					[unreachableHosts removeObject:host];
+					for (TestReconnectClient *waiting in clients) {
+						if ([waiting->host isEqualToString:host] && !waiting->connecting) waiting->dueTime = MIN(waiting->dueTime, clock->time);
+					}
+				} else {
+					[unreachableHosts addObject:host];
+				}
+				[scheduler setHost:host reachable:![unreachableHosts containsObject:host]];
+				break;
+			case 4:
+				//The user disconnects a client which isn't online, then connects it again
+				if (!client->online) {
+					client->connecting = NO;
+					client->dueTime = clock->time;
+					[scheduler cancelReconnectForClient:client];
+					[scheduler scheduleConnectForClient:client];
+				}
+				break;
+			case 5:
+				break;
+		}
+		[self checkStartsAgainstClients:clients unreachableHosts:unreachableHosts lastStartByService:lastStartByService];
+	}
+
+	//Settle: every host comes back, and from now on every attempt succeeds at once
+	for (NSString *host in [[unreachableHosts copy] autorelease]) {
+		[unreachableHosts removeObject:host];
+		[scheduler setHost:host reachable:YES];
+	}
+	for (TestReconnectClient *client in clients) {
+		if (client->connecting && client->startTime + SIMULATED_TIMEOUT <= clock->time) {
+			//Its connection timed out; the scheduler is done with it until the client tries again
+			client->connecting = NO;
+			client->dueTime = clock->time;
+			[scheduler scheduleConnectForClient:client];
+		}
+	}
+	[self checkStartsAgainstClients:clients unreachableHosts:unreachableHosts lastStartByService:lastStartByService];
+
+	NSTimeInterval deadline = clock->time + 3600;
+	while (clock->time < deadline) {
+		BOOL connected = NO;
+
+		for (TestReconnectClient *client in clients) {
+			if (client->connecting) {
+				client->connecting = NO;
+				client->online = YES;
+				[scheduler clientDidConnect:client];
+				[self checkStartsAgainstClients:clients unreachableHosts:unreachableHosts lastStartByService:lastStartByService];
+				connected = YES;
+			}
+		}
+
+		if (!connected) {
+			if (!clock->wakeTime) break;
+			[self runUntil:clock->wakeTime];
+			[self checkStartsAgainstClients:clients unreachableHosts:unreachableHosts lastStartByService:lastStartByService];
+		}
+	}
+
+	for (TestReconnectClient *client in clients) {
+		STAssertTrue(client->online, @"%@ (%@) should be online once the network settles", client->host, client->service);
+		STAssertFalse([scheduler isSchedulingClient:client], @"%@ should no longer be scheduled", client->host);
+	}
+	STAssertEquals(scheduler.connectionCount, (NSUInteger)0, @"No connections should be counted once everyone is online");
+}
+
+@end
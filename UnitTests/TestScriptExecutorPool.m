@@ -0,0 +1,287 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#import "TestScriptExecutorPool.h"
+
+#import <AIUtilities/AIScriptExecutorPool.h>
+#import <AIUtilities/AIShellScriptExecutor.h>
+
+/*!
+ * @class TestKeepAliveExecutor
+ * @brief Answers every script at once, and counts how often it is asked to keep alive
+ */
+@interface TestKeepAliveExecutor : NSObject <AIScriptExecutor> {
+	NSUInteger	keepAliveCount;
+}
+@property (readonly, nonatomic) NSUInteger keepAliveCount;
+@end
+
+@implementation TestKeepAliveExecutor
+
+@synthesize keepAliveCount;
+
+- (void)runScriptAtPath:(NSString *)path
+			   function:(NSString *)function
+			  arguments:(NSArray *)arguments
+		notifyingTarget:(id)target
+			   selector:(SEL)selector
+			   userInfo:(id)userInfo
+{
+	[target retain];
+	[userInfo retain];
+	dispatch_async(dispatch_get_main_queue(), ^{
+		[target performSelector:selector withObject:userInfo withObject:@"done"];
+		[target release];
+		[userInfo release];
+	});
+}
+
+- (void)keepAlive
+{
+	keepAliveCount++;
+}
+
+@end
+
+@interface TestScriptExecutorPool ()
+- (NSString *)pathOfScript:(NSString *)name withContents:(NSString *)contents;
+- (AIScriptExecutorPool *)poolWithExecutorCount:(NSUInteger)count;
+- (void)waitForResultCount:(NSUInteger)count timeout:(NSTimeInterval)timeout;
+@end
+
+@implementation TestScriptExecutorPool
+
+- (void)setUp {
+	scriptDirectory = [[NSTemporaryDirectory() stringByAppendingPathComponent:
+						[NSString stringWithFormat:@"TestScriptExecutorPool-%d", getpid()]] retain];
+	[[NSFileManager defaultManager] createDirectoryAtPath:scriptDirectory withIntermediateDirectories:YES attributes:nil error:NULL];
+	results = [[NSMutableArray alloc] init];
+}
+
+- (void)tearDown {
+	[[NSFileManager defaultManager] removeItemAtPath:scriptDirectory error:NULL];
+	[scriptDirectory release]; scriptDirectory = nil;
+	[results release]; results = nil;
+}
+
+- (NSString *)pathOfScript:(NSString *)name withContents:(NSString *)contents {
+	NSString *path = [scriptDirectory stringByAppendingPathComponent:name];
+	[contents writeToFile:path atomically:YES encoding:NSUTF8StringEncoding error:NULL];
+	return path;
+}
+
+- (AIScriptExecutorPool *)poolWithExecutorCount:(NSUInteger)count {
+	NSMutableArray *executors = [NSMutableArray array];
+	while (count--) [executors addObject:[[[AIShellScriptExecutor alloc] init] autorelease]];
+
+	AIScriptExecutorPool *pool = [[[AIScriptExecutorPool alloc] initWithExecutors:executors] autorelease];
+	pool.keepAliveInterval = 0;
+	return pool;
+}
+
+- (void)scriptDidRun:(id)userInfo resultString:(NSString *)resultString {
+	[results addObject:[NSArray arrayWithObjects:userInfo, (resultString ? resultString : (id)[NSNull null]), nil]];
+}
+
+- (void)waitForResultCount:(NSUInteger)count timeout:(NSTimeInterval)timeout {
+	NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:timeout];
+	while (results.count < count && [deadline timeIntervalSinceNow] > 0) {
+		[[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.05]];
+	}
+}
+
+- (void)testResultIsDelivered {
+	AIScriptExecutorPool *pool = [self poolWithExecutorCount:1];
+	NSString *path = [self pathOfScript:@"join.sh" withContents:@"shift; echo \"$1+$2\"\n"];
+
+	[pool runScriptAtPath:path function:@"substitute" arguments:[NSArray arrayWithObjects:@"a", @"b", nil]
+				cacheable:NO timeout:0 notifyingTarget:self selector:@selector(scriptDidRun:resultString:) userInfo:@"join"];
+	STAssertEquals(results.count, (NSUInteger)0, @"The target should be notified asynchronously");
+
+	[self waitForResultCount:1 timeout:10];
+	STAssertEqualObjects(results, [NSArray arrayWithObject:[NSArray arrayWithObjects:@"join", @"a+b", nil]],
+						 @"The script's output should be delivered with the userInfo");
+	[pool invalidate];
+}
+
+- (void)testFailedScriptGivesNil {
+	AIScriptExecutorPool *pool = [self poolWithExecutorCount:1];
+	NSString *path = [self pathOfScript:@"fail.sh" withContents:@"echo partial; exit 3\n"];
+
+	[pool runScriptAtPath:path function:@"substitute" arguments:nil
+				cacheable:NO timeout:0 notifyingTarget:self selector:@selector(scriptDidRun:resultString:) userInfo:@"fail"];
+	[self waitForResultCount:1 timeout:10];
+	STAssertEqualObjects([[results lastObject] lastObject], [NSNull null], @"A failed script should give a nil result");
+	[pool invalidate];
+}
+
+- (void)testCacheableResultsAreReused {
+	AIScriptExecutorPool *pool = [self poolWithExecutorCount:1];
+	NSString *countPath = [scriptDirectory stringByAppendingPathComponent:@"runs"];
+	NSString *path = [self pathOfScript:@"count.sh"
+						   withContents:[NSString stringWithFormat:@"echo x >> '%@'; echo \"$2\"\n", countPath]];
+	NSUInteger i;
+
+	for (i = 0; i < 3; i++) {
+		[pool runScriptAtPath:path function:@"substitute" arguments:[NSArray arrayWithObject:@"same"]
+					cacheable:YES timeout:0 notifyingTarget:self selector:@selector(scriptDidRun:resultString:) userInfo:@"same"];
+		[self waitForResultCount:(i + 1) timeout:10];
+	}
+	[pool runScriptAtPath:path function:@"substitute" arguments:[NSArray arrayWithObject:@"other"]
+				cacheable:YES timeout:0 notifyingTarget:self selector:@selector(scriptDidRun:resultString:) userInfo:@"other"];
+	[self waitForResultCount:4 timeout:10];
+
+	STAssertEquals(results.count, (NSUInteger)4, @"Every request should be answered");
+	STAssertEqualObjects([[results objectAtIndex:2] lastObject], @"same", @"A cached result should be delivered");
+	STAssertEqualObjects([[results objectAtIndex:3] lastObject], @"other", @"Different arguments should not share a result");
+	NSString *runs = [NSString stringWithContentsOfFile:countPath encoding:NSUTF8StringEncoding error:NULL];
+	STAssertEqualObjects(runs, @"x\nx\n", @"The script should only run once per set of arguments");
+
+	[pool flushCachedResults];
+	[pool runScriptAtPath:path function:@"substitute" arguments:[NSArray arrayWithObject:@"same"]
+				cacheable:YES timeout:0 notifyingTarget:self selector:@selector(scriptDidRun:resultString:) userInfo:@"same"];
+	[self waitForResultCount:5 timeout:10];
+	runs = [NSString stringWithContentsOfFile:countPath encoding:NSUTF8StringEncoding error:NULL];
+	STAssertEqualObjects(runs, @"x\nx\nx\n", @"Flushing should make the script run again");
+	[pool invalidate];
+}
+
+- (void)testTimeout {
+	AIScriptExecutorPool *pool = [self poolWithExecutorCount:1];
+	NSString *slowPath = [self pathOfScript:@"slow.sh" withContents:@"sleep 30; echo late\n"];
+	NSString *fastPath = [self pathOfScript:@"fast.sh" withContents:@"echo fast\n"];
+	NSDate *start = [NSDate date];
+
+	[pool runScriptAtPath:slowPath function:@"substitute" arguments:nil
+				cacheable:NO timeout:0.5 notifyingTarget:self selector:@selector(scriptDidRun:resultString:) userInfo:@"slow"];
+	[pool runScriptAtPath:fastPath function:@"substitute" arguments:nil
+				cacheable:NO timeout:0 notifyingTarget:self selector:@selector(scriptDidRun:resultString:) userInfo:@"fast"];
+	[self waitForResultCount:2 timeout:10];
+
+	STAssertTrue(-[start timeIntervalSinceNow] < 10, @"A timed out script should not hold up the next one");
+	STAssertEqualObjects([results objectAtIndex:0], ([NSArray arrayWithObjects:@"slow", [NSNull null], nil]),
+						 @"A timed out script should give a nil result");
+	STAssertEqualObjects([results objectAtIndex:1], ([NSArray arrayWithObjects:@"fast", @"fast", nil]),
+						 @"The next script should run once the executor is freed");
+
+	//The cancelled script must not answer again
+	[self waitForResultCount:3 timeout:1];
+	STAssertEquals(results.count, (NSUInteger)2, @"A timed out script should only be answered once");
+	[pool invalidate];
+}
+
+- (void)testTimeoutIncludesWait {
+	AIScriptExecutorPool *pool = [self poolWithExecutorCount:1];
+	NSString *slowPath = [self pathOfScript:@"alert.sh" withContents:@"sleep 3; echo alerted\n"];
+	NSString *fastPath = [self pathOfScript:@"filter.sh" withContents:@"echo filtered\n"];
+	NSDate *start = [NSDate date];
+
+	//A script without a timeout, as contact alerts run, holds the only executor
+	[pool runScriptAtPath:slowPath function:@"substitute" arguments:nil
+				cacheable:NO timeout:0 notifyingTarget:self selector:@selector(scriptDidRun:resultString:) userInfo:@"alert"];
+	[pool runScriptAtPath:fastPath function:@"substitute" arguments:nil
+				cacheable:NO timeout:0.5 notifyingTarget:self selector:@selector(scriptDidRun:resultString:) userInfo:@"filter"];
+	[self waitForResultCount:1 timeout:10];
+
+	STAssertTrue(-[start timeIntervalSinceNow] < 2, @"A waiting request should time out without waiting for the script ahead of it");
+	STAssertEqualObjects([results objectAtIndex:0], ([NSArray arrayWithObjects:@"filter", [NSNull null], nil]),
+						 @"A request which timed out waiting should give a nil result");
+
+	[self waitForResultCount:2 timeout:10];
+	STAssertEqualObjects([results lastObject], ([NSArray arrayWithObjects:@"alert", @"alerted", nil]),
+						 @"The script without a timeout should still finish");
+
+	//The timed out request must never run
+	[self waitForResultCount:3 timeout:1];
+	STAssertEquals(results.count, (NSUInteger)2, @"A request which timed out waiting should only be answered once");
+	[pool invalidate];
+}
+
+- (void)testRequestsRunInOrder {
+	AIScriptExecutorPool *pool = [self poolWithExecutorCount:1];
+	NSString *path = [self pathOfScript:@"echo.sh" withContents:@"echo \"$2\"\n"];
+	NSMutableArray *expected = [NSMutableArray array];
+	NSUInteger i;
+
+	for (i = 0; i < 5; i++) {
+		NSString *argument = [NSString stringWithFormat:@"%lu", (unsigned long)i];
+		[pool runScriptAtPath:path function:@"substitute" arguments:[NSArray arrayWithObject:argument]
+					cacheable:NO timeout:0 notifyingTarget:self selector:@selector(scriptDidRun:resultString:) userInfo:argument];
+		[expected addObject:[NSArray arrayWithObjects:argument, argument, nil]];
+	}
+	[self waitForResultCount:5 timeout:10];
+	STAssertEqualObjects(results, expected, @"Requests on one executor should be answered in the order they were made");
+	[pool invalidate];
+}
+
+- (void)testRequestsSpreadAcrossExecutors {
+	AIScriptExecutorPool *pool = [self poolWithExecutorCount:3];
+	NSString *path = [self pathOfScript:@"nap.sh" withContents:@"sleep 1; echo \"$2\"\n"];
+	NSDate *start = [NSDate date];
+	NSUInteger i;
+
+	for (i = 0; i < 3; i++) {
+		[pool runScriptAtPath:path function:@"substitute" arguments:[NSArray arrayWithObject:@"done"]
+					cacheable:NO timeout:0 notifyingTarget:self selector:@selector(scriptDidRun:resultString:) userInfo:@"nap"];
+	}
+	[self waitForResultCount:3 timeout:10];
+	STAssertEquals(results.count, (NSUInteger)3, @"Every request should be answered");
+	STAssertTrue(-[start timeIntervalSinceNow] < 2.5, @"Requests should run at the same time on separate executors");
+	[pool invalidate];
+}
+
+- (void)testRequestsPerExecutor {
+	AIShellScriptExecutor	*executor = [[[AIShellScriptExecutor alloc] init] autorelease];
+	AIScriptExecutorPool	*pool = [[[AIScriptExecutorPool alloc] initWithExecutors:[NSArray arrayWithObject:executor]
+																 requestsPerExecutor:3] autorelease];
+	NSString *path = [self pathOfScript:@"nap.sh" withContents:@"sleep 1; echo \"$2\"\n"];
+	NSDate *start = [NSDate date];
+	NSUInteger i;
+
+	pool.keepAliveInterval = 0;
+	for (i = 0; i < 3; i++) {
+		[pool runScriptAtPath:path function:@"substitute" arguments:[NSArray arrayWithObject:@"done"]
+					cacheable:NO timeout:0 notifyingTarget:self selector:@selector(scriptDidRun:resultString:) userInfo:@"nap"];
+	}
+	[self waitForResultCount:3 timeout:10];
+	STAssertEquals(results.count, (NSUInteger)3, @"Every request should be answered");
+	STAssertTrue(-[start timeIntervalSinceNow] < 2.5, @"An executor should be given as many requests at once as the pool allows");
+	[pool invalidate];
+}
+
+- (void)testKeepAliveStopsWhenIdle {
+	TestKeepAliveExecutor	*executor = [[[TestKeepAliveExecutor alloc] init] autorelease];
+	AIScriptExecutorPool	*pool = [[AIScriptExecutorPool alloc] initWithExecutors:[NSArray arrayWithObject:executor]];
+
+	pool.keepAliveInterval = 0.2;
+	[pool runScriptAtPath:@"/dev/null" function:nil arguments:nil
+				cacheable:NO timeout:0 notifyingTarget:self selector:@selector(scriptDidRun:resultString:) userInfo:@"run"];
+	[self waitForResultCount:1 timeout:10];
+	STAssertNotNil([pool valueForKey:@"keepAliveTimer"], @"Executors should be kept alive after a request");
+
+	//One interval for the request just made, one to find there's nothing left to do
+	[[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:1.5]];
+	STAssertNil([pool valueForKey:@"keepAliveTimer"], @"Executors should no longer be kept alive once the pool is idle");
+	STAssertEquals(executor.keepAliveCount, (NSUInteger)1, @"Executors should be kept alive for one interval after the last request");
+
+	[pool runScriptAtPath:@"/dev/null" function:nil arguments:nil
+				cacheable:NO timeout:0 notifyingTarget:self selector:@selector(scriptDidRun:resultString:) userInfo:@"again"];
+	STAssertNotNil([pool valueForKey:@"keepAliveTimer"], @"The next request should keep executors alive again");
+
+	[pool invalidate];
+	[pool release];
+}
+
+@end
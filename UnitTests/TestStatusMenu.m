@@ -0,0 +1,357 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestStatusMenu.h"
+
+#import <Adium/AIStatusMenu.h>
+#import <Adium/AIStatus.h>
+#import <Adium/AIStatusGroup.h>
+#import <Adium/AIStatusControllerProtocol.h>
+
+#define RANDOM_STEP_COUNT		500
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+/*!
+ * @brief Just the statuses, and their version, which status menus are built from
+ */
+@interface TestStatusMenuStatusController : NSObject {
+	NSArray		*sortedFullStateArray;
+	NSUInteger	statusArrayVersion;
+}
+/*!
+ * @brief Replace the statuses, bump the version and post the state array changed notification
+ */
+- (void)changeStatuses:(NSArray *)inStatuses;
+@property (readonly, nonatomic) NSArray *sortedFullStateArray;
+@property (readonly, nonatomic) NSUInteger statusArrayVersion;
+@end
+
+@implementation TestStatusMenuStatusController
+- (void)dealloc {
+	[sortedFullStateArray release];
+	[super dealloc];
+}
+- (void)changeStatuses:(NSArray *)inStatuses {
+	[sortedFullStateArray release];
+	sortedFullStateArray = [inStatuses copy];
+	statusArrayVersion++;
+
+	[[NSNotificationCenter defaultCenter] postNotificationName:AIStatusStateArrayChangedNotification object:nil];
+}
+@synthesize sortedFullStateArray, statusArrayVersion;
+@end
+
+@interface TestStatusMenuMenuController : NSObject {}
+@end
+
+@implementation TestStatusMenuMenuController
+- (void)delayMenuItemPostProcessing {}
+- (void)endDelayMenuItemPostProcessing {}
+@end
+
+/*!
+ * @brief Stands in for the shared AIAdium, providing only the status and menu controllers
+ */
+@interface TestStatusMenuAdium : NSObject {
+	TestStatusMenuStatusController	*statusController;
+	TestStatusMenuMenuController	*menuController;
+}
+@property (readwrite, retain, nonatomic) TestStatusMenuStatusController *statusController;
+@property (readwrite, retain, nonatomic) TestStatusMenuMenuController *menuController;
+@end
+
+@implementation TestStatusMenuAdium
+- (void)dealloc {
+	[statusController release];
+	[menuController release];
+	[super dealloc];
+}
+@synthesize statusController, menuController;
+@end
+
+/*!
+ * @brief Takes the menu items it is given and copies them into a menu of its own, as the dock status menu does
+ */
+@interface TestStatusMenuDelegate : NSObject <AIStatusMenuDelegate> {
+@public
+	NSArray		*menuItems;
+	NSMenu		*copiedMenu;
+	NSUInteger	rebuildCount;
+}
+@end
+
+@implementation TestStatusMenuDelegate
+- (void)dealloc {
+	[menuItems release];
+	[copiedMenu release];
+	[super dealloc];
+}
+- (void)statusMenu:(AIStatusMenu *)statusMenu didRebuildStatusMenuItems:(NSArray *)inMenuItems {
+	rebuildCount++;
+
+	[menuItems release];
+	menuItems = [inMenuItems copy];
+
+	[copiedMenu release];
+	copiedMenu = [[NSMenu alloc] init];
+	for (NSMenuItem *menuItem in menuItems) {
+		NSMenuItem *copiedMenuItem = [menuItem copy];
+		[copiedMenu addItem:copiedMenuItem];
+		[copiedMenuItem release];
+	}
+
+	[statusMenu delegateCreatedMenuItems:[copiedMenu itemArray]];
+}
+@end
+
+static AIStatus *statusWithTitle(NSString *title, AIStatusType statusType)
+{
+	AIStatus *status = [AIStatus status];
+
+	[status setStatusType:statusType];
+	[status setTitle:title];
+
+	return status;
+}
+
+/*!
+ * @brief The title and tool tip of every item, separators and Custom... included
+ */
+static NSArray *describeMenuItems(NSArray *menuItems)
+{
+	NSMutableArray *descriptions = [NSMutableArray arrayWithCapacity:menuItems.count];
+
+	for (NSMenuItem *menuItem in menuItems) {
+		[descriptions addObject:([menuItem isSeparatorItem] ?
+								 @"-" :
+								 [NSString stringWithFormat:@"%@ (%@)", [menuItem title], ([menuItem toolTip] ? [menuItem toolTip] : @"")])];
+	}
+
+	return descriptions;
+}
+
+@interface TestStatusMenu ()
+- (NSArray *)sortedStatuses;
+- (void)checkMenuOfDelegate:(TestStatusMenuDelegate *)delegate againstRebuild:(NSString *)step;
+@end
+
+@implementation TestStatusMenu
+
+- (void)setUp {
+	TestStatusMenuAdium *testAdium = [[[TestStatusMenuAdium alloc] init] autorelease];
+
+	statusController = [[TestStatusMenuStatusController alloc] init];
+	testAdium.statusController = statusController;
+	testAdium.menuController = [[[TestStatusMenuMenuController alloc] init] autorelease];
+	savedAdium = adium;
+	adium = (id<AIAdium>)[testAdium retain];
+
+	statuses = [[NSMutableArray alloc] initWithObjects:
+				statusWithTitle(@"Available", AIAvailableStatusType),
+				statusWithTitle(@"Free for chat", AIAvailableStatusType),
+				statusWithTitle(@"Away", AIAwayStatusType),
+				statusWithTitle(@"Out to lunch", AIAwayStatusType),
+				statusWithTitle(@"Invisible", AIInvisibleStatusType),
+				statusWithTitle(@"Offline", AIOfflineStatusType),
+				nil];
+	[statusController changeStatuses:statuses];
+}
+
+- (void)tearDown {
+	[statuses release]; statuses = nil;
+	[statusController release]; statusController = nil;
+
+	[(id)adium release];
+	adium = savedAdium;
+}
+
+- (void)testUnchangedStatusesLeaveMenuAlone {
+	TestStatusMenuDelegate	*delegate = [[[TestStatusMenuDelegate alloc] init] autorelease];
+	AIStatusMenu			*statusMenu = [AIStatusMenu statusMenuWithDelegate:delegate];
+
+	STAssertEquals(delegate->rebuildCount, (NSUInteger)1, @"The menu should be built once to begin with");
+
+	[[NSNotificationCenter defaultCenter] postNotificationName:AIStatusStateArrayChangedNotification object:nil];
+	STAssertEquals(delegate->rebuildCount, (NSUInteger)1, @"Nothing should be done if the statuses haven't changed");
+
+	[statusController changeStatuses:statuses];
+	STAssertEquals(delegate->rebuildCount, (NSUInteger)1, @"The same statuses in the same order should not be rebuilt");
+	[self checkMenuOfDelegate:delegate againstRebuild:@"After an unchanged state array"];
+
+	statusMenu.delegate = nil;
+}
+
+- (void)testChangedStatusUpdatedInPlace {
+	TestStatusMenuDelegate	*delegate = [[[TestStatusMenuDelegate alloc] init] autorelease];
+	AIStatusMenu			*statusMenu = [AIStatusMenu statusMenuWithDelegate:delegate];
+	AIStatus				*status = [statuses objectAtIndex:3];
+	NSMenuItem				*menuItem = [delegate->menuItems objectAtIndex:[[delegate->menuItems valueForKey:@"title"] indexOfObject:@"Out to lunch"]];
+	NSMenuItem				*copiedMenuItem = [delegate->copiedMenu itemWithTitle:@"Out to lunch"];
+
+	[status setTitle:@"At the dentist"];
+	[status setStatusMessageString:@"Back at two"];
+	[statusController changeStatuses:statuses];
+
+	STAssertEquals(delegate->rebuildCount, (NSUInteger)1, @"A retitled status should be updated in place");
+	STAssertEqualObjects([menuItem title], @"At the dentist", @"The menu item should have the new title");
+	STAssertEqualObjects([menuItem toolTip], @"Back at two", @"The menu item should have the new tool tip");
+	STAssertEqualObjects([copiedMenuItem title], @"At the dentist", @"The delegate's copy should have the new title");
+	STAssertEqualObjects([copiedMenuItem toolTip], @"Back at two", @"The delegate's copy should have the new tool tip");
+	[self checkMenuOfDelegate:delegate againstRebuild:@"After retitling"];
+
+	statusMenu.delegate = nil;
+}
+
+- (void)testAddedStatusRebuildsMenu {
+	TestStatusMenuDelegate	*delegate = [[[TestStatusMenuDelegate alloc] init] autorelease];
+	AIStatusMenu			*statusMenu = [AIStatusMenu statusMenuWithDelegate:delegate];
+
+	[statuses insertObject:statusWithTitle(@"In a meeting", AIAwayStatusType) atIndex:4];
+	[statusController changeStatuses:statuses];
+
+	STAssertEquals(delegate->rebuildCount, (NSUInteger)2, @"A new status should rebuild the menu");
+	STAssertTrue([[delegate->menuItems valueForKey:@"title"] containsObject:@"In a meeting"], @"The new status should be listed");
+	[self checkMenuOfDelegate:delegate againstRebuild:@"After adding"];
+
+	[statuses removeObjectAtIndex:1];
+	[statusController changeStatuses:statuses];
+
+	STAssertEquals(delegate->rebuildCount, (NSUInteger)3, @"A removed status should rebuild the menu");
+	[self checkMenuOfDelegate:delegate againstRebuild:@"After removing"];
+
+	statusMenu.delegate = nil;
+}
+
+- (void)testReorderedStatusesRebuildMenu {
+	TestStatusMenuDelegate	*delegate = [[[TestStatusMenuDelegate alloc] init] autorelease];
+	AIStatusMenu			*statusMenu = [AIStatusMenu statusMenuWithDelegate:delegate];
+
+	[statuses exchangeObjectAtIndex:2 withObjectAtIndex:3];
+	[statusController changeStatuses:statuses];
+
+	STAssertEquals(delegate->rebuildCount, (NSUInteger)2, @"Moved statuses should rebuild the menu");
+	[self checkMenuOfDelegate:delegate againstRebuild:@"After reordering"];
+
+	statusMenu.delegate = nil;
+}
+
+- (void)testGroupsAlwaysRebuilt {
+	TestStatusMenuDelegate	*delegate = [[[TestStatusMenuDelegate alloc] init] autorelease];
+	AIStatusMenu			*statusMenu;
+	AIStatusGroup			*group = [AIStatusGroup statusGroup];
+
+	[group setStatusType:AIAwayStatusType];
+	[group setTitle:@"Work"];
+	[statuses insertObject:group atIndex:4];
+	[statusController changeStatuses:statuses];
+
+	statusMenu = [AIStatusMenu statusMenuWithDelegate:delegate];
+	[statusController changeStatuses:statuses];
+
+	STAssertEquals(delegate->rebuildCount, (NSUInteger)2, @"A menu with a group in it should be rebuilt, as its submenu may have changed");
+	[self checkMenuOfDelegate:delegate againstRebuild:@"With a group"];
+
+	statusMenu.delegate = nil;
+}
+
+- (void)testRandomChangesMatchRebuild {
+	uint32_t				random = 48;
+	TestStatusMenuDelegate	*delegate = [[[TestStatusMenuDelegate alloc] init] autorelease];
+	AIStatusMenu			*statusMenu = [AIStatusMenu statusMenuWithDelegate:delegate];
+	NSUInteger				step, nextTitle = 0, rebuildCount = delegate->rebuildCount;
+
+	for (step = 0; step < RANDOM_STEP_COUNT; step++) {
+		NSAutoreleasePool	*pool = [[NSAutoreleasePool alloc] init];
+		uint32_t			action = nextRandom(&random) % 10;
+		AIStatus			*status = [statuses objectAtIndex:nextRandom(&random) % statuses.count];
+		BOOL				expectRebuild = NO;
+
+		if (action < 4) {
+			[status setTitle:[NSString stringWithFormat:@"Status %lu", (unsigned long)nextTitle++]];
+
+		} else if (action < 6) {
+			if (nextRandom(&random) % 2) {
+				[status setStatusMessageString:[NSString stringWithFormat:@"Message %lu", (unsigned long)step]];
+			} else {
+				[status setStatusMessage:nil];
+			}
+
+		} else if (action < 7) {
+			AIStatusType statusType = AIAvailableStatusType + nextRandom(&random) % 3;
+			[statuses addObject:statusWithTitle([NSString stringWithFormat:@"Status %lu", (unsigned long)nextTitle++], statusType)];
+			expectRebuild = YES;
+
+		} else if (action < 8 && statuses.count > 2 && status.statusType != AIOfflineStatusType) {
+			[statuses removeObjectIdenticalTo:status];
+			expectRebuild = YES;
+		}
+
+		NSArray *sortedStatuses = [self sortedStatuses];
+		if (![sortedStatuses isEqualToArray:statusController.sortedFullStateArray]) expectRebuild = YES;
+
+		[statusController changeStatuses:sortedStatuses];
+		if (expectRebuild) rebuildCount++;
+
+		STAssertEquals(delegate->rebuildCount, rebuildCount, @"Step %lu: the menu should only be rebuilt when statuses come, go or move",
+					   (unsigned long)step);
+		[self checkMenuOfDelegate:delegate againstRebuild:[NSString stringWithFormat:@"Step %lu", (unsigned long)step]];
+
+		[pool release];
+	}
+
+	statusMenu.delegate = nil;
+}
+
+/*!
+ * @brief Our statuses, grouped by type as the status controller lists them, keeping their order within a type
+ */
+- (NSArray *)sortedStatuses {
+	NSMutableArray	*sortedStatuses = [NSMutableArray arrayWithCapacity:statuses.count];
+	AIStatusType	statusType;
+
+	for (statusType = AIAvailableStatusType; statusType <= AIOfflineStatusType; statusType++) {
+		for (AIStatus *status in statuses) {
+			AIStatusType thisStatusType = status.statusType;
+			if (thisStatusType == AIInvisibleStatusType) thisStatusType = AIAwayStatusType;
+			if (thisStatusType == statusType) [sortedStatuses addObject:status];
+		}
+	}
+
+	[statuses setArray:sortedStatuses];
+
+	return sortedStatuses;
+}
+
+/*!
+ * @brief Check that the delegate's items, and its copies of them, match a menu built from scratch
+ */
+- (void)checkMenuOfDelegate:(TestStatusMenuDelegate *)delegate againstRebuild:(NSString *)step {
+	TestStatusMenuDelegate	*rebuiltDelegate = [[[TestStatusMenuDelegate alloc] init] autorelease];
+	AIStatusMenu			*rebuiltStatusMenu = [AIStatusMenu statusMenuWithDelegate:rebuiltDelegate];
+	NSArray					*expected = describeMenuItems(rebuiltDelegate->menuItems);
+
+	STAssertEqualObjects(describeMenuItems(delegate->menuItems), expected, @"%@: the menu items differ from a rebuilt menu", step);
+	STAssertEqualObjects(describeMenuItems([delegate->copiedMenu itemArray]), expected, @"%@: the delegate's copies differ from a rebuilt menu", step);
+
+	rebuiltStatusMenu.delegate = nil;
+}
+
+@end
@@ -0,0 +1,208 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#import "TestTimerWheel.h"
+
+#import <AIUtilities/AITimerWheel.h>
+
+#define TICK				0.01
+#define RANDOM_TIMER_COUNT	5000
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+@implementation TestTimerWheel
+
+- (void)testFiresInOrder {
+	AITimerWheel	*wheel = [[[AITimerWheel alloc] initWithVirtualClockAndTickInterval:TICK] autorelease];
+	NSMutableArray	*fired = [NSMutableArray array];
+
+	for (NSString *delay in [NSArray arrayWithObjects:@"0.5", @"0.1", @"0.3", @"0.2", nil]) {
+		[wheel scheduleTimerWithDelay:[delay doubleValue] repeatInterval:0 block:^(AIWheelTimer *timer) {
+			[fired addObject:delay];
+		}];
+	}
+	STAssertEquals(wheel.timerCount, (NSUInteger)4, @"Every timer should be counted");
+
+	[wheel advanceTimeBy:0.25];
+	STAssertEqualObjects(fired, ([NSArray arrayWithObjects:@"0.1", @"0.2", nil]), @"Only the timers due should fire, soonest first");
+
+	[wheel advanceTimeBy:1.0];
+	STAssertEqualObjects(fired, ([NSArray arrayWithObjects:@"0.1", @"0.2", @"0.3", @"0.5", nil]), @"The rest should fire in order");
+	STAssertEquals(wheel.timerCount, (NSUInteger)0, @"Fired timers should be gone");
+}
+
+- (void)testCoalescesWithinTick {
+	AITimerWheel	*wheel = [[[AITimerWheel alloc] initWithVirtualClockAndTickInterval:TICK] autorelease];
+	__block NSUInteger	count = 0;
+	__block NSTimeInterval	firedAt = 0;
+
+	//All round up to the tick at 0.11
+	for (NSTimeInterval delay = 0.101; delay < 0.11; delay += 0.004) {
+		[wheel scheduleTimerWithDelay:delay repeatInterval:0 block:^(AIWheelTimer *timer) {
+			count++;
+			firedAt = wheel.currentTime;
+		}];
+	}
+
+	[wheel advanceTimeBy:0.1];
+	STAssertEquals(count, (NSUInteger)0, @"Nothing should fire before its tick");
+	[wheel advanceTimeBy:0.5];
+	STAssertEquals(count, (NSUInteger)3, @"Timers in one tick should fire together");
+	STAssertEqualsWithAccuracy(firedAt, 0.11, 1e-9, @"They should fire on the tick they round up to");
+}
+
+- (void)testRescheduleMovesTimer {
+	AITimerWheel	*wheel = [[[AITimerWheel alloc] initWithVirtualClockAndTickInterval:TICK] autorelease];
+	__block NSUInteger	count = 0;
+	__block NSTimeInterval	firedAt = 0;
+
+	AIWheelTimer *timer = [wheel scheduleTimerWithDelay:3.0 repeatInterval:0 block:^(AIWheelTimer *timer) {
+		count++;
+		firedAt = wheel.currentTime;
+	}];
+
+	//A keystroke every 150ms for 10 seconds
+	for (NSUInteger keystroke = 0; keystroke < 66; keystroke++) {
+		[wheel advanceTimeBy:0.15];
+		[timer rescheduleAfterDelay:3.0];
+	}
+	STAssertEquals(count, (NSUInteger)0, @"A timer pushed back on every keystroke should not fire");
+
+	[wheel advanceTimeBy:10.0];
+	STAssertEquals(count, (NSUInteger)1, @"It should fire once typing stops");
+	STAssertEqualsWithAccuracy(firedAt, 66 * 0.15 + 3.0, 1e-9, @"It should fire 3 seconds after the last keystroke");
+	STAssertFalse(timer.isValid, @"A fired non-repeating timer should be invalid");
+
+	[timer rescheduleAfterDelay:1.0];
+	[wheel advanceTimeBy:2.0];
+	STAssertEquals(count, (NSUInteger)1, @"An invalid timer should not be rescheduled");
+}
+
+- (void)testInvalidateWhileFiring {
+	AITimerWheel	*wheel = [[[AITimerWheel alloc] initWithVirtualClockAndTickInterval:TICK] autorelease];
+	NSMutableArray	*fired = [NSMutableArray array];
+	__block AIWheelTimer	*second = nil;
+
+	[wheel scheduleTimerWithDelay:0.1 repeatInterval:0 block:^(AIWheelTimer *timer) {
+		[fired addObject:@"first"];
+		[second invalidate];
+	}];
+	second = [wheel scheduleTimerWithDelay:0.1 repeatInterval:0 block:^(AIWheelTimer *timer) {
+		[fired addObject:@"second"];
+	}];
+	[wheel scheduleTimerWithDelay:0.1 repeatInterval:0 block:^(AIWheelTimer *timer) {
+		[fired addObject:@"third"];
+		[timer rescheduleAfterDelay:0.1];
+	}];
+
+	[wheel advanceTimeBy:0.15];
+	STAssertEqualObjects(fired, ([NSArray arrayWithObjects:@"first", @"third", nil]), @"A timer invalidated by another in the same tick should not fire");
+	STAssertEquals(wheel.timerCount, (NSUInteger)1, @"A timer rescheduled while firing should stay scheduled");
+
+	[wheel advanceTimeBy:0.1];
+	STAssertEqualObjects([fired lastObject], @"third", @"The rescheduled timer should fire again");
+}
+
+- (void)testRepeatingTimer {
+	AITimerWheel	*wheel = [[[AITimerWheel alloc] initWithVirtualClockAndTickInterval:TICK] autorelease];
+	__block NSUInteger	count = 0;
+
+	AIWheelTimer *timer = [wheel scheduleTimerWithDelay:0.1 repeatInterval:0.1 block:^(AIWheelTimer *timer) {
+		count++;
+	}];
+
+	[wheel advanceTimeBy:1.0];
+	STAssertEquals(count, (NSUInteger)10, @"A repeating timer should fire every interval, even within one advance");
+	STAssertTrue(timer.isValid, @"A repeating timer should stay valid");
+
+	[timer invalidate];
+	[wheel advanceTimeBy:1.0];
+	STAssertEquals(count, (NSUInteger)10, @"An invalidated timer should not fire");
+	STAssertEquals(wheel.timerCount, (NSUInteger)0, @"An invalidated timer should be gone");
+}
+
+- (void)testLongDelaysCascade {
+	AITimerWheel	*wheel = [[[AITimerWheel alloc] initWithVirtualClockAndTickInterval:TICK] autorelease];
+	NSArray			*delays = [NSArray arrayWithObjects:
+							   [NSNumber numberWithDouble:0.64],		//First tick of the second level
+							   [NSNumber numberWithDouble:40.96],		//First tick of the third level
+							   [NSNumber numberWithDouble:2621.44],		//First tick of the fourth level
+							   [NSNumber numberWithDouble:86400.0],		//A day
+							   [NSNumber numberWithDouble:400000.0],	//Beyond the end of the wheel
+							   nil];
+	NSMutableArray	*firedAt = [NSMutableArray array];
+
+	[wheel advanceTimeBy:0.37];
+	for (NSNumber *delay in delays) {
+		[wheel scheduleTimerWithDelay:[delay doubleValue] repeatInterval:0 block:^(AIWheelTimer *timer) {
+			[firedAt addObject:[NSNumber numberWithDouble:wheel.currentTime - 0.37]];
+		}];
+	}
+
+	[wheel advanceTimeBy:1000000.0];
+	STAssertEquals([firedAt count], [delays count], @"Every timer should fire");
+	for (NSUInteger i = 0; i < [delays count]; i++) {
+		STAssertEqualsWithAccuracy([[firedAt objectAtIndex:i] doubleValue], [[delays objectAtIndex:i] doubleValue], 1e-6,
+								   @"A long timer should fire on its own tick after cascading");
+	}
+}
+
+- (void)testRandomTimersFireOnTime {
+	AITimerWheel	*wheel = [[[AITimerWheel alloc] initWithVirtualClockAndTickInterval:TICK] autorelease];
+	uint32_t		seed = 40;
+	NSMutableArray	*timers = [NSMutableArray array];
+	__block NSUInteger	early = 0, late = 0, fired = 0;
+	NSTimeInterval	*due = malloc(RANDOM_TIMER_COUNT * sizeof(NSTimeInterval));
+
+	for (NSUInteger i = 0; i < RANDOM_TIMER_COUNT; i++) {
+		//Mostly short, a few spanning every level
+		NSTimeInterval delay = (nextRandom(&seed) % 1000) * 0.001 * pow(64, nextRandom(&seed) % 4);
+
+		due[i] = ceil((wheel.currentTime + delay) / TICK - 1e-6) * TICK;
+		[timers addObject:[wheel scheduleTimerWithDelay:delay repeatInterval:0 block:^(AIWheelTimer *timer) {
+			if (wheel.currentTime < due[i] - 1e-6) early++;
+			if (wheel.currentTime > due[i] + 1e-6) late++;
+			fired++;
+		}]];
+	}
+
+	while (wheel.timerCount) {
+		[wheel advanceTimeBy:(nextRandom(&seed) % 500) * 0.1];
+
+		//Reschedule a few, as typing would
+		for (NSUInteger j = 0; j < 10; j++) {
+			NSUInteger		i = nextRandom(&seed) % RANDOM_TIMER_COUNT;
+			AIWheelTimer	*timer = [timers objectAtIndex:i];
+			if (timer.isValid) {
+				NSTimeInterval delay = (nextRandom(&seed) % 5000) * 0.001;
+				due[i] = MAX(ceil((wheel.currentTime + delay) / TICK - 1e-6), floor(wheel.currentTime / TICK + 1e-6) + 1) * TICK;
+				[timer rescheduleAfterDelay:delay];
+			}
+		}
+	}
+
+	STAssertEquals(fired, (NSUInteger)RANDOM_TIMER_COUNT, @"Every timer should fire exactly once");
+	STAssertEquals(early, (NSUInteger)0, @"No timer should fire before its tick");
+	STAssertEquals(late, (NSUInteger)0, @"No timer should fire after its tick");
+
+	free(due);
+}
+
+@end
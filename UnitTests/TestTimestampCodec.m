@@ -0,0 +1,115 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#import "TestTimestampCodec.h"
+
+#import <AIUtilities/AITimestampCodec.h>
+#import <AIUtilities/ISO8601DateFormatter.h>
+
+#define ROUND_TRIP_COUNT	20000
+#define FUZZ_COUNT			20000
+
+static uint32_t nextRandom(uint32_t *state)
+{
+	*state = *state * 1664525U + 1013904223U;
+	return *state >> 8;
+}
+
+@implementation TestTimestampCodec
+
+- (void)testParsesAdiumTimestamps {
+	AITimestampCodec *codec = [[[AITimestampCodec alloc] init] autorelease];
+
+	//2013-09-08T23:06:11Z
+	STAssertEqualObjects([codec dateFromString:@"2013-09-08T15:06:11-0800"], [NSDate dateWithTimeIntervalSinceReferenceDate:400374371.0], @"A negative offset should be added back");
+	STAssertEqualObjects([codec dateFromString:@"2013-09-09T04:36:11+0530"], [NSDate dateWithTimeIntervalSinceReferenceDate:400374371.0], @"A positive offset with minutes should be subtracted");
+	STAssertEqualObjects([codec dateFromString:@"2013-09-08T23:06:11Z"], [NSDate dateWithTimeIntervalSinceReferenceDate:400374371.0], @"Z should mean UTC");
+	STAssertEqualObjects([codec dateFromString:@"2012-02-29T00:00:00Z"], [NSDate dateWithTimeIntervalSinceReferenceDate:352166400.0], @"Leap days should parse");
+	STAssertEqualObjects([codec dateFromString:@"2001-01-01T00:00:00Z"], [NSDate dateWithTimeIntervalSinceReferenceDate:0.0], @"The reference date should be zero");
+	STAssertNil([codec dateFromString:nil], @"No string should be no date");
+
+	AITimestampCodec *fileNameCodec = [[[AITimestampCodec alloc] initWithTimeSeparator:'.'] autorelease];
+	STAssertEqualObjects([fileNameCodec dateFromString:@"2013-09-08T15.06.11-0800"], [NSDate dateWithTimeIntervalSinceReferenceDate:400374371.0], @"Log file names separate the time with dots");
+	STAssertEqualObjects([AITimestampCodec dateFromString:@"2013-09-08T15.06.11-0800" timeSeparator:'.'], [NSDate dateWithTimeIntervalSinceReferenceDate:400374371.0], @"The class method should parse the same way");
+
+	STAssertEqualObjects([codec stringFromDate:[NSDate dateWithTimeIntervalSinceReferenceDate:400374371.75] timeZone:[NSTimeZone timeZoneWithName:@"America/Los_Angeles"]], @"2013-09-08T15:06:11-0700", @"Daylight saving time should be applied and the fraction dropped");
+	STAssertEqualObjects([codec stringFromDate:[NSDate dateWithTimeIntervalSinceReferenceDate:400374371.0] timeZone:[NSTimeZone timeZoneWithName:@"UTC"]], @"2013-09-08T23:06:11Z", @"UTC should be written as Z");
+	STAssertEqualObjects([codec stringFromDate:[NSDate dateWithTimeIntervalSinceReferenceDate:400374371.0] timeZone:[NSTimeZone timeZoneForSecondsFromGMT:-(3 * 3600 + 1800)]], @"2013-09-08T19:36:11-0330", @"Negative offsets with minutes should keep their sign on the hours only");
+}
+
+- (void)testFallsBackForOtherForms {
+	AITimestampCodec		*codec = [[[AITimestampCodec alloc] init] autorelease];
+	ISO8601DateFormatter	*formatter = [[[ISO8601DateFormatter alloc] init] autorelease];
+	NSArray					*strings = [NSArray arrayWithObjects:
+										@"2005-05-07",
+										@"2013-09-08T15:06:11",
+										@"2013-09-08T15:06:11.500-0800",
+										@"2013-09-08T15:06:11-08:00",
+										@"2013-02-30T15:06:11-0800",
+										@"2013-09-08T24:00:00Z",
+										@" 2013-09-08T15:06:11-0800",
+										@"not a date", nil];
+
+	for (NSString *string in strings) {
+		STAssertEqualObjects([codec dateFromString:string], [formatter dateFromString:string], @"%@ should be parsed as ISO8601DateFormatter parses it", string);
+	}
+}
+
+- (void)testRoundTripAgainstISO8601DateFormatter {
+	AITimestampCodec		*codec = [[[AITimestampCodec alloc] init] autorelease];
+	ISO8601DateFormatter	*formatter = [[[ISO8601DateFormatter alloc] init] autorelease];
+	NSArray					*timeZoneNames = [NSArray arrayWithObjects:@"UTC", @"America/Los_Angeles", @"Europe/Berlin", @"Asia/Kolkata", @"Australia/Adelaide", @"Pacific/Auckland", nil];
+	uint32_t				state = 1;
+
+	formatter.includeTime = YES;
+
+	for (NSUInteger i = 0; i < ROUND_TRIP_COUNT; i++) {
+		//Whole seconds between 1990 and 2040
+		NSDate		*date = [NSDate dateWithTimeIntervalSinceReferenceDate:-347155200.0 + nextRandom(&state) % 1577836800U];
+		NSTimeZone	*timeZone = [NSTimeZone timeZoneWithName:[timeZoneNames objectAtIndex:nextRandom(&state) % timeZoneNames.count]];
+		NSString	*string = [codec stringFromDate:date timeZone:timeZone];
+
+		STAssertEqualObjects(string, [formatter stringFromDate:date timeZone:timeZone], @"%@ in %@ should be written as ISO8601DateFormatter writes it", date, timeZone);
+		STAssertEqualObjects([codec dateFromString:string], date, @"%@ should read back as %@", string, date);
+		STAssertEqualObjects([codec dateFromString:string], [formatter dateFromString:string], @"%@ should be read as ISO8601DateFormatter reads it", string);
+	}
+}
+
+- (void)testFuzzAgainstISO8601DateFormatter {
+	AITimestampCodec		*codec = [[[AITimestampCodec alloc] init] autorelease];
+	ISO8601DateFormatter	*formatter = [[[ISO8601DateFormatter alloc] init] autorelease];
+	static const unichar	replacements[] = { '0', '1', '2', '3', '5', '9', '-', '+', ':', 'T', 'Z', '.', ' ' };
+	uint32_t				state = 1;
+
+	for (NSUInteger i = 0; i < FUZZ_COUNT; i++) {
+		unichar		characters[AI_TIMESTAMP_MAX_LENGTH];
+		NSString	*valid = [codec stringFromDate:[NSDate dateWithTimeIntervalSinceReferenceDate:nextRandom(&state) % 1000000000U]
+									 timeZone:[NSTimeZone timeZoneForSecondsFromGMT:((NSInteger)(nextRandom(&state) % 97) - 48) * 900]];
+		NSUInteger	length = valid.length;
+
+		//Change a character or two, and sometimes the length
+		[valid getCharacters:characters range:NSMakeRange(0, length)];
+		characters[nextRandom(&state) % length] = replacements[nextRandom(&state) % (sizeof(replacements) / sizeof(replacements[0]))];
+		if (nextRandom(&state) % 2)
+			characters[nextRandom(&state) % length] = replacements[nextRandom(&state) % (sizeof(replacements) / sizeof(replacements[0]))];
+		if (nextRandom(&state) % 8 == 0)
+			length -= 1 + nextRandom(&state) % 4;
+
+		NSString *mutated = [NSString stringWithCharacters:characters length:length];
+		STAssertEqualObjects([codec dateFromString:mutated], [formatter dateFromString:mutated], @"%@ (from %@) should be read as ISO8601DateFormatter reads it", mutated, valid);
+	}
+}
+
+@end
@@ -0,0 +1,210 @@
+/* 
+ * Adium is the legal property of its developers, whose names are listed in the copyright file included
+ * with this source distribution.
+ * 
+ * This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+ * General Public License as published by the Free Software Foundation; either version 2 of the License,
+ * or (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General
+ * Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along with this program; if not,
+ * write to the Free Software Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+#import "TestXMLElementSerialization.h"
+#import "AIUnitTestUtilities.h"
+
+#import <AIUtilities/AIStringAdditions.h>
+#import <Adium/AIXMLElement.h>
+#import <Adium/AIXMLByteBuffer.h>
+
+/* The reference for every test here is the string serializer: -XMLString, or -stringByEscapingForXMLWithEntities:,
+ * converted to UTF-8. The byte serializer must produce exactly the same bytes.
+ */
+
+static NSString *UTF8(const char *bytes)
+{
+	return [NSString stringWithUTF8String:bytes];
+}
+
+static NSData *referenceDataForString(NSString *string)
+{
+	return [string dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+static NSData *dataForBuffer(AIXMLByteBuffer *buffer)
+{
+	return [NSData dataWithBytes:buffer.bytes length:buffer.length];
+}
+
+/*!
+ * @brief Text of the sort found in attribute values and message bodies
+ */
+static NSArray *stringCorpus(void)
+{
+	NSMutableString *longString = [NSMutableString string];
+	for (NSUInteger i = 0; i < 2000; i++) {
+		[longString appendString:(i % 7) ? @"word " : @"<b>&amp;</b> "];
+	}
+
+	return [NSArray arrayWithObjects:
+			@"",
+			@"plain",
+			@"Tom & Jerry",
+			@"<b>bold</b>",
+			@"\"double\" and 'single' quotes",
+			@"&amp; is already escaped, &#x1F600; too",
+			@"&&&&<<<<>>>>\"\"\"\"''''",
+			UTF8("Caf\xC3\xA9 cr\xC3\xA8me br\xC3\xBBl\xC3\xA9e"),
+			UTF8("\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E & \xE4\xB8\xAD\xE6\x96\x87"),
+			UTF8("\xF0\x9F\x98\x80 grinning, \xF0\x9F\x92\xA9 < \xF0\x9D\x84\x9E"),
+			UTF8("\xF0\x9F\x91\xA8\xE2\x80\x8D\xF0\x9F\x91\xA9\xE2\x80\x8D\xF0\x9F\x91\xA7 'family'"),
+			UTF8("line one\nline two\ttabbed\r\n"),
+			longString,
+			nil];
+}
+
+/*!
+ * @brief Elements shaped like the ones the logger writes, and a few which aren't
+ */
+static NSArray *elementCorpus(void)
+{
+	NSMutableArray *elements = [NSMutableArray array];
+
+	for (NSString *string in stringCorpus()) {
+		AIXMLElement *message = [AIXMLElement elementWithName:@"message"];
+		[message setAttributeNames:[NSArray arrayWithObjects:@"sender", @"time", @"alias", nil]
+							values:[NSArray arrayWithObjects:@"tom@example.com", @"2009-06-28T21:06:01-07:00", string, nil]];
+		[message addObject:string];
+		[elements addObject:message];
+
+		AIXMLElement *status = [AIXMLElement elementWithName:@"status"];
+		[status setAttributeNames:[NSArray arrayWithObjects:@"type", @"sender", nil]
+						   values:[NSArray arrayWithObjects:@"away", string, nil]];
+		[status addEscapedObject:@""];
+		[elements addObject:status];
+	}
+
+	AIXMLElement *span = [AIXMLElement elementWithName:@"span"];
+	[span setValue:@"color: #ff0000; font-family: \"Helvetica\"" forAttribute:@"style"];
+	[span addObject:UTF8("red & \xF0\x9F\x94\xB4")];
+	[span addObject:[AIXMLElement elementWithName:@"br"]];
+	[span addEscapedObject:@"&lt;escaped&gt;"];
+
+	AIXMLElement *anchor = [AIXMLElement elementWithName:@"a"];
+	[anchor setValue:(NSString *)[NSURL URLWithString:@"http://example.com/?a=1&b=2"] forAttribute:@"href"];
+	[anchor addObject:@"link"];
+
+	AIXMLElement *div = [AIXMLElement elementWithNamespaceName:@"xhtml" elementName:@"div"];
+	[div setValue:(NSString *)[NSNumber numberWithInteger:42] forAttribute:@"count"];
+	[div addObject:span];
+	[div addObject:@" and "];
+	[div addObject:anchor];
+	[elements addObject:div];
+
+	[elements addObject:[AIXMLElement elementWithName:@"br"]];
+	[elements addObject:[AIXMLElement elementWithName:@"chat"]];
+
+	AIXMLElement *selfClosing = [AIXMLElement elementWithName:@"img"];
+	selfClosing.selfCloses = YES;
+	[selfClosing setValue:@"a \"quoted\" path.png" forAttribute:@"src"];
+	[elements addObject:selfClosing];
+
+	return elements;
+}
+
+@implementation TestXMLElementSerialization
+
+- (void)testEscapedStringsMatchStringEscaping
+{
+	for (NSString *string in stringCorpus()) {
+		AIXMLByteBuffer *buffer = [[[AIXMLByteBuffer alloc] init] autorelease];
+		[buffer appendXMLEscapedString:string];
+
+		AISimplifiedAssertEqualObjects(dataForBuffer(buffer), referenceDataForString([string stringByEscapingForXMLWithEntities:nil]), string);
+	}
+}
+
+- (void)testEscapedUTF8BytesMatchStringEscaping
+{
+	for (NSString *string in stringCorpus()) {
+		NSData *UTF8Data = referenceDataForString(string);
+		AIXMLByteBuffer *buffer = [[[AIXMLByteBuffer alloc] initWithCapacity:1] autorelease];
+		[buffer appendXMLEscapedUTF8Bytes:[UTF8Data bytes] length:[UTF8Data length]];
+
+		AISimplifiedAssertEqualObjects(dataForBuffer(buffer), referenceDataForString([string stringByEscapingForXMLWithEntities:nil]), string);
+	}
+}
+
+- (void)testElementsMatchXMLString
+{
+	for (AIXMLElement *element in elementCorpus()) {
+		NSData *expected = referenceDataForString([element XMLString]);
+
+		AIXMLByteBuffer *buffer = [[[AIXMLByteBuffer alloc] init] autorelease];
+		[element appendUTF8XMLBytesToBuffer:buffer];
+		AISimplifiedAssertEqualObjects(dataForBuffer(buffer), expected, [element XMLString]);
+
+		AISimplifiedAssertEqualObjects([element UTF8XMLData], expected, [element XMLString]);
+
+		NSMutableData *data = [NSMutableData dataWithBytes:"prefix" length:6];
+		[element appendUTF8XMLBytesToData:data];
+		NSMutableData *expectedData = [NSMutableData dataWithBytes:"prefix" length:6];
+		[expectedData appendData:expected];
+		AISimplifiedAssertEqualObjects(data, expectedData, [element XMLString]);
+	}
+}
+
+- (void)testDirectSerializationMatchesElements
+{
+	for (NSString *string in stringCorpus()) {
+		NSArray *names = [NSArray arrayWithObjects:@"sender", @"time", @"alias", nil];
+		NSArray *values = [NSArray arrayWithObjects:string, @"2009-06-28T21:06:01-07:00", UTF8("\xF0\x9F\x98\x80 & co"), nil];
+		NSString *escapedContents = [string stringByEscapingForXMLWithEntities:nil];
+
+		AIXMLElement *element = [AIXMLElement elementWithName:@"message"];
+		[element setAttributeNames:names values:values];
+		[element addEscapedObject:escapedContents];
+
+		AIXMLByteBuffer *buffer = [[[AIXMLByteBuffer alloc] init] autorelease];
+		[AIXMLElement appendUTF8XMLBytesForElementWithName:@"message"
+											attributeNames:names
+													values:values
+										   escapedContents:escapedContents
+												  toBuffer:buffer];
+
+		AISimplifiedAssertEqualObjects(dataForBuffer(buffer), referenceDataForString([element XMLString]), string);
+	}
+}
+
+- (void)testKnownOutput
+{
+	AIXMLElement *message = [AIXMLElement elementWithName:@"message"];
+	[message setAttributeNames:[NSArray arrayWithObjects:@"sender", @"alias", nil]
+						values:[NSArray arrayWithObjects:@"a&b", UTF8("\"\xF0\x9F\x98\x80\""), nil]];
+	[message addObject:UTF8("1 < 2 \xE2\x98\x83")];
+	[message addObject:[AIXMLElement elementWithName:@"br"]];
+
+	NSData *expected = referenceDataForString(UTF8("<message sender=\"a&amp;b\" alias=\"&quot;\xF0\x9F\x98\x80&quot;\">1 &lt; 2 \xE2\x98\x83<br /></message>"));
+	AISimplifiedAssertEqualObjects([message UTF8XMLData], expected, @"Message with entities and a non-BMP alias");
+	AISimplifiedAssertEqualObjects(referenceDataForString([message XMLString]), expected, @"Message with entities and a non-BMP alias");
+}
+
+- (void)testReusedBuffer
+{
+	AIXMLByteBuffer *buffer = [[[AIXMLByteBuffer alloc] initWithCapacity:16] autorelease];
+
+	for (AIXMLElement *element in elementCorpus()) {
+		[buffer removeAllBytes];
+		[buffer appendBytes:"\n" length:1];
+		[element appendUTF8XMLBytesToBuffer:buffer];
+		[buffer appendString:@"</chat>"];
+
+		NSString *expected = [NSString stringWithFormat:@"\n%@</chat>", [element XMLString]];
+		AISimplifiedAssertEqualObjects([buffer data], referenceDataForString(expected), [element XMLString]);
+	}
+}
+
+@end
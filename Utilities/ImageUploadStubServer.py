@@ -0,0 +1,135 @@
+#!/usr/bin/env python
+
+"""A local stand-in for an image upload service, for the image uploaders and AIImageUploadBenchmark.
+
+It accepts multipart/form-data POSTs to any path, checks the body is well formed (every part opened by the
+boundary and closed by CRLF, nothing after the closing boundary) and answers the way Imgur's XML API did, so
+AIImgurImageUploader can be pointed at it.
+
+Usage:
+	python Utilities/ImageUploadStubServer.py
+	defaults write com.adiumX.adiumX AIImageUploadBenchmarkURL http://127.0.0.1:8089/upload
+
+Then relaunch a build of Adium with the Contact List Benchmark plugin installed, and upload an image to a chat.
+Or run the benchmark against it:
+	Utilities/RunContactListBenchmark.sh build/Debug synthetic -AIImageUploadBenchmark YES \\
+		-AIImageUploadBenchmarkURL http://127.0.0.1:8089/upload
+
+Each upload is logged to stderr with its parts, their sizes, how fast the body arrived and any problem with it.
+A malformed body is answered with stat="fail" and the problem as the error message.
+
+To go back to the real service:
+	defaults delete com.adiumX.adiumX AIImageUploadBenchmarkURL
+"""
+
+import optparse
+import re
+import sys
+import time
+
+try:
+	from BaseHTTPServer import BaseHTTPRequestHandler, HTTPServer
+except ImportError:
+	from http.server import BaseHTTPRequestHandler, HTTPServer
+
+CHUNK_SIZE = 65536
+
+def parse_multipart(body, boundary):
+	"""Return the (name, content type, length) of each part, or raise ValueError saying what is wrong."""
+	delimiter = b'--' + boundary
+	closing = delimiter + b'--\r\n'
+
+	if not body.startswith(delimiter + b'\r\n'):
+		raise ValueError('the body does not start with the boundary')
+	end = body.find(closing)
+	if end < 0:
+		raise ValueError('there is no closing boundary')
+	if end + len(closing) != len(body):
+		raise ValueError('%d bytes follow the closing boundary' % (len(body) - end - len(closing)))
+
+	# Each part's closing CRLF is taken off by the split, except the last one's
+	contents = body[len(delimiter) + 2:end]
+	if not contents.endswith(b'\r\n'):
+		raise ValueError('the last part is not closed by CRLF')
+
+	parts = []
+	for chunk in contents[:-2].split(b'\r\n' + delimiter + b'\r\n'):
+		header_end = chunk.find(b'\r\n\r\n')
+		if header_end < 0:
+			raise ValueError('part %d has no headers' % (len(parts) + 1))
+		headers = chunk[:header_end].decode('utf-8', 'replace')
+		name = re.search(r'Content-Disposition: form-data; name="([^"]*)"', headers)
+		if not name:
+			raise ValueError('part %d has no name' % (len(parts) + 1))
+		content_type = re.search(r'Content-Type: (\S+)', headers)
+		parts.append((name.group(1), content_type.group(1) if content_type else None, len(chunk) - header_end - 4))
+	return parts
+
+class Handler(BaseHTTPRequestHandler):
+	protocol_version = 'HTTP/1.1'
+
+	def reply(self, body):
+		body = body.encode('utf-8')
+		self.send_response(200)
+		self.send_header('Content-Type', 'text/xml')
+		self.send_header('Content-Length', str(len(body)))
+		self.end_headers()
+		self.wfile.write(body)
+
+	def do_POST(self):
+		started = time.time()
+		length = int(self.headers.get('Content-Length') or 0)
+		boundary = re.search(r'boundary=(\S+)', self.headers.get('Content-Type') or '')
+
+		chunks = []
+		remaining = length
+		while remaining:
+			chunk = self.rfile.read(min(CHUNK_SIZE, remaining))
+			if not chunk:
+				break
+			chunks.append(chunk)
+			remaining -= len(chunk)
+		body = b''.join(chunks)
+		elapsed = max(time.time() - started, 0.000001)
+
+		try:
+			if remaining:
+				raise ValueError('the body ended %d bytes short of its Content-Length' % remaining)
+			if not boundary:
+				raise ValueError('there is no boundary in the Content-Type')
+			parts = parse_multipart(body, boundary.group(1).encode('utf-8'))
+			files = [part for part in parts if part[1]]
+			if not files:
+				raise ValueError('there is no file')
+		except ValueError as error:
+			sys.stderr.write('%s: %d bytes in %.3f seconds, rejected: %s\n' % (self.path, len(body), elapsed, error))
+			self.reply('<rsp stat="fail"><error_msg>%s</error_msg></rsp>' % error)
+			return
+
+		self.server.upload_count += 1
+		extension = 'jpg' if files[0][1] == 'image/jpeg' else 'png'
+		sys.stderr.write('%s: %d bytes in %.3f seconds (%.1f MB/s): %s\n' % (self.path, len(body), elapsed,
+			len(body) / elapsed / 1048576.0, ', '.join('%s (%s, %d bytes)' % (name, content_type or 'field', size)
+			for name, content_type, size in parts)))
+		self.reply('<rsp stat="ok"><original_image>http://127.0.0.1:%d/i/%d.%s</original_image></rsp>'
+			% (self.server.server_port, self.server.upload_count, extension))
+
+	def log_message(self, format, *args):
+		pass
+
+def main():
+	parser = optparse.OptionParser(usage='%prog [options]')
+	parser.add_option('--port', type='int', default=8089)
+	options, args = parser.parse_args()
+
+	server = HTTPServer(('127.0.0.1', options.port), Handler)
+	server.upload_count = 0
+	sys.stderr.write('Listening on http://127.0.0.1:%d\n' % options.port)
+
+	try:
+		server.serve_forever()
+	except KeyboardInterrupt:
+		pass
+
+if __name__ == '__main__':
+	main()
@@ -0,0 +1,41 @@
+#!/bin/sh
+#
+# Runs the contact list benchmark plugin in a scratch copy of Adium with an empty profile, so no real accounts
+# connect and nothing in your own profile is touched. The report is printed to stdout.
+#
+# Usage: RunContactListBenchmark.sh BUILT_PRODUCTS_DIR [TRACE] [-<Default> <value> ...]
+#
+# TRACE is a trace property list or "synthetic" (the default). -<Benchmark> YES runs that benchmark instead of the
+# trace; see AIContactListBenchmarkPlugin.h for the defaults. Examples:
+#	Utilities/RunContactListBenchmark.sh build/Debug synthetic -AIContactListBenchmarkContacts 5000
+#	Utilities/RunContactListBenchmark.sh build/Debug synthetic -AIChatRegistryBenchmark YES
+
+set -e
+
+if [ $# -lt 1 ]; then
+	sed -n -e '1d' -e '/^#/!q' -e 's/^# \{0,1\}//p' "$0" > /dev/stderr
+	exit 64
+fi
+
+BUILT_PRODUCTS_DIR="$1"
+shift
+TRACE="${1:-synthetic}"
+[ $# -gt 0 ] && shift
+
+if [ "$TRACE" != "synthetic" ]; then
+	TRACE="$(cd "$(dirname "$TRACE")" && pwd)/$(basename "$TRACE")"
+fi
+
+SCRATCH="$(mktemp -d -t AdiumContactListBenchmark)"
+trap 'rm -rf "$SCRATCH"' EXIT
+
+ditto "$BUILT_PRODUCTS_DIR/Adium.app" "$SCRATCH/Adium.app"
+ditto "$BUILT_PRODUCTS_DIR/Contact List Benchmark.AdiumPlugin" "$SCRATCH/Adium.app/Contents/PlugIns/Contact List Benchmark.AdiumPlugin"
+
+# Point the copy at an empty profile, and run it in the background with no Dock icon or menu bar
+mkdir "$SCRATCH/Profile"
+defaults write "$SCRATCH/Adium.app/Contents/Info" "Preference Folder Location" "$SCRATCH/Profile"
+defaults write "$SCRATCH/Adium.app/Contents/Info" LSBackgroundOnly -bool YES
+codesign --force --deep --sign - "$SCRATCH/Adium.app" > /dev/null 2>&1 || true
+
+"$SCRATCH/Adium.app/Contents/MacOS/Adium" -AIContactListBenchmarkTrace "$TRACE" "$@"
@@ -0,0 +1,228 @@
+#!/usr/bin/env python
+
+"""A local stand-in for the parts of api.twitter.com that the Twitter plugin uses.
+
+It serves a generated backlog of tweets so timeline ingestion can be exercised and timed without
+network access or a real account.
+
+Usage:
+	python Utilities/TwitterMockServer.py --tweets 5000
+	defaults write com.adiumX.adiumX AITwitterAPIBaseURL http://127.0.0.1:8088
+
+Then relaunch Adium and add a Twitter account; any username works. The authorization page served
+by this script shows the PIN to enter. To start over with the full backlog, delete and re-add the
+account (the last-seen tweet IDs are stored per account).
+
+With debug logging on, AITwitterAccount logs how long the backlog took to prepare on the timeline
+queue and to display. Each request is logged to stderr here, with the time spent building it.
+
+To go back to the real service:
+	defaults delete com.adiumX.adiumX AITwitterAPIBaseURL
+"""
+
+import json
+import optparse
+import random
+import sys
+import time
+
+try:
+	from BaseHTTPServer import BaseHTTPRequestHandler, HTTPServer
+	from urlparse import urlparse, parse_qs
+except ImportError:
+	from http.server import BaseHTTPRequestHandler, HTTPServer
+	from urllib.parse import urlparse, parse_qs
+
+FIRST_TWEET_ID = 300000000000000000
+FIRST_DM_ID = 1000
+PIN = '1234567'
+
+WORDS = ('adium', 'chat', 'release', 'build', 'beta', 'status', 'contact', 'message', 'window', 'theme',
+	'xtras', 'bonjour', 'jabber', 'otr', 'log', 'transcript', 'icon', 'dock', 'growl', 'sound')
+
+def twitter_date(timestamp):
+	return time.strftime('%a %b %d %H:%M:%S +0000 %Y', time.gmtime(timestamp))
+
+class Backlog(object):
+	def __init__(self, options):
+		self.screen_name = options.screen_name
+		rng = random.Random(options.seed)
+
+		self.users = [self.user(rng, i, 'user%d' % i) for i in range(options.users)]
+		self.me = self.user(rng, options.users, self.screen_name)
+
+		start = time.time() - options.tweets * options.spacing
+		self.timeline = []
+		self.mentions = []
+		for i in range(options.tweets):
+			tweet_id = FIRST_TWEET_ID + i
+			created = start + i * options.spacing
+			author = self.me if (options.mine_every and i % options.mine_every == 0) else rng.choice(self.users)
+			mentions_me = bool(options.mentions_every) and i % options.mentions_every == 0 and author is not self.me
+			status = self.status(rng, tweet_id, created, author, mentions_me)
+
+			if options.retweet_every and i % options.retweet_every == 0 and author is not self.me:
+				retweeter = rng.choice(self.users)
+				original = self.status(rng, tweet_id - options.tweets, created - 3600, author, False)
+				status = self.status(rng, tweet_id, created, retweeter, False)
+				status['text'] = 'RT @%s: %s' % (author['screen_name'], original['text'])
+				status['retweeted_status'] = original
+
+			self.timeline.append(status)
+			# Replies to us show up in both feeds, the way they do on Twitter.
+			if mentions_me:
+				self.mentions.append(status)
+
+		self.direct_messages = []
+		for i in range(options.direct_messages):
+			sender = rng.choice(self.users)
+			self.direct_messages.append({
+				'id': FIRST_DM_ID + i,
+				'id_str': str(FIRST_DM_ID + i),
+				'created_at': twitter_date(start + i * 60),
+				'sender_screen_name': sender['screen_name'],
+				'recipient_screen_name': self.screen_name,
+				'sender': sender,
+				'recipient': self.me,
+				'text': 'direct message %d about #%s' % (i, rng.choice(WORDS)),
+				'entities': {'hashtags': [], 'user_mentions': [], 'urls': []},
+			})
+
+		# Newest first, as the API returns them
+		self.timeline.reverse()
+		self.mentions.reverse()
+		self.direct_messages.reverse()
+
+	def user(self, rng, index, screen_name):
+		return {
+			'id': index + 1,
+			'id_str': str(index + 1),
+			'screen_name': screen_name,
+			'name': screen_name.capitalize(),
+			'profile_image_url': 'http://127.0.0.1/none/%s.png' % screen_name,
+			'followers_count': rng.randint(0, 5000),
+			'friends_count': rng.randint(0, 500),
+		}
+
+	def status(self, rng, tweet_id, created, author, mentions_me):
+		words = [rng.choice(WORDS) for _ in range(rng.randint(6, 16))]
+		hashtag = rng.choice(WORDS)
+		mention = self.screen_name if mentions_me else rng.choice(self.users)['screen_name']
+		short_url = 'http://t.co/%07d' % (tweet_id % 10000000)
+		text = '@%s %s #%s %s &amp; more' % (mention, ' '.join(words), hashtag, short_url)
+		status = {
+			'id': tweet_id,
+			'id_str': str(tweet_id),
+			'created_at': twitter_date(created),
+			'text': text,
+			'user': author,
+			'in_reply_to_screen_name': None,
+			'in_reply_to_status_id_str': None,
+			'entities': {
+				'hashtags': [{'text': hashtag}],
+				'user_mentions': [{'screen_name': mention}],
+				'urls': [{'url': short_url, 'expanded_url': 'http://example.com/%d' % tweet_id}],
+			},
+		}
+		if mentions_me:
+			status['in_reply_to_screen_name'] = self.screen_name
+			status['in_reply_to_status_id_str'] = str(tweet_id - 1)
+		return status
+
+def page(items, query, honor_count):
+	"Apply since_id, max_id and (optionally) count, the way the timeline endpoints do."
+	since_id = int(query.get('since_id', ['0'])[0])
+	max_id = int(query.get('max_id', [str(sys.maxsize)])[0])
+	result = [item for item in items if since_id < item['id'] <= max_id]
+	if honor_count and 'count' in query:
+		result = result[:int(query['count'][0])]
+	return result
+
+class Handler(BaseHTTPRequestHandler):
+	def reply(self, body, content_type='application/json'):
+		if not isinstance(body, bytes):
+			body = body.encode('utf-8')
+		self.send_response(200)
+		self.send_header('Content-Type', content_type)
+		self.send_header('Content-Length', str(len(body)))
+		self.end_headers()
+		self.wfile.write(body)
+
+	def do_GET(self):
+		started = time.time()
+		url = urlparse(self.path)
+		query = parse_qs(url.query)
+		backlog, honor_count = self.server.backlog, self.server.honor_count
+
+		if url.path == '/1.1/account/verify_credentials.json':
+			body = backlog.me
+		elif url.path in ('/1.1/friends/list.json', '/1.1/followers/list.json'):
+			body = {'users': backlog.users, 'next_cursor_str': '0', 'previous_cursor_str': '0'}
+		elif url.path == '/1.1/statuses/home_timeline.json':
+			body = page(backlog.timeline, query, honor_count)
+		elif url.path == '/1.1/statuses/mentions_timeline.json':
+			body = page(backlog.mentions, query, honor_count)
+		elif url.path == '/1.1/direct_messages.json':
+			body = page(backlog.direct_messages, query, True)
+		elif url.path == '/1.1/application/rate_limit_status.json':
+			body = {'resources': {'statuses': {'/statuses/home_timeline': {'limit': 15, 'remaining': 15, 'reset': int(time.time()) + 900}}}}
+		elif url.path == '/oauth/authorize':
+			self.reply('<html><body><p>PIN: <code>%s</code></p></body></html>' % PIN, 'text/html')
+			return
+		else:
+			self.send_error(404)
+			return
+
+		self.reply(json.dumps(body))
+		count = len(body) if isinstance(body, list) else 1
+		sys.stderr.write('%s: %d objects in %.3f seconds\n' % (url.path, count, time.time() - started))
+
+	def do_POST(self):
+		url = urlparse(self.path)
+		length = int(self.headers.get('Content-Length') or 0)
+		self.rfile.read(length)
+
+		if url.path == '/oauth/request_token':
+			self.reply('oauth_token=mock-request-token&oauth_token_secret=mock-request-secret&oauth_callback_confirmed=true', 'text/plain')
+		elif url.path == '/oauth/access_token':
+			self.reply('oauth_token=mock-access-token&oauth_token_secret=mock-access-secret&user_id=%s&screen_name=%s'
+				% (self.server.backlog.me['id_str'], self.server.backlog.screen_name), 'text/plain')
+		elif url.path.startswith('/1.1/'):
+			# Posting, favoriting and the like: accept and echo something status-shaped.
+			self.reply(json.dumps(self.server.backlog.timeline[0]))
+		else:
+			self.send_error(404)
+
+	def log_message(self, format, *args):
+		pass
+
+def main():
+	parser = optparse.OptionParser(usage='%prog [options]')
+	parser.add_option('--port', type='int', default=8088)
+	parser.add_option('--tweets', type='int', default=5000, help='size of the home timeline backlog')
+	parser.add_option('--users', type='int', default=200, help='number of followed accounts')
+	parser.add_option('--direct-messages', type='int', default=20)
+	parser.add_option('--screen-name', default='adiumtester', help='our own screen name')
+	parser.add_option('--mentions-every', type='int', default=10, help='every Nth tweet is a reply to us (0 for none)')
+	parser.add_option('--retweet-every', type='int', default=7, help='every Nth tweet is a retweet (0 for none)')
+	parser.add_option('--mine-every', type='int', default=50, help='every Nth tweet is our own (0 for none)')
+	parser.add_option('--spacing', type='float', default=30.0, help='seconds between tweets')
+	parser.add_option('--honor-count', action='store_true', default=False,
+		help='page timelines by the requested count, as Twitter does, rather than sending the whole backlog at once')
+	parser.add_option('--seed', type='int', default=1)
+	options, args = parser.parse_args()
+
+	started = time.time()
+	server = HTTPServer(('127.0.0.1', options.port), Handler)
+	server.backlog = Backlog(options)
+	server.honor_count = options.honor_count
+	sys.stderr.write('Generated %d tweets (%d mentions) in %.3f seconds; listening on http://127.0.0.1:%d\n'
+		% (len(server.backlog.timeline), len(server.backlog.mentions), time.time() - started, options.port))
+
+	try:
+		server.serve_forever()
+	except KeyboardInterrupt:
+		pass
+
+if __name__ == '__main__':
+	main()